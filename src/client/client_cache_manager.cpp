@@ -10,15 +10,19 @@ using google::protobuf::util::OkStatus;
 google::protobuf::util::Status CacheManager::SetChunkHandle(
     const std::string& filename, const uint32_t& chunk_index,
     const std::string& chunk_handle) {
-    auto chunk_status_or = GetChunkHandle(filename, chunk_index);
-    if (chunk_status_or.ok()) {
-        if (chunk_status_or.value() != chunk_handle) {
-            return InvalidArgumentError(
-                "reassigning a chunk handle for " + filename +
-                " at chunk index " + std::to_string(chunk_index) + " from " +
-                chunk_status_or.value() + " to " + chunk_handle);
+    absl::MutexLock lock_guard(&lock_);
+    auto file_iter = chunk_handles_.find(filename);
+    if (file_iter != chunk_handles_.end()) {
+        auto iter = file_iter->second.find(chunk_index);
+        if (iter != file_iter->second.end()) {
+            if (iter->second != chunk_handle) {
+                return InvalidArgumentError(
+                    "reassigning a chunk handle for " + filename +
+                    " at chunk index " + std::to_string(chunk_index) +
+                    " from " + iter->second + " to " + chunk_handle);
+            }
+            return OkStatus();
         }
-        return OkStatus();
     }
 
     chunk_handles_[filename][chunk_index] = chunk_handle;
@@ -29,6 +33,7 @@ google::protobuf::util::Status CacheManager::SetChunkHandle(
 
 google::protobuf::util::StatusOr<std::string> CacheManager::GetChunkHandle(
     const std::string& filename, const uint32_t& chunk_index) const {
+    absl::MutexLock lock_guard(&lock_);
     if (!chunk_handles_.contains(filename)) {
         return NotFoundError("CacheManager not found filename");
     }
@@ -42,6 +47,7 @@ google::protobuf::util::StatusOr<std::string> CacheManager::GetChunkHandle(
 
 google::protobuf::util::Status CacheManager::SetChunkVersion(
     const std::string& chunk_handle, const uint32_t& version) {
+    absl::MutexLock lock_guard(&lock_);
     if (!valid_chunk_handles_.contains(chunk_handle)) {
         return NotFoundError("CacheManager chunk hanle not found " +
                              chunk_handle);
@@ -53,6 +59,7 @@ google::protobuf::util::Status CacheManager::SetChunkVersion(
 
 google::protobuf::util::StatusOr<uint32_t> CacheManager::GetChunkVersion(
     const std::string& chunk_handle) const {
+    absl::MutexLock lock_guard(&lock_);
     if (!chunk_versions_.contains(chunk_handle)) {
         return NotFoundError("CacheManager chunk hanle not found " +
                              chunk_handle);
@@ -63,6 +70,7 @@ google::protobuf::util::StatusOr<uint32_t> CacheManager::GetChunkVersion(
 
 google::protobuf::util::Status CacheManager::SetChunkServerLocationEntry(
     const std::string& chunk_handle, const ChunkServerLocationEntry& entry) {
+    absl::MutexLock lock_guard(&lock_);
     if (!valid_chunk_handles_.contains(chunk_handle)) {
         return NotFoundError("SetChunkServerLocationEnrty: chunk handle not found " + chunk_handle);
     }
@@ -74,6 +82,7 @@ google::protobuf::util::Status CacheManager::SetChunkServerLocationEntry(
 google::protobuf::util::StatusOr<CacheManager::ChunkServerLocationEntry>
 CacheManager::GetChunkServerLocationEntry(
     const std::string& chunk_handle) const {
+    absl::MutexLock lock_guard(&lock_);
     if (!chunk_server_locations_.contains(chunk_handle)) {
         return NotFoundError("GetChunkServerLocationEntry: chunk handle not found " + chunk_handle);
     }
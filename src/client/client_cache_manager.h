@@ -3,6 +3,7 @@
 
 #include <absl/container/flat_hash_map.h>
 #include <absl/container/flat_hash_set.h>
+#include <absl/synchronization/mutex.h>
 #include <absl/time/time.h>
 #include <google/protobuf/stubs/statusor.h>
 
@@ -14,7 +15,7 @@
 namespace dfs {
 namespace client {
 
-// 缓存从 master 获取的数据
+// 缓存从 master 获取的数据，可以被预读线程并发访问
 class CacheManager {
    public:
     struct ChunkServerLocationEntry {
@@ -51,6 +52,8 @@ class CacheManager {
     GetChunkServerLocationEntry(const std::string& chunk_handle) const;
 
    private:
+    mutable absl::Mutex lock_;
+
     // map<filename, <chunk_index, chunk_handle>>
     absl::flat_hash_map<std::string, absl::flat_hash_map<uint32_t, std::string>>
         chunk_handles_;
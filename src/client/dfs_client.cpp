@@ -2,6 +2,7 @@
 
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <string>
 
 namespace dfs {
@@ -12,26 +13,43 @@ using google::protobuf::util::IsAlreadyExists;
 using google::protobuf::util::OkStatus;
 using google::protobuf::util::UnknownError;
 
-static thread_local DfsClientImpl* client_impl_ = nullptr;
+// 线程退出时释放，析构时刷新写回缓冲区中的数据
+static thread_local std::unique_ptr<DfsClientImpl> client_impl_;
 
 google::protobuf::util::Status init_client() {
     if (client_impl_) {
         return AlreadyExistsError("client_impl is already exists");
     }
 
-    client_impl_ = new DfsClientImpl();
+    client_impl_ = std::make_unique<DfsClientImpl>();
     return OkStatus();
 }
 
-google::protobuf::util::Status open(const char* filename, unsigned int flag) {
-    if (flag | OpenFlag::CREATE) {
-        auto status = client_impl_->CreateFile(filename);
-        if (!status.ok()) {
-            return status;
-        }
-    }
+google::protobuf::util::StatusOr<FileHandle*> open(const char* filename,
+                                                   unsigned int flag,
+                                                   protos::ChunkCodec codec) {
+    return client_impl_->OpenFile(filename, flag, codec);
+}
 
-    return OkStatus();
+google::protobuf::util::StatusOr<size_t> pread(FileHandle* file, void* buffer,
+                                               size_t nbytes, size_t offset) {
+    return client_impl_->ReadFile(file, offset, nbytes,
+                                  static_cast<char*>(buffer));
+}
+
+google::protobuf::util::StatusOr<size_t> pwrite(FileHandle* file,
+                                                const void* buffer,
+                                                size_t nbytes, size_t offset) {
+    return client_impl_->WriteFile(file, static_cast<const char*>(buffer),
+                                   offset, nbytes);
+}
+
+google::protobuf::util::Status fsync(FileHandle* file) {
+    return client_impl_->SyncFile(file);
+}
+
+google::protobuf::util::Status close(FileHandle* file) {
+    return client_impl_->CloseFile(file);
 }
 
 google::protobuf::util::StatusOr<Data> read(const char* filename, size_t offset,
@@ -57,8 +75,17 @@ google::protobuf::util::Status remove(const char* filename) {
     return client_impl_->DeleteFile(filename);
 }
 
+google::protobuf::util::Status set_storage_class(
+    const char* filename, protos::StorageClass storage_class) {
+    return client_impl_->SetStorageClass(filename, storage_class);
+}
+
 google::protobuf::util::Status close(const char* filename) {
-    return OkStatus();
+    return client_impl_->CloseFile(filename);
+}
+
+google::protobuf::util::Status fsync(const char* filename) {
+    return client_impl_->SyncFile(filename);
 }
 
 google::protobuf::util::Status upload(const char* filename) {
@@ -93,10 +120,7 @@ google::protobuf::util::Status set(const char* filename, size_t size) {
     return write(filename, buffer, 0, size).status();
 }
 
-void reset_client() {
-    delete client_impl_;
-    client_impl_ = nullptr;
-}
+void reset_client() { client_impl_.reset(); }
 
 }  // namespace client
 }  // namespace dfs
\ No newline at end of file
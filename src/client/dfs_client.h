@@ -10,8 +10,6 @@
 namespace dfs {
 namespace client {
 
-enum OpenFlag { READ = 1, WRITE = 2, CREATE = 4 };
-
 struct Data {
     size_t bytes;
     void* buffer;
@@ -21,8 +19,29 @@ struct Data {
 
 google::protobuf::util::Status init_client();
 
-google::protobuf::util::Status open(const char* filename, unsigned int flag);
+// 打开文件，flag 为 OpenFlag 的组合，返回的 FileHandle 在 close 后失效。
+// 通过 FileHandle 读写时使用缓存的数据块元数据与租约，不再按路径查找。
+// 带 CREATE 创建文件时，块服务器按 codec 压缩文件的数据
+google::protobuf::util::StatusOr<FileHandle*> open(
+    const char* filename, unsigned int flag,
+    protos::ChunkCodec codec = protos::CODEC_NONE);
+
+// 读取 [offset, offset + nbytes) 到调用方的 buffer，返回读取的字节数
+google::protobuf::util::StatusOr<size_t> pread(FileHandle* file, void* buffer,
+                                               size_t nbytes, size_t offset);
+
+// 将 buffer 写入 [offset, offset + nbytes)，返回写入的字节数
+google::protobuf::util::StatusOr<size_t> pwrite(FileHandle* file,
+                                                const void* buffer,
+                                                size_t nbytes, size_t offset);
+
+google::protobuf::util::Status fsync(FileHandle* file);
 
+// 刷新写回缓冲区并关闭 file，返回之前未报告的写入错误
+google::protobuf::util::Status close(FileHandle* file);
+
+// 返回的 buffer 由 malloc 分配，调用者负责释放。不需要转移所有权时使用
+// pread 读入调用者的 buffer，避免分配与复制
 google::protobuf::util::StatusOr<Data> read(const char* filename, size_t offset,
                                             size_t nbytes);
 
@@ -32,8 +51,17 @@ google::protobuf::util::StatusOr<size_t> write(const char* filename,
 
 google::protobuf::util::Status remove(const char* filename);
 
+// 修改文件的存储方式，目前只支持将多副本文件转换为纠删码文件，
+// 转换后文件只读
+google::protobuf::util::Status set_storage_class(
+    const char* filename, protos::StorageClass storage_class);
+
+// 刷新写回缓冲区并关闭文件，返回之前未报告的写入错误
 google::protobuf::util::Status close(const char* filename);
 
+// 将文件写回缓冲区中的数据写入块服务器，返回之前未报告的写入错误
+google::protobuf::util::Status fsync(const char* filename);
+
 google::protobuf::util::Status upload(const char* filename);
 
 google::protobuf::util::Status set(const char* filename, size_t size);
@@ -1,11 +1,19 @@
 #include "src/client/dfs_client_impl.h"
 
+#include <unistd.h>
+
+#include <random>
 #include <thread>
 #include <vector>
 
+#include "src/common/checksum.h"
 #include "src/common/config_manager.h"
+#include "src/common/metrics.h"
+#include "src/common/metrics_server.h"
 #include "src/common/system_logger.h"
+#include "src/common/tracing.h"
 #include "src/common/utils.h"
+#include "src/grpc_client/chunk_data_codec.h"
 
 namespace dfs {
 namespace client {
@@ -13,17 +21,141 @@ namespace client {
 using dfs::common::ConfigManager;
 using dfs::grpc_client::ChunkServerFileServiceClient;
 using dfs::grpc_client::MasterMetadataServiceClient;
+using google::protobuf::util::DataLossError;
+using google::protobuf::util::FailedPreconditionError;
+using google::protobuf::util::InvalidArgumentError;
+using google::protobuf::util::IsAlreadyExists;
+using google::protobuf::util::NotFoundError;
 using google::protobuf::util::OkStatus;
+using google::protobuf::util::OutOfRangeError;
+using google::protobuf::util::PermissionDeniedError;
 using google::protobuf::util::UnknownError;
 using protos::grpc::DeleteFileRequest;
+using protos::grpc::FileChunkMutationStatus;
 using protos::grpc::OpenFileRequest;
 using protos::grpc::ReadFileChunkRequest;
 using protos::grpc::ReadFileChunkRespond;
 using protos::grpc::SendChunkDataRequest;
 using protos::grpc::SendChunkDataRespond;
+using protos::grpc::SetStorageClassRequest;
 using protos::grpc::WriteFileChunkRequest;
 using protos::grpc::WriteFileChunkRespond;
 
+namespace {
+
+// 对冲预算最多积攒的令牌数，允许短时间内连续对冲
+const double kMaxHedgeTokens = 10;
+
+// 等待执行的预读数量上限，超过时放弃预读
+const uint32_t kMaxQueuedReadaheads = 64;
+
+// 写租约所属的客户端会话
+struct ClientSession {
+    std::string client_id;
+    uint64_t session_epoch = 0;
+};
+
+// 进程内的客户端共用一个会话，多个 DfsClientImpl 与它们的工作线程共享
+// 写租约，重新连接 master 也不会失去租约
+const ClientSession& ProcessClientSession(const std::string& client_id) {
+    static const ClientSession session = [&] {
+        ClientSession process_session;
+        // 进程启动的时间，重启后的会话更大
+        process_session.session_epoch = absl::ToUnixMicros(absl::Now());
+        process_session.client_id = client_id;
+        if (process_session.client_id.empty()) {
+            char hostname[256] = {0};
+            gethostname(hostname, sizeof(hostname) - 1);
+            std::random_device random;
+            process_session.client_id = std::string(hostname) + ":" +
+                                        std::to_string(getpid()) + ":" +
+                                        std::to_string(random());
+        }
+        return process_session;
+    }();
+    return session;
+}
+
+// 进程内客户端共用的指标
+struct ClientMetrics {
+    common::Histogram* read_latency;
+    common::Histogram* write_latency;
+    common::Histogram* chunk_write_latency;
+    common::Counter* read_bytes;
+    common::Counter* write_bytes;
+    common::Counter* metadata_requests;
+    common::Counter* metadata_cache_hits;
+    common::Counter* hedges_issued;
+    common::Counter* hedges_won;
+};
+
+const ClientMetrics& GetClientMetrics() {
+    static const ClientMetrics metrics = [] {
+        auto registry = common::MetricsRegistry::GetInstance();
+        ClientMetrics client_metrics;
+        client_metrics.read_latency = registry->GetHistogram(
+            "dfs_client_latency_seconds", "Latency of client file operations",
+            {{"op", "read"}});
+        client_metrics.write_latency = registry->GetHistogram(
+            "dfs_client_latency_seconds", "Latency of client file operations",
+            {{"op", "write"}});
+        client_metrics.chunk_write_latency = registry->GetHistogram(
+            "dfs_client_chunk_write_latency_seconds",
+            "Latency of writing one file chunk to its replicas");
+        client_metrics.read_bytes = registry->GetCounter(
+            "dfs_client_bytes_total", "Bytes read or written by the client",
+            {{"op", "read"}});
+        client_metrics.write_bytes = registry->GetCounter(
+            "dfs_client_bytes_total", "Bytes read or written by the client",
+            {{"op", "write"}});
+        client_metrics.metadata_requests = registry->GetCounter(
+            "dfs_client_metadata_requests_total",
+            "Chunk metadata requests sent to the master");
+        client_metrics.metadata_cache_hits = registry->GetCounter(
+            "dfs_client_metadata_cache_hits_total",
+            "Chunk metadata lookups served from the file handle cache");
+        client_metrics.hedges_issued = registry->GetCounter(
+            "dfs_client_hedged_reads_total", "Hedged reads by result",
+            {{"result", "issued"}});
+        client_metrics.hedges_won = registry->GetCounter(
+            "dfs_client_hedged_reads_total", "Hedged reads by result",
+            {{"result", "won"}});
+        return client_metrics;
+    }();
+    return metrics;
+}
+
+// 配置了客户端指标端口时，进程内第一个客户端启动指标服务，进程退出前
+// 一直运行
+void StartClientMetricsServer(ConfigManager* config_manager) {
+    static bool started = [config_manager] {
+        const uint32_t port = config_manager->GetMetricsClientPort();
+        if (port == 0) {
+            return false;
+        }
+        auto server =
+            new common::MetricsServer(common::MetricsRegistry::GetInstance());
+        return server->Start(config_manager->GetMetricsAddress(), port);
+    }();
+    (void)started;
+}
+
+// 进程内第一个客户端开始导出 span，进程退出时结束
+void StartClientTracing() {
+    static bool started = [] {
+        common::Tracer::GetInstance()->Start("dfs_client",
+                                             common::Tracer::LoadOptions());
+        return true;
+    }();
+    (void)started;
+}
+
+// 租约从 master 收到请求时开始计算，客户端提前这么久放弃缓存的写元数据，
+// 避免使用即将到期的租约写入
+const absl::Duration kLeaseRenewMargin = absl::Seconds(5);
+
+}  // namespace
+
 DfsClientImpl::DfsClientImpl() {
     // TODO: read ip:port from config file.
     const std::string& target_str = "127.0.0.1:50050";
@@ -35,13 +167,99 @@ DfsClientImpl::DfsClientImpl() {
     cache_manager_ = std::make_shared<CacheManager>();
 
     config_manager_ = ConfigManager::GetInstance();
+
+    ReplicaSelector::Options selector_options;
+    selector_options.local_host = config_manager_->GetClientHost();
+    selector_options.local_rack = config_manager_->GetClientRack();
+    selector_options.failure_backoff =
+        absl::Milliseconds(config_manager_->GetClientReplicaBackoffMs());
+    replica_selector_ = std::make_unique<ReplicaSelector>(selector_options);
+
+    read_options_.hedged_read = config_manager_->GetClientHedgedRead();
+    read_options_.readahead = config_manager_->GetClientReadahead();
+    write_back_ = config_manager_->GetClientWriteBack();
+    max_path_files_ =
+        std::max<size_t>(config_manager_->GetClientMaxPathFiles(), 1);
+    readahead_executor_ = std::make_unique<common::Executor>(
+        "readahead", config_manager_->GetClientReadaheadThreadNums(),
+        kMaxQueuedReadaheads);
+    hedge_budget_ = std::make_unique<HedgeBudget>(
+        config_manager_->GetClientHedgeBudgetPercent() / 100.0,
+        kMaxHedgeTokens);
+
+    const auto& session =
+        ProcessClientSession(config_manager_->GetClientId());
+    client_id_ = session.client_id;
+    session_epoch_ = session.session_epoch;
+
+    StartClientMetricsServer(config_manager_);
+    StartClientTracing();
+
+    if (write_back_) {
+        flush_thread_ = std::thread(&DfsClientImpl::RunFlushTimer, this);
+    }
 }
 
-google::protobuf::util::Status DfsClientImpl::CreateFile(const char* filename) {
+DfsClientImpl::~DfsClientImpl() {
+    {
+        absl::MutexLock lock_guard(&files_lock_);
+        stopped_ = true;
+    }
+    if (flush_thread_.joinable()) {
+        flush_thread_.join();
+    }
+
+    for (auto& [file_ptr, file] : open_files_) {
+        if (!file->write_buffer()) {
+            continue;
+        }
+        auto status = file->write_buffer()->Flush();
+        if (!status.ok()) {
+            LOG(ERROR) << "flush " << file->filename()
+                       << " failed: " << status.ToString();
+        }
+    }
+}
+
+void DfsClientImpl::RunFlushTimer() {
+    const absl::Duration flush_interval =
+        absl::Milliseconds(config_manager_->GetClientWriteFlushMs());
+    // 检查的间隔不超过刷新间隔的一半，缓冲的数据最多多等半个刷新间隔
+    const absl::Duration check_interval =
+        std::max(flush_interval / 2, absl::Milliseconds(1));
+
+    std::vector<std::shared_ptr<FileHandle>> files;
+    while (true) {
+        {
+            absl::MutexLock lock_guard(&files_lock_);
+            files_lock_.AwaitWithTimeout(absl::Condition(&stopped_),
+                                         check_interval);
+            if (stopped_) {
+                return;
+            }
+            for (const auto& [file_ptr, file] : open_files_) {
+                if (file->write_buffer()) {
+                    files.push_back(file);
+                }
+            }
+        }
+
+        // 刷新时不持有 files_lock_，调用线程可以继续打开与关闭文件
+        const absl::Time now = absl::Now();
+        for (const auto& file : files) {
+            file->write_buffer()->FlushExpired(now);
+        }
+        files.clear();
+    }
+}
+
+google::protobuf::util::Status DfsClientImpl::CreateFile(
+    const char* filename, const protos::ChunkCodec& codec) {
     // set up request
     OpenFileRequest request;
     request.set_filename(filename);
     request.set_mode(OpenFileRequest::CREATE);
+    request.set_codec(codec);
     // call rpc, create file.
     auto respond_or = master_metadata_service_client_->SendRequest(request);
     if (!respond_or.ok()) {
@@ -52,15 +270,288 @@ google::protobuf::util::Status DfsClientImpl::CreateFile(const char* filename) {
     return OkStatus();
 }
 
+google::protobuf::util::StatusOr<FileHandle*> DfsClientImpl::OpenFile(
+    const char* filename, unsigned int flags,
+    const protos::ChunkCodec& codec) {
+    if (flags & OpenFlag::CREATE) {
+        // 文件已经存在时沿用创建时的压缩算法
+        auto status = CreateFile(filename, codec);
+        if (!status.ok() && !IsAlreadyExists(status)) {
+            return status;
+        }
+    }
+
+    auto file = std::make_unique<FileHandle>(filename, flags);
+    // 获取第一个数据块的元数据，确认文件存在，同时预热元数据缓存
+    FileHandle::ChunkMetadata metadata;
+    auto status =
+        GetChunkMetedata(file.get(), 0, OpenFileRequest::READ, &metadata);
+    if (!status.ok()) {
+        return status;
+    }
+
+    FileHandle* file_ptr = file.get();
+    absl::MutexLock lock_guard(&files_lock_);
+    open_files_[file_ptr] = std::move(file);
+    return file_ptr;
+}
+
+google::protobuf::util::StatusOr<size_t> DfsClientImpl::ReadFile(
+    FileHandle* file, size_t offset, size_t nbytes, char* buffer) {
+    if (!IsOpenFile(file)) {
+        return InvalidArgumentError("file is not open");
+    }
+    if (!file->readable()) {
+        return PermissionDeniedError(file->filename() +
+                                     " is not opened for read");
+    }
+
+    const auto& metrics = GetClientMetrics();
+    common::ScopedLatency latency(metrics.read_latency);
+    common::Span span("ClientRead");
+    span.SetAttribute("bytes", nbytes);
+    auto read_or =
+        ReadFileToBuffer(file, offset, nbytes, read_options_, buffer);
+    span.SetStatus(read_or.status());
+    if (read_or.ok()) {
+        metrics.read_bytes->Increment(read_or.value());
+    }
+    return read_or;
+}
+
+google::protobuf::util::StatusOr<size_t> DfsClientImpl::WriteFile(
+    FileHandle* file, const char* buffer, size_t offset, size_t nbytes) {
+    if (!IsOpenFile(file)) {
+        return InvalidArgumentError("file is not open");
+    }
+    if (!file->writable()) {
+        return PermissionDeniedError(file->filename() +
+                                     " is not opened for write");
+    }
+
+    const auto& metrics = GetClientMetrics();
+    common::ScopedLatency latency(metrics.write_latency);
+    common::Span span("ClientWrite");
+    span.SetAttribute("bytes", nbytes);
+
+    // 预读的数据可能已经过期
+    if (file->read_stream()) {
+        file->read_stream()->Invalidate();
+    }
+
+    if (!write_back_) {
+        auto write_or = WriteFileDirect(file, buffer, offset, nbytes);
+        if (write_or.ok()) {
+            metrics.write_bytes->Increment(write_or.value());
+        }
+        return write_or;
+    }
+
+    // 写入文件的写回缓冲区，刷新失败时返回错误
+    auto status = GetWriteBuffer(file)->Write(offset, buffer, nbytes);
+    if (!status.ok()) {
+        return status;
+    }
+    metrics.write_bytes->Increment(nbytes);
+    return nbytes;
+}
+
+google::protobuf::util::Status DfsClientImpl::SyncFile(FileHandle* file) {
+    if (!IsOpenFile(file)) {
+        return InvalidArgumentError("file is not open");
+    }
+    if (!file->write_buffer()) {
+        return OkStatus();
+    }
+    return file->write_buffer()->Flush();
+}
+
+google::protobuf::util::Status DfsClientImpl::CloseFile(FileHandle* file) {
+    std::shared_ptr<FileHandle> handle;
+    {
+        absl::MutexLock lock_guard(&files_lock_);
+        auto iter = open_files_.find(file);
+        if (iter == open_files_.end()) {
+            return InvalidArgumentError("file is not open");
+        }
+        handle = std::move(iter->second);
+        open_files_.erase(iter);
+
+        auto path_iter = path_files_.find(file->filename());
+        if (path_iter != path_files_.end() && path_iter->second.file == file) {
+            path_files_.erase(path_iter);
+        }
+    }
+
+    // 后台线程可能正在刷新同一个缓冲区，Flush 等待其结束
+    if (!handle->write_buffer()) {
+        return OkStatus();
+    }
+    return handle->write_buffer()->Flush();
+}
+
 google::protobuf::util::Status DfsClientImpl::DeleteFile(const char* filename) {
+    // 丢弃该文件未刷新的写入与缓存的元数据。写回缓冲区可能正在被后台线程
+    // 刷新，只清空不释放
+    {
+        absl::MutexLock lock_guard(&files_lock_);
+        for (auto& [file_ptr, file] : open_files_) {
+            if (file->filename() == filename) {
+                file->set_read_stream(nullptr);
+                if (file->write_buffer()) {
+                    file->write_buffer()->Discard();
+                }
+                file->ClearChunkMetadata();
+            }
+        }
+    }
     // set up request
     DeleteFileRequest request;
     request.set_filename(filename);
     return master_metadata_service_client_->SendRequest(request);
 }
 
+google::protobuf::util::Status DfsClientImpl::SetStorageClass(
+    const char* filename, const protos::StorageClass& storage_class) {
+    // 转换后数据块的位置会变化，丢弃缓存的元数据
+    std::vector<std::shared_ptr<FileHandle>> files;
+    {
+        absl::MutexLock lock_guard(&files_lock_);
+        for (const auto& [file_ptr, file] : open_files_) {
+            if (file->filename() == filename) {
+                files.push_back(file);
+            }
+        }
+    }
+    for (const auto& file : files) {
+        if (file->write_buffer()) {
+            auto sync_status = file->write_buffer()->Flush();
+            if (!sync_status.ok()) {
+                return sync_status;
+            }
+        }
+        file->ClearChunkMetadata();
+    }
+
+    SetStorageClassRequest request;
+    request.set_filename(filename);
+    request.set_storage_class(storage_class);
+    return master_metadata_service_client_->SendRequest(request);
+}
+
 google::protobuf::util::StatusOr<std::pair<size_t, void*>>
 DfsClientImpl::ReadFile(const char* filename, size_t offset, size_t nbytes) {
+    return ReadFile(filename, offset, nbytes, read_options_);
+}
+
+google::protobuf::util::StatusOr<std::pair<size_t, void*>>
+DfsClientImpl::ReadFile(const char* filename, size_t offset, size_t nbytes,
+                        const ReadOptions& options) {
+    // TODO: 当读取文件过大时，会导致程序崩溃
+    void* buffer = malloc(nbytes);
+    if (!buffer) {
+        return UnknownError("malloc failed");
+    }
+
+    auto read_or = ReadFileToBuffer(GetPathFile(filename), offset, nbytes,
+                                    options, static_cast<char*>(buffer));
+    if (!read_or.ok()) {
+        free(buffer);
+        return read_or.status();
+    }
+
+    return std::make_pair(read_or.value(), buffer);
+}
+
+google::protobuf::util::Status DfsClientImpl::CloseFile(
+    const char* filename) {
+    FileHandle* file = FindPathFile(filename);
+    if (!file) {
+        return OkStatus();
+    }
+    return CloseFile(file);
+}
+
+FileHandle* DfsClientImpl::GetPathFile(const std::string& filename) {
+    FileHandle* file_ptr = nullptr;
+    std::shared_ptr<FileHandle> evicted;
+    {
+        absl::MutexLock lock_guard(&files_lock_);
+        auto& path_file = path_files_[filename];
+        path_file.last_use = ++path_file_uses_;
+        file_ptr = path_file.file;
+        if (file_ptr) {
+            return file_ptr;
+        }
+
+        auto file = std::make_shared<FileHandle>(
+            filename, OpenFlag::READ | OpenFlag::WRITE);
+        file_ptr = file.get();
+        path_file.file = file_ptr;
+        open_files_[file_ptr] = std::move(file);
+
+        if (path_files_.size() > max_path_files_) {
+            // 隐式 FileHandle 数量很少，直接遍历查找最久未使用的一个
+            auto lru_iter = path_files_.begin();
+            for (auto iter = path_files_.begin(); iter != path_files_.end();
+                 iter++) {
+                if (iter->second.last_use < lru_iter->second.last_use) {
+                    lru_iter = iter;
+                }
+            }
+            auto open_iter = open_files_.find(lru_iter->second.file);
+            evicted = std::move(open_iter->second);
+            open_files_.erase(open_iter);
+            path_files_.erase(lru_iter);
+        }
+    }
+
+    // 释放前刷新写回缓冲区，没有调用者可以接收错误，只记录日志
+    if (evicted && evicted->write_buffer()) {
+        auto status = evicted->write_buffer()->Flush();
+        if (!status.ok()) {
+            LOG(ERROR) << "flush " << evicted->filename()
+                       << " failed: " << status.ToString();
+        }
+    }
+    return file_ptr;
+}
+
+FileHandle* DfsClientImpl::FindPathFile(const std::string& filename) {
+    absl::MutexLock lock_guard(&files_lock_);
+    auto iter = path_files_.find(filename);
+    if (iter == path_files_.end()) {
+        return nullptr;
+    }
+    return iter->second.file;
+}
+
+bool DfsClientImpl::IsOpenFile(FileHandle* file) {
+    absl::MutexLock lock_guard(&files_lock_);
+    return open_files_.contains(file);
+}
+
+google::protobuf::util::StatusOr<size_t> DfsClientImpl::ReadFileToBuffer(
+    FileHandle* file, size_t offset, size_t nbytes, const ReadOptions& options,
+    char* buffer) {
+    // 先刷新写回缓冲区，保证读到自己写入的数据
+    if (file->write_buffer()) {
+        auto sync_status = file->write_buffer()->Flush();
+        if (!sync_status.ok()) {
+            return sync_status;
+        }
+    }
+
+    // 开启预读时经过文件的读取流，第一次读取时创建
+    if (options.readahead) {
+        return GetReadStream(file)->Read(offset, nbytes, buffer);
+    }
+    return ReadFileInto(file, offset, nbytes, options, buffer);
+}
+
+google::protobuf::util::StatusOr<size_t> DfsClientImpl::ReadFileInto(
+    FileHandle* file, size_t offset, size_t nbytes, const ReadOptions& options,
+    char* buffer) {
     // 一个 chunk 64MB
     const size_t chunk_size = config_manager_->GetBlockSize() * common::bytesMB;
 
@@ -69,28 +560,22 @@ DfsClientImpl::ReadFile(const char* filename, size_t offset, size_t nbytes) {
     // 在 chunk 的起始位置
     size_t chunk_start_offset = offset % chunk_size;
 
-    // TODO: 当读取文件过大时，会导致程序崩溃
-    void* buffer = malloc(nbytes);
-    if (!buffer) {
-        return UnknownError("malloc failed");
-    }
-
     for (size_t chunk_index = offset / chunk_size; remain_bytes > 0;
          chunk_index++) {
         size_t bytes_to_read = std::min(remain_bytes, chunk_size);
-        auto read_file_chunk_or = ReadFileChunk(
-            filename, chunk_index, chunk_start_offset, bytes_to_read);
+        // 数据直接写入调用者的 buffer
+        auto read_file_chunk_or =
+            ReadFileChunk(file, chunk_index, chunk_start_offset,
+                          bytes_to_read, options, buffer + bytes_read);
         if (!read_file_chunk_or.ok()) {
-            free(buffer);
             return read_file_chunk_or.status();
         }
 
-        // copy data
         size_t actually_read_bytes = read_file_chunk_or.value().read_length();
-        const void* actually_read_data =
-            read_file_chunk_or.value().data().c_str();
-        memmove((char*)buffer + bytes_read, actually_read_data,
-                actually_read_bytes);
+        if (actually_read_bytes == 0) {
+            // 读到文件末尾
+            break;
+        }
 
         // set parameters
         chunk_start_offset = 0;
@@ -98,63 +583,158 @@ DfsClientImpl::ReadFile(const char* filename, size_t offset, size_t nbytes) {
         remain_bytes -= actually_read_bytes;
     }
 
-    return std::make_pair(bytes_read, buffer);
+    return bytes_read;
+}
+
+FileWriteBuffer* DfsClientImpl::GetWriteBuffer(FileHandle* file) {
+    absl::MutexLock lock_guard(&files_lock_);
+    if (!file->write_buffer()) {
+        FileWriteBuffer::Options buffer_options;
+        buffer_options.max_buffer_bytes =
+            config_manager_->GetClientWriteBufferKB() * common::bytesKB;
+        buffer_options.flush_interval =
+            absl::Milliseconds(config_manager_->GetClientWriteFlushMs());
+        file->set_write_buffer(std::make_unique<FileWriteBuffer>(
+            buffer_options,
+            [this, file](size_t offset, const char* data, size_t nbytes) {
+                return WriteFileDirect(file, data, offset, nbytes);
+            }));
+    }
+    return file->write_buffer();
+}
+
+FileReadStream* DfsClientImpl::GetReadStream(FileHandle* file) {
+    if (!file->read_stream()) {
+        FileReadStream::Options stream_options;
+        stream_options.initial_window =
+            config_manager_->GetClientReadaheadKB() * common::bytesKB;
+        stream_options.max_window =
+            config_manager_->GetClientReadaheadMaxMB() * common::bytesMB;
+        // 预读不经过读取流，也不使用对冲读取
+        ReadOptions options = read_options_;
+        options.hedged_read = false;
+        options.readahead = false;
+        file->set_read_stream(std::make_unique<FileReadStream>(
+            stream_options,
+            [this, file, options](size_t offset, size_t nbytes,
+                                  char* buffer) {
+                return ReadFileInto(file, offset, nbytes, options, buffer);
+            },
+            readahead_executor_.get()));
+    }
+    return file->read_stream();
 }
 
 google::protobuf::util::StatusOr<protos::grpc::ReadFileChunkRespond>
-DfsClientImpl::ReadFileChunk(const char* filename, size_t chunk_index,
-                             size_t offset, size_t nbytes) {
-    // TODO: set up chunk_handle, chunk_version from chunk metadata.
-    std::string chunk_handle;
-    size_t chunk_version;
-    CacheManager::ChunkServerLocationEntry entry;
-    // talk to master or cache
-    auto status = GetChunkMetedata(filename, chunk_index, OpenFileRequest::READ,
-                                   chunk_handle, chunk_version, entry);
-    if (!status.ok()) {
-        return status;
+DfsClientImpl::ReadFileChunk(FileHandle* file, size_t chunk_index,
+                             size_t offset, size_t nbytes,
+                             const ReadOptions& options, char* buffer) {
+    google::protobuf::util::StatusOr<ReadFileChunkRespond> respond_or;
+    // 第一次可能使用缓存的元数据，过期时重新获取后再试一次
+    for (int attempt = 0; attempt < 2; attempt++) {
+        FileHandle::ChunkMetadata metadata;
+        // talk to master or cache
+        auto status = GetChunkMetedata(file, chunk_index,
+                                       OpenFileRequest::READ, &metadata);
+        if (!status.ok()) {
+            return status;
+        }
+
+        bool stale = false;
+        respond_or = ReadFromReplicas(metadata, offset, nbytes, options,
+                                      buffer, &stale);
+        if (respond_or.ok() || !stale) {
+            return respond_or;
+        }
+
+        DFS_VLOG(1) << "chunk metadata of " << file->filename() << " index "
+                    << chunk_index << " is stale, refetch from master";
+        file->InvalidateChunkMetadata(chunk_index, false);
     }
 
+    return respond_or;
+}
+
+google::protobuf::util::StatusOr<protos::grpc::ReadFileChunkRespond>
+DfsClientImpl::ReadFromReplicas(const FileHandle::ChunkMetadata& metadata,
+                                size_t offset, size_t nbytes,
+                                const ReadOptions& options, char* buffer,
+                                bool* stale) {
+    const std::string& chunk_handle = metadata.chunk_handle;
+    const auto& entry = metadata.entry;
+
     ReadFileChunkRequest request;
     request.set_chunk_handle(chunk_handle);
-    request.set_version(chunk_version);
+    request.set_version(metadata.version);
     request.set_offset(offset);
     request.set_length(nbytes);
 
-    // TODO: 轮询每个 chunkserver，只要有一个成功返回，立马退出
+    // 按距离与负载排列副本，依次尝试，只要有一个成功返回，立马退出
+    std::vector<ReplicaSelector::Replica> replicas;
     for (const auto& location : entry.locations) {
-        const std::string server_address =
-            location.server_hostname() + ":" +
-            std::to_string(location.server_port());
-
-        LOG(INFO) << "try to talk to chunkserver " << server_address;
-
-        auto chunk_server_file_service_client =
-            GetChunkServerFileServiceClient(server_address);
+        ReplicaSelector::Replica replica;
+        replica.server_address = location.server_hostname() + ":" +
+                                 std::to_string(location.server_port());
+        replica.host =
+            config_manager_->GetChunkServerHost(replica.server_address);
+        replica.rack =
+            config_manager_->GetChunkServerRack(replica.server_address);
+        replicas.push_back(std::move(replica));
+    }
 
-        auto respond_or =
-            chunk_server_file_service_client->SendRequest(request);
+    google::protobuf::util::Status last_status =
+        UnknownError("cant not read from entry.location");
+    const auto server_addresses = replica_selector_->RankReplicas(replicas);
+    hedge_budget_->RecordRead();
+    for (size_t i = 0; i < server_addresses.size(); i++) {
+        const auto& server_address = server_addresses[i];
+        DFS_VLOG(2) << "try to talk to chunkserver " << server_address;
+
+        google::protobuf::util::StatusOr<ReadFileChunkRespond> respond_or;
+        if (options.hedged_read && i + 1 < server_addresses.size()) {
+            bool hedged = false;
+            respond_or =
+                HedgedReadFromReplicas(request, server_address,
+                                       server_addresses[i + 1], buffer,
+                                       &hedged);
+            // 对冲请求已经尝试过下一个副本
+            if (hedged) {
+                i++;
+            }
+        } else {
+            grpc::ClientContext context;
+            respond_or =
+                ReadFromReplica(server_address, request, &context, buffer);
+        }
         if (!respond_or.ok()) {
-            LOG(ERROR) << "read " << chunk_handle
-                       << " error: " << respond_or.status().ToString();
-            return respond_or.status();
+            DFS_LOG_RATE_LIMITED(ERROR, 10)
+                << "read " << chunk_handle << " from " << server_address
+                << " error: " << respond_or.status().ToString();
+            last_status = respond_or.status();
+            continue;
         }
 
         auto respond = respond_or.value();
         switch (respond.status()) {
             case ReadFileChunkRespond::UNKNOW:
-                LOG(ERROR) << "read file chunk respond unknow, chunk_handle: "
-                           << chunk_handle;
+                DFS_LOG_RATE_LIMITED(ERROR, 10)
+                    << "read file chunk respond unknow, chunk_handle: "
+                    << chunk_handle;
                 continue;
             case ReadFileChunkRespond::NOT_FOUND:
-                LOG(ERROR) << "chunk not found: " << chunk_handle;
+                DFS_LOG_RATE_LIMITED(ERROR, 10)
+                    << "chunk not found: " << chunk_handle;
+                *stale = true;
                 continue;
             case ReadFileChunkRespond::OUT_OF_RANGE:
-                LOG(ERROR) << "out of range when read " << chunk_handle;
+                DFS_LOG_RATE_LIMITED(ERROR, 10)
+                    << "out of range when read " << chunk_handle;
                 continue;
             case ReadFileChunkRespond::VERSION_ERROR:
-                LOG(ERROR) << "version error when read chunk " << chunk_handle
-                           << " version" << chunk_version;
+                DFS_LOG_RATE_LIMITED(ERROR, 10)
+                    << "version error when read chunk " << chunk_handle
+                    << " version" << metadata.version;
+                *stale = true;
                 continue;
             default:
                 break;
@@ -163,12 +743,195 @@ DfsClientImpl::ReadFileChunk(const char* filename, size_t chunk_index,
         return respond;
     }
 
-    return google::protobuf::util::UnknownError(
-        "cant not read from entry.location");
+    return last_status;
+}
+
+google::protobuf::util::StatusOr<protos::grpc::ReadFileChunkRespond>
+DfsClientImpl::ReadFromReplica(const std::string& server_address,
+                               const ReadFileChunkRequest& request,
+                               grpc::ClientContext* context, char* buffer) {
+    auto chunk_server_file_service_client =
+        GetChunkServerFileServiceClient(server_address);
+    context->set_deadline(absl::ToChronoTime(
+        absl::Now() +
+        absl::Milliseconds(config_manager_->GetClientReadTimeoutMs())));
+
+    replica_selector_->BeginRequest(server_address);
+    const absl::Time start_time = absl::Now();
+    auto respond_or =
+        chunk_server_file_service_client->SendRequest(request, context, buffer);
+
+    // 传输错误、超时与块服务器内部错误时换下一个副本，并让该块服务器退避
+    const bool server_ok =
+        respond_or.ok() &&
+        respond_or.value().status() != ReadFileChunkRespond::UNKNOW;
+    replica_selector_->EndRequest(server_address, absl::Now() - start_time,
+                                  server_ok);
+    return respond_or;
+}
+
+google::protobuf::util::StatusOr<protos::grpc::ReadFileChunkRespond>
+DfsClientImpl::HedgedReadFromReplicas(const ReadFileChunkRequest& request,
+                                      const std::string& primary_address,
+                                      const std::string& secondary_address,
+                                      char* buffer, bool* hedged) {
+    HedgedRead hedged_read;
+    hedged_read.trace_context = common::CurrentTraceContext();
+    hedged_read.attempts[0].server_address = primary_address;
+    hedged_read.attempts[0].buffer = buffer;
+    hedged_read.attempts[1].server_address = secondary_address;
+
+    // 原请求在阈值（该块服务器最近延迟的分位数）内没有返回时，向下一个副本
+    // 发送对冲请求
+    const absl::Duration hedge_delay = replica_selector_->GetLatencyPercentile(
+        primary_address, config_manager_->GetClientHedgePercentile() / 100.0,
+        absl::Milliseconds(config_manager_->GetClientHedgeDelayMs()));
+    const auto hedge_deadline = absl::ToChronoTime(absl::Now() + hedge_delay);
+    StartHedgedAttempt(&hedged_read, 0, request);
+
+    // 等待第一个成功的请求，或者所有请求都失败；取消后仍需等待被取消的
+    // 请求返回，之后才能释放它的 context
+    bool hedge_checked = false;
+    while (hedged_read.pending > 0) {
+        void* tag;
+        bool ok;
+        auto next_status = grpc::CompletionQueue::GOT_EVENT;
+        if (!hedge_checked && hedged_read.winner < 0) {
+            next_status = hedged_read.cq.AsyncNext(&tag, &ok, hedge_deadline);
+        } else if (!hedged_read.cq.Next(&tag, &ok)) {
+            next_status = grpc::CompletionQueue::SHUTDOWN;
+        }
+
+        if (next_status == grpc::CompletionQueue::TIMEOUT) {
+            hedge_checked = true;
+            if (hedge_budget_->TryAcquire()) {
+                GetClientMetrics().hedges_issued->Increment();
+                DFS_VLOG(1) << "hedge read " << request.chunk_handle()
+                            << " to " << secondary_address;
+                // 对冲请求读到自己的缓冲区，避免与原请求同时写入 buffer
+                auto& hedge_attempt = hedged_read.attempts[1];
+                hedge_attempt.data.resize(request.length());
+                hedge_attempt.buffer = &hedge_attempt.data[0];
+                StartHedgedAttempt(&hedged_read, 1, request);
+            }
+            continue;
+        }
+        if (next_status != grpc::CompletionQueue::GOT_EVENT) {
+            break;
+        }
+
+        auto attempt = static_cast<HedgedRead::Attempt*>(tag);
+        hedged_read.pending--;
+        FinishHedgedAttempt(attempt, request);
+        if (hedged_read.winner < 0 && HedgedRead::IsGood(*attempt)) {
+            hedged_read.winner = attempt - hedged_read.attempts;
+            // 取消尚未返回的请求
+            for (int i = 0; i < hedged_read.launched; i++) {
+                auto& other = hedged_read.attempts[i];
+                if (!other.done) {
+                    other.cancelled = true;
+                    other.context.TryCancel();
+                }
+            }
+        }
+    }
+
+    hedged_read.cq.Shutdown();
+    void* tag;
+    bool ok;
+    while (hedged_read.cq.Next(&tag, &ok)) {
+    }
+
+    *hedged = hedged_read.launched > 1;
+    if (hedged_read.winner == 1) {
+        hedge_budget_->RecordWin();
+        GetClientMetrics().hedges_won->Increment();
+        const auto& attempt = hedged_read.attempts[1];
+        memcpy(buffer, attempt.buffer,
+               attempt.respond_or.value().read_length());
+    }
+    // 都失败时返回原请求的结果
+    return std::move(
+        hedged_read.attempts[std::max(hedged_read.winner, 0)].respond_or);
+}
+
+void DfsClientImpl::StartHedgedAttempt(HedgedRead* hedged_read, int index,
+                                       const ReadFileChunkRequest& request) {
+    auto& attempt = hedged_read->attempts[index];
+    attempt.context.set_deadline(absl::ToChronoTime(
+        absl::Now() +
+        absl::Milliseconds(config_manager_->GetClientReadTimeoutMs())));
+    {
+        // 对冲请求与原请求是同一个父 span 下的兄弟
+        common::ScopedTraceContext trace_scope(hedged_read->trace_context);
+        attempt.span =
+            std::make_unique<common::Span>("ReadFileChunk", &attempt.context);
+    }
+
+    replica_selector_->BeginRequest(attempt.server_address);
+    attempt.start_time = absl::Now();
+    GetChunkServerFileServiceClient(attempt.server_address)
+        ->AsyncReadFileChunk(request, &attempt.context, &attempt.respond_buffer,
+                             &attempt.status, &hedged_read->cq, &attempt);
+    hedged_read->launched++;
+    hedged_read->pending++;
+}
+
+void DfsClientImpl::FinishHedgedAttempt(HedgedRead::Attempt* attempt,
+                                        const ReadFileChunkRequest& request) {
+    attempt->done = true;
+    attempt->span->SetStatus(attempt->status);
+    attempt->span->End();
+    if (attempt->cancelled) {
+        replica_selector_->CancelRequest(attempt->server_address);
+        attempt->respond_or = common::StatusGrpc2Protobuf(attempt->status);
+        return;
+    }
+
+    if (attempt->status.ok()) {
+        ReadFileChunkRespond respond;
+        auto parse_status = grpc_client::ParseReadFileChunkRespond(
+            &attempt->respond_buffer, attempt->buffer, request.length(),
+            &respond);
+        if (parse_status.ok()) {
+            attempt->respond_or = std::move(respond);
+        } else {
+            attempt->respond_or = parse_status;
+        }
+    } else {
+        attempt->respond_or = common::StatusGrpc2Protobuf(attempt->status);
+    }
+
+    // 传输错误、超时与块服务器内部错误时换下一个副本，并让该块服务器退避
+    const bool server_ok =
+        attempt->respond_or.ok() &&
+        attempt->respond_or.value().status() != ReadFileChunkRespond::UNKNOW;
+    replica_selector_->EndRequest(attempt->server_address,
+                                  absl::Now() - attempt->start_time,
+                                  server_ok);
+}
+
+bool DfsClientImpl::HedgedRead::IsGood(const Attempt& attempt) {
+    return attempt.respond_or.ok() &&
+           attempt.respond_or.value().status() == ReadFileChunkRespond::OK;
 }
 
 google::protobuf::util::StatusOr<size_t> DfsClientImpl::WriteFile(
     const char* filename, void* buffer, size_t offset, size_t nbytes) {
+    return WriteFile(GetPathFile(filename), static_cast<const char*>(buffer),
+                     offset, nbytes);
+}
+
+google::protobuf::util::Status DfsClientImpl::SyncFile(const char* filename) {
+    FileHandle* file = FindPathFile(filename);
+    if (!file) {
+        return OkStatus();
+    }
+    return SyncFile(file);
+}
+
+google::protobuf::util::StatusOr<size_t> DfsClientImpl::WriteFileDirect(
+    FileHandle* file, const char* buffer, size_t offset, size_t nbytes) {
     // TODO: use config file, chunk is 4MB
     const size_t chunk_size = config_manager_->GetBlockSize() * common::bytesMB;
     size_t chunk_start_offset = offset % chunk_size;
@@ -177,24 +940,27 @@ google::protobuf::util::StatusOr<size_t> DfsClientImpl::WriteFile(
 
     for (size_t chunk_index = offset / chunk_size; remain_bytes > 0;
          chunk_index++) {
-        size_t bytes_to_write = std::min(remain_bytes, chunk_size);
+        // 合并后的写入可能跨越数据块边界，每次只写到当前数据块的末尾
+        size_t bytes_to_write =
+            std::min(remain_bytes, chunk_size - chunk_start_offset);
 
-        auto start = std::chrono::high_resolution_clock::now();  // 记录开始时间
-        void* buffer_start = ((char*)buffer + bytes_write);
-        auto respond_or = WriteFileChunk(filename, buffer_start, chunk_index,
+        const char* buffer_start = buffer + bytes_write;
+        const uint64_t start_micros = common::MonotonicMicros();
+        auto respond_or = WriteFileChunk(file, buffer_start, chunk_index,
                                          chunk_start_offset, bytes_to_write);
-        auto end = std::chrono::high_resolution_clock::now();  // 记录结束时间
-        double durationMs =
-            std::chrono::duration_cast<std::chrono::milliseconds>(end - start)
-                .count();
-
-        LOG(INFO) << "write file chunk " << durationMs << "ms";
+        GetClientMetrics().chunk_write_latency->Record(
+            common::MonotonicMicros() - start_micros);
 
         if (!respond_or.ok()) {
             return respond_or.status();
         }
 
         size_t actually_write_bytes = respond_or.value().write_length();
+        if (actually_write_bytes == 0) {
+            // 没有写入任何数据时重试也不会前进，作为失败返回
+            return DataLossError("chunk server wrote 0 bytes at offset " +
+                                 std::to_string(offset + bytes_write));
+        }
 
         // set parameters
         chunk_start_offset = 0;
@@ -206,85 +972,58 @@ google::protobuf::util::StatusOr<size_t> DfsClientImpl::WriteFile(
 }
 
 google::protobuf::util::StatusOr<protos::grpc::WriteFileChunkRespond>
-DfsClientImpl::WriteFileChunk(const char* filename, void* buffer,
+DfsClientImpl::WriteFileChunk(FileHandle* file, const char* buffer,
                               size_t chunk_index, size_t offset,
                               size_t nbytes) {
-    std::string chunk_handle;
-    size_t chunk_version;
-    CacheManager::ChunkServerLocationEntry entry;
-    // talk to master or cache
-    auto get_metadata_status =
-        GetChunkMetedata(filename, chunk_index, OpenFileRequest::WRITE,
-                         chunk_handle, chunk_version, entry);
+    // 一个数据块的写入：获取元数据、向所有副本推送数据、通知主副本写入
+    common::Span span("WriteChunk");
+    FileHandle::ChunkMetadata metadata;
+    // 租约有效期内使用缓存的写元数据，不再向 master 申请
+    auto get_metadata_status = GetChunkMetedata(
+        file, chunk_index, OpenFileRequest::WRITE, &metadata);
     if (!get_metadata_status.ok()) {
         return get_metadata_status;
     }
+    const std::string& chunk_handle = metadata.chunk_handle;
+    const auto& entry = metadata.entry;
 
-    absl::Time start_time = absl::Now();
-    // 需要发送的数据
-    auto data_to_send = std::string((const char*)buffer, nbytes);
-    absl::Time end_time = absl::Now();
-    absl::Duration elapsed_time = end_time - start_time;
-    LOG(INFO) << "make nbytes buffer to data_to_send "
-              << absl::ToDoubleMilliseconds(elapsed_time) << "ms";
-
-    start_time = absl::Now();
-    // 数据的校验和
-    auto checksum = dfs::common::ComputeHash(data_to_send);
-    end_time = absl::Now();
-    elapsed_time = end_time - start_time;
-    LOG(INFO) << "ComputeHash data_to_send "
-              << absl::ToDoubleMilliseconds(elapsed_time) << "ms";
+    // 数据的校验和，直接对调用者的 buffer 计算
+    auto checksum = dfs::common::ComputeChecksum(
+        ConfigManager::GetInstance()->GetPayloadChecksumType(), buffer, nbytes);
 
-    // 数据发送线程
+    // 数据发送线程，所有副本的请求都直接引用调用者的 buffer，不复制数据
+    common::Span push_span("PushChunkData");
+    push_span.SetAttribute("bytes", nbytes);
+    const auto trace_context = common::CurrentTraceContext();
     std::vector<std::thread> send_data_threads;
     for (const auto& location : entry.locations) {
         std::string server_address = location.server_hostname() + ":" +
                                      std::to_string(location.server_port());
 
         send_data_threads.push_back(std::thread([&, server_address]() {
-            // 设置数据发送请求
-            SendChunkDataRequest send_request;
-            start_time = absl::Now();
-            // 数据的校验和
-            send_request.set_checksum(checksum);
-            end_time = absl::Now();
-            elapsed_time = end_time - start_time;
-            LOG(INFO) << "request set chunksum "
-                      << absl::ToDoubleMilliseconds(elapsed_time) << "ms";
-
-            start_time = absl::Now();
-            // 数据的校验和
-            send_request.set_data(data_to_send);
-            end_time = absl::Now();
-            elapsed_time = end_time - start_time;
-            LOG(INFO) << "request set data "
-                      << absl::ToDoubleMilliseconds(elapsed_time) << "ms";
-
+            common::ScopedTraceContext trace_scope(trace_context);
             // 获取 grpc 客户端
             auto chunk_server_file_service_client =
                 GetChunkServerFileServiceClient(server_address);
 
-            start_time = absl::Now();
             auto send_respond_or =
-                chunk_server_file_service_client->SendRequest(send_request);
-            end_time = absl::Now();
-            elapsed_time = end_time - start_time;
-            LOG(INFO) << "request send data, send request "
-                      << absl::ToDoubleMilliseconds(elapsed_time) << "ms";
+                chunk_server_file_service_client->SendChunkData(
+                    checksum, buffer, nbytes);
             if (!send_respond_or.ok()) {
-                LOG(ERROR) << "send chunk data is failed, because "
-                           << send_respond_or.status().ToString();
+                DFS_LOG_RATE_LIMITED(ERROR, 10)
+                    << "send chunk data is failed, because "
+                    << send_respond_or.status().ToString();
             } else {
                 // ok
                 auto send_respond = send_respond_or.value();
                 if (send_respond.status() ==
                     protos::grpc::SendChunkDataRespond::OK) {
-                    LOG(INFO)
+                    DFS_VLOG(2)
                         << "send chunk data to " << server_address << " is ok";
                 } else {
-                    LOG(ERROR) << "send chunk data to " << server_address
-                               << " failed, because " << send_respond.status();
+                    DFS_LOG_RATE_LIMITED(ERROR, 10)
+                        << "send chunk data to " << server_address
+                        << " failed, because " << send_respond.status();
                 }
             }
         }));
@@ -294,24 +1033,18 @@ DfsClientImpl::WriteFileChunk(const char* filename, void* buffer,
     for (auto& thread : send_data_threads) {
         thread.join();
     }
+    push_span.End();
 
     // TODO:
     // 将数据写入到主副本块服务器，让主副本块服务器在将更新推送到其他副本的块服务器
 
-    start_time = absl::Now();
-
     WriteFileChunkRequest write_request;
     write_request.mutable_header()->set_chunk_handle(chunk_handle);
-    write_request.mutable_header()->set_version(chunk_version);
+    write_request.mutable_header()->set_version(metadata.version);
     write_request.mutable_header()->set_offset(offset);
     write_request.mutable_header()->set_length(nbytes);
     write_request.mutable_header()->set_checksum(checksum);
 
-    end_time = absl::Now();
-    elapsed_time = end_time - start_time;
-    LOG(INFO) << "set up write data request "
-              << absl::ToDoubleMilliseconds(elapsed_time) << "ms";
-
     // 将块服务器地址写入请求中
     for (auto location : entry.locations) {
         write_request.mutable_locations()->Add(std::move(location));
@@ -321,37 +1054,63 @@ DfsClientImpl::WriteFileChunk(const char* filename, void* buffer,
         entry.primary_location.server_hostname() + ":" +
         std::to_string(entry.primary_location.server_port());
 
-    LOG(INFO) << "try to get primary_server_address: "
-              << primary_server_address;
+    DFS_VLOG(2) << "try to get primary_server_address: "
+                << primary_server_address;
 
     // 获取 grpc 客户端
     auto chunk_server_file_service_client =
         GetChunkServerFileServiceClient(primary_server_address);
 
     if (!chunk_server_file_service_client) {
-        LOG(ERROR) << "can not get primary chunk server client, ip:port is "
-                   << primary_server_address;
+        DFS_LOG_RATE_LIMITED(ERROR, 10)
+            << "can not get primary chunk server client, ip:port is "
+            << primary_server_address;
+        file->InvalidateChunkMetadata(chunk_index, true);
         return UnknownError("can not talk to primary chunk server");
     }
 
-    start_time = absl::Now();
-
     auto respond_or =
         chunk_server_file_service_client->SendRequest(write_request);
-
-    end_time = absl::Now();
-    elapsed_time = end_time - start_time;
-    LOG(INFO) << "write data, sendrequest "
-              << absl::ToDoubleMilliseconds(elapsed_time) << "ms";
     if (!respond_or.ok()) {
-        LOG(ERROR) << "write file chunk respond is not ok, status: "
-                   << respond_or.status().ToString();
+        DFS_LOG_RATE_LIMITED(ERROR, 10)
+            << "write file chunk respond is not ok, status: "
+            << respond_or.status().ToString();
+        // 租约或主副本可能已经变化，下一次写入重新向 master 获取
+        file->InvalidateChunkMetadata(chunk_index, true);
         return respond_or.status();
     }
+    // 写入后数据块的版本可能已经变化，读元数据需要重新获取
+    file->InvalidateChunkMetadata(chunk_index, false);
+
+    const auto mutation_status = respond_or.value().status();
+    if (mutation_status == FileChunkMutationStatus::OK) {
+        return respond_or.value();
+    }
+
+    DFS_LOG_RATE_LIMITED(ERROR, 10)
+        << "write " << chunk_handle << " to " << primary_server_address
+        << " failed, status: " << mutation_status;
+    file->InvalidateChunkMetadata(chunk_index, true);
+    switch (mutation_status) {
+        case FileChunkMutationStatus::NOT_FOUND:
+            return NotFoundError("chunk " + chunk_handle + " not found");
+        case FileChunkMutationStatus::OUT_OF_RANGE:
+            return OutOfRangeError("write out of range in chunk " +
+                                   chunk_handle);
+        case FileChunkMutationStatus::VERSION_ERROR:
+            return FailedPreconditionError("version error when write chunk " +
+                                           chunk_handle);
+        default:
+            return UnknownError("write chunk " + chunk_handle + " failed");
+    }
+}
 
-    return respond_or.value();
+void DfsClientImpl::SetReadOptions(const ReadOptions& options) {
+    read_options_ = options;
 }
 
+HedgeBudget* DfsClientImpl::GetHedgeBudget() { return hedge_budget_.get(); }
+
 std::shared_ptr<dfs::grpc_client::ChunkServerFileServiceClient>
 DfsClientImpl::GetChunkServerFileServiceClient(const std::string& address) {
     auto value_pair = chunk_server_file_service_clients_.TryGet(address);
@@ -399,8 +1158,8 @@ void DfsClientImpl::CacheToCacheManager(
         // add log
     }
 
-    LOG(INFO) << "metadata from master, primary location: "
-              << respond.metadata().primary_location().DebugString();
+    DFS_VLOG(2) << "metadata from master, primary location: "
+                << respond.metadata().primary_location().ShortDebugString();
 
     CacheManager::ChunkServerLocationEntry entry;
     entry.primary_location = respond.metadata().primary_location();
@@ -411,64 +1170,60 @@ void DfsClientImpl::CacheToCacheManager(
 }
 
 google::protobuf::util::Status DfsClientImpl::GetChunkMetedata(
-    const char* filename, const size_t& chunk_index,
-    const OpenFileRequest::OpenMode& openmode, std::string& chunk_handle,
-    size_t& chunk_version, CacheManager::ChunkServerLocationEntry& entry) {
-    bool metedata_in_cache = true;
-    // // get chunk_handle, chunk_version, entry from cache.
-    // auto cache_chunk_handle_or =
-    //     cache_manager_->GetChunkHandle(filename, chunk_index);
-    // if (cache_chunk_handle_or.ok()) {
-    //     chunk_handle = cache_chunk_handle_or.value();
-    //     auto cache_chunk_version_or =
-    //         cache_manager_->GetChunkVersion(chunk_handle);
-    //     if (cache_chunk_version_or.ok()) {
-    //         chunk_version = cache_chunk_version_or.value();
-    //         auto cache_chunk_server_location_or =
-    //             cache_manager_->GetChunkServerLocationEntry(chunk_handle);
-    //         if (cache_chunk_server_location_or.ok()) {
-    //             LOG(INFO) << "file metadata in cache";
-    //             entry = cache_chunk_server_location_or.value();
-    //         } else {
-    //             metedata_in_cache = false;
-    //         }
-    //     } else {
-    //         metedata_in_cache = false;
-    //     }
-    // } else {
-    //     metedata_in_cache = false;
-    // }
-    metedata_in_cache = false;
-
-    if (!metedata_in_cache) {
-        LOG(INFO) << "talk to master metadata service";
-        // talk to master_metadata_service
-        OpenFileRequest request;
-        request.set_filename(filename);
-        request.set_chunk_index(chunk_index);
-        request.set_mode(openmode);
-        request.set_create_if_not_exists(openmode == OpenFileRequest::WRITE);
-
-        auto respond_or = master_metadata_service_client_->SendRequest(request);
-        if (!respond_or.ok()) {
-            LOG(INFO) << "get file chunk metadata is not ok";
-            return respond_or.status();
-        }
+    FileHandle* file, const size_t& chunk_index,
+    const OpenFileRequest::OpenMode& openmode,
+    FileHandle::ChunkMetadata* metadata) {
+    const bool write = openmode == OpenFileRequest::WRITE;
+    const absl::Time now = absl::Now();
+    if (file->GetChunkMetadata(chunk_index, write, now, metadata)) {
+        GetClientMetrics().metadata_cache_hits->Increment();
+        return OkStatus();
+    }
+
+    DFS_VLOG(1) << "talk to master metadata service";
+    GetClientMetrics().metadata_requests->Increment();
+    // talk to master_metadata_service
+    OpenFileRequest request;
+    request.set_filename(file->filename());
+    request.set_chunk_index(chunk_index);
+    request.set_mode(openmode);
+    request.set_create_if_not_exists(write);
+    request.set_client_id(client_id_);
+    request.set_session_epoch(session_epoch_);
 
-        // cache
-        CacheToCacheManager(filename, chunk_index, respond_or.value());
-        chunk_handle =
-            cache_manager_->GetChunkHandle(filename, chunk_index).value();
-        chunk_version = cache_manager_->GetChunkVersion(chunk_handle).value();
-        entry =
-            cache_manager_->GetChunkServerLocationEntry(chunk_handle).value();
+    auto respond_or = master_metadata_service_client_->SendRequest(request);
+    if (!respond_or.ok()) {
+        DFS_LOG_RATE_LIMITED(WARNING, 10)
+            << "get file chunk metadata is not ok, status: "
+            << respond_or.status().ToString();
+        return respond_or.status();
     }
 
+    // cache
+    const auto& respond = respond_or.value();
+    CacheToCacheManager(file->filename().c_str(), chunk_index, respond);
+    metadata->chunk_handle = respond.metadata().chunk_handle();
+    metadata->version = respond.metadata().version();
+    metadata->entry.primary_location = respond.metadata().primary_location();
+    metadata->entry.locations.assign(respond.metadata().locations().begin(),
+                                     respond.metadata().locations().end());
+
     // no chunk server?
-    if (entry.locations.empty()) {
+    if (metadata->entry.locations.empty()) {
         return UnknownError("chunk server is empty");
     }
 
+    // 写元数据在租约到期前有效，租约从发送请求之前开始计算
+    if (write) {
+        metadata->expire_time =
+            now + absl::Seconds(config_manager_->GetLeaseTimeout()) -
+            kLeaseRenewMargin;
+    } else {
+        metadata->expire_time =
+            now + absl::Seconds(config_manager_->GetClientCacheTimeout());
+    }
+    file->SetChunkMetadata(chunk_index, write, *metadata);
+
     return OkStatus();
 }
 
@@ -1,13 +1,23 @@
 #ifndef DFS_CLIENT_DFS_CLIENT_IMPL_H
 #define DFS_CLIENT_DFS_CLIENT_IMPL_H
 
+#include <absl/synchronization/mutex.h>
 #include <google/protobuf/stubs/statusor.h>
 
+#include <atomic>
+#include <memory>
 #include <string>
+#include <thread>
 
 #include "master_metadata_service.grpc.pb.h"
 #include "src/client/client_cache_manager.h"
+#include "src/client/file_handle.h"
+#include "src/client/file_read_stream.h"
+#include "src/client/file_write_buffer.h"
+#include "src/client/hedge_budget.h"
+#include "src/client/replica_selector.h"
 #include "src/common/config_manager.h"
+#include "src/common/tracing.h"
 #include "src/common/utils.h"
 #include "src/grpc_client/chunk_server_file_service_client.h"
 #include "src/grpc_client/master_metadata_service_client.h"
@@ -15,41 +25,215 @@
 namespace dfs {
 namespace client {
 
-// 实现 client 对文件的基本操作
+// 实现 client 对文件的基本操作。按路径的读写使用每个路径一个的隐式
+// FileHandle，与 OpenFile 返回的 FileHandle 共享同样的元数据缓存与缓冲，
+// 只保留最近使用的 max_path_files 个
 class DfsClientImpl {
    public:
+    struct ReadOptions {
+        // 原请求超过该块服务器最近延迟的分位数仍未返回时，向下一个副本
+        // 发送对冲请求，取先返回的结果
+        bool hedged_read = false;
+        // 经过文件的读取流，顺序读取时预读后续数据
+        bool readahead = false;
+    };
+
     DfsClientImpl();
 
-    google::protobuf::util::Status CreateFile(const char* filename);
+    // 停止后台刷新线程，刷新所有文件的写回缓冲区
+    ~DfsClientImpl();
+
+    // codec 为文件的压缩算法，块服务器按分块压缩文件的数据块
+    google::protobuf::util::Status CreateFile(
+        const char* filename,
+        const protos::ChunkCodec& codec = protos::CODEC_NONE);
+
+    // 打开文件，flags 为 OpenFlag 的组合。带 CREATE 时文件不存在则以 codec
+    // 创建，否则文件不存在时返回 NotFound。返回的 FileHandle 由客户端持有，
+    // 在 CloseFile 后失效
+    google::protobuf::util::StatusOr<FileHandle*> OpenFile(
+        const char* filename, unsigned int flags,
+        const protos::ChunkCodec& codec = protos::CODEC_NONE);
+
+    // 读取打开的文件的 [offset, offset + nbytes) 到 buffer，
+    // 使用客户端默认的读取选项
+    google::protobuf::util::StatusOr<size_t> ReadFile(FileHandle* file,
+                                                      size_t offset,
+                                                      size_t nbytes,
+                                                      char* buffer);
+
+    // 写入打开的文件，开启写回时先写入文件的写回缓冲区
+    google::protobuf::util::StatusOr<size_t> WriteFile(FileHandle* file,
+                                                       const char* buffer,
+                                                       size_t offset,
+                                                       size_t nbytes);
+
+    google::protobuf::util::Status SyncFile(FileHandle* file);
+
+    // 刷新写回缓冲区并释放 file，返回刷新的错误
+    google::protobuf::util::Status CloseFile(FileHandle* file);
 
     google::protobuf::util::Status DeleteFile(const char* filename);
 
+    // 修改文件的存储方式，转换前先刷新该文件的写回缓冲区。纠删码文件只读，
+    // 文件的写租约过期前无法转换
+    google::protobuf::util::Status SetStorageClass(
+        const char* filename, const protos::StorageClass& storage_class);
+
+    // 使用客户端默认的读取选项
     google::protobuf::util::StatusOr<std::pair<size_t, void*>> ReadFile(
         const char* filename, size_t offset, size_t nbytes);
 
+    google::protobuf::util::StatusOr<std::pair<size_t, void*>> ReadFile(
+        const char* filename, size_t offset, size_t nbytes,
+        const ReadOptions& options);
+
+    // 关闭文件，刷新写回缓冲区并释放文件的读取流与写回缓冲区，
+    // 返回刷新的错误
+    google::protobuf::util::Status CloseFile(const char* filename);
+
+    // 开启写回时写入文件的写回缓冲区，刷新前写入的错误在之后的 WriteFile、
+    // SyncFile 或 CloseFile 中返回
     google::protobuf::util::StatusOr<size_t> WriteFile(
         const char* filename, void* data, size_t offset,
         size_t nbytes);
 
+    // 刷新文件的写回缓冲区
+    google::protobuf::util::Status SyncFile(const char* filename);
+
+    // 设置客户端默认的读取选项
+    void SetReadOptions(const ReadOptions& options);
+
+    // 对冲读取的预算与计数
+    HedgeBudget* GetHedgeBudget();
+
    private:
+    // 一次对冲读取，原请求与对冲请求各一个 Attempt。两个请求在同一个
+    // CompletionQueue 上异步发出，由调用线程等待，不创建线程
+    struct HedgedRead {
+        struct Attempt {
+            std::string server_address;
+            grpc::ClientContext context;
+            std::unique_ptr<common::Span> span;
+            // 未解析的回复与 RPC 的状态
+            grpc::ByteBuffer respond_buffer;
+            grpc::Status status;
+            absl::Time start_time;
+            google::protobuf::util::StatusOr<protos::grpc::ReadFileChunkRespond>
+                respond_or;
+            bool done = false;
+            // 读取的数据写入 buffer，原请求为调用者的 buffer，对冲请求为 data
+            char* buffer = nullptr;
+            std::string data;
+            // 被对方先返回的结果取消
+            bool cancelled = false;
+        };
+
+        static bool IsGood(const Attempt& attempt);
+
+        // 先于 attempts 声明，所有请求结束后才销毁
+        grpc::CompletionQueue cq;
+        Attempt attempts[2];
+        // 调用者的 trace context，两个请求的 span 都是它的子 span
+        common::TraceContext trace_context;
+        // 已发出的请求数量与尚未返回的请求数量
+        int launched = 0;
+        int pending = 0;
+        // 第一个成功返回的请求，没有时为 -1
+        int winner = -1;
+    };
+
+    // 按路径读写时使用的隐式 FileHandle 与最近一次使用的序号
+    struct PathFile {
+        FileHandle* file = nullptr;
+        uint64_t last_use = 0;
+    };
+
+    // 获取路径对应的隐式 FileHandle，不存在时创建，不访问 master。
+    // 隐式 FileHandle 超过 max_path_files_ 时刷新并释放最久未使用的一个
+    FileHandle* GetPathFile(const std::string& filename);
+
+    // 获取路径对应的隐式 FileHandle，不存在时返回 nullptr
+    FileHandle* FindPathFile(const std::string& filename);
+
+    // 开启写回时的后台线程，按 write_flush_ms 刷新没有后续写入的写回缓冲区
+    void RunFlushTimer();
+
+    // file 是否是打开且尚未关闭的文件
+    bool IsOpenFile(FileHandle* file);
+
+    // 先刷新写回缓冲区，再按 options 读取文件到 buffer
+    google::protobuf::util::StatusOr<size_t> ReadFileToBuffer(
+        FileHandle* file, size_t offset, size_t nbytes,
+        const ReadOptions& options, char* buffer);
+
+    // 读取文件的 [offset, offset + nbytes) 到 buffer，不经过读取流
+    google::protobuf::util::StatusOr<size_t> ReadFileInto(
+        FileHandle* file, size_t offset, size_t nbytes,
+        const ReadOptions& options, char* buffer);
+
+    // 不经过写回缓冲区，直接写入块服务器
+    google::protobuf::util::StatusOr<size_t> WriteFileDirect(
+        FileHandle* file, const char* buffer, size_t offset, size_t nbytes);
+
+    // 获取文件的写回缓冲区，不存在时创建。写回缓冲区创建后直到文件释放
+    // 都不会被替换，后台线程可以在不持有 files_lock_ 时刷新
+    FileWriteBuffer* GetWriteBuffer(FileHandle* file);
+
+    // 获取文件的读取流，不存在时创建，预读使用创建时的默认读取选项
+    FileReadStream* GetReadStream(FileHandle* file);
+
     // cache metadata to cache manager
     void CacheToCacheManager(const char* filename,
                              const uint32_t& chunk_index,
                              const protos::grpc::OpenFileRespond& respond);
 
+    // 先从 file 的元数据缓存中获取，缓存中没有或者已过期时向 master 获取
     google::protobuf::util::Status GetChunkMetedata(
-        const char* filename, const size_t& chunk_index,
+        FileHandle* file, const size_t& chunk_index,
         const protos::grpc::OpenFileRequest::OpenMode& openmode,
-        std::string& chunk_handle, size_t& chunk_version,
-        CacheManager::ChunkServerLocationEntry& entry);
+        FileHandle::ChunkMetadata* metadata);
+
+    // 读取的数据直接写入 buffer，返回的 respond 中 data 为空。
+    // 缓存的元数据过期（块服务器返回 NOT_FOUND 或 VERSION_ERROR）时，
+    // 向 master 重新获取元数据后再读取一次
+    google::protobuf::util::StatusOr<protos::grpc::ReadFileChunkRespond>
+    ReadFileChunk(FileHandle* file, size_t chunk_index, size_t offset,
+                  size_t nbytes, const ReadOptions& options, char* buffer);
+
+    // 按距离与负载依次尝试数据块的副本，stale 返回是否有副本认为元数据已过期
+    google::protobuf::util::StatusOr<protos::grpc::ReadFileChunkRespond>
+    ReadFromReplicas(const FileHandle::ChunkMetadata& metadata, size_t offset,
+                     size_t nbytes, const ReadOptions& options, char* buffer,
+                     bool* stale);
 
+    // 向一个副本发送读请求并记录延迟，数据写入 buffer
     google::protobuf::util::StatusOr<protos::grpc::ReadFileChunkRespond>
-    ReadFileChunk(const char* filename, size_t chunk_index,
-                  size_t offset, size_t nbytes);
+    ReadFromReplica(const std::string& server_address,
+                    const protos::grpc::ReadFileChunkRequest& request,
+                    grpc::ClientContext* context, char* buffer);
 
+    // 异步发出对冲读取中的第 index 个请求
+    void StartHedgedAttempt(HedgedRead* hedged_read, int index,
+                            const protos::grpc::ReadFileChunkRequest& request);
+
+    // 请求返回后解析回复并记录延迟，被取消的请求不记录
+    void FinishHedgedAttempt(HedgedRead::Attempt* attempt,
+                             const protos::grpc::ReadFileChunkRequest& request);
+
+    // 先向 primary_address 发送读请求，超过阈值未返回且预算允许时再向
+    // secondary_address 发送，返回先成功的结果并取消另一个请求。
+    // hedged 返回是否发送了对冲请求
+    google::protobuf::util::StatusOr<protos::grpc::ReadFileChunkRespond>
+    HedgedReadFromReplicas(const protos::grpc::ReadFileChunkRequest& request,
+                           const std::string& primary_address,
+                           const std::string& secondary_address, char* buffer,
+                           bool* hedged);
+
+    // 直接从调用者的 buffer 发送数据，主副本返回的状态不为 OK 时返回错误
     google::protobuf::util::StatusOr<protos::grpc::WriteFileChunkRespond>
-    WriteFileChunk(const char* filename, void* data,
-                   size_t chunk_index, size_t offset, size_t nbytes);
+    WriteFileChunk(FileHandle* file, const char* data, size_t chunk_index,
+                   size_t offset, size_t nbytes);
 
     std::shared_ptr<dfs::grpc_client::ChunkServerFileServiceClient>
     GetChunkServerFileServiceClient(const std::string& address);
@@ -66,7 +250,47 @@ class DfsClientImpl {
 
     std::shared_ptr<CacheManager> cache_manager_;
 
+    // 读取时选择副本
+    std::unique_ptr<ReplicaSelector> replica_selector_;
+
+    ReadOptions read_options_;
+
+    std::unique_ptr<HedgeBudget> hedge_budget_;
+
+    // 执行预读，需在 open_files_ 之前声明，读取流析构时等待预读结束
+    std::unique_ptr<dfs::common::Executor> readahead_executor_;
+
+    // 是否开启写回
+    bool write_back_ = false;
+
+    // 保护 open_files_、path_files_ 与文件的写回缓冲区的创建，
+    // 后台刷新线程与调用线程并发访问
+    absl::Mutex files_lock_;
+
+    // 打开的文件，包括按路径读写时的隐式 FileHandle。后台刷新线程在
+    // 刷新期间持有 FileHandle 的引用，关闭的文件在刷新结束后才释放
+    absl::flat_hash_map<FileHandle*, std::shared_ptr<FileHandle>> open_files_;
+
+    // map<filename, PathFile>，按路径读写时使用的 FileHandle
+    absl::flat_hash_map<std::string, PathFile> path_files_;
+
+    // 隐式 FileHandle 的使用序号，由 files_lock_ 保护
+    uint64_t path_file_uses_ = 0;
+
+    size_t max_path_files_ = 16;
+
+    // 停止后台刷新线程，由 files_lock_ 保护
+    bool stopped_ = false;
+
+    // 后台刷新线程，只在开启写回时启动
+    std::thread flush_thread_;
+
     dfs::common::ConfigManager* config_manager_;
+
+    // 写租约所属的客户端会话，同一进程内的客户端相同
+    std::string client_id_;
+
+    uint64_t session_epoch_ = 0;
 };
 
 }  // namespace client
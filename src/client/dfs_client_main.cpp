@@ -1,9 +1,11 @@
+#include <absl/container/flat_hash_map.h>
 #include <absl/strings/str_split.h>
 
 #include <iostream>
 #include <string>
 
 #include "src/client/dfs_client.h"
+#include "src/common/compression.h"
 #include "src/common/config_manager.h"
 #include "src/common/system_logger.h"
 
@@ -26,8 +28,14 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    // 按配置切换为异步日志
+    dfs::common::SystemLogger::GetInstance().Configure(
+        dfs::common::SystemLogger::LoadOptions());
+
     init_client();
     std::string command;
+    // map<filename, FileHandle>，通过 open 打开的文件
+    absl::flat_hash_map<std::string, FileHandle*> files;
 
     while (true) {
         std::cout << "DFS >> ";
@@ -35,9 +43,21 @@ int main(int argc, char* argv[]) {
 
         const auto& token = ParseCommand(command);
 
-        if (token[0] == "open" && token.size() == 3) {
-            auto status = open(token[1].c_str(), std::stoi(token[2]));
-            LOG(INFO) << "open status: " << status.ToString();
+        if (token[0] == "open" && (token.size() == 3 || token.size() == 4)) {
+            // open <filename> <flag> [none|lz4|zstd]
+            const auto codec = dfs::common::CompressionCodecFromName(
+                token.size() == 4 ? token[3] : "none",
+                dfs::common::CompressionCodec::NONE);
+            auto file_or = open(token[1].c_str(), std::stoi(token[2]),
+                                static_cast<protos::ChunkCodec>(codec));
+            if (file_or.ok()) {
+                auto iter = files.find(token[1]);
+                if (iter != files.end()) {
+                    dfs::client::close(iter->second);
+                }
+                files[token[1]] = file_or.value();
+            }
+            LOG(INFO) << "open status: " << file_or.status().ToString();
         } else if (token[0] == "read" && token.size() == 4) {
             auto status = read(token[1].c_str(), std::stoi(token[2]),
                                std::stoi(token[3]));
@@ -62,8 +82,32 @@ int main(int argc, char* argv[]) {
         } else if (token[0] == "set" && token.size() == 3) {
             auto status = set(token[1].c_str(), std::stoi(token[2]));
             LOG(INFO) << "set status: " << status.ToString();
+        } else if (token[0] == "fsync" && token.size() == 2) {
+            auto status = fsync(token[1].c_str());
+            LOG(INFO) << "fsync status: " << status.ToString();
+        } else if (token[0] == "close" && token.size() == 2) {
+            auto status = dfs::client::close(token[1].c_str());
+            auto iter = files.find(token[1]);
+            if (iter != files.end()) {
+                auto file_status = dfs::client::close(iter->second);
+                if (status.ok()) {
+                    status = file_status;
+                }
+                files.erase(iter);
+            }
+            LOG(INFO) << "close status: " << status.ToString();
+        } else if (token[0] == "storage" && token.size() == 3 &&
+                   (token[2] == "replicated" || token[2] == "ec")) {
+            // storage <filename> <replicated|ec>
+            auto status = set_storage_class(
+                token[1].c_str(), token[2] == "ec"
+                                      ? protos::STORAGE_ERASURE_CODED
+                                      : protos::STORAGE_REPLICATED);
+            LOG(INFO) << "storage status: " << status.ToString();
         } else if (token[0] == "quit") {
             LOG(INFO) << "Quit....";
+            // 刷新所有文件的写回缓冲区
+            reset_client();
             break;
         } else {
             LOG(ERROR) << "unknow command";
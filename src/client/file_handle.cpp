@@ -0,0 +1,54 @@
+#include "src/client/file_handle.h"
+
+namespace dfs {
+namespace client {
+
+FileHandle::FileHandle(const std::string& filename, unsigned int flags)
+    : filename_(filename), flags_(flags) {}
+
+bool FileHandle::GetChunkMetadata(size_t chunk_index, bool write,
+                                  absl::Time now,
+                                  ChunkMetadata* metadata) const {
+    absl::MutexLock lock_guard(&lock_);
+    const MetadataMap& metadata_map = write ? write_metadata_ : read_metadata_;
+    auto iter = metadata_map.find(chunk_index);
+    if (iter == metadata_map.end() || iter->second.expire_time <= now) {
+        return false;
+    }
+
+    *metadata = iter->second;
+    return true;
+}
+
+void FileHandle::SetChunkMetadata(size_t chunk_index, bool write,
+                                  const ChunkMetadata& metadata) {
+    absl::MutexLock lock_guard(&lock_);
+    MetadataMap& metadata_map = write ? write_metadata_ : read_metadata_;
+    metadata_map[chunk_index] = metadata;
+}
+
+void FileHandle::InvalidateChunkMetadata(size_t chunk_index, bool write) {
+    absl::MutexLock lock_guard(&lock_);
+    MetadataMap& metadata_map = write ? write_metadata_ : read_metadata_;
+    metadata_map.erase(chunk_index);
+}
+
+void FileHandle::ClearChunkMetadata() {
+    absl::MutexLock lock_guard(&lock_);
+    read_metadata_.clear();
+    write_metadata_.clear();
+}
+
+size_t FileHandle::GetLeaseNums(absl::Time now) const {
+    absl::MutexLock lock_guard(&lock_);
+    size_t lease_nums = 0;
+    for (const auto& [chunk_index, metadata] : write_metadata_) {
+        if (metadata.expire_time > now) {
+            lease_nums++;
+        }
+    }
+    return lease_nums;
+}
+
+}  // namespace client
+}  // namespace dfs
@@ -0,0 +1,103 @@
+#ifndef DFS_CLIENT_FILE_HANDLE_H
+#define DFS_CLIENT_FILE_HANDLE_H
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+#include <absl/time/time.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "src/client/client_cache_manager.h"
+#include "src/client/file_read_stream.h"
+#include "src/client/file_write_buffer.h"
+
+namespace dfs {
+namespace client {
+
+enum OpenFlag { READ = 1, WRITE = 2, CREATE = 4 };
+
+/**
+ * 打开的文件，保存文件在客户端的状态，读写时不再按路径查找
+ * 1. 按数据块缓存从 master 获取的元数据，读元数据在缓存超时前有效；
+ *    写元数据在租约到期前有效，期间的写入沿用同一个租约与版本，
+ *    不再向 master 申请
+ * 2. 块服务器返回 NOT_FOUND、VERSION_ERROR 等错误时，调用方使该数据块的
+ *    元数据失效，下一次读写重新向 master 获取
+ * 3. 持有文件的读取流与写回缓冲区，关闭文件时释放
+ * 元数据缓存可以被预读线程并发访问，读取流与写回缓冲区只能被一个线程使用
+ */
+class FileHandle {
+   public:
+    struct ChunkMetadata {
+        std::string chunk_handle;
+        uint32_t version = 0;
+        CacheManager::ChunkServerLocationEntry entry;
+        // 元数据的过期时间，写元数据即租约的到期时间
+        absl::Time expire_time;
+    };
+
+    FileHandle(const std::string& filename, unsigned int flags);
+
+    const std::string& filename() const { return filename_; }
+
+    unsigned int flags() const { return flags_; }
+
+    bool readable() const { return flags_ & OpenFlag::READ; }
+
+    bool writable() const { return flags_ & OpenFlag::WRITE; }
+
+    // 获取数据块在 now 时仍有效的元数据，write 为 true 时获取写元数据
+    bool GetChunkMetadata(size_t chunk_index, bool write, absl::Time now,
+                          ChunkMetadata* metadata) const;
+
+    void SetChunkMetadata(size_t chunk_index, bool write,
+                          const ChunkMetadata& metadata);
+
+    // 使数据块的读元数据（write 为 true 时为写元数据）失效
+    void InvalidateChunkMetadata(size_t chunk_index, bool write);
+
+    // 清空所有元数据
+    void ClearChunkMetadata();
+
+    // 在 now 时仍持有租约的数据块数量
+    size_t GetLeaseNums(absl::Time now) const;
+
+    // 读取流与写回缓冲区，没有时返回 nullptr
+    FileReadStream* read_stream() const { return read_stream_.get(); }
+
+    void set_read_stream(std::unique_ptr<FileReadStream> read_stream) {
+        read_stream_ = std::move(read_stream);
+    }
+
+    FileWriteBuffer* write_buffer() const { return write_buffer_.get(); }
+
+    void set_write_buffer(std::unique_ptr<FileWriteBuffer> write_buffer) {
+        write_buffer_ = std::move(write_buffer);
+    }
+
+   private:
+    using MetadataMap = absl::flat_hash_map<size_t, ChunkMetadata>;
+
+    const std::string filename_;
+
+    const unsigned int flags_;
+
+    mutable absl::Mutex lock_;
+
+    // map<chunk_index, ChunkMetadata>
+    MetadataMap read_metadata_;
+
+    MetadataMap write_metadata_;
+
+    std::unique_ptr<FileWriteBuffer> write_buffer_;
+
+    // 预读会访问元数据缓存，读取流最后声明，析构时最先等待预读结束
+    std::unique_ptr<FileReadStream> read_stream_;
+};
+
+}  // namespace client
+}  // namespace dfs
+
+#endif  // DFS_CLIENT_FILE_HANDLE_H
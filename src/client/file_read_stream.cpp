@@ -0,0 +1,147 @@
+#include "src/client/file_read_stream.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace dfs {
+namespace client {
+
+FileReadStream::FileReadStream(const Options& options,
+                               ReadFunction read_function,
+                               common::Executor* executor)
+    : options_(options),
+      read_function_(std::move(read_function)),
+      executor_(executor) {
+    options_.initial_window = std::max<uint64_t>(options_.initial_window, 1);
+    options_.max_window =
+        std::max(options_.max_window, options_.initial_window);
+    window_ = options_.initial_window;
+}
+
+FileReadStream::~FileReadStream() {
+    absl::MutexLock lock_guard(&lock_);
+    lock_.Await(absl::Condition(
+        +[](uint32_t* running_prefetches) { return *running_prefetches == 0; },
+        &running_prefetches_));
+}
+
+google::protobuf::util::StatusOr<size_t> FileReadStream::Read(size_t offset,
+                                                              size_t nbytes,
+                                                              char* buffer) {
+    const bool sequential = offset == next_offset_;
+    if (!sequential) {
+        DropBuffer();
+        window_ = options_.initial_window;
+    }
+
+    // 先从预读的数据中复制，不够时等待覆盖当前位置的预读
+    size_t copied = 0;
+    while (copied < nbytes) {
+        const uint64_t position = offset + copied;
+        const size_t bytes =
+            CopyFromBuffer(position, nbytes - copied, buffer + copied);
+        if (bytes > 0) {
+            copied += bytes;
+            prefetched_bytes_ += bytes;
+            continue;
+        }
+
+        if (!prefetch_ || position < prefetch_->offset ||
+            position >= prefetch_->offset + prefetch_->length) {
+            break;
+        }
+        auto prefetch = std::move(prefetch_);
+        prefetch->done.WaitForNotification();
+        if (!prefetch->ok ||
+            position >= prefetch->offset + prefetch->data.size()) {
+            // 预读失败，之后的数据同步读取
+            window_ = options_.initial_window;
+            break;
+        }
+        buffer_offset_ = prefetch->offset;
+        buffer_ = std::move(prefetch->data);
+    }
+
+    if (copied < nbytes) {
+        auto read_or =
+            read_function_(offset + copied, nbytes - copied, buffer + copied);
+        if (!read_or.ok()) {
+            return read_or.status();
+        }
+        copied += read_or.value();
+    }
+    next_offset_ = offset + copied;
+
+    // 预读的数据剩余不到半个窗口时发起下一次预读
+    if (sequential && !prefetch_) {
+        const uint64_t buffer_end = buffer_offset_ + buffer_.size();
+        const uint64_t unread =
+            buffer_end > next_offset_ ? buffer_end - next_offset_ : 0;
+        if (unread <= window_ / 2) {
+            StartPrefetch(std::max(buffer_end, next_offset_));
+            window_ = std::min(window_ * 2, options_.max_window);
+        }
+    }
+
+    return copied;
+}
+
+void FileReadStream::Invalidate() {
+    DropBuffer();
+    window_ = options_.initial_window;
+}
+
+size_t FileReadStream::CopyFromBuffer(uint64_t offset, size_t nbytes,
+                                      char* buffer) {
+    if (offset < buffer_offset_ || offset >= buffer_offset_ + buffer_.size()) {
+        return 0;
+    }
+
+    const size_t bytes =
+        std::min<uint64_t>(nbytes, buffer_offset_ + buffer_.size() - offset);
+    memcpy(buffer, buffer_.data() + (offset - buffer_offset_), bytes);
+    return bytes;
+}
+
+void FileReadStream::StartPrefetch(uint64_t offset) {
+    auto prefetch = std::make_shared<Prefetch>();
+    prefetch->offset = offset;
+    prefetch->length = window_;
+
+    {
+        absl::MutexLock lock_guard(&lock_);
+        running_prefetches_++;
+    }
+    const bool submitted = executor_->Submit([this, prefetch]() {
+        prefetch->data.resize(prefetch->length);
+        auto read_or = read_function_(prefetch->offset, prefetch->length,
+                                      &prefetch->data[0]);
+        if (read_or.ok()) {
+            prefetch->data.resize(read_or.value());
+            prefetch->ok = true;
+        } else {
+            prefetch->data.clear();
+        }
+        prefetch->done.Notify();
+
+        absl::MutexLock lock_guard(&lock_);
+        running_prefetches_--;
+    });
+
+    // 执行器繁忙时放弃本次预读
+    if (!submitted) {
+        absl::MutexLock lock_guard(&lock_);
+        running_prefetches_--;
+        return;
+    }
+    prefetch_ = std::move(prefetch);
+}
+
+void FileReadStream::DropBuffer() {
+    buffer_.clear();
+    buffer_offset_ = 0;
+    prefetch_.reset();
+}
+
+}  // namespace client
+}  // namespace dfs
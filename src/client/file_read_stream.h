@@ -0,0 +1,107 @@
+#ifndef DFS_CLIENT_FILE_READ_STREAM_H
+#define DFS_CLIENT_FILE_READ_STREAM_H
+
+#include <absl/synchronization/mutex.h>
+#include <absl/synchronization/notification.h>
+#include <google/protobuf/stubs/statusor.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "src/common/executor.h"
+
+namespace dfs {
+namespace client {
+
+/**
+ * 打开文件的顺序读取流，在后台预读后续数据
+ * 1. 本次读取的起始位置等于上一次读取的结束位置时视为顺序读取
+ * 2. 顺序读取时异步预读之后 window 字节的数据，预读的数据被消费到一半时
+ *    发起下一次预读，窗口每次翻倍直到 max_window（与 Linux 内核的预读类似）
+ * 3. 随机读取时丢弃预读的数据，窗口恢复为 initial_window，直接读取
+ * 4. 预读失败（例如越过文件末尾）时丢弃结果，由之后的读取同步读取并返回错误
+ * 一个流只能被一个线程使用
+ */
+class FileReadStream {
+   public:
+    struct Options {
+        uint64_t initial_window = 128 * 1024;
+        uint64_t max_window = 8 * 1024 * 1024;
+    };
+
+    // 从文件 offset 处读取 nbytes 字节到 buffer，返回读到的字节数
+    using ReadFunction =
+        std::function<google::protobuf::util::StatusOr<size_t>(
+            size_t offset, size_t nbytes, char* buffer)>;
+
+    // executor 用于执行预读，生命周期需长于流
+    FileReadStream(const Options& options, ReadFunction read_function,
+                   common::Executor* executor);
+
+    // 等待正在进行的预读结束
+    ~FileReadStream();
+
+    // 读取 [offset, offset + nbytes) 到 buffer，返回读到的字节数
+    google::protobuf::util::StatusOr<size_t> Read(size_t offset, size_t nbytes,
+                                                  char* buffer);
+
+    // 文件被修改，丢弃已经预读的数据
+    void Invalidate();
+
+    // 由预读数据满足的字节数
+    uint64_t GetPrefetchedBytes() const { return prefetched_bytes_; }
+
+    uint64_t window() const { return window_; }
+
+   private:
+    // 一次异步预读
+    struct Prefetch {
+        uint64_t offset = 0;
+        uint64_t length = 0;
+        std::string data;
+        bool ok = false;
+        absl::Notification done;
+    };
+
+    // 从已经预读的数据中复制，返回复制的字节数
+    size_t CopyFromBuffer(uint64_t offset, size_t nbytes, char* buffer);
+
+    // 在 offset 处发起 window_ 字节的预读
+    void StartPrefetch(uint64_t offset);
+
+    // 丢弃预读的数据，正在进行的预读在后台完成后被释放
+    void DropBuffer();
+
+    Options options_;
+
+    ReadFunction read_function_;
+
+    common::Executor* executor_;
+
+    // 预读的数据，位于文件的 [buffer_offset_, buffer_offset_ + buffer_.size())
+    uint64_t buffer_offset_ = 0;
+
+    std::string buffer_;
+
+    // 正在进行的预读
+    std::shared_ptr<Prefetch> prefetch_;
+
+    // 下一次顺序读取的起始位置
+    uint64_t next_offset_ = 0;
+
+    uint64_t window_;
+
+    uint64_t prefetched_bytes_ = 0;
+
+    // 正在执行的预读任务数量，析构时等待归零
+    absl::Mutex lock_;
+
+    uint32_t running_prefetches_ = 0;
+};
+
+}  // namespace client
+}  // namespace dfs
+
+#endif  // DFS_CLIENT_FILE_READ_STREAM_H
@@ -0,0 +1,129 @@
+#include "src/client/file_write_buffer.h"
+
+#include <algorithm>
+#include <string>
+
+namespace dfs {
+namespace client {
+
+using google::protobuf::util::OkStatus;
+
+FileWriteBuffer::FileWriteBuffer(const Options& options,
+                                 WriteFunction write_function)
+    : options_(options), write_function_(std::move(write_function)) {}
+
+google::protobuf::util::Status FileWriteBuffer::Write(size_t offset,
+                                                      const char* data,
+                                                      size_t nbytes) {
+    if (!nbytes) {
+        return OkStatus();
+    }
+
+    absl::MutexLock lock_guard(&lock_);
+    // 与缓冲区不相邻的写入先刷新缓冲区
+    const uint64_t buffer_end = buffer_offset_ + buffer_.size();
+    if (!buffer_.empty() &&
+        (offset < buffer_offset_ || offset > buffer_end)) {
+        auto status = FlushBuffer();
+        if (!status.ok()) {
+            return status;
+        }
+    }
+
+    // 大写入直接写入文件
+    if (nbytes >= options_.max_buffer_bytes) {
+        auto status = FlushBuffer();
+        if (!status.ok()) {
+            return status;
+        }
+        return WriteThrough(offset, data, nbytes);
+    }
+
+    if (buffer_.empty()) {
+        buffer_offset_ = offset;
+        first_write_time_ = absl::Now();
+    }
+
+    // 覆盖缓冲区中已有的部分，超出的部分追加到末尾
+    const size_t position = offset - buffer_offset_;
+    const size_t overlap = std::min(nbytes, buffer_.size() - position);
+    buffer_.replace(position, overlap, data, overlap);
+    buffer_.append(data + overlap, nbytes - overlap);
+
+    if (buffer_.size() >= options_.max_buffer_bytes ||
+        absl::Now() - first_write_time_ >= options_.flush_interval) {
+        return FlushBuffer();
+    }
+    return OkStatus();
+}
+
+google::protobuf::util::Status FileWriteBuffer::Flush() {
+    absl::MutexLock lock_guard(&lock_);
+    auto status = FlushBuffer();
+    if (!error_.ok()) {
+        status = error_;
+        error_ = OkStatus();
+    }
+    return status;
+}
+
+void FileWriteBuffer::FlushExpired(absl::Time now) {
+    absl::MutexLock lock_guard(&lock_);
+    if (!buffer_.empty() &&
+        now - first_write_time_ >= options_.flush_interval) {
+        FlushBuffer();
+    }
+}
+
+void FileWriteBuffer::Discard() {
+    absl::MutexLock lock_guard(&lock_);
+    buffer_.clear();
+    error_ = OkStatus();
+}
+
+size_t FileWriteBuffer::GetBufferedBytes() {
+    absl::MutexLock lock_guard(&lock_);
+    return buffer_.size();
+}
+
+uint64_t FileWriteBuffer::GetFlushes() {
+    absl::MutexLock lock_guard(&lock_);
+    return flushes_;
+}
+
+google::protobuf::util::Status FileWriteBuffer::FlushBuffer() {
+    if (buffer_.empty()) {
+        return OkStatus();
+    }
+
+    auto status = WriteThrough(buffer_offset_, buffer_.data(), buffer_.size());
+    buffer_.clear();
+    return status;
+}
+
+google::protobuf::util::Status FileWriteBuffer::WriteThrough(size_t offset,
+                                                             const char* data,
+                                                             size_t nbytes) {
+    flushes_++;
+    auto write_or = write_function_(offset, data, nbytes);
+    if (!write_or.ok()) {
+        return RecordError(write_or.status());
+    }
+    // 只写入了一部分，剩余的数据不会再被写入
+    if (write_or.value() != nbytes) {
+        return RecordError(google::protobuf::util::DataLossError(
+            "short write at offset " + std::to_string(offset) + ", wrote " +
+            std::to_string(write_or.value()) + " of " +
+            std::to_string(nbytes) + " bytes"));
+    }
+    return OkStatus();
+}
+
+google::protobuf::util::Status FileWriteBuffer::RecordError(
+    const google::protobuf::util::Status& status) {
+    error_ = status;
+    return status;
+}
+
+}  // namespace client
+}  // namespace dfs
@@ -0,0 +1,96 @@
+#ifndef DFS_CLIENT_FILE_WRITE_BUFFER_H
+#define DFS_CLIENT_FILE_WRITE_BUFFER_H
+
+#include <absl/synchronization/mutex.h>
+#include <absl/time/clock.h>
+#include <absl/time/time.h>
+#include <google/protobuf/stubs/statusor.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace dfs {
+namespace client {
+
+/**
+ * 打开文件的写回缓冲区，合并相邻的小写入
+ * 1. 与缓冲区相邻或重叠的写入合并到缓冲区中，不相邻的写入先刷新缓冲区
+ * 2. 缓冲区超过 max_buffer_bytes，或者第一次写入缓冲区超过 flush_interval
+ *    时刷新，大于 max_buffer_bytes 的写入刷新缓冲区后直接写入。
+ *    没有后续写入时由客户端的后台线程调用 FlushExpired 刷新
+ * 3. 刷新失败或者只写入了一部分时缓冲区中的数据被丢弃，错误返回给触发
+ *    刷新的调用，并在下一次 Flush 时再返回一次（与 fsync 的语义类似）
+ * 所有方法都可以在多个线程中调用，刷新期间其他调用等待
+ */
+class FileWriteBuffer {
+   public:
+    struct Options {
+        uint64_t max_buffer_bytes = 4 * 1024 * 1024;
+        absl::Duration flush_interval = absl::Seconds(1);
+    };
+
+    // 将 [offset, offset + nbytes) 写入文件，返回写入的字节数
+    using WriteFunction =
+        std::function<google::protobuf::util::StatusOr<size_t>(
+            size_t offset, const char* data, size_t nbytes)>;
+
+    FileWriteBuffer(const Options& options, WriteFunction write_function);
+
+    // 写入缓冲区，需要刷新时返回刷新的结果
+    google::protobuf::util::Status Write(size_t offset, const char* data,
+                                         size_t nbytes);
+
+    // 刷新缓冲区，返回本次刷新或者之前未报告的刷新错误
+    google::protobuf::util::Status Flush();
+
+    // 第一次写入缓冲区已经超过 flush_interval 时刷新缓冲区，错误留给
+    // 下一次 Write 或 Flush 报告
+    void FlushExpired(absl::Time now);
+
+    // 丢弃缓冲的数据与未报告的错误，例如文件已被删除
+    void Discard();
+
+    // 缓冲区中的字节数
+    size_t GetBufferedBytes();
+
+    // 刷新的次数，即实际发出的写请求数量
+    uint64_t GetFlushes();
+
+   private:
+    // 将缓冲区写入文件，不返回之前的错误，调用者需持有 lock_
+    google::protobuf::util::Status FlushBuffer();
+
+    // 写入 [offset, offset + nbytes)，只写入一部分时返回错误
+    google::protobuf::util::Status WriteThrough(size_t offset,
+                                                const char* data,
+                                                size_t nbytes);
+
+    // 记录错误，直到被 Flush 报告
+    google::protobuf::util::Status RecordError(
+        const google::protobuf::util::Status& status);
+
+    Options options_;
+
+    absl::Mutex lock_;
+
+    WriteFunction write_function_;
+
+    // 缓冲的数据，位于文件的 [buffer_offset_, buffer_offset_ + buffer_.size())
+    uint64_t buffer_offset_ = 0;
+
+    std::string buffer_;
+
+    // 缓冲区第一次写入的时间
+    absl::Time first_write_time_;
+
+    // 尚未通过 Flush 报告的刷新错误
+    google::protobuf::util::Status error_;
+
+    uint64_t flushes_ = 0;
+};
+
+}  // namespace client
+}  // namespace dfs
+
+#endif  // DFS_CLIENT_FILE_WRITE_BUFFER_H
@@ -0,0 +1,50 @@
+#include "src/client/hedge_budget.h"
+
+#include <algorithm>
+
+namespace dfs {
+namespace client {
+
+HedgeBudget::HedgeBudget(double ratio, double max_tokens)
+    : ratio_(std::max(ratio, 0.0)),
+      max_tokens_(std::max(max_tokens, 1.0)),
+      tokens_(max_tokens_) {}
+
+void HedgeBudget::RecordRead() {
+    absl::MutexLock lock_guard(&lock_);
+    reads_++;
+    tokens_ = std::min(max_tokens_, tokens_ + ratio_);
+}
+
+bool HedgeBudget::TryAcquire() {
+    absl::MutexLock lock_guard(&lock_);
+    if (tokens_ < 1) {
+        return false;
+    }
+    tokens_ -= 1;
+    hedges_issued_++;
+    return true;
+}
+
+void HedgeBudget::RecordWin() {
+    absl::MutexLock lock_guard(&lock_);
+    hedges_won_++;
+}
+
+uint64_t HedgeBudget::GetReads() {
+    absl::MutexLock lock_guard(&lock_);
+    return reads_;
+}
+
+uint64_t HedgeBudget::GetHedgesIssued() {
+    absl::MutexLock lock_guard(&lock_);
+    return hedges_issued_;
+}
+
+uint64_t HedgeBudget::GetHedgesWon() {
+    absl::MutexLock lock_guard(&lock_);
+    return hedges_won_;
+}
+
+}  // namespace client
+}  // namespace dfs
@@ -0,0 +1,56 @@
+#ifndef DFS_CLIENT_HEDGE_BUDGET_H
+#define DFS_CLIENT_HEDGE_BUDGET_H
+
+#include <absl/synchronization/mutex.h>
+
+#include <cstdint>
+
+namespace dfs {
+namespace client {
+
+/**
+ * 对冲读取的预算，限制对冲请求带来的额外负载
+ * 每次读取积攒 ratio 个令牌，每次对冲消耗一个令牌，令牌最多积攒 max_tokens 个，
+ * 长期来看对冲请求不超过读取次数的 ratio
+ */
+class HedgeBudget {
+   public:
+    HedgeBudget(double ratio, double max_tokens);
+
+    // 记录一次读取
+    void RecordRead();
+
+    // 申请一次对冲，预算不足时返回 false
+    bool TryAcquire();
+
+    // 对冲请求先于原请求返回
+    void RecordWin();
+
+    uint64_t GetReads();
+
+    // 发出的对冲请求数量
+    uint64_t GetHedgesIssued();
+
+    // 先于原请求返回的对冲请求数量
+    uint64_t GetHedgesWon();
+
+   private:
+    absl::Mutex lock_;
+
+    double ratio_;
+
+    double max_tokens_;
+
+    double tokens_;
+
+    uint64_t reads_ = 0;
+
+    uint64_t hedges_issued_ = 0;
+
+    uint64_t hedges_won_ = 0;
+};
+
+}  // namespace client
+}  // namespace dfs
+
+#endif  // DFS_CLIENT_HEDGE_BUDGET_H
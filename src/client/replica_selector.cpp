@@ -0,0 +1,157 @@
+#include "src/client/replica_selector.h"
+
+#include <algorithm>
+
+namespace dfs {
+namespace client {
+
+ReplicaSelector::ReplicaSelector(const Options& options, uint64_t seed)
+    : options_(options), random_engine_(seed) {
+    options_.ewma_alpha = std::clamp(options_.ewma_alpha, 0.0, 1.0);
+    options_.latency_window = std::max<size_t>(options_.latency_window, 1);
+}
+
+std::vector<std::string> ReplicaSelector::RankReplicas(
+    const std::vector<Replica>& replicas) {
+    struct RankedReplica {
+        const Replica* replica;
+        bool backoff;
+        double cost;
+    };
+
+    std::vector<RankedReplica> ranked;
+    ranked.reserve(replicas.size());
+    {
+        absl::MutexLock lock_guard(&lock_);
+        const absl::Time now = absl::Now();
+        for (const auto& replica : replicas) {
+            const auto& server = servers_[replica.server_address];
+            ranked.push_back({&replica, server.backoff_until > now,
+                              Cost(replica, server)});
+        }
+        // 先打乱再稳定排序，代价相同的副本随机排列
+        std::shuffle(ranked.begin(), ranked.end(), random_engine_);
+    }
+
+    std::stable_sort(ranked.begin(), ranked.end(),
+                     [](const RankedReplica& a, const RankedReplica& b) {
+                         if (a.backoff != b.backoff) {
+                             return !a.backoff;
+                         }
+                         return a.cost < b.cost;
+                     });
+
+    std::vector<std::string> server_addresses;
+    server_addresses.reserve(ranked.size());
+    for (const auto& item : ranked) {
+        server_addresses.push_back(item.replica->server_address);
+    }
+    return server_addresses;
+}
+
+void ReplicaSelector::BeginRequest(const std::string& server_address) {
+    absl::MutexLock lock_guard(&lock_);
+    servers_[server_address].outstanding_requests++;
+}
+
+void ReplicaSelector::EndRequest(const std::string& server_address,
+                                 const absl::Duration& latency, bool ok) {
+    absl::MutexLock lock_guard(&lock_);
+    auto& server = servers_[server_address];
+    if (server.outstanding_requests > 0) {
+        server.outstanding_requests--;
+    }
+
+    if (!ok) {
+        server.backoff_until = absl::Now() + options_.failure_backoff;
+        return;
+    }
+
+    const double latency_us = absl::ToDoubleMicroseconds(latency);
+    if (!server.has_latency) {
+        server.has_latency = true;
+        server.ewma_latency_us = latency_us;
+    } else {
+        server.ewma_latency_us = options_.ewma_alpha * latency_us +
+                                 (1 - options_.ewma_alpha) *
+                                     server.ewma_latency_us;
+    }
+    server.backoff_until = absl::InfinitePast();
+
+    if (server.latency_samples.size() < options_.latency_window) {
+        server.latency_samples.push_back(latency_us);
+    } else {
+        server.latency_samples[server.next_sample] = latency_us;
+        server.next_sample = (server.next_sample + 1) % options_.latency_window;
+    }
+}
+
+void ReplicaSelector::CancelRequest(const std::string& server_address) {
+    absl::MutexLock lock_guard(&lock_);
+    auto& server = servers_[server_address];
+    if (server.outstanding_requests > 0) {
+        server.outstanding_requests--;
+    }
+}
+
+absl::Duration ReplicaSelector::GetLatency(const std::string& server_address) {
+    absl::MutexLock lock_guard(&lock_);
+    auto iter = servers_.find(server_address);
+    if (iter == servers_.end() || !iter->second.has_latency) {
+        return options_.initial_latency;
+    }
+    return absl::Microseconds(iter->second.ewma_latency_us);
+}
+
+absl::Duration ReplicaSelector::GetLatencyPercentile(
+    const std::string& server_address, double percentile,
+    const absl::Duration& default_latency) {
+    std::vector<double> samples;
+    {
+        absl::MutexLock lock_guard(&lock_);
+        auto iter = servers_.find(server_address);
+        if (iter == servers_.end() ||
+            iter->second.latency_samples.size() <
+                std::max<size_t>(options_.min_percentile_samples, 1)) {
+            return default_latency;
+        }
+        samples = iter->second.latency_samples;
+    }
+
+    const size_t index = std::min(
+        samples.size() - 1,
+        static_cast<size_t>(std::clamp(percentile, 0.0, 1.0) * samples.size()));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return absl::Microseconds(samples[index]);
+}
+
+uint32_t ReplicaSelector::GetOutstandingRequests(
+    const std::string& server_address) {
+    absl::MutexLock lock_guard(&lock_);
+    auto iter = servers_.find(server_address);
+    return iter == servers_.end() ? 0 : iter->second.outstanding_requests;
+}
+
+double ReplicaSelector::Cost(const Replica& replica,
+                             const ServerState& server) const {
+    double latency_us = server.has_latency
+                            ? server.ewma_latency_us
+                            : absl::ToDoubleMicroseconds(
+                                  options_.initial_latency);
+
+    // 未配置标签时视为距离未知，按跨机架计算
+    const bool same_rack =
+        !options_.local_rack.empty() && replica.rack == options_.local_rack;
+    const bool same_host =
+        !options_.local_host.empty() && replica.host == options_.local_host;
+    if (!same_host) {
+        latency_us += absl::ToDoubleMicroseconds(
+            same_rack ? options_.same_rack_penalty
+                      : options_.remote_rack_penalty);
+    }
+
+    return latency_us * (server.outstanding_requests + 1);
+}
+
+}  // namespace client
+}  // namespace dfs
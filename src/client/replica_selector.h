@@ -0,0 +1,111 @@
+#ifndef DFS_CLIENT_REPLICA_SELECTOR_H
+#define DFS_CLIENT_REPLICA_SELECTOR_H
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+#include <absl/time/time.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace dfs {
+namespace client {
+
+/**
+ * 读请求的副本选择策略
+ * 1. 为每个块服务器记录读请求延迟的指数加权移动平均（EWMA）以及
+ *    正在进行的读请求数量
+ * 2. 副本的代价 = (EWMA 延迟 + 距离惩罚) * (正在进行的请求数 + 1)，
+ *    同一主机没有距离惩罚，同一机架的惩罚小于跨机架
+ * 3. 代价相同的副本随机排序，多个客户端的读请求分散到所有副本
+ * 4. 最近读取失败的块服务器在退避时间内排在最后，只在其他副本都失败时尝试
+ * 5. 保留每个块服务器最近的延迟样本，用于计算对冲读取的等待阈值
+ */
+class ReplicaSelector {
+   public:
+    struct Options {
+        // 客户端所在的主机与机架，与块服务器配置中的标签比较
+        std::string local_host;
+        std::string local_rack;
+        // EWMA 中新样本的权重
+        double ewma_alpha = 0.3;
+        // 没有延迟样本的块服务器使用的初始延迟
+        absl::Duration initial_latency = absl::Milliseconds(1);
+        // 同一机架不同主机的距离惩罚
+        absl::Duration same_rack_penalty = absl::Microseconds(200);
+        // 不同机架的距离惩罚
+        absl::Duration remote_rack_penalty = absl::Milliseconds(1);
+        // 读取失败后的退避时间
+        absl::Duration failure_backoff = absl::Seconds(5);
+        // 每个块服务器保留的延迟样本数量
+        size_t latency_window = 64;
+        // 样本少于该数量时不计算延迟分位数
+        size_t min_percentile_samples = 8;
+    };
+
+    struct Replica {
+        // "ip:port"
+        std::string server_address;
+        std::string host;
+        std::string rack;
+    };
+
+    explicit ReplicaSelector(const Options& options,
+                             uint64_t seed = std::random_device{}());
+
+    // 按代价从低到高排列副本，调用者依次尝试，失败时换下一个
+    std::vector<std::string> RankReplicas(const std::vector<Replica>& replicas);
+
+    // 开始向块服务器发送读请求
+    void BeginRequest(const std::string& server_address);
+
+    // 读请求结束，ok 为 false 时块服务器进入退避，失败的延迟不计入 EWMA
+    void EndRequest(const std::string& server_address,
+                    const absl::Duration& latency, bool ok);
+
+    // 请求被调用者主动取消，不计入延迟也不退避
+    void CancelRequest(const std::string& server_address);
+
+    // 块服务器的 EWMA 延迟，没有样本时返回初始延迟
+    absl::Duration GetLatency(const std::string& server_address);
+
+    // 块服务器最近延迟样本的 percentile 分位数（0 ~ 1），样本不足时返回
+    // default_latency
+    absl::Duration GetLatencyPercentile(const std::string& server_address,
+                                        double percentile,
+                                        const absl::Duration& default_latency);
+
+    // 块服务器正在进行的读请求数量
+    uint32_t GetOutstandingRequests(const std::string& server_address);
+
+   private:
+    struct ServerState {
+        // 是否有过延迟样本
+        bool has_latency = false;
+        double ewma_latency_us = 0;
+        uint32_t outstanding_requests = 0;
+        // 最近的延迟样本（微秒），写满后循环覆盖
+        std::vector<double> latency_samples;
+        size_t next_sample = 0;
+        // 在该时间之前处于退避状态
+        absl::Time backoff_until = absl::InfinitePast();
+    };
+
+    // 调用时需持有 lock_
+    double Cost(const Replica& replica, const ServerState& server) const;
+
+    Options options_;
+
+    absl::Mutex lock_;
+
+    // map<server_address, ServerState>
+    absl::flat_hash_map<std::string, ServerState> servers_;
+
+    std::mt19937_64 random_engine_;
+};
+
+}  // namespace client
+}  // namespace dfs
+
+#endif  // DFS_CLIENT_REPLICA_SELECTOR_H
@@ -0,0 +1,174 @@
+#include "src/common/async_log_sink.h"
+
+#include <absl/strings/str_cat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+
+namespace dfs {
+namespace common {
+
+namespace {
+
+int64_t CurrentThreadId() {
+    thread_local const int64_t thread_id = syscall(SYS_gettid);
+    return thread_id;
+}
+
+// Flush 等待的条件，写入的序号追上调用时放入的序号
+struct FlushCondition {
+    const uint64_t* written_seq;
+    uint64_t seq;
+};
+
+bool IsFlushed(FlushCondition* condition) {
+    return *condition->written_seq >= condition->seq;
+}
+
+}  // namespace
+
+AsyncLogSink::AsyncLogSink(size_t capacity, int fd)
+    : capacity_(std::max<size_t>(capacity, 1)), fd_(fd), entries_(capacity_) {
+    thread_ = std::thread([this]() { Run(); });
+}
+
+AsyncLogSink::~AsyncLogSink() { Stop(); }
+
+void AsyncLogSink::send(google::LogSeverity severity,
+                        const char* full_filename, const char* base_filename,
+                        int line, const struct ::tm* tm_time,
+                        const char* message, size_t message_len) {
+    const absl::Time now = absl::Now();
+    if (severity < google::GLOG_FATAL) {
+        absl::MutexLock lock_guard(&lock_);
+        if (!stopped_) {
+            if (size_ == capacity_) {
+                pending_dropped_++;
+                dropped_nums_++;
+                return;
+            }
+            // 复用槽位中字符串的内存，稳定后记录日志不需要分配内存
+            auto& entry = entries_[(head_ + size_) % capacity_];
+            entry.severity = severity;
+            entry.base_filename = base_filename;
+            entry.line = line;
+            entry.time = now;
+            entry.thread_id = CurrentThreadId();
+            entry.message.assign(message, message_len);
+            size_++;
+            pushed_seq_++;
+            return;
+        }
+    } else {
+        // FATAL 之后进程会退出，先写完之前的日志
+        Flush();
+    }
+
+    // 后台线程已经停止，或者是 FATAL 日志，同步写入
+    Entry entry{severity, base_filename, line, now, CurrentThreadId(),
+                std::string(message, message_len)};
+    std::string text;
+    FormatEntry(entry, &text);
+    WriteText(text);
+}
+
+void AsyncLogSink::Flush() {
+    absl::MutexLock lock_guard(&lock_);
+    FlushCondition condition{&written_seq_, pushed_seq_};
+    lock_.Await(absl::Condition(&IsFlushed, &condition));
+}
+
+void AsyncLogSink::Stop() {
+    {
+        absl::MutexLock lock_guard(&lock_);
+        stopped_ = true;
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+uint64_t AsyncLogSink::GetDroppedNums() {
+    absl::MutexLock lock_guard(&lock_);
+    return dropped_nums_;
+}
+
+void AsyncLogSink::FormatEntry(const Entry& entry, std::string* text) {
+    // 与 glog 相同：I1019 12:34:56.123456 12345 file.cpp:42] message
+    static const char kSeverityChars[] = "IWEF";
+    const auto severity = std::min<google::LogSeverity>(
+        std::max<google::LogSeverity>(entry.severity, 0), 3);
+    text->push_back(kSeverityChars[severity]);
+    absl::StrAppend(
+        text,
+        absl::FormatTime("%m%d %H:%M:%E6S", entry.time, absl::LocalTimeZone()),
+        " ", entry.thread_id, " ", entry.base_filename, ":", entry.line, "] ",
+        entry.message, "\n");
+}
+
+void AsyncLogSink::WriteText(const std::string& text) {
+    absl::MutexLock lock_guard(&write_lock_);
+    size_t written = 0;
+    while (written < text.size()) {
+        auto n = write(fd_, text.data() + written, text.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        written += n;
+    }
+}
+
+void AsyncLogSink::Run() {
+    std::vector<Entry> batch;
+    std::string text;
+    while (true) {
+        uint64_t dropped = 0;
+        uint64_t seq = 0;
+        {
+            absl::MutexLock lock_guard(&lock_);
+            lock_.Await(absl::Condition(
+                +[](AsyncLogSink* sink) {
+                    return sink->size_ > 0 || sink->stopped_;
+                },
+                this));
+            if (size_ == 0) {
+                break;
+            }
+
+            // 与批次交换字符串，双方的内存都能被复用
+            batch.resize(size_);
+            for (size_t i = 0; i < size_; i++) {
+                std::swap(batch[i], entries_[(head_ + i) % capacity_]);
+            }
+            head_ = (head_ + size_) % capacity_;
+            size_ = 0;
+            dropped = pending_dropped_;
+            pending_dropped_ = 0;
+            seq = pushed_seq_;
+        }
+
+        text.clear();
+        if (dropped > 0) {
+            Entry notice{google::GLOG_WARNING, "async_log_sink.cpp", __LINE__,
+                         absl::Now(), CurrentThreadId(),
+                         absl::StrCat(dropped, " log messages dropped, log "
+                                               "buffer is full")};
+            FormatEntry(notice, &text);
+        }
+        for (const auto& entry : batch) {
+            FormatEntry(entry, &text);
+        }
+        WriteText(text);
+
+        absl::MutexLock lock_guard(&lock_);
+        written_seq_ = seq;
+    }
+}
+
+}  // namespace common
+}  // namespace dfs
@@ -0,0 +1,96 @@
+#ifndef DFS_COMMON_ASYNC_LOG_SINK_H
+#define DFS_COMMON_ASYNC_LOG_SINK_H
+
+#include <absl/synchronization/mutex.h>
+#include <absl/time/time.h>
+#include <glog/logging.h>
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dfs {
+namespace common {
+
+/**
+ * 异步写日志的 glog LogSink
+ * 1. 记录日志的线程只把消息复制到定长的环形缓冲区，格式化与写入由后台
+ *    线程完成，一批日志只调用一次 write
+ * 2. 缓冲区满时丢弃新的日志并计数，之后输出丢弃的数量，记录日志的线程
+ *    不会因为输出慢而阻塞
+ * 3. FATAL 日志先写完缓冲区中的日志，再同步写入，进程退出前不会丢失
+ */
+class AsyncLogSink : public google::LogSink {
+   public:
+    // capacity 为缓冲区能容纳的日志条数，日志写入文件描述符 fd
+    AsyncLogSink(size_t capacity, int fd);
+
+    ~AsyncLogSink() override;
+
+    void send(google::LogSeverity severity, const char* full_filename,
+              const char* base_filename, int line, const struct ::tm* tm_time,
+              const char* message, size_t message_len) override;
+
+    // 等待调用之前记录的日志写入完成
+    void Flush();
+
+    // 写完缓冲区中的日志后停止后台线程，之后的日志同步写入
+    void Stop();
+
+    // 因缓冲区满丢弃的日志数量
+    uint64_t GetDroppedNums();
+
+   private:
+    struct Entry {
+        google::LogSeverity severity;
+        // glog 传入的文件名来自 __FILE__，一直有效
+        const char* base_filename;
+        int line;
+        absl::Time time;
+        int64_t thread_id;
+        std::string message;
+    };
+
+    // 按 glog 的格式输出一条日志
+    static void FormatEntry(const Entry& entry, std::string* text);
+
+    void WriteText(const std::string& text);
+
+    void Run();
+
+    const size_t capacity_;
+
+    const int fd_;
+
+    absl::Mutex lock_;
+
+    // 环形缓冲区，head_ 为最早的日志
+    std::vector<Entry> entries_;
+
+    size_t head_ = 0;
+
+    size_t size_ = 0;
+
+    // 已经放入与已经写入的日志序号，用于 Flush
+    uint64_t pushed_seq_ = 0;
+
+    uint64_t written_seq_ = 0;
+
+    // 上一次写入之后丢弃的日志数量
+    uint64_t pending_dropped_ = 0;
+
+    uint64_t dropped_nums_ = 0;
+
+    bool stopped_ = false;
+
+    // 保证同一时刻只有一个线程写入 fd_
+    absl::Mutex write_lock_;
+
+    std::thread thread_;
+};
+
+}  // namespace common
+}  // namespace dfs
+
+#endif  // DFS_COMMON_ASYNC_LOG_SINK_H
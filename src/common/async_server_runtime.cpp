@@ -0,0 +1,173 @@
+#include "src/common/async_server_runtime.h"
+
+#include <grpcpp/resource_quota.h>
+
+#include <algorithm>
+
+#include "src/common/config_manager.h"
+#include "src/common/system_logger.h"
+#include "src/common/utils.h"
+
+namespace dfs {
+namespace common {
+
+AsyncServerRuntime::Options AsyncServerRuntime::LoadOptions() {
+    auto config_manager = ConfigManager::GetInstance();
+    Options options;
+    options.completion_queue_nums =
+        config_manager->GetServerCompletionQueueNums();
+    options.disk_thread_nums = config_manager->GetServerDiskThreadNums();
+    options.network_thread_nums = config_manager->GetServerNetworkThreadNums();
+    options.max_queued_calls = config_manager->GetServerMaxQueuedCalls();
+    options.max_sync_threads = config_manager->GetServerMaxSyncThreads();
+    options.max_memory_mb = config_manager->GetServerMaxMemoryMB();
+    options.max_concurrent_streams =
+        config_manager->GetServerMaxConcurrentStreams();
+    return options;
+}
+
+AsyncServerRuntime::AsyncServerRuntime(const Options& options)
+    : options_(options) {
+    options_.completion_queue_nums =
+        std::max<uint32_t>(options_.completion_queue_nums, 1);
+    disk_executor_ = std::make_unique<Executor>(
+        "disk", options_.disk_thread_nums, options_.max_queued_calls);
+    network_executor_ = std::make_unique<Executor>(
+        "network", options_.network_thread_nums, options_.max_queued_calls);
+
+    auto registry = MetricsRegistry::GetInstance();
+    for (Executor* executor : {disk_executor_.get(), network_executor_.get()}) {
+        const MetricLabels labels = {{"executor", executor->name()}};
+        metric_callbacks_.push_back(registry->AddCallback(
+            "dfs_executor_queued_tasks", "Tasks waiting in the executor queue",
+            MetricType::GAUGE, labels,
+            [executor]() { return executor->GetQueueSize(); }));
+        metric_callbacks_.push_back(registry->AddCallback(
+            "dfs_executor_running_tasks", "Tasks running in the executor",
+            MetricType::GAUGE, labels,
+            [executor]() { return executor->GetRunningTasks(); }));
+    }
+}
+
+AsyncServerRuntime::~AsyncServerRuntime() {
+    for (auto id : metric_callbacks_) {
+        MetricsRegistry::GetInstance()->RemoveCallback(id);
+    }
+    Shutdown();
+}
+
+AsyncServerRuntime::RpcMetrics::RpcMetrics(const std::string& method) {
+    auto registry = MetricsRegistry::GetInstance();
+    const MetricLabels labels = {{"method", method}};
+    requests = registry->GetCounter("dfs_rpc_requests_total",
+                                    "RPC requests received", labels);
+    failures = registry->GetCounter("dfs_rpc_failures_total",
+                                    "RPC requests finished with an error",
+                                    labels);
+    rejected = registry->GetCounter(
+        "dfs_rpc_rejected_total",
+        "RPC requests rejected because the executor queue is full", labels);
+    latency = registry->GetHistogram(
+        "dfs_rpc_latency_seconds",
+        "Time from receiving an RPC request to finishing it", labels);
+}
+
+void AsyncServerRuntime::RpcMetrics::Finish(const grpc::Status& status,
+                                            uint64_t start_micros) {
+    requests->Increment();
+    if (!status.ok()) {
+        failures->Increment();
+    }
+    latency->Record(MonotonicMicros() - start_micros);
+}
+
+void AsyncServerRuntime::Configure(grpc::ServerBuilder* builder) {
+    for (uint32_t i = 0; i < options_.completion_queue_nums; i++) {
+        cqs_.push_back(builder->AddCompletionQueue());
+    }
+
+    grpc::ResourceQuota resource_quota("dfs_server");
+    if (options_.max_sync_threads > 0) {
+        resource_quota.SetMaxThreads(options_.max_sync_threads);
+    }
+    if (options_.max_memory_mb > 0) {
+        resource_quota.Resize(static_cast<size_t>(options_.max_memory_mb) *
+                              bytesMB);
+    }
+    builder->SetResourceQuota(resource_quota);
+
+    if (options_.max_concurrent_streams > 0) {
+        builder->AddChannelArgument(GRPC_ARG_MAX_CONCURRENT_STREAMS,
+                                    options_.max_concurrent_streams);
+    }
+}
+
+void AsyncServerRuntime::Start() {
+    LOG(INFO) << "async server runtime start, completion queues: "
+              << cqs_.size() << ", disk threads: "
+              << disk_executor_->thread_nums()
+              << ", network threads: " << network_executor_->thread_nums()
+              << ", registered methods: " << methods_.size();
+
+    // 每个方法在每个完成队列上都等待一个请求
+    for (auto& cq : cqs_) {
+        for (auto& method : methods_) {
+            method->CreateCall(cq.get());
+        }
+    }
+
+    for (auto& cq : cqs_) {
+        poll_threads_.emplace_back(
+            [this, cq = cq.get()]() { PollCompletionQueue(cq); });
+    }
+    started_ = true;
+}
+
+void AsyncServerRuntime::Shutdown() {
+    if (shutdown_) {
+        return;
+    }
+    shutdown_ = true;
+
+    // 线程池中的请求处理完后会向完成队列投递回复，先关闭线程池
+    disk_executor_->Shutdown();
+    network_executor_->Shutdown();
+
+    for (auto& cq : cqs_) {
+        cq->Shutdown();
+    }
+
+    if (!started_) {
+        // 没有轮询线程，直接清空完成队列
+        for (auto& cq : cqs_) {
+            PollCompletionQueue(cq.get());
+        }
+    }
+
+    for (auto& poll_thread : poll_threads_) {
+        poll_thread.join();
+    }
+}
+
+Executor* AsyncServerRuntime::GetExecutor(ExecutorType executor_type) {
+    switch (executor_type) {
+        case ExecutorType::DISK:
+            return disk_executor_.get();
+        case ExecutorType::NETWORK:
+            return network_executor_.get();
+        case ExecutorType::INLINE:
+            return nullptr;
+    }
+    return nullptr;
+}
+
+void AsyncServerRuntime::PollCompletionQueue(grpc::ServerCompletionQueue* cq) {
+    void* tag;
+    bool ok;
+    while (cq->Next(&tag, &ok)) {
+        static_cast<Call*>(tag)->Proceed(ok);
+    }
+}
+
+}  // namespace common
+}  // namespace dfs
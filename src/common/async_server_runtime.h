@@ -0,0 +1,303 @@
+#ifndef DFS_COMMON_ASYNC_SERVER_RUNTIME_H
+#define DFS_COMMON_ASYNC_SERVER_RUNTIME_H
+
+#include <grpcpp/grpcpp.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/common/executor.h"
+#include "src/common/metrics.h"
+#include "src/common/tracing.h"
+
+namespace dfs {
+namespace common {
+
+/**
+ * 基于 gRPC 异步接口的服务端运行时
+ * 1. 若干个完成队列，每个完成队列由一个线程轮询，负责接收请求与发送回复
+ * 2. 一元 RPC 按照注册时指定的类型分发：
+ *    INLINE  直接在轮询线程中处理，用于心跳、租约等不会阻塞的请求
+ *    DISK    在磁盘线程池中处理，用于读写 leveldb 的请求
+ *    NETWORK 在网络线程池中处理，用于需要访问其他服务器的请求
+ *    线程池队列已满时立即返回 RESOURCE_EXHAUSTED，慢请求不会占满所有线程
+ * 3. 未注册到运行时的方法（如流式 RPC）仍然由同步线程处理，
+ *    同步线程数量受资源配额限制
+ * 4. 每个方法记录请求数、失败数、被拒绝数以及从收到请求到处理完成的
+ *    延迟（包括在线程池中排队的时间），线程池的队列长度在导出时读取
+ * 5. 每个请求记录一个服务端 span，父 span 来自请求元数据中的 trace
+ *    context，处理方法中发起的 RPC 属于同一个 trace
+ */
+class AsyncServerRuntime {
+   public:
+    enum class ExecutorType {
+        INLINE,
+        DISK,
+        NETWORK,
+    };
+
+    struct Options {
+        // 完成队列数量，每个完成队列一个轮询线程
+        uint32_t completion_queue_nums = 2;
+        // 磁盘线程池的线程数量
+        uint32_t disk_thread_nums = 8;
+        // 网络线程池的线程数量
+        uint32_t network_thread_nums = 8;
+        // 每个线程池等待处理的请求数量上限，为 0 时不限制
+        uint32_t max_queued_calls = 1024;
+        // 资源配额：同步线程数量上限
+        uint32_t max_sync_threads = 32;
+        // 资源配额：内存上限（MB），为 0 时不限制
+        uint32_t max_memory_mb = 0;
+        // 每个连接同时进行的 RPC 数量上限，为 0 时使用 gRPC 的默认值
+        uint32_t max_concurrent_streams = 0;
+    };
+
+    // 一个 RPC 方法的指标，同名方法共用一组指标
+    struct RpcMetrics {
+        explicit RpcMetrics(const std::string& method);
+
+        // 记录一次处理完成的请求，start_micros 为收到请求的时间
+        void Finish(const grpc::Status& status, uint64_t start_micros);
+
+        Counter* requests;
+
+        Counter* failures;
+
+        // 线程池队列已满被拒绝的请求
+        Counter* rejected;
+
+        Histogram* latency;
+    };
+
+    // 生成的异步服务中 RequestXXX 方法的类型
+    template <class AsyncService, class Request, class Respond>
+    using RequestMethod = void (AsyncService::*)(
+        grpc::ServerContext*, Request*, grpc::ServerAsyncResponseWriter<Respond>*,
+        grpc::CompletionQueue*, grpc::ServerCompletionQueue*, void*);
+
+    // 同步服务中处理请求的方法类型
+    template <class Impl, class Request, class Respond>
+    using HandlerMethod = grpc::Status (Impl::*)(grpc::ServerContext*,
+                                                 const Request*, Respond*);
+
+    // 从配置文件读取运行时配置
+    static Options LoadOptions();
+
+    explicit AsyncServerRuntime(const Options& options);
+
+    ~AsyncServerRuntime();
+
+    // 在 BuildAndStart 之前调用，创建完成队列并设置资源配额
+    void Configure(grpc::ServerBuilder* builder);
+
+    // 注册一元 RPC，请求由 impl 的同步处理方法在 executor_type 对应的
+    // 线程中处理，需在 Start 之前调用。method_name 为指标中的方法名
+    template <class Service, class AsyncService, class Impl, class Request,
+              class Respond>
+    void RegisterUnaryMethod(
+        const std::string& method_name, Service* service,
+        RequestMethod<AsyncService, Request, Respond> request_method,
+        Impl* impl, HandlerMethod<Impl, Request, Respond> handler_method,
+        ExecutorType executor_type);
+
+    // 在 BuildAndStart 之后调用，开始接收请求
+    void Start();
+
+    // 在 grpc::Server::Shutdown 之后调用，处理完剩余的请求后退出
+    void Shutdown();
+
+    Executor* disk_executor() { return disk_executor_.get(); }
+
+    Executor* network_executor() { return network_executor_.get(); }
+
+   private:
+    // 完成队列中的标签
+    class Call {
+       public:
+        virtual ~Call() = default;
+
+        // 完成队列返回该标签时调用
+        virtual void Proceed(bool ok) = 0;
+    };
+
+    class MethodBase {
+       public:
+        virtual ~MethodBase() = default;
+
+        // 在完成队列上等待一个新的请求
+        virtual void CreateCall(grpc::ServerCompletionQueue* cq) = 0;
+    };
+
+    template <class Request, class Respond>
+    class UnaryMethod;
+
+    template <class Request, class Respond>
+    class UnaryCall;
+
+    Executor* GetExecutor(ExecutorType executor_type);
+
+    void PollCompletionQueue(grpc::ServerCompletionQueue* cq);
+
+    Options options_;
+
+    std::unique_ptr<Executor> disk_executor_;
+
+    std::unique_ptr<Executor> network_executor_;
+
+    std::vector<std::unique_ptr<grpc::ServerCompletionQueue>> cqs_;
+
+    std::vector<std::unique_ptr<MethodBase>> methods_;
+
+    std::vector<std::thread> poll_threads_;
+
+    // 线程池指标的回调
+    std::vector<uint64_t> metric_callbacks_;
+
+    bool started_ = false;
+
+    bool shutdown_ = false;
+};
+
+template <class Request, class Respond>
+class AsyncServerRuntime::UnaryMethod : public AsyncServerRuntime::MethodBase {
+   public:
+    using RequestFunction = std::function<void(
+        grpc::ServerContext*, Request*, grpc::ServerAsyncResponseWriter<Respond>*,
+        grpc::ServerCompletionQueue*, void*)>;
+
+    using HandlerFunction = std::function<grpc::Status(
+        grpc::ServerContext*, const Request*, Respond*)>;
+
+    UnaryMethod(const std::string& method_name,
+                RequestFunction request_function,
+                HandlerFunction handler_function, Executor* executor)
+        : request_function(std::move(request_function)),
+          handler_function(std::move(handler_function)),
+          executor(executor),
+          metrics(method_name),
+          trace_name(Tracer::GetInstance()->InternName(method_name)) {}
+
+    void CreateCall(grpc::ServerCompletionQueue* cq) override {
+        new UnaryCall<Request, Respond>(this, cq);
+    }
+
+    RequestFunction request_function;
+
+    HandlerFunction handler_function;
+
+    // 为空时在轮询线程中处理
+    Executor* executor;
+
+    RpcMetrics metrics;
+
+    const char* trace_name;
+};
+
+// 一次一元 RPC，收到请求后处理，发送回复后释放自身
+template <class Request, class Respond>
+class AsyncServerRuntime::UnaryCall : public AsyncServerRuntime::Call {
+   public:
+    UnaryCall(UnaryMethod<Request, Respond>* method,
+              grpc::ServerCompletionQueue* cq)
+        : method_(method), cq_(cq), responder_(&context_) {
+        method_->request_function(&context_, &request_, &responder_, cq_,
+                                  this);
+    }
+
+    void Proceed(bool ok) override {
+        // 回复已经发送，或者服务器正在关闭
+        if (finished_ || !ok) {
+            delete this;
+            return;
+        }
+
+        // 先在完成队列上等待下一个请求，再处理当前请求
+        method_->CreateCall(cq_);
+        finished_ = true;
+        start_micros_ = MonotonicMicros();
+
+        if (!method_->executor) {
+            Handle();
+            return;
+        }
+
+        if (!method_->executor->Submit([this]() { Handle(); })) {
+            const grpc::Status status(
+                grpc::StatusCode::RESOURCE_EXHAUSTED,
+                method_->executor->name() + " executor is busy");
+            method_->metrics.rejected->Increment();
+            method_->metrics.Finish(status, start_micros_);
+            responder_.FinishWithError(status, this);
+        }
+    }
+
+   private:
+    void Handle() {
+        grpc::Status status;
+        {
+            Span span(method_->trace_name, &context_, start_micros_);
+            if (span.sampled()) {
+                span.SetAttribute("queue_us",
+                                  MonotonicMicros() - start_micros_);
+            }
+            status =
+                method_->handler_function(&context_, &request_, &respond_);
+            span.SetStatus(status);
+        }
+        method_->metrics.Finish(status, start_micros_);
+        responder_.Finish(respond_, status, this);
+    }
+
+    UnaryMethod<Request, Respond>* method_;
+
+    grpc::ServerCompletionQueue* cq_;
+
+    grpc::ServerContext context_;
+
+    Request request_;
+
+    Respond respond_;
+
+    grpc::ServerAsyncResponseWriter<Respond> responder_;
+
+    bool finished_ = false;
+
+    // 收到请求的时间
+    uint64_t start_micros_ = 0;
+};
+
+template <class Service, class AsyncService, class Impl, class Request,
+          class Respond>
+void AsyncServerRuntime::RegisterUnaryMethod(
+    const std::string& method_name, Service* service,
+    RequestMethod<AsyncService, Request, Respond> request_method, Impl* impl,
+    HandlerMethod<Impl, Request, Respond> handler_method,
+    ExecutorType executor_type) {
+    AsyncService* async_service = service;
+    auto request_function =
+        [async_service, request_method](
+            grpc::ServerContext* context, Request* request,
+            grpc::ServerAsyncResponseWriter<Respond>* responder,
+            grpc::ServerCompletionQueue* cq, void* tag) {
+            (async_service->*request_method)(context, request, responder, cq,
+                                             cq, tag);
+        };
+    auto handler_function = [impl, handler_method](
+                                grpc::ServerContext* context,
+                                const Request* request, Respond* respond) {
+        return (impl->*handler_method)(context, request, respond);
+    };
+
+    methods_.push_back(std::make_unique<UnaryMethod<Request, Respond>>(
+        method_name, request_function, handler_function,
+        GetExecutor(executor_type)));
+}
+
+}  // namespace common
+}  // namespace dfs
+
+#endif  // DFS_COMMON_ASYNC_SERVER_RUNTIME_H
@@ -0,0 +1,261 @@
+#include "src/common/checksum.h"
+
+#include <openssl/evp.h>
+#include <xxhash.h>
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+namespace dfs {
+namespace common {
+
+namespace {
+
+// CRC32C（Castagnoli）多项式的反射形式
+const uint32_t kCrc32cPolynomial = 0x82F63B78;
+
+// 以下实现的 crc 参数与返回值都是取反后的状态，由 Crc32c 统一取反
+
+const std::array<uint32_t, 256>& Crc32cTable() {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> table;
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc >> 1) ^ ((crc & 1) ? kCrc32cPolynomial : 0);
+            }
+            table[i] = crc;
+        }
+        return table;
+    }();
+    return table;
+}
+
+uint32_t Crc32cTableUpdate(uint32_t crc, const char* data, size_t nbytes) {
+    const auto& table = Crc32cTable();
+    const auto* bytes = reinterpret_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < nbytes; i++) {
+        crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2"))) uint32_t Crc32cSse42Update(
+    uint32_t crc, const char* data, size_t nbytes) {
+    uint64_t crc64 = crc;
+    while (nbytes >= sizeof(uint64_t)) {
+        uint64_t value;
+        memcpy(&value, data, sizeof(value));
+        crc64 = _mm_crc32_u64(crc64, value);
+        data += sizeof(value);
+        nbytes -= sizeof(value);
+    }
+    crc = static_cast<uint32_t>(crc64);
+    while (nbytes > 0) {
+        crc = _mm_crc32_u8(crc, static_cast<uint8_t>(*data));
+        data++;
+        nbytes--;
+    }
+    return crc;
+}
+#elif defined(__ARM_FEATURE_CRC32)
+uint32_t Crc32cArmUpdate(uint32_t crc, const char* data, size_t nbytes) {
+    while (nbytes >= sizeof(uint64_t)) {
+        uint64_t value;
+        memcpy(&value, data, sizeof(value));
+        crc = __crc32cd(crc, value);
+        data += sizeof(value);
+        nbytes -= sizeof(value);
+    }
+    while (nbytes > 0) {
+        crc = __crc32cb(crc, static_cast<uint8_t>(*data));
+        data++;
+        nbytes--;
+    }
+    return crc;
+}
+#endif
+
+using Crc32cUpdateFunction = uint32_t (*)(uint32_t, const char*, size_t);
+
+Crc32cUpdateFunction ChooseCrc32cUpdate() {
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("sse4.2")) {
+        return Crc32cSse42Update;
+    }
+#elif defined(__ARM_FEATURE_CRC32)
+    return Crc32cArmUpdate;
+#endif
+    return Crc32cTableUpdate;
+}
+
+class Crc32cChecksum : public Checksum {
+   public:
+    Crc32cChecksum() : Checksum(ChecksumType::CRC32C) {}
+
+    void Update(const char* data, size_t nbytes) override {
+        crc_ = Crc32c(crc_, data, nbytes);
+    }
+
+   protected:
+    void AppendDigest(std::string* checksum) override {
+        // 大端序
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            checksum->push_back(static_cast<char>((crc_ >> shift) & 0xFF));
+        }
+    }
+
+   private:
+    uint32_t crc_ = 0;
+};
+
+class Xxh3Checksum : public Checksum {
+   public:
+    Xxh3Checksum() : Checksum(ChecksumType::XXH3), state_(XXH3_createState()) {
+        XXH3_128bits_reset(state_);
+    }
+
+    ~Xxh3Checksum() override { XXH3_freeState(state_); }
+
+    void Update(const char* data, size_t nbytes) override {
+        XXH3_128bits_update(state_, data, nbytes);
+    }
+
+   protected:
+    void AppendDigest(std::string* checksum) override {
+        XXH128_canonical_t canonical;
+        XXH128_canonicalFromHash(&canonical, XXH3_128bits_digest(state_));
+        checksum->append(reinterpret_cast<const char*>(canonical.digest),
+                         sizeof(canonical.digest));
+    }
+
+   private:
+    XXH3_state_t* state_;
+};
+
+class Sha256Checksum : public Checksum {
+   public:
+    Sha256Checksum()
+        : Checksum(ChecksumType::SHA256), context_(EVP_MD_CTX_new()) {
+        EVP_DigestInit_ex(context_, EVP_sha256(), nullptr);
+    }
+
+    ~Sha256Checksum() override { EVP_MD_CTX_free(context_); }
+
+    void Update(const char* data, size_t nbytes) override {
+        EVP_DigestUpdate(context_, data, nbytes);
+    }
+
+   protected:
+    void AppendDigest(std::string* checksum) override {
+        unsigned char digest[EVP_MAX_MD_SIZE];
+        unsigned int length = 0;
+        EVP_DigestFinal_ex(context_, digest, &length);
+        checksum->append(reinterpret_cast<const char*>(digest), length);
+    }
+
+   private:
+    EVP_MD_CTX* context_;
+};
+
+bool IsValidChecksumType(uint8_t type) {
+    return type >= static_cast<uint8_t>(ChecksumType::CRC32C) &&
+           type <= static_cast<uint8_t>(ChecksumType::SHA256);
+}
+
+}  // namespace
+
+ChecksumType ChecksumTypeFromName(const std::string& name,
+                                  ChecksumType default_type) {
+    if (name == "crc32c") {
+        return ChecksumType::CRC32C;
+    } else if (name == "xxh3") {
+        return ChecksumType::XXH3;
+    } else if (name == "sha256") {
+        return ChecksumType::SHA256;
+    }
+    return default_type;
+}
+
+const char* ChecksumTypeName(ChecksumType type) {
+    switch (type) {
+        case ChecksumType::CRC32C:
+            return "crc32c";
+        case ChecksumType::XXH3:
+            return "xxh3";
+        case ChecksumType::SHA256:
+            return "sha256";
+    }
+    return "unknown";
+}
+
+std::unique_ptr<Checksum> Checksum::Create(ChecksumType type) {
+    switch (type) {
+        case ChecksumType::CRC32C:
+            return std::make_unique<Crc32cChecksum>();
+        case ChecksumType::XXH3:
+            return std::make_unique<Xxh3Checksum>();
+        case ChecksumType::SHA256:
+            return std::make_unique<Sha256Checksum>();
+    }
+    return nullptr;
+}
+
+std::string Checksum::Finish() {
+    std::string checksum(1, static_cast<char>(type_));
+    AppendDigest(&checksum);
+    return checksum;
+}
+
+std::string ComputeChecksum(ChecksumType type, const char* data,
+                            size_t nbytes) {
+    // 一次性计算 XXH3 时不需要分配流式计算的状态
+    if (type == ChecksumType::XXH3) {
+        XXH128_canonical_t canonical;
+        XXH128_canonicalFromHash(&canonical, XXH3_128bits(data, nbytes));
+        std::string checksum(1, static_cast<char>(type));
+        checksum.append(reinterpret_cast<const char*>(canonical.digest),
+                        sizeof(canonical.digest));
+        return checksum;
+    }
+
+    auto checksum = Checksum::Create(type);
+    checksum->Update(data, nbytes);
+    return checksum->Finish();
+}
+
+std::string ComputeChecksum(ChecksumType type, const std::string& data) {
+    return ComputeChecksum(type, data.data(), data.size());
+}
+
+bool VerifyChecksum(const std::string& checksum, const char* data,
+                    size_t nbytes) {
+    if (checksum.empty() || !IsValidChecksumType(checksum[0])) {
+        return false;
+    }
+    const auto type = static_cast<ChecksumType>(checksum[0]);
+    return ComputeChecksum(type, data, nbytes) == checksum;
+}
+
+bool VerifyChecksum(const std::string& checksum, const std::string& data) {
+    return VerifyChecksum(checksum, data.data(), data.size());
+}
+
+uint32_t Crc32c(uint32_t crc, const char* data, size_t nbytes) {
+    static const Crc32cUpdateFunction update = ChooseCrc32cUpdate();
+    return ~update(~crc, data, nbytes);
+}
+
+uint32_t Crc32cPortable(uint32_t crc, const char* data, size_t nbytes) {
+    return ~Crc32cTableUpdate(~crc, data, nbytes);
+}
+
+}  // namespace common
+}  // namespace dfs
@@ -0,0 +1,81 @@
+#ifndef DFS_COMMON_CHECKSUM_H
+#define DFS_COMMON_CHECKSUM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace dfs {
+namespace common {
+
+// 校验和算法，数值作为校验和的第一个字节，不能修改
+enum class ChecksumType : uint8_t {
+    // 4 字节，使用 SSE4.2 / ARMv8 CRC 指令，只用于数据完整性校验
+    CRC32C = 1,
+    // 16 字节的 XXH3-128，速度接近内存带宽，碰撞概率可以忽略
+    XXH3 = 2,
+    // 32 字节，需要抵抗恶意构造的碰撞时使用
+    SHA256 = 3,
+};
+
+// 配置中的算法名字："crc32c"、"xxh3"、"sha256"，无法识别时返回 default_type
+ChecksumType ChecksumTypeFromName(const std::string& name,
+                                  ChecksumType default_type);
+
+const char* ChecksumTypeName(ChecksumType type);
+
+/**
+ * 可流式计算的校验和
+ * 1. 数据可以分多次 Update，结果与一次性计算相同，接收分帧数据时
+ *    不需要先拼接
+ * 2. Finish 返回的校验和以算法编号开头，校验方根据第一个字节选择算法，
+ *    发送方与接收方的配置不需要一致
+ * 一个对象只能被一个线程使用，Finish 之后不能再 Update
+ */
+class Checksum {
+   public:
+    static std::unique_ptr<Checksum> Create(ChecksumType type);
+
+    virtual ~Checksum() = default;
+
+    ChecksumType type() const { return type_; }
+
+    virtual void Update(const char* data, size_t nbytes) = 0;
+
+    // 返回带算法编号的校验和
+    std::string Finish();
+
+   protected:
+    explicit Checksum(ChecksumType type) : type_(type) {}
+
+    // 追加不带算法编号的摘要
+    virtual void AppendDigest(std::string* checksum) = 0;
+
+   private:
+    const ChecksumType type_;
+};
+
+// 一次性计算 data 的校验和
+std::string ComputeChecksum(ChecksumType type, const char* data,
+                            size_t nbytes);
+
+std::string ComputeChecksum(ChecksumType type, const std::string& data);
+
+// 按 checksum 的算法编号重新计算并比较，编号无法识别时返回 false
+bool VerifyChecksum(const std::string& checksum, const char* data,
+                    size_t nbytes);
+
+bool VerifyChecksum(const std::string& checksum, const std::string& data);
+
+// 在 crc（上一段数据的结果，第一段为 0）的基础上继续计算 CRC32C，
+// CPU 支持时使用硬件指令
+uint32_t Crc32c(uint32_t crc, const char* data, size_t nbytes);
+
+// 查表实现，不使用硬件指令，用于对比
+uint32_t Crc32cPortable(uint32_t crc, const char* data, size_t nbytes);
+
+}  // namespace common
+}  // namespace dfs
+
+#endif  // DFS_COMMON_CHECKSUM_H
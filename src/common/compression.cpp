@@ -0,0 +1,156 @@
+#include "src/common/compression.h"
+
+#include <lz4.h>
+#include <zstd.h>
+
+#include <memory>
+
+namespace dfs {
+namespace common {
+
+namespace {
+
+struct ZstdCCtxDeleter {
+    void operator()(ZSTD_CCtx* context) const { ZSTD_freeCCtx(context); }
+};
+
+struct ZstdDCtxDeleter {
+    void operator()(ZSTD_DCtx* context) const { ZSTD_freeDCtx(context); }
+};
+
+// 每个线程一个 zstd 上下文，避免每个分块重新分配
+ZSTD_CCtx* GetZstdCCtx() {
+    thread_local std::unique_ptr<ZSTD_CCtx, ZstdCCtxDeleter> context(
+        ZSTD_createCCtx());
+    return context.get();
+}
+
+ZSTD_DCtx* GetZstdDCtx() {
+    thread_local std::unique_ptr<ZSTD_DCtx, ZstdDCtxDeleter> context(
+        ZSTD_createDCtx());
+    return context.get();
+}
+
+// 压缩到 output 末尾预留的 capacity 字节中，返回压缩后的长度，失败时返回 0
+size_t CompressTo(CompressionCodec codec, const char* data, size_t nbytes,
+                  int level, char* output, size_t capacity) {
+    switch (codec) {
+        case CompressionCodec::LZ4: {
+            const int length = LZ4_compress_default(
+                data, output, static_cast<int>(nbytes),
+                static_cast<int>(capacity));
+            return length > 0 ? length : 0;
+        }
+        case CompressionCodec::ZSTD: {
+            const size_t length = ZSTD_compressCCtx(
+                GetZstdCCtx(), output, capacity, data, nbytes,
+                level ? level : ZSTD_CLEVEL_DEFAULT);
+            return ZSTD_isError(length) ? 0 : length;
+        }
+        case CompressionCodec::NONE:
+            break;
+    }
+    return 0;
+}
+
+size_t CompressBound(CompressionCodec codec, size_t nbytes) {
+    switch (codec) {
+        case CompressionCodec::LZ4:
+            return LZ4_compressBound(static_cast<int>(nbytes));
+        case CompressionCodec::ZSTD:
+            return ZSTD_compressBound(nbytes);
+        case CompressionCodec::NONE:
+            break;
+    }
+    return 0;
+}
+
+}  // namespace
+
+CompressionCodec CompressionCodecFromName(const std::string& name,
+                                          CompressionCodec default_codec) {
+    if (name == "none") {
+        return CompressionCodec::NONE;
+    } else if (name == "lz4") {
+        return CompressionCodec::LZ4;
+    } else if (name == "zstd") {
+        return CompressionCodec::ZSTD;
+    }
+    return default_codec;
+}
+
+const char* CompressionCodecName(CompressionCodec codec) {
+    switch (codec) {
+        case CompressionCodec::NONE:
+            return "none";
+        case CompressionCodec::LZ4:
+            return "lz4";
+        case CompressionCodec::ZSTD:
+            return "zstd";
+    }
+    return "unknown";
+}
+
+size_t CompressBlock(CompressionCodec codec, const char* data, size_t nbytes,
+                     int level, std::string* output) {
+    const size_t start = output->size();
+    const size_t capacity = CompressBound(codec, nbytes);
+    if (nbytes > 0 && capacity > 0) {
+        output->resize(start + capacity);
+        const size_t length = CompressTo(codec, data, nbytes, level,
+                                         &(*output)[start], capacity);
+        if (length > 0 && length < nbytes) {
+            output->resize(start + length);
+            return length;
+        }
+        output->resize(start);
+    }
+
+    // 不压缩或压缩后没有变短，保存原始数据
+    output->append(data, nbytes);
+    return nbytes;
+}
+
+bool DecompressBlock(CompressionCodec codec, const char* compressed,
+                     size_t compressed_length, size_t raw_length,
+                     std::string* output) {
+    if (compressed_length == raw_length) {
+        output->append(compressed, compressed_length);
+        return true;
+    }
+    if (compressed_length > raw_length) {
+        return false;
+    }
+
+    const size_t start = output->size();
+    output->resize(start + raw_length);
+    char* destination = &(*output)[start];
+    size_t length = 0;
+    switch (codec) {
+        case CompressionCodec::LZ4: {
+            const int result = LZ4_decompress_safe(
+                compressed, destination, static_cast<int>(compressed_length),
+                static_cast<int>(raw_length));
+            length = result < 0 ? 0 : result;
+            break;
+        }
+        case CompressionCodec::ZSTD: {
+            const size_t result =
+                ZSTD_decompressDCtx(GetZstdDCtx(), destination, raw_length,
+                                    compressed, compressed_length);
+            length = ZSTD_isError(result) ? 0 : result;
+            break;
+        }
+        case CompressionCodec::NONE:
+            break;
+    }
+
+    if (length != raw_length) {
+        output->resize(start);
+        return false;
+    }
+    return true;
+}
+
+}  // namespace common
+}  // namespace dfs
@@ -0,0 +1,47 @@
+#ifndef DFS_COMMON_COMPRESSION_H
+#define DFS_COMMON_COMPRESSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace dfs {
+namespace common {
+
+// 压缩算法，数值与 protos::ChunkCodec 一致，不能修改
+enum class CompressionCodec : uint8_t {
+    NONE = 0,
+    // 压缩与解压都接近内存带宽，适合读写频繁的文件
+    LZ4 = 1,
+    // 压缩率更高，适合日志等写入后很少读取的文件
+    ZSTD = 2,
+};
+
+// 配置中的算法名字："none"、"lz4"、"zstd"，无法识别时返回 default_codec
+CompressionCodec CompressionCodecFromName(const std::string& name,
+                                          CompressionCodec default_codec);
+
+const char* CompressionCodecName(CompressionCodec codec);
+
+/**
+ * 按分块独立压缩，随机读取时只需要解压读到的分块
+ * 1. 压缩后不比原始数据短的分块保存原始数据，解压时根据压缩后的长度是否
+ *    等于原始长度判断，不可压缩的数据不会变长
+ * 2. 压缩与解压使用线程局部的上下文，可以被多个线程同时调用
+ */
+
+// 压缩 nbytes 字节的 data 并追加到 output，返回追加的字节数。
+// level 只对 zstd 有效，为 0 时使用 zstd 的默认级别
+size_t CompressBlock(CompressionCodec codec, const char* data, size_t nbytes,
+                     int level, std::string* output);
+
+// 解压 CompressBlock 的结果并追加到 output，raw_length 为原始长度，
+// 数据损坏时返回 false
+bool DecompressBlock(CompressionCodec codec, const char* compressed,
+                     size_t compressed_length, size_t raw_length,
+                     std::string* output);
+
+}  // namespace common
+}  // namespace dfs
+
+#endif  // DFS_COMMON_COMPRESSION_H
@@ -32,6 +32,310 @@ uint32_t ConfigManager::GetGrpcTimeout() const {
     return root_["timeout"]["grpc"].asUInt();
 }
 
+uint32_t ConfigManager::GetLeaseTimeout() const {
+    return root_["timeout"].get("lease", 60).asUInt();
+}
+
+uint32_t ConfigManager::GetLeaseBatchChunks() const {
+    return root_["lease"].get("batch_chunks", 8).asUInt();
+}
+
+uint32_t ConfigManager::GetClientCacheTimeout() const {
+    return root_["timeout"].get("client_cache", 600).asUInt();
+}
+
+uint32_t ConfigManager::GetHeartBeatIntervalMs() const {
+    return root_["heartbeat"].get("interval_ms", 5000).asUInt();
+}
+
+uint32_t ConfigManager::GetHeartBeatJitterMs() const {
+    return root_["heartbeat"].get("jitter_ms", 1000).asUInt();
+}
+
+uint32_t ConfigManager::GetHeartBeatLeaseMs() const {
+    return root_["heartbeat"].get("lease_ms", 15000).asUInt();
+}
+
+uint32_t ConfigManager::GetHeartBeatTickMs() const {
+    return root_["heartbeat"].get("tick_ms", 500).asUInt();
+}
+
+uint32_t ConfigManager::GetHeartBeatFullReportIntervalMs() const {
+    return root_["heartbeat"].get("full_report_interval_ms", 60000).asUInt();
+}
+
+uint32_t ConfigManager::GetChunkReplicaNums() const {
+    return root_["chunk"].get("replica", 3).asUInt();
+}
+
+uint32_t ConfigManager::GetReplicationMaxConcurrentCopies() const {
+    return root_["replication"].get("max_concurrent_copies", 8).asUInt();
+}
+
+uint32_t ConfigManager::GetReplicationMaxCopiesPerSource() const {
+    return root_["replication"].get("max_copies_per_source", 2).asUInt();
+}
+
+uint32_t ConfigManager::GetReplicationMaxCopiesPerDestination() const {
+    return root_["replication"].get("max_copies_per_destination", 2).asUInt();
+}
+
+uint32_t ConfigManager::GetReplicationBandwidthMB() const {
+    return root_["replication"].get("bandwidth_mb", 100).asUInt();
+}
+
+uint32_t ConfigManager::GetReplicationScanIntervalMs() const {
+    return root_["replication"].get("scan_interval_ms", 10000).asUInt();
+}
+
+uint32_t ConfigManager::GetReplicationFrameSizeKB() const {
+    return root_["replication"].get("frame_size_kb", 1024).asUInt();
+}
+
+uint32_t ConfigManager::GetReplicationWindowFrames() const {
+    return root_["replication"].get("window_frames", 4).asUInt();
+}
+
+uint32_t ConfigManager::GetReplicationStreamRetryTimes() const {
+    return root_["replication"].get("stream_retry_times", 3).asUInt();
+}
+
+uint32_t ConfigManager::GetServerCompletionQueueNums() const {
+    return root_["server_runtime"].get("completion_queue_nums", 2).asUInt();
+}
+
+uint32_t ConfigManager::GetServerDiskThreadNums() const {
+    return root_["server_runtime"].get("disk_thread_nums", 8).asUInt();
+}
+
+uint32_t ConfigManager::GetServerNetworkThreadNums() const {
+    return root_["server_runtime"].get("network_thread_nums", 8).asUInt();
+}
+
+uint32_t ConfigManager::GetServerMaxQueuedCalls() const {
+    return root_["server_runtime"].get("max_queued_calls", 1024).asUInt();
+}
+
+uint32_t ConfigManager::GetServerMaxSyncThreads() const {
+    return root_["server_runtime"].get("max_sync_threads", 32).asUInt();
+}
+
+uint32_t ConfigManager::GetServerMaxMemoryMB() const {
+    return root_["server_runtime"].get("max_memory_mb", 0).asUInt();
+}
+
+uint32_t ConfigManager::GetServerMaxConcurrentStreams() const {
+    return root_["server_runtime"].get("max_concurrent_streams", 0).asUInt();
+}
+
+std::string ConfigManager::GetMetricsAddress() const {
+    return root_["metrics"].get("address", "127.0.0.1").asString();
+}
+
+uint32_t ConfigManager::GetMetricsPortOffset() const {
+    return root_["metrics"].get("port_offset", 1000).asUInt();
+}
+
+uint32_t ConfigManager::GetMetricsClientPort() const {
+    return root_["metrics"].get("client_port", 0).asUInt();
+}
+
+bool ConfigManager::GetLogAsync() const {
+    return root_["log"].get("async", true).asBool();
+}
+
+uint32_t ConfigManager::GetLogBufferEntries() const {
+    return root_["log"].get("buffer_entries", 65536).asUInt();
+}
+
+int ConfigManager::GetLogVerbosity() const {
+    return root_["log"].get("verbosity", 0).asInt();
+}
+
+double ConfigManager::GetTracingSampleRate() const {
+    return root_["tracing"].get("sample_rate", 0.0).asDouble();
+}
+
+uint32_t ConfigManager::GetTracingBufferSpans() const {
+    return root_["tracing"].get("buffer_spans", 16384).asUInt();
+}
+
+uint32_t ConfigManager::GetTracingFlushIntervalMs() const {
+    return root_["tracing"].get("flush_interval_ms", 1000).asUInt();
+}
+
+std::string ConfigManager::GetTracingOutputDir() const {
+    return root_["tracing"].get("output_dir", "trace").asString();
+}
+
+uint32_t ConfigManager::GetDiskIoDepth() const {
+    return root_["disk_io"].get("io_depth", 4).asUInt();
+}
+
+uint32_t ConfigManager::GetDiskIoMaxQueuedOps() const {
+    return root_["disk_io"].get("max_queued_ops", 256).asUInt();
+}
+
+uint32_t ConfigManager::GetDiskIoMaxBackgroundDepth() const {
+    return root_["disk_io"].get("max_background_depth", 1).asUInt();
+}
+
+std::string ConfigManager::GetChunkIoBackend() const {
+    return root_["chunk_io"].get("backend", "io_uring").asString();
+}
+
+uint32_t ConfigManager::GetChunkIoQueueDepth() const {
+    return root_["chunk_io"].get("queue_depth", 256).asUInt();
+}
+
+uint32_t ConfigManager::GetChunkIoThreadNums() const {
+    return root_["chunk_io"].get("thread_nums", 8).asUInt();
+}
+
+uint32_t ConfigManager::GetChunkIoBufferNums() const {
+    return root_["chunk_io"].get("buffer_nums", 16).asUInt();
+}
+
+uint32_t ConfigManager::GetChunkIoBufferKB() const {
+    return root_["chunk_io"].get("buffer_kb", 1024).asUInt();
+}
+
+bool ConfigManager::GetChunkStoreDirectIo() const {
+    return root_["chunk_store"].get("direct_io", false).asBool();
+}
+
+uint32_t ConfigManager::GetChunkStoreCacheBlockKB() const {
+    return root_["chunk_store"].get("cache_block_kb", 64).asUInt();
+}
+
+uint32_t ConfigManager::GetChunkStoreCacheMB() const {
+    return root_["chunk_store"].get("cache_mb", 256).asUInt();
+}
+
+uint32_t ConfigManager::GetChunkStoreCompressionLevel() const {
+    return root_["chunk_store"].get("compression_level", 3).asUInt();
+}
+
+uint32_t ConfigManager::GetErasureCodingDataShards() const {
+    return root_["erasure_coding"].get("data_shards", 6).asUInt();
+}
+
+uint32_t ConfigManager::GetErasureCodingParityShards() const {
+    return root_["erasure_coding"].get("parity_shards", 3).asUInt();
+}
+
+bool ConfigManager::GetErasureCodingDistinctRacks() const {
+    return root_["erasure_coding"].get("distinct_racks", false).asBool();
+}
+
+uint32_t ConfigManager::GetErasureCodingColdFileSeconds() const {
+    return root_["erasure_coding"].get("cold_file_seconds", 0).asUInt();
+}
+
+uint32_t ConfigManager::GetErasureCodingTranscodeScanIntervalMs() const {
+    return root_["erasure_coding"]
+        .get("transcode_scan_interval_ms", 60000)
+        .asUInt();
+}
+
+uint32_t ConfigManager::GetErasureCodingTranscodeMaxFilesPerScan() const {
+    return root_["erasure_coding"]
+        .get("transcode_max_files_per_scan", 4)
+        .asUInt();
+}
+
+uint32_t ConfigManager::GetErasureCodingTranscodeBandwidthMB() const {
+    return root_["erasure_coding"].get("transcode_bandwidth_mb", 50).asUInt();
+}
+
+uint32_t ConfigManager::GetErasureCodingTranscodeMaxClientIops() const {
+    return root_["erasure_coding"]
+        .get("transcode_max_client_iops", 0)
+        .asUInt();
+}
+
+std::string ConfigManager::GetClientHost() const {
+    return root_["client"].get("host", "").asString();
+}
+
+std::string ConfigManager::GetClientRack() const {
+    return root_["client"].get("rack", "").asString();
+}
+
+uint32_t ConfigManager::GetClientReadTimeoutMs() const {
+    return root_["client"].get("read_timeout_ms", 2000).asUInt();
+}
+
+uint32_t ConfigManager::GetClientReplicaBackoffMs() const {
+    return root_["client"].get("replica_backoff_ms", 5000).asUInt();
+}
+
+bool ConfigManager::GetClientHedgedRead() const {
+    return root_["client"].get("hedged_read", false).asBool();
+}
+
+uint32_t ConfigManager::GetClientHedgePercentile() const {
+    return root_["client"].get("hedge_percentile", 95).asUInt();
+}
+
+uint32_t ConfigManager::GetClientHedgeDelayMs() const {
+    return root_["client"].get("hedge_delay_ms", 10).asUInt();
+}
+
+uint32_t ConfigManager::GetClientHedgeBudgetPercent() const {
+    return root_["client"].get("hedge_budget_percent", 5).asUInt();
+}
+
+bool ConfigManager::GetClientReadahead() const {
+    return root_["client"].get("readahead", true).asBool();
+}
+
+uint32_t ConfigManager::GetClientReadaheadKB() const {
+    return root_["client"].get("readahead_kb", 128).asUInt();
+}
+
+uint32_t ConfigManager::GetClientReadaheadMaxMB() const {
+    return root_["client"].get("readahead_max_mb", 8).asUInt();
+}
+
+uint32_t ConfigManager::GetClientReadaheadThreadNums() const {
+    return root_["client"].get("readahead_thread_nums", 2).asUInt();
+}
+
+bool ConfigManager::GetClientWriteBack() const {
+    return root_["client"].get("write_back", false).asBool();
+}
+
+uint32_t ConfigManager::GetClientWriteBufferKB() const {
+    return root_["client"].get("write_buffer_kb", 4096).asUInt();
+}
+
+uint32_t ConfigManager::GetClientWriteFlushMs() const {
+    return root_["client"].get("write_flush_ms", 1000).asUInt();
+}
+
+uint32_t ConfigManager::GetClientMaxPathFiles() const {
+    return root_["client"].get("max_path_files", 16).asUInt();
+}
+
+std::string ConfigManager::GetClientId() const {
+    return root_["client"].get("id", "").asString();
+}
+
+ChecksumType ConfigManager::GetPayloadChecksumType() const {
+    const auto type = ChecksumTypeFromName(
+        root_["checksum"].get("payload", "xxh3").asString(),
+        ChecksumType::XXH3);
+    // CRC32C 只有 32 位，不能作为缓存的键
+    return type == ChecksumType::CRC32C ? ChecksumType::XXH3 : type;
+}
+
+ChecksumType ConfigManager::GetFrameChecksumType() const {
+    return ChecksumTypeFromName(
+        root_["checksum"].get("frame", "crc32c").asString(),
+        ChecksumType::CRC32C);
+}
+
 std::vector<std::pair<std::string, std::string>>
 ConfigManager::GetAllMasterServer() {
     std::vector<std::pair<std::string, std::string>> res;
@@ -90,5 +394,50 @@ uint32_t ConfigManager::GetChunkServerPort(
     return 0;
 }
 
+std::vector<std::string> ConfigManager::GetChunkServerDataDirs(
+    const std::string& server_name) const {
+    std::vector<std::string> data_dirs;
+    auto chunk_servers = root_["chunk_server"];
+    for (int i = 0; i < chunk_servers.size(); i++) {
+        if (chunk_servers[i]["name"].asString() != server_name) {
+            continue;
+        }
+
+        auto dirs = chunk_servers[i]["data_dirs"];
+        for (int j = 0; j < dirs.size(); j++) {
+            data_dirs.push_back(dirs[j].asString());
+        }
+    }
+
+    if (data_dirs.empty()) {
+        data_dirs.push_back(server_name);
+    }
+    return data_dirs;
+}
+
+std::string ConfigManager::GetChunkServerRack(
+    const std::string& server_address) const {
+    return GetChunkServerLabel(server_address, "rack");
+}
+
+std::string ConfigManager::GetChunkServerHost(
+    const std::string& server_address) const {
+    return GetChunkServerLabel(server_address, "host");
+}
+
+std::string ConfigManager::GetChunkServerLabel(
+    const std::string& server_address, const std::string& label) const {
+    auto chunk_servers = root_["chunk_server"];
+    for (int i = 0; i < chunk_servers.size(); i++) {
+        std::string address = chunk_servers[i]["address"].asString() + ":" +
+                              std::to_string(chunk_servers[i]["port"].asUInt());
+        if (address == server_address) {
+            return chunk_servers[i].get(label, "").asString();
+        }
+    }
+
+    return "";
+}
+
 }  // namespace common
-}  // namespace dfs
\ No newline at end of file
+}  // namespace dfs
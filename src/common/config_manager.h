@@ -6,6 +6,8 @@
 #include <string>
 #include <vector>
 
+#include "src/common/checksum.h"
+
 namespace dfs {
 namespace common {
 
@@ -19,16 +21,267 @@ class ConfigManager {
 
     uint32_t GetGrpcTimeout() const;
 
+    // master 分配给客户端的写租约时长（秒）
+    uint32_t GetLeaseTimeout() const;
+
+    // 申请写租约时同时申请的后续数据块数量（包含当前数据块）
+    uint32_t GetLeaseBatchChunks() const;
+
+    // 客户端缓存读元数据的时长（秒）
+    uint32_t GetClientCacheTimeout() const;
+
+    // 心跳包配置，配置文件中缺失时使用默认值
+    // 块服务器汇报（心跳）的间隔
+    uint32_t GetHeartBeatIntervalMs() const;
+
+    // 汇报间隔的随机抖动范围，避免所有块服务器在同一时刻汇报
+    uint32_t GetHeartBeatJitterMs() const;
+
+    // 块服务器的存活租约，超过该时间未汇报的块服务器会被注销
+    uint32_t GetHeartBeatLeaseMs() const;
+
+    // 主服务器检查租约过期的时间粒度
+    uint32_t GetHeartBeatTickMs() const;
+
+    // 块服务器汇报完整数据块清单的间隔，其余汇报只携带负载
+    uint32_t GetHeartBeatFullReportIntervalMs() const;
+
+    // 数据块的副本数量
+    uint32_t GetChunkReplicaNums() const;
+
+    // 副本复制配置，配置文件中缺失时使用默认值
+    // 同时进行的副本复制任务数量
+    uint32_t GetReplicationMaxConcurrentCopies() const;
+
+    // 每个源块服务器同时进行的复制任务数量
+    uint32_t GetReplicationMaxCopiesPerSource() const;
+
+    // 每个目标块服务器同时进行的复制任务数量
+    uint32_t GetReplicationMaxCopiesPerDestination() const;
+
+    // 副本复制的总带宽（MB/s），为 0 时不限速
+    uint32_t GetReplicationBandwidthMB() const;
+
+    // 扫描副本数量不足的数据块的间隔
+    uint32_t GetReplicationScanIntervalMs() const;
+
+    // 流式复制时每一帧的数据大小（KB），每一帧单独计算校验和
+    uint32_t GetReplicationFrameSizeKB() const;
+
+    // 流式复制时每个目标块服务器未确认的最大帧数
+    uint32_t GetReplicationWindowFrames() const;
+
+    // 流式复制中断后的重试次数，重试时从已确认的偏移处续传
+    uint32_t GetReplicationStreamRetryTimes() const;
+
+    // 服务端运行时配置，主服务器与块服务器共用
+    // 完成队列数量，每个完成队列一个轮询线程
+    uint32_t GetServerCompletionQueueNums() const;
+
+    // 处理磁盘读写请求的线程数量
+    uint32_t GetServerDiskThreadNums() const;
+
+    // 处理需要访问其他服务器的请求的线程数量
+    uint32_t GetServerNetworkThreadNums() const;
+
+    // 每个线程池等待处理的请求数量上限
+    uint32_t GetServerMaxQueuedCalls() const;
+
+    // 资源配额：同步线程数量上限
+    uint32_t GetServerMaxSyncThreads() const;
+
+    // 资源配额：内存上限（MB），为 0 时不限制
+    uint32_t GetServerMaxMemoryMB() const;
+
+    // 每个连接同时进行的 RPC 数量上限，为 0 时使用 gRPC 的默认值
+    uint32_t GetServerMaxConcurrentStreams() const;
+
+    // 指标导出配置，配置文件中缺失时使用默认值
+    // 指标 HTTP 服务监听的地址
+    std::string GetMetricsAddress() const;
+
+    // 服务器的指标端口为 RPC 端口加上该值，为 0 时不导出
+    uint32_t GetMetricsPortOffset() const;
+
+    // 客户端进程的指标端口，为 0 时不导出
+    uint32_t GetMetricsClientPort() const;
+
+    // 日志配置，配置文件中缺失时使用默认值
+    // 是否由后台线程异步写日志
+    bool GetLogAsync() const;
+
+    // 异步日志缓冲区能容纳的日志条数
+    uint32_t GetLogBufferEntries() const;
+
+    // DFS_VLOG 的运行时级别
+    int GetLogVerbosity() const;
+
+    // 请求追踪配置，配置文件中缺失时使用默认值
+    // 新的 trace 被采样的比例，0 为关闭，运行时可以通过指标服务修改
+    double GetTracingSampleRate() const;
+
+    // 环形缓冲区能容纳的 span 数量
+    uint32_t GetTracingBufferSpans() const;
+
+    // span 写入导出文件的间隔
+    uint32_t GetTracingFlushIntervalMs() const;
+
+    // 导出文件所在的目录，为空时不导出
+    std::string GetTracingOutputDir() const;
+
+    // 块服务器磁盘 I/O 配置，配置文件中缺失时使用默认值
+    // 每块磁盘同时进行的 I/O 数量
+    uint32_t GetDiskIoDepth() const;
+
+    // 每块磁盘等待执行的 I/O 数量上限，为 0 时不限制
+    uint32_t GetDiskIoMaxQueuedOps() const;
+
+    // 每块磁盘上复制、巡检等后台 I/O 同时进行的数量上限
+    uint32_t GetDiskIoMaxBackgroundDepth() const;
+
+    // 块服务器文件 I/O 后端配置，配置文件中缺失时使用默认值
+    // I/O 后端，"io_uring" 或 "thread_pool"，io_uring 不可用时使用线程池
+    std::string GetChunkIoBackend() const;
+
+    // 同时进行的文件 I/O 数量上限
+    uint32_t GetChunkIoQueueDepth() const;
+
+    // 线程池后端的线程数量
+    uint32_t GetChunkIoThreadNums() const;
+
+    // 注册缓冲区的数量
+    uint32_t GetChunkIoBufferNums() const;
+
+    // 每个注册缓冲区的大小（KB）
+    uint32_t GetChunkIoBufferKB() const;
+
+    // 块服务器数据块存储配置，配置文件中缺失时使用默认值
+    // 是否将数据块保存在单独的文件中，以 O_DIRECT 读写
+    bool GetChunkStoreDirectIo() const;
+
+    // 数据块读缓存中每个分块的大小（KB）
+    uint32_t GetChunkStoreCacheBlockKB() const;
+
+    // 数据块读缓存的内存上限（MB），为 0 时关闭读缓存
+    uint32_t GetChunkStoreCacheMB() const;
+
+    // 压缩数据块时 zstd 的压缩级别
+    uint32_t GetChunkStoreCompressionLevel() const;
+
+    // 纠删码配置，配置文件中缺失时使用默认值
+    // 每个条带的数据块数量
+    uint32_t GetErasureCodingDataShards() const;
+
+    // 每个条带的校验块数量，最多可以同时丢失该数量的分片
+    uint32_t GetErasureCodingParityShards() const;
+
+    // 条带的所有分片是否必须位于不同的机架，机架不足时不转换
+    bool GetErasureCodingDistinctRacks() const;
+
+    // 超过该时间（秒）没有被读写的多副本文件在后台转换为纠删码文件，
+    // 为 0 时不转换（默认）
+    uint32_t GetErasureCodingColdFileSeconds() const;
+
+    // 查找冷文件的时间间隔（ms）
+    uint32_t GetErasureCodingTranscodeScanIntervalMs() const;
+
+    // 每次最多转换的文件数量
+    uint32_t GetErasureCodingTranscodeMaxFilesPerScan() const;
+
+    // 后台转换读写数据的总带宽（MB/s），为 0 时不限速
+    uint32_t GetErasureCodingTranscodeBandwidthMB() const;
+
+    // 块服务器的客户端读写 IOPS 总和超过该值时暂停后台转换，为 0 时不检查
+    uint32_t GetErasureCodingTranscodeMaxClientIops() const;
+
+    // 客户端配置，配置文件中缺失时使用默认值
+    // 客户端所在的主机，与块服务器的 host 标签比较，读取时优先选择同一主机的副本
+    std::string GetClientHost() const;
+
+    // 客户端所在的机架，读取时其次选择同一机架的副本
+    std::string GetClientRack() const;
+
+    // 每个副本的读请求超时，超时后换下一个副本
+    uint32_t GetClientReadTimeoutMs() const;
+
+    // 读取失败的块服务器在该时间内排在其他副本之后
+    uint32_t GetClientReplicaBackoffMs() const;
+
+    // 是否默认开启对冲读取
+    bool GetClientHedgedRead() const;
+
+    // 对冲阈值使用的延迟分位数（百分比）
+    uint32_t GetClientHedgePercentile() const;
+
+    // 延迟样本不足时的对冲阈值
+    uint32_t GetClientHedgeDelayMs() const;
+
+    // 对冲请求占读请求的比例上限（百分比）
+    uint32_t GetClientHedgeBudgetPercent() const;
+
+    // 是否默认开启顺序读取的预读
+    bool GetClientReadahead() const;
+
+    // 预读的初始窗口（KB）
+    uint32_t GetClientReadaheadKB() const;
+
+    // 预读窗口的上限（MB）
+    uint32_t GetClientReadaheadMaxMB() const;
+
+    // 执行预读的线程数量
+    uint32_t GetClientReadaheadThreadNums() const;
+
+    // 是否开启写回，写入先合并到文件的写回缓冲区，默认关闭
+    bool GetClientWriteBack() const;
+
+    // 写回缓冲区的大小（KB），缓冲的数据达到该大小时刷新
+    uint32_t GetClientWriteBufferKB() const;
+
+    // 缓冲区中的数据最长等待时间，超过后由下一次写入或后台线程刷新
+    uint32_t GetClientWriteFlushMs() const;
+
+    // 按路径读写时最多保留的隐式 FileHandle 数量，超过时刷新并释放最久
+    // 未使用的一个
+    uint32_t GetClientMaxPathFiles() const;
+
+    // 客户端标识，写租约属于该标识。配置后客户端重启时新会话接管旧会话的
+    // 写租约，为空时每个进程生成一个
+    std::string GetClientId() const;
+
+    // 校验和配置，配置文件中缺失时使用默认值
+    // 客户端写入数据时的校验和算法，块服务器以校验和作为缓存数据的键，
+    // 只能是 "xxh3" 或 "sha256"，其他值使用 xxh3
+    ChecksumType GetPayloadChecksumType() const;
+
+    // 流式复制时每一帧的校验和算法
+    ChecksumType GetFrameChecksumType() const;
+
     std::vector<std::pair<std::string, std::string>> GetAllMasterServer();
 
     std::vector<std::pair<std::string, std::string>> GetAllChunkServer();
 
     std::string GetChunkServerAddress(const std::string& server_name) const;
 
+    // 故障域标签，server_address 为 "ip:port"，未配置时返回空字符串
+    // 块服务器所在的机架
+    std::string GetChunkServerRack(const std::string& server_address) const;
+
+    // 块服务器所在的物理主机
+    std::string GetChunkServerHost(const std::string& server_address) const;
+
     uint32_t GetChunkServerPort(const std::string& server_name) const;
 
+    // 块服务器的数据目录，每块磁盘一个目录，未配置时使用服务器名称
+    std::vector<std::string> GetChunkServerDataDirs(
+        const std::string& server_name) const;
+
    private:
     ConfigManager() = default;
+
+    // 获取块服务器配置中的标签
+    std::string GetChunkServerLabel(const std::string& server_address,
+                                    const std::string& label) const;
+
     Json::Value root_;
 };
 
@@ -0,0 +1,432 @@
+#include "src/common/erasure_code.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace dfs {
+namespace common {
+
+namespace {
+
+// 本原多项式 x^8 + x^4 + x^3 + x^2 + 1
+const uint32_t kGfPolynomial = 0x11D;
+
+// 每个系数展开后的乘法表大小
+const size_t kTableBytes = 32;
+
+// SIMD 实现一次计算的输出数量，累加结果保存在寄存器中
+const uint32_t kMaxOutputGroup = 4;
+
+struct GfTables {
+    // exp 表重复一遍，log(a) + log(b) 不需要取模
+    std::array<uint8_t, 512> exp;
+    std::array<uint8_t, 256> log;
+};
+
+const GfTables& GetGfTables() {
+    static const GfTables tables = [] {
+        GfTables tables;
+        uint32_t x = 1;
+        for (uint32_t i = 0; i < 255; i++) {
+            tables.exp[i] = static_cast<uint8_t>(x);
+            tables.exp[i + 255] = static_cast<uint8_t>(x);
+            tables.log[x] = static_cast<uint8_t>(i);
+            x <<= 1;
+            if (x & 0x100) {
+                x ^= kGfPolynomial;
+            }
+        }
+        tables.exp[510] = tables.exp[0];
+        tables.exp[511] = tables.exp[1];
+        tables.log[0] = 0;
+        return tables;
+    }();
+    return tables;
+}
+
+// 计算 [begin, nbytes) 范围内 first 开始的 group 个输出，用于处理 SIMD
+// 实现剩余的尾部数据
+void DotProductRange(const uint8_t* tables, uint32_t input_nums,
+                     uint32_t first, uint32_t group, const char* const* inputs,
+                     char* const* outputs, size_t begin, size_t nbytes) {
+    for (uint32_t j = first; j < first + group; j++) {
+        auto* output = reinterpret_cast<uint8_t*>(outputs[j]);
+        std::fill(output + begin, output + nbytes, 0);
+        for (uint32_t i = 0; i < input_nums; i++) {
+            const uint8_t* table = tables + (j * input_nums + i) * kTableBytes;
+            const auto* input = reinterpret_cast<const uint8_t*>(inputs[i]);
+            for (size_t pos = begin; pos < nbytes; pos++) {
+                output[pos] ^=
+                    table[input[pos] & 0x0F] ^ table[16 + (input[pos] >> 4)];
+            }
+        }
+    }
+}
+
+#if defined(__x86_64__)
+template <uint32_t kGroup>
+__attribute__((target("avx2"))) size_t DotProductAvx2Group(
+    const uint8_t* tables, uint32_t input_nums, uint32_t first,
+    const char* const* inputs, char* const* outputs, size_t nbytes) {
+    const __m256i mask = _mm256_set1_epi8(0x0F);
+    size_t pos = 0;
+    for (; pos + 32 <= nbytes; pos += 32) {
+        __m256i acc[kGroup];
+        for (uint32_t g = 0; g < kGroup; g++) {
+            acc[g] = _mm256_setzero_si256();
+        }
+        for (uint32_t i = 0; i < input_nums; i++) {
+            const __m256i x = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(inputs[i] + pos));
+            const __m256i low = _mm256_and_si256(x, mask);
+            const __m256i high =
+                _mm256_and_si256(_mm256_srli_epi64(x, 4), mask);
+            for (uint32_t g = 0; g < kGroup; g++) {
+                const uint8_t* table =
+                    tables + ((first + g) * input_nums + i) * kTableBytes;
+                const __m256i low_table =
+                    _mm256_broadcastsi128_si256(_mm_loadu_si128(
+                        reinterpret_cast<const __m128i*>(table)));
+                const __m256i high_table =
+                    _mm256_broadcastsi128_si256(_mm_loadu_si128(
+                        reinterpret_cast<const __m128i*>(table + 16)));
+                acc[g] = _mm256_xor_si256(
+                    acc[g],
+                    _mm256_xor_si256(_mm256_shuffle_epi8(low_table, low),
+                                     _mm256_shuffle_epi8(high_table, high)));
+            }
+        }
+        for (uint32_t g = 0; g < kGroup; g++) {
+            _mm256_storeu_si256(
+                reinterpret_cast<__m256i*>(outputs[first + g] + pos), acc[g]);
+        }
+    }
+    return pos;
+}
+
+template <uint32_t kGroup>
+__attribute__((target("ssse3"))) size_t DotProductSsse3Group(
+    const uint8_t* tables, uint32_t input_nums, uint32_t first,
+    const char* const* inputs, char* const* outputs, size_t nbytes) {
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    size_t pos = 0;
+    for (; pos + 16 <= nbytes; pos += 16) {
+        __m128i acc[kGroup];
+        for (uint32_t g = 0; g < kGroup; g++) {
+            acc[g] = _mm_setzero_si128();
+        }
+        for (uint32_t i = 0; i < input_nums; i++) {
+            const __m128i x = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(inputs[i] + pos));
+            const __m128i low = _mm_and_si128(x, mask);
+            const __m128i high = _mm_and_si128(_mm_srli_epi64(x, 4), mask);
+            for (uint32_t g = 0; g < kGroup; g++) {
+                const uint8_t* table =
+                    tables + ((first + g) * input_nums + i) * kTableBytes;
+                const __m128i low_table =
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(table));
+                const __m128i high_table = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(table + 16));
+                acc[g] = _mm_xor_si128(
+                    acc[g], _mm_xor_si128(_mm_shuffle_epi8(low_table, low),
+                                          _mm_shuffle_epi8(high_table, high)));
+            }
+        }
+        for (uint32_t g = 0; g < kGroup; g++) {
+            _mm_storeu_si128(
+                reinterpret_cast<__m128i*>(outputs[first + g] + pos), acc[g]);
+        }
+    }
+    return pos;
+}
+#elif defined(__aarch64__)
+template <uint32_t kGroup>
+size_t DotProductNeonGroup(const uint8_t* tables, uint32_t input_nums,
+                           uint32_t first, const char* const* inputs,
+                           char* const* outputs, size_t nbytes) {
+    const uint8x16_t mask = vdupq_n_u8(0x0F);
+    size_t pos = 0;
+    for (; pos + 16 <= nbytes; pos += 16) {
+        uint8x16_t acc[kGroup];
+        for (uint32_t g = 0; g < kGroup; g++) {
+            acc[g] = vdupq_n_u8(0);
+        }
+        for (uint32_t i = 0; i < input_nums; i++) {
+            const uint8x16_t x = vld1q_u8(
+                reinterpret_cast<const uint8_t*>(inputs[i] + pos));
+            const uint8x16_t low = vandq_u8(x, mask);
+            const uint8x16_t high = vshrq_n_u8(x, 4);
+            for (uint32_t g = 0; g < kGroup; g++) {
+                const uint8_t* table =
+                    tables + ((first + g) * input_nums + i) * kTableBytes;
+                acc[g] = veorq_u8(
+                    acc[g], veorq_u8(vqtbl1q_u8(vld1q_u8(table), low),
+                                     vqtbl1q_u8(vld1q_u8(table + 16), high)));
+            }
+        }
+        for (uint32_t g = 0; g < kGroup; g++) {
+            vst1q_u8(reinterpret_cast<uint8_t*>(outputs[first + g] + pos),
+                     acc[g]);
+        }
+    }
+    return pos;
+}
+#endif
+
+using DotProductGroupFunction = size_t (*)(const uint8_t*, uint32_t, uint32_t,
+                                           const char* const*, char* const*,
+                                           size_t);
+
+// 每次计算最多 kMaxOutputGroup 个输出，groups[n - 1] 为一次计算 n 个输出的
+// 模板实例，累加结果数组的长度在编译期确定
+void DotProductByGroups(const DotProductGroupFunction* groups,
+                        const uint8_t* tables, uint32_t input_nums,
+                        uint32_t output_nums, const char* const* inputs,
+                        char* const* outputs, size_t nbytes) {
+    for (uint32_t first = 0; first < output_nums; first += kMaxOutputGroup) {
+        const uint32_t group = std::min(kMaxOutputGroup, output_nums - first);
+        const size_t done = groups[group - 1](tables, input_nums, first,
+                                              inputs, outputs, nbytes);
+        DotProductRange(tables, input_nums, first, group, inputs, outputs,
+                        done, nbytes);
+    }
+}
+
+#if defined(__x86_64__)
+void DotProductAvx2(const uint8_t* tables, uint32_t input_nums,
+                    uint32_t output_nums, const char* const* inputs,
+                    char* const* outputs, size_t nbytes) {
+    static const DotProductGroupFunction groups[kMaxOutputGroup] = {
+        DotProductAvx2Group<1>, DotProductAvx2Group<2>,
+        DotProductAvx2Group<3>, DotProductAvx2Group<4>};
+    DotProductByGroups(groups, tables, input_nums, output_nums, inputs,
+                       outputs, nbytes);
+}
+
+void DotProductSsse3(const uint8_t* tables, uint32_t input_nums,
+                     uint32_t output_nums, const char* const* inputs,
+                     char* const* outputs, size_t nbytes) {
+    static const DotProductGroupFunction groups[kMaxOutputGroup] = {
+        DotProductSsse3Group<1>, DotProductSsse3Group<2>,
+        DotProductSsse3Group<3>, DotProductSsse3Group<4>};
+    DotProductByGroups(groups, tables, input_nums, output_nums, inputs,
+                       outputs, nbytes);
+}
+#elif defined(__aarch64__)
+void DotProductNeon(const uint8_t* tables, uint32_t input_nums,
+                    uint32_t output_nums, const char* const* inputs,
+                    char* const* outputs, size_t nbytes) {
+    static const DotProductGroupFunction groups[kMaxOutputGroup] = {
+        DotProductNeonGroup<1>, DotProductNeonGroup<2>,
+        DotProductNeonGroup<3>, DotProductNeonGroup<4>};
+    DotProductByGroups(groups, tables, input_nums, output_nums, inputs,
+                       outputs, nbytes);
+}
+#endif
+
+using DotProductFunction = void (*)(const uint8_t*, uint32_t, uint32_t,
+                                    const char* const*, char* const*, size_t);
+
+struct DotProductImpl {
+    DotProductFunction function;
+    const char* name;
+};
+
+DotProductImpl ChooseDotProduct() {
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("avx2")) {
+        return {DotProductAvx2, "avx2"};
+    }
+    if (__builtin_cpu_supports("ssse3")) {
+        return {DotProductSsse3, "ssse3"};
+    }
+#elif defined(__aarch64__)
+    return {DotProductNeon, "neon"};
+#endif
+    return {GfDotProductPortable, "portable"};
+}
+
+const DotProductImpl& GetDotProductImpl() {
+    static const DotProductImpl impl = ChooseDotProduct();
+    return impl;
+}
+
+// 求 n * n 矩阵的逆矩阵，不可逆时返回 false
+bool InvertMatrix(std::vector<uint8_t> matrix, uint32_t n,
+                  std::vector<uint8_t>* inverse) {
+    inverse->assign(n * n, 0);
+    for (uint32_t i = 0; i < n; i++) {
+        (*inverse)[i * n + i] = 1;
+    }
+
+    // Gauss-Jordan 消元
+    for (uint32_t col = 0; col < n; col++) {
+        uint32_t pivot = col;
+        while (pivot < n && matrix[pivot * n + col] == 0) {
+            pivot++;
+        }
+        if (pivot == n) {
+            return false;
+        }
+        if (pivot != col) {
+            for (uint32_t k = 0; k < n; k++) {
+                std::swap(matrix[pivot * n + k], matrix[col * n + k]);
+                std::swap((*inverse)[pivot * n + k], (*inverse)[col * n + k]);
+            }
+        }
+
+        const uint8_t scale = GfInverse(matrix[col * n + col]);
+        for (uint32_t k = 0; k < n; k++) {
+            matrix[col * n + k] = GfMul(matrix[col * n + k], scale);
+            (*inverse)[col * n + k] = GfMul((*inverse)[col * n + k], scale);
+        }
+
+        for (uint32_t row = 0; row < n; row++) {
+            const uint8_t factor = matrix[row * n + col];
+            if (row == col || factor == 0) {
+                continue;
+            }
+            for (uint32_t k = 0; k < n; k++) {
+                matrix[row * n + k] ^= GfMul(factor, matrix[col * n + k]);
+                (*inverse)[row * n + k] ^=
+                    GfMul(factor, (*inverse)[col * n + k]);
+            }
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+uint8_t GfMul(uint8_t a, uint8_t b) {
+    if (a == 0 || b == 0) {
+        return 0;
+    }
+    const auto& tables = GetGfTables();
+    return tables.exp[tables.log[a] + tables.log[b]];
+}
+
+uint8_t GfInverse(uint8_t a) {
+    if (a == 0) {
+        return 0;
+    }
+    const auto& tables = GetGfTables();
+    return tables.exp[255 - tables.log[a]];
+}
+
+std::vector<uint8_t> GfExpandTables(const std::vector<uint8_t>& matrix) {
+    std::vector<uint8_t> tables(matrix.size() * kTableBytes);
+    for (size_t i = 0; i < matrix.size(); i++) {
+        uint8_t* table = &tables[i * kTableBytes];
+        for (uint32_t x = 0; x < 16; x++) {
+            table[x] = GfMul(matrix[i], static_cast<uint8_t>(x));
+            table[16 + x] = GfMul(matrix[i], static_cast<uint8_t>(x << 4));
+        }
+    }
+    return tables;
+}
+
+void GfDotProduct(const uint8_t* tables, uint32_t input_nums,
+                  uint32_t output_nums, const char* const* inputs,
+                  char* const* outputs, size_t nbytes) {
+    GetDotProductImpl().function(tables, input_nums, output_nums, inputs,
+                                 outputs, nbytes);
+}
+
+void GfDotProductPortable(const uint8_t* tables, uint32_t input_nums,
+                          uint32_t output_nums, const char* const* inputs,
+                          char* const* outputs, size_t nbytes) {
+    DotProductRange(tables, input_nums, 0, output_nums, inputs, outputs, 0,
+                    nbytes);
+}
+
+const char* GfDotProductImplName() { return GetDotProductImpl().name; }
+
+ReedSolomon::ReedSolomon(uint32_t data_shards, uint32_t parity_shards)
+    : data_shards_(data_shards), parity_shards_(parity_shards) {
+    const uint32_t total_shards = data_shards_ + parity_shards_;
+    encoding_matrix_.assign(total_shards * data_shards_, 0);
+    for (uint32_t i = 0; i < data_shards_; i++) {
+        encoding_matrix_[i * data_shards_ + i] = 1;
+    }
+
+    // Cauchy 矩阵 1 / (x_i + y_j)，x_i = k + i，y_j = j 互不相同
+    for (uint32_t i = 0; i < parity_shards_; i++) {
+        for (uint32_t j = 0; j < data_shards_; j++) {
+            encoding_matrix_[(data_shards_ + i) * data_shards_ + j] =
+                GfInverse(static_cast<uint8_t>((data_shards_ + i) ^ j));
+        }
+    }
+
+    parity_tables_ = GfExpandTables(std::vector<uint8_t>(
+        encoding_matrix_.begin() + data_shards_ * data_shards_,
+        encoding_matrix_.end()));
+}
+
+void ReedSolomon::Encode(const char* const* data, char* const* parity,
+                         size_t nbytes) const {
+    GfDotProduct(parity_tables_.data(), data_shards_, parity_shards_, data,
+                 parity, nbytes);
+}
+
+bool ReedSolomon::Decode(const std::vector<uint32_t>& survivors,
+                         const char* const* survivor_data,
+                         const std::vector<uint32_t>& targets,
+                         char* const* outputs, size_t nbytes) const {
+    const uint32_t total_shards = data_shards_ + parity_shards_;
+    if (survivors.size() != data_shards_) {
+        return false;
+    }
+
+    std::vector<bool> used(total_shards, false);
+    for (const auto& index : survivors) {
+        if (index >= total_shards || used[index]) {
+            return false;
+        }
+        used[index] = true;
+    }
+    for (const auto& index : targets) {
+        if (index >= total_shards) {
+            return false;
+        }
+    }
+
+    // 存活分片对应的编码矩阵行组成的方阵，其逆矩阵将存活分片映射回数据分片
+    std::vector<uint8_t> survivor_matrix(data_shards_ * data_shards_);
+    for (uint32_t i = 0; i < data_shards_; i++) {
+        memcpy(&survivor_matrix[i * data_shards_], EncodingRow(survivors[i]),
+               data_shards_);
+    }
+    std::vector<uint8_t> inverse;
+    if (!InvertMatrix(std::move(survivor_matrix), data_shards_, &inverse)) {
+        return false;
+    }
+
+    // 目标分片 = 编码矩阵的对应行 * 逆矩阵 * 存活分片
+    std::vector<uint8_t> decode_matrix(targets.size() * data_shards_, 0);
+    for (size_t t = 0; t < targets.size(); t++) {
+        const uint8_t* row = EncodingRow(targets[t]);
+        for (uint32_t j = 0; j < data_shards_; j++) {
+            uint8_t value = 0;
+            for (uint32_t k = 0; k < data_shards_; k++) {
+                value ^= GfMul(row[k], inverse[k * data_shards_ + j]);
+            }
+            decode_matrix[t * data_shards_ + j] = value;
+        }
+    }
+
+    const auto tables = GfExpandTables(decode_matrix);
+    GfDotProduct(tables.data(), data_shards_, targets.size(), survivor_data,
+                 outputs, nbytes);
+    return true;
+}
+
+}  // namespace common
+}  // namespace dfs
@@ -0,0 +1,82 @@
+#ifndef DFS_COMMON_ERASURE_CODE_H
+#define DFS_COMMON_ERASURE_CODE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dfs {
+namespace common {
+
+// GF(2^8) 上的乘法与求逆，本原多项式为 x^8 + x^4 + x^3 + x^2 + 1
+uint8_t GfMul(uint8_t a, uint8_t b);
+
+uint8_t GfInverse(uint8_t a);
+
+// 将系数矩阵展开为乘法表，每个系数 32 字节：低 4 位与高 4 位各一张
+// 16 项的表，SIMD 实现用查表指令一次计算 16 或 32 个字节的乘积
+std::vector<uint8_t> GfExpandTables(const std::vector<uint8_t>& matrix);
+
+// outputs[j] = sum(matrix[j][i] * inputs[i])，矩阵为 output_nums 行
+// input_nums 列，tables 为 GfExpandTables 展开的乘法表。每个输入只读取
+// 一次，按 CPU 支持的指令选择 AVX2、SSSE3、NEON 或查表实现
+void GfDotProduct(const uint8_t* tables, uint32_t input_nums,
+                  uint32_t output_nums, const char* const* inputs,
+                  char* const* outputs, size_t nbytes);
+
+// 不使用 SIMD 指令的实现，用于测试与性能对比
+void GfDotProductPortable(const uint8_t* tables, uint32_t input_nums,
+                          uint32_t output_nums, const char* const* inputs,
+                          char* const* outputs, size_t nbytes);
+
+// 当前使用的 GfDotProduct 实现："avx2"、"ssse3"、"neon" 或 "portable"
+const char* GfDotProductImplName();
+
+/**
+ * 系统 Reed-Solomon 码 RS(k, m)
+ * 1. 前 k 个分片为原始数据，后 m 个为校验，任意 k 个分片可以恢复全部分片
+ * 2. 校验矩阵为 Cauchy 矩阵，任意 k 行组成的矩阵都可逆
+ * 3. 只做计算，不分配分片的内存，可以被多个线程同时调用
+ */
+class ReedSolomon {
+   public:
+    // data_shards 与 parity_shards 都不为 0，且总数不超过 256
+    ReedSolomon(uint32_t data_shards, uint32_t parity_shards);
+
+    uint32_t data_shards() const { return data_shards_; }
+
+    uint32_t parity_shards() const { return parity_shards_; }
+
+    // data 为 data_shards 个长度为 nbytes 的分片，计算 parity_shards 个
+    // 校验分片写入 parity
+    void Encode(const char* const* data, char* const* parity,
+                size_t nbytes) const;
+
+    // 由 data_shards 个存活分片重建 targets 中的分片。survivors 为存活分片
+    // 的编号（数据分片为 0 ~ k-1，校验分片为 k ~ k+m-1），survivor_data 为
+    // 对应的数据；重建的分片依次写入 outputs。编号无效或重复时返回 false
+    bool Decode(const std::vector<uint32_t>& survivors,
+                const char* const* survivor_data,
+                const std::vector<uint32_t>& targets, char* const* outputs,
+                size_t nbytes) const;
+
+   private:
+    // 编码矩阵第 row 行，前 k 行为单位矩阵
+    const uint8_t* EncodingRow(uint32_t row) const {
+        return &encoding_matrix_[row * data_shards_];
+    }
+
+    uint32_t data_shards_;
+    uint32_t parity_shards_;
+
+    // (k + m) * k 的编码矩阵
+    std::vector<uint8_t> encoding_matrix_;
+
+    // 校验部分的乘法表
+    std::vector<uint8_t> parity_tables_;
+};
+
+}  // namespace common
+}  // namespace dfs
+
+#endif  // DFS_COMMON_ERASURE_CODE_H
@@ -0,0 +1,83 @@
+#include "src/common/executor.h"
+
+#include <algorithm>
+
+namespace dfs {
+namespace common {
+
+Executor::Executor(const std::string& name, uint32_t thread_nums,
+                   uint32_t max_queue_size)
+    : name_(name), max_queue_size_(max_queue_size) {
+    thread_nums = std::max<uint32_t>(thread_nums, 1);
+    for (uint32_t i = 0; i < thread_nums; i++) {
+        threads_.emplace_back([this]() { RunWorker(); });
+    }
+}
+
+Executor::~Executor() { Shutdown(); }
+
+bool Executor::Submit(std::function<void()> task) {
+    absl::MutexLock lock_guard(&lock_);
+    if (shutdown_ ||
+        (max_queue_size_ > 0 && tasks_.size() >= max_queue_size_)) {
+        return false;
+    }
+
+    tasks_.push_back(std::move(task));
+    task_cond_var_.Signal();
+    return true;
+}
+
+void Executor::Shutdown() {
+    {
+        absl::MutexLock lock_guard(&lock_);
+        if (shutdown_) {
+            return;
+        }
+        shutdown_ = true;
+        task_cond_var_.SignalAll();
+    }
+
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+size_t Executor::GetQueueSize() {
+    absl::MutexLock lock_guard(&lock_);
+    return tasks_.size();
+}
+
+uint32_t Executor::GetRunningTasks() {
+    absl::MutexLock lock_guard(&lock_);
+    return running_tasks_;
+}
+
+void Executor::RunWorker() {
+    while (true) {
+        std::function<void()> task;
+        {
+            absl::MutexLock lock_guard(&lock_);
+            while (!shutdown_ && tasks_.empty()) {
+                task_cond_var_.Wait(&lock_);
+            }
+
+            // 关闭后仍然执行完剩余的任务
+            if (tasks_.empty()) {
+                return;
+            }
+
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+            running_tasks_++;
+        }
+
+        task();
+
+        absl::MutexLock lock_guard(&lock_);
+        running_tasks_--;
+    }
+}
+
+}  // namespace common
+}  // namespace dfs
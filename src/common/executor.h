@@ -0,0 +1,68 @@
+#ifndef DFS_COMMON_EXECUTOR_H
+#define DFS_COMMON_EXECUTOR_H
+
+#include <absl/synchronization/mutex.h>
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dfs {
+namespace common {
+
+/**
+ * 固定线程数的任务执行器
+ * 任务队列有长度上限，队列已满时拒绝新的任务，由调用者决定如何处理，
+ * 避免慢任务无限堆积
+ */
+class Executor {
+   public:
+    // max_queue_size 为 0 表示队列长度不受限制
+    Executor(const std::string& name, uint32_t thread_nums,
+             uint32_t max_queue_size);
+
+    ~Executor();
+
+    // 提交任务，队列已满或者执行器已经关闭时返回 false
+    bool Submit(std::function<void()> task);
+
+    // 拒绝新的任务，执行完队列中剩余的任务后退出所有线程
+    void Shutdown();
+
+    // 等待执行的任务数量
+    size_t GetQueueSize();
+
+    // 正在执行的任务数量
+    uint32_t GetRunningTasks();
+
+    const std::string& name() const { return name_; }
+
+    uint32_t thread_nums() const { return threads_.size(); }
+
+   private:
+    void RunWorker();
+
+    const std::string name_;
+
+    const uint32_t max_queue_size_;
+
+    absl::Mutex lock_;
+
+    absl::CondVar task_cond_var_;
+
+    std::deque<std::function<void()>> tasks_;
+
+    uint32_t running_tasks_ = 0;
+
+    bool shutdown_ = false;
+
+    std::vector<std::thread> threads_;
+};
+
+}  // namespace common
+}  // namespace dfs
+
+#endif  // DFS_COMMON_EXECUTOR_H
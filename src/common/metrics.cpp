@@ -0,0 +1,315 @@
+#include "src/common/metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "src/common/system_logger.h"
+
+namespace dfs {
+namespace common {
+
+namespace {
+
+std::atomic<size_t> next_thread_shard(0);
+
+// Prometheus 标签值需要转义反斜杠、双引号与换行
+std::string EscapeLabelValue(const std::string& value) {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            escaped.push_back('\\');
+            escaped.push_back(c);
+        } else if (c == '\n') {
+            escaped.append("\\n");
+        } else {
+            escaped.push_back(c);
+        }
+    }
+    return escaped;
+}
+
+const char* TypeName(MetricType type) {
+    switch (type) {
+        case MetricType::COUNTER:
+            return "counter";
+        case MetricType::GAUGE:
+            return "gauge";
+        case MetricType::HISTOGRAM:
+            return "histogram";
+    }
+    return "untyped";
+}
+
+// 整数不带小数点输出，其他值保留足够的精度
+std::string FormatValue(double value) {
+    if (std::isinf(value)) {
+        return value > 0 ? "+Inf" : "-Inf";
+    }
+    char buffer[64];
+    if (value == std::floor(value) && std::fabs(value) < 1e15) {
+        snprintf(buffer, sizeof(buffer), "%.0f", value);
+    } else {
+        snprintf(buffer, sizeof(buffer), "%.9g", value);
+    }
+    return buffer;
+}
+
+void AppendSample(const std::string& name, const std::string& labels,
+                  const std::string& value, std::string* text) {
+    text->append(name);
+    if (!labels.empty()) {
+        text->append("{").append(labels).append("}");
+    }
+    text->append(" ").append(value).append("\n");
+}
+
+}  // namespace
+
+size_t MetricsThreadShard() {
+    thread_local const size_t shard =
+        next_thread_shard.fetch_add(1, std::memory_order_relaxed);
+    return shard;
+}
+
+uint64_t Counter::Value() const {
+    uint64_t value = 0;
+    for (const auto& shard : shards_) {
+        value += shard.value.load(std::memory_order_relaxed);
+    }
+    return value;
+}
+
+Histogram::Histogram() : shards_(new Shard[kShards]) {}
+
+uint64_t Histogram::BucketUpperBound(size_t index) {
+    if (index < (size_t(1) << kSubBucketBits)) {
+        return index;
+    }
+    const uint32_t shift = (index >> kSubBucketBits) - 1;
+    const uint64_t sub_bucket = index & ((size_t(1) << kSubBucketBits) - 1);
+    const uint64_t lower = ((uint64_t(1) << kSubBucketBits) + sub_bucket)
+                           << shift;
+    return lower + (uint64_t(1) << shift) - 1;
+}
+
+std::vector<uint64_t> Histogram::Snapshot() const {
+    std::vector<uint64_t> buckets(kBucketNums, 0);
+    for (size_t i = 0; i < kShards; i++) {
+        for (size_t j = 0; j < kBucketNums; j++) {
+            buckets[j] += shards_[i].buckets[j].load(std::memory_order_relaxed);
+        }
+    }
+    return buckets;
+}
+
+uint64_t Histogram::Count() const {
+    uint64_t count = 0;
+    for (auto bucket : Snapshot()) {
+        count += bucket;
+    }
+    return count;
+}
+
+uint64_t Histogram::Sum() const {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < kShards; i++) {
+        sum += shards_[i].sum.load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+uint64_t Histogram::Percentile(double quantile) const {
+    const auto buckets = Snapshot();
+    uint64_t count = 0;
+    for (auto bucket : buckets) {
+        count += bucket;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    // 第 rank 个样本所在的桶，rank 从 1 开始
+    const uint64_t rank = std::max<uint64_t>(
+        1, static_cast<uint64_t>(std::ceil(quantile * count)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketNums; i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return BucketUpperBound(i);
+        }
+    }
+    return BucketUpperBound(kBucketNums - 1);
+}
+
+MetricsRegistry* MetricsRegistry::GetInstance() {
+    static MetricsRegistry* instance = new MetricsRegistry();
+    return instance;
+}
+
+std::string MetricsRegistry::FormatLabels(const MetricLabels& labels) {
+    std::string text;
+    for (const auto& label : labels) {
+        if (!text.empty()) {
+            text.push_back(',');
+        }
+        text.append(label.first)
+            .append("=\"")
+            .append(EscapeLabelValue(label.second))
+            .append("\"");
+    }
+    return text;
+}
+
+MetricsRegistry::Series* MetricsRegistry::GetSeries(
+    const std::string& name, const std::string& help, MetricType type,
+    const MetricLabels& labels) {
+    auto iter = families_.find(name);
+    if (iter == families_.end()) {
+        iter = families_.emplace(name, Family{help, type, {}}).first;
+    } else if (iter->second.type != type) {
+        LOG(FATAL) << "metric " << name << " is already registered as "
+                   << TypeName(iter->second.type);
+    }
+    return &iter->second.series[FormatLabels(labels)];
+}
+
+Counter* MetricsRegistry::GetCounter(const std::string& name,
+                                     const std::string& help,
+                                     const MetricLabels& labels) {
+    absl::MutexLock lock_guard(&lock_);
+    auto series = GetSeries(name, help, MetricType::COUNTER, labels);
+    if (!series->counter) {
+        series->counter = std::make_unique<Counter>();
+    }
+    return series->counter.get();
+}
+
+Gauge* MetricsRegistry::GetGauge(const std::string& name,
+                                 const std::string& help,
+                                 const MetricLabels& labels) {
+    absl::MutexLock lock_guard(&lock_);
+    auto series = GetSeries(name, help, MetricType::GAUGE, labels);
+    if (!series->gauge) {
+        series->gauge = std::make_unique<Gauge>();
+    }
+    return series->gauge.get();
+}
+
+Histogram* MetricsRegistry::GetHistogram(const std::string& name,
+                                         const std::string& help,
+                                         const MetricLabels& labels) {
+    absl::MutexLock lock_guard(&lock_);
+    auto series = GetSeries(name, help, MetricType::HISTOGRAM, labels);
+    if (!series->histogram) {
+        series->histogram = std::make_unique<Histogram>();
+    }
+    return series->histogram.get();
+}
+
+uint64_t MetricsRegistry::AddCallback(const std::string& name,
+                                      const std::string& help,
+                                      MetricType type,
+                                      const MetricLabels& labels,
+                                      std::function<double()> callback) {
+    absl::MutexLock lock_guard(&lock_);
+    auto series = GetSeries(name, help, type, labels);
+    series->callback = std::move(callback);
+    const uint64_t id = next_callback_id_++;
+    series->callback_id = id;
+    callbacks_[id] = {name, FormatLabels(labels)};
+    return id;
+}
+
+void MetricsRegistry::RemoveCallback(uint64_t id) {
+    absl::MutexLock lock_guard(&lock_);
+    auto iter = callbacks_.find(id);
+    if (iter == callbacks_.end()) {
+        return;
+    }
+    auto family_iter = families_.find(iter->second.first);
+    if (family_iter != families_.end()) {
+        auto& series = family_iter->second.series;
+        auto series_iter = series.find(iter->second.second);
+        // 已经被之后注册的回调替换时保留
+        if (series_iter != series.end() &&
+            series_iter->second.callback_id == id) {
+            series.erase(series_iter);
+        }
+        if (series.empty()) {
+            families_.erase(family_iter);
+        }
+    }
+    callbacks_.erase(iter);
+}
+
+void MetricsRegistry::ExportHistogram(const std::string& name,
+                                      const std::string& labels,
+                                      const Histogram& histogram,
+                                      std::string* text) {
+    const auto buckets = histogram.Snapshot();
+    const std::string prefix = labels.empty() ? "" : labels + ",";
+
+    // 第 k 个边界统计小于 2^k 微秒的样本，即桶上界小于 2^k 的所有桶
+    uint64_t cumulative = 0;
+    size_t bucket_index = 0;
+    for (uint32_t k = 0; k < kExportedBuckets; k++) {
+        const uint64_t bound = uint64_t(1) << k;
+        while (bucket_index < buckets.size() &&
+               Histogram::BucketUpperBound(bucket_index) < bound) {
+            cumulative += buckets[bucket_index++];
+        }
+        AppendSample(name + "_bucket",
+                     prefix + "le=\"" + FormatValue(bound / 1e6) + "\"",
+                     FormatValue(cumulative), text);
+    }
+    while (bucket_index < buckets.size()) {
+        cumulative += buckets[bucket_index++];
+    }
+    AppendSample(name + "_bucket", prefix + "le=\"+Inf\"",
+                 FormatValue(cumulative), text);
+    AppendSample(name + "_sum", labels, FormatValue(histogram.Sum() / 1e6),
+                 text);
+    AppendSample(name + "_count", labels, FormatValue(cumulative), text);
+}
+
+std::string MetricsRegistry::ExportText() {
+    std::string text;
+    absl::MutexLock lock_guard(&lock_);
+    for (const auto& family_pair : families_) {
+        const auto& name = family_pair.first;
+        const auto& family = family_pair.second;
+        text.append("# HELP ")
+            .append(name)
+            .append(" ")
+            .append(family.help)
+            .append("\n");
+        text.append("# TYPE ")
+            .append(name)
+            .append(" ")
+            .append(TypeName(family.type))
+            .append("\n");
+
+        for (const auto& series_pair : family.series) {
+            const auto& labels = series_pair.first;
+            const auto& series = series_pair.second;
+            if (series.callback) {
+                AppendSample(name, labels, FormatValue(series.callback()),
+                             &text);
+            } else if (series.counter) {
+                AppendSample(name, labels,
+                             FormatValue(series.counter->Value()), &text);
+            } else if (series.gauge) {
+                AppendSample(name, labels, FormatValue(series.gauge->Value()),
+                             &text);
+            } else if (series.histogram) {
+                ExportHistogram(name, labels, *series.histogram, &text);
+            }
+        }
+    }
+    return text;
+}
+
+}  // namespace common
+}  // namespace dfs
@@ -0,0 +1,242 @@
+#ifndef DFS_COMMON_METRICS_H
+#define DFS_COMMON_METRICS_H
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dfs {
+namespace common {
+
+// 指标的标签，<name, value>
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+enum class MetricType {
+    COUNTER,
+    GAUGE,
+    HISTOGRAM,
+};
+
+// 当前线程使用的分片，线程第一次调用时按顺序分配
+size_t MetricsThreadShard();
+
+// 单调时钟，单位微秒
+inline uint64_t MonotonicMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/**
+ * 计数器，只增不减
+ * 每个线程固定写一个分片，分片按缓存行对齐，记录只需要一次 relaxed
+ * 原子加，读取时累加所有分片
+ */
+class Counter {
+   public:
+    static constexpr size_t kShards = 16;
+
+    void Increment(uint64_t delta = 1) {
+        shards_[MetricsThreadShard() % kShards].value.fetch_add(
+            delta, std::memory_order_relaxed);
+    }
+
+    uint64_t Value() const;
+
+   private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+
+    std::array<Shard, kShards> shards_;
+};
+
+// 可增可减的瞬时值，例如正在处理的请求数量
+class Gauge {
+   public:
+    void Set(int64_t value) { value_.store(value, std::memory_order_relaxed); }
+
+    void Add(int64_t delta) {
+        value_.fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    int64_t Value() const { return value_.load(std::memory_order_relaxed); }
+
+   private:
+    std::atomic<int64_t> value_{0};
+};
+
+/**
+ * 延迟直方图，单位微秒，HDR 风格的对数线性分桶
+ * 1. 小于 2^kSubBucketBits 的值每个值一个桶，之后每个 2 的幂区间再均分为
+ *    2^kSubBucketBits 个桶，相对误差不超过 1/2^kSubBucketBits
+ * 2. 不小于 2^kMaxValueBits 的值记录在最后一个桶
+ * 3. 与 Counter 相同，每个线程固定写一个分片，记录一次只需要两次
+ *    relaxed 原子加，不需要加锁
+ */
+class Histogram {
+   public:
+    static constexpr uint32_t kSubBucketBits = 4;
+
+    static constexpr uint32_t kMaxValueBits = 36;
+
+    static constexpr size_t kBucketNums = (kMaxValueBits - kSubBucketBits + 1)
+                                          << kSubBucketBits;
+
+    static constexpr size_t kShards = 8;
+
+    Histogram();
+
+    void Record(uint64_t value) {
+        auto& shard = shards_[MetricsThreadShard() % kShards];
+        shard.buckets[BucketIndex(value)].fetch_add(1,
+                                                    std::memory_order_relaxed);
+        shard.sum.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    static size_t BucketIndex(uint64_t value) {
+        if (value < (uint64_t(1) << kSubBucketBits)) {
+            return value;
+        }
+        if (value >= (uint64_t(1) << kMaxValueBits)) {
+            return kBucketNums - 1;
+        }
+        const uint32_t exponent = 63 - __builtin_clzll(value);
+        const uint32_t shift = exponent - kSubBucketBits;
+        return ((shift + 1) << kSubBucketBits) +
+               (value >> shift) - (uint64_t(1) << kSubBucketBits);
+    }
+
+    // 桶中的最大值
+    static uint64_t BucketUpperBound(size_t index);
+
+    // 合并所有分片后每个桶的样本数
+    std::vector<uint64_t> Snapshot() const;
+
+    uint64_t Count() const;
+
+    uint64_t Sum() const;
+
+    // 分位数 quantile（0 到 1）所在桶的最大值，没有样本时返回 0
+    uint64_t Percentile(double quantile) const;
+
+   private:
+    struct alignas(64) Shard {
+        std::array<std::atomic<uint64_t>, kBucketNums> buckets{};
+        std::atomic<uint64_t> sum{0};
+    };
+
+    std::unique_ptr<Shard[]> shards_;
+};
+
+// 作用域结束时记录经过的时间，histogram 为 nullptr 时不记录
+class ScopedLatency {
+   public:
+    explicit ScopedLatency(Histogram* histogram)
+        : histogram_(histogram), start_micros_(MonotonicMicros()) {}
+
+    ~ScopedLatency() {
+        if (histogram_) {
+            histogram_->Record(MonotonicMicros() - start_micros_);
+        }
+    }
+
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+   private:
+    Histogram* histogram_;
+
+    uint64_t start_micros_;
+};
+
+/**
+ * 进程内的指标注册表
+ * 1. 同名同标签的指标只创建一次，返回的指针在进程内一直有效，调用者
+ *    在初始化时获取并保存，记录时不需要查找注册表
+ * 2. 已有的统计（例如缓存命中次数）以回调的方式注册，导出时读取，
+ *    对象析构前需要 RemoveCallback
+ * 3. 以 Prometheus 文本格式导出，直方图导出为秒，le 为 2 的幂微秒
+ */
+class MetricsRegistry {
+   public:
+    static MetricsRegistry* GetInstance();
+
+    Counter* GetCounter(const std::string& name, const std::string& help,
+                        const MetricLabels& labels = {});
+
+    Gauge* GetGauge(const std::string& name, const std::string& help,
+                    const MetricLabels& labels = {});
+
+    // 名字以 _seconds 结尾，记录的值为微秒
+    Histogram* GetHistogram(const std::string& name, const std::string& help,
+                            const MetricLabels& labels = {});
+
+    // 导出时调用 callback 获取值，type 只能是 COUNTER 或 GAUGE，
+    // 同名同标签时替换之前的回调。返回的 id 用于 RemoveCallback
+    uint64_t AddCallback(const std::string& name, const std::string& help,
+                         MetricType type, const MetricLabels& labels,
+                         std::function<double()> callback);
+
+    // 返回后 callback 不会再被调用
+    void RemoveCallback(uint64_t id);
+
+    // Prometheus 文本格式
+    std::string ExportText();
+
+    // 直方图导出的桶边界数量，最后一个边界为 2^(kExportedBuckets - 1) 微秒
+    static constexpr uint32_t kExportedBuckets = 27;
+
+   private:
+    struct Series {
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+        std::function<double()> callback;
+        // 同名同标签的回调以最后注册的为准
+        uint64_t callback_id = 0;
+    };
+
+    struct Family {
+        std::string help;
+        MetricType type;
+        // <标签文本, 指标>，标签文本如 method="ReadFileChunk"
+        std::map<std::string, Series> series;
+    };
+
+    MetricsRegistry() = default;
+
+    // 获取或创建指标，调用者需持有 lock_
+    Series* GetSeries(const std::string& name, const std::string& help,
+                      MetricType type, const MetricLabels& labels);
+
+    static std::string FormatLabels(const MetricLabels& labels);
+
+    void ExportHistogram(const std::string& name, const std::string& labels,
+                         const Histogram& histogram, std::string* text);
+
+    absl::Mutex lock_;
+
+    std::map<std::string, Family> families_;
+
+    // <callback id, <name, 标签文本>>
+    absl::flat_hash_map<uint64_t, std::pair<std::string, std::string>>
+        callbacks_;
+
+    uint64_t next_callback_id_ = 1;
+};
+
+}  // namespace common
+}  // namespace dfs
+
+#endif  // DFS_COMMON_METRICS_H
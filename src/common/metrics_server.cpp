@@ -0,0 +1,193 @@
+#include "src/common/metrics_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <absl/strings/numbers.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "src/common/system_logger.h"
+#include "src/common/tracing.h"
+
+namespace dfs {
+namespace common {
+
+namespace {
+
+// 等待连接时的轮询间隔，Stop 最多等待这么久
+const int kPollIntervalMs = 100;
+
+// 读取请求的超时
+const int kRecvTimeoutMs = 1000;
+
+// 请求头的长度上限
+const size_t kMaxRequestBytes = 8192;
+
+void SendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        auto n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        sent += n;
+    }
+}
+
+std::string MakeResponse(const std::string& status,
+                         const std::string& content_type,
+                         const std::string& body) {
+    return "HTTP/1.1 " + status + "\r\nContent-Type: " + content_type +
+           "\r\nContent-Length: " + std::to_string(body.size()) +
+           "\r\nConnection: close\r\n\r\n" + body;
+}
+
+// 查询参数为 sample_rate=<0 到 1 之间的小数> 时修改采样率，
+// 返回当前的采样率
+std::string HandleTracing(const std::string& query) {
+    const std::string key = "sample_rate=";
+    if (query.rfind(key, 0) == 0) {
+        double sample_rate;
+        if (!absl::SimpleAtod(query.substr(key.size()), &sample_rate) ||
+            sample_rate < 0 || sample_rate > 1) {
+            return MakeResponse("400 Bad Request", "text/plain",
+                                "sample_rate should be in [0, 1]\n");
+        }
+        Tracer::GetInstance()->SetSampleRate(sample_rate);
+        LOG(INFO) << "trace sample rate is set to " << sample_rate;
+    }
+    return MakeResponse(
+        "200 OK", "text/plain",
+        "sample_rate " +
+            std::to_string(Tracer::GetInstance()->GetSampleRate()) + "\n");
+}
+
+}  // namespace
+
+MetricsServer::MetricsServer(MetricsRegistry* registry) : registry_(registry) {}
+
+MetricsServer::~MetricsServer() { Stop(); }
+
+bool MetricsServer::Start(const std::string& address, uint16_t port) {
+    if (listen_fd_ >= 0) {
+        return false;
+    }
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+        LOG(ERROR) << "metrics server: invalid address " << address;
+        return false;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        LOG(ERROR) << "metrics server: socket failed, " << strerror(errno);
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        listen(fd, 16) < 0) {
+        LOG(ERROR) << "metrics server: can not listen on " << address << ":"
+                   << port << ", " << strerror(errno);
+        close(fd);
+        return false;
+    }
+
+    socklen_t addr_len = sizeof(addr);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &addr_len);
+    listen_fd_ = fd;
+    port_ = ntohs(addr.sin_port);
+    stopped_ = false;
+    thread_ = std::thread([this]() { Serve(); });
+    LOG(INFO) << "metrics server listening on " << address << ":" << port_;
+    return true;
+}
+
+void MetricsServer::Stop() {
+    if (listen_fd_ < 0) {
+        return;
+    }
+    stopped_ = true;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    close(listen_fd_);
+    listen_fd_ = -1;
+    port_ = 0;
+}
+
+void MetricsServer::Serve() {
+    pollfd poll_fd;
+    poll_fd.fd = listen_fd_;
+    poll_fd.events = POLLIN;
+    while (!stopped_) {
+        if (poll(&poll_fd, 1, kPollIntervalMs) <= 0) {
+            continue;
+        }
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        HandleConnection(fd);
+        close(fd);
+    }
+}
+
+void MetricsServer::HandleConnection(int fd) {
+    timeval timeout;
+    timeout.tv_sec = kRecvTimeoutMs / 1000;
+    timeout.tv_usec = (kRecvTimeoutMs % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    // 只需要请求行，读到请求头结束为止
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos &&
+           request.size() < kMaxRequestBytes) {
+        auto n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        request.append(buffer, n);
+    }
+
+    // 请求行为 "GET /metrics?xxx HTTP/1.1"
+    const std::string request_line = request.substr(0, request.find("\r\n"));
+    std::string path;
+    std::string query;
+    if (request_line.rfind("GET ", 0) == 0) {
+        path = request_line.substr(4, request_line.find(' ', 4) - 4);
+        const auto query_pos = path.find('?');
+        if (query_pos != std::string::npos) {
+            query = path.substr(query_pos + 1);
+            path = path.substr(0, query_pos);
+        }
+    }
+    if (path == "/metrics") {
+        SendAll(fd, MakeResponse("200 OK", "text/plain; version=0.0.4",
+                                 registry_->ExportText()));
+    } else if (path == "/tracing") {
+        SendAll(fd, HandleTracing(query));
+    } else {
+        SendAll(fd, MakeResponse("404 Not Found", "text/plain", "not found\n"));
+    }
+}
+
+}  // namespace common
+}  // namespace dfs
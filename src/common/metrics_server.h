@@ -0,0 +1,56 @@
+#ifndef DFS_COMMON_METRICS_SERVER_H
+#define DFS_COMMON_METRICS_SERVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "src/common/metrics.h"
+
+namespace dfs {
+namespace common {
+
+/**
+ * 以 Prometheus 文本格式导出指标的 HTTP 服务
+ * 1. GET /metrics 导出指标；GET /tracing 返回请求追踪的采样率，
+ *    GET /tracing?sample_rate=0.01 在运行时修改采样率；其他请求返回 404
+ * 2. 一个后台线程依次处理连接，每次回复后关闭连接，
+ *    抓取的频率很低，不需要并发处理
+ */
+class MetricsServer {
+   public:
+    explicit MetricsServer(MetricsRegistry* registry);
+
+    ~MetricsServer();
+
+    // 监听 address:port，port 为 0 时由系统分配。失败时返回 false
+    bool Start(const std::string& address, uint16_t port);
+
+    // 停止监听并等待后台线程退出
+    void Stop();
+
+    // 实际监听的端口，未启动时为 0
+    uint16_t port() const { return port_; }
+
+   private:
+    void Serve();
+
+    // 读取一个请求并回复
+    void HandleConnection(int fd);
+
+    MetricsRegistry* registry_;
+
+    int listen_fd_ = -1;
+
+    uint16_t port_ = 0;
+
+    std::atomic<bool> stopped_{false};
+
+    std::thread thread_;
+};
+
+}  // namespace common
+}  // namespace dfs
+
+#endif  // DFS_COMMON_METRICS_SERVER_H
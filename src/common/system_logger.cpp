@@ -1,8 +1,55 @@
 #include "src/common/system_logger.h"
 
+#include <absl/strings/str_cat.h>
+#include <absl/time/clock.h>
+#include <unistd.h>
+
+#include "src/common/async_log_sink.h"
+#include "src/common/config_manager.h"
+
 namespace dfs {
 namespace common {
 
+LogRateLimiter::LogRateLimiter(uint32_t max_per_second)
+    : max_per_second_(max_per_second) {}
+
+bool LogRateLimiter::Allow() {
+    const int64_t now = absl::GetCurrentTimeNanos() / 1000000000;
+    int64_t window = window_.load(std::memory_order_relaxed);
+    if (window != now &&
+        window_.compare_exchange_strong(window, now,
+                                        std::memory_order_relaxed)) {
+        count_.store(0, std::memory_order_relaxed);
+    }
+    if (count_.fetch_add(1, std::memory_order_relaxed) < max_per_second_) {
+        return true;
+    }
+    suppressed_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+std::string LogRateLimiter::TakeSuppressed() {
+    const uint64_t suppressed =
+        suppressed_.exchange(0, std::memory_order_relaxed);
+    if (suppressed == 0) {
+        return "";
+    }
+    return absl::StrCat("(", suppressed, " similar messages suppressed) ");
+}
+
+SystemLogger::SystemLogger() : is_initialized_(false) {}
+
+SystemLogger::~SystemLogger() { Shutdown(); }
+
+SystemLogger::Options SystemLogger::LoadOptions() {
+    auto config_manager = ConfigManager::GetInstance();
+    Options options;
+    options.async = config_manager->GetLogAsync();
+    options.buffer_entries = config_manager->GetLogBufferEntries();
+    options.verbosity = config_manager->GetLogVerbosity();
+    return options;
+}
+
 void SystemLogger::Initialize(const std::string& program_name) {
     if (this->is_initialized_) {
         return;
@@ -17,5 +64,39 @@ void SystemLogger::Initialize(const std::string& program_name) {
     this->is_initialized_ = true;
 }
 
+void SystemLogger::Configure(const Options& options) {
+    Shutdown();
+    FLAGS_v = options.verbosity;
+    if (!options.async) {
+        return;
+    }
+
+    // glog 不再写标准错误与日志文件，所有日志经过异步 sink 输出
+    async_sink_ = std::make_unique<AsyncLogSink>(options.buffer_entries,
+                                                 STDERR_FILENO);
+    for (int severity = 0; severity < google::NUM_SEVERITIES; severity++) {
+        google::SetLogDestination(severity, "");
+    }
+    FLAGS_stderrthreshold = google::NUM_SEVERITIES;
+    FLAGS_logtostderr = false;
+    google::AddLogSink(async_sink_.get());
+}
+
+void SystemLogger::Flush() {
+    if (async_sink_) {
+        async_sink_->Flush();
+    }
+}
+
+void SystemLogger::Shutdown() {
+    if (!async_sink_) {
+        return;
+    }
+    FLAGS_logtostderr = true;
+    google::RemoveLogSink(async_sink_.get());
+    async_sink_->Stop();
+    async_sink_.reset();
+}
+
 }  // namespace common
-}  // namespace dfs
\ No newline at end of file
+}  // namespace dfs
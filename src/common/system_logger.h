@@ -3,13 +3,74 @@
 
 #include <glog/logging.h>
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <string>
 
+// 编译期的最大 VLOG 级别，更高级别的 DFS_VLOG 在编译时被去掉，
+// 运行时的级别由 glog 的 FLAGS_v（配置中的 log.verbosity）控制
+#ifndef DFS_MAX_VLOG_LEVEL
+#define DFS_MAX_VLOG_LEVEL 2
+#endif
+
+// 热路径上的调试日志使用 DFS_VLOG，级别 1 为每个请求一条，级别 2 为更细的
+// 过程
+#define DFS_VLOG(level)                   \
+    if ((level) > DFS_MAX_VLOG_LEVEL) {   \
+    } else                                \
+        VLOG(level)
+
+// 同一处每秒最多输出 max_per_second 条日志，超出的丢弃，下一条输出的日志
+// 带上丢弃的数量。用于可能随请求刷屏的错误日志
+#define DFS_LOG_RATE_LIMITED(severity, max_per_second)                  \
+    if (static ::dfs::common::LogRateLimiter dfs_log_rate_limiter(      \
+            max_per_second);                                            \
+        !dfs_log_rate_limiter.Allow()) {                                \
+    } else                                                              \
+        LOG(severity) << dfs_log_rate_limiter.TakeSuppressed()
+
 namespace dfs {
 namespace common {
 
+class AsyncLogSink;
+
+/**
+ * 一处日志的限速器，每秒最多放行 max_per_second 条
+ * 只使用 relaxed 原子操作，窗口切换时的计数不精确，对日志限速足够
+ */
+class LogRateLimiter {
+   public:
+    explicit LogRateLimiter(uint32_t max_per_second);
+
+    bool Allow();
+
+    // 返回并清空上一次放行以来丢弃的数量，格式化为日志前缀，没有丢弃时
+    // 为空
+    std::string TakeSuppressed();
+
+   private:
+    const uint32_t max_per_second_;
+
+    // 当前窗口的起始秒
+    std::atomic<int64_t> window_{0};
+
+    std::atomic<uint32_t> count_{0};
+
+    std::atomic<uint64_t> suppressed_{0};
+};
+
 class SystemLogger {
 public:
+    struct Options {
+        // 由后台线程异步写日志，关闭时由 glog 同步写入标准错误
+        bool async = true;
+        // 异步缓冲区能容纳的日志条数，满时丢弃新的日志
+        uint32_t buffer_entries = 65536;
+        // glog 的 FLAGS_v，DFS_VLOG 的运行时级别
+        int verbosity = 0;
+    };
+
     static SystemLogger& GetInstance() {
         static SystemLogger instance;
         return instance;
@@ -17,14 +78,31 @@ public:
 
     SystemLogger(const SystemLogger&) = delete;
 
+    ~SystemLogger();
+
+    // 读取配置文件中的日志配置，需在配置初始化之后调用
+    static Options LoadOptions();
+
+    // 初始化 glog，日志先同步写入标准错误，Configure 之后按配置输出
     void Initialize(const std::string& program_name);
+
+    // 切换日志的输出方式，可以重复调用
+    void Configure(const Options& options);
+
+    // 写完缓冲区中的日志
+    void Flush();
+
+    // 停止异步输出，写完缓冲区中的日志，之后回到同步写入标准错误
+    void Shutdown();
 private:
     bool is_initialized_;
-    SystemLogger():is_initialized_(false) {}
+    SystemLogger();
+
+    std::unique_ptr<AsyncLogSink> async_sink_;
 };
 
 }  // namespace common
 }  // namespace dfs
 
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,49 @@
+#include "src/common/token_bucket.h"
+
+#include <algorithm>
+
+namespace dfs {
+namespace common {
+
+TokenBucket::TokenBucket(uint64_t rate_per_sec, uint64_t burst)
+    : rate_per_sec_(rate_per_sec),
+      burst_(std::max<uint64_t>(burst, 1)),
+      tokens_(burst_),
+      last_refill_time_(absl::Now()) {}
+
+absl::Duration TokenBucket::Reserve(uint64_t tokens, absl::Time now) {
+    absl::MutexLock lock_guard(&lock_);
+    if (rate_per_sec_ <= 0) {
+        return absl::ZeroDuration();
+    }
+
+    Refill(now);
+    tokens_ -= tokens;
+    if (tokens_ >= 0) {
+        return absl::ZeroDuration();
+    }
+
+    return absl::Seconds(-tokens_ / rate_per_sec_);
+}
+
+void TokenBucket::Acquire(uint64_t tokens) {
+    absl::SleepFor(Reserve(tokens, absl::Now()));
+}
+
+void TokenBucket::SetRate(uint64_t rate_per_sec) {
+    absl::MutexLock lock_guard(&lock_);
+    Refill(absl::Now());
+    rate_per_sec_ = rate_per_sec;
+}
+
+void TokenBucket::Refill(absl::Time now) {
+    if (now > last_refill_time_) {
+        tokens_ = std::min(
+            burst_, tokens_ + absl::ToDoubleSeconds(now - last_refill_time_) *
+                                  rate_per_sec_);
+        last_refill_time_ = now;
+    }
+}
+
+}  // namespace common
+}  // namespace dfs
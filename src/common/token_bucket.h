@@ -0,0 +1,50 @@
+#ifndef DFS_COMMON_TOKEN_BUCKET_H
+#define DFS_COMMON_TOKEN_BUCKET_H
+
+#include <absl/synchronization/mutex.h>
+#include <absl/time/time.h>
+
+#include <cstdint>
+
+namespace dfs {
+namespace common {
+
+/**
+ * 令牌桶限速器
+ * 令牌以 rate_per_sec 的速度生成，最多积攒 burst 个。
+ * 单次申请可以超过 burst，此时令牌数变为负数，后续的申请需要等待补齐。
+ * rate_per_sec 为 0 表示不限速。
+ */
+class TokenBucket {
+   public:
+    TokenBucket(uint64_t rate_per_sec, uint64_t burst);
+
+    // 申请 tokens 个令牌，返回需要等待的时间，不会阻塞
+    absl::Duration Reserve(uint64_t tokens, absl::Time now);
+
+    // 申请 tokens 个令牌，令牌不足时阻塞等待
+    void Acquire(uint64_t tokens);
+
+    // 修改令牌生成速度
+    void SetRate(uint64_t rate_per_sec);
+
+   private:
+    // 补充令牌，调用者需持有 lock_
+    void Refill(absl::Time now);
+
+    absl::Mutex lock_;
+
+    double rate_per_sec_;
+
+    double burst_;
+
+    // 当前令牌数，可以为负数
+    double tokens_;
+
+    absl::Time last_refill_time_;
+};
+
+}  // namespace common
+}  // namespace dfs
+
+#endif  // DFS_COMMON_TOKEN_BUCKET_H
@@ -0,0 +1,521 @@
+#include "src/common/tracing.h"
+
+#include <absl/strings/str_cat.h>
+#include <absl/time/clock.h>
+#include <fcntl.h>
+#include <json/json.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <random>
+
+#include "src/common/config_manager.h"
+#include "src/common/metrics.h"
+#include "src/common/system_logger.h"
+
+namespace dfs {
+namespace common {
+
+const char kTraceParentKey[] = "traceparent";
+
+namespace {
+
+// 2^64，采样率与采样阈值之间的换算
+const double kThresholdScale = 18446744073709551616.0;
+
+thread_local TraceContext current_context;
+
+int64_t CurrentThreadId() {
+    thread_local const int64_t thread_id = syscall(SYS_gettid);
+    return thread_id;
+}
+
+uint64_t WallMicros() { return absl::GetCurrentTimeNanos() / 1000; }
+
+// 每个线程一个 splitmix64 生成器，生成 id 与采样用的随机数
+uint64_t RandomUint64() {
+    thread_local uint64_t state =
+        (static_cast<uint64_t>(std::random_device()()) << 32) ^
+        static_cast<uint64_t>(CurrentThreadId()) ^ WallMicros();
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// id 不能为 0，0 表示没有
+uint64_t RandomId() {
+    uint64_t id;
+    do {
+        id = RandomUint64();
+    } while (id == 0);
+    return id;
+}
+
+bool ParseHex(absl::string_view text, uint64_t* value) {
+    *value = 0;
+    for (char c : text) {
+        uint64_t digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else {
+            return false;
+        }
+        *value = (*value << 4) | digit;
+    }
+    return true;
+}
+
+const char* KindName(Span::Kind kind) {
+    switch (kind) {
+        case Span::Kind::CLIENT:
+            return "client";
+        case Span::Kind::SERVER:
+            return "server";
+        case Span::Kind::INTERNAL:
+            return "internal";
+    }
+    return "internal";
+}
+
+}  // namespace
+
+std::string FormatTraceParent(const TraceContext& context) {
+    return absl::StrCat(
+        "00-", absl::Hex(context.trace_id_high, absl::kZeroPad16),
+        absl::Hex(context.trace_id_low, absl::kZeroPad16), "-",
+        absl::Hex(context.span_id, absl::kZeroPad16),
+        context.sampled ? "-01" : "-00");
+}
+
+bool ParseTraceParent(absl::string_view text, TraceContext* context) {
+    // 00-<32>-<16>-<2>
+    if (text.size() != 55 || text.substr(0, 3) != "00-" || text[35] != '-' ||
+        text[52] != '-') {
+        return false;
+    }
+    TraceContext parsed;
+    uint64_t flags;
+    if (!ParseHex(text.substr(3, 16), &parsed.trace_id_high) ||
+        !ParseHex(text.substr(19, 16), &parsed.trace_id_low) ||
+        !ParseHex(text.substr(36, 16), &parsed.span_id) ||
+        !ParseHex(text.substr(53, 2), &flags) || !parsed.valid() ||
+        parsed.span_id == 0) {
+        return false;
+    }
+    parsed.sampled = flags & 1;
+    *context = parsed;
+    return true;
+}
+
+TraceContext CurrentTraceContext() { return current_context; }
+
+ScopedTraceContext::ScopedTraceContext(const TraceContext& context)
+    : previous_(current_context) {
+    current_context = context;
+}
+
+ScopedTraceContext::~ScopedTraceContext() { current_context = previous_; }
+
+Span::Span(const char* name) : name_(name), kind_(Kind::INTERNAL) {
+    Begin(current_context, 0);
+}
+
+Span::Span(const char* name, grpc::ClientContext* context)
+    : name_(name), kind_(Kind::CLIENT) {
+    Begin(current_context, 0);
+    if (context_.valid()) {
+        context->AddMetadata(kTraceParentKey, FormatTraceParent(context_));
+    }
+}
+
+Span::Span(const char* name, const grpc::ServerContext* context,
+           uint64_t start_micros)
+    : name_(name), kind_(Kind::SERVER) {
+    TraceContext parent;
+    const auto& metadata = context->client_metadata();
+    auto iter = metadata.find(kTraceParentKey);
+    if (iter != metadata.end()) {
+        ParseTraceParent(
+            absl::string_view(iter->second.data(), iter->second.length()),
+            &parent);
+    }
+    Begin(parent, start_micros);
+}
+
+void Span::Begin(const TraceContext& parent, uint64_t start_micros) {
+    previous_ = current_context;
+    if (parent.valid()) {
+        context_ = parent;
+        context_.span_id = RandomId();
+        parent_span_id_ = parent.span_id;
+    } else if (!Tracer::GetInstance()->StartTrace(&context_)) {
+        return;
+    }
+    current_context = context_;
+
+    if (context_.sampled) {
+        start_micros_ = WallMicros();
+        // 服务端的 span 从收到请求时开始，包括在线程池中排队的时间
+        if (start_micros > 0) {
+            start_micros_ -= MonotonicMicros() - start_micros;
+        }
+    }
+}
+
+Span::~Span() { End(); }
+
+void Span::End() {
+    if (!context_.valid()) {
+        return;
+    }
+    current_context = previous_;
+    const TraceContext context = context_;
+    // 之后的 End 与析构不再记录
+    context_ = TraceContext();
+    if (!context.sampled) {
+        return;
+    }
+
+    const uint64_t end_micros = WallMicros();
+    Tracer::SpanRecord record;
+    record.name = name_;
+    record.kind = kind_;
+    record.trace_id_high = context.trace_id_high;
+    record.trace_id_low = context.trace_id_low;
+    record.span_id = context.span_id;
+    record.parent_span_id = parent_span_id_;
+    record.start_micros = start_micros_;
+    record.duration_micros =
+        end_micros > start_micros_ ? end_micros - start_micros_ : 0;
+    record.thread_id = CurrentThreadId();
+    record.status = status_;
+    record.attribute_key = attribute_key_;
+    record.attribute_value = attribute_value_;
+    Tracer::GetInstance()->Record(record);
+}
+
+void Span::SetStatus(const grpc::Status& status) {
+    status_ = status.error_code();
+}
+
+void Span::SetStatus(const google::protobuf::util::Status& status) {
+    status_ = static_cast<int>(status.code());
+}
+
+void Span::SetAttribute(const char* key, int64_t value) {
+    attribute_key_ = key;
+    attribute_value_ = value;
+}
+
+Tracer::Tracer() {
+    auto registry = MetricsRegistry::GetInstance();
+    metric_callbacks_.push_back(registry->AddCallback(
+        "dfs_trace_spans_total", "Sampled spans recorded", MetricType::COUNTER,
+        {}, [this]() { return GetRecordedSpans(); }));
+    metric_callbacks_.push_back(registry->AddCallback(
+        "dfs_trace_spans_lost_total",
+        "Spans overwritten in the ring buffer before being exported",
+        MetricType::COUNTER, {}, [this]() { return GetLostSpans(); }));
+}
+
+Tracer::~Tracer() {
+    for (auto id : metric_callbacks_) {
+        MetricsRegistry::GetInstance()->RemoveCallback(id);
+    }
+    Shutdown();
+}
+
+Tracer::Options Tracer::LoadOptions() {
+    auto config_manager = ConfigManager::GetInstance();
+    Options options;
+    options.sample_rate = config_manager->GetTracingSampleRate();
+    options.buffer_spans = config_manager->GetTracingBufferSpans();
+    options.flush_interval_ms = config_manager->GetTracingFlushIntervalMs();
+    options.output_dir = config_manager->GetTracingOutputDir();
+    return options;
+}
+
+void Tracer::Start(const std::string& process_name, const Options& options) {
+    Shutdown();
+    SetSampleRate(options.sample_rate);
+
+    absl::MutexLock lock_guard(&lock_);
+    ResizeBuffer(options.buffer_spans);
+    process_name_ = process_name;
+    pid_ = getpid();
+    flush_interval_ms_ = std::max<uint32_t>(options.flush_interval_ms, 1);
+    if (options.output_dir.empty()) {
+        return;
+    }
+
+    if (mkdir(options.output_dir.c_str(), 0755) < 0 && errno != EEXIST) {
+        LOG(ERROR) << "can not create trace dir " << options.output_dir << ", "
+                   << strerror(errno);
+        return;
+    }
+    const std::string path = absl::StrCat(options.output_dir, "/",
+                                          process_name, ".", pid_,
+                                          ".trace.json");
+    fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        LOG(ERROR) << "can not open trace file " << path << ", "
+                   << strerror(errno);
+        return;
+    }
+
+    // 第一个事件为进程名，之后的事件都以逗号开头，文件没有正常结束时
+    // 也能被打开
+    WriteText(absl::StrCat(
+        "[{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":", pid_,
+        ",\"tid\":0,\"args\":{\"name\":",
+        Json::valueToQuotedString(process_name.c_str()), "}}"));
+    stopped_ = false;
+    thread_ = std::thread([this]() { Run(); });
+    LOG(INFO) << "trace spans are exported to " << path
+              << ", sample rate: " << options.sample_rate;
+}
+
+void Tracer::Shutdown() {
+    {
+        absl::MutexLock lock_guard(&lock_);
+        stopped_ = true;
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+
+    absl::MutexLock lock_guard(&lock_);
+    if (fd_ < 0) {
+        return;
+    }
+    FlushLocked();
+    WriteText("\n]\n");
+    close(fd_);
+    fd_ = -1;
+}
+
+void Tracer::SetSampleRate(double sample_rate) {
+    uint64_t threshold = 0;
+    if (sample_rate >= 1) {
+        threshold = UINT64_MAX;
+    } else if (sample_rate > 0) {
+        threshold = static_cast<uint64_t>(sample_rate * kThresholdScale);
+    }
+    sample_threshold_.store(threshold, std::memory_order_relaxed);
+}
+
+double Tracer::GetSampleRate() const {
+    const uint64_t threshold =
+        sample_threshold_.load(std::memory_order_relaxed);
+    if (threshold == UINT64_MAX) {
+        return 1;
+    }
+    return threshold / kThresholdScale;
+}
+
+const char* Tracer::InternName(const std::string& name) {
+    absl::MutexLock lock_guard(&names_lock_);
+    return names_.insert(name).first->c_str();
+}
+
+bool Tracer::StartTrace(TraceContext* context) {
+    const uint64_t threshold =
+        sample_threshold_.load(std::memory_order_relaxed);
+    if (threshold == 0) {
+        return false;
+    }
+    context->trace_id_high = RandomUint64();
+    context->trace_id_low = RandomId();
+    context->span_id = RandomId();
+    context->sampled =
+        threshold == UINT64_MAX || RandomUint64() < threshold;
+    return true;
+}
+
+void Tracer::Record(const SpanRecord& record) {
+    if (!slots_) {
+        return;
+    }
+
+    // 多个线程写入不同的位置；缓冲区在一次写入期间被绕过一整圈时两个
+    // 写者可能写同一个槽位，读者通过 seq 丢弃大部分这样的 span
+    const uint64_t pos = next_.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = slots_[pos & mask_];
+    slot.seq.store(2 * pos + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(record.name, std::memory_order_relaxed);
+    slot.kind.store(static_cast<uint8_t>(record.kind),
+                    std::memory_order_relaxed);
+    slot.status.store(record.status, std::memory_order_relaxed);
+    slot.trace_id_high.store(record.trace_id_high, std::memory_order_relaxed);
+    slot.trace_id_low.store(record.trace_id_low, std::memory_order_relaxed);
+    slot.span_id.store(record.span_id, std::memory_order_relaxed);
+    slot.parent_span_id.store(record.parent_span_id,
+                              std::memory_order_relaxed);
+    slot.start_micros.store(record.start_micros, std::memory_order_relaxed);
+    slot.duration_micros.store(record.duration_micros,
+                               std::memory_order_relaxed);
+    slot.thread_id.store(record.thread_id, std::memory_order_relaxed);
+    slot.attribute_key.store(record.attribute_key, std::memory_order_relaxed);
+    slot.attribute_value.store(record.attribute_value,
+                               std::memory_order_relaxed);
+    slot.seq.store(2 * pos + 2, std::memory_order_release);
+}
+
+void Tracer::Flush() {
+    absl::MutexLock lock_guard(&lock_);
+    FlushLocked();
+}
+
+size_t Tracer::Drain(std::vector<SpanRecord>* records) {
+    absl::MutexLock lock_guard(&lock_);
+    return DrainLocked(records);
+}
+
+uint64_t Tracer::GetLostSpans() {
+    absl::MutexLock lock_guard(&lock_);
+    return lost_spans_;
+}
+
+void Tracer::ResizeBuffer(uint32_t buffer_spans) {
+    uint64_t capacity = 1;
+    while (capacity < buffer_spans) {
+        capacity <<= 1;
+    }
+    if (slots_ && capacity == mask_ + 1) {
+        return;
+    }
+    slots_ = std::make_unique<Slot[]>(capacity);
+    mask_ = capacity - 1;
+    next_.store(0, std::memory_order_relaxed);
+    read_pos_ = 0;
+}
+
+void Tracer::Run() {
+    absl::MutexLock lock_guard(&lock_);
+    while (!stopped_) {
+        lock_.AwaitWithTimeout(absl::Condition(&stopped_),
+                               absl::Milliseconds(flush_interval_ms_));
+        FlushLocked();
+    }
+}
+
+size_t Tracer::DrainLocked(std::vector<SpanRecord>* records) {
+    if (!slots_) {
+        return 0;
+    }
+
+    const uint64_t capacity = mask_ + 1;
+    const uint64_t end = next_.load(std::memory_order_acquire);
+    if (end - read_pos_ > capacity) {
+        lost_spans_ += end - capacity - read_pos_;
+        read_pos_ = end - capacity;
+    }
+
+    size_t drained = 0;
+    for (; read_pos_ < end; read_pos_++) {
+        const Slot& slot = slots_[read_pos_ & mask_];
+        const uint64_t expected = 2 * read_pos_ + 2;
+        const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+        // 还在写入，下一次再读
+        if (seq < expected) {
+            break;
+        }
+        // 已经被后来的 span 覆盖
+        if (seq > expected) {
+            lost_spans_++;
+            continue;
+        }
+
+        SpanRecord record;
+        record.name = slot.name.load(std::memory_order_relaxed);
+        record.kind =
+            static_cast<Span::Kind>(slot.kind.load(std::memory_order_relaxed));
+        record.status = slot.status.load(std::memory_order_relaxed);
+        record.trace_id_high =
+            slot.trace_id_high.load(std::memory_order_relaxed);
+        record.trace_id_low = slot.trace_id_low.load(std::memory_order_relaxed);
+        record.span_id = slot.span_id.load(std::memory_order_relaxed);
+        record.parent_span_id =
+            slot.parent_span_id.load(std::memory_order_relaxed);
+        record.start_micros = slot.start_micros.load(std::memory_order_relaxed);
+        record.duration_micros =
+            slot.duration_micros.load(std::memory_order_relaxed);
+        record.thread_id = slot.thread_id.load(std::memory_order_relaxed);
+        record.attribute_key =
+            slot.attribute_key.load(std::memory_order_relaxed);
+        record.attribute_value =
+            slot.attribute_value.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != seq) {
+            lost_spans_++;
+            continue;
+        }
+        records->push_back(record);
+        drained++;
+    }
+    return drained;
+}
+
+void Tracer::FlushLocked() {
+    std::vector<SpanRecord> records;
+    DrainLocked(&records);
+    if (fd_ < 0 || records.empty()) {
+        return;
+    }
+
+    std::string text;
+    for (const auto& record : records) {
+        AppendEvent(record, &text);
+    }
+    WriteText(text);
+}
+
+void Tracer::AppendEvent(const SpanRecord& record, std::string* text) {
+    // {"name":"WriteFileChunk","cat":"server","ph":"X","ts":...,"dur":...,
+    //  "pid":...,"tid":...,"args":{"trace_id":...,"span_id":...}}
+    absl::StrAppend(
+        text, ",\n{\"name\":\"", record.name, "\",\"cat\":\"",
+        KindName(record.kind), "\",\"ph\":\"X\",\"ts\":", record.start_micros,
+        ",\"dur\":", record.duration_micros, ",\"pid\":", pid_,
+        ",\"tid\":", record.thread_id, ",\"args\":{\"trace_id\":\"",
+        absl::Hex(record.trace_id_high, absl::kZeroPad16),
+        absl::Hex(record.trace_id_low, absl::kZeroPad16),
+        "\",\"span_id\":\"", absl::Hex(record.span_id, absl::kZeroPad16), "\"");
+    if (record.parent_span_id != 0) {
+        absl::StrAppend(text, ",\"parent_span_id\":\"",
+                        absl::Hex(record.parent_span_id, absl::kZeroPad16),
+                        "\"");
+    }
+    absl::StrAppend(text, ",\"status\":", record.status);
+    if (record.attribute_key) {
+        absl::StrAppend(text, ",\"", record.attribute_key,
+                        "\":", record.attribute_value);
+    }
+    text->append("}}");
+}
+
+void Tracer::WriteText(const std::string& text) {
+    size_t written = 0;
+    while (written < text.size()) {
+        auto n = write(fd_, text.data() + written, text.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG(ERROR) << "write trace file failed, " << strerror(errno);
+            return;
+        }
+        written += n;
+    }
+}
+
+}  // namespace common
+}  // namespace dfs
@@ -0,0 +1,294 @@
+#ifndef DFS_COMMON_TRACING_H
+#define DFS_COMMON_TRACING_H
+
+#include <absl/strings/string_view.h>
+#include <absl/synchronization/mutex.h>
+#include <google/protobuf/stubs/status.h>
+#include <grpcpp/grpcpp.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dfs {
+namespace common {
+
+// 请求元数据中携带 trace context 的键，格式与 W3C traceparent 相同：
+// 00-<32 位十六进制 trace id>-<16 位十六进制 span id>-<01 采样 | 00 不采样>
+extern const char kTraceParentKey[];
+
+// 一次请求链路中的位置，随 gRPC 元数据在进程间传递
+struct TraceContext {
+    uint64_t trace_id_high = 0;
+    uint64_t trace_id_low = 0;
+    uint64_t span_id = 0;
+    // 不采样的请求也传递 context，下游不会再单独开始一个 trace
+    bool sampled = false;
+
+    bool valid() const { return trace_id_high != 0 || trace_id_low != 0; }
+};
+
+std::string FormatTraceParent(const TraceContext& context);
+
+bool ParseTraceParent(absl::string_view text, TraceContext* context);
+
+// 当前线程的 trace context，没有进行中的 span 时无效
+TraceContext CurrentTraceContext();
+
+/**
+ * 在作用域内设置当前线程的 trace context，离开作用域时恢复
+ * 请求交给其他线程处理时，在新线程中使用原线程的 context，
+ * 新线程中的 span 仍属于同一个 trace
+ */
+class ScopedTraceContext {
+   public:
+    explicit ScopedTraceContext(const TraceContext& context);
+
+    ~ScopedTraceContext();
+
+    ScopedTraceContext(const ScopedTraceContext&) = delete;
+
+    ScopedTraceContext& operator=(const ScopedTraceContext&) = delete;
+
+   private:
+    TraceContext previous_;
+};
+
+/**
+ * 一个 span，构造时开始，析构时结束
+ * 1. 作为当前线程 span 的子 span，期间是当前线程的 span；
+ *    没有父 span 时按采样率决定是否开始一个新的 trace
+ * 2. 客户端的 span 把 context 写入 ClientContext 的元数据，
+ *    服务端的 span 以请求元数据中的 context 为父 span
+ * 3. 只有采样的 span 读取时钟并在结束时写入 Tracer 的环形缓冲区，
+ *    不采样时只有一次线程局部变量的读写
+ * 4. name 与属性名不会被复制，需为字面量或 Tracer::InternName 的返回值
+ */
+class Span {
+   public:
+    enum class Kind : uint8_t {
+        INTERNAL,
+        CLIENT,
+        SERVER,
+    };
+
+    explicit Span(const char* name);
+
+    // 发起 RPC，需在调用 stub 之前构造
+    Span(const char* name, grpc::ClientContext* context);
+
+    // 处理 RPC，start_micros 为收到请求时的 MonotonicMicros()
+    Span(const char* name, const grpc::ServerContext* context,
+         uint64_t start_micros);
+
+    ~Span();
+
+    // 在离开作用域之前结束 span，之后的调用与析构不做任何事
+    void End();
+
+    Span(const Span&) = delete;
+
+    Span& operator=(const Span&) = delete;
+
+    void SetStatus(const grpc::Status& status);
+
+    void SetStatus(const google::protobuf::util::Status& status);
+
+    // 一个整数属性，例如数据长度、排队时间，重复设置时覆盖
+    void SetAttribute(const char* key, int64_t value);
+
+    bool sampled() const { return context_.sampled; }
+
+    const TraceContext& context() const { return context_; }
+
+   private:
+    void Begin(const TraceContext& parent, uint64_t start_micros);
+
+    const char* name_;
+
+    Kind kind_;
+
+    TraceContext context_;
+
+    uint64_t parent_span_id_ = 0;
+
+    // 构造前线程的 context，结束时恢复
+    TraceContext previous_;
+
+    // 墙上时钟，单位微秒，多个进程的 span 可以放到一起对比
+    uint64_t start_micros_ = 0;
+
+    int status_ = 0;
+
+    const char* attribute_key_ = nullptr;
+
+    int64_t attribute_value_ = 0;
+};
+
+/**
+ * 进程内的 span 收集与导出
+ * 1. 结束的 span 写入固定大小的环形缓冲区，写入只需要一次原子加与
+ *    一个 seqlock，不加锁。后台线程来不及导出时旧的 span 被覆盖，
+ *    记录丢失的数量
+ * 2. 后台线程定期将新的 span 以 Chrome trace（JSON 数组格式）追加到
+ *    <output_dir>/<process_name>.<pid>.trace.json，可以直接用
+ *    chrome://tracing 或 Perfetto 打开，trace id 与 span id 在 args 中，
+ *    用于拼接多个进程的文件
+ * 3. 采样率可以在运行时修改，新的 trace 按新的采样率决定是否采样，
+ *    已经开始的 trace 沿用上游的决定
+ */
+class Tracer {
+   public:
+    struct Options {
+        // 没有上游 context 的请求被采样的比例，0 为关闭
+        double sample_rate = 0;
+        // 环形缓冲区能容纳的 span 数量，向上取整为 2 的幂
+        uint32_t buffer_spans = 16384;
+        // 导出的间隔
+        uint32_t flush_interval_ms = 1000;
+        // 导出的目录，为空时不导出
+        std::string output_dir;
+    };
+
+    // 导出时的一个 span
+    struct SpanRecord {
+        const char* name;
+        Span::Kind kind;
+        uint64_t trace_id_high;
+        uint64_t trace_id_low;
+        uint64_t span_id;
+        uint64_t parent_span_id;
+        uint64_t start_micros;
+        uint64_t duration_micros;
+        int64_t thread_id;
+        int status;
+        const char* attribute_key;
+        int64_t attribute_value;
+    };
+
+    static Tracer* GetInstance() {
+        static Tracer instance;
+        return &instance;
+    }
+
+    Tracer(const Tracer&) = delete;
+
+    ~Tracer();
+
+    // 读取配置文件中的追踪配置，需在配置初始化之后调用
+    static Options LoadOptions();
+
+    // 设置采样率并开始导出，process_name 用于文件名与 trace 中的进程名。
+    // 需在处理请求之前调用，调用之前结束的 span 被丢弃
+    void Start(const std::string& process_name, const Options& options);
+
+    // 导出剩余的 span，结束 JSON 数组并关闭文件
+    void Shutdown();
+
+    void SetSampleRate(double sample_rate);
+
+    double GetSampleRate() const;
+
+    // 返回与 name 相同、进程退出前一直有效的字符串，用于运行时生成的
+    // span 名字
+    const char* InternName(const std::string& name);
+
+    // 没有上游 context 时，为新的 trace 生成 id 并决定是否采样。
+    // 采样率为 0 时返回 false，不生成 context
+    bool StartTrace(TraceContext* context);
+
+    void Record(const SpanRecord& record);
+
+    // 将新的 span 写入导出文件，没有启动导出时只丢弃
+    void Flush();
+
+    // 读出新写入的 span，返回读出的数量。测试与 Flush 使用
+    size_t Drain(std::vector<SpanRecord>* records);
+
+    uint64_t GetRecordedSpans() const {
+        return next_.load(std::memory_order_relaxed);
+    }
+
+    uint64_t GetLostSpans();
+
+   private:
+    Tracer();
+
+    // 环形缓冲区的一个槽位，所有字段都是原子变量，读取时用 seq 判断
+    // 是否读到了完整的 span
+    struct Slot {
+        // 写入位置为 pos 的 span 时先置为 2 * pos + 1，写完后置为
+        // 2 * pos + 2
+        std::atomic<uint64_t> seq{0};
+        std::atomic<const char*> name{nullptr};
+        std::atomic<uint8_t> kind{0};
+        std::atomic<int> status{0};
+        std::atomic<uint64_t> trace_id_high{0};
+        std::atomic<uint64_t> trace_id_low{0};
+        std::atomic<uint64_t> span_id{0};
+        std::atomic<uint64_t> parent_span_id{0};
+        std::atomic<uint64_t> start_micros{0};
+        std::atomic<uint64_t> duration_micros{0};
+        std::atomic<int64_t> thread_id{0};
+        std::atomic<const char*> attribute_key{nullptr};
+        std::atomic<int64_t> attribute_value{0};
+    };
+
+    void ResizeBuffer(uint32_t buffer_spans);
+
+    void Run();
+
+    // 以下方法需持有 lock_
+    size_t DrainLocked(std::vector<SpanRecord>* records);
+
+    void FlushLocked();
+
+    void AppendEvent(const SpanRecord& record, std::string* text);
+
+    void WriteText(const std::string& text);
+
+    std::unique_ptr<Slot[]> slots_;
+
+    uint64_t mask_ = 0;
+
+    // 下一个写入位置
+    std::atomic<uint64_t> next_{0};
+
+    // 采样阈值，随机数小于阈值时采样，为 0 时关闭
+    std::atomic<uint64_t> sample_threshold_{0};
+
+    // 保护读取位置与导出文件，同一时刻只有一个读者
+    absl::Mutex lock_;
+
+    uint64_t read_pos_ = 0;
+
+    uint64_t lost_spans_ = 0;
+
+    int fd_ = -1;
+
+    int pid_ = 0;
+
+    std::string process_name_;
+
+    uint32_t flush_interval_ms_ = 1000;
+
+    bool stopped_ = true;
+
+    std::thread thread_;
+
+    absl::Mutex names_lock_;
+
+    std::set<std::string> names_;
+
+    // 导出的 span 数量与丢失的 span 数量
+    std::vector<uint64_t> metric_callbacks_;
+};
+
+}  // namespace common
+}  // namespace dfs
+
+#endif  // DFS_COMMON_TRACING_H
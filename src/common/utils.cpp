@@ -10,10 +10,14 @@ const std::string calc_md5(const std::string& data) {
 }
 
 const std::string ComputeHash(const std::string& data) {
+    return ComputeHash(data.data(), data.size());
+}
+
+const std::string ComputeHash(const char* data, size_t nbytes) {
     std::string hash(EVP_MAX_MD_SIZE, ' ');
     EVP_MD_CTX* mdctx = EVP_MD_CTX_new();
     EVP_DigestInit_ex(mdctx, EVP_sha256(), NULL);
-    EVP_DigestUpdate(mdctx, data.data(), data.size());
+    EVP_DigestUpdate(mdctx, data, nbytes);
     unsigned int len;
     EVP_DigestFinal_ex(mdctx, reinterpret_cast<unsigned char*>(&hash[0]), &len);
     hash.resize(len);
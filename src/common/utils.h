@@ -14,6 +14,9 @@
 namespace dfs {
 namespace common {
 
+// 1KB
+const size_t bytesKB = 1024;
+
 // 1MB
 const size_t bytesMB = 1024 * 1024;
 
@@ -21,6 +24,9 @@ const std::string calc_md5(const std::string& data);
 
 const std::string ComputeHash(const std::string& data);
 
+// 直接计算调用者内存的校验和，不需要先复制到 std::string
+const std::string ComputeHash(const char* data, size_t nbytes);
+
 template <class Key, class Value,
           class Hash = absl::container_internal::hash_default_hash<Key>>
 class parallel_hash_map {
@@ -60,12 +66,38 @@ class parallel_hash_map {
         map_[key] = value;
     }
 
+    // if key exist, update the value in place by updater and return its
+    // result, else return false
+    template <class Updater>
+    bool TryUpdate(const Key& key, Updater updater) {
+        absl::WriterMutexLock lock_guard(&lock_);
+        auto iter = map_.find(key);
+        if (iter == map_.end()) {
+            return false;
+        }
+        return updater(iter->second);
+    }
+
+    // update the value in place by updater and return its result, insert a
+    // default value first if the key does not exist
+    template <class Updater>
+    auto Upsert(const Key& key, Updater updater) {
+        absl::WriterMutexLock lock_guard(&lock_);
+        return updater(map_[key]);
+    }
+
     // erase key from hash_map
     void Erase(const Key& key) {
         absl::WriterMutexLock lock_guard(&lock_);
         map_.erase(key);
     }
 
+    // erase all keys from hash_map
+    void Clear() {
+        absl::WriterMutexLock lock_guard(&lock_);
+        map_.clear();
+    }
+
     Value& operator[](const Key& key) {
         absl::ReaderMutexLock lock_guard(&lock_);
         return map_[key];
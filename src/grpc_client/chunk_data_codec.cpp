@@ -0,0 +1,93 @@
+#include "src/grpc_client/chunk_data_codec.h"
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/wire_format_lite.h>
+#include <grpcpp/support/proto_buffer_reader.h>
+#include <grpcpp/support/slice.h>
+
+namespace dfs {
+namespace grpc_client {
+
+using google::protobuf::internal::WireFormatLite;
+using google::protobuf::io::CodedInputStream;
+using google::protobuf::io::CodedOutputStream;
+using google::protobuf::io::StringOutputStream;
+using google::protobuf::util::DataLossError;
+using google::protobuf::util::OkStatus;
+using google::protobuf::util::OutOfRangeError;
+using protos::grpc::ReadFileChunkRespond;
+using protos::grpc::SendChunkDataRequest;
+
+grpc::ByteBuffer SerializeSendChunkDataRequest(const std::string& checksum,
+                                               const char* data,
+                                               size_t nbytes) {
+    // 字段头：checksum 字段与 data 字段的 tag 和长度
+    std::string header;
+    {
+        StringOutputStream header_stream(&header);
+        CodedOutputStream output(&header_stream);
+        WireFormatLite::WriteString(SendChunkDataRequest::kChecksumFieldNumber,
+                                    checksum, &output);
+        if (nbytes > 0) {
+            WireFormatLite::WriteTag(
+                SendChunkDataRequest::kDataFieldNumber,
+                WireFormatLite::WIRETYPE_LENGTH_DELIMITED, &output);
+            output.WriteVarint32(static_cast<uint32_t>(nbytes));
+        }
+    }
+
+    grpc::Slice slices[2] = {
+        grpc::Slice(header),
+        grpc::Slice(data, nbytes, grpc::Slice::STATIC_SLICE),
+    };
+    return grpc::ByteBuffer(slices, nbytes > 0 ? 2 : 1);
+}
+
+google::protobuf::util::Status ParseReadFileChunkRespond(
+    grpc::ByteBuffer* byte_buffer, char* buffer, size_t capacity,
+    ReadFileChunkRespond* respond) {
+    grpc::ProtoBufferReader reader(byte_buffer);
+    CodedInputStream input(&reader);
+
+    // data 以外的字段原样复制出来，最后交给 protobuf 解析
+    std::string fields;
+    uint32_t data_length = 0;
+    {
+        StringOutputStream fields_stream(&fields);
+        CodedOutputStream output(&fields_stream);
+        while (const uint32_t tag = input.ReadTag()) {
+            if (WireFormatLite::GetTagFieldNumber(tag) !=
+                    ReadFileChunkRespond::kDataFieldNumber ||
+                WireFormatLite::GetTagWireType(tag) !=
+                    WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+                if (!WireFormatLite::SkipField(&input, tag, &output)) {
+                    return DataLossError("malformed read file chunk respond");
+                }
+                continue;
+            }
+
+            if (!input.ReadVarint32(&data_length)) {
+                return DataLossError("malformed read file chunk data");
+            }
+            if (data_length > capacity) {
+                return OutOfRangeError(
+                    "read file chunk data " + std::to_string(data_length) +
+                    " bytes exceeds buffer " + std::to_string(capacity));
+            }
+            if (!input.ReadRaw(buffer, data_length)) {
+                return DataLossError("truncated read file chunk data");
+            }
+        }
+    }
+
+    if (!respond->ParseFromString(fields)) {
+        return DataLossError("malformed read file chunk respond");
+    }
+    // 以实际收到的数据为准
+    respond->set_read_length(data_length);
+    return OkStatus();
+}
+
+}  // namespace grpc_client
+}  // namespace dfs
@@ -0,0 +1,38 @@
+#ifndef DFS_GRPC_CLIENT_CHUNK_DATA_CODEC_H
+#define DFS_GRPC_CLIENT_CHUNK_DATA_CODEC_H
+
+#include <google/protobuf/stubs/statusor.h>
+#include <grpcpp/support/byte_buffer.h>
+
+#include <string>
+
+#include "chunk_server_file_service.pb.h"
+
+namespace dfs {
+namespace grpc_client {
+
+/**
+ * 数据块读写请求的手写序列化，data 字段不经过 std::string
+ * 1. 发送数据时 data 字段直接引用调用者的内存，只序列化很小的字段头，
+ *    多个副本的请求共享同一块内存
+ * 2. 读取数据时 data 字段从接收到的 grpc 缓冲区直接复制到调用者的内存，
+ *    其余字段按 protobuf 正常解析
+ * 与 protobuf 的编码完全兼容，服务端不需要修改
+ */
+
+// 将 SendChunkDataRequest 编码为 ByteBuffer，data 不会被复制，
+// 在请求完成之前调用者需保持 data 有效
+grpc::ByteBuffer SerializeSendChunkDataRequest(const std::string& checksum,
+                                               const char* data,
+                                               size_t nbytes);
+
+// 解析 ReadFileChunkRespond，data 字段写入 buffer，超过 capacity 时返回
+// OutOfRange。respond 中的 data 为空，read_length 为写入 buffer 的字节数
+google::protobuf::util::Status ParseReadFileChunkRespond(
+    grpc::ByteBuffer* byte_buffer, char* buffer, size_t capacity,
+    protos::grpc::ReadFileChunkRespond* respond);
+
+}  // namespace grpc_client
+}  // namespace dfs
+
+#endif  // DFS_GRPC_CLIENT_CHUNK_DATA_CODEC_H
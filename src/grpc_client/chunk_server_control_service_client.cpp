@@ -1,14 +1,20 @@
 #include "src/grpc_client/chunk_server_control_service_client.h"
 
+#include "src/common/tracing.h"
+
 namespace dfs {
 namespace grpc_client {
 
+using dfs::common::Span;
+
 google::protobuf::util::Status ChunkServerControlServiceClient::SendHeartBeat(
     const protos::grpc::SendHeartBeatRequest& request) {
     grpc::ClientContext context;
     protos::grpc::SendHeartBeatRespond respond;
 
+    Span span("SendHeartBeat", &context);
     auto status = stub_->SendHeartBeat(&context, request, &respond);
+    span.SetStatus(status);
     if (!status.ok()) {
         return google::protobuf::util::UnknownError(status.error_message());
     }
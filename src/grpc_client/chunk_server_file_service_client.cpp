@@ -1,10 +1,13 @@
 #include "src/grpc_client/chunk_server_file_service_client.h"
 
+#include "src/common/tracing.h"
 #include "src/common/utils.h"
+#include "src/grpc_client/chunk_data_codec.h"
 
 namespace dfs {
 namespace grpc_client {
 
+using dfs::common::Span;
 using dfs::common::StatusGrpc2Protobuf;
 using protos::grpc::AdjustFileChunkVersionRespond;
 using protos::grpc::ApplyMutationRespond;
@@ -14,13 +17,27 @@ using protos::grpc::SendChunkDataRespond;
 using protos::grpc::WriteFileChunkRespond;
 using protos::grpc::ApplyChunkReplicaCopyRespond;
 using protos::grpc::ChunkReplicaCopyRespond;
+using protos::grpc::EncodeStripeRespond;
+using protos::grpc::ReconstructChunkRespond;
+
+namespace {
+
+const char kReadFileChunkMethod[] =
+    "/protos.grpc.ChunkServerFileService/ReadFileChunk";
+
+const char kSendChunkDataMethod[] =
+    "/protos.grpc.ChunkServerFileService/SendChunkData";
+
+}  // namespace
 
 google::protobuf::util::StatusOr<protos::grpc::InitFileChunkRespond>
 ChunkServerFileServiceClient::SendRequest(
     const protos::grpc::InitFileChunkRequest& request) {
     grpc::ClientContext context;
     InitFileChunkRespond respond;
+    Span span("InitFileChunk", &context);
     auto status = stub_->InitFileChunk(&context, request, &respond);
+    span.SetStatus(status);
     if (status.ok()) {
         return respond;
     }
@@ -32,19 +49,74 @@ ChunkServerFileServiceClient::SendRequest(
     const protos::grpc::ReadFileChunkRequest& request) {
     grpc::ClientContext context;
     ReadFileChunkRespond respond;
+    Span span("ReadFileChunk", &context);
     auto status = stub_->ReadFileChunk(&context, request, &respond);
+    span.SetStatus(status);
+    if (status.ok()) {
+        return respond;
+    }
+    return StatusGrpc2Protobuf(status);
+}
+
+google::protobuf::util::StatusOr<protos::grpc::ReadFileChunkRespond>
+ChunkServerFileServiceClient::SendRequest(
+    const protos::grpc::ReadFileChunkRequest& request,
+    grpc::ClientContext* context) {
+    ReadFileChunkRespond respond;
+    Span span("ReadFileChunk", context);
+    auto status = stub_->ReadFileChunk(context, request, &respond);
+    span.SetStatus(status);
     if (status.ok()) {
         return respond;
     }
     return StatusGrpc2Protobuf(status);
 }
 
+google::protobuf::util::StatusOr<protos::grpc::ReadFileChunkRespond>
+ChunkServerFileServiceClient::SendRequest(
+    const protos::grpc::ReadFileChunkRequest& request,
+    grpc::ClientContext* context, char* buffer) {
+    grpc::Slice request_slice(request.SerializeAsString());
+    grpc::ByteBuffer request_buffer(&request_slice, 1);
+    grpc::ByteBuffer respond_buffer;
+    Span span("ReadFileChunk", context);
+    auto status = GenericUnaryCall(context, kReadFileChunkMethod,
+                                   request_buffer, &respond_buffer);
+    span.SetStatus(status);
+    if (!status.ok()) {
+        return StatusGrpc2Protobuf(status);
+    }
+
+    ReadFileChunkRespond respond;
+    auto parse_status = ParseReadFileChunkRespond(
+        &respond_buffer, buffer, request.length(), &respond);
+    if (!parse_status.ok()) {
+        return parse_status;
+    }
+    return respond;
+}
+
+void ChunkServerFileServiceClient::AsyncReadFileChunk(
+    const protos::grpc::ReadFileChunkRequest& request,
+    grpc::ClientContext* context, grpc::ByteBuffer* respond,
+    grpc::Status* status, grpc::CompletionQueue* cq, void* tag) {
+    grpc::Slice request_slice(request.SerializeAsString());
+    grpc::ByteBuffer request_buffer(&request_slice, 1);
+    // reader 分配在 call 的 arena 上，随 call 一起释放
+    auto call = generic_stub_->PrepareUnaryCall(context, kReadFileChunkMethod,
+                                                request_buffer, cq);
+    call->StartCall();
+    call->Finish(respond, status, tag);
+}
+
 google::protobuf::util::StatusOr<protos::grpc::WriteFileChunkRespond>
 ChunkServerFileServiceClient::SendRequest(
     const protos::grpc::WriteFileChunkRequest& request) {
     grpc::ClientContext context;
     WriteFileChunkRespond respond;
+    Span span("WriteFileChunk", &context);
     auto status = stub_->WriteFileChunk(&context, request, &respond);
+    span.SetStatus(status);
     if (status.ok()) {
         return respond;
     }
@@ -56,19 +128,47 @@ ChunkServerFileServiceClient::SendRequest(
     const protos::grpc::SendChunkDataRequest& request) {
     grpc::ClientContext context;
     SendChunkDataRespond respond;
+    Span span("SendChunkData", &context);
     auto status = stub_->SendChunkData(&context, request, &respond);
+    span.SetStatus(status);
     if (status.ok()) {
         return respond;
     }
     return StatusGrpc2Protobuf(status);
 }
 
+google::protobuf::util::StatusOr<protos::grpc::SendChunkDataRespond>
+ChunkServerFileServiceClient::SendChunkData(const std::string& checksum,
+                                            const char* data, size_t nbytes) {
+    grpc::ClientContext context;
+    auto request_buffer = SerializeSendChunkDataRequest(checksum, data, nbytes);
+    grpc::ByteBuffer respond_buffer;
+    Span span("SendChunkData", &context);
+    span.SetAttribute("bytes", nbytes);
+    auto status = GenericUnaryCall(&context, kSendChunkDataMethod,
+                                   request_buffer, &respond_buffer);
+    span.SetStatus(status);
+    if (!status.ok()) {
+        return StatusGrpc2Protobuf(status);
+    }
+
+    SendChunkDataRespond respond;
+    status = grpc::SerializationTraits<SendChunkDataRespond>::Deserialize(
+        &respond_buffer, &respond);
+    if (!status.ok()) {
+        return StatusGrpc2Protobuf(status);
+    }
+    return respond;
+}
+
 google::protobuf::util::StatusOr<protos::grpc::ApplyMutationRespond>
 ChunkServerFileServiceClient::SendRequest(
     const protos::grpc::ApplyMutationRequest& request) {
     grpc::ClientContext context;
     ApplyMutationRespond respond;
+    Span span("ApplyMutation", &context);
     auto status = stub_->ApplyMutation(&context, request, &respond);
+    span.SetStatus(status);
     if (status.ok()) {
         return respond;
     }
@@ -80,7 +180,9 @@ ChunkServerFileServiceClient::SendRequest(
     const protos::grpc::AdjustFileChunkVersionRequest& request) {
     grpc::ClientContext context;
     AdjustFileChunkVersionRespond respond;
+    Span span("AdjustFileChunkVersion", &context);
     auto status = stub_->AdjustFileChunkVersion(&context, request, &respond);
+    span.SetStatus(status);
     if (status.ok()) {
         return respond;
     }
@@ -92,7 +194,9 @@ ChunkServerFileServiceClient::SendRequest(
     const protos::grpc::ChunkReplicaCopyRequest& request) {
     grpc::ClientContext context;
     ChunkReplicaCopyRespond respond;
+    Span span("ChunkReplicaCopy", &context);
     auto status = stub_->ChunkReplicaCopy(&context, request, &respond);
+    span.SetStatus(status);
     if (status.ok()) {
         return respond;
     }
@@ -104,12 +208,68 @@ ChunkServerFileServiceClient::SendRequest(
     const protos::grpc::ApplyChunkReplicaCopyRequest& request) {
     grpc::ClientContext context;
     ApplyChunkReplicaCopyRespond respond;
+    Span span("ApplyChunkReplicaCopy", &context);
     auto status = stub_->ApplyChunkReplicaCopy(&context, request, &respond);
+    span.SetStatus(status);
+    if (status.ok()) {
+        return respond;
+    }
+    return StatusGrpc2Protobuf(status);
+}
+
+google::protobuf::util::StatusOr<protos::grpc::EncodeStripeRespond>
+ChunkServerFileServiceClient::SendRequest(
+    const protos::grpc::EncodeStripeRequest& request) {
+    grpc::ClientContext context;
+    EncodeStripeRespond respond;
+    Span span("EncodeStripe", &context);
+    auto status = stub_->EncodeStripe(&context, request, &respond);
+    span.SetStatus(status);
     if (status.ok()) {
         return respond;
     }
     return StatusGrpc2Protobuf(status);
 }
 
+google::protobuf::util::StatusOr<protos::grpc::ReconstructChunkRespond>
+ChunkServerFileServiceClient::SendRequest(
+    const protos::grpc::ReconstructChunkRequest& request) {
+    grpc::ClientContext context;
+    ReconstructChunkRespond respond;
+    Span span("ReconstructChunk", &context);
+    auto status = stub_->ReconstructChunk(&context, request, &respond);
+    span.SetStatus(status);
+    if (status.ok()) {
+        return respond;
+    }
+    return StatusGrpc2Protobuf(status);
+}
+
+std::unique_ptr<grpc::ClientReaderWriter<protos::grpc::ChunkReplicaCopyFrame,
+                                         protos::grpc::ChunkReplicaCopyAck>>
+ChunkServerFileServiceClient::StreamChunkReplicaCopy(
+    grpc::ClientContext* context) {
+    return stub_->StreamChunkReplicaCopy(context);
+}
+
+grpc::Status ChunkServerFileServiceClient::GenericUnaryCall(
+    grpc::ClientContext* context, const std::string& method,
+    const grpc::ByteBuffer& request, grpc::ByteBuffer* respond) {
+    grpc::CompletionQueue cq;
+    auto call = generic_stub_->PrepareUnaryCall(context, method, request, &cq);
+    call->StartCall();
+
+    grpc::Status status;
+    call->Finish(respond, &status, nullptr);
+    void* tag;
+    bool ok;
+    cq.Next(&tag, &ok);
+
+    cq.Shutdown();
+    while (cq.Next(&tag, &ok)) {
+    }
+    return status;
+}
+
 }  // namespace grpc_client
-}  // namespace dfs
\ No newline at end of file
+}  // namespace dfs
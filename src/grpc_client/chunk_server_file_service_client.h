@@ -2,9 +2,11 @@
 #define DFS_GRPC_CLIENT_CHUNK_SERVER_FILE_SERVICE_CLIENT_H
 
 #include <google/protobuf/stubs/statusor.h>
+#include <grpcpp/generic/generic_stub.h>
 #include <grpcpp/grpcpp.h>
 
 #include <memory>
+#include <string>
 
 #include "chunk_server_file_service.grpc.pb.h"
 
@@ -14,7 +16,8 @@ namespace grpc_client {
 class ChunkServerFileServiceClient {
    public:
     ChunkServerFileServiceClient(std::shared_ptr<grpc::Channel> channel)
-        : stub_(protos::grpc::ChunkServerFileService::NewStub(channel)) {}
+        : stub_(protos::grpc::ChunkServerFileService::NewStub(channel)),
+          generic_stub_(std::make_unique<grpc::GenericStub>(channel)) {}
 
     google::protobuf::util::StatusOr<protos::grpc::InitFileChunkRespond>
     SendRequest(const protos::grpc::InitFileChunkRequest& request);
@@ -22,12 +25,37 @@ class ChunkServerFileServiceClient {
     google::protobuf::util::StatusOr<protos::grpc::ReadFileChunkRespond>
     SendRequest(const protos::grpc::ReadFileChunkRequest& request);
 
+    // 使用调用者提供的 context，调用者可以设置超时或者在其他线程中取消请求
+    google::protobuf::util::StatusOr<protos::grpc::ReadFileChunkRespond>
+    SendRequest(const protos::grpc::ReadFileChunkRequest& request,
+                grpc::ClientContext* context);
+
+    // 读取的数据直接写入 buffer（至少 request.length() 字节），不经过
+    // std::string。返回的 respond 中 data 为空，read_length 为写入的字节数
+    google::protobuf::util::StatusOr<protos::grpc::ReadFileChunkRespond>
+    SendRequest(const protos::grpc::ReadFileChunkRequest& request,
+                grpc::ClientContext* context, char* buffer);
+
+    // 异步读取，不阻塞调用线程，完成后 tag 出现在 cq 中。respond 为未解析
+    // 的回复，使用 ParseReadFileChunkRespond 解析。context、respond、status
+    // 需在完成前保持有效，可以通过 context 取消请求。
+    // span 由调用者在 context 上创建
+    void AsyncReadFileChunk(const protos::grpc::ReadFileChunkRequest& request,
+                            grpc::ClientContext* context,
+                            grpc::ByteBuffer* respond, grpc::Status* status,
+                            grpc::CompletionQueue* cq, void* tag);
+
     google::protobuf::util::StatusOr<protos::grpc::WriteFileChunkRespond>
     SendRequest(const protos::grpc::WriteFileChunkRequest& request);
 
     google::protobuf::util::StatusOr<protos::grpc::SendChunkDataRespond>
     SendRequest(const protos::grpc::SendChunkDataRequest& request);
 
+    // 发送数据时直接引用 data，不复制，请求返回前 data 需保持有效
+    google::protobuf::util::StatusOr<protos::grpc::SendChunkDataRespond>
+    SendChunkData(const std::string& checksum, const char* data,
+                  size_t nbytes);
+
     google::protobuf::util::StatusOr<protos::grpc::ApplyMutationRespond>
     SendRequest(const protos::grpc::ApplyMutationRequest& request);
 
@@ -40,8 +68,29 @@ class ChunkServerFileServiceClient {
     google::protobuf::util::StatusOr<protos::grpc::ApplyChunkReplicaCopyRespond>
     SendRequest(const protos::grpc::ApplyChunkReplicaCopyRequest& request);
 
+    google::protobuf::util::StatusOr<protos::grpc::EncodeStripeRespond>
+    SendRequest(const protos::grpc::EncodeStripeRequest& request);
+
+    google::protobuf::util::StatusOr<protos::grpc::ReconstructChunkRespond>
+    SendRequest(const protos::grpc::ReconstructChunkRequest& request);
+
+    // 打开流式复制数据块的双向流，context 的生命周期需长于返回的流。
+    // 流的 span 由调用者在 context 上创建
+    std::unique_ptr<grpc::ClientReaderWriter<protos::grpc::ChunkReplicaCopyFrame,
+                                             protos::grpc::ChunkReplicaCopyAck>>
+    StreamChunkReplicaCopy(grpc::ClientContext* context);
+
    private:
+    // 以 ByteBuffer 发送一元请求并等待返回
+    grpc::Status GenericUnaryCall(grpc::ClientContext* context,
+                                  const std::string& method,
+                                  const grpc::ByteBuffer& request,
+                                  grpc::ByteBuffer* respond);
+
     std::unique_ptr<protos::grpc::ChunkServerFileService::Stub> stub_;
+
+    // 自行序列化 data 字段的请求使用
+    std::unique_ptr<grpc::GenericStub> generic_stub_;
 };
 
 }  // namespace grpc_client
@@ -1,10 +1,12 @@
 #include "src/grpc_client/chunk_server_lease_service_client.h"
 
+#include "src/common/tracing.h"
 #include "src/common/utils.h"
 
 namespace dfs {
 namespace grpc_client {
 
+using dfs::common::Span;
 using dfs::common::StatusGrpc2Protobuf;
 using protos::grpc::GrantLeaseRespond;
 using protos::grpc::RevokeLeaseRespond;
@@ -14,7 +16,9 @@ ChunkServerLeaseServiceClient::SendRequest(
     const protos::grpc::GrantLeaseRequest& request) {
     grpc::ClientContext context;
     GrantLeaseRespond respond;
+    Span span("GrantLease", &context);
     auto status = stub_->GrantLease(&context, request, &respond);
+    span.SetStatus(status);
     if (status.ok()) {
         return respond;
     }
@@ -26,7 +30,9 @@ ChunkServerLeaseServiceClient::SendRequest(
     const protos::grpc::RevokeLeaseRequest& request) {
     grpc::ClientContext context;
     RevokeLeaseRespond respond;
+    Span span("RevokeLease", &context);
     auto status = stub_->RevokeLease(&context, request, &respond);
+    span.SetStatus(status);
     if (status.ok()) {
         return respond;
     }
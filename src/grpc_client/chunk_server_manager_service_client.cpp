@@ -1,10 +1,12 @@
 #include "src/grpc_client/chunk_server_manager_service_client.h"
 
+#include "src/common/tracing.h"
 #include "src/common/utils.h"
 
 namespace dfs {
 namespace grpc_client {
 
+using dfs::common::Span;
 using dfs::common::StatusGrpc2Protobuf;
 using protos::grpc::ReportChunkServerRespond;
 
@@ -13,7 +15,9 @@ ChunkServerManagerServiceClient::SendRequest(
     const protos::grpc::ReportChunkServerRequest& request) {
     grpc::ClientContext context;
     ReportChunkServerRespond respond;
+    Span span("ReportChunkServer", &context);
     auto status = stub_->ReportChunkServer(&context, request, &respond);
+    span.SetStatus(status);
     if (!status.ok()) {
         return StatusGrpc2Protobuf(status);
     }
@@ -1,10 +1,12 @@
 #include "src/grpc_client/master_metadata_service_client.h"
 
+#include "src/common/tracing.h"
 #include "src/common/utils.h"
 
 namespace dfs {
 namespace grpc_client {
 
+using dfs::common::Span;
 using dfs::common::StatusGrpc2Protobuf;
 using protos::grpc::OpenFileRespond;
 
@@ -14,7 +16,9 @@ MasterMetadataServiceClient::SendRequest(
     grpc::ClientContext context;
     OpenFileRespond respond;
 
+    Span span("OpenFile", &context);
     auto status = stub_->OpenFile(&context, request, &respond);
+    span.SetStatus(status);
     if (!status.ok()) {
         return StatusGrpc2Protobuf(status);
     }
@@ -26,7 +30,19 @@ google::protobuf::util::Status MasterMetadataServiceClient::SendRequest(
     const protos::grpc::DeleteFileRequest& request) {
     grpc::ClientContext context;
     google::protobuf::Empty respond;
+    Span span("DeleteFile", &context);
     auto status = stub_->DeleteFile(&context, request, &respond);
+    span.SetStatus(status);
+    return StatusGrpc2Protobuf(status);
+}
+
+google::protobuf::util::Status MasterMetadataServiceClient::SendRequest(
+    const protos::grpc::SetStorageClassRequest& request) {
+    grpc::ClientContext context;
+    google::protobuf::Empty respond;
+    Span span("SetStorageClass", &context);
+    auto status = stub_->SetStorageClass(&context, request, &respond);
+    span.SetStatus(status);
     return StatusGrpc2Protobuf(status);
 }
 
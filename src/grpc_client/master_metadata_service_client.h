@@ -21,6 +21,9 @@ class MasterMetadataServiceClient {
     google::protobuf::util::Status SendRequest(
         const protos::grpc::DeleteFileRequest& request);
 
+    google::protobuf::util::Status SendRequest(
+        const protos::grpc::SetStorageClassRequest& request);
+
    private:
     std::unique_ptr<protos::grpc::MasterMetadataService::Stub> stub_;
 };
@@ -0,0 +1,246 @@
+#include "src/server/chunk_server/chunk_block_cache.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace dfs {
+namespace server {
+
+ChunkBlockCache::ChunkBlockCache(const Options& options) : options_(options) {
+    options_.block_size = std::max<uint64_t>(options_.block_size, 1);
+    options_.in_ratio = std::clamp(options_.in_ratio, 0.0, 1.0);
+    options_.out_ratio = std::max(options_.out_ratio, 0.0);
+}
+
+std::vector<ChunkBlockCache::BlockLookup> ChunkBlockCache::Lookup(
+    const std::string& chunk_handle, const uint32_t& version,
+    const uint64_t& first_block, const uint64_t& last_block) {
+    std::vector<BlockLookup> lookups;
+    absl::MutexLock lock_guard(&lock_);
+    for (uint64_t block_index = first_block; block_index <= last_block;
+         block_index++) {
+        BlockKey key(chunk_handle, version, block_index);
+        BlockLookup lookup;
+
+        auto iter = blocks_.find(key);
+        if (iter != blocks_.end()) {
+            hits_++;
+            // A1in 中的分块命中时不调整位置，只有 Am 按 LRU 排序
+            auto& block = iter->second;
+            if (block.hot) {
+                hot_queue_.splice(hot_queue_.begin(), hot_queue_,
+                                  block.queue_iter);
+            }
+            lookup.data = block.data;
+            const bool last = lookup.data->size() < options_.block_size;
+            lookups.push_back(std::move(lookup));
+            if (last) {
+                break;
+            }
+            continue;
+        }
+
+        auto pending_iter = pending_blocks_.find(key);
+        if (pending_iter != pending_blocks_.end()) {
+            coalesced_loads_++;
+            lookup.pending = pending_iter->second;
+        } else {
+            misses_++;
+            lookup.pending = std::make_shared<PendingBlock>();
+            lookup.pending->generation =
+                generations_[GetGenerationSlot(chunk_handle)];
+            lookup.load = true;
+            pending_blocks_.emplace(std::move(key), lookup.pending);
+        }
+        lookups.push_back(std::move(lookup));
+    }
+    return lookups;
+}
+
+void ChunkBlockCache::FinishLoad(const std::string& chunk_handle,
+                                 const uint32_t& version,
+                                 const uint64_t& block_index,
+                                 const std::shared_ptr<PendingBlock>& pending,
+                                 std::shared_ptr<const std::string> data) {
+    {
+        absl::MutexLock lock_guard(&lock_);
+        BlockKey key(chunk_handle, version, block_index);
+        // 分块失效时已经从 pending_blocks_ 中移除，之后的查找会重新读取
+        auto iter = pending_blocks_.find(key);
+        if (iter != pending_blocks_.end() && iter->second == pending) {
+            pending_blocks_.erase(iter);
+        }
+
+        // 读取期间数据块被修改过，读到的数据可能已经过期
+        if (data && !data->empty() &&
+            data->size() <= options_.capacity_bytes &&
+            generations_[GetGenerationSlot(chunk_handle)] ==
+                pending->generation) {
+            Insert(std::move(key), data);
+        }
+    }
+
+    pending->data = std::move(data);
+    pending->done.Notify();
+}
+
+std::shared_ptr<const std::string> ChunkBlockCache::WaitLoad(
+    const std::shared_ptr<PendingBlock>& pending) {
+    pending->done.WaitForNotification();
+    return pending->data;
+}
+
+void ChunkBlockCache::Erase(const std::string& chunk_handle,
+                            const uint64_t& first_block,
+                            const uint64_t& last_block) {
+    absl::MutexLock lock_guard(&lock_);
+    generations_[GetGenerationSlot(chunk_handle)]++;
+
+    const BlockKey begin(chunk_handle, 0, 0);
+    auto in_range = [&](const BlockKey& key) {
+        return std::get<2>(key) >= first_block && std::get<2>(key) <= last_block;
+    };
+    for (auto iter = blocks_.lower_bound(begin);
+         iter != blocks_.end() && std::get<0>(iter->first) == chunk_handle;) {
+        iter = in_range(iter->first) ? RemoveBlock(iter) : std::next(iter);
+    }
+    // 正在读取的分块由读取者完成，之后的查找不再等待它
+    for (auto iter = pending_blocks_.lower_bound(begin);
+         iter != pending_blocks_.end() &&
+         std::get<0>(iter->first) == chunk_handle;) {
+        iter = in_range(iter->first) ? pending_blocks_.erase(iter)
+                                     : std::next(iter);
+    }
+}
+
+void ChunkBlockCache::Erase(const std::string& chunk_handle) {
+    Erase(chunk_handle, 0, UINT64_MAX);
+}
+
+void ChunkBlockCache::Clear() {
+    absl::MutexLock lock_guard(&lock_);
+    for (auto& generation : generations_) {
+        generation++;
+    }
+    blocks_.clear();
+    pending_blocks_.clear();
+    in_queue_.clear();
+    hot_queue_.clear();
+    ghost_queue_.clear();
+    ghosts_.clear();
+    in_bytes_ = 0;
+    hot_bytes_ = 0;
+    ghost_bytes_ = 0;
+}
+
+uint64_t ChunkBlockCache::GetHits() {
+    absl::MutexLock lock_guard(&lock_);
+    return hits_;
+}
+
+uint64_t ChunkBlockCache::GetMisses() {
+    absl::MutexLock lock_guard(&lock_);
+    return misses_;
+}
+
+uint64_t ChunkBlockCache::GetCoalescedLoads() {
+    absl::MutexLock lock_guard(&lock_);
+    return coalesced_loads_;
+}
+
+double ChunkBlockCache::GetHitRate() {
+    absl::MutexLock lock_guard(&lock_);
+    const uint64_t lookups = hits_ + misses_ + coalesced_loads_;
+    return lookups ? static_cast<double>(hits_) / lookups : 0;
+}
+
+uint64_t ChunkBlockCache::GetResidentBytes() {
+    absl::MutexLock lock_guard(&lock_);
+    return in_bytes_ + hot_bytes_;
+}
+
+size_t ChunkBlockCache::GetBlockNums() {
+    absl::MutexLock lock_guard(&lock_);
+    return blocks_.size();
+}
+
+size_t ChunkBlockCache::GetGenerationSlot(const std::string& chunk_handle) {
+    return std::hash<std::string>()(chunk_handle) % kGenerationSlots;
+}
+
+void ChunkBlockCache::Insert(BlockKey key,
+                             std::shared_ptr<const std::string> data) {
+    auto iter = blocks_.find(key);
+    if (iter != blocks_.end()) {
+        RemoveBlock(iter);
+    }
+
+    Block block;
+    block.data = std::move(data);
+    // 最近被淘汰过又再次读取，说明是热点数据
+    auto ghost_iter = ghosts_.find(key);
+    if (ghost_iter != ghosts_.end()) {
+        RemoveGhost(ghost_iter);
+        block.hot = true;
+        hot_queue_.push_front(key);
+        block.queue_iter = hot_queue_.begin();
+        hot_bytes_ += block.data->size();
+    } else {
+        in_queue_.push_front(key);
+        block.queue_iter = in_queue_.begin();
+        in_bytes_ += block.data->size();
+    }
+    blocks_.emplace(std::move(key), std::move(block));
+    Evict();
+}
+
+std::map<ChunkBlockCache::BlockKey, ChunkBlockCache::Block>::iterator
+ChunkBlockCache::RemoveBlock(std::map<BlockKey, Block>::iterator iter) {
+    auto& block = iter->second;
+    if (block.hot) {
+        hot_bytes_ -= block.data->size();
+        hot_queue_.erase(block.queue_iter);
+    } else {
+        in_bytes_ -= block.data->size();
+        in_queue_.erase(block.queue_iter);
+    }
+    return blocks_.erase(iter);
+}
+
+void ChunkBlockCache::RemoveGhost(
+    std::map<BlockKey, GhostBlock>::iterator iter) {
+    ghost_bytes_ -= iter->second.bytes;
+    ghost_queue_.erase(iter->second.queue_iter);
+    ghosts_.erase(iter);
+}
+
+void ChunkBlockCache::Evict() {
+    const uint64_t max_in_bytes = options_.capacity_bytes * options_.in_ratio;
+    const uint64_t max_ghost_bytes =
+        options_.capacity_bytes * options_.out_ratio;
+
+    while (in_bytes_ + hot_bytes_ > options_.capacity_bytes) {
+        if (in_bytes_ > max_in_bytes || hot_queue_.empty()) {
+            // A1in 超过配额，淘汰最早进入的分块，记录到 A1out
+            auto iter = blocks_.find(in_queue_.back());
+            const uint64_t bytes = iter->second.data->size();
+            BlockKey key = iter->first;
+            RemoveBlock(iter);
+
+            if (max_ghost_bytes > 0) {
+                ghost_queue_.push_front(key);
+                ghost_bytes_ += bytes;
+                ghosts_[std::move(key)] = {bytes, ghost_queue_.begin()};
+            }
+        } else {
+            RemoveBlock(blocks_.find(hot_queue_.back()));
+        }
+    }
+
+    while (ghost_bytes_ > max_ghost_bytes) {
+        RemoveGhost(ghosts_.find(ghost_queue_.back()));
+    }
+}
+
+}  // namespace server
+}  // namespace dfs
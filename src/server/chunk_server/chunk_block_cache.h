@@ -0,0 +1,186 @@
+#ifndef DFS_SERVER_CHUNK_SERVER_CHUNK_BLOCK_CACHE_H
+#define DFS_SERVER_CHUNK_SERVER_CHUNK_BLOCK_CACHE_H
+
+#include <absl/synchronization/mutex.h>
+#include <absl/synchronization/notification.h>
+
+#include <array>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace dfs {
+namespace server {
+
+/**
+ * 块服务器的数据块读缓存，缓存最近读取的分块，按 (chunk_handle, version, block)
+ * 索引，使用 2Q 算法淘汰
+ * 1. 第一次读取的分块进入 A1in 队列（FIFO），A1in 占用的内存不超过总量的
+ *    in_ratio，顺序扫描读取的分块只会经过 A1in，不会挤掉热点数据
+ * 2. 从 A1in 淘汰的分块只保留 key，记录在 A1out 中，之后再次读取时
+ *    说明是热点数据，放入 Am 队列（LRU）
+ * 3. 缓存的数据总量不超过 capacity_bytes，命中时不需要任何系统调用
+ * 4. 同一个分块同时只有一个线程从磁盘读取，其他未命中的线程等待它的结果
+ * 5. 写入、删除数据块以及版本号变化时使对应的分块失效，
+ *    失效前开始的读取不会写入缓存
+ */
+class ChunkBlockCache {
+   public:
+    struct Options {
+        // 缓存数据的字节数上限，为 0 时不缓存
+        uint64_t capacity_bytes = 256 * 1024 * 1024;
+        // 分块大小，只有数据块的最后一个分块会比它短
+        uint64_t block_size = 64 * 1024;
+        // A1in 队列占用的内存比例
+        double in_ratio = 0.25;
+        // A1out 记录的被淘汰分块的字节数之和，相对 capacity_bytes 的比例
+        double out_ratio = 0.5;
+    };
+
+    // 正在从磁盘读取的分块
+    struct PendingBlock {
+        absl::Notification done;
+        // 读取失败时为 nullptr
+        std::shared_ptr<const std::string> data;
+        // 开始读取时数据块的失效代数
+        uint64_t generation = 0;
+    };
+
+    // 一个分块的查找结果，为以下三种之一：
+    // 1. data 不为空，命中缓存
+    // 2. pending 不为空且 load 为 true，由调用者读取该分块，读取后调用
+    //    FinishLoad，读取失败时也需要调用
+    // 3. pending 不为空且 load 为 false，其他线程正在读取，调用 WaitLoad
+    struct BlockLookup {
+        std::shared_ptr<const std::string> data;
+        std::shared_ptr<PendingBlock> pending;
+        bool load = false;
+    };
+
+    explicit ChunkBlockCache(const Options& options);
+
+    // 查找数据块 version 版本的 [first_block, last_block] 范围内的分块，
+    // 遇到比 block_size 短的分块（数据块的最后一个分块）时停止
+    std::vector<BlockLookup> Lookup(const std::string& chunk_handle,
+                                    const uint32_t& version,
+                                    const uint64_t& first_block,
+                                    const uint64_t& last_block);
+
+    // 完成一个分块的读取，data 为 nullptr 表示读取失败。读取期间数据块
+    // 没有失效时将分块放入缓存，并唤醒等待的线程
+    void FinishLoad(const std::string& chunk_handle, const uint32_t& version,
+                    const uint64_t& block_index,
+                    const std::shared_ptr<PendingBlock>& pending,
+                    std::shared_ptr<const std::string> data);
+
+    // 等待其他线程读取分块，读取失败时返回 nullptr
+    static std::shared_ptr<const std::string> WaitLoad(
+        const std::shared_ptr<PendingBlock>& pending);
+
+    // 使数据块所有版本 [first_block, last_block] 范围内的分块失效
+    void Erase(const std::string& chunk_handle, const uint64_t& first_block,
+               const uint64_t& last_block);
+
+    // 使数据块的所有分块失效
+    void Erase(const std::string& chunk_handle);
+
+    void Clear();
+
+    // 命中缓存的分块查找次数
+    uint64_t GetHits();
+
+    // 从磁盘读取的分块查找次数
+    uint64_t GetMisses();
+
+    // 等待其他线程读取同一分块的查找次数
+    uint64_t GetCoalescedLoads();
+
+    // 命中率，没有查找过时返回 0
+    double GetHitRate();
+
+    // 缓存中数据的字节数
+    uint64_t GetResidentBytes();
+
+    // 缓存的分块数量
+    size_t GetBlockNums();
+
+    uint64_t block_size() const { return options_.block_size; }
+
+   private:
+    // 记录失效代数的槽数量，数据块按句柄的哈希值映射到槽
+    static constexpr size_t kGenerationSlots = 64;
+
+    // <chunk_handle, version, block_index>
+    using BlockKey = std::tuple<std::string, uint32_t, uint64_t>;
+
+    struct Block {
+        std::shared_ptr<const std::string> data;
+        // 是否位于 Am 队列，否则位于 A1in 队列
+        bool hot = false;
+        std::list<BlockKey>::iterator queue_iter;
+    };
+
+    struct GhostBlock {
+        uint64_t bytes;
+        std::list<BlockKey>::iterator queue_iter;
+    };
+
+    static size_t GetGenerationSlot(const std::string& chunk_handle);
+
+    // 以下方法调用时需持有 lock_
+    // 缓存一个分块
+    void Insert(BlockKey key, std::shared_ptr<const std::string> data);
+
+    // 从所在队列中移除分块
+    std::map<BlockKey, Block>::iterator RemoveBlock(
+        std::map<BlockKey, Block>::iterator iter);
+
+    void RemoveGhost(std::map<BlockKey, GhostBlock>::iterator iter);
+
+    // 淘汰分块直到数据总量不超过上限
+    void Evict();
+
+    Options options_;
+
+    absl::Mutex lock_;
+
+    // 缓存中的分块，按句柄排序，方便使一个数据块的所有分块失效
+    std::map<BlockKey, Block> blocks_;
+
+    // 正在从磁盘读取的分块
+    std::map<BlockKey, std::shared_ptr<PendingBlock>> pending_blocks_;
+
+    // 队首为最近进入的分块
+    std::list<BlockKey> in_queue_;
+
+    // 队首为最近使用的分块
+    std::list<BlockKey> hot_queue_;
+
+    // A1out，只记录被淘汰分块的 key，队首为最近淘汰的分块
+    std::list<BlockKey> ghost_queue_;
+
+    std::map<BlockKey, GhostBlock> ghosts_;
+
+    uint64_t in_bytes_ = 0;
+
+    uint64_t hot_bytes_ = 0;
+
+    uint64_t ghost_bytes_ = 0;
+
+    std::array<uint64_t, kGenerationSlots> generations_{};
+
+    uint64_t hits_ = 0;
+
+    uint64_t misses_ = 0;
+
+    uint64_t coalesced_loads_ = 0;
+};
+
+}  // namespace server
+}  // namespace dfs
+
+#endif  // DFS_SERVER_CHUNK_SERVER_CHUNK_BLOCK_CACHE_H
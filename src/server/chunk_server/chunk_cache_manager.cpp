@@ -6,6 +6,18 @@ namespace server {
 using google::protobuf::util::NotFoundError;
 using google::protobuf::util::OkStatus;
 
+ChunkCacheManager::ChunkCacheManager() {
+    auto registry = common::MetricsRegistry::GetInstance();
+    hits_ = registry->GetCounter("dfs_chunk_data_cache_hits_total",
+                                 "Pushed data found in the data cache");
+    misses_ = registry->GetCounter("dfs_chunk_data_cache_misses_total",
+                                   "Pushed data missing from the data cache");
+    registry->AddCallback(
+        "dfs_chunk_data_cache_bytes", "Bytes of pushed data in the data cache",
+        common::MetricType::GAUGE, {},
+        [this]() { return static_cast<double>(GetCachedBytes()); });
+}
+
 ChunkCacheManager* ChunkCacheManager::GetInstance() {
     static ChunkCacheManager* instance = new ChunkCacheManager();
     return instance;
@@ -13,25 +25,42 @@ ChunkCacheManager* ChunkCacheManager::GetInstance() {
 
 google::protobuf::util::StatusOr<std::string> ChunkCacheManager::Get(
     const std::string& key) {
-    auto value_pair = cache_.TryGet(key);
-    if (!value_pair.second) {
+    absl::ReaderMutexLock lock_guard(&lock_);
+    auto iter = cache_.find(key);
+    if (iter == cache_.end()) {
+        misses_->Increment();
         return NotFoundError("key nou found: " + key);
     }
 
-    return value_pair.first;
+    hits_->Increment();
+    return iter->second;
 }
 
 google::protobuf::util::Status ChunkCacheManager::Set(
     const std::string& key, const std::string& value) {
-    cache_.Set(key, value);
+    absl::WriterMutexLock lock_guard(&lock_);
+    auto& cached_value = cache_[key];
+    cached_bytes_ -= cached_value.size();
+    cached_value = value;
+    cached_bytes_ += cached_value.size();
     return OkStatus();
 }
 
 google::protobuf::util::Status ChunkCacheManager::Remove(
     const std::string& key) {
-    cache_.Erase(key);
+    absl::WriterMutexLock lock_guard(&lock_);
+    auto iter = cache_.find(key);
+    if (iter != cache_.end()) {
+        cached_bytes_ -= iter->second.size();
+        cache_.erase(iter);
+    }
     return OkStatus();
 }
 
+uint64_t ChunkCacheManager::GetCachedBytes() {
+    absl::ReaderMutexLock lock_guard(&lock_);
+    return cached_bytes_;
+}
+
 }  // namespace server
 }  // namespace dfs
\ No newline at end of file
@@ -1,9 +1,13 @@
 #ifndef DFS_SERVER_CHUNK_CACHE_MANAGER_H
 #define DFS_SERVER_CHUNK_CACHE_MANAGER_H
 
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
 #include <google/protobuf/stubs/statusor.h>
 
-#include "src/common/utils.h"
+#include <string>
+
+#include "src/common/metrics.h"
 
 namespace dfs {
 namespace server {
@@ -23,9 +27,19 @@ class ChunkCacheManager {
     // 从缓存中清除掉校验和对应的数据
     google::protobuf::util::Status Remove(const std::string& key);
 
+    // 缓存中数据的总字节数，随汇报发送给主服务器
+    uint64_t GetCachedBytes();
+
    private:
-    ChunkCacheManager() = default;
-    dfs::common::parallel_hash_map<std::string, std::string> cache_;
+    // 注册缓存命中与占用字节数的指标
+    ChunkCacheManager();
+
+    common::Counter* hits_;
+    common::Counter* misses_;
+
+    absl::Mutex lock_;
+    absl::flat_hash_map<std::string, std::string> cache_;
+    uint64_t cached_bytes_ = 0;
 };
 
 }  // namespace server
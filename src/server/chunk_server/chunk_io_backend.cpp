@@ -0,0 +1,638 @@
+#include "src/server/chunk_server/chunk_io_backend.h"
+
+#include <absl/synchronization/notification.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "src/common/executor.h"
+#include "src/common/system_logger.h"
+
+namespace dfs {
+namespace server {
+
+namespace {
+
+std::string ErrnoToString(const int& error) { return std::strerror(error); }
+
+// 在调用线程中执行一次 I/O
+int64_t ExecuteIo(const ChunkIoRequest& request) {
+    while (true) {
+        ssize_t result = 0;
+        switch (request.type) {
+            case ChunkIoRequest::READ:
+                result = pread(request.fd, request.buffer, request.length,
+                               request.offset);
+                break;
+            case ChunkIoRequest::WRITE:
+                result = pwrite(request.fd, request.buffer, request.length,
+                                request.offset);
+                break;
+            case ChunkIoRequest::FSYNC:
+                result = fsync(request.fd);
+                break;
+        }
+
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        return result < 0 ? -errno : result;
+    }
+}
+
+// 线程池后端，在线程中调用 pread/pwrite/fsync
+class ThreadPoolChunkIoBackend : public ChunkIoBackend {
+   public:
+    explicit ThreadPoolChunkIoBackend(const Options& options)
+        : ChunkIoBackend(options),
+          executor_("chunk_io", options.thread_nums, 0) {}
+
+    ~ThreadPoolChunkIoBackend() override { Shutdown(); }
+
+    const char* name() const override { return "thread_pool"; }
+
+    void Shutdown() override { executor_.Shutdown(); }
+
+   protected:
+    google::protobuf::util::Status SubmitBatch(
+        std::vector<std::unique_ptr<ChunkIoRequest>>* requests) override {
+        for (auto& request : *requests) {
+            auto raw_request = request.get();
+            if (!executor_.Submit([this, raw_request]() {
+                    std::unique_ptr<ChunkIoRequest> request(raw_request);
+                    const int64_t result = ExecuteIo(*request);
+                    Complete(std::move(request), result);
+                })) {
+                return google::protobuf::util::UnavailableError(
+                    "chunk io backend is shutdown");
+            }
+            request.release();
+        }
+        return google::protobuf::util::OkStatus();
+    }
+
+   private:
+    dfs::common::Executor executor_;
+};
+
+// io_uring 后端，直接使用系统调用，不依赖 liburing
+class IoUringChunkIoBackend : public ChunkIoBackend {
+   public:
+    explicit IoUringChunkIoBackend(const Options& options)
+        : ChunkIoBackend(options) {}
+
+    ~IoUringChunkIoBackend() override { Shutdown(); }
+
+    // 创建 io_uring 并启动完成线程，内核不支持时返回错误
+    google::protobuf::util::Status Initialize();
+
+    const char* name() const override { return "io_uring"; }
+
+    void Shutdown() override;
+
+   protected:
+    google::protobuf::util::Status SubmitBatch(
+        std::vector<std::unique_ptr<ChunkIoRequest>>* requests) override;
+
+   private:
+    // 检查内核是否支持用到的操作
+    bool ProbeOps();
+
+    // 将缓冲区注册到内核，失败时使用普通的读写操作
+    void RegisterBuffers();
+
+    // 将提交队列中的 I/O 提交给内核
+    google::protobuf::util::Status Enter(unsigned to_submit);
+
+    void RunCompletion();
+
+    int ring_fd_ = -1;
+
+    void* sq_ring_ = nullptr;
+
+    size_t sq_ring_size_ = 0;
+
+    void* cq_ring_ = nullptr;
+
+    size_t cq_ring_size_ = 0;
+
+    io_uring_sqe* sqes_ = nullptr;
+
+    size_t sqes_size_ = 0;
+
+    unsigned* sq_head_ = nullptr;
+
+    unsigned* sq_tail_ = nullptr;
+
+    unsigned* sq_mask_ = nullptr;
+
+    unsigned* sq_array_ = nullptr;
+
+    unsigned* cq_head_ = nullptr;
+
+    unsigned* cq_tail_ = nullptr;
+
+    unsigned* cq_mask_ = nullptr;
+
+    io_uring_cqe* cqes_ = nullptr;
+
+    bool buffers_registered_ = false;
+
+    // 保护提交队列
+    absl::Mutex submit_lock_;
+
+    std::thread completion_thread_;
+
+    bool shutdown_ = false;
+};
+
+google::protobuf::util::Status IoUringChunkIoBackend::Initialize() {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd_ = syscall(__NR_io_uring_setup, options_.queue_depth, &params);
+    if (ring_fd_ < 0) {
+        return google::protobuf::util::UnavailableError(
+            "io_uring_setup failed, " + ErrnoToString(errno));
+    }
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+        sq_ring_ = nullptr;
+        return google::protobuf::util::UnavailableError(
+            "mmap io_uring sq ring failed, " + ErrnoToString(errno));
+    }
+
+    if (single_mmap) {
+        cq_ring_ = sq_ring_;
+    } else {
+        cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring_fd_,
+                        IORING_OFF_CQ_RING);
+        if (cq_ring_ == MAP_FAILED) {
+            cq_ring_ = nullptr;
+            return google::protobuf::util::UnavailableError(
+                "mmap io_uring cq ring failed, " + ErrnoToString(errno));
+        }
+    }
+
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        return google::protobuf::util::UnavailableError(
+            "mmap io_uring sqes failed, " + ErrnoToString(errno));
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    auto sq_ring = static_cast<char*>(sq_ring_);
+    sq_head_ = reinterpret_cast<unsigned*>(sq_ring + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq_ring + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned*>(sq_ring + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq_ring + params.sq_off.array);
+
+    auto cq_ring = static_cast<char*>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq_ring + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq_ring + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned*>(cq_ring + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq_ring + params.cq_off.cqes);
+
+    if (!ProbeOps()) {
+        return google::protobuf::util::UnimplementedError(
+            "io_uring does not support read/write");
+    }
+
+    RegisterBuffers();
+    completion_thread_ = std::thread([this]() { RunCompletion(); });
+    return google::protobuf::util::OkStatus();
+}
+
+bool IoUringChunkIoBackend::ProbeOps() {
+    const size_t probe_size =
+        sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op);
+    std::unique_ptr<char[]> probe_buffer(new char[probe_size]());
+    auto probe = reinterpret_cast<io_uring_probe*>(probe_buffer.get());
+    if (syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_PROBE, probe,
+                256) < 0) {
+        return false;
+    }
+
+    for (auto op : {IORING_OP_READ, IORING_OP_WRITE, IORING_OP_FSYNC,
+                    IORING_OP_NOP}) {
+        if (op > probe->last_op ||
+            !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void IoUringChunkIoBackend::RegisterBuffers() {
+    if (buffers_.empty()) {
+        return;
+    }
+
+    std::vector<iovec> iovecs(buffers_.size());
+    for (size_t i = 0; i < buffers_.size(); i++) {
+        iovecs[i].iov_base = buffers_[i];
+        iovecs[i].iov_len = options_.buffer_size;
+    }
+
+    // 锁定内存的上限不够时注册失败，此时退回普通的读写操作
+    buffers_registered_ =
+        syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_BUFFERS,
+                iovecs.data(), iovecs.size()) == 0;
+    if (!buffers_registered_) {
+        LOG(WARNING) << "io_uring register buffers failed, "
+                     << ErrnoToString(errno);
+    }
+}
+
+google::protobuf::util::Status IoUringChunkIoBackend::SubmitBatch(
+    std::vector<std::unique_ptr<ChunkIoRequest>>* requests) {
+    absl::MutexLock lock_guard(&submit_lock_);
+    if (shutdown_) {
+        return google::protobuf::util::UnavailableError(
+            "chunk io backend is shutdown");
+    }
+
+    // 只有持有 submit_lock_ 的线程修改 sq_tail
+    unsigned tail = *sq_tail_;
+    for (auto& request : *requests) {
+        const unsigned index = tail & *sq_mask_;
+        io_uring_sqe* sqe = &sqes_[index];
+        memset(sqe, 0, sizeof(*sqe));
+
+        const bool fixed = buffers_registered_ && request->buffer_index >= 0;
+        switch (request->type) {
+            case ChunkIoRequest::READ:
+                sqe->opcode = fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+                break;
+            case ChunkIoRequest::WRITE:
+                sqe->opcode = fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+                break;
+            case ChunkIoRequest::FSYNC:
+                sqe->opcode = IORING_OP_FSYNC;
+                break;
+        }
+        sqe->fd = request->fd;
+        sqe->off = request->offset;
+        sqe->addr = reinterpret_cast<uint64_t>(request->buffer);
+        sqe->len = request->length;
+        if (fixed) {
+            sqe->buf_index = request->buffer_index;
+        }
+        sqe->user_data = reinterpret_cast<uint64_t>(request.release());
+
+        sq_array_[index] = index;
+        tail++;
+    }
+    __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+
+    auto status = Enter(requests->size());
+    if (!status.ok()) {
+        // 内核没有取走的请求留在提交队列中会在之后被提交，此时调用方已经
+        // 认为它们失败。撤回这些请求并交还给调用方，不会调用回调。
+        // 之前的批次都已经被内核全部取走，未取走的都是本批次末尾的请求
+        const unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+        const unsigned pending = tail - head;
+        const size_t first = requests->size() - pending;
+        for (unsigned i = 0; i < pending; i++) {
+            const io_uring_sqe& sqe = sqes_[(head + i) & *sq_mask_];
+            (*requests)[first + i].reset(
+                reinterpret_cast<ChunkIoRequest*>(sqe.user_data));
+        }
+        __atomic_store_n(sq_tail_, head, __ATOMIC_RELEASE);
+    }
+    return status;
+}
+
+google::protobuf::util::Status IoUringChunkIoBackend::Enter(
+    unsigned to_submit) {
+    while (to_submit > 0) {
+        const int submitted = syscall(__NR_io_uring_enter, ring_fd_, to_submit,
+                                      0, 0, nullptr, 0);
+        if (submitted < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                std::this_thread::yield();
+                continue;
+            }
+            return google::protobuf::util::InternalError(
+                "io_uring_enter failed, " + ErrnoToString(errno));
+        }
+        to_submit -= submitted;
+    }
+    return google::protobuf::util::OkStatus();
+}
+
+void IoUringChunkIoBackend::RunCompletion() {
+    bool stop = false;
+    while (!stop) {
+        const int ret = syscall(__NR_io_uring_enter, ring_fd_, 0, 1,
+                                IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (ret < 0 && errno != EINTR) {
+            LOG(ERROR) << "io_uring wait completion failed, "
+                       << ErrnoToString(errno);
+        }
+
+        unsigned head = *cq_head_;
+        const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            const io_uring_cqe cqe = cqes_[head & *cq_mask_];
+            head++;
+            // 先归还完成队列的位置，回调中可以继续提交 I/O
+            __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+
+            // user_data 为空的 NOP 表示关闭
+            if (!cqe.user_data) {
+                stop = true;
+                continue;
+            }
+            Complete(std::unique_ptr<ChunkIoRequest>(
+                         reinterpret_cast<ChunkIoRequest*>(cqe.user_data)),
+                     cqe.res);
+        }
+    }
+}
+
+void IoUringChunkIoBackend::Shutdown() {
+    if (ring_fd_ < 0) {
+        return;
+    }
+
+    if (completion_thread_.joinable()) {
+        // 拒绝新的 I/O，等待已经提交的 I/O 完成后通知完成线程退出
+        {
+            absl::MutexLock lock_guard(&submit_lock_);
+            shutdown_ = true;
+        }
+        WaitInflightOps();
+
+        absl::MutexLock lock_guard(&submit_lock_);
+        const unsigned tail = *sq_tail_;
+        const unsigned index = tail & *sq_mask_;
+        memset(&sqes_[index], 0, sizeof(io_uring_sqe));
+        sqes_[index].opcode = IORING_OP_NOP;
+        sq_array_[index] = index;
+        __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+        if (!Enter(1).ok()) {
+            LOG(ERROR) << "io_uring submit shutdown nop failed";
+        }
+    }
+    if (completion_thread_.joinable()) {
+        completion_thread_.join();
+    }
+
+    if (sqes_) {
+        munmap(sqes_, sqes_size_);
+    }
+    if (cq_ring_ && cq_ring_ != sq_ring_) {
+        munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_) {
+        munmap(sq_ring_, sq_ring_size_);
+    }
+    close(ring_fd_);
+    ring_fd_ = -1;
+}
+
+}  // namespace
+
+std::unique_ptr<ChunkIoBackend> ChunkIoBackend::Create(
+    const Options& options) {
+    if (!options.use_thread_pool) {
+        auto backend = std::make_unique<IoUringChunkIoBackend>(options);
+        auto status = backend->Initialize();
+        if (status.ok()) {
+            return backend;
+        }
+        LOG(WARNING) << "io_uring is unavailable, use thread pool instead, "
+                     << status.ToString();
+    }
+
+    return std::make_unique<ThreadPoolChunkIoBackend>(options);
+}
+
+ChunkIoBackend::ChunkIoBackend(const Options& options) : options_(options) {
+    options_.queue_depth = std::max<uint32_t>(options_.queue_depth, 1);
+    options_.buffer_size =
+        (options_.buffer_size + kBufferAlignment - 1) / kBufferAlignment *
+        kBufferAlignment;
+    for (uint32_t i = 0; i < options_.buffer_nums; i++) {
+        void* buffer = nullptr;
+        if (posix_memalign(&buffer, kBufferAlignment, options_.buffer_size)) {
+            break;
+        }
+        buffers_.push_back(static_cast<char*>(buffer));
+        free_buffers_.push_back(i);
+    }
+}
+
+ChunkIoBackend::~ChunkIoBackend() {
+    for (auto buffer : buffers_) {
+        free(buffer);
+    }
+}
+
+google::protobuf::util::Status ChunkIoBackend::Submit(
+    std::vector<ChunkIoRequest> requests) {
+    size_t submitted = 0;
+    while (submitted < requests.size()) {
+        // 等待空闲的位置，一次提交尽可能多的 I/O
+        size_t batch_size;
+        {
+            absl::MutexLock lock_guard(&lock_);
+            while (inflight_ops_ >= options_.queue_depth) {
+                inflight_cond_var_.Wait(&lock_);
+            }
+            batch_size = std::min<size_t>(
+                requests.size() - submitted,
+                options_.queue_depth - inflight_ops_);
+            inflight_ops_ += batch_size;
+        }
+
+        std::vector<std::unique_ptr<ChunkIoRequest>> batch;
+        for (size_t i = 0; i < batch_size; i++) {
+            batch.push_back(std::make_unique<ChunkIoRequest>(
+                std::move(requests[submitted + i])));
+        }
+
+        auto status = SubmitBatch(&batch);
+        if (!status.ok()) {
+            // 没有交给后端的请求不会完成
+            const size_t rejected =
+                std::count_if(batch.begin(), batch.end(),
+                              [](const auto& request) { return !!request; });
+            absl::MutexLock lock_guard(&lock_);
+            inflight_ops_ -= rejected;
+            inflight_cond_var_.SignalAll();
+            return status;
+        }
+        submitted += batch_size;
+    }
+    return google::protobuf::util::OkStatus();
+}
+
+google::protobuf::util::StatusOr<int64_t> ChunkIoBackend::Execute(
+    ChunkIoRequest request) {
+    int64_t result = 0;
+    absl::Notification done;
+    request.callback = [&](int64_t io_result) {
+        result = io_result;
+        done.Notify();
+    };
+
+    std::vector<ChunkIoRequest> requests;
+    requests.push_back(std::move(request));
+    auto status = Submit(std::move(requests));
+    if (!status.ok()) {
+        return status;
+    }
+
+    done.WaitForNotification();
+    return result;
+}
+
+google::protobuf::util::StatusOr<size_t> ChunkIoBackend::Read(
+    const int& fd, const uint64_t& offset, char* buffer, const size_t& length,
+    const int& buffer_index) {
+    size_t read_bytes = 0;
+    while (read_bytes < length) {
+        ChunkIoRequest request;
+        request.type = ChunkIoRequest::READ;
+        request.fd = fd;
+        request.offset = offset + read_bytes;
+        request.buffer = buffer + read_bytes;
+        request.length = length - read_bytes;
+        // 固定缓冲区的读写需要完整地落在缓冲区内，续读时不再使用
+        request.buffer_index = read_bytes ? -1 : buffer_index;
+
+        auto result_or = Execute(std::move(request));
+        if (!result_or.ok()) {
+            return result_or.status();
+        }
+        if (result_or.value() < 0) {
+            return google::protobuf::util::InternalError(
+                "read failed, " + ErrnoToString(-result_or.value()));
+        }
+        // 文件末尾
+        if (result_or.value() == 0) {
+            break;
+        }
+        read_bytes += result_or.value();
+    }
+    return read_bytes;
+}
+
+google::protobuf::util::Status ChunkIoBackend::Write(const int& fd,
+                                                     const uint64_t& offset,
+                                                     const char* buffer,
+                                                     const size_t& length,
+                                                     const int& buffer_index) {
+    size_t written = 0;
+    while (written < length) {
+        ChunkIoRequest request;
+        request.type = ChunkIoRequest::WRITE;
+        request.fd = fd;
+        request.offset = offset + written;
+        // 写操作不会修改缓冲区
+        request.buffer = const_cast<char*>(buffer) + written;
+        request.length = length - written;
+        request.buffer_index = written ? -1 : buffer_index;
+
+        auto result_or = Execute(std::move(request));
+        if (!result_or.ok()) {
+            return result_or.status();
+        }
+        if (result_or.value() <= 0) {
+            return google::protobuf::util::InternalError(
+                "write failed, " + ErrnoToString(-result_or.value()));
+        }
+        written += result_or.value();
+    }
+    return google::protobuf::util::OkStatus();
+}
+
+google::protobuf::util::Status ChunkIoBackend::Fsync(const int& fd) {
+    ChunkIoRequest request;
+    request.type = ChunkIoRequest::FSYNC;
+    request.fd = fd;
+
+    auto result_or = Execute(std::move(request));
+    if (!result_or.ok()) {
+        return result_or.status();
+    }
+    if (result_or.value() < 0) {
+        return google::protobuf::util::InternalError(
+            "fsync failed, " + ErrnoToString(-result_or.value()));
+    }
+    return google::protobuf::util::OkStatus();
+}
+
+int ChunkIoBackend::AcquireBuffer() {
+    absl::MutexLock lock_guard(&lock_);
+    if (free_buffers_.empty()) {
+        return -1;
+    }
+
+    const int buffer_index = free_buffers_.back();
+    free_buffers_.pop_back();
+    return buffer_index;
+}
+
+void ChunkIoBackend::ReleaseBuffer(const int& buffer_index) {
+    if (buffer_index < 0) {
+        return;
+    }
+
+    absl::MutexLock lock_guard(&lock_);
+    free_buffers_.push_back(buffer_index);
+}
+
+char* ChunkIoBackend::GetBuffer(const int& buffer_index) const {
+    return buffers_[buffer_index];
+}
+
+uint32_t ChunkIoBackend::GetInflightOps() {
+    absl::MutexLock lock_guard(&lock_);
+    return inflight_ops_;
+}
+
+void ChunkIoBackend::Complete(std::unique_ptr<ChunkIoRequest> request,
+                              const int64_t& result) {
+    {
+        absl::MutexLock lock_guard(&lock_);
+        inflight_ops_--;
+        inflight_cond_var_.SignalAll();
+    }
+
+    if (request->callback) {
+        request->callback(result);
+    }
+}
+
+void ChunkIoBackend::WaitInflightOps() {
+    absl::MutexLock lock_guard(&lock_);
+    while (inflight_ops_ > 0) {
+        inflight_cond_var_.Wait(&lock_);
+    }
+}
+
+}  // namespace server
+}  // namespace dfs
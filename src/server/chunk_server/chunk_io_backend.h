@@ -0,0 +1,150 @@
+#ifndef DFS_SERVER_CHUNK_SERVER_CHUNK_IO_BACKEND_H
+#define DFS_SERVER_CHUNK_SERVER_CHUNK_IO_BACKEND_H
+
+#include <absl/synchronization/mutex.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "google/protobuf/stubs/status.h"
+#include "google/protobuf/stubs/statusor.h"
+
+namespace dfs {
+namespace server {
+
+// 一次异步文件 I/O
+struct ChunkIoRequest {
+    enum Type {
+        READ,
+        WRITE,
+        FSYNC,
+    };
+
+    Type type = READ;
+
+    int fd = -1;
+
+    uint64_t offset = 0;
+
+    char* buffer = nullptr;
+
+    size_t length = 0;
+
+    // buffer 为注册缓冲区时的下标，否则为 -1
+    int buffer_index = -1;
+
+    // I/O 完成后在完成线程中调用，result 为读写的字节数，失败时为 -errno。
+    // 回调中不能等待其他 I/O 完成
+    std::function<void(int64_t result)> callback;
+};
+
+/**
+ * 文件 I/O 后端
+ * 1. 优先使用 io_uring，一次系统调用提交一批读写与 fsync，
+ *    由一个完成线程处理所有 I/O 的完成事件，少量线程即可维持大量 I/O
+ * 2. 内核不支持 io_uring 时退回线程池，在线程中调用 pread/pwrite/fsync
+ * 3. 预先分配一组按页对齐的缓冲区，io_uring 后端将其注册到内核，
+ *    使用这些缓冲区的 I/O 不需要每次锁定内存页
+ * 4. 同时进行的 I/O 数量不超过 queue_depth，超过时提交者等待
+ */
+class ChunkIoBackend {
+   public:
+    // 缓冲区按页对齐，可以用于 O_DIRECT，O_DIRECT 读写的偏移与长度
+    // 也需要按此对齐
+    static constexpr size_t kBufferAlignment = 4096;
+
+    struct Options {
+        // 同时进行的 I/O 数量上限，也是 io_uring 提交队列的长度
+        uint32_t queue_depth = 256;
+        // 线程池后端的线程数量
+        uint32_t thread_nums = 8;
+        // 注册缓冲区的数量
+        uint32_t buffer_nums = 16;
+        // 每个注册缓冲区的大小，按页对齐
+        size_t buffer_size = 1024 * 1024;
+        // 为 true 时不使用 io_uring
+        bool use_thread_pool = false;
+    };
+
+    // 创建 I/O 后端，io_uring 不可用时使用线程池
+    static std::unique_ptr<ChunkIoBackend> Create(const Options& options);
+
+    virtual ~ChunkIoBackend();
+
+    // 批量提交 I/O，提交失败的请求不会调用回调
+    google::protobuf::util::Status Submit(
+        std::vector<ChunkIoRequest> requests);
+
+    // 以下为同步接口，提交后等待 I/O 完成，不能在回调中调用
+    // 读取 length 字节，遇到文件末尾时返回实际读取的字节数
+    google::protobuf::util::StatusOr<size_t> Read(const int& fd,
+                                                  const uint64_t& offset,
+                                                  char* buffer,
+                                                  const size_t& length,
+                                                  const int& buffer_index = -1);
+
+    // 写入 length 字节
+    google::protobuf::util::Status Write(const int& fd, const uint64_t& offset,
+                                         const char* buffer,
+                                         const size_t& length,
+                                         const int& buffer_index = -1);
+
+    google::protobuf::util::Status Fsync(const int& fd);
+
+    // 取一个空闲的注册缓冲区，没有时返回 -1
+    int AcquireBuffer();
+
+    void ReleaseBuffer(const int& buffer_index);
+
+    char* GetBuffer(const int& buffer_index) const;
+
+    size_t buffer_size() const { return options_.buffer_size; }
+
+    // 正在进行的 I/O 数量
+    uint32_t GetInflightOps();
+
+    virtual const char* name() const = 0;
+
+    // 等待正在进行的 I/O 完成后关闭
+    virtual void Shutdown() = 0;
+
+   protected:
+    explicit ChunkIoBackend(const Options& options);
+
+    // 提交一批 I/O，请求的所有权交给后端，完成时调用 Complete。失败时
+    // 没有交给后端的请求留在 requests 中，不会调用 Complete
+    virtual google::protobuf::util::Status SubmitBatch(
+        std::vector<std::unique_ptr<ChunkIoRequest>>* requests) = 0;
+
+    // 一次 I/O 完成
+    void Complete(std::unique_ptr<ChunkIoRequest> request,
+                  const int64_t& result);
+
+    // 等待所有 I/O 完成
+    void WaitInflightOps();
+
+    Options options_;
+
+    // 注册缓冲区
+    std::vector<char*> buffers_;
+
+   private:
+    // 执行一次同步 I/O，返回 I/O 的结果
+    google::protobuf::util::StatusOr<int64_t> Execute(ChunkIoRequest request);
+
+    absl::Mutex lock_;
+
+    absl::CondVar inflight_cond_var_;
+
+    uint32_t inflight_ops_ = 0;
+
+    std::vector<int> free_buffers_;
+};
+
+}  // namespace server
+}  // namespace dfs
+
+#endif  // DFS_SERVER_CHUNK_SERVER_CHUNK_IO_BACKEND_H
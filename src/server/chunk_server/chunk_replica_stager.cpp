@@ -0,0 +1,340 @@
+#include "src/server/chunk_server/chunk_replica_stager.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+namespace dfs {
+namespace server {
+
+namespace {
+
+// 超过该时间没有续传的暂存文件会被删除
+const absl::Duration kStagingExpiration = absl::Minutes(10);
+
+std::string ErrnoToString() { return std::strerror(errno); }
+
+}  // namespace
+
+ChunkReplicaStager::ChunkReplicaStager(const std::string& staging_dir,
+                                       ChunkIoBackend* io_backend)
+    : staging_dir_(staging_dir), io_backend_(io_backend) {}
+
+ChunkReplicaStager::~ChunkReplicaStager() {
+    absl::MutexLock lock_guard(&lock_);
+    for (auto& chunk_pair : staging_chunks_) {
+        if (chunk_pair.second.fd >= 0) {
+            close(chunk_pair.second.fd);
+        }
+    }
+}
+
+google::protobuf::util::Status ChunkReplicaStager::Initialize() {
+    std::error_code error;
+    std::filesystem::remove_all(staging_dir_, error);
+    std::filesystem::create_directories(staging_dir_, error);
+    if (error) {
+        return google::protobuf::util::InternalError(
+            "failed to create staging dir " + staging_dir_ + ", " +
+            error.message());
+    }
+
+    return google::protobuf::util::OkStatus();
+}
+
+google::protobuf::util::StatusOr<uint64_t> ChunkReplicaStager::Begin(
+    const std::string& chunk_handle, const uint32_t& version,
+    const uint64_t& chunk_size) {
+    absl::MutexLock lock_guard(&lock_);
+    const absl::Time now = absl::Now();
+    RemoveExpiredStagingChunks(now);
+
+    auto iter = staging_chunks_.find(chunk_handle);
+    if (iter != staging_chunks_.end()) {
+        if (iter->second.active) {
+            return google::protobuf::util::AbortedError(
+                "chunk " + chunk_handle + " is being copied by another stream");
+        }
+
+        if (iter->second.version == version &&
+            iter->second.chunk_size == chunk_size) {
+            iter->second.active = true;
+            iter->second.last_update = now;
+            return iter->second.staged_bytes;
+        }
+
+        // 数据块在传输中断期间被修改过，重新接收
+        RemoveStagingChunk(chunk_handle);
+    }
+
+    const int fd =
+        open(StagingPath(chunk_handle).c_str(), O_RDWR | O_CREAT | O_TRUNC,
+             0644);
+    if (fd < 0) {
+        return google::protobuf::util::InternalError(
+            "failed to create staging file for chunk " + chunk_handle + ", " +
+            ErrnoToString());
+    }
+
+    auto& staging_chunk = staging_chunks_[chunk_handle];
+    staging_chunk.version = version;
+    staging_chunk.chunk_size = chunk_size;
+    staging_chunk.staged_bytes = 0;
+    staging_chunk.fd = fd;
+    staging_chunk.active = true;
+    staging_chunk.last_update = now;
+    return 0;
+}
+
+google::protobuf::util::StatusOr<uint64_t> ChunkReplicaStager::Append(
+    const std::string& chunk_handle, const uint64_t& offset,
+    const std::string& data) {
+    int fd = -1;
+    {
+        absl::MutexLock lock_guard(&lock_);
+        auto iter = staging_chunks_.find(chunk_handle);
+        if (iter == staging_chunks_.end() || !iter->second.active) {
+            return google::protobuf::util::FailedPreconditionError(
+                "chunk " + chunk_handle + " is not being copied");
+        }
+
+        const auto& staging_chunk = iter->second;
+        if (offset != staging_chunk.staged_bytes) {
+            return google::protobuf::util::FailedPreconditionError(
+                "unexpected offset " + std::to_string(offset) + " for chunk " +
+                chunk_handle + ", staged bytes: " +
+                std::to_string(staging_chunk.staged_bytes));
+        }
+
+        if (offset + data.size() > staging_chunk.chunk_size) {
+            return google::protobuf::util::OutOfRangeError(
+                "data exceeds chunk size, chunk_handle: " + chunk_handle);
+        }
+
+        fd = staging_chunk.fd;
+    }
+
+    // 同一个数据块只有一个传输写入，可以在锁外写文件。
+    // 数据放得下时复制到注册缓冲区，避免每次写入都锁定内存页
+    google::protobuf::util::Status write_status;
+    const int buffer_index = data.size() <= io_backend_->buffer_size()
+                                 ? io_backend_->AcquireBuffer()
+                                 : -1;
+    if (buffer_index >= 0) {
+        char* buffer = io_backend_->GetBuffer(buffer_index);
+        memcpy(buffer, data.data(), data.size());
+        write_status = io_backend_->Write(fd, offset, buffer, data.size(),
+                                          buffer_index);
+        io_backend_->ReleaseBuffer(buffer_index);
+    } else {
+        write_status =
+            io_backend_->Write(fd, offset, data.data(), data.size());
+    }
+    if (!write_status.ok()) {
+        return google::protobuf::util::InternalError(
+            "failed to write staging file for chunk " + chunk_handle + ", " +
+            write_status.ToString());
+    }
+
+    absl::MutexLock lock_guard(&lock_);
+    auto& staging_chunk = staging_chunks_[chunk_handle];
+    staging_chunk.staged_bytes = offset + data.size();
+    staging_chunk.last_update = absl::Now();
+    return staging_chunk.staged_bytes;
+}
+
+google::protobuf::util::Status ChunkReplicaStager::Seal(
+    const std::string& chunk_handle) {
+    absl::MutexLock lock_guard(&lock_);
+    auto iter = staging_chunks_.find(chunk_handle);
+    if (iter == staging_chunks_.end() || !iter->second.active) {
+        return google::protobuf::util::FailedPreconditionError(
+            "chunk " + chunk_handle + " is not being copied");
+    }
+
+    iter->second.chunk_size = iter->second.staged_bytes;
+    return google::protobuf::util::OkStatus();
+}
+
+google::protobuf::util::StatusOr<std::string> ChunkReplicaStager::Read(
+    const std::string& chunk_handle, const uint64_t& offset,
+    const uint64_t& length) {
+    int fd = -1;
+    uint64_t staged_bytes = 0;
+    {
+        absl::MutexLock lock_guard(&lock_);
+        auto iter = staging_chunks_.find(chunk_handle);
+        if (iter == staging_chunks_.end() || !iter->second.active) {
+            return google::protobuf::util::FailedPreconditionError(
+                "chunk " + chunk_handle + " is not being copied");
+        }
+        fd = iter->second.fd;
+        staged_bytes = iter->second.staged_bytes;
+    }
+
+    if (offset >= staged_bytes) {
+        return std::string();
+    }
+
+    // 传输处于活跃状态，暂存文件不会被关闭
+    std::string data(std::min(length, staged_bytes - offset), '\0');
+    auto read_or = io_backend_->Read(fd, offset, &data[0], data.size());
+    if (!read_or.ok() || read_or.value() != data.size()) {
+        return google::protobuf::util::InternalError(
+            "failed to read staging file for chunk " + chunk_handle +
+            " at offset " + std::to_string(offset));
+    }
+    return data;
+}
+
+google::protobuf::util::Status ChunkReplicaStager::Commit(
+    const std::string& chunk_handle, const PieceWriter& write_piece) {
+    int fd = -1;
+    uint64_t chunk_size = 0;
+    {
+        absl::MutexLock lock_guard(&lock_);
+        auto iter = staging_chunks_.find(chunk_handle);
+        if (iter == staging_chunks_.end() || !iter->second.active) {
+            return google::protobuf::util::FailedPreconditionError(
+                "chunk " + chunk_handle + " is not being copied");
+        }
+
+        auto& staging_chunk = iter->second;
+        if (staging_chunk.staged_bytes != staging_chunk.chunk_size) {
+            return google::protobuf::util::FailedPreconditionError(
+                "chunk " + chunk_handle + " is incomplete, staged bytes: " +
+                std::to_string(staging_chunk.staged_bytes));
+        }
+
+        staging_chunk.committing = true;
+        fd = staging_chunk.fd;
+        chunk_size = staging_chunk.chunk_size;
+    }
+
+    // 提交期间暂存文件不会被关闭，可以在锁外读取。每次读出一片数据，
+    // 优先读入注册缓冲区
+    const size_t piece_size = std::max<size_t>(io_backend_->buffer_size(), 1);
+    const int buffer_index = io_backend_->AcquireBuffer();
+    std::string piece_buffer;
+    char* buffer = nullptr;
+    if (buffer_index >= 0) {
+        buffer = io_backend_->GetBuffer(buffer_index);
+    } else {
+        piece_buffer.resize(piece_size);
+        buffer = &piece_buffer[0];
+    }
+
+    google::protobuf::util::Status status;
+    for (uint64_t offset = 0; offset < chunk_size && status.ok();) {
+        const size_t length =
+            std::min<uint64_t>(piece_size, chunk_size - offset);
+        auto read_or =
+            io_backend_->Read(fd, offset, buffer, length, buffer_index);
+        if (!read_or.ok() || read_or.value() != length) {
+            status = google::protobuf::util::InternalError(
+                "failed to read staging file for chunk " + chunk_handle +
+                " at offset " + std::to_string(offset));
+            break;
+        }
+
+        status = write_piece(offset, buffer, length);
+        offset += length;
+    }
+    if (buffer_index >= 0) {
+        io_backend_->ReleaseBuffer(buffer_index);
+    }
+
+    absl::MutexLock lock_guard(&lock_);
+    auto iter = staging_chunks_.find(chunk_handle);
+    if (iter != staging_chunks_.end()) {
+        iter->second.committing = false;
+        if (status.ok()) {
+            RemoveStagingChunk(chunk_handle);
+        }
+    }
+    return status;
+}
+
+void ChunkReplicaStager::Release(const std::string& chunk_handle) {
+    int fd = -1;
+    {
+        absl::MutexLock lock_guard(&lock_);
+        auto iter = staging_chunks_.find(chunk_handle);
+        if (iter == staging_chunks_.end()) {
+            return;
+        }
+        fd = iter->second.fd;
+    }
+
+    // 传输仍然处于活跃状态，暂存文件不会被关闭，可以在锁外落盘
+    auto sync_status = io_backend_->Fsync(fd);
+
+    absl::MutexLock lock_guard(&lock_);
+    auto iter = staging_chunks_.find(chunk_handle);
+    if (iter == staging_chunks_.end()) {
+        return;
+    }
+    if (!sync_status.ok()) {
+        // 没有落盘的数据不能用于续传
+        RemoveStagingChunk(chunk_handle);
+        return;
+    }
+    iter->second.active = false;
+    iter->second.last_update = absl::Now();
+}
+
+void ChunkReplicaStager::Abort(const std::string& chunk_handle) {
+    absl::MutexLock lock_guard(&lock_);
+    auto iter = staging_chunks_.find(chunk_handle);
+    if (iter != staging_chunks_.end() && iter->second.committing) {
+        // 正在提交的数据由提交方删除
+        return;
+    }
+    RemoveStagingChunk(chunk_handle);
+}
+
+uint64_t ChunkReplicaStager::GetStagedBytes(const std::string& chunk_handle) {
+    absl::MutexLock lock_guard(&lock_);
+    auto iter = staging_chunks_.find(chunk_handle);
+    return iter == staging_chunks_.end() ? 0 : iter->second.staged_bytes;
+}
+
+std::string ChunkReplicaStager::StagingPath(
+    const std::string& chunk_handle) const {
+    return staging_dir_ + "/" + chunk_handle;
+}
+
+void ChunkReplicaStager::RemoveStagingChunk(const std::string& chunk_handle) {
+    auto iter = staging_chunks_.find(chunk_handle);
+    if (iter == staging_chunks_.end()) {
+        return;
+    }
+
+    if (iter->second.fd >= 0) {
+        close(iter->second.fd);
+    }
+    unlink(StagingPath(chunk_handle).c_str());
+    staging_chunks_.erase(iter);
+}
+
+void ChunkReplicaStager::RemoveExpiredStagingChunks(absl::Time now) {
+    std::vector<std::string> expired_handles;
+    for (const auto& chunk_pair : staging_chunks_) {
+        if (!chunk_pair.second.active &&
+            now - chunk_pair.second.last_update > kStagingExpiration) {
+            expired_handles.push_back(chunk_pair.first);
+        }
+    }
+
+    for (const auto& chunk_handle : expired_handles) {
+        RemoveStagingChunk(chunk_handle);
+    }
+}
+
+}  // namespace server
+}  // namespace dfs
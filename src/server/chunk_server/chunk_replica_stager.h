@@ -0,0 +1,110 @@
+#ifndef DFS_SERVER_CHUNK_SERVER_CHUNK_REPLICA_STAGER_H
+#define DFS_SERVER_CHUNK_SERVER_CHUNK_REPLICA_STAGER_H
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+#include <absl/time/time.h>
+
+#include <functional>
+#include <string>
+
+#include "google/protobuf/stubs/status.h"
+#include "google/protobuf/stubs/statusor.h"
+#include "src/server/chunk_server/chunk_io_backend.h"
+
+namespace dfs {
+namespace server {
+
+/**
+ * 暂存流式复制收到的数据块副本
+ * 1. 每一帧数据追加写入暂存目录下的文件，接收过程中只在内存中保留一帧数据
+ * 2. 连接中断后暂存文件保留，重新连接时返回已经写入的字节数，用于续传
+ * 3. 同一个数据块同时只允许一个传输写入
+ * 4. 暂存文件通过 io_backend 读写，提交时每次读出一个缓冲区大小的数据片，
+ *    交给调用方写入数据块存储，提交过程中不持有锁
+ */
+class ChunkReplicaStager {
+   public:
+    ChunkReplicaStager(const std::string& staging_dir,
+                       ChunkIoBackend* io_backend);
+
+    ~ChunkReplicaStager();
+
+    // 创建暂存目录，并清除上一次运行遗留的暂存文件
+    google::protobuf::util::Status Initialize();
+
+    // 开始接收数据块，返回应当续传的偏移。
+    // 已有的暂存数据版本或大小不同时，丢弃后从头开始接收
+    google::protobuf::util::StatusOr<uint64_t> Begin(
+        const std::string& chunk_handle, const uint32_t& version,
+        const uint64_t& chunk_size);
+
+    // 将 offset 处的数据追加到暂存文件，返回已经写入的字节数
+    google::protobuf::util::StatusOr<uint64_t> Append(
+        const std::string& chunk_handle, const uint64_t& offset,
+        const std::string& data);
+
+    // 数据块的长度事先未知时（如编码得到的校验块），以长度上限开始接收，
+    // 写入完成后将长度设置为已经写入的字节数
+    google::protobuf::util::Status Seal(const std::string& chunk_handle);
+
+    // 读取暂存文件 offset 处最多 length 字节的数据，只能由正在写入的传输
+    // 调用，可以在多个线程中同时调用
+    google::protobuf::util::StatusOr<std::string> Read(
+        const std::string& chunk_handle, const uint64_t& offset,
+        const uint64_t& length);
+
+    // 按顺序写入 offset 处 length 字节的数据片，data 在调用返回后失效
+    using PieceWriter = std::function<google::protobuf::util::Status(
+        const uint64_t& offset, const char* data, const size_t& length)>;
+
+    // 数据块接收完整，按顺序读出各数据片交给 write_piece，全部写入后删除
+    // 暂存文件。失败时保留暂存数据，由调用方决定释放或丢弃
+    google::protobuf::util::Status Commit(const std::string& chunk_handle,
+                                          const PieceWriter& write_piece);
+
+    // 结束本次传输，将已经写入的数据落盘后保留，用于续传
+    void Release(const std::string& chunk_handle);
+
+    // 丢弃暂存的数据
+    void Abort(const std::string& chunk_handle);
+
+    // 已经写入暂存文件的字节数，没有暂存数据时返回 0
+    uint64_t GetStagedBytes(const std::string& chunk_handle);
+
+   private:
+    struct StagingChunk {
+        uint32_t version = 0;
+        uint64_t chunk_size = 0;
+        // 已经写入暂存文件的字节数
+        uint64_t staged_bytes = 0;
+        int fd = -1;
+        // 是否有传输正在写入
+        bool active = false;
+        // 是否正在提交，提交期间暂存文件不能被关闭
+        bool committing = false;
+        absl::Time last_update;
+    };
+
+    std::string StagingPath(const std::string& chunk_handle) const;
+
+    // 关闭并删除暂存文件，调用者需持有 lock_
+    void RemoveStagingChunk(const std::string& chunk_handle);
+
+    // 删除长时间没有续传的暂存文件，调用者需持有 lock_
+    void RemoveExpiredStagingChunks(absl::Time now);
+
+    std::string staging_dir_;
+
+    ChunkIoBackend* io_backend_;
+
+    absl::Mutex lock_;
+
+    // <chunk_handle, staging chunk>
+    absl::flat_hash_map<std::string, StagingChunk> staging_chunks_;
+};
+
+}  // namespace server
+}  // namespace dfs
+
+#endif  // DFS_SERVER_CHUNK_SERVER_CHUNK_REPLICA_STAGER_H
@@ -0,0 +1,153 @@
+#include "src/server/chunk_server/chunk_server_async_services.h"
+
+namespace dfs {
+namespace server {
+
+using dfs::common::AsyncServerRuntime;
+using protos::grpc::ChunkServerControlService;
+using protos::grpc::ChunkServerFileService;
+using protos::grpc::ChunkServerLeaseService;
+using ExecutorType = AsyncServerRuntime::ExecutorType;
+
+// 除流式复制以外的方法都使用异步接口
+using AsyncFileServiceBase =
+    ChunkServerFileService::WithAsyncMethod_InitFileChunk<
+    ChunkServerFileService::WithAsyncMethod_ReadFileChunk<
+    ChunkServerFileService::WithAsyncMethod_WriteFileChunk<
+    ChunkServerFileService::WithAsyncMethod_SendChunkData<
+    ChunkServerFileService::WithAsyncMethod_ApplyMutation<
+    ChunkServerFileService::WithAsyncMethod_AdjustFileChunkVersion<
+    ChunkServerFileService::WithAsyncMethod_ChunkReplicaCopy<
+    ChunkServerFileService::WithAsyncMethod_ApplyChunkReplicaCopy<
+    ChunkServerFileService::WithAsyncMethod_EncodeStripe<
+    ChunkServerFileService::WithAsyncMethod_ReconstructChunk<
+    ChunkServerFileService::Service>>>>>>>>>>;
+
+class ChunkServerAsyncServices::AsyncFileService final
+    : public AsyncFileServiceBase {
+   public:
+    explicit AsyncFileService(ChunkServerFileServiceImpl* impl)
+        : impl_(impl) {}
+
+    void RegisterMethods(AsyncServerRuntime* runtime) {
+        using Impl = ChunkServerFileServiceImpl;
+        runtime->RegisterUnaryMethod(
+            "InitFileChunk", this, &AsyncFileService::RequestInitFileChunk,
+            impl_, &Impl::InitFileChunk, ExecutorType::DISK);
+        runtime->RegisterUnaryMethod(
+            "ReadFileChunk", this, &AsyncFileService::RequestReadFileChunk,
+            impl_, &Impl::ReadFileChunk, ExecutorType::DISK);
+        // 主副本服务器写入本地后还要同步地通知其他副本服务器
+        runtime->RegisterUnaryMethod(
+            "WriteFileChunk", this, &AsyncFileService::RequestWriteFileChunk,
+            impl_, &Impl::WriteFileChunk, ExecutorType::NETWORK);
+        // 数据只写入内存缓存
+        runtime->RegisterUnaryMethod(
+            "SendChunkData", this, &AsyncFileService::RequestSendChunkData,
+            impl_, &Impl::SendChunkData, ExecutorType::NETWORK);
+        runtime->RegisterUnaryMethod(
+            "ApplyMutation", this, &AsyncFileService::RequestApplyMutation,
+            impl_, &Impl::ApplyMutation, ExecutorType::DISK);
+        runtime->RegisterUnaryMethod(
+            "AdjustFileChunkVersion", this,
+            &AsyncFileService::RequestAdjustFileChunkVersion, impl_,
+            &Impl::AdjustFileChunkVersion, ExecutorType::DISK);
+        // 向其他块服务器发送数据块，耗时取决于网络
+        runtime->RegisterUnaryMethod(
+            "ChunkReplicaCopy", this,
+            &AsyncFileService::RequestChunkReplicaCopy, impl_,
+            &Impl::ChunkReplicaCopy, ExecutorType::NETWORK);
+        runtime->RegisterUnaryMethod(
+            "ApplyChunkReplicaCopy", this,
+            &AsyncFileService::RequestApplyChunkReplicaCopy, impl_,
+            &Impl::ApplyChunkReplicaCopy, ExecutorType::DISK);
+        // 纠删码条带需要读取其他块服务器上的分片
+        runtime->RegisterUnaryMethod(
+            "EncodeStripe", this, &AsyncFileService::RequestEncodeStripe, impl_,
+            &Impl::EncodeStripe, ExecutorType::NETWORK);
+        runtime->RegisterUnaryMethod(
+            "ReconstructChunk", this,
+            &AsyncFileService::RequestReconstructChunk, impl_,
+            &Impl::ReconstructChunk, ExecutorType::NETWORK);
+    }
+
+    grpc::Status StreamChunkReplicaCopy(
+        grpc::ServerContext* context,
+        grpc::ServerReaderWriter<protos::grpc::ChunkReplicaCopyAck,
+                                 protos::grpc::ChunkReplicaCopyFrame>* stream)
+        override {
+        // 流式 RPC 不经过运行时，单独记录指标与 span
+        static AsyncServerRuntime::RpcMetrics metrics("StreamChunkReplicaCopy");
+        const uint64_t start_micros = dfs::common::MonotonicMicros();
+        dfs::common::Span span("StreamChunkReplicaCopy", context, start_micros);
+        auto status = impl_->StreamChunkReplicaCopy(context, stream);
+        span.SetStatus(status);
+        metrics.Finish(status, start_micros);
+        return status;
+    }
+
+   private:
+    ChunkServerFileServiceImpl* impl_;
+};
+
+class ChunkServerAsyncServices::AsyncControlService final
+    : public ChunkServerControlService::AsyncService {
+   public:
+    explicit AsyncControlService(ChunkServerControlServiceImpl* impl)
+        : impl_(impl) {}
+
+    void RegisterMethods(AsyncServerRuntime* runtime) {
+        runtime->RegisterUnaryMethod(
+            "SendHeartBeat", this, &AsyncControlService::RequestSendHeartBeat,
+            impl_, &ChunkServerControlServiceImpl::SendHeartBeat,
+            ExecutorType::INLINE);
+    }
+
+   private:
+    ChunkServerControlServiceImpl* impl_;
+};
+
+class ChunkServerAsyncServices::AsyncLeaseService final
+    : public ChunkServerLeaseService::AsyncService {
+   public:
+    explicit AsyncLeaseService(ChunkServerLeaseServiceImpl* impl)
+        : impl_(impl) {}
+
+    // 数据块的版本号通常已经缓存在内存中
+    void RegisterMethods(AsyncServerRuntime* runtime) {
+        runtime->RegisterUnaryMethod(
+            "GrantLease", this, &AsyncLeaseService::RequestGrantLease, impl_,
+            &ChunkServerLeaseServiceImpl::GrantLease, ExecutorType::INLINE);
+        runtime->RegisterUnaryMethod(
+            "RevokeLease", this, &AsyncLeaseService::RequestRevokeLease, impl_,
+            &ChunkServerLeaseServiceImpl::RevokeLease, ExecutorType::INLINE);
+    }
+
+   private:
+    ChunkServerLeaseServiceImpl* impl_;
+};
+
+ChunkServerAsyncServices::ChunkServerAsyncServices(
+    ChunkServerFileServiceImpl* file_service,
+    ChunkServerControlServiceImpl* control_service,
+    ChunkServerLeaseServiceImpl* lease_service)
+    : file_service_(std::make_unique<AsyncFileService>(file_service)),
+      control_service_(
+          std::make_unique<AsyncControlService>(control_service)),
+      lease_service_(std::make_unique<AsyncLeaseService>(lease_service)) {}
+
+ChunkServerAsyncServices::~ChunkServerAsyncServices() = default;
+
+void ChunkServerAsyncServices::Register(grpc::ServerBuilder* builder,
+                                        AsyncServerRuntime* runtime) {
+    builder->RegisterService(file_service_.get());
+    builder->RegisterService(control_service_.get());
+    builder->RegisterService(lease_service_.get());
+
+    file_service_->RegisterMethods(runtime);
+    control_service_->RegisterMethods(runtime);
+    lease_service_->RegisterMethods(runtime);
+}
+
+}  // namespace server
+}  // namespace dfs
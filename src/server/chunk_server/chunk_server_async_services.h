@@ -0,0 +1,51 @@
+#ifndef DFS_SERVER_CHUNK_SERVER_ASYNC_SERVICES_H
+#define DFS_SERVER_CHUNK_SERVER_ASYNC_SERVICES_H
+
+#include <grpcpp/grpcpp.h>
+
+#include <memory>
+
+#include "src/common/async_server_runtime.h"
+#include "src/server/chunk_server/chunk_server_control_service_impl.h"
+#include "src/server/chunk_server/chunk_server_file_service_impl.h"
+#include "src/server/chunk_server/chunk_server_lease_service_impl.h"
+
+namespace dfs {
+namespace server {
+
+/**
+ * 块服务器对外提供的服务
+ * 一元 RPC 由异步运行时处理，处理逻辑仍然是各个同步服务的实现：
+ * 1. 读写 leveldb 的请求在磁盘线程池中处理
+ * 2. 需要访问其他块服务器的请求在网络线程池中处理
+ * 3. 心跳与租约只访问内存中的状态，直接在轮询线程中处理
+ * 流式复制仍然由同步线程处理
+ */
+class ChunkServerAsyncServices {
+   public:
+    ChunkServerAsyncServices(ChunkServerFileServiceImpl* file_service,
+                             ChunkServerControlServiceImpl* control_service,
+                             ChunkServerLeaseServiceImpl* lease_service);
+
+    ~ChunkServerAsyncServices();
+
+    // 将服务注册到 builder，并将一元 RPC 注册到运行时
+    void Register(grpc::ServerBuilder* builder,
+                  dfs::common::AsyncServerRuntime* runtime);
+
+   private:
+    class AsyncFileService;
+    class AsyncControlService;
+    class AsyncLeaseService;
+
+    std::unique_ptr<AsyncFileService> file_service_;
+
+    std::unique_ptr<AsyncControlService> control_service_;
+
+    std::unique_ptr<AsyncLeaseService> lease_service_;
+};
+
+}  // namespace server
+}  // namespace dfs
+
+#endif  // DFS_SERVER_CHUNK_SERVER_ASYNC_SERVICES_H
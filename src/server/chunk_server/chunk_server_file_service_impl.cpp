@@ -1,7 +1,15 @@
 #include "src/server/chunk_server/chunk_server_file_service_impl.h"
 
+#include <absl/time/clock.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "src/common/checksum.h"
 #include "src/common/config_manager.h"
 #include "src/common/system_logger.h"
+#include "src/common/tracing.h"
 #include "src/common/utils.h"
 #include "src/server/chunk_server/chunk_cache_manager.h"
 #include "src/server/chunk_server/chunk_server_impl.h"
@@ -10,6 +18,10 @@ namespace dfs {
 namespace server {
 
 using dfs::common::ConfigManager;
+using dfs::common::CurrentTraceContext;
+using dfs::common::ScopedTraceContext;
+using dfs::common::Span;
+using dfs::common::StatusGrpc2Protobuf;
 using dfs::common::StatusProtobuf2Grpc;
 using google::protobuf::util::IsAlreadyExists;
 using google::protobuf::util::IsNotFound;
@@ -20,10 +32,19 @@ using protos::grpc::ApplyChunkReplicaCopyRequest;
 using protos::grpc::ApplyChunkReplicaCopyRespond;
 using protos::grpc::ApplyMutationRequest;
 using protos::grpc::ApplyMutationRespond;
+using protos::grpc::ChunkReplicaCopyAck;
+using protos::grpc::ChunkReplicaCopyFrame;
+using protos::grpc::EncodeStripeRequest;
+using protos::grpc::EncodeStripeRespond;
 using protos::grpc::FileChunkMutationStatus;
 using protos::grpc::InitFileChunkRequest;
 using protos::grpc::InitFileChunkRespond;
+using protos::grpc::ReadFileChunkRequest;
+using protos::grpc::ReadFileChunkRespond;
+using protos::grpc::ReconstructChunkRequest;
+using protos::grpc::ReconstructChunkRespond;
 using protos::grpc::SendChunkDataRespond;
+using protos::grpc::StripeShard;
 using protos::grpc::WriteFileChunkRespond;
 
 FileChunkManager* ChunkServerFileServiceImpl::file_chunk_manager() {
@@ -34,6 +55,82 @@ ChunkServerImpl* ChunkServerFileServiceImpl::chunk_server_impl() {
     return ChunkServerImpl::GetInstance();
 }
 
+namespace {
+
+// 统计读写磁盘请求，用于向主服务器汇报负载
+class DiskOpRecorder {
+   public:
+    DiskOpRecorder(ChunkServerImpl* chunk_server_impl, bool is_write)
+        : chunk_server_impl_(chunk_server_impl) {
+        if (is_write) {
+            chunk_server_impl_->BeginWriteOp();
+        } else {
+            chunk_server_impl_->BeginReadOp();
+        }
+    }
+
+    ~DiskOpRecorder() { chunk_server_impl_->EndOp(); }
+
+   private:
+    ChunkServerImpl* chunk_server_impl_;
+};
+
+// 流式复制结束时释放暂存的数据块，保留已经写入的数据用于续传
+class ReplicaStagingGuard {
+   public:
+    ReplicaStagingGuard(ChunkReplicaStager* stager,
+                        const std::string& chunk_handle)
+        : stager_(stager), chunk_handle_(chunk_handle) {}
+
+    ~ReplicaStagingGuard() { stager_->Release(chunk_handle_); }
+
+   private:
+    ChunkReplicaStager* stager_;
+    std::string chunk_handle_;
+};
+
+// 编码得到的校验块在暂存区中的名称，与接收同一数据块副本的暂存数据区分
+std::string ParityStagingName(const std::string& chunk_handle) {
+    return chunk_handle + ".parity";
+}
+
+// 编码期间暂存的校验块，退出时丢弃没有提交的暂存数据
+class ParityStagingGuard {
+   public:
+    explicit ParityStagingGuard(ChunkReplicaStager* stager) : stager_(stager) {}
+
+    ~ParityStagingGuard() {
+        for (const auto& chunk_handle : chunk_handles_) {
+            stager_->Abort(chunk_handle);
+        }
+    }
+
+    void Add(const std::string& chunk_handle) {
+        chunk_handles_.push_back(chunk_handle);
+    }
+
+   private:
+    ChunkReplicaStager* stager_;
+    std::vector<std::string> chunk_handles_;
+};
+
+// 流式复制失败后重试的等待时间，随重试次数增加
+const absl::Duration kStreamRetryBackoff = absl::Milliseconds(200);
+
+// 以下错误重试也无法恢复
+bool IsStreamRetryable(const google::protobuf::util::Status& status) {
+    return !google::protobuf::util::IsOutOfRange(status) &&
+           !google::protobuf::util::IsInvalidArgument(status) &&
+           !google::protobuf::util::IsUnimplemented(status);
+}
+
+std::string LocationAddress(const protos::ChunkServerLocation& location) {
+    return location.server_hostname() + ":" +
+           std::to_string(location.server_port());
+}
+
+}  // namespace
+
 grpc::Status ChunkServerFileServiceImpl::InitFileChunk(
     grpc::ServerContext* context,
     const protos::grpc::InitFileChunkRequest* request,
@@ -44,9 +141,15 @@ grpc::Status ChunkServerFileServiceImpl::InitFileChunk(
     // add log
     LOG(INFO) << "create a chunk for chunk handle: " << chunk_handle;
 
-    auto status = file_chunk_manager()->CreateChunk(chunk_handle, 1);
+    auto status = file_chunk_manager()->CreateChunk(
+        chunk_handle, 1, IoPriority::FOREGROUND_WRITE, request->codec());
     if (status.ok()) {
         // successfully created
+        // 主副本服务器在创建数据块时同时获得写租约
+        if (request->has_lease_expiration_time()) {
+            chunk_server_impl()->AddOrUpdateLease(
+                chunk_handle, request->lease_expiration_time().seconds());
+        }
         respond->set_status(protos::grpc::InitFileChunkRespond::CREATED);
         return grpc::Status::OK;
     } else if (google::protobuf::util::IsAlreadyExists(status)) {
@@ -68,16 +171,11 @@ grpc::Status ChunkServerFileServiceImpl::ReadFileChunk(
     const uint32_t& version = request->version();
     const uint32_t& offset = request->offset();
     const uint32_t& length = request->length();
+    DiskOpRecorder op_recorder(chunk_server_impl(), false);
 
-    LOG(INFO) << "Client address: " << context->peer();
-
-    //
-    LOG(INFO) << "try to read chunk, chunk_handle: " << chunk_handle
-              << ",version: " << version << ",offset: " << offset
-              << ",length: " << length;
-
-    // 计算从 leveldb 读取数据块的时间
-    auto start = std::chrono::high_resolution_clock::now();  // 记录开始时间
+    DFS_VLOG(1) << "read chunk " << chunk_handle << ", version: " << version
+                << ", offset: " << offset << ", length: " << length
+                << ", client: " << context->peer();
 
     auto read_status_or = file_chunk_manager()->ReadFromChunk(
         chunk_handle, version, offset, length);
@@ -120,18 +218,7 @@ grpc::Status ChunkServerFileServiceImpl::ReadFileChunk(
         return grpc::Status::OK;
     }
 
-    auto end = std::chrono::high_resolution_clock::now();  // 记录结束时间
-    double durationMs =
-        std::chrono::duration_cast<std::chrono::milliseconds>(end - start)
-            .count();
-
     const auto& read_data = read_status_or.value();
-    // LOG(INFO) << "read_data: " << read_data << "  "
-    //           << "length: " << read_data.size();
-
-    LOG(INFO) << "data length: " << read_data.size()
-              << ", spend: " << durationMs << "ms";
-
     respond->set_data(read_data);
     respond->set_read_length(read_data.size());
     respond->set_status(protos::grpc::ReadFileChunkRespond::OK);
@@ -147,30 +234,26 @@ grpc::Status ChunkServerFileServiceImpl::WriteFileChunk(
     const auto& header = request->header();
 
     if (!chunk_server_impl()->HasWriteLease(header.chunk_handle())) {
-        LOG(ERROR)
+        DFS_LOG_RATE_LIMITED(ERROR, 10)
             << "can not write to local chunk, because dont have write lease";
         return grpc::Status(grpc::StatusCode::PERMISSION_DENIED,
                             "no write lease");
     }
 
-    auto start = std::chrono::high_resolution_clock::now();  // 记录开始时间
     auto status = WriteFileChunkLocally(header, respond);
-    auto end = std::chrono::high_resolution_clock::now();  // 记录结束时间
-    double durationMs =
-        std::chrono::duration_cast<std::chrono::milliseconds>(end - start)
-            .count();
-    LOG(INFO) << "WriteFileChunkLocally spend " << durationMs << "ms";
 
     // write failed
     if (respond->status() != protos::grpc::FileChunkMutationStatus::OK) {
         return status;
     }
+    chunk_server_impl()->RecordLeaseWrite(header.chunk_handle());
 
+    // 依次通知其他副本，每个副本的 RPC 是该 span 的子 span
+    Span fan_out_span("ApplyMutationToReplicas");
     auto curr_location = chunk_server_impl()->GetChunkServerLocation();
-    LOG(INFO) << "this is primary chunk server, curr_location is "
-              << curr_location;
-
-    LOG(INFO) << "replica server size: " << request->locations_size();
+    DFS_VLOG(2) << "primary chunk server " << curr_location
+                << " applies mutation to " << request->locations_size()
+                << " replicas";
 
     // write successful
     // TODO: apply changes to other chunk server
@@ -184,8 +267,8 @@ grpc::Status ChunkServerFileServiceImpl::WriteFileChunk(
             continue;
         }
 
-        LOG(INFO) << "primary server try to apply mutation to chunk server: "
-                  << server_address;
+        DFS_VLOG(2) << "primary server try to apply mutation to chunk server: "
+                    << server_address;
 
         // 与其他块服务器进行通信
         auto client =
@@ -193,7 +276,7 @@ grpc::Status ChunkServerFileServiceImpl::WriteFileChunk(
                 server_address);
 
         if (!client) {
-            LOG(ERROR)
+            DFS_LOG_RATE_LIMITED(ERROR, 10)
                 << "can not get or create file service client, server_address: "
                 << server_address;
             continue;
@@ -228,20 +311,19 @@ grpc::Status ChunkServerFileServiceImpl::SendChunkData(
     // data too big
     if (request->data().size() >
         ConfigManager::GetInstance()->GetBlockSize() * dfs::common::bytesMB) {
-        LOG(ERROR) << "send chunk data is too big";
+        DFS_LOG_RATE_LIMITED(ERROR, 10) << "send chunk data is too big";
         respond->set_status(SendChunkDataRespond::DATA_TOO_BIG);
         return grpc::Status::OK;
     }
 
-    // 对比校验和
-    auto checksum = dfs::common::ComputeHash(request->data());
-    if (checksum != request->checksum()) {
-        LOG(ERROR) << "send chunk data checksum failed";
+    // 对比校验和，算法由校验和的第一个字节决定
+    if (!dfs::common::VerifyChecksum(request->checksum(), request->data())) {
+        DFS_LOG_RATE_LIMITED(ERROR, 10) << "send chunk data checksum failed";
         respond->set_status(SendChunkDataRespond::BAD_DATA);
         return grpc::Status::OK;
     }
 
-    LOG(INFO) << "caching data";
+    DFS_VLOG(2) << "caching data, checksum: " << request->checksum();
     ChunkCacheManager::GetInstance()->Set(request->checksum(), request->data());
     respond->set_status(SendChunkDataRespond::OK);
 
@@ -251,30 +333,30 @@ grpc::Status ChunkServerFileServiceImpl::SendChunkData(
 grpc::Status ChunkServerFileServiceImpl::WriteFileChunkLocally(
     const protos::grpc::WriteFileChunkRequestHeader& header,
     protos::grpc::WriteFileChunkRespond* respond) {
-    LOG(INFO) << "check data checksum: " << header.checksum()
-              << " chunk handle: " << header.chunk_handle();
+    DFS_VLOG(2) << "check data checksum: " << header.checksum()
+                << " chunk handle: " << header.chunk_handle();
     // get data from cache
     auto data_or = ChunkCacheManager::GetInstance()->Get(header.checksum());
     if (!data_or.ok()) {
-        LOG(ERROR) << "data not found in cache for checksum: "
-                   << header.checksum();
+        DFS_LOG_RATE_LIMITED(ERROR, 10)
+            << "data not found in cache for checksum: " << header.checksum();
         respond->set_status(FileChunkMutationStatus::NOT_FOUND);
         return grpc::Status::OK;
     }
 
-    auto start = std::chrono::high_resolution_clock::now();  // 记录开始时间
+    DiskOpRecorder op_recorder(chunk_server_impl(), true);
     // 将 cache 里读到的数据写入
+    Span write_span("WriteChunkLocally");
+    write_span.SetAttribute("bytes", header.length());
     auto write_result = file_chunk_manager()->WriteToChunk(
         header.chunk_handle(), header.version(), header.offset(),
         header.length(), data_or.value());
-    auto end = std::chrono::high_resolution_clock::now();  // 记录结束时间
-    double durationMs =
-        std::chrono::duration_cast<std::chrono::milliseconds>(end - start)
-            .count();
+    write_span.SetStatus(write_result.status());
 
-    LOG(INFO) << "write to leveldb " << durationMs << "ms";
-
-    LOG(INFO) << "write to local status: " + write_result.status().ToString();
+    DFS_VLOG(1) << "write chunk " << header.chunk_handle()
+                << ", offset: " << header.offset()
+                << ", length: " << header.length()
+                << ", status: " << write_result.status().ToString();
 
     if (write_result.ok()) {
         respond->set_write_length(write_result.value());
@@ -297,7 +379,7 @@ grpc::Status ChunkServerFileServiceImpl::ApplyMutation(
     grpc::ServerContext* context,
     const protos::grpc::ApplyMutationRequest* request,
     protos::grpc::ApplyMutationRespond* respond) {
-    LOG(INFO) << "ApplyMutationRequest";
+    DFS_VLOG(1) << "ApplyMutationRequest";
     // 应用对数据块的更改
     WriteFileChunkRespond write_respond;
     // 将数据写入本地
@@ -310,14 +392,14 @@ grpc::Status ChunkServerFileServiceImpl::AdjustFileChunkVersion(
     grpc::ServerContext* context,
     const protos::grpc::AdjustFileChunkVersionRequest* request,
     protos::grpc::AdjustFileChunkVersionRespond* respond) {
-    LOG(INFO) << "AdjustFileChunkVersionRequest";
+    DFS_VLOG(1) << "AdjustFileChunkVersionRequest";
     // 正常来说，在调整数据块版本时，我们只对版本号 +1
     const uint32_t old_version = request->new_chunk_version() - 1;
     auto update_version = file_chunk_manager()->UpdateChunkVersion(
         request->chunk_handle(), old_version, request->new_chunk_version());
     if (update_version.ok()) {
-        LOG(INFO) << "update file chunk " << request->chunk_handle()
-                  << " to version " << request->new_chunk_version();
+        DFS_VLOG(1) << "update file chunk " << request->chunk_handle()
+                    << " to version " << request->new_chunk_version();
         respond->set_status(AdjustFileChunkVersionRespond::OK);
         respond->set_chunk_version(request->new_chunk_version());
         return grpc::Status::OK;
@@ -381,48 +463,188 @@ grpc::Status ChunkServerFileServiceImpl::ChunkReplicaCopy(
     const protos::grpc::ChunkReplicaCopyRequest* request,
     protos::grpc::ChunkReplicaCopyRespond* respond) {
     const std::string chunk_handle = request->chunk_handle();
+    DiskOpRecorder op_recorder(chunk_server_impl(), false);
 
-    auto chunk_or = file_chunk_manager()->GetFileChunk(chunk_handle);
-    if (!chunk_or.ok()) {
-        return StatusProtobuf2Grpc(chunk_or.status());
+    // 按帧读取数据块，不将整个数据块复制到内存中
+    auto reader_or = file_chunk_manager()->OpenFileChunkReader(chunk_handle);
+    if (!reader_or.ok()) {
+        return StatusProtobuf2Grpc(reader_or.status());
     }
 
-    const FileChunk chunk = *(chunk_or.value());
+    auto reader = reader_or.value();
+    respond->set_chunk_size(reader->size());
 
-    // 创建数据块
-    for (const auto& location : request->locations()) {
-        // 获取服务器地址
-        const std::string server_address =
-            location.server_hostname() + ":" +
-            std::to_string(location.server_port());
+    const int location_nums = request->locations_size();
+    const auto copy_status =
+        CopyChunkReplicaToServers(*reader, chunk_handle, request->locations());
 
-        // 与其他块服务器进行通信
-        auto client =
-            chunk_server_impl()->GetOrCreateChunkServerFileServerClient(
-                server_address);
+    for (int i = 0; i < location_nums; i++) {
+        const auto& location = request->locations(i);
+        if (copy_status[i].ok()) {
+            LOG(INFO) << "successfully copy chunk " << chunk_handle
+                      << " replica to server " << location.server_hostname()
+                      << ":" << location.server_port();
+            *respond->add_copied_locations() = location;
+        } else {
+            LOG(ERROR) << "copy chunk " << chunk_handle << " replica to server "
+                       << location.server_hostname() << ":"
+                       << location.server_port() << " failed, because "
+                       << copy_status[i].ToString();
+        }
+    }
 
-        if (!client) {
-            LOG(ERROR) << "can not get or create file service client, "
-                       << "server_address : " << server_address;
-            continue;
+    return grpc::Status::OK;
+}
+
+std::vector<google::protobuf::util::Status>
+ChunkServerFileServiceImpl::CopyChunkReplicaToServers(
+    const FileChunkReader& reader, const std::string& chunk_handle,
+    const google::protobuf::RepeatedPtrField<protos::ChunkServerLocation>&
+        locations) {
+    // 并发地向所有目标块服务器发送数据块
+    const int location_nums = locations.size();
+    std::vector<google::protobuf::util::Status> copy_status(location_nums);
+    std::vector<std::thread> copy_threads;
+    const auto trace_context = CurrentTraceContext();
+    for (int i = 0; i < location_nums; i++) {
+        copy_threads.emplace_back([&, i]() {
+            ScopedTraceContext trace_scope(trace_context);
+            copy_status[i] = StreamChunkReplicaToServer(
+                reader, chunk_handle, LocationAddress(locations.Get(i)));
+        });
+    }
+
+    for (auto& copy_thread : copy_threads) {
+        copy_thread.join();
+    }
+    return copy_status;
+}
+
+google::protobuf::util::Status
+ChunkServerFileServiceImpl::StreamChunkReplicaToServer(
+    const FileChunkReader& reader, const std::string& chunk_handle,
+    const std::string& server_address) {
+    auto client =
+        chunk_server_impl()->GetOrCreateChunkServerFileServerClient(
+            server_address);
+    if (!client) {
+        return google::protobuf::util::UnavailableError(
+            "can not get or create file service client, server_address: " +
+            server_address);
+    }
+
+    const uint32_t retry_times =
+        ConfigManager::GetInstance()->GetReplicationStreamRetryTimes();
+    uint64_t acked_offset = 0;
+    google::protobuf::util::Status status;
+    for (uint32_t attempt = 0; attempt <= retry_times; attempt++) {
+        if (attempt > 0) {
+            LOG(WARNING) << "stream chunk " << chunk_handle << " to "
+                         << server_address << " failed, because "
+                         << status.ToString() << ", resume from offset "
+                         << acked_offset;
+            absl::SleepFor(kStreamRetryBackoff * attempt);
         }
 
-        ApplyChunkReplicaCopyRequest apply_req;
-        apply_req.set_chunk_handle(chunk_handle);
-        apply_req.mutable_chunk()->set_data(chunk.data());
-        apply_req.mutable_chunk()->set_version(chunk.version());
-        auto apply_status = client->SendRequest(apply_req);
-        if (apply_status.ok()) {
-            LOG(INFO) << "successfully apply chunk replica copy to server "
-                      << server_address;
-        } else {
-            LOG(ERROR) << "apply chunk replica copy to server "
-                       << server_address << " failed, because "
-                       << apply_status.status().ToString();
+        status = StreamChunkReplicaOnce(client.get(), reader, chunk_handle,
+                                        &acked_offset);
+        if (status.ok() || !IsStreamRetryable(status)) {
+            break;
         }
     }
 
-    return grpc::Status::OK;
+    return status;
+}
+
+google::protobuf::util::Status
+ChunkServerFileServiceImpl::StreamChunkReplicaOnce(
+    dfs::grpc_client::ChunkServerFileServiceClient* client,
+    const FileChunkReader& reader, const std::string& chunk_handle,
+    uint64_t* acked_offset) {
+    auto config_manager = ConfigManager::GetInstance();
+    const uint64_t frame_size =
+        std::max<uint64_t>(config_manager->GetReplicationFrameSizeKB(), 1) *
+        dfs::common::bytesKB;
+    // 未确认的数据不超过窗口大小，限制每个传输占用的内存
+    const uint64_t window_bytes =
+        frame_size *
+        std::max<uint32_t>(config_manager->GetReplicationWindowFrames(), 1);
+    // 每一帧的校验和只用于检查传输错误，默认使用 CRC32C
+    const auto frame_checksum = config_manager->GetFrameChecksumType();
+
+    grpc::ClientContext context;
+    Span span("StreamChunkReplicaCopy", &context);
+    auto stream = client->StreamChunkReplicaCopy(&context);
+
+    // 第一帧不携带数据，目标块服务器返回续传的偏移。压缩的数据块按压缩后的
+    // 数据复制，第一帧携带压缩信息
+    ChunkReplicaCopyFrame frame;
+    frame.set_chunk_handle(chunk_handle);
+    frame.set_version(reader.version());
+    frame.set_chunk_size(reader.size());
+    *frame.mutable_chunk_metadata() = reader.metadata();
+
+    ChunkReplicaCopyAck ack;
+    bool committed = false;
+    google::protobuf::util::Status read_status;
+    const bool header_sent = stream->Write(frame);
+    frame.clear_chunk_metadata();
+    if (header_sent && stream->Read(&ack)) {
+        *acked_offset = ack.acked_offset();
+        committed = ack.committed();
+
+        uint64_t next_offset = *acked_offset;
+        bool stream_ok = true;
+        while (stream_ok && !committed) {
+            while (next_offset < reader.size() &&
+                   next_offset - *acked_offset < window_bytes) {
+                frame.set_offset(next_offset);
+                auto data_or = reader.Read(next_offset, frame_size);
+                if (!data_or.ok()) {
+                    read_status = data_or.status();
+                    stream_ok = false;
+                    break;
+                }
+                frame.set_data(std::move(data_or.value()));
+                frame.set_checksum(
+                    dfs::common::ComputeChecksum(frame_checksum, frame.data()));
+                if (!stream->Write(frame)) {
+                    stream_ok = false;
+                    break;
+                }
+                next_offset += frame.data().size();
+            }
+
+            if (stream_ok && stream->Read(&ack)) {
+                *acked_offset = ack.acked_offset();
+                committed = ack.committed();
+            } else {
+                stream_ok = false;
+            }
+        }
+    }
+
+    if (!read_status.ok()) {
+        // 本地读取失败，不再等待目标块服务器的确认
+        context.TryCancel();
+    }
+    stream->WritesDone();
+    auto status = stream->Finish();
+    span.SetStatus(status);
+    if (!read_status.ok()) {
+        span.SetStatus(read_status);
+        return read_status;
+    }
+    if (!status.ok()) {
+        return StatusGrpc2Protobuf(status);
+    }
+
+    if (!committed) {
+        return google::protobuf::util::UnavailableError(
+            "stream closed before chunk " + chunk_handle + " committed");
+    }
+
+    return google::protobuf::util::OkStatus();
 }
 
 grpc::Status ChunkServerFileServiceImpl::ApplyChunkReplicaCopy(
@@ -431,22 +653,21 @@ grpc::Status ChunkServerFileServiceImpl::ApplyChunkReplicaCopy(
     protos::grpc::ApplyChunkReplicaCopyRespond* respond) {
     const std::string chunk_handle = request->chunk_handle();
     const FileChunk chunk = request->chunk();
+    DiskOpRecorder op_recorder(chunk_server_impl(), true);
 
     // 首先先创建数据块
-    auto create_status =
-        file_chunk_manager()->CreateChunk(chunk_handle, chunk.version());
+    auto create_status = file_chunk_manager()->CreateChunk(
+        chunk_handle, chunk.version(), IoPriority::REPLICATION);
     if (create_status.ok() || IsAlreadyExists(create_status)) {
         LOG(INFO) << "create a chunk for " << chunk_handle << " is ok";
         // 写入数据块
-        auto write_status =
-            file_chunk_manager()->WriteFileChunk(chunk_handle, chunk);
+        auto write_status = file_chunk_manager()->WriteFileChunk(
+            chunk_handle, chunk, IoPriority::REPLICATION);
         if (write_status.ok()) {
             LOG(INFO) << "ApplyChunkReplicaCopy ok";
             return grpc::Status::OK;
         } else {
-            return grpc::Status(grpc::StatusCode::UNKNOWN,
-                                "leveldb have something wrong, status: " +
-                                    write_status.ToString());
+            return StatusProtobuf2Grpc(write_status);
         }
 
     } else {
@@ -455,5 +676,345 @@ grpc::Status ChunkServerFileServiceImpl::ApplyChunkReplicaCopy(
     }
 }
 
+grpc::Status ChunkServerFileServiceImpl::StreamChunkReplicaCopy(
+    grpc::ServerContext* context,
+    grpc::ServerReaderWriter<ChunkReplicaCopyAck, ChunkReplicaCopyFrame>*
+        stream) {
+    // 第一帧携带数据块信息
+    ChunkReplicaCopyFrame frame;
+    if (!stream->Read(&frame)) {
+        return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                            "no chunk replica copy header");
+    }
+
+    const std::string chunk_handle = frame.chunk_handle();
+    const uint32_t version = frame.version();
+    const uint64_t chunk_size = frame.chunk_size();
+    // 压缩的数据块收到的是压缩后的数据，与压缩信息一起写入
+    const FileChunk chunk_metadata = frame.chunk_metadata();
+    if (chunk_size >
+        ConfigManager::GetInstance()->GetBlockSize() * dfs::common::bytesMB) {
+        return grpc::Status(grpc::StatusCode::OUT_OF_RANGE,
+                            "chunk replica is too big");
+    }
+
+    auto stager = file_chunk_manager()->GetChunkReplicaStager();
+    auto offset_or = stager->Begin(chunk_handle, version, chunk_size);
+    if (!offset_or.ok()) {
+        return StatusProtobuf2Grpc(offset_or.status());
+    }
+
+    ReplicaStagingGuard staging_guard(stager, chunk_handle);
+    DiskOpRecorder op_recorder(chunk_server_impl(), true);
+
+    uint64_t offset = offset_or.value();
+    LOG(INFO) << "receive chunk " << chunk_handle << " replica from "
+              << context->peer() << ", start from offset " << offset;
+
+    ChunkReplicaCopyAck ack;
+    while (offset < chunk_size) {
+        // 确认已经写入的偏移，第一次确认即为续传的偏移
+        ack.set_acked_offset(offset);
+        if (!stream->Write(ack) || !stream->Read(&frame)) {
+            return grpc::Status(grpc::StatusCode::CANCELLED,
+                                "stream closed at offset " +
+                                    std::to_string(offset));
+        }
+
+        if (frame.chunk_handle() != chunk_handle ||
+            frame.version() != version) {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                                "frame does not belong to chunk " +
+                                    chunk_handle);
+        }
+
+        if (!dfs::common::VerifyChecksum(frame.checksum(), frame.data())) {
+            LOG(ERROR) << "chunk " << chunk_handle
+                       << " replica checksum mismatch at offset "
+                       << frame.offset();
+            return grpc::Status(grpc::StatusCode::DATA_LOSS,
+                                "checksum mismatch at offset " +
+                                    std::to_string(frame.offset()));
+        }
+
+        auto append_or =
+            stager->Append(chunk_handle, frame.offset(), frame.data());
+        if (!append_or.ok()) {
+            return StatusProtobuf2Grpc(append_or.status());
+        }
+        offset = append_or.value();
+    }
+
+    // 数据块接收完整，逐片写入数据块存储，不在内存中保留整个数据块。
+    // 写入失败时暂存数据保留，源块服务器重试时直接提交
+    FileChunk chunk = chunk_metadata;
+    chunk.clear_size();
+    chunk.set_version(version);
+    auto commit_status = file_chunk_manager()->CommitReplicaChunk(
+        chunk_handle, chunk, IoPriority::REPLICATION);
+    if (!commit_status.ok()) {
+        return StatusProtobuf2Grpc(commit_status);
+    }
+
+    LOG(INFO) << "StreamChunkReplicaCopy of chunk " << chunk_handle << " ok";
+    ack.set_acked_offset(offset);
+    ack.set_committed(true);
+    stream->Write(ack);
+    return grpc::Status::OK;
+}
+
+grpc::Status ChunkServerFileServiceImpl::EncodeStripe(
+    grpc::ServerContext* context, const EncodeStripeRequest* request,
+    EncodeStripeRespond* respond) {
+    const uint32_t data_shards = request->data_shards();
+    const uint32_t parity_shards = request->parity_shards();
+    if (data_shards == 0 || parity_shards == 0 ||
+        data_shards + parity_shards > 256 ||
+        request->data_size() != data_shards ||
+        request->parity_size() != parity_shards) {
+        return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                            "invalid stripe layout");
+    }
+    for (const auto& parity : request->parity()) {
+        if (parity.chunk_handle().empty() || parity.locations().empty()) {
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                                "parity chunk has no handle or location");
+        }
+    }
+
+    DiskOpRecorder op_recorder(chunk_server_impl(), false);
+    ChunkStripeCoder coder(
+        data_shards, parity_shards, StripeCellSize(),
+        [this](const StripeShard& shard, uint64_t offset, uint64_t length) {
+            return ReadStripeShard(shard, offset, length);
+        });
+
+    // 校验块按段写入本地的暂存区，内存中只保留每个校验块的一段数据。
+    // 校验块的长度在编码完成前未知，以数据块大小的上限开始暂存
+    auto stager = file_chunk_manager()->GetChunkReplicaStager();
+    ParityStagingGuard staging_guard(stager);
+    const uint64_t max_chunk_size =
+        ConfigManager::GetInstance()->GetBlockSize() * dfs::common::bytesMB;
+    for (const auto& shard : request->parity()) {
+        const std::string staging_name =
+            ParityStagingName(shard.chunk_handle());
+        auto begin_or =
+            stager->Begin(staging_name, shard.version(), max_chunk_size);
+        if (!begin_or.ok()) {
+            return StatusProtobuf2Grpc(begin_or.status());
+        }
+        staging_guard.Add(staging_name);
+    }
+
+    const std::vector<StripeShard> data(request->data().begin(),
+                                        request->data().end());
+    std::vector<uint64_t> data_sizes;
+    auto encode_status = coder.Encode(
+        data,
+        [&](uint64_t offset, const std::vector<std::string>& parity_cells)
+            -> google::protobuf::util::Status {
+            for (uint32_t i = 0; i < parity_shards; i++) {
+                auto append_or = stager->Append(
+                    ParityStagingName(request->parity(i).chunk_handle()),
+                    offset, parity_cells[i]);
+                if (!append_or.ok()) {
+                    return append_or.status();
+                }
+            }
+            return google::protobuf::util::OkStatus();
+        },
+        &data_sizes);
+    if (!encode_status.ok()) {
+        LOG(ERROR) << "encode stripe failed, because "
+                   << encode_status.ToString();
+        return StatusProtobuf2Grpc(encode_status);
+    }
+
+    // 校验块不压缩，与数据块副本一样以流的方式复制到其他块服务器，
+    // 位于本地的校验块直接从暂存区提交
+    const std::string curr_location =
+        chunk_server_impl()->GetChunkServerLocation();
+    for (const auto& shard : request->parity()) {
+        const std::string& chunk_handle = shard.chunk_handle();
+        const std::string staging_name = ParityStagingName(chunk_handle);
+        FileChunk metadata;
+        metadata.set_version(shard.version());
+
+        bool store_locally = false;
+        google::protobuf::RepeatedPtrField<protos::ChunkServerLocation>
+            remote_locations;
+        for (const auto& location : shard.locations()) {
+            if (LocationAddress(location) == curr_location) {
+                store_locally = true;
+            } else {
+                *remote_locations.Add() = location;
+            }
+        }
+
+        auto write_status = stager->Seal(staging_name);
+        if (write_status.ok() && !remote_locations.empty()) {
+            auto reader_or = file_chunk_manager()->OpenStagedChunkReader(
+                staging_name, metadata);
+            if (!reader_or.ok()) {
+                write_status = reader_or.status();
+            } else {
+                const auto copy_status = CopyChunkReplicaToServers(
+                    *reader_or.value(), chunk_handle, remote_locations);
+                for (const auto& status : copy_status) {
+                    if (!status.ok()) {
+                        write_status = status;
+                        break;
+                    }
+                }
+            }
+        }
+        if (write_status.ok() && store_locally) {
+            write_status = file_chunk_manager()->CommitReplicaChunk(
+                chunk_handle, metadata, IoPriority::REPLICATION, staging_name);
+        }
+        if (!write_status.ok()) {
+            LOG(ERROR) << "write parity chunk " << chunk_handle << " failed, "
+                       << "because " << write_status.ToString();
+            return StatusProtobuf2Grpc(write_status);
+        }
+    }
+
+    uint64_t parity_size = 0;
+    for (const auto& size : data_sizes) {
+        respond->add_data_sizes(size);
+        parity_size = std::max(parity_size, size);
+    }
+    respond->set_parity_size(parity_size);
+    LOG(INFO) << "encode stripe of chunk " << request->data(0).chunk_handle()
+              << " ok, parity size: " << parity_size;
+    return grpc::Status::OK;
+}
+
+grpc::Status ChunkServerFileServiceImpl::ReconstructChunk(
+    grpc::ServerContext* context, const ReconstructChunkRequest* request,
+    ReconstructChunkRespond* respond) {
+    const uint32_t data_shards = request->data_shards();
+    const uint32_t parity_shards = request->parity_shards();
+    if (data_shards == 0 || parity_shards == 0 ||
+        data_shards + parity_shards > 256 ||
+        request->shards_size() != data_shards + parity_shards ||
+        request->shard_index() >= data_shards + parity_shards) {
+        return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                            "invalid stripe layout");
+    }
+
+    const auto& target = request->shards(request->shard_index());
+    DiskOpRecorder op_recorder(chunk_server_impl(), true);
+    ChunkStripeCoder coder(
+        data_shards, parity_shards, StripeCellSize(),
+        [this](const StripeShard& shard, uint64_t offset, uint64_t length) {
+            return ReadStripeShard(shard, offset, length);
+        });
+
+    const std::vector<StripeShard> shards(request->shards().begin(),
+                                          request->shards().end());
+    std::vector<uint32_t> read_shards;
+    auto data_or =
+        coder.Reconstruct(shards, request->shard_index(), &read_shards);
+    if (!data_or.ok()) {
+        LOG(ERROR) << "reconstruct chunk " << target.chunk_handle()
+                   << " failed, because " << data_or.status().ToString();
+        return StatusProtobuf2Grpc(data_or.status());
+    }
+
+    // 数据块按文件的压缩算法保存，校验块不压缩
+    FileChunk chunk;
+    chunk.set_version(target.version());
+    if (request->shard_index() < data_shards) {
+        chunk.set_codec(request->codec());
+    }
+    chunk.set_data(std::move(data_or.value()));
+    const uint64_t chunk_size = chunk.data().size();
+    auto store_status = StoreChunkLocally(target.chunk_handle(), chunk);
+    if (!store_status.ok()) {
+        return StatusProtobuf2Grpc(store_status);
+    }
+
+    respond->set_chunk_size(chunk_size);
+    respond->mutable_read_shards()->Add(read_shards.begin(),
+                                        read_shards.end());
+    LOG(INFO) << "reconstruct chunk " << target.chunk_handle() << " ok, size: "
+              << chunk_size;
+    return grpc::Status::OK;
+}
+
+google::protobuf::util::StatusOr<std::string>
+ChunkServerFileServiceImpl::ReadStripeShard(const StripeShard& shard,
+                                            uint64_t offset, uint64_t length) {
+    // 分片在本地时不需要经过网络
+    auto version_or = file_chunk_manager()->GetChunkVersion(shard.chunk_handle());
+    if (version_or.ok() && version_or.value() == shard.version()) {
+        auto data_or = file_chunk_manager()->ReadFromChunk(
+            shard.chunk_handle(), shard.version(), offset, length);
+        if (data_or.ok()) {
+            return data_or;
+        } else if (google::protobuf::util::IsOutOfRange(data_or.status())) {
+            return std::string();
+        }
+        LOG(WARNING) << "read local shard " << shard.chunk_handle()
+                     << " failed, because " << data_or.status().ToString();
+    }
+
+    const std::string curr_location =
+        chunk_server_impl()->GetChunkServerLocation();
+    ReadFileChunkRequest request;
+    request.set_chunk_handle(shard.chunk_handle());
+    request.set_version(shard.version());
+    request.set_offset(offset);
+    request.set_length(length);
+    for (const auto& location : shard.locations()) {
+        const std::string server_address = LocationAddress(location);
+        if (server_address == curr_location) {
+            continue;
+        }
+        auto client =
+            chunk_server_impl()->GetOrCreateChunkServerFileServerClient(
+                server_address);
+        if (!client) {
+            continue;
+        }
+
+        auto respond_or = client->SendRequest(request);
+        if (!respond_or.ok()) {
+            LOG(WARNING) << "read shard " << shard.chunk_handle() << " from "
+                         << server_address << " failed, because "
+                         << respond_or.status().ToString();
+            continue;
+        }
+        const auto& respond = respond_or.value();
+        if (respond.status() == ReadFileChunkRespond::OK) {
+            return respond.data();
+        } else if (respond.status() == ReadFileChunkRespond::OUT_OF_RANGE) {
+            return std::string();
+        }
+    }
+
+    return google::protobuf::util::UnavailableError(
+        "no live location of shard " + shard.chunk_handle());
+}
+
+google::protobuf::util::Status ChunkServerFileServiceImpl::StoreChunkLocally(
+    const std::string& chunk_handle, const FileChunk& chunk) {
+    auto create_status = file_chunk_manager()->CreateChunk(
+        chunk_handle, chunk.version(), IoPriority::REPLICATION, chunk.codec());
+    if (!create_status.ok() && !IsAlreadyExists(create_status)) {
+        return create_status;
+    }
+    return file_chunk_manager()->WriteFileChunk(chunk_handle, chunk,
+                                                IoPriority::REPLICATION);
+}
+
+uint64_t ChunkServerFileServiceImpl::StripeCellSize() const {
+    // 与流式复制的帧大小相同，单次读取的数据不超过 gRPC 默认的消息大小
+    return std::max<uint64_t>(
+               ConfigManager::GetInstance()->GetReplicationFrameSizeKB(), 1) *
+           dfs::common::bytesKB;
+}
+
 }  // namespace server
-}  // namespace dfs
\ No newline at end of file
+}  // namespace dfs
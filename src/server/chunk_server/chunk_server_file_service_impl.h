@@ -2,8 +2,9 @@
 #define DFS_SERVER_CHUNK_SERVER_FILE_SERVICE_IMPL_H
 
 #include "chunk_server_file_service.grpc.pb.h"
-#include "src/server/chunk_server/file_chunk_manager.h"
 #include "src/server/chunk_server/chunk_server_impl.h"
+#include "src/server/chunk_server/chunk_stripe_coder.h"
+#include "src/server/chunk_server/file_chunk_manager.h"
 
 namespace dfs {
 namespace server {
@@ -59,6 +60,25 @@ class ChunkServerFileServiceImpl final
         const protos::grpc::ApplyChunkReplicaCopyRequest* request,
         protos::grpc::ApplyChunkReplicaCopyRespond* respond) override;
 
+    // 源块服务器调用，以帧为单位接收数据块副本，逐帧校验并确认
+    grpc::Status StreamChunkReplicaCopy(
+        grpc::ServerContext* context,
+        grpc::ServerReaderWriter<protos::grpc::ChunkReplicaCopyAck,
+                                 protos::grpc::ChunkReplicaCopyFrame>* stream)
+        override;
+
+    // 主服务器调用，计算条带的校验块并写入校验块所在的块服务器
+    grpc::Status EncodeStripe(
+        grpc::ServerContext* context,
+        const protos::grpc::EncodeStripeRequest* request,
+        protos::grpc::EncodeStripeRespond* respond) override;
+
+    // 主服务器调用，从条带的其他分片重建丢失的分片并保存在本地
+    grpc::Status ReconstructChunk(
+        grpc::ServerContext* context,
+        const protos::grpc::ReconstructChunkRequest* request,
+        protos::grpc::ReconstructChunkRespond* respond) override;
+
    private:
     FileChunkManager* file_chunk_manager();
 
@@ -67,6 +87,37 @@ class ChunkServerFileServiceImpl final
     grpc::Status WriteFileChunkLocally(
         const protos::grpc::WriteFileChunkRequestHeader& header,
         protos::grpc::WriteFileChunkRespond* respond);
+
+    // 并发地将数据块以流的方式复制到 locations 中的每个块服务器，
+    // 返回每个位置的复制结果
+    std::vector<google::protobuf::util::Status> CopyChunkReplicaToServers(
+        const FileChunkReader& reader, const std::string& chunk_handle,
+        const google::protobuf::RepeatedPtrField<protos::ChunkServerLocation>&
+            locations);
+
+    // 将数据块以流的方式发送给一个块服务器，失败后从已确认的偏移处续传
+    google::protobuf::util::Status StreamChunkReplicaToServer(
+        const FileChunkReader& reader, const std::string& chunk_handle,
+        const std::string& server_address);
+
+    // 一次流式传输，acked_offset 为目标块服务器已经确认的偏移
+    google::protobuf::util::Status StreamChunkReplicaOnce(
+        dfs::grpc_client::ChunkServerFileServiceClient* client,
+        const FileChunkReader& reader, const std::string& chunk_handle,
+        uint64_t* acked_offset);
+
+    // 读取条带分片的一段数据，先读本地，再依次读取保存分片的块服务器，
+    // 分片末尾之后的部分返回空
+    google::protobuf::util::StatusOr<std::string> ReadStripeShard(
+        const protos::grpc::StripeShard& shard, uint64_t offset,
+        uint64_t length);
+
+    // 将完整的数据块写入本地，数据块不存在时先创建
+    google::protobuf::util::Status StoreChunkLocally(
+        const std::string& chunk_handle, const protos::FileChunk& chunk);
+
+    // 条带编码与重建时每次读取的长度
+    uint64_t StripeCellSize() const;
 };
 
 }  // namespace server
@@ -2,14 +2,19 @@
 
 #include <absl/time/time.h>
 
+#include <algorithm>
+#include <random>
+
 #include "src/common/config_manager.h"
 #include "src/common/system_logger.h"
+#include "src/server/chunk_server/chunk_cache_manager.h"
 
 namespace dfs {
 namespace server {
 
 using dfs::grpc_client::ChunkServerFileServiceClient;
 using dfs::grpc_client::ChunkServerManagerServiceClient;
+using protos::ChunkServerLoad;
 using protos::grpc::ReportChunkServerRequest;
 
 ChunkServerImpl* ChunkServerImpl::GetInstance() {
@@ -25,6 +30,10 @@ bool ChunkServerImpl::Initialize(const std::string& server_name,
     chunk_server_name_ = server_name;
     server_address_ = config_manager_->GetChunkServerAddress(server_name);
     server_port_ = config_manager_->GetChunkServerPort(server_name);
+    report_interval_ms_ = config_manager_->GetHeartBeatIntervalMs();
+    report_jitter_ms_ = config_manager_->GetHeartBeatJitterMs();
+    full_report_interval_ =
+        absl::Milliseconds(config_manager_->GetHeartBeatFullReportIntervalMs());
     return true;
 }
 
@@ -35,20 +44,56 @@ bool ChunkServerImpl::ReportToMaster() {
     auto chunk_server_location = chunk_server->mutable_location();
     chunk_server_location->set_server_hostname(server_address_);
     chunk_server_location->set_server_port(server_port_);
+    chunk_server->set_available_disk_mb(
+        FileChunkManager::GetInstance()->GetAvailableDiskMb());
+    *chunk_server->mutable_load() = CollectLoad();
 
-    auto all_chunk_data =
-        FileChunkManager::GetInstance()->GetAllFileChunkMetadata();
+    // 大多数汇报只是心跳，只有间隔到期或主服务器要求时才扫描全部数据块
+    const absl::Time now = absl::Now();
+    const bool full_report = full_report_requested_.load() ||
+                             now - last_full_report_time_ >=
+                                 full_report_interval_;
+    if (full_report) {
+        request.set_full_report(true);
+        auto all_chunk_data =
+            FileChunkManager::GetInstance()->GetAllFileChunkMetadata();
 
-    for (const auto& metadata : all_chunk_data) {
-        //
-        chunk_server->add_stored_chunk_handles(metadata.chunk_handle());
-        LOG(INFO) << "store chunk handle: " << metadata.chunk_handle();
+        for (const auto& metadata : all_chunk_data) {
+            //
+            chunk_server->add_stored_chunk_handles(metadata.chunk_handle());
+            DFS_VLOG(2) << "store chunk handle: " << metadata.chunk_handle();
+        }
+    }
+
+    // 正在写入的数据块随汇报一起续租，写入期间不需要重新申请租约
+    const auto written_lease_chunks = TakeWrittenLeaseChunks();
+    for (const auto& chunk_handle : written_lease_chunks) {
+        request.add_writing_chunk_handles(chunk_handle);
     }
 
     // report to master
     auto respond = master_server_client_->SendRequest(request);
     if (respond.ok()) {
         // ok, handle respond
+        if (full_report) {
+            last_full_report_time_ = now;
+            full_report_requested_.store(false);
+        }
+        if (respond.value().request_full_report()) {
+            full_report_requested_.store(true);
+        }
+
+        if (respond.value().report_interval_ms() > 0) {
+            report_interval_ms_ = respond.value().report_interval_ms();
+        }
+
+        for (const auto& extension : respond.value().lease_extensions()) {
+            DFS_VLOG(2) << "extend lease of chunk handle: "
+                        << extension.chunk_handle();
+            ExtendLease(extension.chunk_handle(),
+                        extension.lease_expiration_time().seconds());
+        }
+
         auto delete_chunk_handles = respond.value().delete_chunk_handles();
         for (const auto& chunk_handle : delete_chunk_handles) {
             LOG(INFO) << "start delete chunk handle: " << chunk_handle;
@@ -62,6 +107,10 @@ bool ChunkServerImpl::ReportToMaster() {
     } else {
         // handle error
         LOG(ERROR) << "master server client not responding " << respond.status();
+        // 下一次汇报时重新请求续租
+        for (const auto& chunk_handle : written_lease_chunks) {
+            RecordLeaseWrite(chunk_handle);
+        }
         return false;
     }
 
@@ -70,17 +119,22 @@ bool ChunkServerImpl::ReportToMaster() {
 
 void ChunkServerImpl::StartReportToMaster() {
     chunk_report_thread_ = std::make_unique<std::thread>(std::thread([&]() {
+        std::mt19937 random_engine(std::random_device{}());
         while (!stop_report_thread_.load()) {
-            // report to master
+            // report to master，汇报同时也是块服务器的心跳
             if (!ReportToMaster()) {
                 LOG(ERROR) << "failed to report master server";
             }
 
-            LOG(INFO) << "report to master";
+            DFS_VLOG(1) << "report to master";
 
-            // TODO: use config file
-            int64_t sleep_sec = 10;
-            std::this_thread::sleep_for(std::chrono::seconds(sleep_sec));
+            // 加上随机抖动，避免所有块服务器同时汇报
+            uint32_t sleep_ms = report_interval_ms_.load();
+            if (report_jitter_ms_ > 0) {
+                sleep_ms += std::uniform_int_distribution<uint32_t>(
+                    0, report_jitter_ms_ - 1)(random_engine);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms));
         }
     }));
 }
@@ -112,9 +166,19 @@ void ChunkServerImpl::AddOrUpdateLease(const std::string& chunk_handle,
     lease_unix_sec_[chunk_handle] = expiration_unix_sec;
 }
 
-void ChunkServerImpl::RemoveLease(const std::string& chunk_handle) {
+void ChunkServerImpl::ExtendLease(const std::string& chunk_handle,
+                                  const uint64_t& expiration_unix_sec) {
     absl::WriterMutexLock lease_unix_sec_lock_guard(&lease_unix_sec_lock_);
-    lease_unix_sec_.erase(chunk_handle);
+    auto iter = lease_unix_sec_.find(chunk_handle);
+    if (iter != lease_unix_sec_.end()) {
+        iter->second = std::max(iter->second, expiration_unix_sec);
+    }
+}
+
+bool ChunkServerImpl::RemoveLease(const std::string& chunk_handle) {
+    absl::WriterMutexLock lease_unix_sec_lock_guard(&lease_unix_sec_lock_);
+    written_lease_chunks_.erase(chunk_handle);
+    return lease_unix_sec_.erase(chunk_handle) > 0;
 }
 
 bool ChunkServerImpl::HasWriteLease(const std::string& chunk_handle) {
@@ -126,6 +190,21 @@ bool ChunkServerImpl::HasWriteLease(const std::string& chunk_handle) {
     return absl::Now() < absl::FromUnixSeconds(lease_unix_sec_[chunk_handle]);
 }
 
+void ChunkServerImpl::RecordLeaseWrite(const std::string& chunk_handle) {
+    absl::WriterMutexLock lease_unix_sec_lock_guard(&lease_unix_sec_lock_);
+    if (lease_unix_sec_.contains(chunk_handle)) {
+        written_lease_chunks_.insert(chunk_handle);
+    }
+}
+
+std::vector<std::string> ChunkServerImpl::TakeWrittenLeaseChunks() {
+    absl::WriterMutexLock lease_unix_sec_lock_guard(&lease_unix_sec_lock_);
+    std::vector<std::string> chunk_handles(written_lease_chunks_.begin(),
+                                           written_lease_chunks_.end());
+    written_lease_chunks_.clear();
+    return chunk_handles;
+}
+
 std::shared_ptr<dfs::grpc_client::ChunkServerFileServiceClient>
 ChunkServerImpl::GetOrCreateChunkServerFileServerClient(
     const std::string& server_address) {
@@ -151,5 +230,44 @@ std::string ChunkServerImpl::GetChunkServerLocation() const {
     return server_address_ + ":" + std::to_string(server_port_);
 }
 
+void ChunkServerImpl::BeginReadOp() {
+    read_ops_.fetch_add(1);
+    queue_depth_.fetch_add(1);
+}
+
+void ChunkServerImpl::BeginWriteOp() {
+    write_ops_.fetch_add(1);
+    queue_depth_.fetch_add(1);
+}
+
+void ChunkServerImpl::EndOp() { queue_depth_.fetch_sub(1); }
+
+ChunkServerLoad ChunkServerImpl::CollectLoad() {
+    ChunkServerLoad load;
+
+    const absl::Time now = absl::Now();
+    const double elapsed_sec =
+        absl::ToDoubleSeconds(now - last_collect_time_);
+    const uint64_t read_ops = read_ops_.load();
+    const uint64_t write_ops = write_ops_.load();
+
+    if (elapsed_sec > 0) {
+        load.set_read_iops((read_ops - last_read_ops_) / elapsed_sec);
+        load.set_write_iops((write_ops - last_write_ops_) / elapsed_sec);
+    }
+    load.set_queue_depth(queue_depth_.load());
+    load.set_cache_bytes(ChunkCacheManager::GetInstance()->GetCachedBytes());
+    auto block_cache = FileChunkManager::GetInstance()->GetChunkBlockCache();
+    if (block_cache) {
+        load.set_block_cache_bytes(block_cache->GetResidentBytes());
+        load.set_block_cache_hit_rate(block_cache->GetHitRate());
+    }
+
+    last_read_ops_ = read_ops;
+    last_write_ops_ = write_ops;
+    last_collect_time_ = now;
+    return load;
+}
+
 }  // namespace server
-}  // namespace dfs
\ No newline at end of file
+}  // namespace dfs
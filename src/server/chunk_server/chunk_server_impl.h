@@ -1,9 +1,13 @@
 #ifndef DFS_SERVER_CHUNK_SERVER_IMPL_H
 #define DFS_SERVER_CHUNK_SERVER_IMPL_H
 
+#include <absl/container/flat_hash_set.h>
+#include <absl/time/time.h>
+
 #include <atomic>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include "src/common/config_manager.h"
 #include "src/grpc_client/chunk_server_file_service_client.h"
@@ -20,7 +24,8 @@ class ChunkServerImpl {
     bool Initialize(const std::string& server_name,
                     dfs::common::ConfigManager* config_manager);
 
-    // 向主服务器汇报信息，并处理已删除的数据块
+    // 向主服务器汇报负载并续约，间隔到期时汇报完整的数据块清单，
+    // 并处理已删除的数据块
     bool ReportToMaster();
 
     // 创建后台线程用于定期向主服务器汇报信息
@@ -38,15 +43,39 @@ class ChunkServerImpl {
     void AddOrUpdateLease(const std::string& chunk_handle,
                           const uint64_t& expiration_unix_sec);
 
-    void RemoveLease(const std::string& chunk_handle);
+    // 延长已有的租约，租约已经被撤销时不做任何事
+    void ExtendLease(const std::string& chunk_handle,
+                     const uint64_t& expiration_unix_sec);
+
+    // 撤销租约，返回撤销前是否持有该租约
+    bool RemoveLease(const std::string& chunk_handle);
 
     bool HasWriteLease(const std::string& chunk_handle);
 
+    // 记录一次持有租约的写入，汇报时请求主服务器延长该租约
+    void RecordLeaseWrite(const std::string& chunk_handle);
+
+    // 取出上一次汇报以来有写入的租约数据块
+    std::vector<std::string> TakeWrittenLeaseChunks();
+
     std::shared_ptr<dfs::grpc_client::ChunkServerFileServiceClient>
     GetOrCreateChunkServerFileServerClient(const std::string& server_address);
 
     std::string GetChunkServerLocation() const;
 
+    // 负载统计，随汇报一起发送给主服务器
+    // 开始一次读磁盘请求
+    void BeginReadOp();
+
+    // 开始一次写磁盘请求
+    void BeginWriteOp();
+
+    // 结束一次读写磁盘请求
+    void EndOp();
+
+    // 计算自上一次调用以来的负载，仅由汇报线程调用
+    protos::ChunkServerLoad CollectLoad();
+
    private:
     ChunkServerImpl() = default;
 
@@ -57,6 +86,17 @@ class ChunkServerImpl {
     std::string server_address_;
     uint32_t server_port_;
 
+    // 下一次汇报的间隔，主服务器可以通过汇报的回复调整
+    std::atomic<uint32_t> report_interval_ms_{0};
+    uint32_t report_jitter_ms_ = 0;
+
+    // 完整数据块清单的汇报间隔，以及上一次成功汇报清单的时间，
+    // 仅由汇报线程访问
+    absl::Duration full_report_interval_ = absl::Minutes(1);
+    absl::Time last_full_report_time_ = absl::InfinitePast();
+    // 主服务器要求下一次汇报携带完整清单，启动后的第一次汇报总是完整的
+    std::atomic<bool> full_report_requested_{true};
+
     // A special thread, scheduled to execute ReportToMaster
     std::unique_ptr<std::thread> chunk_report_thread_;
     // to stop chunk_report_thread
@@ -67,6 +107,8 @@ class ChunkServerImpl {
 
     // 租约
     absl::flat_hash_map<std::string, uint64_t> lease_unix_sec_;
+    // 上一次汇报以来有写入的租约数据块
+    absl::flat_hash_set<std::string> written_lease_chunks_;
     // 锁
     absl::Mutex lease_unix_sec_lock_;
 
@@ -76,6 +118,16 @@ class ChunkServerImpl {
         chunk_server_file_server_clients_;
 
     absl::Mutex chunk_server_file_server_clients_lock_;
+
+    // 累计的读写请求数，以及正在处理的请求数
+    std::atomic<uint64_t> read_ops_{0};
+    std::atomic<uint64_t> write_ops_{0};
+    std::atomic<uint32_t> queue_depth_{0};
+
+    // 上一次计算负载时的状态，仅由汇报线程访问
+    uint64_t last_read_ops_ = 0;
+    uint64_t last_write_ops_ = 0;
+    absl::Time last_collect_time_ = absl::Now();
 };
 
 }  // namespace server
@@ -15,52 +15,79 @@ grpc::Status ChunkServerLeaseServiceImpl::GrantLease(
     grpc::ServerContext* context,
     const protos::grpc::GrantLeaseRequest* request,
     protos::grpc::GrantLeaseRespond* respond) {
-    // 从请求中获取相应信息
-    const auto& chunk_handle = request->chunk_handle();
-    const auto& chunk_version = request->chunk_version();
-    LOG(INFO) << "GrantLease for " << chunk_handle;
+    const uint64_t expiration_unix_sec =
+        request->lease_expiration_time().seconds();
+    DFS_VLOG(1) << "GrantLease for " << request->chunk_handle() << " and "
+                << request->batch_size() << " batched chunks";
+
+    auto status_or = GrantChunkLease(request->chunk_handle(),
+                                     request->chunk_version(),
+                                     expiration_unix_sec);
+    if (!status_or.ok()) {
+        respond->set_status(GrantLeaseRespond::UNKNOW);
+        return StatusProtobuf2Grpc(status_or.status());
+    }
+    respond->set_status(status_or.value());
+
+    // 同一批的其他数据块，单个数据块失败不影响其他数据块
+    for (const auto& lease_chunk : request->batch()) {
+        auto batch_status_or =
+            GrantChunkLease(lease_chunk.chunk_handle(),
+                            lease_chunk.chunk_version(), expiration_unix_sec);
+        respond->add_batch_status(batch_status_or.ok()
+                                      ? batch_status_or.value()
+                                      : GrantLeaseRespond::UNKNOW);
+    }
+    return grpc::Status::OK;
+}
+
+grpc::Status ChunkServerLeaseServiceImpl::RevokeLease(
+    grpc::ServerContext* context,
+    const protos::grpc::RevokeLeaseRequest* request,
+    protos::grpc::RevokeLeaseRespond* respond) {
+    for (const auto& chunk_handle : request->chunk_handles()) {
+        if (ChunkServerImpl::GetInstance()->RemoveLease(chunk_handle)) {
+            LOG(INFO) << "revoke lease for " << chunk_handle;
+            respond->add_revoked_chunk_handles(chunk_handle);
+        }
+    }
+    return grpc::Status::OK;
+}
+
+google::protobuf::util::StatusOr<
+    protos::grpc::GrantLeaseRespond::GrantLeaseRespondStatus>
+ChunkServerLeaseServiceImpl::GrantChunkLease(const std::string& chunk_handle,
+                                             uint32_t chunk_version,
+                                             uint64_t expiration_unix_sec) {
     auto owned_version_or =
         ChunkServerImpl::GetInstance()->GetChunkVersion(chunk_handle);
     if (!owned_version_or.ok()) {
         if (IsNotFound(owned_version_or.status())) {
             LOG(INFO) << "can not accept lease " << chunk_handle
                       << " done't exist on this chunk server";
-            respond->set_status(GrantLeaseRespond::REJECTED_NOT_FOUND);
-            return grpc::Status::OK;
+            return GrantLeaseRespond::REJECTED_NOT_FOUND;
         } else {
             LOG(ERROR) << "can not accept lease " << chunk_handle << " because "
                        << owned_version_or.status().ToString();
-            respond->set_status(GrantLeaseRespond::UNKNOW);
-            return StatusProtobuf2Grpc(owned_version_or.status());
+            return owned_version_or.status();
         }
     } else if (chunk_version != owned_version_or.value()) {
         LOG(INFO) << "can not accept lease " << chunk_handle
                   << " because request version is " << chunk_version
                   << " but owned version is " << owned_version_or.value();
-        respond->set_status(GrantLeaseRespond::REJECTED_VERSION);
-        return grpc::Status::OK;
-    } else if (absl::Now() > absl::FromUnixSeconds(
-                                 request->lease_expiration_time().seconds())) {
+        return GrantLeaseRespond::REJECTED_VERSION;
+    } else if (absl::Now() > absl::FromUnixSeconds(expiration_unix_sec)) {
         LOG(INFO) << "can not accept lease " << chunk_handle
                   << " because the given lease is already expired";
-        respond->set_status(GrantLeaseRespond::REJECTED_EXPIRED);
-        return grpc::Status::OK;
+        return GrantLeaseRespond::REJECTED_EXPIRED;
     } else {
         //
-        LOG(INFO) << "accept lease for " << chunk_handle;
-        ChunkServerImpl::GetInstance()->AddOrUpdateLease(
-            chunk_handle, request->lease_expiration_time().seconds());
-        respond->set_status(GrantLeaseRespond::ACCEPTED);
-        return grpc::Status::OK;
+        DFS_VLOG(1) << "accept lease for " << chunk_handle;
+        ChunkServerImpl::GetInstance()->AddOrUpdateLease(chunk_handle,
+                                                         expiration_unix_sec);
+        return GrantLeaseRespond::ACCEPTED;
     }
 }
 
-grpc::Status ChunkServerLeaseServiceImpl::RevokeLease(
-    grpc::ServerContext* context,
-    const protos::grpc::RevokeLeaseRequest* request,
-    protos::grpc::RevokeLeaseRespond* respond) {
-    return grpc::Status::OK;
-}
-
 }  // namespace server
-}  // namespace dfs
\ No newline at end of file
+}  // namespace dfs
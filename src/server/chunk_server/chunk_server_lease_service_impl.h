@@ -1,7 +1,10 @@
 #ifndef DFS_SERVER_CHUNK_SERVER_LEASE_SERVICE_IMPL_H
 #define DFS_SERVER_CHUNK_SERVER_LEASE_SERVICE_IMPL_H
 
+#include <string>
+
 #include "chunk_server_lease_service.grpc.pb.h"
+#include "google/protobuf/stubs/statusor.h"
 
 namespace dfs {
 namespace server {
@@ -17,6 +20,13 @@ class ChunkServerLeaseServiceImpl final
         grpc::ServerContext* context,
         const protos::grpc::RevokeLeaseRequest* request,
         protos::grpc::RevokeLeaseRespond* respond) override;
+
+   private:
+    // 检查数据块与版本后授予租约，返回申请状态
+    google::protobuf::util::StatusOr<
+        protos::grpc::GrantLeaseRespond::GrantLeaseRespondStatus>
+    GrantChunkLease(const std::string& chunk_handle, uint32_t chunk_version,
+                    uint64_t expiration_unix_sec);
 };
 
 }  // namespace server
@@ -2,19 +2,31 @@
 
 #include <memory>
 
+#include "src/common/async_server_runtime.h"
 #include "src/common/config_manager.h"
+#include "src/common/metrics_server.h"
 #include "src/common/system_logger.h"
+#include "src/common/tracing.h"
 #include "src/common/utils.h"
+#include "src/server/chunk_server/chunk_server_async_services.h"
 #include "src/server/chunk_server/chunk_server_control_service_impl.h"
 #include "src/server/chunk_server/chunk_server_file_service_impl.h"
 #include "src/server/chunk_server/chunk_server_impl.h"
 #include "src/server/chunk_server/chunk_server_lease_service_impl.h"
 
+using dfs::common::AsyncServerRuntime;
 using dfs::common::ConfigManager;
+using dfs::common::MetricsRegistry;
+using dfs::common::MetricsServer;
+using dfs::common::Tracer;
+using dfs::server::ChunkServerAsyncServices;
 using dfs::server::ChunkServerControlServiceImpl;
 using dfs::server::ChunkServerFileServiceImpl;
 using dfs::server::ChunkServerLeaseServiceImpl;
+using dfs::server::ChunkIoBackend;
 using dfs::server::ChunkServerImpl;
+using dfs::server::ChunkStoreOptions;
+using dfs::server::DiskIoQueue;
 using dfs::server::FileChunkManager;
 
 int main(int argc, char* argv[]) {
@@ -37,6 +49,13 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    // 按配置切换为异步日志
+    dfs::common::SystemLogger::GetInstance().Configure(
+        dfs::common::SystemLogger::LoadOptions());
+
+    // 导出请求的 span，采样率可以通过指标服务的 /tracing 修改
+    Tracer::GetInstance()->Start(chunk_server_name, Tracer::LoadOptions());
+
     auto address =
         ConfigManager::GetInstance()->GetChunkServerAddress(chunk_server_name);
     auto port =
@@ -51,19 +70,62 @@ int main(int argc, char* argv[]) {
         ConfigManager::GetInstance()->GetBlockSize() * dfs::common::bytesMB +
         1000);
 
-    // initialize file chunk manager
-    FileChunkManager::GetInstance()->Initialize(
-        chunk_server_name,
-        dfs::common::bytesMB * ConfigManager::GetInstance()->GetBlockSize());
+    // initialize file chunk manager，每个数据目录一块磁盘，一个 I/O 队列
+    DiskIoQueue::Options io_options;
+    io_options.io_depth = ConfigManager::GetInstance()->GetDiskIoDepth();
+    io_options.max_queued_ops =
+        ConfigManager::GetInstance()->GetDiskIoMaxQueuedOps();
+    io_options.max_background_depth =
+        ConfigManager::GetInstance()->GetDiskIoMaxBackgroundDepth();
+    ChunkIoBackend::Options backend_options;
+    backend_options.use_thread_pool =
+        ConfigManager::GetInstance()->GetChunkIoBackend() == "thread_pool";
+    backend_options.queue_depth =
+        ConfigManager::GetInstance()->GetChunkIoQueueDepth();
+    backend_options.thread_nums =
+        ConfigManager::GetInstance()->GetChunkIoThreadNums();
+    backend_options.buffer_nums =
+        ConfigManager::GetInstance()->GetChunkIoBufferNums();
+    backend_options.buffer_size =
+        ConfigManager::GetInstance()->GetChunkIoBufferKB() *
+        dfs::common::bytesKB;
+    ChunkStoreOptions store_options;
+    store_options.direct_io =
+        ConfigManager::GetInstance()->GetChunkStoreDirectIo();
+    store_options.cache_block_size =
+        ConfigManager::GetInstance()->GetChunkStoreCacheBlockKB() *
+        dfs::common::bytesKB;
+    store_options.cache_capacity_bytes =
+        static_cast<uint64_t>(
+            ConfigManager::GetInstance()->GetChunkStoreCacheMB()) *
+        dfs::common::bytesMB;
+    store_options.compression_level =
+        ConfigManager::GetInstance()->GetChunkStoreCompressionLevel();
+    const auto data_dirs =
+        ConfigManager::GetInstance()->GetChunkServerDataDirs(
+            chunk_server_name);
+    if (!FileChunkManager::GetInstance()->Initialize(
+            data_dirs,
+            dfs::common::bytesMB * ConfigManager::GetInstance()->GetBlockSize(),
+            io_options, backend_options, store_options)) {
+        LOG(ERROR) << "file chunk manager init error, check data dirs";
+        return 1;
+    }
+    LOG(INFO) << chunk_server_name << " use " << data_dirs.size()
+              << " data dirs, chunk io backend: "
+              << FileChunkManager::GetInstance()->GetChunkIoBackend()->name()
+              << ", direct io: " << store_options.direct_io;
 
-    ChunkServerControlServiceImpl control_service;
-    builder.RegisterService(&control_service);
+    // 一元 RPC 由异步运行时处理，磁盘请求与网络请求使用不同的线程池
+    AsyncServerRuntime runtime(AsyncServerRuntime::LoadOptions());
+    runtime.Configure(&builder);
 
+    ChunkServerControlServiceImpl control_service;
     ChunkServerFileServiceImpl file_service;
-    builder.RegisterService(&file_service);
-
     ChunkServerLeaseServiceImpl lease_service;
-    builder.RegisterService(&lease_service);
+    ChunkServerAsyncServices async_services(&file_service, &control_service,
+                                            &lease_service);
+    async_services.Register(&builder, &runtime);
 
     auto chunk_server_impl = ChunkServerImpl::GetInstance();
     chunk_server_impl->Initialize(chunk_server_name,
@@ -71,13 +133,27 @@ int main(int argc, char* argv[]) {
     chunk_server_impl->RegisterMasterServerClient("127.0.0.1:50050");
 
     std::unique_ptr<grpc::Server> server(builder.BuildAndStart());
+    runtime.Start();
     // set up start task
     chunk_server_impl->StartReportToMaster();
 
+    // 以 Prometheus 文本格式导出指标，端口为 RPC 端口加上偏移
+    MetricsServer metrics_server(MetricsRegistry::GetInstance());
+    const uint32_t metrics_port_offset =
+        ConfigManager::GetInstance()->GetMetricsPortOffset();
+    if (metrics_port_offset > 0) {
+        metrics_server.Start(ConfigManager::GetInstance()->GetMetricsAddress(),
+                             port + metrics_port_offset);
+    }
+
     server->Wait();
 
     // server is over
+    metrics_server.Stop();
     chunk_server_impl->StopReportToMaster();
+    runtime.Shutdown();
+    Tracer::GetInstance()->Shutdown();
+    dfs::common::SystemLogger::GetInstance().Shutdown();
     google::ShutdownGoogleLogging();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,264 @@
+#include "src/server/chunk_server/chunk_stripe_coder.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "src/common/system_logger.h"
+#include "src/common/tracing.h"
+
+namespace dfs {
+namespace server {
+
+using google::protobuf::util::DataLossError;
+using google::protobuf::util::InternalError;
+using google::protobuf::util::InvalidArgumentError;
+using google::protobuf::util::OkStatus;
+using protos::grpc::StripeShard;
+
+ChunkStripeCoder::ChunkStripeCoder(uint32_t data_shards,
+                                   uint32_t parity_shards, uint64_t cell_size,
+                                   ShardReader reader)
+    : codec_(data_shards, parity_shards),
+      cell_size_(std::max<uint64_t>(cell_size, 1)),
+      reader_(std::move(reader)) {}
+
+google::protobuf::util::Status ChunkStripeCoder::Encode(
+    const std::vector<StripeShard>& data, std::vector<std::string>* parity,
+    std::vector<uint64_t>* data_sizes) {
+    parity->assign(codec_.parity_shards(), std::string());
+    return Encode(
+        data,
+        [parity](uint64_t offset,
+                 const std::vector<std::string>& parity_cells) {
+            for (size_t i = 0; i < parity_cells.size(); i++) {
+                (*parity)[i].append(parity_cells[i]);
+            }
+            return OkStatus();
+        },
+        data_sizes);
+}
+
+google::protobuf::util::Status ChunkStripeCoder::Encode(
+    const std::vector<StripeShard>& data, const ParityWriter& write_parity,
+    std::vector<uint64_t>* data_sizes) {
+    const uint32_t data_shards = codec_.data_shards();
+    const uint32_t parity_shards = codec_.parity_shards();
+    if (data.size() != data_shards) {
+        return InvalidArgumentError("stripe needs " +
+                                    std::to_string(data_shards) +
+                                    " data shards, got " +
+                                    std::to_string(data.size()));
+    }
+
+    data_sizes->assign(data_shards, 0);
+
+    // 不存在的数据分片不需要读取
+    std::vector<bool> ended(data_shards);
+    for (uint32_t i = 0; i < data_shards; i++) {
+        ended[i] = data[i].chunk_handle().empty();
+    }
+
+    std::vector<std::string> cells(data_shards);
+    std::vector<std::string> parity_cells(parity_shards);
+    for (uint64_t offset = 0;; offset += cell_size_) {
+        std::vector<uint32_t> indexes;
+        for (uint32_t i = 0; i < data_shards; i++) {
+            if (!ended[i]) {
+                indexes.push_back(i);
+            }
+        }
+        if (indexes.empty()) {
+            break;
+        }
+
+        std::vector<std::string> read_cells;
+        auto statuses = ReadCells(
+            data, indexes, std::vector<uint64_t>(indexes.size(), cell_size_),
+            offset, &read_cells);
+
+        uint64_t cell_length = 0;
+        for (size_t j = 0; j < indexes.size(); j++) {
+            if (!statuses[j].ok()) {
+                return statuses[j];
+            }
+            const uint32_t i = indexes[j];
+            (*data_sizes)[i] += read_cells[j].size();
+            // 读到的数据不足一段，说明已经到达分片末尾
+            ended[i] = read_cells[j].size() < cell_size_;
+            cell_length =
+                std::max<uint64_t>(cell_length, read_cells[j].size());
+        }
+        if (cell_length == 0) {
+            break;
+        }
+
+        // 较短的分片按全 0 补齐
+        for (auto& cell : cells) {
+            cell.clear();
+        }
+        for (size_t j = 0; j < indexes.size(); j++) {
+            cells[indexes[j]] = std::move(read_cells[j]);
+        }
+        std::vector<const char*> inputs;
+        for (auto& cell : cells) {
+            cell.resize(cell_length, '\0');
+            inputs.push_back(cell.data());
+        }
+
+        std::vector<char*> outputs;
+        for (auto& cell : parity_cells) {
+            cell.resize(cell_length);
+            outputs.push_back(&cell[0]);
+        }
+        codec_.Encode(inputs.data(), outputs.data(), cell_length);
+        auto write_status = write_parity(offset, parity_cells);
+        if (!write_status.ok()) {
+            return write_status;
+        }
+    }
+
+    return OkStatus();
+}
+
+google::protobuf::util::StatusOr<std::string> ChunkStripeCoder::Reconstruct(
+    const std::vector<StripeShard>& shards, uint32_t shard_index,
+    std::vector<uint32_t>* read_shards) {
+    const uint32_t data_shards = codec_.data_shards();
+    const uint32_t total_shards = data_shards + codec_.parity_shards();
+    if (shards.size() != total_shards || shard_index >= total_shards) {
+        return InvalidArgumentError("invalid stripe shards or shard index");
+    }
+
+    // 读取失败的分片不再使用
+    std::vector<bool> failed(total_shards, false);
+    failed[shard_index] = true;
+    std::vector<bool> read(total_shards, false);
+
+    const uint64_t target_size = shards[shard_index].size();
+    std::string result;
+    result.reserve(target_size);
+    std::string output;
+    for (uint64_t offset = 0; offset < target_size; offset += cell_size_) {
+        const uint64_t cell_length =
+            std::min<uint64_t>(cell_size_, target_size - offset);
+
+        while (true) {
+            // 按编号选择存活的分片，数据分片在前
+            std::vector<uint32_t> survivors;
+            for (uint32_t i = 0; i < total_shards && survivors.size() <
+                                                         data_shards;
+                 i++) {
+                if (!failed[i]) {
+                    survivors.push_back(i);
+                }
+            }
+            if (survivors.size() < data_shards) {
+                return DataLossError("no enough live shards to reconstruct "
+                                     "shard " +
+                                     std::to_string(shard_index));
+            }
+
+            // 只读取在该段范围内有数据的分片
+            std::vector<uint32_t> indexes;
+            std::vector<uint64_t> lengths;
+            for (const auto& i : survivors) {
+                const uint64_t size = shards[i].size();
+                if (!shards[i].chunk_handle().empty() && size > offset) {
+                    indexes.push_back(i);
+                    lengths.push_back(std::min(cell_length, size - offset));
+                }
+            }
+
+            std::vector<std::string> read_cells;
+            auto statuses =
+                ReadCells(shards, indexes, lengths, offset, &read_cells);
+            bool retry = false;
+            for (size_t j = 0; j < indexes.size(); j++) {
+                const uint32_t i = indexes[j];
+                read[i] = true;
+                if (!statuses[j].ok() || read_cells[j].size() != lengths[j]) {
+                    LOG(WARNING) << "read shard " << i << " of chunk "
+                                 << shards[i].chunk_handle()
+                                 << " failed, because "
+                                 << (statuses[j].ok()
+                                         ? "shard is too short"
+                                         : statuses[j].ToString())
+                                 << ", try other shards";
+                    failed[i] = true;
+                    retry = true;
+                }
+            }
+            if (retry) {
+                continue;
+            }
+
+            std::vector<std::string> cells(data_shards);
+            for (size_t j = 0; j < indexes.size(); j++) {
+                const auto position =
+                    std::find(survivors.begin(), survivors.end(), indexes[j]) -
+                    survivors.begin();
+                cells[position] = std::move(read_cells[j]);
+            }
+            std::vector<const char*> inputs;
+            for (auto& cell : cells) {
+                cell.resize(cell_length, '\0');
+                inputs.push_back(cell.data());
+            }
+
+            output.resize(cell_length);
+            char* outputs[] = {&output[0]};
+            if (!codec_.Decode(survivors, inputs.data(), {shard_index},
+                               outputs, cell_length)) {
+                return InternalError("decode shard " +
+                                     std::to_string(shard_index) + " failed");
+            }
+            result.append(output);
+            break;
+        }
+    }
+
+    if (read_shards) {
+        read_shards->clear();
+        for (uint32_t i = 0; i < total_shards; i++) {
+            if (read[i] && !failed[i]) {
+                read_shards->push_back(i);
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<google::protobuf::util::Status> ChunkStripeCoder::ReadCells(
+    const std::vector<StripeShard>& shards,
+    const std::vector<uint32_t>& indexes, const std::vector<uint64_t>& lengths,
+    uint64_t offset, std::vector<std::string>* cells) {
+    std::vector<google::protobuf::util::Status> statuses(indexes.size());
+    cells->assign(indexes.size(), std::string());
+
+    const auto trace_context = dfs::common::CurrentTraceContext();
+    auto read_cell = [&](size_t j) {
+        dfs::common::ScopedTraceContext trace_scope(trace_context);
+        auto data_or = reader_(shards[indexes[j]], offset, lengths[j]);
+        if (data_or.ok()) {
+            (*cells)[j] = std::move(data_or.value());
+        } else {
+            statuses[j] = data_or.status();
+        }
+    };
+
+    // 分片通常位于不同的块服务器，并发读取
+    std::vector<std::thread> read_threads;
+    for (size_t j = 1; j < indexes.size(); j++) {
+        read_threads.emplace_back(read_cell, j);
+    }
+    if (!indexes.empty()) {
+        read_cell(0);
+    }
+    for (auto& read_thread : read_threads) {
+        read_thread.join();
+    }
+    return statuses;
+}
+
+}  // namespace server
+}  // namespace dfs
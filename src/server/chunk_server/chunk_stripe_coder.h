@@ -0,0 +1,77 @@
+#ifndef DFS_SERVER_CHUNK_SERVER_CHUNK_STRIPE_CODER_H
+#define DFS_SERVER_CHUNK_SERVER_CHUNK_STRIPE_CODER_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "chunk_server_file_service.pb.h"
+#include "google/protobuf/stubs/status.h"
+#include "google/protobuf/stubs/statusor.h"
+#include "src/common/erasure_code.h"
+
+namespace dfs {
+namespace server {
+
+/**
+ * 纠删码条带的编码与重建
+ * 1. 按 cell_size 逐段读取分片并计算，内存中只保留每个分片的一段数据
+ *    与计算结果
+ * 2. 分片的读取方式由调用者提供，块服务器从本地或其他块服务器读取
+ * 3. 重建时优先读取数据分片，长度不足的部分与不存在的数据分片按全 0
+ *    计算不需要读取；读取失败的分片换成其他存活的分片继续重建
+ */
+class ChunkStripeCoder {
+   public:
+    // 读取分片 [offset, offset + length) 的数据，分片末尾之后的部分不返回
+    using ShardReader =
+        std::function<google::protobuf::util::StatusOr<std::string>(
+            const protos::grpc::StripeShard& shard, uint64_t offset,
+            uint64_t length)>;
+
+    ChunkStripeCoder(uint32_t data_shards, uint32_t parity_shards,
+                     uint64_t cell_size, ShardReader reader);
+
+    // 每计算出一段校验数据调用一次，parity_cells 为各校验块 offset 处的
+    // 一段数据，返回错误时停止编码
+    using ParityWriter = std::function<google::protobuf::util::Status(
+        uint64_t offset, const std::vector<std::string>& parity_cells)>;
+
+    // data 为 data_shards 个数据分片，计算 parity_shards 个校验块写入
+    // parity，data_sizes 为读取到的数据分片长度。
+    // 校验块的长度为最长的数据分片长度，较短的分片按全 0 补齐
+    google::protobuf::util::Status Encode(
+        const std::vector<protos::grpc::StripeShard>& data,
+        std::vector<std::string>* parity, std::vector<uint64_t>* data_sizes);
+
+    // 同上，校验数据按段交给 write_parity，内存中只保留每个校验块的一段
+    google::protobuf::util::Status Encode(
+        const std::vector<protos::grpc::StripeShard>& data,
+        const ParityWriter& write_parity, std::vector<uint64_t>* data_sizes);
+
+    // shards 为条带的全部分片，长度都已知，重建第 shard_index 个分片。
+    // read_shards 记录读取过的分片，可以为空
+    google::protobuf::util::StatusOr<std::string> Reconstruct(
+        const std::vector<protos::grpc::StripeShard>& shards,
+        uint32_t shard_index, std::vector<uint32_t>* read_shards);
+
+   private:
+    // 并发读取 indexes 中每个分片 offset 处的一段数据，读取的长度为
+    // lengths 中对应的值，结果依次写入 cells
+    std::vector<google::protobuf::util::Status> ReadCells(
+        const std::vector<protos::grpc::StripeShard>& shards,
+        const std::vector<uint32_t>& indexes,
+        const std::vector<uint64_t>& lengths, uint64_t offset,
+        std::vector<std::string>* cells);
+
+    dfs::common::ReedSolomon codec_;
+
+    uint64_t cell_size_;
+
+    ShardReader reader_;
+};
+
+}  // namespace server
+}  // namespace dfs
+
+#endif  // DFS_SERVER_CHUNK_SERVER_CHUNK_STRIPE_CODER_H
@@ -0,0 +1,134 @@
+#include "src/server/chunk_server/disk_io_queue.h"
+
+#include <algorithm>
+
+namespace dfs {
+namespace server {
+
+DiskIoQueue::DiskIoQueue(const std::string& name, const Options& options)
+    : name_(name), options_(options) {
+    options_.io_depth = std::max<uint32_t>(options_.io_depth, 1);
+    options_.max_background_depth = std::clamp<uint32_t>(
+        options_.max_background_depth, 1, options_.io_depth);
+    for (uint32_t i = 0; i < options_.io_depth; i++) {
+        threads_.emplace_back([this]() { RunWorker(); });
+    }
+}
+
+DiskIoQueue::~DiskIoQueue() { Shutdown(); }
+
+google::protobuf::util::Status DiskIoQueue::Execute(
+    const IoPriority& priority, const std::function<void()>& io) {
+    IoTask task;
+    task.io = &io;
+
+    absl::MutexLock lock_guard(&lock_);
+    if (shutdown_) {
+        return google::protobuf::util::UnavailableError(
+            "disk io queue is shutdown, disk: " + name_);
+    }
+    if (options_.max_queued_ops > 0 &&
+        queued_ops_ >= options_.max_queued_ops) {
+        return google::protobuf::util::ResourceExhaustedError(
+            "disk io queue is full, disk: " + name_);
+    }
+
+    tasks_[static_cast<size_t>(priority)].push_back(&task);
+    queued_ops_++;
+    task_cond_var_.Signal();
+
+    while (!task.done) {
+        done_cond_var_.Wait(&lock_);
+    }
+    return google::protobuf::util::OkStatus();
+}
+
+void DiskIoQueue::Shutdown() {
+    {
+        absl::MutexLock lock_guard(&lock_);
+        if (shutdown_) {
+            return;
+        }
+        shutdown_ = true;
+        task_cond_var_.SignalAll();
+    }
+
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+size_t DiskIoQueue::GetQueuedOps() {
+    absl::MutexLock lock_guard(&lock_);
+    return queued_ops_;
+}
+
+size_t DiskIoQueue::GetQueuedOps(const IoPriority& priority) {
+    absl::MutexLock lock_guard(&lock_);
+    return tasks_[static_cast<size_t>(priority)].size();
+}
+
+uint32_t DiskIoQueue::GetRunningOps() {
+    absl::MutexLock lock_guard(&lock_);
+    return running_ops_;
+}
+
+bool DiskIoQueue::IsBackground(const size_t& priority) {
+    return priority >= static_cast<size_t>(IoPriority::REPLICATION);
+}
+
+bool DiskIoQueue::PopTask(IoTask** task, size_t* priority) {
+    for (size_t i = 0; i < kPriorityNums; i++) {
+        if (tasks_[i].empty()) {
+            continue;
+        }
+        // 后台 I/O 已经占满配额，更低优先级的也都是后台 I/O
+        if (IsBackground(i) &&
+            running_background_ops_ >= options_.max_background_depth) {
+            return false;
+        }
+
+        *task = tasks_[i].front();
+        *priority = i;
+        tasks_[i].pop_front();
+        queued_ops_--;
+        running_ops_++;
+        if (IsBackground(i)) {
+            running_background_ops_++;
+        }
+        return true;
+    }
+    return false;
+}
+
+void DiskIoQueue::RunWorker() {
+    absl::MutexLock lock_guard(&lock_);
+    while (true) {
+        IoTask* task;
+        size_t priority;
+        if (!PopTask(&task, &priority)) {
+            // 关闭后仍然执行完已经提交的 I/O
+            if (shutdown_ && queued_ops_ == 0) {
+                return;
+            }
+            task_cond_var_.Wait(&lock_);
+            continue;
+        }
+
+        lock_.Unlock();
+        (*task->io)();
+        lock_.Lock();
+
+        task->done = true;
+        running_ops_--;
+        if (IsBackground(priority)) {
+            running_background_ops_--;
+            // 等待后台配额的线程可以继续执行
+            task_cond_var_.SignalAll();
+        }
+        done_cond_var_.SignalAll();
+    }
+}
+
+}  // namespace server
+}  // namespace dfs
@@ -0,0 +1,114 @@
+#ifndef DFS_SERVER_CHUNK_SERVER_DISK_IO_QUEUE_H
+#define DFS_SERVER_CHUNK_SERVER_DISK_IO_QUEUE_H
+
+#include <absl/synchronization/mutex.h>
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "google/protobuf/stubs/status.h"
+
+namespace dfs {
+namespace server {
+
+// I/O 的优先级，数值越小优先级越高
+enum class IoPriority : uint32_t {
+    // 客户端读
+    FOREGROUND_READ = 0,
+    // 客户端写
+    FOREGROUND_WRITE = 1,
+    // 副本复制
+    REPLICATION = 2,
+    // 巡检、汇报等全盘扫描
+    SCRUBBING = 3,
+};
+
+/**
+ * 一块磁盘的 I/O 队列
+ * 1. 固定数量的线程执行 I/O，同时进行的 I/O 数量不超过 io_depth
+ * 2. 每个优先级一个队列，总是先执行优先级高的 I/O
+ * 3. 复制与巡检属于后台 I/O，同时进行的数量不超过 max_background_depth，
+ *    剩余的线程留给客户端请求，后台任务不会拖慢客户端的尾延迟
+ * 4. 等待执行的 I/O 数量有上限，超过时直接拒绝
+ */
+class DiskIoQueue {
+   public:
+    struct Options {
+        // 同时进行的 I/O 数量
+        uint32_t io_depth = 4;
+        // 等待执行的 I/O 数量上限，为 0 时不限制
+        uint32_t max_queued_ops = 256;
+        // 后台 I/O 同时进行的数量上限
+        uint32_t max_background_depth = 1;
+    };
+
+    DiskIoQueue(const std::string& name, const Options& options);
+
+    ~DiskIoQueue();
+
+    // 在 I/O 线程中执行 io，执行完成后返回。队列已满或者已经关闭时
+    // 不执行 io，返回 RESOURCE_EXHAUSTED 或 UNAVAILABLE
+    google::protobuf::util::Status Execute(const IoPriority& priority,
+                                           const std::function<void()>& io);
+
+    // 执行完已经提交的 I/O 后退出所有线程
+    void Shutdown();
+
+    // 等待执行的 I/O 数量
+    size_t GetQueuedOps();
+
+    // 某个优先级等待执行的 I/O 数量
+    size_t GetQueuedOps(const IoPriority& priority);
+
+    // 正在执行的 I/O 数量
+    uint32_t GetRunningOps();
+
+    const std::string& name() const { return name_; }
+
+   private:
+    static constexpr size_t kPriorityNums = 4;
+
+    struct IoTask {
+        const std::function<void()>* io;
+        bool done = false;
+    };
+
+    static bool IsBackground(const size_t& priority);
+
+    void RunWorker();
+
+    // 取出下一个可以执行的 I/O，没有时返回 false，调用时需持有 lock_
+    bool PopTask(IoTask** task, size_t* priority);
+
+    const std::string name_;
+
+    Options options_;
+
+    absl::Mutex lock_;
+
+    absl::CondVar task_cond_var_;
+
+    absl::CondVar done_cond_var_;
+
+    std::array<std::deque<IoTask*>, kPriorityNums> tasks_;
+
+    size_t queued_ops_ = 0;
+
+    uint32_t running_ops_ = 0;
+
+    uint32_t running_background_ops_ = 0;
+
+    bool shutdown_ = false;
+
+    std::vector<std::thread> threads_;
+};
+
+}  // namespace server
+}  // namespace dfs
+
+#endif  // DFS_SERVER_CHUNK_SERVER_DISK_IO_QUEUE_H
@@ -1,10 +1,274 @@
 #include "src/server/chunk_server/file_chunk_manager.h"
 
+#include <fcntl.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <set>
+
 #include "chunk_server.pb.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/wire_format_lite.h"
+#include "src/common/compression.h"
 
 namespace dfs {
 namespace server {
 
+namespace {
+
+const uint64_t kPageSize = ChunkIoBackend::kBufferAlignment;
+
+uint64_t AlignUp(const uint64_t& value, const uint64_t& alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// 打开数据块文件，文件系统不支持 O_DIRECT 时（如 tmpfs）使用普通读写
+int OpenChunkFile(const std::string& path, const int& flags) {
+    int fd = open(path.c_str(), flags | O_DIRECT, 0644);
+    if (fd < 0 && errno == EINVAL) {
+        fd = open(path.c_str(), flags, 0644);
+    }
+    return fd;
+}
+
+class ScopedFd {
+   public:
+    explicit ScopedFd(const int& fd = -1) : fd_(fd) {}
+
+    ~ScopedFd() {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    ScopedFd(const ScopedFd&) = delete;
+
+    ScopedFd& operator=(const ScopedFd&) = delete;
+
+    void Reset(const int& fd) {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+        fd_ = fd;
+    }
+
+    int get() const { return fd_; }
+
+   private:
+    int fd_;
+};
+
+// 对齐的 I/O 缓冲区，优先使用 I/O 后端的注册缓冲区，没有空闲的注册缓冲区时
+// 临时分配
+class AlignedBuffer {
+   public:
+    AlignedBuffer(ChunkIoBackend* io_backend, const size_t& min_size)
+        : io_backend_(io_backend) {
+        if (io_backend_->buffer_size() >= min_size) {
+            buffer_index_ = io_backend_->AcquireBuffer();
+        }
+        if (buffer_index_ >= 0) {
+            data_ = io_backend_->GetBuffer(buffer_index_);
+            size_ = io_backend_->buffer_size();
+            return;
+        }
+
+        size_ = AlignUp(min_size, kPageSize);
+        void* buffer = nullptr;
+        if (!posix_memalign(&buffer, kPageSize, size_)) {
+            data_ = static_cast<char*>(buffer);
+        }
+    }
+
+    ~AlignedBuffer() {
+        if (buffer_index_ >= 0) {
+            io_backend_->ReleaseBuffer(buffer_index_);
+        } else {
+            free(data_);
+        }
+    }
+
+    AlignedBuffer(const AlignedBuffer&) = delete;
+
+    AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+    // 分配失败时为 nullptr
+    char* data() const { return data_; }
+
+    size_t size() const { return size_; }
+
+    int index() const { return buffer_index_; }
+
+   private:
+    ChunkIoBackend* io_backend_;
+
+    int buffer_index_ = -1;
+
+    char* data_ = nullptr;
+
+    size_t size_ = 0;
+};
+
+// 读取 page_offset 处的一页，超出 size 的部分填 0
+google::protobuf::util::Status ReadPage(ChunkIoBackend* io_backend,
+                                        const int& fd,
+                                        const uint64_t& page_offset,
+                                        const uint64_t& size, char* buffer,
+                                        const int& buffer_index) {
+    size_t read_bytes = 0;
+    if (page_offset < size) {
+        auto read_or = io_backend->Read(fd, page_offset, buffer, kPageSize,
+                                        buffer_index);
+        if (!read_or.ok()) {
+            return read_or.status();
+        }
+        read_bytes = read_or.value();
+    }
+    memset(buffer + read_bytes, 0, kPageSize - read_bytes);
+    return google::protobuf::util::OkStatus();
+}
+
+bool IsCompressed(const protos::FileChunk& chunk) {
+    return chunk.codec() != protos::CODEC_NONE;
+}
+
+dfs::common::CompressionCodec ToCompressionCodec(
+    const protos::ChunkCodec& codec) {
+    return static_cast<dfs::common::CompressionCodec>(codec);
+}
+
+// 压缩的数据块中每个分块压缩后的数据的位置
+std::vector<uint64_t> GetStoredOffsets(const protos::FileChunk& chunk) {
+    std::vector<uint64_t> offsets(chunk.block_lengths_size());
+    uint64_t offset = 0;
+    for (size_t i = 0; i < offsets.size(); i++) {
+        if (chunk.block_offsets_size() > 0) {
+            offsets[i] = chunk.block_offsets(i);
+        } else {
+            offsets[i] = offset;
+            offset += chunk.block_lengths(i);
+        }
+    }
+    return offsets;
+}
+
+// 各分块压缩后的总长度，不包括空洞
+uint64_t GetLiveStoredSize(const protos::FileChunk& chunk) {
+    uint64_t size = 0;
+    for (const auto& length : chunk.block_lengths()) {
+        size += length;
+    }
+    return size;
+}
+
+// 记录分块的位置，各分块依次拼接时不记录
+void SetStoredOffsets(const std::vector<uint64_t>& offsets,
+                      protos::FileChunk* chunk) {
+    chunk->clear_block_offsets();
+    uint64_t offset = 0;
+    bool contiguous = true;
+    for (size_t i = 0; i < offsets.size() && contiguous; i++) {
+        contiguous = offsets[i] == offset;
+        offset += chunk->block_lengths(i);
+    }
+    if (!contiguous) {
+        chunk->mutable_block_offsets()->Add(offsets.begin(), offsets.end());
+    }
+}
+
+// 将 length 字节的 data 按分块压缩后追加到 stored，每个分块压缩后的长度
+// 追加到 block_lengths
+void CompressBlocks(const protos::FileChunk& chunk, const int& level,
+                    const char* data, const uint64_t& length,
+                    std::string* stored, std::vector<uint32_t>* block_lengths) {
+    for (uint64_t pos = 0; pos < length; pos += chunk.block_size()) {
+        block_lengths->push_back(dfs::common::CompressBlock(
+            ToCompressionCodec(chunk.codec()), data + pos,
+            std::min<uint64_t>(chunk.block_size(), length - pos), level,
+            stored));
+    }
+}
+
+// 解压从 first_block 开始的分块并追加到 output，stored 为这些分块压缩后的
+// 数据依次拼接
+google::protobuf::util::Status DecompressBlocks(const protos::FileChunk& chunk,
+                                                const uint64_t& first_block,
+                                                const char* stored,
+                                                const uint64_t& stored_length,
+                                                std::string* output) {
+    uint64_t pos = 0;
+    for (uint64_t block = first_block; pos < stored_length; block++) {
+        const uint64_t block_start = block * chunk.block_size();
+        if (block >= static_cast<uint64_t>(chunk.block_lengths_size()) ||
+            block_start >= chunk.raw_size() ||
+            pos + chunk.block_lengths(block) > stored_length) {
+            return google::protobuf::util::DataLossError(
+                "compressed chunk blocks are inconsistent");
+        }
+
+        const uint64_t raw_length = std::min<uint64_t>(
+            chunk.block_size(), chunk.raw_size() - block_start);
+        if (!dfs::common::DecompressBlock(ToCompressionCodec(chunk.codec()),
+                                          stored + pos,
+                                          chunk.block_lengths(block),
+                                          raw_length, output)) {
+            return google::protobuf::util::DataLossError(
+                "failed to decompress chunk block " + std::to_string(block));
+        }
+        pos += chunk.block_lengths(block);
+    }
+    return google::protobuf::util::OkStatus();
+}
+
+}  // namespace
+
+FileChunkManager::FileChunkManager() {
+    auto registry = common::MetricsRegistry::GetInstance();
+    read_latency_ = registry->GetHistogram(
+        "dfs_chunk_store_latency_seconds",
+        "Latency of chunk store operations", {{"op", "read"}});
+    write_latency_ = registry->GetHistogram(
+        "dfs_chunk_store_latency_seconds",
+        "Latency of chunk store operations", {{"op", "write"}});
+    read_bytes_ = registry->GetCounter("dfs_chunk_store_bytes_total",
+                                       "Bytes read from or written to chunks",
+                                       {{"op", "read"}});
+    write_bytes_ = registry->GetCounter("dfs_chunk_store_bytes_total",
+                                        "Bytes read from or written to chunks",
+                                        {{"op", "write"}});
+
+    // 单例不会析构，读缓存在 Initialize 中重新创建，读取前检查是否存在
+    using CacheGetter = uint64_t (ChunkBlockCache::*)();
+    auto add_cache_metric = [this, registry](const std::string& name,
+                                             const std::string& help,
+                                             common::MetricType type,
+                                             CacheGetter getter) {
+        registry->AddCallback(name, help, type, {}, [this, getter]() {
+            auto cache = block_cache_.get();
+            return cache ? static_cast<double>((cache->*getter)()) : 0.0;
+        });
+    };
+    add_cache_metric("dfs_chunk_block_cache_hits_total",
+                     "Chunk block cache hits", common::MetricType::COUNTER,
+                     &ChunkBlockCache::GetHits);
+    add_cache_metric("dfs_chunk_block_cache_misses_total",
+                     "Chunk block cache misses", common::MetricType::COUNTER,
+                     &ChunkBlockCache::GetMisses);
+    add_cache_metric("dfs_chunk_block_cache_coalesced_loads_total",
+                     "Chunk block reads coalesced with a concurrent load",
+                     common::MetricType::COUNTER,
+                     &ChunkBlockCache::GetCoalescedLoads);
+    add_cache_metric("dfs_chunk_block_cache_resident_bytes",
+                     "Bytes resident in the chunk block cache",
+                     common::MetricType::GAUGE,
+                     &ChunkBlockCache::GetResidentBytes);
+}
+
 FileChunkManager* FileChunkManager::GetInstance() {
     static FileChunkManager* instance = new FileChunkManager();
     return instance;
@@ -12,39 +276,147 @@ FileChunkManager* FileChunkManager::GetInstance() {
 
 bool FileChunkManager::Initialize(const std::string& chunk_dbname,
                                   const uint32_t& max_bytes_per_chunk) {
-    leveldb::DB* db;
-    leveldb::Options options;
-    options.create_if_missing = true;
-    options.write_buffer_size = max_bytes_per_chunk * 128;
-    leveldb::Status status = leveldb::DB::Open(options, chunk_dbname, &db);
-    if (!status.ok()) {
+    return Initialize(std::vector<std::string>{chunk_dbname},
+                      max_bytes_per_chunk, DiskIoQueue::Options());
+}
+
+bool FileChunkManager::Initialize(
+    const std::vector<std::string>& data_dirs,
+    const uint32_t& max_bytes_per_chunk, const DiskIoQueue::Options& io_options,
+    const ChunkIoBackend::Options& backend_options,
+    const ChunkStoreOptions& store_options) {
+    CloseDisks();
+    replica_stager_.reset();
+    io_backend_.reset();
+    block_cache_.reset();
+    if (data_dirs.empty()) {
         return false;
     }
 
-    chunk_db_ = std::unique_ptr<leveldb::DB>(db);
+    for (const auto& data_dir : data_dirs) {
+        auto disk = std::make_unique<ChunkDisk>();
+        disk->data_dir = data_dir;
+
+        std::error_code error_code;
+        std::filesystem::create_directories(
+            std::filesystem::path(data_dir).parent_path(), error_code);
+        if (store_options.direct_io) {
+            disk->chunk_dir = data_dir + "_chunks";
+            if (!std::filesystem::create_directories(disk->chunk_dir,
+                                                     error_code) &&
+                error_code) {
+                CloseDisks();
+                return false;
+            }
+        }
+
+        leveldb::DB* db;
+        leveldb::Options options;
+        options.create_if_missing = true;
+        options.write_buffer_size = max_bytes_per_chunk * 128;
+        leveldb::Status status = leveldb::DB::Open(options, data_dir, &db);
+        if (!status.ok()) {
+            CloseDisks();
+            return false;
+        }
+        disk->db = std::unique_ptr<leveldb::DB>(db);
+
+        // 记录已有数据块所在的磁盘，只读取 key
+        leveldb::ReadOptions read_options;
+        read_options.fill_cache = false;
+        std::unique_ptr<leveldb::Iterator> it(
+            disk->db->NewIterator(read_options));
+        for (it->SeekToFirst(); it->Valid(); it->Next()) {
+            if (chunk_disks_.TryInsert(it->key().ToString(), disks_.size())) {
+                disk->chunk_nums++;
+            }
+        }
+
+        disk->io_queue = std::make_unique<DiskIoQueue>(data_dir, io_options);
+        disks_.push_back(std::move(disk));
+    }
+
     max_bytes_per_chunk_ = max_bytes_per_chunk;
-    return true;
+
+    io_backend_ = ChunkIoBackend::Create(backend_options);
+
+    direct_io_ = store_options.direct_io;
+    compression_level_ = store_options.compression_level;
+    // 分块按页对齐，不超过注册缓冲区时 O_DIRECT 读取可以使用注册缓冲区
+    cache_block_size_ = AlignUp(
+        std::max<uint64_t>(store_options.cache_block_size, 1), kPageSize);
+    if (io_backend_->buffer_size() >= kPageSize) {
+        cache_block_size_ =
+            std::min<uint64_t>(cache_block_size_, io_backend_->buffer_size());
+    }
+    ChunkBlockCache::Options cache_options;
+    cache_options.capacity_bytes = store_options.cache_capacity_bytes;
+    cache_options.block_size = cache_block_size_;
+    block_cache_ = std::make_unique<ChunkBlockCache>(cache_options);
+
+    replica_stager_ = std::make_unique<ChunkReplicaStager>(
+        disks_.front()->data_dir + "_replica_staging", io_backend_.get());
+    return replica_stager_->Initialize().ok();
 }
 
-google::protobuf::util::Status FileChunkManager::CreateChunk(
-    const std::string& chunk_handle, const uint32_t& chunk_version) {
-    std::unique_ptr<leveldb::Iterator> db_read_iter(
-        chunk_db_->NewIterator(leveldb::ReadOptions()));
+void FileChunkManager::CloseDisks() {
+    // 先停止 I/O 线程，再关闭数据库
+    for (auto& disk : disks_) {
+        disk->io_queue->Shutdown();
+    }
+    disks_.clear();
+    chunk_disks_.Clear();
+    chunk_versions_.Clear();
+}
+
+FileChunkManager::ChunkDisk* FileChunkManager::FindChunkDisk(
+    const std::string& chunk_handle) {
+    auto disk_index = chunk_disks_.TryGet(chunk_handle);
+    if (!disk_index.second) {
+        return nullptr;
+    }
+    return disks_[disk_index.first].get();
+}
+
+FileChunkManager::ChunkDisk* FileChunkManager::PlaceChunk(
+    const std::string& chunk_handle, bool* placed) {
+    absl::MutexLock lock_guard(&placement_lock_);
+    auto disk = FindChunkDisk(chunk_handle);
+    *placed = !disk;
+    if (disk) {
+        return disk;
+    }
+
+    size_t disk_index = 0;
+    for (size_t i = 1; i < disks_.size(); i++) {
+        if (disks_[i]->chunk_nums < disks_[disk_index]->chunk_nums) {
+            disk_index = i;
+        }
+    }
 
-    // 快速查找
-    db_read_iter->Seek(chunk_handle);
+    chunk_disks_.Set(chunk_handle, disk_index);
+    disks_[disk_index]->chunk_nums++;
+    return disks_[disk_index].get();
+}
 
+google::protobuf::util::Status FileChunkManager::CreateChunk(
+    const std::string& chunk_handle, const uint32_t& chunk_version,
+    const IoPriority& priority, const protos::ChunkCodec& codec) {
     // does the chunk already exist?
-    if (db_read_iter->Valid() && db_read_iter->status().ok() &&
-        db_read_iter->key() == chunk_handle) {
+    if (FindChunkDisk(chunk_handle)) {
         return google::protobuf::util::AlreadyExistsError(
             "chunk already exist, chunk_handle: " + chunk_handle);
     }
 
     protos::FileChunk chunk;
     chunk.set_version(chunk_version);
+    if (codec != protos::CODEC_NONE) {
+        // 压缩的分块与读缓存的分块对齐，读取一个缓存分块只需要解压一个分块
+        chunk.set_codec(codec);
+        chunk.set_block_size(cache_block_size_);
+    }
 
-    auto status = WriteFileChunk(chunk_handle, chunk);
+    auto status = WriteFileChunk(chunk_handle, chunk, priority);
     if (!status.ok()) {
         return google::protobuf::util::UnknownError("Create chunk failed: " +
                                                     status.ToString());
@@ -56,132 +428,629 @@ google::protobuf::util::Status FileChunkManager::CreateChunk(
 google::protobuf::util::StatusOr<std::string> FileChunkManager::ReadFromChunk(
     const std::string& chunk_handle, const uint32_t& version,
     const uint32_t& offset, const uint32_t& length) {
-    // get the specified verison of the chunk
-    auto file_chunk_or = GetFileChunk(chunk_handle, version);
-    if (!file_chunk_or.ok()) {
-        return file_chunk_or.status();
+    common::ScopedLatency latency(read_latency_);
+    auto disk = FindChunkDisk(chunk_handle);
+    if (!disk) {
+        return google::protobuf::util::NotFoundError(
+            "chunk not found, chunk_handle: " + chunk_handle);
+    }
+
+    // 一次读取不会超过数据块的大小
+    const uint64_t end =
+        static_cast<uint64_t>(offset) + std::min(length, max_bytes_per_chunk_);
+    const uint64_t first_block = offset / cache_block_size_;
+    const uint64_t last_block =
+        end > offset ? (end - 1) / cache_block_size_ : first_block;
+
+    // 全部命中缓存时不经过磁盘队列
+    auto lookups =
+        block_cache_->Lookup(chunk_handle, version, first_block, last_block);
+
+    // 未命中且没有其他线程在读取的分块由当前线程读取
+    std::vector<size_t> load_indexes;
+    for (size_t i = 0; i < lookups.size(); i++) {
+        if (lookups[i].load) {
+            load_indexes.push_back(i);
+        }
+    }
+    if (!load_indexes.empty()) {
+        auto status = LoadChunkBlocks(disk, chunk_handle, version, first_block,
+                                      load_indexes, &lookups);
+        // 读取失败时也要唤醒等待的线程，它们会自己重新读取
+        for (const auto& i : load_indexes) {
+            block_cache_->FinishLoad(chunk_handle, version, first_block + i,
+                                     lookups[i].pending,
+                                     status.ok() ? lookups[i].data : nullptr);
+        }
+        if (!status.ok()) {
+            return status;
+        }
     }
 
-    auto file_chunk = file_chunk_or.value();
+    // 等待其他线程读取的分块，对方读取失败时自己读取
+    std::vector<size_t> retry_indexes;
+    for (size_t i = 0; i < lookups.size(); i++) {
+        if (lookups[i].pending && !lookups[i].load) {
+            lookups[i].data = ChunkBlockCache::WaitLoad(lookups[i].pending);
+            if (!lookups[i].data) {
+                retry_indexes.push_back(i);
+            }
+        }
+    }
+    if (!retry_indexes.empty()) {
+        auto status = LoadChunkBlocks(disk, chunk_handle, version, first_block,
+                                      retry_indexes, &lookups);
+        if (!status.ok()) {
+            return status;
+        }
+    }
 
-    // out of range?
-    if (offset > file_chunk->data().size()) {
-        return google::protobuf::util::OutOfRangeError(
-            "out of range when read chunk: " + chunk_handle);
+    // 拼接分块，比分块大小短的分块是数据块的最后一个分块
+    std::string result;
+    for (size_t i = 0; i < lookups.size(); i++) {
+        const auto& data = lookups[i].data;
+        const uint64_t block_start = (first_block + i) * cache_block_size_;
+        // 没有数据的分块位于数据块末尾之后
+        if (!data || (i == 0 && offset - block_start > data->size())) {
+            if (i == 0) {
+                return google::protobuf::util::OutOfRangeError(
+                    "out of range when read chunk: " + chunk_handle);
+            }
+            break;
+        }
+
+        const uint64_t from = std::max<uint64_t>(offset, block_start);
+        const uint64_t to = std::min(end, block_start + data->size());
+        if (from < to) {
+            result.append(*data, from - block_start, to - from);
+        }
+        if (data->size() < cache_block_size_) {
+            break;
+        }
     }
 
-    return file_chunk->data().substr(offset, length);
+    read_bytes_->Increment(result.size());
+    return result;
 }
 
 google::protobuf::util::StatusOr<uint32_t> FileChunkManager::WriteToChunk(
     const std::string& chunk_handle, const uint32_t& version,
     const uint32_t& offset, const uint32_t& length, const std::string& data) {
-    // get the specified verison of the chunk
-    auto file_chunk_or = GetFileChunk(chunk_handle, version);
-    if (!file_chunk_or.ok()) {
-        return file_chunk_or.status();
+    common::ScopedLatency latency(write_latency_);
+    auto disk = FindChunkDisk(chunk_handle);
+    if (!disk) {
+        return google::protobuf::util::NotFoundError(
+            "chunk not found, chunk_handle: " + chunk_handle);
     }
 
-    auto file_chunk = file_chunk_or.value();
+    google::protobuf::util::StatusOr<uint32_t> result;
+    auto io_status = disk->io_queue->Execute(
+        IoPriority::FOREGROUND_WRITE, [&]() {
+            // get the specified verison of the chunk
+            auto file_chunk_or = GetFileChunkFromDisk(
+                disk, chunk_handle, &version, /*read_data=*/false);
+            if (!file_chunk_or.ok()) {
+                result = file_chunk_or.status();
+                return;
+            }
 
-    // out of range?
-    if (offset > file_chunk->data().size()) {
-        return google::protobuf::util::OutOfRangeError(
-            "out of range when write chunk: " + chunk_handle);
-    }
+            auto file_chunk = file_chunk_or.value();
+            const uint64_t chunk_size = GetChunkSize(*file_chunk);
 
-    // TODO: data is too big? stop writing
-    // 当前 chunk 可用的字节数
-    uint32_t remaining_bytes = max_bytes_per_chunk_ - offset;
-    if (!remaining_bytes) {
-        return google::protobuf::util::OutOfRangeError(
-            "chunk is full when write chunk: " + chunk_handle);
-    }
+            // out of range?
+            if (offset > chunk_size) {
+                result = google::protobuf::util::OutOfRangeError(
+                    "out of range when write chunk: " + chunk_handle);
+                return;
+            }
 
-    // 实际写入的字节数
-    uint32_t write_length = std::min(remaining_bytes, length);
-    file_chunk->mutable_data()->replace(offset, write_length, data);
+            // TODO: data is too big? stop writing
+            // 当前 chunk 可用的字节数
+            uint32_t remaining_bytes = max_bytes_per_chunk_ - offset;
+            if (!remaining_bytes) {
+                result = google::protobuf::util::OutOfRangeError(
+                    "chunk is full when write chunk: " + chunk_handle);
+                return;
+            }
 
-    auto status = WriteFileChunk(chunk_handle, *file_chunk);
-    if (!status.ok()) {
-        return google::protobuf::util::UnknownError(
-            "failed to write file chunk to db, chunk_handle: " + chunk_handle +
-            " status: " + status.ToString());
+            // 实际写入的字节数
+            uint32_t write_length = std::min(remaining_bytes, length);
+            if (IsCompressed(*file_chunk)) {
+                const uint64_t data_length =
+                    std::min<uint64_t>(write_length, data.size());
+                auto write_status =
+                    WriteCompressedChunk(disk, chunk_handle, file_chunk.get(),
+                                         offset, data.data(), data_length);
+                if (!write_status.ok()) {
+                    result = write_status;
+                    return;
+                }
+            } else if (direct_io_) {
+                // 只写入修改的页，再更新数据库中的长度
+                const uint64_t data_length =
+                    std::min<uint64_t>(write_length, data.size());
+                auto write_status =
+                    WriteChunkFile(disk, chunk_handle, chunk_size, offset,
+                                   data.data(), data_length, false);
+                if (!write_status.ok()) {
+                    result = write_status;
+                    return;
+                }
+                file_chunk->set_size(
+                    std::max<uint64_t>(chunk_size, offset + data_length));
+            } else {
+                file_chunk->mutable_data()->replace(offset, write_length,
+                                                    data);
+            }
+
+            auto status = PutFileChunkToDisk(disk, chunk_handle, *file_chunk);
+            if (!status.ok()) {
+                result = google::protobuf::util::UnknownError(
+                    "failed to write file chunk to db, chunk_handle: " +
+                    chunk_handle + " status: " + status.ToString());
+                return;
+            }
+            InvalidateBlocks(chunk_handle, offset, write_length);
+
+            result = write_length;
+        });
+    if (!io_status.ok()) {
+        return io_status;
     }
 
-    return write_length;
+    if (result.ok()) {
+        write_bytes_->Increment(result.value());
+    }
+    return result;
 }
 
 google::protobuf::util::StatusOr<uint32_t> FileChunkManager::AppendToChunk(
     const std::string& chunk_handle, const uint32_t& version,
     const uint32_t& length, const std::string& data) {
-    // get the specified verison of the chunk
-    auto file_chunk_or = GetFileChunk(chunk_handle, version);
-    if (!file_chunk_or.ok()) {
-        return file_chunk_or.status();
+    common::ScopedLatency latency(write_latency_);
+    auto disk = FindChunkDisk(chunk_handle);
+    if (!disk) {
+        return google::protobuf::util::NotFoundError(
+            "chunk not found, chunk_handle: " + chunk_handle);
     }
 
-    auto file_chunk = file_chunk_or.value();
-    // 将 offset 设置为 chunk 的末尾
-    uint32_t offset = file_chunk->data().size();
-    uint32_t remaining_bytes = max_bytes_per_chunk_ - offset;
-    if (!remaining_bytes) {
-        return google::protobuf::util::OutOfRangeError(
-            "chunk is full when write chunk: " + chunk_handle);
-    }
+    google::protobuf::util::StatusOr<uint32_t> result;
+    auto io_status = disk->io_queue->Execute(
+        IoPriority::FOREGROUND_WRITE, [&]() {
+            // get the specified verison of the chunk
+            auto file_chunk_or = GetFileChunkFromDisk(
+                disk, chunk_handle, &version, /*read_data=*/false);
+            if (!file_chunk_or.ok()) {
+                result = file_chunk_or.status();
+                return;
+            }
 
-    // 实际写入的长度
-    uint32_t append_length = std::min(remaining_bytes, length);
-    file_chunk->set_data(file_chunk->data() + data.substr(append_length));
+            auto file_chunk = file_chunk_or.value();
+            // 将 offset 设置为 chunk 的末尾
+            uint32_t offset = GetChunkSize(*file_chunk);
+            uint32_t remaining_bytes = max_bytes_per_chunk_ - offset;
+            if (!remaining_bytes) {
+                result = google::protobuf::util::OutOfRangeError(
+                    "chunk is full when write chunk: " + chunk_handle);
+                return;
+            }
 
-    auto status = WriteFileChunk(chunk_handle, *file_chunk);
-    if (!status.ok()) {
-        return google::protobuf::util::UnknownError(
-            "failed to append data to chunk, chunk_handle: " + chunk_handle +
-            " status: " + status.ToString());
+            // 实际写入的长度
+            uint32_t append_length = std::min(remaining_bytes, length);
+            if (IsCompressed(*file_chunk)) {
+                const uint64_t data_length =
+                    std::min<uint64_t>(append_length, data.size());
+                auto write_status =
+                    WriteCompressedChunk(disk, chunk_handle, file_chunk.get(),
+                                         offset, data.data(), data_length);
+                if (!write_status.ok()) {
+                    result = write_status;
+                    return;
+                }
+            } else if (direct_io_) {
+                const uint64_t data_length =
+                    std::min<uint64_t>(append_length, data.size());
+                auto write_status =
+                    WriteChunkFile(disk, chunk_handle, offset, offset,
+                                   data.data(), data_length, false);
+                if (!write_status.ok()) {
+                    result = write_status;
+                    return;
+                }
+                file_chunk->set_size(offset + data_length);
+            } else {
+                file_chunk->set_data(file_chunk->data() +
+                                     data.substr(0, append_length));
+            }
+
+            auto status = PutFileChunkToDisk(disk, chunk_handle, *file_chunk);
+            if (!status.ok()) {
+                result = google::protobuf::util::UnknownError(
+                    "failed to append data to chunk, chunk_handle: " +
+                    chunk_handle + " status: " + status.ToString());
+                return;
+            }
+            InvalidateBlocks(chunk_handle, offset, append_length);
+
+            result = append_length;
+        });
+    if (!io_status.ok()) {
+        return io_status;
     }
 
-    return append_length;
+    if (result.ok()) {
+        write_bytes_->Increment(result.value());
+    }
+    return result;
 }
 
 google::protobuf::util::Status FileChunkManager::DeleteChunk(
     const std::string& chunk_handle) {
-    leveldb::WriteOptions options;
-    options.sync = true;
+    auto disk = FindChunkDisk(chunk_handle);
+    if (!disk) {
+        // 与 leveldb 一致，删除不存在的数据块不是错误
+        return google::protobuf::util::OkStatus();
+    }
+
+    leveldb::Status status;
+    // 删除过期的数据块属于后台任务
+    auto io_status = disk->io_queue->Execute(IoPriority::SCRUBBING, [&]() {
+        leveldb::WriteOptions options;
+        options.sync = true;
+        status = disk->db->Delete(options, chunk_handle);
+        if (status.ok() && direct_io_) {
+            unlink(GetChunkFilePath(disk, chunk_handle).c_str());
+        }
+    });
+    if (!io_status.ok()) {
+        return io_status;
+    }
 
-    auto status = chunk_db_->Delete(options, chunk_handle);
     if (!status.ok()) {
         return google::protobuf::util::UnknownError(
             "failed to delete file chunk, handle: " + chunk_handle +
             " status: " + status.ToString());
     }
 
+    {
+        absl::MutexLock lock_guard(&placement_lock_);
+        chunk_disks_.Erase(chunk_handle);
+        disk->chunk_nums--;
+    }
+    chunk_versions_.Erase(chunk_handle);
+    block_cache_->Erase(chunk_handle);
+
+    return google::protobuf::util::OkStatus();
+}
+
+google::protobuf::util::Status FileChunkManager::WriteFileChunk(
+    const std::string& chunk_handle, const protos::FileChunk& chunk,
+    const IoPriority& priority) {
+    // 压缩的数据块只带有原始数据时，先按分块压缩
+    const protos::FileChunk* stored_chunk = &chunk;
+    protos::FileChunk compressed_chunk;
+    if (IsCompressed(chunk) && chunk.block_lengths_size() == 0) {
+        compressed_chunk.set_version(chunk.version());
+        compressed_chunk.set_codec(chunk.codec());
+        compressed_chunk.set_block_size(
+            chunk.block_size() ? chunk.block_size() : cache_block_size_);
+        compressed_chunk.set_raw_size(chunk.data().size());
+        std::vector<uint32_t> block_lengths;
+        CompressBlocks(compressed_chunk, compression_level_,
+                       chunk.data().data(), chunk.data().size(),
+                       compressed_chunk.mutable_data(), &block_lengths);
+        compressed_chunk.mutable_block_lengths()->Add(block_lengths.begin(),
+                                                      block_lengths.end());
+        stored_chunk = &compressed_chunk;
+    }
+
+    bool placed;
+    auto disk = PlaceChunk(chunk_handle, &placed);
+
+    google::protobuf::util::Status status;
+    auto io_status = disk->io_queue->Execute(priority, [&]() {
+        protos::FileChunk metadata;
+        if (direct_io_) {
+            // 先写入数据块文件，再在数据库中记录版本号、长度与压缩信息
+            const auto& data = stored_chunk->data();
+            status = WriteChunkFile(disk, chunk_handle, 0, 0, data.data(),
+                                    data.size(), /*truncate=*/true);
+            if (!status.ok()) {
+                return;
+            }
+            metadata.set_version(stored_chunk->version());
+            metadata.set_size(data.size());
+            metadata.set_codec(stored_chunk->codec());
+            metadata.set_block_size(stored_chunk->block_size());
+            *metadata.mutable_block_lengths() = stored_chunk->block_lengths();
+            *metadata.mutable_block_offsets() = stored_chunk->block_offsets();
+            metadata.set_raw_size(stored_chunk->raw_size());
+        }
+
+        auto db_status = PutFileChunkToDisk(
+            disk, chunk_handle, direct_io_ ? metadata : *stored_chunk);
+        if (!db_status.ok()) {
+            status = google::protobuf::util::UnknownError(db_status.ToString());
+        }
+        // 整块写入，版本号与数据都可能变化
+        block_cache_->Erase(chunk_handle);
+    });
+    if (!io_status.ok() || !status.ok()) {
+        // 新的数据块没有写入，撤销选择的位置
+        if (placed) {
+            absl::MutexLock lock_guard(&placement_lock_);
+            chunk_disks_.Erase(chunk_handle);
+            disk->chunk_nums--;
+        }
+        return io_status.ok() ? status : io_status;
+    }
+
+    // 整块写入时版本号可能发生变化
+    chunk_versions_.Set(chunk_handle, chunk.version());
+    return google::protobuf::util::OkStatus();
+}
+
+google::protobuf::util::Status FileChunkManager::CommitReplicaChunk(
+    const std::string& chunk_handle, const protos::FileChunk& chunk,
+    const IoPriority& priority, const std::string& staging_name) {
+    const std::string& staged_name =
+        staging_name.empty() ? chunk_handle : staging_name;
+    bool placed;
+    auto disk = PlaceChunk(chunk_handle, &placed);
+
+    google::protobuf::util::Status status;
+    auto io_status = disk->io_queue->Execute(priority, [&]() {
+        protos::FileChunk stored_chunk = chunk;
+        stored_chunk.clear_data();
+        stored_chunk.clear_size();
+        if (direct_io_) {
+            ScopedFd file(OpenChunkFile(GetChunkFilePath(disk, chunk_handle),
+                                        O_RDWR | O_CREAT | O_TRUNC));
+            if (file.get() < 0) {
+                status = google::protobuf::util::UnknownError(
+                    "failed to open chunk file, chunk_handle: " +
+                    chunk_handle + ", " + std::strerror(errno));
+                return;
+            }
+            AlignedBuffer buffer(io_backend_.get(), io_backend_->buffer_size());
+            if (!buffer.data()) {
+                status = google::protobuf::util::ResourceExhaustedError(
+                    "failed to allocate aligned buffer");
+                return;
+            }
+
+            // 数据片按缓冲区大小切分，只有最后一片不满一页，不足的部分填 0
+            uint64_t stored_size = 0;
+            status = replica_stager_->Commit(
+                staged_name, [&](const uint64_t& offset, const char* data,
+                                  const size_t& length) {
+                    const uint64_t aligned_length = AlignUp(length, kPageSize);
+                    memcpy(buffer.data(), data, length);
+                    memset(buffer.data() + length, 0, aligned_length - length);
+                    stored_size = offset + length;
+                    return io_backend_->Write(file.get(), offset,
+                                              buffer.data(), aligned_length,
+                                              buffer.index());
+                });
+            if (status.ok()) {
+                status = io_backend_->Fsync(file.get());
+            }
+            if (!status.ok()) {
+                return;
+            }
+            stored_chunk.set_size(stored_size);
+        } else {
+            stored_chunk.mutable_data()->reserve(
+                replica_stager_->GetStagedBytes(staged_name));
+            status = replica_stager_->Commit(
+                staged_name, [&](const uint64_t& offset, const char* data,
+                                  const size_t& length) {
+                    stored_chunk.mutable_data()->append(data, length);
+                    return google::protobuf::util::OkStatus();
+                });
+            if (!status.ok()) {
+                return;
+            }
+        }
+
+        auto db_status = PutFileChunkToDisk(disk, chunk_handle, stored_chunk);
+        if (!db_status.ok()) {
+            status = google::protobuf::util::UnknownError(db_status.ToString());
+        }
+        block_cache_->Erase(chunk_handle);
+    });
+    if (!io_status.ok() || !status.ok()) {
+        if (placed) {
+            absl::MutexLock lock_guard(&placement_lock_);
+            chunk_disks_.Erase(chunk_handle);
+            disk->chunk_nums--;
+        }
+        return io_status.ok() ? status : io_status;
+    }
+
+    chunk_versions_.Set(chunk_handle, chunk.version());
     return google::protobuf::util::OkStatus();
 }
 
-leveldb::Status FileChunkManager::WriteFileChunk(
-    const std::string& chunk_handle, const protos::FileChunk& chunk) {
+leveldb::Status FileChunkManager::PutFileChunkToDisk(
+    ChunkDisk* disk, const std::string& chunk_handle,
+    const protos::FileChunk& chunk) {
     leveldb::WriteOptions options;
     // 开启同步
     options.sync = true;
-    return chunk_db_->Put(options, chunk_handle, chunk.SerializeAsString());
+    return disk->db->Put(options, chunk_handle, chunk.SerializeAsString());
+}
+
+FileChunkReader::~FileChunkReader() {
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+google::protobuf::util::StatusOr<std::string> FileChunkReader::Read(
+    const uint64_t& offset, const uint64_t& length) const {
+    if (offset >= size_) {
+        return std::string();
+    }
+    if (read_file_) {
+        return read_file_(offset, std::min(length, size_ - offset));
+    }
+    return std::string(data_ + offset, std::min(length, size_ - offset));
+}
+
+google::protobuf::util::StatusOr<std::shared_ptr<FileChunkReader>>
+FileChunkManager::OpenFileChunkReader(const std::string& chunk_handle,
+                                      const IoPriority& priority) {
+    using google::protobuf::internal::WireFormatLite;
+
+    auto disk = FindChunkDisk(chunk_handle);
+    if (!disk) {
+        return google::protobuf::util::NotFoundError(
+            "chunk not found, chunk_handle: " + chunk_handle);
+    }
+
+    std::shared_ptr<FileChunkReader> reader(new FileChunkReader);
+    google::protobuf::util::Status status;
+    auto io_status = disk->io_queue->Execute(priority, [&]() {
+        leveldb::ReadOptions options;
+        // 复制时整块读取，不占用块缓存
+        options.fill_cache = false;
+
+        reader->iter_.reset(disk->db->NewIterator(options));
+        reader->iter_->Seek(chunk_handle);
+        if (!reader->iter_->Valid() || reader->iter_->key() != chunk_handle) {
+            status = google::protobuf::util::NotFoundError(
+                "chunk not found, chunk_handle: " + chunk_handle);
+            return;
+        }
+
+        // 直接在 leveldb 的数据上解析 FileChunk，只记录 data 字段的位置，
+        // 其余字段复制出来解析为元数据
+        const leveldb::Slice value = reader->iter_->value();
+        google::protobuf::io::CodedInputStream input(
+            reinterpret_cast<const uint8_t*>(value.data()), value.size());
+        std::string fields;
+        bool parsed = true;
+        {
+            google::protobuf::io::StringOutputStream fields_stream(&fields);
+            google::protobuf::io::CodedOutputStream output(&fields_stream);
+            uint32_t tag;
+            while (parsed && (tag = input.ReadTag()) != 0) {
+                if (WireFormatLite::GetTagFieldNumber(tag) ==
+                        protos::FileChunk::kDataFieldNumber &&
+                    WireFormatLite::GetTagWireType(tag) ==
+                        WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+                    uint32_t length;
+                    parsed = input.ReadVarint32(&length);
+                    reader->data_ = value.data() + input.CurrentPosition();
+                    reader->size_ = length;
+                    parsed = parsed && input.Skip(length);
+                } else {
+                    parsed = WireFormatLite::SkipField(&input, tag, &output);
+                }
+            }
+        }
+
+        if (!parsed || !reader->metadata_.ParseFromString(fields)) {
+            status = google::protobuf::util::InternalError(
+                "chunk parse failed, chunk_handle: " + chunk_handle);
+            return;
+        }
+        reader->version_ = reader->metadata_.version();
+        const uint32_t file_size = reader->metadata_.size();
+
+        if (direct_io_) {
+            // 按帧读取数据块文件，不经过分块缓存，避免复制挤掉热点数据
+            reader->iter_.reset();
+            reader->fd_ =
+                OpenChunkFile(GetChunkFilePath(disk, chunk_handle), O_RDONLY);
+            if (reader->fd_ < 0) {
+                status = google::protobuf::util::DataLossError(
+                    "failed to open chunk file, chunk_handle: " +
+                    chunk_handle + ", " + std::strerror(errno));
+                return;
+            }
+            reader->data_ = nullptr;
+            reader->size_ = file_size;
+            const int fd = reader->fd_;
+            reader->read_file_ = [this, disk, chunk_handle, file_size, fd,
+                                  priority](const uint64_t& offset,
+                                            const uint64_t& length)
+                -> google::protobuf::util::StatusOr<std::string> {
+                google::protobuf::util::StatusOr<std::string> data_or;
+                auto io_status = disk->io_queue->Execute(priority, [&]() {
+                    data_or = ReadChunkFile(fd, chunk_handle, file_size, offset,
+                                            length);
+                });
+                if (!io_status.ok()) {
+                    return io_status;
+                }
+                return data_or;
+            };
+        }
+    });
+    if (!io_status.ok()) {
+        return io_status;
+    }
+    if (!status.ok()) {
+        return status;
+    }
+
+    return reader;
+}
+
+google::protobuf::util::StatusOr<std::shared_ptr<FileChunkReader>>
+FileChunkManager::OpenStagedChunkReader(const std::string& staging_name,
+                                        const protos::FileChunk& metadata) {
+    std::shared_ptr<FileChunkReader> reader(new FileChunkReader);
+    reader->metadata_ = metadata;
+    reader->metadata_.clear_data();
+    reader->version_ = metadata.version();
+    reader->size_ = replica_stager_->GetStagedBytes(staging_name);
+    auto stager = replica_stager_.get();
+    reader->read_file_ = [stager, staging_name](const uint64_t& offset,
+                                                const uint64_t& length) {
+        return stager->Read(staging_name, offset, length);
+    };
+    return reader;
 }
 
+ChunkReplicaStager* FileChunkManager::GetChunkReplicaStager() {
+    return replica_stager_.get();
+}
+
+ChunkIoBackend* FileChunkManager::GetChunkIoBackend() {
+    return io_backend_.get();
+}
+
+ChunkBlockCache* FileChunkManager::GetChunkBlockCache() {
+    return block_cache_.get();
+}
+
+bool FileChunkManager::IsDirectIo() const { return direct_io_; }
+
 std::list<protos::FileChunkMetadata>
 FileChunkManager::GetAllFileChunkMetadata() {
     std::list<protos::FileChunkMetadata> metadatas;
-    std::unique_ptr<leveldb::Iterator> it(
-        chunk_db_->NewIterator(leveldb::ReadOptions()));
+    for (auto& disk : disks_) {
+        // 全盘扫描，优先级最低，不影响客户端请求
+        disk->io_queue->Execute(IoPriority::SCRUBBING, [&]() {
+            leveldb::ReadOptions options;
+            options.fill_cache = false;
+            std::unique_ptr<leveldb::Iterator> it(
+                disk->db->NewIterator(options));
 
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        protos::FileChunk chunk;
-        if (chunk.ParseFromString(it->value().ToString())) {
-            protos::FileChunkMetadata metadata;
-            metadata.set_chunk_handle(it->key().ToString());
-            metadata.set_version(chunk.version());
+            for (it->SeekToFirst(); it->Valid(); it->Next()) {
+                protos::FileChunk chunk;
+                if (chunk.ParseFromString(it->value().ToString())) {
+                    protos::FileChunkMetadata metadata;
+                    metadata.set_chunk_handle(it->key().ToString());
+                    metadata.set_version(chunk.version());
 
-            metadatas.emplace_back(metadata);
-        }
+                    metadatas.emplace_back(metadata);
+                }
+            }
+        });
     }
 
     return metadatas;
@@ -190,23 +1059,42 @@ FileChunkManager::GetAllFileChunkMetadata() {
 google::protobuf::util::Status FileChunkManager::UpdateChunkVersion(
     const std::string& chunk_handle, const uint32_t& old_version,
     const uint32_t& new_version) {
-    // get the specified verison of the chunk
-    auto file_chunk_or = GetFileChunk(chunk_handle, old_version);
-    if (!file_chunk_or.ok()) {
-        return file_chunk_or.status();
+    auto disk = FindChunkDisk(chunk_handle);
+    if (!disk) {
+        return google::protobuf::util::NotFoundError(
+            "chunk not found, chunk_handle: " + chunk_handle);
     }
 
-    auto file_chunk = file_chunk_or.value();
-    file_chunk->set_version(new_version);
+    google::protobuf::util::Status status;
+    auto io_status = disk->io_queue->Execute(
+        IoPriority::FOREGROUND_WRITE, [&]() {
+            // get the specified verison of the chunk
+            auto file_chunk_or = GetFileChunkFromDisk(
+                disk, chunk_handle, &old_version, /*read_data=*/false);
+            if (!file_chunk_or.ok()) {
+                status = file_chunk_or.status();
+                return;
+            }
+
+            auto file_chunk = file_chunk_or.value();
+            file_chunk->set_version(new_version);
 
-    // write change back to db
-    auto status = WriteFileChunk(chunk_handle, *file_chunk.get());
+            // write change back to db
+            if (!PutFileChunkToDisk(disk, chunk_handle, *file_chunk).ok()) {
+                status = google::protobuf::util::UnknownError("");
+            }
+        });
+    if (!io_status.ok()) {
+        return io_status;
+    }
     if (!status.ok()) {
-        return google::protobuf::util::UnknownError("");
+        return status;
     }
 
     // update chunk_verisons in memory
     chunk_versions_.Set(chunk_handle, new_version);
+    // 旧版本的分块不会再被读取
+    block_cache_->Erase(chunk_handle);
 
     return google::protobuf::util::OkStatus();
 }
@@ -215,7 +1103,23 @@ google::protobuf::util::StatusOr<uint32_t> FileChunkManager::GetChunkVersion(
     const std::string& chunk_handle) {
     auto value_pair = chunk_versions_.TryGet(chunk_handle);
     if (!value_pair.second) {
-        auto chunk_or = GetFileChunk(chunk_handle);
+        auto disk = FindChunkDisk(chunk_handle);
+        if (!disk) {
+            return google::protobuf::util::NotFoundError(
+                "chunk not found, chunk_handle: " + chunk_handle);
+        }
+
+        // 只需要版本号，不读取数据块文件
+        google::protobuf::util::StatusOr<std::shared_ptr<protos::FileChunk>>
+            chunk_or;
+        auto io_status =
+            disk->io_queue->Execute(IoPriority::FOREGROUND_READ, [&]() {
+                chunk_or = GetFileChunkFromDisk(disk, chunk_handle, nullptr,
+                                                /*read_data=*/false);
+            });
+        if (!io_status.ok()) {
+            return io_status;
+        }
         if (!chunk_or.ok()) {
             return chunk_or.status();
         }
@@ -230,23 +1134,23 @@ google::protobuf::util::StatusOr<uint32_t> FileChunkManager::GetChunkVersion(
 
 google::protobuf::util::StatusOr<std::shared_ptr<protos::FileChunk>>
 FileChunkManager::GetFileChunk(const std::string& chunk_handle) {
-    leveldb::ReadOptions options;
-    std::string data;
-
-    auto status = chunk_db_->Get(options, chunk_handle, &data);
-    if (!status.ok()) {
+    auto disk = FindChunkDisk(chunk_handle);
+    if (!disk) {
         return google::protobuf::util::NotFoundError(
-            "chunk not found, chunk_handle: " + chunk_handle +
-            ", status: " + status.ToString());
+            "chunk not found, chunk_handle: " + chunk_handle);
     }
 
-    std::shared_ptr<protos::FileChunk> chunk(new protos::FileChunk);
-    if (!chunk->ParseFromString(data)) {
-        return google::protobuf::util::InternalError(
-            "chunk parse failed, data: " + data);
+    google::protobuf::util::StatusOr<std::shared_ptr<protos::FileChunk>>
+        result;
+    auto io_status =
+        disk->io_queue->Execute(IoPriority::FOREGROUND_READ, [&]() {
+            result = GetFileChunkFromDisk(disk, chunk_handle, nullptr);
+        });
+    if (!io_status.ok()) {
+        return io_status;
     }
 
-    return chunk;
+    return result;
 }
 
 google::protobuf::util::StatusOr<std::shared_ptr<protos::FileChunk>>
@@ -266,5 +1170,539 @@ FileChunkManager::GetFileChunk(const std::string& chunk_handle,
     return chunk_or.value();
 }
 
+google::protobuf::util::StatusOr<std::shared_ptr<protos::FileChunk>>
+FileChunkManager::GetFileChunkFromDisk(ChunkDisk* disk,
+                                       const std::string& chunk_handle,
+                                       const uint32_t* version,
+                                       const bool& read_data) {
+    leveldb::ReadOptions options;
+    std::string data;
+
+    auto status = disk->db->Get(options, chunk_handle, &data);
+    if (!status.ok()) {
+        return google::protobuf::util::NotFoundError(
+            "chunk not found, chunk_handle: " + chunk_handle +
+            ", status: " + status.ToString());
+    }
+
+    std::shared_ptr<protos::FileChunk> chunk(new protos::FileChunk);
+    if (!chunk->ParseFromString(data)) {
+        return google::protobuf::util::InternalError(
+            "chunk parse failed, data: " + data);
+    }
+
+    // 指定了版本时检查版本号
+    if (version && chunk->version() != *version) {
+        return google::protobuf::util::NotFoundError(
+            "no chunk found for the specified version, handle: " +
+            chunk_handle + " version: " + std::to_string(*version));
+    }
+
+    if (direct_io_ && read_data) {
+        auto data_or = ReadChunkFile(disk, chunk_handle, chunk->size(), 0,
+                                     chunk->size());
+        if (!data_or.ok()) {
+            return data_or.status();
+        }
+        chunk->set_data(std::move(data_or.value()));
+    }
+
+    // 返回解压后的数据
+    if (read_data && IsCompressed(*chunk)) {
+        std::string raw_data;
+        raw_data.reserve(chunk->raw_size());
+        const auto offsets = GetStoredOffsets(*chunk);
+        for (size_t block = 0; block < offsets.size(); block++) {
+            const uint64_t block_length = chunk->block_lengths(block);
+            if (offsets[block] + block_length > chunk->data().size()) {
+                return google::protobuf::util::DataLossError(
+                    "compressed chunk data is truncated, chunk_handle: " +
+                    chunk_handle);
+            }
+            auto decompress_status = DecompressBlocks(
+                *chunk, block, chunk->data().data() + offsets[block],
+                block_length, &raw_data);
+            if (!decompress_status.ok()) {
+                return decompress_status;
+            }
+        }
+        chunk->set_data(std::move(raw_data));
+        chunk->clear_block_lengths();
+        chunk->clear_block_offsets();
+    }
+
+    return chunk;
+}
+
+uint64_t FileChunkManager::GetChunkSize(const protos::FileChunk& chunk) const {
+    return IsCompressed(chunk) ? chunk.raw_size() : GetStoredSize(chunk);
+}
+
+uint64_t FileChunkManager::GetStoredSize(
+    const protos::FileChunk& chunk) const {
+    return direct_io_ ? chunk.size() : chunk.data().size();
+}
+
+std::string FileChunkManager::GetChunkFilePath(
+    ChunkDisk* disk, const std::string& chunk_handle) const {
+    return disk->chunk_dir + "/" + chunk_handle;
+}
+
+google::protobuf::util::Status FileChunkManager::LoadChunkBlocks(
+    ChunkDisk* disk, const std::string& chunk_handle, const uint32_t& version,
+    const uint64_t& first_block, const std::vector<size_t>& indexes,
+    std::vector<ChunkBlockCache::BlockLookup>* lookups) {
+    google::protobuf::util::Status status;
+    auto io_status = disk->io_queue->Execute(
+        IoPriority::FOREGROUND_READ, [&]() {
+            // get the specified verison of the chunk，leveldb 中的数据块
+            // 一次读出，数据块文件只读取需要的分块
+            auto file_chunk_or = GetFileChunkFromDisk(
+                disk, chunk_handle, &version, /*read_data=*/false);
+            if (!file_chunk_or.ok()) {
+                status = file_chunk_or.status();
+                return;
+            }
+
+            auto file_chunk = file_chunk_or.value();
+            const uint64_t chunk_size = GetChunkSize(*file_chunk);
+            for (size_t k = 0; k < indexes.size();) {
+                const size_t i = indexes[k];
+                const uint64_t block_start =
+                    (first_block + i) * cache_block_size_;
+                if (block_start > chunk_size) {
+                    (*lookups)[i].data = nullptr;
+                    k++;
+                    continue;
+                }
+
+                // 连续的分块合并为一次读取
+                size_t run_blocks = 1;
+                while (k + run_blocks < indexes.size() &&
+                       indexes[k + run_blocks] == i + run_blocks) {
+                    run_blocks++;
+                }
+
+                const uint64_t run_length =
+                    std::min(chunk_size,
+                             block_start + run_blocks * cache_block_size_) -
+                    block_start;
+                std::string data;
+                if (IsCompressed(*file_chunk)) {
+                    // 只解压读到的分块
+                    auto data_or =
+                        ReadCompressedChunk(disk, chunk_handle, *file_chunk,
+                                            block_start, run_length);
+                    if (!data_or.ok()) {
+                        status = data_or.status();
+                        return;
+                    }
+                    data = std::move(data_or.value());
+                } else if (direct_io_) {
+                    auto data_or = ReadChunkFile(disk, chunk_handle,
+                                                 chunk_size, block_start,
+                                                 run_length);
+                    if (!data_or.ok()) {
+                        status = data_or.status();
+                        return;
+                    }
+                    data = std::move(data_or.value());
+                } else {
+                    data = file_chunk->data().substr(block_start, run_length);
+                }
+
+                for (size_t j = 0; j < run_blocks; j++) {
+                    const uint64_t offset = j * cache_block_size_;
+                    (*lookups)[i + j].data =
+                        offset > data.size()
+                            ? nullptr
+                            : std::make_shared<const std::string>(
+                                  data, offset, cache_block_size_);
+                }
+                k += run_blocks;
+            }
+        });
+    return io_status.ok() ? status : io_status;
+}
+
+google::protobuf::util::StatusOr<std::string> FileChunkManager::ReadChunkFile(
+    ChunkDisk* disk, const std::string& chunk_handle, const uint64_t& size,
+    const uint64_t& offset, const uint64_t& length) {
+    if (offset >= std::min(size, offset + length)) {
+        return std::string();
+    }
+
+    ScopedFd file(
+        OpenChunkFile(GetChunkFilePath(disk, chunk_handle), O_RDONLY));
+    if (file.get() < 0) {
+        return google::protobuf::util::DataLossError(
+            "failed to open chunk file, chunk_handle: " + chunk_handle + ", " +
+            std::strerror(errno));
+    }
+    return ReadChunkFile(file.get(), chunk_handle, size, offset, length);
+}
+
+google::protobuf::util::StatusOr<std::string> FileChunkManager::ReadChunkFile(
+    const int& fd, const std::string& chunk_handle, const uint64_t& size,
+    const uint64_t& offset, const uint64_t& length) {
+    const uint64_t end = std::min(size, offset + length);
+    if (offset >= end) {
+        return std::string();
+    }
+
+    AlignedBuffer buffer(io_backend_.get(), cache_block_size_);
+    if (!buffer.data()) {
+        return google::protobuf::util::ResourceExhaustedError(
+            "failed to allocate aligned buffer");
+    }
+
+    // O_DIRECT 只能整页读取，每次最多读满一个缓冲区
+    std::string result;
+    result.reserve(end - offset);
+    const uint64_t aligned_end = AlignUp(end, kPageSize);
+    for (uint64_t pos = offset / kPageSize * kPageSize; pos < end;) {
+        const uint64_t segment =
+            std::min<uint64_t>(buffer.size(), aligned_end - pos);
+        auto read_or =
+            io_backend_->Read(fd, pos, buffer.data(), segment, buffer.index());
+        if (!read_or.ok()) {
+            return read_or.status();
+        }
+
+        // 文件按页补齐，只保留数据块长度以内的数据
+        const uint64_t from = std::max(pos, offset);
+        const uint64_t to = std::min(end, pos + read_or.value());
+        if (to < std::min(end, pos + segment)) {
+            return google::protobuf::util::DataLossError(
+                "chunk file is shorter than chunk size, chunk_handle: " +
+                chunk_handle);
+        }
+        result.append(buffer.data() + (from - pos), to - from);
+        pos += segment;
+    }
+    return result;
+}
+
+google::protobuf::util::Status FileChunkManager::WriteChunkFile(
+    ChunkDisk* disk, const std::string& chunk_handle, const uint64_t& size,
+    const uint64_t& offset, const char* data, const uint64_t& length,
+    const bool& truncate) {
+    ScopedFd file(OpenChunkFile(GetChunkFilePath(disk, chunk_handle),
+                                O_RDWR | O_CREAT));
+    if (file.get() < 0) {
+        return google::protobuf::util::UnknownError(
+            "failed to open chunk file, chunk_handle: " + chunk_handle + ", " +
+            std::strerror(errno));
+    }
+
+    const uint64_t end = offset + length;
+    const uint64_t aligned_end = AlignUp(end, kPageSize);
+    if (length > 0) {
+        AlignedBuffer buffer(io_backend_.get(), cache_block_size_);
+        if (!buffer.data()) {
+            return google::protobuf::util::ResourceExhaustedError(
+                "failed to allocate aligned buffer");
+        }
+
+        // O_DIRECT 只能整页写入，每次最多写满一个缓冲区
+        for (uint64_t pos = offset / kPageSize * kPageSize; pos < aligned_end;) {
+            const uint64_t segment =
+                std::min<uint64_t>(buffer.size(), aligned_end - pos);
+            const uint64_t data_begin = std::max(pos, offset);
+            const uint64_t data_end = std::min(pos + segment, end);
+
+            // 首尾不完整的页保留原有的数据
+            google::protobuf::util::Status status;
+            if (data_begin > pos) {
+                status = ReadPage(io_backend_.get(), file.get(), pos, size,
+                                  buffer.data(), buffer.index());
+            }
+            const uint64_t tail_page = pos + segment - kPageSize;
+            if (status.ok() && data_end < pos + segment &&
+                (tail_page != pos || data_begin == pos)) {
+                status = ReadPage(io_backend_.get(), file.get(), tail_page,
+                                  size, buffer.data() + segment - kPageSize,
+                                  buffer.index());
+            }
+            if (!status.ok()) {
+                return status;
+            }
+
+            memcpy(buffer.data() + (data_begin - pos),
+                   data + (data_begin - offset), data_end - data_begin);
+            status = io_backend_->Write(file.get(), pos, buffer.data(),
+                                        segment, buffer.index());
+            if (!status.ok()) {
+                return status;
+            }
+            pos += segment;
+        }
+    }
+
+    if (truncate && ftruncate(file.get(), aligned_end)) {
+        return google::protobuf::util::UnknownError(
+            "failed to truncate chunk file, chunk_handle: " + chunk_handle +
+            ", " + std::strerror(errno));
+    }
+
+    // 与数据库的同步写入一致，落盘后才返回
+    return io_backend_->Fsync(file.get());
+}
+
+google::protobuf::util::StatusOr<std::string>
+FileChunkManager::ReadCompressedChunk(ChunkDisk* disk,
+                                      const std::string& chunk_handle,
+                                      const protos::FileChunk& chunk,
+                                      const uint64_t& offset,
+                                      const uint64_t& length) {
+    const uint64_t end = std::min<uint64_t>(chunk.raw_size(), offset + length);
+    if (offset >= end) {
+        return std::string();
+    }
+
+    const uint64_t block_size = chunk.block_size();
+    const uint64_t first_block = offset / block_size;
+    const uint64_t last_block = (end - 1) / block_size;
+    if (!block_size ||
+        last_block >= static_cast<uint64_t>(chunk.block_lengths_size())) {
+        return google::protobuf::util::DataLossError(
+            "compressed chunk blocks are inconsistent, chunk_handle: " +
+            chunk_handle);
+    }
+
+    // 位置相邻的分块合并为一次读取
+    const auto offsets = GetStoredOffsets(chunk);
+    std::string data;
+    data.reserve((last_block - first_block + 1) * block_size);
+    for (uint64_t run_first = first_block; run_first <= last_block;) {
+        const uint64_t stored_begin = offsets[run_first];
+        uint64_t stored_length = chunk.block_lengths(run_first);
+        uint64_t run_last = run_first;
+        while (run_last < last_block &&
+               offsets[run_last + 1] == stored_begin + stored_length) {
+            run_last++;
+            stored_length += chunk.block_lengths(run_last);
+        }
+
+        std::string stored;
+        const char* stored_data = nullptr;
+        if (direct_io_) {
+            auto stored_or = ReadChunkFile(disk, chunk_handle, chunk.size(),
+                                           stored_begin, stored_length);
+            if (!stored_or.ok()) {
+                return stored_or.status();
+            }
+            stored = std::move(stored_or.value());
+            stored_data = stored.data();
+            if (stored.size() < stored_length) {
+                return google::protobuf::util::DataLossError(
+                    "chunk file is shorter than chunk size, chunk_handle: " +
+                    chunk_handle);
+            }
+        } else {
+            if (stored_begin + stored_length > chunk.data().size()) {
+                return google::protobuf::util::DataLossError(
+                    "compressed chunk data is truncated, chunk_handle: " +
+                    chunk_handle);
+            }
+            stored_data = chunk.data().data() + stored_begin;
+        }
+
+        auto status = DecompressBlocks(chunk, run_first, stored_data,
+                                       stored_length, &data);
+        if (!status.ok()) {
+            return status;
+        }
+        run_first = run_last + 1;
+    }
+
+    // 去掉第一个分块中 offset 之前与最后一个分块中 end 之后的数据
+    data.erase(0, offset - first_block * block_size);
+    data.resize(end - offset);
+    return data;
+}
+
+google::protobuf::util::Status FileChunkManager::WriteCompressedChunk(
+    ChunkDisk* disk, const std::string& chunk_handle, protos::FileChunk* chunk,
+    const uint64_t& offset, const char* data, const uint64_t& length) {
+    if (!length) {
+        return google::protobuf::util::OkStatus();
+    }
+
+    const uint64_t block_size = chunk->block_size();
+    if (!block_size) {
+        return google::protobuf::util::DataLossError(
+            "compressed chunk has no block size, chunk_handle: " +
+            chunk_handle);
+    }
+    const uint64_t block_nums = chunk->block_lengths_size();
+    const uint64_t end = offset + length;
+    const uint64_t first_block = offset / block_size;
+    const uint64_t last_block = (end - 1) / block_size;
+    // 被修改的已有分块为 [first_block, existing_end)
+    const uint64_t existing_end = std::min<uint64_t>(block_nums, last_block + 1);
+
+    // 读出被修改的分块原有的数据，覆盖写入的部分
+    const uint64_t rewrite_start = first_block * block_size;
+    std::string raw_data;
+    if (first_block < existing_end) {
+        auto raw_or = ReadCompressedChunk(disk, chunk_handle, *chunk,
+                                          rewrite_start,
+                                          existing_end * block_size -
+                                              rewrite_start);
+        if (!raw_or.ok()) {
+            return raw_or.status();
+        }
+        raw_data = std::move(raw_or.value());
+    }
+    raw_data.resize(std::max<uint64_t>(raw_data.size(), end - rewrite_start));
+    memcpy(&raw_data[offset - rewrite_start], data, length);
+
+    std::string stored;
+    std::vector<uint32_t> block_lengths;
+    CompressBlocks(*chunk, compression_level_, raw_data.data(),
+                   raw_data.size(), &stored, &block_lengths);
+
+    // 重新压缩的分块追加在压缩数据的末尾，其他分块不移动。位于末尾的
+    // 被修改分块的位置可以直接复用
+    const uint64_t stored_size = GetStoredSize(*chunk);
+    auto offsets = GetStoredOffsets(*chunk);
+    uint64_t write_start = stored_size;
+    for (bool moved = true; moved;) {
+        moved = false;
+        for (uint64_t block = first_block; block < existing_end; block++) {
+            if (offsets[block] < write_start &&
+                offsets[block] + chunk->block_lengths(block) == write_start) {
+                write_start = offsets[block];
+                moved = true;
+            }
+        }
+    }
+
+    if (direct_io_) {
+        auto status =
+            WriteChunkFile(disk, chunk_handle, stored_size, write_start,
+                           stored.data(), stored.size(), /*truncate=*/true);
+        if (!status.ok()) {
+            return status;
+        }
+        chunk->set_size(write_start + stored.size());
+    } else {
+        chunk->mutable_data()->replace(write_start, std::string::npos, stored);
+    }
+
+    uint64_t block_offset = write_start;
+    for (size_t i = 0; i < block_lengths.size(); i++) {
+        const uint64_t block = first_block + i;
+        if (block < block_nums) {
+            chunk->set_block_lengths(block, block_lengths[i]);
+            offsets[block] = block_offset;
+        } else {
+            chunk->add_block_lengths(block_lengths[i]);
+            offsets.push_back(block_offset);
+        }
+        block_offset += block_lengths[i];
+    }
+    SetStoredOffsets(offsets, chunk);
+    chunk->set_raw_size(std::max<uint64_t>(chunk->raw_size(), end));
+
+    // 空洞超过分块的总长度时重新依次拼接，整理的代价分摊到之前的写入
+    const uint64_t live_size = GetLiveStoredSize(*chunk);
+    if (GetStoredSize(*chunk) - live_size > live_size) {
+        return CompactCompressedChunk(disk, chunk_handle, chunk);
+    }
+    return google::protobuf::util::OkStatus();
+}
+
+google::protobuf::util::Status FileChunkManager::CompactCompressedChunk(
+    ChunkDisk* disk, const std::string& chunk_handle,
+    protos::FileChunk* chunk) {
+    const uint64_t stored_size = GetStoredSize(*chunk);
+    std::string stored;
+    if (direct_io_) {
+        auto stored_or =
+            ReadChunkFile(disk, chunk_handle, stored_size, 0, stored_size);
+        if (!stored_or.ok()) {
+            return stored_or.status();
+        }
+        stored = std::move(stored_or.value());
+    } else {
+        stored = std::move(*chunk->mutable_data());
+    }
+
+    const auto offsets = GetStoredOffsets(*chunk);
+    std::string compacted;
+    compacted.reserve(GetLiveStoredSize(*chunk));
+    for (size_t block = 0; block < offsets.size(); block++) {
+        const uint64_t block_length = chunk->block_lengths(block);
+        if (offsets[block] + block_length > stored.size()) {
+            return google::protobuf::util::DataLossError(
+                "compressed chunk data is truncated, chunk_handle: " +
+                chunk_handle);
+        }
+        compacted.append(stored, offsets[block], block_length);
+    }
+
+    if (direct_io_) {
+        auto status =
+            WriteChunkFile(disk, chunk_handle, stored_size, 0, compacted.data(),
+                           compacted.size(), /*truncate=*/true);
+        if (!status.ok()) {
+            return status;
+        }
+        chunk->set_size(compacted.size());
+    } else {
+        chunk->set_data(std::move(compacted));
+    }
+    chunk->clear_block_offsets();
+    return google::protobuf::util::OkStatus();
+}
+
+void FileChunkManager::InvalidateBlocks(const std::string& chunk_handle,
+                                        const uint64_t& offset,
+                                        const uint64_t& length) {
+    if (!length) {
+        return;
+    }
+    block_cache_->Erase(chunk_handle, offset / cache_block_size_,
+                        (offset + length - 1) / cache_block_size_);
+}
+
+uint32_t FileChunkManager::GetAvailableDiskMb() const {
+    uint64_t available_mb = 0;
+    // 多个数据目录可能位于同一个文件系统
+    std::set<uint64_t> counted_fsids;
+    for (const auto& disk : disks_) {
+        struct statvfs disk_stat;
+        if (statvfs(disk->data_dir.c_str(), &disk_stat)) {
+            continue;
+        }
+        if (!counted_fsids.insert(disk_stat.f_fsid).second) {
+            continue;
+        }
+
+        available_mb += static_cast<uint64_t>(disk_stat.f_bavail) *
+                        disk_stat.f_frsize / dfs::common::bytesMB;
+    }
+
+    return static_cast<uint32_t>(
+        std::min<uint64_t>(available_mb, UINT32_MAX));
+}
+
+size_t FileChunkManager::GetDiskNums() const { return disks_.size(); }
+
+std::string FileChunkManager::GetChunkDataDir(
+    const std::string& chunk_handle) {
+    auto disk = FindChunkDisk(chunk_handle);
+    return disk ? disk->data_dir : "";
+}
+
+DiskIoQueue* FileChunkManager::GetDiskIoQueue(const size_t& disk_index) {
+    if (disk_index >= disks_.size()) {
+        return nullptr;
+    }
+    return disks_[disk_index]->io_queue.get();
+}
+
 }  // namespace server
-}  // namespace dfs
\ No newline at end of file
+}  // namespace dfs
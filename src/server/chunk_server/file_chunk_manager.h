@@ -1,21 +1,98 @@
 #ifndef DFS_SERVER_CHUNK_SERVER_FILE_CHUNK_MANAGER_H
 #define DFS_SERVER_CHUNK_SERVER_FILE_CHUNK_MANAGER_H
 
+#include <absl/synchronization/mutex.h>
+
+#include <atomic>
+#include <functional>
 #include <list>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "chunk_server.pb.h"
 #include "google/protobuf/stubs/status.h"
 #include "google/protobuf/stubs/statusor.h"
 #include "leveldb/db.h"
 #include "metadata.pb.h"
+#include "src/common/metrics.h"
 #include "src/common/utils.h"
+#include "src/server/chunk_server/chunk_block_cache.h"
+#include "src/server/chunk_server/chunk_io_backend.h"
+#include "src/server/chunk_server/chunk_replica_stager.h"
+#include "src/server/chunk_server/disk_io_queue.h"
 
 namespace dfs {
 namespace server {
 
+// 只读地访问一个数据块，直接引用 leveldb 中的数据而不复制整个数据块，
+// 用于流式复制时按帧读取。O_DIRECT 模式下打开数据块文件，每次读取一帧，
+// 内存占用与帧大小有关而与数据块大小无关。
+// 压缩的数据块读到的是压缩后的数据，与 metadata 一起写入目标块服务器
+class FileChunkReader {
+   public:
+    ~FileChunkReader();
+
+    uint32_t version() const { return version_; }
+
+    uint64_t size() const { return size_; }
+
+    // 数据块的版本与压缩信息，不包含数据
+    const protos::FileChunk& metadata() const { return metadata_; }
+
+    // 读取 offset 处最多 length 字节的数据，可以在多个线程中同时调用。
+    // O_DIRECT 模式下经过数据块所在磁盘的 I/O 队列读取数据块文件
+    google::protobuf::util::StatusOr<std::string> Read(
+        const uint64_t& offset, const uint64_t& length) const;
+
+   private:
+    friend class FileChunkManager;
+
+    FileChunkReader() = default;
+
+    // 迭代器有效期间 value 引用的数据不会被释放
+    std::unique_ptr<leveldb::Iterator> iter_;
+
+    // O_DIRECT 模式下打开的数据块文件，数据块被删除后仍然可以读取
+    int fd_ = -1;
+
+    // O_DIRECT 模式下读取数据块文件 [offset, offset + length)，
+    // 暂存区中的数据块从暂存文件读取
+    std::function<google::protobuf::util::StatusOr<std::string>(
+        const uint64_t&, const uint64_t&)>
+        read_file_;
+
+    uint32_t version_ = 0;
+
+    protos::FileChunk metadata_;
+
+    const char* data_ = nullptr;
+
+    uint64_t size_ = 0;
+};
+
+// 数据块的存储方式
+struct ChunkStoreOptions {
+    // 为 true 时数据块的数据保存在数据目录旁的数据块文件中，以 O_DIRECT
+    // 读写，数据库只保存版本号与长度。已有数据的目录不能切换存储方式
+    bool direct_io = false;
+    // 读缓存中每个分块的大小，按 4KB 对齐，不超过 I/O 后端的缓冲区大小
+    uint32_t cache_block_size = 64 * 1024;
+    // 读缓存的字节数上限，为 0 时不缓存
+    uint64_t cache_capacity_bytes = 256 * 1024 * 1024;
+    // 压缩数据块时 zstd 的压缩级别，为 0 时使用默认级别
+    int compression_level = 0;
+};
+
 // control the chunks locally on the chunkserver
+// 每个数据目录（一块磁盘）一个数据库以及一个 I/O 队列，新的数据块放在
+// 数据块最少的磁盘上，所有读写都经过数据块所在磁盘的 I/O 队列。
+// 开启 O_DIRECT 模式时数据块的数据保存在单独的文件中，绕过内核页缓存，
+// 以对齐的缓冲区读写。两种模式下 ReadFromChunk 读到的分块都缓存在
+// ChunkBlockCache 中，热点数据块的读取不需要访问磁盘。
+// 创建时指定了压缩算法的数据块按读缓存的分块大小分块压缩，读取时只解压
+// 读到的分块，缓存中保存解压后的数据；写入时只重新压缩修改的分块并追加
+// 到压缩数据的末尾，其他分块不移动
 
 class FileChunkManager {
     friend class ChunkServerFileServiceImpl;
@@ -27,13 +104,27 @@ class FileChunkManager {
     bool Initialize(const std::string& chunk_dbname,
                     const uint32_t& max_bytes_per_chunk);
 
+    // 每个数据目录一块磁盘，每块磁盘使用 io_options 创建 I/O 队列，
+    // 文件读写使用 backend_options 创建的 I/O 后端，store_options 决定
+    // 数据块的存储方式
+    bool Initialize(const std::vector<std::string>& data_dirs,
+                    const uint32_t& max_bytes_per_chunk,
+                    const DiskIoQueue::Options& io_options,
+                    const ChunkIoBackend::Options& backend_options =
+                        ChunkIoBackend::Options(),
+                    const ChunkStoreOptions& store_options =
+                        ChunkStoreOptions());
+
     // interacting with leveldb
 
-    // 创建数据块，指定了块句柄以及版本
-    google::protobuf::util::Status CreateChunk(const std::string& chunk_handle,
-                                               const uint32_t& chunk_version);
+    // 创建数据块，指定了块句柄、版本以及数据块的压缩算法
+    google::protobuf::util::Status CreateChunk(
+        const std::string& chunk_handle, const uint32_t& chunk_version,
+        const IoPriority& priority = IoPriority::FOREGROUND_WRITE,
+        const protos::ChunkCodec& codec = protos::CODEC_NONE);
 
-    // 读取数据块
+    // 读取数据块，先查找读缓存，未命中的分块从磁盘读取后放入缓存，
+    // 多个线程同时读取同一分块时只读取一次磁盘
     google::protobuf::util::StatusOr<std::string> ReadFromChunk(
         const std::string& chunk_handle, const uint32_t& version,
         const uint32_t& offset, const uint32_t& length);
@@ -53,8 +144,20 @@ class FileChunkManager {
     google::protobuf::util::Status DeleteChunk(const std::string& chunk_handle);
 
     // write file chunk to leveldb
-    leveldb::Status WriteFileChunk(const std::string& chunk_handle,
-                                   const protos::FileChunk& chunk);
+    // 压缩的数据块带有 block_lengths 时 data 为压缩后的数据（如流式复制
+    // 收到的数据块），否则 data 为原始数据，写入前按分块压缩
+    google::protobuf::util::Status WriteFileChunk(
+        const std::string& chunk_handle, const protos::FileChunk& chunk,
+        const IoPriority& priority = IoPriority::FOREGROUND_WRITE);
+
+    // 提交流式复制暂存的数据块，chunk 为数据块的版本与压缩信息，不包含数据。
+    // O_DIRECT 模式下逐片写入数据块文件，内存中只保留一片数据；否则数据块
+    // 整体保存在数据库中，在内存中拼接后写入。
+    // staging_name 为暂存数据的名称，为空时与块句柄相同
+    google::protobuf::util::Status CommitReplicaChunk(
+        const std::string& chunk_handle, const protos::FileChunk& chunk,
+        const IoPriority& priority = IoPriority::REPLICATION,
+        const std::string& staging_name = "");
 
     // when chunkserver starts, report the stored chunkmetadata to master
     std::list<protos::FileChunkMetadata> GetAllFileChunkMetadata();
@@ -68,6 +171,7 @@ class FileChunkManager {
         const std::string& chunk_handle);
 
     // get the specified chunk from the db
+    // 压缩的数据块返回解压后的数据，block_lengths 为空
     google::protobuf::util::StatusOr<std::shared_ptr<protos::FileChunk>>
     GetFileChunk(const std::string& chunk_handle);
 
@@ -75,17 +179,184 @@ class FileChunkManager {
     google::protobuf::util::StatusOr<std::shared_ptr<protos::FileChunk>>
     GetFileChunk(const std::string& chunk_handle, const uint32_t& version);
 
+    // 以只读的方式打开数据块，不会将整个数据块复制到内存中
+    google::protobuf::util::StatusOr<std::shared_ptr<FileChunkReader>>
+    OpenFileChunkReader(const std::string& chunk_handle,
+                        const IoPriority& priority = IoPriority::REPLICATION);
+
+    // 以只读的方式打开暂存区中名为 staging_name 的数据，metadata 为数据块的
+    // 版本与压缩信息。读取期间暂存数据需保持活跃
+    google::protobuf::util::StatusOr<std::shared_ptr<FileChunkReader>>
+    OpenStagedChunkReader(const std::string& staging_name,
+                          const protos::FileChunk& metadata);
+
+    // 暂存流式复制收到的数据块
+    ChunkReplicaStager* GetChunkReplicaStager();
+
+    // 文件 I/O 后端
+    ChunkIoBackend* GetChunkIoBackend();
+
+    // 数据块读缓存
+    ChunkBlockCache* GetChunkBlockCache();
+
+    // 是否开启了 O_DIRECT 模式
+    bool IsDirectIo() const;
+
+    // 所有数据目录所在磁盘的剩余空间之和（MB），同一文件系统只计算一次
+    uint32_t GetAvailableDiskMb() const;
+
+    // 数据目录数量
+    size_t GetDiskNums() const;
+
+    // 数据块所在的数据目录，数据块不存在时返回空字符串
+    std::string GetChunkDataDir(const std::string& chunk_handle);
+
+    // 数据目录对应的 I/O 队列
+    DiskIoQueue* GetDiskIoQueue(const size_t& disk_index);
+
    private:
-    FileChunkManager() = default;
+    // 一块磁盘：数据目录中的数据库以及它的 I/O 队列
+    struct ChunkDisk {
+        std::string data_dir;
+
+        // O_DIRECT 模式下数据块文件所在的目录
+        std::string chunk_dir;
+
+        // chunk database
+        std::unique_ptr<leveldb::DB> db;
+
+        std::unique_ptr<DiskIoQueue> io_queue;
+
+        // 磁盘上的数据块数量，用于选择新数据块的位置
+        std::atomic<uint64_t> chunk_nums{0};
+    };
+
+    // 注册数据块读写与读缓存的指标
+    FileChunkManager();
+
+    // 关闭所有磁盘的 I/O 队列与数据库
+    void CloseDisks();
+
+    // 数据块所在的磁盘，不存在时返回 nullptr
+    ChunkDisk* FindChunkDisk(const std::string& chunk_handle);
+
+    // 数据块所在的磁盘，不存在时为新的数据块选择数据块最少的磁盘，
+    // placed 表示是否为新的数据块选择了位置
+    ChunkDisk* PlaceChunk(const std::string& chunk_handle, bool* placed);
+
+    // 以下方法直接访问数据库与数据块文件，需在磁盘的 I/O 线程中调用
+    // read_data 为 false 时 O_DIRECT 模式下不读取数据块文件，只返回版本号
+    // 与长度
+    google::protobuf::util::StatusOr<std::shared_ptr<protos::FileChunk>>
+    GetFileChunkFromDisk(ChunkDisk* disk, const std::string& chunk_handle,
+                         const uint32_t* version, const bool& read_data = true);
+
+    leveldb::Status PutFileChunkToDisk(ChunkDisk* disk,
+                                       const std::string& chunk_handle,
+                                       const protos::FileChunk& chunk);
+
+    // 数据块的数据长度，压缩的数据块为压缩前的长度
+    uint64_t GetChunkSize(const protos::FileChunk& chunk) const;
+
+    // 数据块在数据库或数据块文件中保存的长度
+    uint64_t GetStoredSize(const protos::FileChunk& chunk) const;
+
+    // 读取压缩的数据块 [offset, offset + length) 范围内的数据，只读取并
+    // 解压覆盖该范围的分块
+    google::protobuf::util::StatusOr<std::string> ReadCompressedChunk(
+        ChunkDisk* disk, const std::string& chunk_handle,
+        const protos::FileChunk& chunk, const uint64_t& offset,
+        const uint64_t& length);
+
+    // 将 data 写入压缩的数据块 offset 处，重新压缩修改的分块并追加到压缩
+    // 数据的末尾（位于末尾的分块原地覆盖），其他分块不读取也不移动，
+    // 并更新 chunk 中的分块信息与长度。调用方随后将 chunk 写入数据库
+    google::protobuf::util::Status WriteCompressedChunk(
+        ChunkDisk* disk, const std::string& chunk_handle,
+        protos::FileChunk* chunk, const uint64_t& offset, const char* data,
+        const uint64_t& length);
+
+    // 按分块顺序重新拼接压缩数据，去掉被修改的分块留下的空洞
+    google::protobuf::util::Status CompactCompressedChunk(
+        ChunkDisk* disk, const std::string& chunk_handle,
+        protos::FileChunk* chunk);
+
+    std::string GetChunkFilePath(ChunkDisk* disk,
+                                 const std::string& chunk_handle) const;
+
+    // 读取数据块文件 [offset, offset + length) 范围内的数据，size 为数据块
+    // 的长度，不经过读缓存
+    google::protobuf::util::StatusOr<std::string> ReadChunkFile(
+        ChunkDisk* disk, const std::string& chunk_handle, const uint64_t& size,
+        const uint64_t& offset, const uint64_t& length);
+
+    // 同 ReadChunkFile，从已经打开的数据块文件 fd 中读取
+    google::protobuf::util::StatusOr<std::string> ReadChunkFile(
+        const int& fd, const std::string& chunk_handle, const uint64_t& size,
+        const uint64_t& offset, const uint64_t& length);
+
+    // 将 data 写入数据块文件 offset 处，size 为数据块原来的长度，首尾不完整
+    // 的页先读出原有数据再整页写入。truncate 为 true 时丢弃写入范围之后的
+    // 数据。写入后需调用 InvalidateBlocks
+    google::protobuf::util::Status WriteChunkFile(
+        ChunkDisk* disk, const std::string& chunk_handle, const uint64_t& size,
+        const uint64_t& offset, const char* data, const uint64_t& length,
+        const bool& truncate);
+
+    // 在磁盘的 I/O 线程中读取 lookups 中 indexes 对应的分块，first_block
+    // 为 lookups[0] 的分块序号，连续的分块合并为一次读取。位于数据块末尾
+    // 之后的分块 data 为 nullptr
+    google::protobuf::util::Status LoadChunkBlocks(
+        ChunkDisk* disk, const std::string& chunk_handle,
+        const uint32_t& version, const uint64_t& first_block,
+        const std::vector<size_t>& indexes,
+        std::vector<ChunkBlockCache::BlockLookup>* lookups);
+
+    // 数据块的版本号与长度写入数据库后，使写入范围内的缓存分块失效
+    void InvalidateBlocks(const std::string& chunk_handle,
+                          const uint64_t& offset, const uint64_t& length);
 
     // <chunk_handle, version>
     dfs::common::parallel_hash_map<std::string, uint32_t> chunk_versions_;
 
-    // chunk database
-    std::unique_ptr<leveldb::DB> chunk_db_;
+    // <chunk_handle, disk index>
+    dfs::common::parallel_hash_map<std::string, size_t> chunk_disks_;
+
+    // 选择新数据块位置时加锁，避免同一个数据块放到两块磁盘上
+    absl::Mutex placement_lock_;
+
+    // 每个数据目录一块磁盘
+    std::vector<std::unique_ptr<ChunkDisk>> disks_;
 
     // max bytes per chunk
     uint32_t max_bytes_per_chunk_;
+
+    // 文件 I/O 后端，io_uring 或线程池
+    std::unique_ptr<ChunkIoBackend> io_backend_;
+
+    // 数据块的数据是否保存在数据块文件中
+    bool direct_io_ = false;
+
+    // 读缓存中每个分块的大小，也是新的压缩数据块的分块大小
+    uint64_t cache_block_size_ = 0;
+
+    // zstd 的压缩级别
+    int compression_level_ = 0;
+
+    // 数据块读缓存
+    std::unique_ptr<ChunkBlockCache> block_cache_;
+
+    // 流式复制的暂存区，位于数据库目录旁
+    std::unique_ptr<ChunkReplicaStager> replica_stager_;
+
+    // 数据块读写的延迟与字节数
+    common::Histogram* read_latency_;
+
+    common::Histogram* write_latency_;
+
+    common::Counter* read_bytes_;
+
+    common::Counter* write_bytes_;
 };
 
 }  // namespace server
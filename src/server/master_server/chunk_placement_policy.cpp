@@ -0,0 +1,290 @@
+#include "src/server/master_server/chunk_placement_policy.h"
+
+#include <algorithm>
+
+namespace dfs {
+namespace server {
+
+using protos::ChunkServerLocation;
+
+namespace {
+
+// 随机抽样的最大尝试次数，超过后退化为遍历所有块服务器
+const int kMaxSampleAttempts = 8;
+
+// 一次尚未完成的数据块写入（分配或副本复制）相当于多少次写请求
+const double kPendingWriteWeight = 8.0;
+
+std::string ToServerAddress(const ChunkServerLocation& location) {
+    return location.server_hostname() + ":" +
+           std::to_string(location.server_port());
+}
+
+}  // namespace
+
+void ChunkPlacementPolicy::ChosenDomains::Add(
+    const std::string& server_address, const FailureDomain& domain) {
+    racks.insert(domain.rack);
+    hosts.insert(domain.host);
+    servers.insert(server_address);
+}
+
+ChunkPlacementPolicy::ChunkPlacementPolicy(uint32_t min_available_disk_mb,
+                                           uint64_t seed)
+    : min_available_disk_mb_(min_available_disk_mb), random_engine_(seed) {}
+
+void ChunkPlacementPolicy::AddServer(const protos::ChunkServer& chunk_server,
+                                     const FailureDomain& domain) {
+    absl::MutexLock lock_guard(&lock_);
+    const std::string server_address = ToServerAddress(chunk_server.location());
+
+    auto iter = server_indexes_.find(server_address);
+    if (iter == server_indexes_.end()) {
+        iter = server_indexes_.emplace(server_address, servers_.size()).first;
+        servers_.emplace_back();
+    } else {
+        RemoveDomain(servers_[iter->second].domain);
+    }
+
+    auto& server = servers_[iter->second];
+    server.location = chunk_server.location();
+    server.server_address = server_address;
+    server.domain = domain;
+    AddDomain(domain);
+    server.available_disk_mb = chunk_server.available_disk_mb();
+    server.has_reported = chunk_server.has_load();
+    server.load = chunk_server.load();
+}
+
+void ChunkPlacementPolicy::RemoveServer(const ChunkServerLocation& location) {
+    absl::MutexLock lock_guard(&lock_);
+    auto iter = server_indexes_.find(ToServerAddress(location));
+    if (iter == server_indexes_.end()) {
+        return;
+    }
+
+    // 与最后一个元素交换后删除，保持数组紧凑
+    const size_t index = iter->second;
+    server_indexes_.erase(iter);
+    RemoveDomain(servers_[index].domain);
+    if (index != servers_.size() - 1) {
+        servers_[index] = std::move(servers_.back());
+        server_indexes_[servers_[index].server_address] = index;
+    }
+    servers_.pop_back();
+}
+
+void ChunkPlacementPolicy::UpdateServerLoad(
+    const ChunkServerLocation& location, uint32_t available_disk_mb,
+    const protos::ChunkServerLoad& load) {
+    absl::MutexLock lock_guard(&lock_);
+    auto server = FindServer(location);
+    if (!server) {
+        return;
+    }
+
+    server->available_disk_mb = available_disk_mb;
+    server->has_reported = true;
+    server->load = load;
+    // 汇报中的写负载已经部分体现了之前分配的数据块，逐步衰减
+    server->recent_assignments /= 2;
+}
+
+void ChunkPlacementPolicy::BeginReplication(
+    const ChunkServerLocation& location) {
+    absl::MutexLock lock_guard(&lock_);
+    auto server = FindServer(location);
+    if (server) {
+        server->inflight_replications++;
+    }
+}
+
+void ChunkPlacementPolicy::EndReplication(const ChunkServerLocation& location) {
+    absl::MutexLock lock_guard(&lock_);
+    auto server = FindServer(location);
+    if (server && server->inflight_replications > 0) {
+        server->inflight_replications--;
+    }
+}
+
+std::vector<ChunkServerLocation> ChunkPlacementPolicy::ChooseServers(
+    size_t server_nums,
+    const std::vector<ChunkServerLocation>& existing_locations,
+    bool distinct_racks) {
+    absl::MutexLock lock_guard(&lock_);
+    std::vector<ChunkServerLocation> chosen_locations;
+
+    ChosenDomains chosen;
+    for (const auto& location : existing_locations) {
+        auto server = FindServer(location);
+        if (server) {
+            chosen.Add(server->server_address, server->domain);
+        } else {
+            // 未知的块服务器，至少避免选中同一主机
+            chosen.Add(ToServerAddress(location),
+                       FailureDomain{"", location.server_hostname()});
+        }
+    }
+
+    while (chosen_locations.size() < server_nums) {
+        // 只尝试还能满足的约束
+        std::vector<DomainConstraint> constraints;
+        if (distinct_racks) {
+            constraints.push_back(DomainConstraint::DISTINCT_RACK);
+        } else {
+            if (HasUnusedDomain(rack_counts_, chosen.racks)) {
+                constraints.push_back(DomainConstraint::DISTINCT_RACK);
+            }
+            if (HasUnusedDomain(host_counts_, chosen.hosts)) {
+                constraints.push_back(DomainConstraint::DISTINCT_HOST);
+            }
+            constraints.push_back(DomainConstraint::DISTINCT_SERVER);
+        }
+
+        int64_t index = -1;
+        for (const auto constraint : constraints) {
+            index = PickServer(constraint, chosen);
+            if (index >= 0) {
+                break;
+            }
+        }
+
+        if (index < 0) {
+            // 没有更多可用的块服务器
+            break;
+        }
+
+        auto& server = servers_[index];
+        server.recent_assignments++;
+        chosen.Add(server.server_address, server.domain);
+        chosen_locations.push_back(server.location);
+    }
+
+    return chosen_locations;
+}
+
+size_t ChunkPlacementPolicy::size() {
+    absl::MutexLock lock_guard(&lock_);
+    return servers_.size();
+}
+
+bool ChunkPlacementPolicy::IsEligible(const ServerState& server,
+                                      DomainConstraint constraint,
+                                      const ChosenDomains& chosen) const {
+    if (chosen.servers.contains(server.server_address)) {
+        return false;
+    }
+
+    if (server.has_reported &&
+        server.available_disk_mb < min_available_disk_mb_) {
+        return false;
+    }
+
+    switch (constraint) {
+        case DomainConstraint::DISTINCT_RACK:
+            return !chosen.racks.contains(server.domain.rack) &&
+                   !chosen.hosts.contains(server.domain.host);
+        case DomainConstraint::DISTINCT_HOST:
+            return !chosen.hosts.contains(server.domain.host);
+        case DomainConstraint::DISTINCT_SERVER:
+            return true;
+    }
+
+    return true;
+}
+
+double ChunkPlacementPolicy::Score(const ServerState& server) const {
+    const double load =
+        1.0 + server.load.write_iops() + server.load.queue_depth() +
+        kPendingWriteWeight *
+            (server.recent_assignments + server.inflight_replications);
+    return (server.available_disk_mb + 1.0) / load;
+}
+
+int64_t ChunkPlacementPolicy::PickServer(DomainConstraint constraint,
+                                         const ChosenDomains& chosen) {
+    if (servers_.empty()) {
+        return -1;
+    }
+
+    std::uniform_int_distribution<size_t> distribution(0, servers_.size() - 1);
+    std::vector<size_t> candidates;
+
+    // 随机抽取两个满足约束的块服务器
+    for (int i = 0; i < kMaxSampleAttempts && candidates.size() < 2; i++) {
+        const size_t index = distribution(random_engine_);
+        if (IsEligible(servers_[index], constraint, chosen) &&
+            (candidates.empty() || candidates[0] != index)) {
+            candidates.push_back(index);
+        }
+    }
+
+    // 满足约束的块服务器较少，抽样难以命中，遍历后再从中抽取
+    if (candidates.size() < 2) {
+        std::vector<size_t> eligible_indexes;
+        for (size_t index = 0; index < servers_.size(); index++) {
+            if (IsEligible(servers_[index], constraint, chosen)) {
+                eligible_indexes.push_back(index);
+            }
+        }
+
+        if (eligible_indexes.empty()) {
+            return -1;
+        }
+
+        std::shuffle(eligible_indexes.begin(), eligible_indexes.end(),
+                     random_engine_);
+        eligible_indexes.resize(std::min<size_t>(eligible_indexes.size(), 2));
+        candidates = eligible_indexes;
+    }
+
+    if (candidates.size() == 1 ||
+        Score(servers_[candidates[0]]) >= Score(servers_[candidates[1]])) {
+        return candidates[0];
+    }
+    return candidates[1];
+}
+
+bool ChunkPlacementPolicy::HasUnusedDomain(
+    const absl::flat_hash_map<std::string, uint32_t>& domain_counts,
+    const absl::flat_hash_set<std::string>& used_domains) {
+    if (domain_counts.size() < 2) {
+        // 只有一个机架（主机）时该层约束没有意义
+        return false;
+    }
+    if (domain_counts.size() > used_domains.size()) {
+        return true;
+    }
+    for (const auto& domain_pair : domain_counts) {
+        if (!used_domains.contains(domain_pair.first)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ChunkPlacementPolicy::AddDomain(const FailureDomain& domain) {
+    rack_counts_[domain.rack]++;
+    host_counts_[domain.host]++;
+}
+
+void ChunkPlacementPolicy::RemoveDomain(const FailureDomain& domain) {
+    if (--rack_counts_[domain.rack] == 0) {
+        rack_counts_.erase(domain.rack);
+    }
+    if (--host_counts_[domain.host] == 0) {
+        host_counts_.erase(domain.host);
+    }
+}
+
+ChunkPlacementPolicy::ServerState* ChunkPlacementPolicy::FindServer(
+    const ChunkServerLocation& location) {
+    auto iter = server_indexes_.find(ToServerAddress(location));
+    if (iter == server_indexes_.end()) {
+        return nullptr;
+    }
+    return &servers_[iter->second];
+}
+
+}  // namespace server
+}  // namespace dfs
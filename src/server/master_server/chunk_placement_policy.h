@@ -0,0 +1,138 @@
+#ifndef DFS_SERVER_MASTER_SERVER_CHUNK_PLACEMENT_POLICY_H
+#define DFS_SERVER_MASTER_SERVER_CHUNK_PLACEMENT_POLICY_H
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+#include <absl/synchronization/mutex.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "chunk_server.pb.h"
+
+namespace dfs {
+namespace server {
+
+// 块服务器所在的故障域
+struct FailureDomain {
+    std::string rack;
+    std::string host;
+};
+
+/**
+ * 数据块放置策略
+ * 1. 按照剩余空间、最近的写负载以及正在进行的副本复制为块服务器打分
+ * 2. 每个副本随机抽取两个候选块服务器，选择得分较高的一个（power of two
+ *    choices），单次决策的代价与块服务器数量无关
+ * 3. 副本优先分布在不同机架，其次是不同主机，最后才允许落在同一主机。
+ *    所有机架（主机）都已经有副本时跳过该层约束，例如没有配置机架时，
+ *    避免每次抽样都落空后退化为遍历
+ */
+class ChunkPlacementPolicy {
+   public:
+    // min_available_disk_mb: 剩余空间低于该值的块服务器不会被选中
+    explicit ChunkPlacementPolicy(uint32_t min_available_disk_mb,
+                                  uint64_t seed = std::random_device{}());
+
+    // 添加块服务器，已存在时更新其故障域与负载
+    void AddServer(const protos::ChunkServer& chunk_server,
+                   const FailureDomain& domain);
+
+    void RemoveServer(const protos::ChunkServerLocation& location);
+
+    // 块服务器汇报时更新其剩余空间与负载
+    void UpdateServerLoad(const protos::ChunkServerLocation& location,
+                          uint32_t available_disk_mb,
+                          const protos::ChunkServerLoad& load);
+
+    // 记录正在进行的副本复制
+    void BeginReplication(const protos::ChunkServerLocation& location);
+
+    void EndReplication(const protos::ChunkServerLocation& location);
+
+    // 为数据块选择 server_nums 个新的块服务器
+    // existing_locations 为已经存放了副本的块服务器，不会被重复选中，并参与故障域的计算
+    // distinct_racks 为 true 时不放宽机架约束，选中的块服务器与
+    // existing_locations 都位于不同的机架，机架不足时返回的数量少于 server_nums
+    std::vector<protos::ChunkServerLocation> ChooseServers(
+        size_t server_nums,
+        const std::vector<protos::ChunkServerLocation>& existing_locations,
+        bool distinct_racks = false);
+
+    size_t size();
+
+   private:
+    struct ServerState {
+        protos::ChunkServerLocation location;
+        std::string server_address;
+        FailureDomain domain;
+        uint32_t available_disk_mb = 0;
+        // 是否收到过块服务器汇报的负载
+        bool has_reported = false;
+        protos::ChunkServerLoad load;
+        // 自上一次汇报以来分配到的数据块数量，汇报中的负载尚未体现
+        uint32_t recent_assignments = 0;
+        uint32_t inflight_replications = 0;
+    };
+
+    // 已经选中的块服务器所占用的故障域
+    struct ChosenDomains {
+        absl::flat_hash_set<std::string> racks;
+        absl::flat_hash_set<std::string> hosts;
+        absl::flat_hash_set<std::string> servers;
+
+        void Add(const std::string& server_address,
+                 const FailureDomain& domain);
+    };
+
+    // 故障域约束，选不到块服务器时逐级放宽
+    enum class DomainConstraint {
+        DISTINCT_RACK,
+        DISTINCT_HOST,
+        DISTINCT_SERVER,
+    };
+
+    bool IsEligible(const ServerState& server, DomainConstraint constraint,
+                    const ChosenDomains& chosen) const;
+
+    // 剩余空间越多、负载越低，得分越高
+    double Score(const ServerState& server) const;
+
+    // 从满足约束的块服务器中选择一个，没有时返回 -1，调用者需持有 lock_
+    int64_t PickServer(DomainConstraint constraint,
+                       const ChosenDomains& chosen);
+
+    ServerState* FindServer(const protos::ChunkServerLocation& location);
+
+    // 是否还有未被选中的机架（主机），调用者需持有 lock_
+    static bool HasUnusedDomain(
+        const absl::flat_hash_map<std::string, uint32_t>& domain_counts,
+        const absl::flat_hash_set<std::string>& used_domains);
+
+    // 故障域的块服务器计数，调用者需持有 lock_
+    void AddDomain(const FailureDomain& domain);
+
+    void RemoveDomain(const FailureDomain& domain);
+
+    uint32_t min_available_disk_mb_;
+
+    absl::Mutex lock_;
+
+    // 使用数组存放，以便 O(1) 随机抽样
+    std::vector<ServerState> servers_;
+
+    // map<server_address, index in servers_>
+    absl::flat_hash_map<std::string, size_t> server_indexes_;
+
+    // map<rack, server nums>, map<host, server nums>
+    absl::flat_hash_map<std::string, uint32_t> rack_counts_;
+    absl::flat_hash_map<std::string, uint32_t> host_counts_;
+
+    std::mt19937_64 random_engine_;
+};
+
+}  // namespace server
+}  // namespace dfs
+
+#endif  // DFS_SERVER_MASTER_SERVER_CHUNK_PLACEMENT_POLICY_H
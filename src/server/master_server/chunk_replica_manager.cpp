@@ -1,16 +1,27 @@
 #include "src/server/master_server/chunk_replica_manager.h"
 
+#include <absl/time/clock.h>
+
+#include <algorithm>
+
+#include "src/common/config_manager.h"
 #include "src/common/system_logger.h"
+#include "src/common/utils.h"
+#include "src/server/master_server/erasure_coding_manager.h"
+#include "src/server/master_server/metadata_manager.h"
 
 namespace dfs {
 namespace server {
 
+using dfs::common::ConfigManager;
+using dfs::common::TokenBucket;
+using protos::ChunkServerLocation;
 using protos::grpc::ChunkReplicaCopyRequest;
 using protos::grpc::ChunkReplicaCopyRespond;
 
 ChunkReplicaManager::ChunkReplicaManager() {
     chunk_server_manager_ = ChunkServerManager::GetInstance();
-    metadata_manager_ = MetadataManager::GetInstance();
+    LoadConfig();
 }
 
 ChunkReplicaManager* ChunkReplicaManager::GetInstance() {
@@ -18,105 +29,489 @@ ChunkReplicaManager* ChunkReplicaManager::GetInstance() {
     return instance;
 }
 
-void ChunkReplicaManager::AddChunkReplicaTask(const std::string& chunk_handle) {
-    absl::WriterMutexLock chunk_replica_queues_lock_guard(
-        &chunk_replica_queues_lock_);
-    chunk_replica_queues_.push(chunk_handle);
-    cond_var_.Signal();
+void ChunkReplicaManager::LoadConfig() {
+    auto config_manager = ConfigManager::GetInstance();
+    replica_nums_ = config_manager->GetChunkReplicaNums();
+    max_concurrent_copies_ = std::max<uint32_t>(
+        config_manager->GetReplicationMaxConcurrentCopies(), 1);
+    max_copies_per_source_ = std::max<uint32_t>(
+        config_manager->GetReplicationMaxCopiesPerSource(), 1);
+    max_copies_per_destination_ = std::max<uint32_t>(
+        config_manager->GetReplicationMaxCopiesPerDestination(), 1);
+    chunk_size_bytes_ = static_cast<uint64_t>(config_manager->GetBlockSize()) *
+                        dfs::common::bytesMB;
+    scan_interval_ =
+        absl::Milliseconds(config_manager->GetReplicationScanIntervalMs());
+
+    // 允许突发一个数据块的复制
+    const uint64_t bandwidth_bytes =
+        static_cast<uint64_t>(config_manager->GetReplicationBandwidthMB()) *
+        dfs::common::bytesMB;
+    bandwidth_limiter_ = std::make_unique<TokenBucket>(
+        bandwidth_bytes, std::max(bandwidth_bytes, chunk_size_bytes_));
+
+    cold_file_age_ =
+        absl::Seconds(config_manager->GetErasureCodingColdFileSeconds());
+    transcode_scan_interval_ = absl::Milliseconds(
+        config_manager->GetErasureCodingTranscodeScanIntervalMs());
+    max_transcode_files_per_scan_ = std::max<uint32_t>(
+        config_manager->GetErasureCodingTranscodeMaxFilesPerScan(), 1);
+    max_transcode_client_iops_ =
+        config_manager->GetErasureCodingTranscodeMaxClientIops();
+    const uint64_t transcode_bandwidth_bytes =
+        static_cast<uint64_t>(
+            config_manager->GetErasureCodingTranscodeBandwidthMB()) *
+        dfs::common::bytesMB;
+    transcode_limiter_ = std::make_unique<TokenBucket>(
+        transcode_bandwidth_bytes,
+        std::max(transcode_bandwidth_bytes, chunk_size_bytes_));
+}
+
+void ChunkReplicaManager::AddChunkReplicaTask(
+    const std::string& chunk_handle, const uint32_t& live_replica_nums) {
+    absl::MutexLock lock_guard(&lock_);
+    // 正在复制的数据块在复制结束后会重新检查副本数量
+    if (running_chunks_.contains(chunk_handle)) {
+        return;
+    }
+
+    if (chunk_replica_queue_.Push(chunk_handle, live_replica_nums)) {
+        task_cond_var_.Signal();
+    }
 }
 
 void ChunkReplicaManager::StartChunkReplicaCopyTask() {
-    thread_ptr_ = std::make_unique<std::thread>(std::thread([&]() {
+    LOG(INFO) << "ChunkReplicaCopyTask is start, replica nums: "
+              << replica_nums_ << ", concurrent copies: "
+              << max_concurrent_copies_ << ", per source: "
+              << max_copies_per_source_
+              << ", per destination: " << max_copies_per_destination_;
+
+    for (uint32_t i = 0; i < max_concurrent_copies_; i++) {
+        copy_threads_.push_back(std::make_unique<std::thread>(
+            std::thread([&]() { RunCopyWorker(); })));
+    }
+
+    // 副本探测
+    replica_check_thread_ = std::make_unique<std::thread>(std::thread([&]() {
         while (!stop_chunk_replica_copy_task_.load()) {
-            // TODO: 执行副本复制任务
+            // 探测副本数量，然后执行复制任务
+            ScanUnderReplicatedChunks();
 
-            chunk_replica_queues_lock_.Lock();
-            while (chunk_replica_queues_.empty()) {
-                cond_var_.Wait(&chunk_replica_queues_lock_);
+            absl::MutexLock lock_guard(&lock_);
+            stop_cond_var_.WaitWithTimeout(&lock_, scan_interval_);
+        }
+    }));
+
+    // 冷文件转换
+    if (cold_file_age_ > absl::ZeroDuration()) {
+        LOG(INFO) << "TranscodeTask is start, cold file age: "
+                  << cold_file_age_;
+        transcode_thread_ = std::make_unique<std::thread>(std::thread([&]() {
+            while (!stop_chunk_replica_copy_task_.load()) {
+                {
+                    absl::MutexLock lock_guard(&lock_);
+                    stop_cond_var_.WaitWithTimeout(&lock_,
+                                                   transcode_scan_interval_);
+                }
+                TranscodeColdFiles();
             }
+        }));
+    }
+}
 
-            // 条件变量中重新赋予了锁
-            const std::string chunk_handle = chunk_replica_queues_.front();
-            chunk_replica_queues_.pop();
-            // 解锁，以便继续添加任务
-            chunk_replica_queues_lock_.Unlock();
+void ChunkReplicaManager::StopChunkReplicaCopyTask() {
+    {
+        absl::MutexLock lock_guard(&lock_);
+        stop_chunk_replica_copy_task_.store(true);
+        task_cond_var_.SignalAll();
+        stop_cond_var_.SignalAll();
+    }
 
-            LOG(INFO) << "start to copy chunk handle " << chunk_handle;
+    for (auto& copy_thread : copy_threads_) {
+        copy_thread->join();
+    }
+    replica_check_thread_->join();
+    if (transcode_thread_) {
+        transcode_thread_->join();
+    }
+}
 
-            // TODO: use config
-            if (chunk_server_manager_->GetChunkLocationSize(chunk_handle) >=
-                3) {
-                continue;
-            }
+ChunkReplicaManager::ReplicationStats
+ChunkReplicaManager::GetReplicationStats() {
+    absl::MutexLock lock_guard(&lock_);
+    ReplicationStats stats = stats_;
+    stats.queued_chunks = chunk_replica_queue_.size();
+    stats.running_chunks = running_chunks_.size();
+    stats.deferred_chunks = deferred_chunks_.size();
+    stats.lost_chunks = lost_chunks_.size();
+    return stats;
+}
 
-            // 副本数量小于健康值
-            auto locations =
-                chunk_server_manager_->AssignChunkServerToCopyReplica(
-                    chunk_handle, 3);
-            if (locations.empty()) {
-                LOG(INFO) << "no more chunk server to copy " << chunk_handle
-                          << " replica";
-                continue;
+void ChunkReplicaManager::RunCopyWorker() {
+    while (true) {
+        std::string chunk_handle;
+        uint32_t live_replica_nums = 0;
+        {
+            absl::MutexLock lock_guard(&lock_);
+            while (!stop_chunk_replica_copy_task_.load() &&
+                   chunk_replica_queue_.empty()) {
+                task_cond_var_.Wait(&lock_);
             }
 
-            // 向数据块主副本服务器发出数据块复制请求，让主副本服务器将数据块复制到块服务器上
-            auto metadata_or =
-                metadata_manager_->GetFileChunkMetadata(chunk_handle);
-            if (!metadata_or.ok()) {
-                LOG(ERROR) << "ChunkReplicaCopyTask, can not get chunk "
-                              "metadata, because "
-                           << metadata_or.status().ToString();
-                continue;
+            if (stop_chunk_replica_copy_task_.load()) {
+                return;
             }
 
-            const std::string primary_server_address =
-                metadata_or.value().primary_location().server_hostname() + ":" +
-                std::to_string(
-                    metadata_or.value().primary_location().server_port());
-            auto primary_client =
-                chunk_server_manager_->GetOrCreateChunkServerFileServiceClient(
-                    primary_server_address);
-            if (!primary_client) {
-                LOG(ERROR) << "can not get or create primary server file "
-                              "service client";
-                continue;
-            }
+            chunk_replica_queue_.Pop(&chunk_handle, &live_replica_nums);
+            running_chunks_.insert(chunk_handle);
+        }
+
+        uint32_t copied_nums = 0;
+        const CopyResult result = RunCopyTask(chunk_handle, &copied_nums);
+
+        absl::MutexLock lock_guard(&lock_);
+        running_chunks_.erase(chunk_handle);
+
+        switch (result) {
+            case CopyResult::COPIED:
+                // 可能仍未达到副本数量，重新入队检查
+                chunk_replica_queue_.Push(chunk_handle,
+                                          live_replica_nums + copied_nums);
+                break;
+            case CopyResult::DEFERRED:
+                deferred_chunks_.emplace_back(chunk_handle, live_replica_nums);
+                break;
+            case CopyResult::LOST:
+                lost_chunks_.insert(chunk_handle);
+                break;
+            default:
+                // 失败的任务由副本探测线程稍后重新添加
+                break;
+        }
 
-            ChunkReplicaCopyRequest copy_req;
-            copy_req.set_chunk_handle(chunk_handle);
-            for (auto location : locations) {
-                *copy_req.add_locations() = location;
+        // 有并发名额被释放，延后的任务重新入队
+        if (result != CopyResult::DEFERRED) {
+            for (const auto& chunk_pair : deferred_chunks_) {
+                chunk_replica_queue_.Push(chunk_pair.first, chunk_pair.second);
             }
+            deferred_chunks_.clear();
+        }
+        task_cond_var_.SignalAll();
+    }
+}
+
+void ChunkReplicaManager::ScanUnderReplicatedChunks() {
+    auto chunks =
+        chunk_server_manager_->GetUnderReplicatedChunks(replica_nums_);
+    // 纠删码文件的分片只需要一份
+    auto metadata_manager = MetadataManager::GetInstance();
+    chunks.erase(
+        std::remove_if(chunks.begin(), chunks.end(),
+                       [&](const std::pair<std::string, uint32_t>& chunk_pair) {
+                           return chunk_pair.second > 0 &&
+                                  metadata_manager->IsErasureCodedChunk(
+                                      chunk_pair.first);
+                       }),
+        chunks.end());
+    for (const auto& chunk_pair : chunks) {
+        AddChunkReplicaTask(chunk_pair.first, chunk_pair.second);
+    }
+
+    auto stats = GetReplicationStats();
+    if (!chunks.empty() || stats.running_chunks > 0) {
+        LOG(INFO) << "ReplicaCheckTask: " << chunks.size()
+                  << " chunks need to copy, queued: " << stats.queued_chunks
+                  << ", running: " << stats.running_chunks
+                  << ", deferred: " << stats.deferred_chunks
+                  << ", completed copies: " << stats.completed_copies
+                  << ", failed copies: " << stats.failed_copies
+                  << ", copied: " << stats.copied_bytes / dfs::common::bytesMB
+                  << "MB, lost chunks: " << stats.lost_chunks
+                  << ", reconstructed chunks: " << stats.reconstructed_chunks
+                  << ", transcoded files: " << stats.transcoded_files;
+    }
+}
+
+void ChunkReplicaManager::TranscodeColdFiles() {
+    auto metadata_manager = MetadataManager::GetInstance();
+    auto erasure_coding_manager = ErasureCodingManager::GetInstance();
+
+    // 每个分片需要一个不同的块服务器（机架），不足时转换必然失败
+    const uint32_t stripe_shards = erasure_coding_manager->data_shards() +
+                                   erasure_coding_manager->parity_shards();
+    const auto locations = chunk_server_manager_->GetAllChunkServerLocations();
+    size_t domain_nums = locations.size();
+    if (erasure_coding_manager->distinct_racks()) {
+        absl::flat_hash_set<std::string> racks;
+        for (const auto& location : locations) {
+            racks.insert(chunk_server_manager_->GetChunkServerRack(location));
+        }
+        domain_nums = racks.size();
+    }
+    if (domain_nums < stripe_shards) {
+        if (!transcode_skip_logged_) {
+            LOG(WARNING) << "TranscodeTask: skip, a stripe needs "
+                         << stripe_shards << " distinct chunk servers"
+                         << (erasure_coding_manager->distinct_racks()
+                                 ? " (racks)"
+                                 : "")
+                         << ", only " << domain_nums << " available";
+            transcode_skip_logged_ = true;
+        }
+        return;
+    }
+    transcode_skip_logged_ = false;
+
+    const absl::Time cold_before = absl::Now() - cold_file_age_;
+    const auto filenames = metadata_manager->GetColdFiles(
+        cold_before, max_transcode_files_per_scan_);
+
+    for (const auto& filename : filenames) {
+        if (stop_chunk_replica_copy_task_.load() || ShouldPauseTranscode()) {
+            break;
+        }
+
+        auto file_metadata_or = metadata_manager->GetFileMetadata(filename);
+        if (!file_metadata_or.ok()) {
+            continue;
+        }
+
+        // 读取全部数据块，写入每个条带的校验块
+        const uint64_t chunk_nums =
+            file_metadata_or.value()->chunk_handles_size();
+        const uint64_t data_shards = erasure_coding_manager->data_shards();
+        const uint64_t parity_nums =
+            (chunk_nums + data_shards - 1) / data_shards *
+            erasure_coding_manager->parity_shards();
+        transcode_limiter_->Acquire(chunk_size_bytes_ *
+                                    (chunk_nums + parity_nums));
+
+        // 等待带宽期间文件可能被访问
+        auto access_time_or = metadata_manager->GetFileAccessTime(filename);
+        if (!access_time_or.ok() || access_time_or.value() >= cold_before) {
+            continue;
+        }
+
+        LOG(INFO) << "TranscodeTask: convert cold file " << filename << " with "
+                  << chunk_nums << " chunks to erasure coded";
+        auto status = erasure_coding_manager->ConvertToErasureCoded(filename);
 
-            auto respond = primary_client->SendRequest(copy_req);
-            if (respond.ok()) {
-                LOG(INFO) << "copy right";
+        absl::MutexLock lock_guard(&lock_);
+        if (status.ok()) {
+            stats_.transcoded_files++;
+        } else {
+            // 有未过期的写租约时下一次再转换
+            LOG(WARNING) << "TranscodeTask: convert " << filename
+                         << " failed, because " << status.ToString();
+            stats_.transcode_failed_files++;
+        }
+    }
+}
+
+bool ChunkReplicaManager::ShouldPauseTranscode() {
+    {
+        // 副本复制与重建优先
+        absl::MutexLock lock_guard(&lock_);
+        if (!chunk_replica_queue_.empty() || !running_chunks_.empty() ||
+            !deferred_chunks_.empty()) {
+            LOG(INFO) << "TranscodeTask: pause, replica copy is running";
+            return true;
+        }
+    }
+
+    if (max_transcode_client_iops_ > 0) {
+        const uint64_t iops = chunk_server_manager_->GetTotalClientIops();
+        if (iops > max_transcode_client_iops_) {
+            LOG(INFO) << "TranscodeTask: pause, client iops " << iops
+                      << " exceeds " << max_transcode_client_iops_;
+            return true;
+        }
+    }
+    return false;
+}
+
+ChunkReplicaManager::CopyResult ChunkReplicaManager::RunCopyTask(
+    const std::string& chunk_handle, uint32_t* copied_nums) {
+    auto locations = chunk_server_manager_->GetChunkLocation(chunk_handle);
+    if (!locations.empty()) {
+        // 丢失副本的块服务器可能重新上线
+        absl::MutexLock lock_guard(&lock_);
+        lost_chunks_.erase(chunk_handle);
+    }
+
+    if (MetadataManager::GetInstance()->IsErasureCodedChunk(chunk_handle)) {
+        if (!locations.empty()) {
+            return CopyResult::ENOUGH_REPLICAS;
+        }
+        return RunReconstructTask(chunk_handle, copied_nums);
+    }
+
+    if (locations.size() >= replica_nums_) {
+        return CopyResult::ENOUGH_REPLICAS;
+    }
+
+    if (locations.empty()) {
+        LOG(ERROR) << "chunk handle " << chunk_handle
+                   << " has no live replica to copy";
+        return CopyResult::LOST;
+    }
+
+    ChunkServerLocation source;
+    {
+        absl::MutexLock lock_guard(&lock_);
+        if (!ReserveSource(locations, &source)) {
+            return CopyResult::DEFERRED;
+        }
+    }
+
+    auto assigned_locations =
+        chunk_server_manager_->AssignChunkServerToCopyReplica(chunk_handle,
+                                                              replica_nums_);
+    std::vector<ChunkServerLocation> destinations;
+    {
+        absl::MutexLock lock_guard(&lock_);
+        for (const auto& location : assigned_locations) {
+            auto& copies =
+                destination_copies_[ChunkServerLocationToString(location)];
+            if (copies < max_copies_per_destination_) {
+                copies++;
+                destinations.push_back(location);
             }
         }
-    }));
 
-    // 副本探测
-    replica_check_thread_ = std::make_unique<std::thread>(std::thread([&]() {
-        while (!stop_chunk_replica_copy_task_.load()) {
-            // 探测副本数量，然后执行复制任务
-            for (const auto& val_pair :
-                 chunk_server_manager_->chunk_location_maps_) {
-                if (val_pair.second.size() < 3) {
-                    LOG(INFO) << "ReplicaCheckTask: chunk handle "
-                              << val_pair.first << " need to copy";
-                    AddChunkReplicaTask(val_pair.first);
-                }
+        if (destinations.empty()) {
+            ReleaseCopySlots(source, destinations);
+            if (assigned_locations.empty()) {
+                LOG(INFO) << "no more chunk server to copy " << chunk_handle
+                          << " replica";
+                return CopyResult::NO_DESTINATION;
             }
+            return CopyResult::DEFERRED;
+        }
+    }
 
-            std::this_thread::sleep_for(std::chrono::seconds(10));
+    const std::string source_address = ChunkServerLocationToString(source);
+    LOG(INFO) << "start to copy chunk handle " << chunk_handle << " from "
+              << source_address << " to " << destinations.size() << " servers";
+
+    // 按照一个完整数据块估计复制的数据量
+    bandwidth_limiter_->Acquire(chunk_size_bytes_ * destinations.size());
+
+    // 复制期间源与目标块服务器都有额外的负载
+    chunk_server_manager_->BeginReplication(source);
+    for (const auto& location : destinations) {
+        chunk_server_manager_->BeginReplication(location);
+    }
+
+    ChunkReplicaCopyRequest copy_req;
+    copy_req.set_chunk_handle(chunk_handle);
+    for (const auto& location : destinations) {
+        *copy_req.add_locations() = location;
+    }
+
+    auto source_client =
+        chunk_server_manager_->GetOrCreateChunkServerFileServiceClient(
+            source_address);
+    google::protobuf::util::StatusOr<ChunkReplicaCopyRespond> respond_or =
+        google::protobuf::util::UnavailableError(
+            "can not get or create file service client");
+    if (source_client) {
+        respond_or = source_client->SendRequest(copy_req);
+    }
+
+    chunk_server_manager_->EndReplication(source);
+    for (const auto& location : destinations) {
+        chunk_server_manager_->EndReplication(location);
+    }
+
+    *copied_nums = 0;
+    if (respond_or.ok()) {
+        // 立即记录新的副本位置，避免下一次扫描时重复复制
+        for (const auto& location : respond_or.value().copied_locations()) {
+            chunk_server_manager_->AddChunkLocation(chunk_handle, location);
+            (*copied_nums)++;
         }
-    }));
+    } else {
+        LOG(ERROR) << "copy chunk handle " << chunk_handle << " from "
+                   << source_address << " failed, because "
+                   << respond_or.status().ToString();
+    }
+
+    absl::MutexLock lock_guard(&lock_);
+    ReleaseCopySlots(source, destinations);
+    stats_.completed_copies += *copied_nums;
+    stats_.failed_copies += destinations.size() - *copied_nums;
+    if (respond_or.ok()) {
+        stats_.copied_bytes += respond_or.value().chunk_size() * (*copied_nums);
+    }
+
+    return *copied_nums > 0 ? CopyResult::COPIED : CopyResult::FAILED;
 }
 
-void ChunkReplicaManager::StopChunkReplicaCopyTask() {
-    stop_chunk_replica_copy_task_.store(true);
-    thread_ptr_->join();
-    replica_check_thread_->join();
+ChunkReplicaManager::CopyResult ChunkReplicaManager::RunReconstructTask(
+    const std::string& chunk_handle, uint32_t* reconstructed_nums) {
+    auto erasure_coding_manager = ErasureCodingManager::GetInstance();
+    // 重建需要读取 data_shards 个分片，按完整的数据块估计
+    bandwidth_limiter_->Acquire(chunk_size_bytes_ *
+                                erasure_coding_manager->data_shards());
+
+    auto size_or = erasure_coding_manager->ReconstructChunk(chunk_handle);
+    *reconstructed_nums = size_or.ok() ? 1 : 0;
+
+    absl::MutexLock lock_guard(&lock_);
+    if (size_or.ok()) {
+        stats_.reconstructed_chunks++;
+        stats_.copied_bytes += size_or.value();
+        return CopyResult::COPIED;
+    }
+
+    LOG(ERROR) << "reconstruct chunk handle " << chunk_handle
+               << " failed, because " << size_or.status().ToString();
+    if (google::protobuf::util::IsDataLoss(size_or.status())) {
+        return CopyResult::LOST;
+    }
+    stats_.failed_copies++;
+    return CopyResult::FAILED;
+}
+
+bool ChunkReplicaManager::ReserveSource(
+    const ChunkServerLocationFlatSet& locations, ChunkServerLocation* source) {
+    const ChunkServerLocation* best_location = nullptr;
+    uint32_t best_copies = max_copies_per_source_;
+    for (const auto& location : locations) {
+        auto iter = source_copies_.find(ChunkServerLocationToString(location));
+        const uint32_t copies = iter == source_copies_.end() ? 0 : iter->second;
+        if (copies < best_copies) {
+            best_copies = copies;
+            best_location = &location;
+        }
+    }
+
+    if (!best_location) {
+        return false;
+    }
+
+    *source = *best_location;
+    source_copies_[ChunkServerLocationToString(*source)]++;
+    return true;
+}
+
+void ChunkReplicaManager::ReleaseCopySlots(
+    const ChunkServerLocation& source,
+    const std::vector<ChunkServerLocation>& destinations) {
+    auto source_iter = source_copies_.find(ChunkServerLocationToString(source));
+    if (source_iter != source_copies_.end() && --source_iter->second == 0) {
+        source_copies_.erase(source_iter);
+    }
+
+    for (const auto& location : destinations) {
+        auto iter =
+            destination_copies_.find(ChunkServerLocationToString(location));
+        if (iter != destination_copies_.end() && --iter->second == 0) {
+            destination_copies_.erase(iter);
+        }
+    }
 }
 
 }  // namespace server
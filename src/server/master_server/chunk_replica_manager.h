@@ -1,62 +1,190 @@
 #ifndef DFS_SERVER_CHUNK_REPLICA_MANAGER_H
 #define DFS_SERVER_CHUNK_REPLICA_MANAGER_H
 
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
 #include <absl/synchronization/mutex.h>
-#include <absl/synchronization/notification.h>
+#include <absl/time/time.h>
 
 #include <atomic>
 #include <memory>
-#include <queue>
 #include <string>
 #include <thread>
+#include <vector>
 
+#include "src/common/token_bucket.h"
+#include "src/server/master_server/chunk_replica_queue.h"
 #include "src/server/master_server/chunk_server_manager.h"
-#include "src/server/master_server/metadata_manager.h"
 
 namespace dfs {
 namespace server {
 
+/**
+ * 副本复制调度
+ * 1. 副本数量不足的数据块进入去重的优先队列，存活副本越少越先复制
+ * 2. 多个工作线程并行复制，每个源与目标块服务器同时进行的复制数量有上限，
+ *    超过上限的任务延后，等待其他复制完成后再调度
+ * 3. 复制的总带宽受令牌桶限制，避免挤占客户端的读写
+ * 4. 纠删码文件的分片只保存一份，丢失后从条带中的其他分片重建
+ * 5. 长时间没有被读写的多副本文件在后台转换为纠删码文件。转换有单独的
+ *    带宽限制，有副本复制任务或者客户端读写较多时暂停，不与二者竞争
+ */
 class ChunkReplicaManager {
    public:
+    // 副本复制的进度统计
+    struct ReplicationStats {
+        // 等待复制的数据块数量
+        uint64_t queued_chunks = 0;
+        // 正在复制的数据块数量
+        uint64_t running_chunks = 0;
+        // 因并发上限延后的数据块数量
+        uint64_t deferred_chunks = 0;
+        // 成功复制的副本数量
+        uint64_t completed_copies = 0;
+        // 复制失败的副本数量
+        uint64_t failed_copies = 0;
+        // 成功复制的字节数
+        uint64_t copied_bytes = 0;
+        // 没有存活副本，无法恢复的数据块数量
+        uint64_t lost_chunks = 0;
+        // 重建的纠删码分片数量
+        uint64_t reconstructed_chunks = 0;
+        // 后台转换为纠删码的文件数量
+        uint64_t transcoded_files = 0;
+        // 后台转换失败的文件数量
+        uint64_t transcode_failed_files = 0;
+    };
+
     // 单例模式
     static ChunkReplicaManager* GetInstance();
 
-    void AddChunkReplicaTask(const std::string& chunk_handle);
+    // 添加副本复制任务，live_replica_nums 为当前存活的副本数量
+    void AddChunkReplicaTask(const std::string& chunk_handle,
+                             const uint32_t& live_replica_nums);
 
     void StartChunkReplicaCopyTask();
 
     void StopChunkReplicaCopyTask();
 
+    ReplicationStats GetReplicationStats();
+
    private:
     ChunkReplicaManager();
 
-    // 块句柄队列，将数据块副本数量低于健康值的块句柄记录在这里
-    // 生产者消费者队列
-    std::queue<std::string> chunk_replica_queues_;
+    // 一次复制任务的结果
+    enum class CopyResult {
+        // 副本数量已经足够
+        ENOUGH_REPLICAS,
+        // 复制成功
+        COPIED,
+        // 复制失败
+        FAILED,
+        // 源或目标块服务器达到并发上限
+        DEFERRED,
+        // 没有可用的目标块服务器
+        NO_DESTINATION,
+        // 没有存活的副本
+        LOST,
+    };
+
+    // 读取配置
+    void LoadConfig();
+
+    // 工作线程，从队列中取出任务执行
+    void RunCopyWorker();
+
+    // 扫描副本数量不足的数据块
+    void ScanUnderReplicatedChunks();
+
+    // 将冷文件转换为纠删码文件，块服务器（机架）少于一个条带的分片数量时
+    // 跳过
+    void TranscodeColdFiles();
+
+    // 是否需要暂停后台转换
+    bool ShouldPauseTranscode();
+
+    // 执行一次复制，copied_nums 为成功复制的副本数量
+    CopyResult RunCopyTask(const std::string& chunk_handle,
+                           uint32_t* copied_nums);
+
+    // 重建纠删码文件中丢失的分片，reconstructed_nums 为重建的分片数量
+    CopyResult RunReconstructTask(const std::string& chunk_handle,
+                                  uint32_t* reconstructed_nums);
+
+    // 选择复制任务最少且未达到上限的源块服务器，调用者需持有 lock_
+    bool ReserveSource(const ChunkServerLocationFlatSet& locations,
+                       protos::ChunkServerLocation* source);
+
+    // 释放源与目标块服务器的并发名额，调用者需持有 lock_
+    void ReleaseCopySlots(
+        const protos::ChunkServerLocation& source,
+        const std::vector<protos::ChunkServerLocation>& destinations);
+
+    // 配置
+    uint32_t replica_nums_;
+    uint32_t max_concurrent_copies_;
+    uint32_t max_copies_per_source_;
+    uint32_t max_copies_per_destination_;
+    uint64_t chunk_size_bytes_;
+    absl::Duration scan_interval_;
+    absl::Duration cold_file_age_;
+    absl::Duration transcode_scan_interval_;
+    uint32_t max_transcode_files_per_scan_;
+    uint64_t max_transcode_client_iops_;
 
-    // 锁
-    absl::Mutex chunk_replica_queues_lock_;
+    // 保护以下所有成员
+    absl::Mutex lock_;
 
-    // 条件变量
-    absl::CondVar cond_var_;
+    // 有新任务或者有并发名额释放时通知工作线程
+    absl::CondVar task_cond_var_;
+
+    // 通知副本探测线程退出
+    absl::CondVar stop_cond_var_;
+
+    // 副本复制任务队列
+    ChunkReplicaQueue chunk_replica_queue_;
+
+    // 正在复制的块句柄
+    absl::flat_hash_set<std::string> running_chunks_;
+
+    // 因并发上限延后的任务 <chunk_handle, live replica nums>
+    std::vector<std::pair<std::string, uint32_t>> deferred_chunks_;
+
+    // map<server_address, copy nums>
+    absl::flat_hash_map<std::string, uint32_t> source_copies_;
+    absl::flat_hash_map<std::string, uint32_t> destination_copies_;
+
+    // 没有存活副本的块句柄
+    absl::flat_hash_set<std::string> lost_chunks_;
+
+    ReplicationStats stats_;
+
+    // 副本复制的带宽限制，单位为字节
+    std::unique_ptr<dfs::common::TokenBucket> bandwidth_limiter_;
+
+    // 后台转换的带宽限制，单位为字节
+    std::unique_ptr<dfs::common::TokenBucket> transcode_limiter_;
 
     // 用于执行块副本复制任务
-    std::unique_ptr<std::thread> thread_ptr_;
+    std::vector<std::unique_ptr<std::thread>> copy_threads_;
 
     // 用于副本探测
     std::unique_ptr<std::thread> replica_check_thread_;
 
+    // 用于将冷文件转换为纠删码文件，cold_file_age_ 为 0 时不启动
+    std::unique_ptr<std::thread> transcode_thread_;
+
+    // 是否已经记录过块服务器不足，只由转换线程访问，块服务器足够时重置
+    bool transcode_skip_logged_ = false;
+
     // 是否暂停当前副本复制任务
     std::atomic<bool> stop_chunk_replica_copy_task_{false};
 
     // 管理块服务器的对象
     ChunkServerManager* chunk_server_manager_;
-
-    // 管理元数据的单例对象
-    MetadataManager* metadata_manager_;
 };
 
 }  // namespace server
 }  // namespace dfs
 
-#endif  // DFS_SERVER_CHUNK_REPLICA_MANAGER_H
\ No newline at end of file
+#endif  // DFS_SERVER_CHUNK_REPLICA_MANAGER_H
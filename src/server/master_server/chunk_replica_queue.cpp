@@ -0,0 +1,48 @@
+#include "src/server/master_server/chunk_replica_queue.h"
+
+namespace dfs {
+namespace server {
+
+bool ChunkReplicaQueue::Push(const std::string& chunk_handle,
+                             uint32_t live_replica_nums) {
+    auto iter = keys_.find(chunk_handle);
+    if (iter != keys_.end()) {
+        // 已在队列中，副本数量减少时提高优先级，并保持原有的先后顺序
+        if (live_replica_nums < std::get<0>(iter->second)) {
+            queue_.erase(iter->second);
+            std::get<0>(iter->second) = live_replica_nums;
+            queue_.insert(iter->second);
+        }
+        return false;
+    }
+
+    QueueKey key(live_replica_nums, sequence_++, chunk_handle);
+    queue_.insert(key);
+    keys_.emplace(chunk_handle, key);
+    return true;
+}
+
+bool ChunkReplicaQueue::Pop(std::string* chunk_handle,
+                            uint32_t* live_replica_nums) {
+    if (queue_.empty()) {
+        return false;
+    }
+
+    auto iter = queue_.begin();
+    *live_replica_nums = std::get<0>(*iter);
+    *chunk_handle = std::get<2>(*iter);
+    keys_.erase(*chunk_handle);
+    queue_.erase(iter);
+    return true;
+}
+
+bool ChunkReplicaQueue::Contains(const std::string& chunk_handle) const {
+    return keys_.contains(chunk_handle);
+}
+
+bool ChunkReplicaQueue::empty() const { return queue_.empty(); }
+
+size_t ChunkReplicaQueue::size() const { return queue_.size(); }
+
+}  // namespace server
+}  // namespace dfs
@@ -0,0 +1,49 @@
+#ifndef DFS_SERVER_MASTER_SERVER_CHUNK_REPLICA_QUEUE_H
+#define DFS_SERVER_MASTER_SERVER_CHUNK_REPLICA_QUEUE_H
+
+#include <absl/container/flat_hash_map.h>
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <tuple>
+
+namespace dfs {
+namespace server {
+
+/**
+ * 副本复制任务队列
+ * 1. 以存活副本数量为优先级，存活副本越少越先复制，相同优先级先进先出
+ * 2. 同一块句柄只会在队列中出现一次，重复添加时取更高的优先级
+ * 非线程安全，调用者需自行加锁。
+ */
+class ChunkReplicaQueue {
+   public:
+    // 添加任务，返回是否为新添加的块句柄
+    bool Push(const std::string& chunk_handle, uint32_t live_replica_nums);
+
+    // 取出优先级最高的任务，队列为空时返回 false
+    bool Pop(std::string* chunk_handle, uint32_t* live_replica_nums);
+
+    bool Contains(const std::string& chunk_handle) const;
+
+    bool empty() const;
+
+    size_t size() const;
+
+   private:
+    // <live replica nums, sequence, chunk handle>
+    using QueueKey = std::tuple<uint32_t, uint64_t, std::string>;
+
+    std::set<QueueKey> queue_;
+
+    // map<chunk_handle, key in queue_>
+    absl::flat_hash_map<std::string, QueueKey> keys_;
+
+    uint64_t sequence_ = 0;
+};
+
+}  // namespace server
+}  // namespace dfs
+
+#endif  // DFS_SERVER_MASTER_SERVER_CHUNK_REPLICA_QUEUE_H
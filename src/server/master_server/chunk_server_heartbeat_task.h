@@ -2,16 +2,25 @@
 #define DFS_SERVER_CHUNK_SERVER_HEARTBEAT_TASK_H
 
 #include <absl/container/flat_hash_map.h>
+#include <absl/synchronization/mutex.h>
+#include <absl/time/time.h>
 
 #include <atomic>
+#include <memory>
 #include <thread>
 
 #include "chunk_server.pb.h"
-#include "src/grpc_client/chunk_server_control_service_client.h"
+#include "src/server/master_server/timer_wheel.h"
 
 namespace dfs {
 namespace server {
 
+/**
+ * 心跳包任务
+ * 主服务器不再主动探测块服务器，块服务器的定时汇报即为心跳：
+ * 每次汇报为块服务器续约一个存活租约，租约记录在时间轮中，
+ * 任务线程定时推进时间轮，注销租约已经过期的块服务器。
+ */
 class ChunkServerHeartBeatTask {
    public:
     // 获取单例对象
@@ -23,27 +32,42 @@ class ChunkServerHeartBeatTask {
     // 结束心跳包任务
     void StopHeartBeatTask();
 
+    // 块服务器汇报时调用，为其续约存活租约
+    void RenewChunkServerLease(const protos::ChunkServerLocation& location);
+
+    // 块服务器的汇报间隔，通过汇报的回复下发给块服务器
+    uint32_t GetReportIntervalMs() const;
+
    private:
     ChunkServerHeartBeatTask();
     ~ChunkServerHeartBeatTask();
 
-    // 执行心跳包检测服务的线程
+    // 读取配置
+    void LoadConfig();
+
+    // 推进时间轮，注销租约已经过期的块服务器
+    void ExpireChunkServers();
+
+    // 执行心跳包任务的线程
     std::unique_ptr<std::thread> thread_;
 
     std::atomic<bool> stop_heart_beat_task_{false};
 
-    std::shared_ptr<dfs::grpc_client::ChunkServerControlServiceClient>
-    GetOrCreateChunkServerControlServiceClient(
-        const std::string& server_address);
+    // 配置
+    std::atomic<uint32_t> report_interval_ms_;
+    absl::Duration lease_;
+    absl::Duration tick_;
+
+    // 保护 timer_wheel_ 与 locations_
+    absl::Mutex lock_;
+
+    std::unique_ptr<TimerWheel> timer_wheel_;
 
-    // map<server_address, client ptr>
-    absl::flat_hash_map<
-        std::string,
-        std::shared_ptr<dfs::grpc_client::ChunkServerControlServiceClient>>
-        control_clients_;
+    // map<server_address, location>
+    absl::flat_hash_map<std::string, protos::ChunkServerLocation> locations_;
 };
 
 }  // namespace server
 }  // namespace dfs
 
-#endif  // DFS_SERVER_CHUNK_SERVER_HEARTBEAT_TASK_H
\ No newline at end of file
+#endif  // DFS_SERVER_CHUNK_SERVER_HEARTBEAT_TASK_H
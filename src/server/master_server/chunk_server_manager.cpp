@@ -1,5 +1,8 @@
 #include "src/server/master_server/chunk_server_manager.h"
 
+#include <algorithm>
+
+#include "src/common/config_manager.h"
 #include "src/common/system_logger.h"
 #include "src/server/master_server/chunk_replica_manager.h"
 #include "src/server/master_server/metadata_manager.h"
@@ -23,6 +26,7 @@ bool operator<(const ChunkServer& l, const ChunkServer& r) {
 namespace dfs {
 namespace server {
 
+using dfs::common::ConfigManager;
 using dfs::grpc_client::ChunkServerFileServiceClient;
 using dfs::grpc_client::ChunkServerLeaseServiceClient;
 using protos::ChunkServerLocation;
@@ -42,6 +46,29 @@ std::string ChunkServerLocationToString(const protos::ChunkServerLocation& locat
     return location.server_hostname() + ":" + std::to_string(location.server_port());
 }
 
+namespace {
+
+// 从配置文件中读取块服务器的故障域，未配置主机时使用块服务器的地址
+FailureDomain GetChunkServerFailureDomain(
+    const protos::ChunkServerLocation& location) {
+    const std::string server_address = ChunkServerLocationToString(location);
+    auto config_manager = ConfigManager::GetInstance();
+
+    FailureDomain domain;
+    domain.rack = config_manager->GetChunkServerRack(server_address);
+    domain.host = config_manager->GetChunkServerHost(server_address);
+    if (domain.host.empty()) {
+        domain.host = location.server_hostname();
+    }
+    return domain;
+}
+
+}  // namespace
+
+ChunkServerManager::ChunkServerManager()
+    // 剩余空间至少要能存放一个数据块
+    : placement_policy_(ConfigManager::GetInstance()->GetBlockSize()) {}
+
 ChunkServerManager* ChunkServerManager::GetInstance() {
     static ChunkServerManager* instance = new ChunkServerManager();
     return instance;
@@ -59,6 +86,8 @@ bool ChunkServerManager::RegisterChunkServer(
     }
 
     chunk_server_maps_[chunk_server->location()] = chunk_server;
+    placement_policy_.AddServer(
+        *chunk_server, GetChunkServerFailureDomain(chunk_server->location()));
     // handle store chunk
     for (int i = 0; i < chunk_server->stored_chunk_handles_size(); i++) {
         chunk_location_maps_[chunk_server->stored_chunk_handles()[i]].insert(
@@ -81,6 +110,7 @@ bool ChunkServerManager::UnRegisterChunkServer(
 
     auto chunk_server = chunk_server_maps_[location];
     chunk_server_maps_.erase(chunk_server->location());
+    placement_policy_.RemoveServer(location);
 
     // 在 master 中删除掉 <chunk_handle, location> 映射，表明 chunk_handle
     // 所代表的 chunk 已不存在于 location 所代表的 chunkserver
@@ -93,9 +123,11 @@ bool ChunkServerManager::UnRegisterChunkServer(
         UpdateFileChunkMetadataLocation(chunk_server->stored_chunk_handles()[i],
                                         chunk_server->location());
 
-        // 复制副本
+        // 复制副本，存活副本越少越优先
         ChunkReplicaManager::GetInstance()->AddChunkReplicaTask(
-            chunk_server->stored_chunk_handles()[i]);
+            chunk_server->stored_chunk_handles()[i],
+            chunk_location_maps_[chunk_server->stored_chunk_handles()[i]]
+                .size());
     }
 
     return true;
@@ -111,6 +143,18 @@ std::shared_ptr<protos::ChunkServer> ChunkServerManager::GetChunkServer(
     return chunk_server_maps_[location];
 }
 
+std::vector<protos::ChunkServerLocation>
+ChunkServerManager::GetAllChunkServerLocations() {
+    absl::ReaderMutexLock chunk_server_maps_lock_guard(
+        &chunk_server_maps_lock_);
+    std::vector<ChunkServerLocation> locations;
+    locations.reserve(chunk_server_maps_.size());
+    for (const auto& location_pair : chunk_server_maps_) {
+        locations.emplace_back(location_pair.first);
+    }
+    return locations;
+}
+
 ChunkServerLocationFlatSet ChunkServerManager::GetChunkLocation(
     const std::string& chunk_handle) {
     absl::ReaderMutexLock chunk_location_maps_lock_guard(
@@ -132,7 +176,7 @@ ChunkServerLocationFlatSet ChunkServerManager::GetChunkLocationNoLock(
 
 ChunkServerLocationFlatSet ChunkServerManager::AssignChunkServer(
     const std::string& chunk_handle, const uint32_t& server_request_nums) {
-    absl::ReaderMutexLock chunk_location_maps_lock_guard(
+    absl::WriterMutexLock chunk_location_maps_lock_guard(
         &chunk_location_maps_lock_);
 
     if (chunk_location_maps_.contains(chunk_handle) &&
@@ -141,17 +185,10 @@ ChunkServerLocationFlatSet ChunkServerManager::AssignChunkServer(
     }
 
     ChunkServerLocationFlatSet assigned_locations;
-    int assigned_nums = 0;
-    // TODO: 选择磁盘剩余空间最多的块服务器
-    for (const auto& chunk_server : chunk_server_maps_) {
-        const auto& location = chunk_server.first;
-        if (assigned_nums >= (int)server_request_nums) {
-            break;
-        }
-
+    for (const auto& location :
+         placement_policy_.ChooseServers(server_request_nums, {})) {
         assigned_locations.insert(location);
         chunk_location_maps_[chunk_handle].insert(location);
-        assigned_nums++;
     }
 
     return assigned_locations;
@@ -163,36 +200,137 @@ ChunkServerLocationFlatSet ChunkServerManager::AssignChunkServerToCopyReplica(
         &chunk_location_maps_lock_);
     ChunkServerLocationFlatSet assigned_locations;
 
-    if (!chunk_location_maps_.contains(chunk_handle)) {
+    auto iter = chunk_location_maps_.find(chunk_handle);
+    if (iter == chunk_location_maps_.end()) {
         LOG(ERROR) << "no chunk replica to copy";
         return assigned_locations;
     }
 
-    if (chunk_location_maps_[chunk_handle].size() >= healthy_replica_nums) {
-        LOG(INFO) << "have " << chunk_location_maps_[chunk_handle].size()
+    const auto& existing_locations = iter->second;
+    if (existing_locations.size() >= healthy_replica_nums) {
+        LOG(INFO) << "have " << existing_locations.size()
                   << " in server, no need copy";
         return assigned_locations;
     }
 
-    int replica_num = chunk_location_maps_[chunk_handle].size();
-    // TODO: 优先选择磁盘容量充足的块服务器
-    for (const auto& location_pair : chunk_server_maps_) {
-        if (replica_num >= healthy_replica_nums) {
-            break;
+    for (const auto& location : placement_policy_.ChooseServers(
+             healthy_replica_nums - existing_locations.size(),
+             ChunkServerLocationFlatSetToVector(existing_locations))) {
+        assigned_locations.insert(location);
+    }
+
+    return assigned_locations;
+}
+
+std::vector<protos::ChunkServerLocation> ChunkServerManager::ChooseChunkServers(
+    const uint32_t& server_nums,
+    const std::vector<protos::ChunkServerLocation>& existing_locations,
+    bool distinct_racks) {
+    return placement_policy_.ChooseServers(server_nums, existing_locations,
+                                           distinct_racks);
+}
+
+std::string ChunkServerManager::GetChunkServerRack(
+    const protos::ChunkServerLocation& location) {
+    return GetChunkServerFailureDomain(location).rack;
+}
+
+void ChunkServerManager::RemoveChunkReplica(
+    const std::string& chunk_handle,
+    const protos::ChunkServerLocation& location) {
+    {
+        absl::WriterMutexLock chunk_server_maps_lock_guard(
+            &chunk_server_maps_lock_);
+        absl::WriterMutexLock chunk_location_maps_lock_guard(
+            &chunk_location_maps_lock_);
+
+        chunk_location_maps_[chunk_handle].erase(location);
+        auto iter = chunk_server_maps_.find(location);
+        if (iter != chunk_server_maps_.end()) {
+            auto chunk_handles =
+                iter->second->mutable_stored_chunk_handles();
+            chunk_handles->erase(
+                std::remove(chunk_handles->begin(), chunk_handles->end(),
+                            chunk_handle),
+                chunk_handles->end());
         }
+    }
+
+    absl::MutexLock pending_deletions_lock_guard(&pending_deletions_lock_);
+    pending_deletions_[location].insert(chunk_handle);
+}
+
+absl::flat_hash_set<std::string> ChunkServerManager::TakePendingDeletions(
+    const protos::ChunkServerLocation& location) {
+    absl::MutexLock pending_deletions_lock_guard(&pending_deletions_lock_);
+    auto iter = pending_deletions_.find(location);
+    if (iter == pending_deletions_.end()) {
+        return {};
+    }
+
+    auto chunk_handles = std::move(iter->second);
+    pending_deletions_.erase(iter);
+    return chunk_handles;
+}
 
-        if (!chunk_location_maps_[chunk_handle].contains(location_pair.first)) {
-            assigned_locations.insert(location_pair.first);
-            replica_num++;
+std::vector<std::pair<std::string, uint32_t>>
+ChunkServerManager::GetUnderReplicatedChunks(const uint32_t& replica_nums) {
+    absl::ReaderMutexLock chunk_location_maps_lock_guard(
+        &chunk_location_maps_lock_);
+    std::vector<std::pair<std::string, uint32_t>> chunks;
+    for (const auto& location_pair : chunk_location_maps_) {
+        if (location_pair.second.size() < replica_nums) {
+            chunks.emplace_back(location_pair.first,
+                                location_pair.second.size());
         }
     }
+    return chunks;
+}
 
-    return assigned_locations;
+void ChunkServerManager::AddChunkLocation(
+    const std::string& chunk_handle,
+    const protos::ChunkServerLocation& location) {
+    absl::WriterMutexLock chunk_server_maps_lock_guard(
+        &chunk_server_maps_lock_);
+    absl::WriterMutexLock chunk_location_maps_lock_guard(
+        &chunk_location_maps_lock_);
+
+    auto iter = chunk_server_maps_.find(location);
+    if (iter == chunk_server_maps_.end()) {
+        return;
+    }
+
+    if (!chunk_location_maps_[chunk_handle].insert(location).second) {
+        return;
+    }
+    // 同时记录在块服务器信息中，下一次汇报时不会被重复添加
+    iter->second->add_stored_chunk_handles(chunk_handle);
+}
+
+void ChunkServerManager::BeginReplication(
+    const protos::ChunkServerLocation& location) {
+    placement_policy_.BeginReplication(location);
+}
+
+void ChunkServerManager::EndReplication(
+    const protos::ChunkServerLocation& location) {
+    placement_policy_.EndReplication(location);
+}
+
+uint64_t ChunkServerManager::GetTotalClientIops() {
+    absl::ReaderMutexLock chunk_server_maps_lock_guard(
+        &chunk_server_maps_lock_);
+    uint64_t iops = 0;
+    for (const auto& server_pair : chunk_server_maps_) {
+        const auto& load = server_pair.second->load();
+        iops += load.read_iops() + load.write_iops();
+    }
+    return iops;
 }
 
 void ChunkServerManager::UpdateChunkServer(
     const protos::ChunkServerLocation& location,
-    const uint32_t& available_disk_mb,
+    const uint32_t& available_disk_mb, const protos::ChunkServerLoad& load,
     const absl::flat_hash_set<std::string>& chunks_to_add,
     const absl::flat_hash_set<std::string>& chunks_to_remove) {
     auto chunk_server = GetChunkServer(location);
@@ -202,7 +340,13 @@ void ChunkServerManager::UpdateChunkServer(
         return;
     }
 
-    LOG(INFO) << "start to update chunk server";
+    DFS_VLOG(1) << "start to update chunk server";
+
+    // 块服务器每个汇报周期都会更新，需要与读取者互斥
+    absl::WriterMutexLock chunk_server_maps_lock_guard(
+        &chunk_server_maps_lock_);
+    absl::WriterMutexLock chunk_location_maps_lock_guard(
+        &chunk_location_maps_lock_);
 
     if (!chunks_to_remove.empty()) {
         for (auto iter = chunk_server->stored_chunk_handles().begin();
@@ -226,6 +370,8 @@ void ChunkServerManager::UpdateChunkServer(
     }
 
     chunk_server->set_available_disk_mb(available_disk_mb);
+    *chunk_server->mutable_load() = load;
+    placement_policy_.UpdateServerLoad(location, available_disk_mb, load);
 }
 
 void ChunkServerManager::UpdateFileChunkMetadataLocation(
@@ -11,6 +11,7 @@
 #include "chunk_server.pb.h"
 #include "src/grpc_client/chunk_server_file_service_client.h"
 #include "src/grpc_client/chunk_server_lease_service_client.h"
+#include "src/server/master_server/chunk_placement_policy.h"
 
 namespace protos {
 bool operator==(const ChunkServerLocation& l, const ChunkServerLocation& r);
@@ -67,6 +68,9 @@ class ChunkServerManager {
     std::shared_ptr<protos::ChunkServer> GetChunkServer(
         const protos::ChunkServerLocation& location);
 
+    // 获取当前已注册的所有块服务器地址
+    std::vector<protos::ChunkServerLocation> GetAllChunkServerLocations();
+
     // 获取存储块句柄的块服务器地址集合
     ChunkServerLocationFlatSet GetChunkLocation(
         const std::string& chunk_handle);
@@ -77,7 +81,7 @@ class ChunkServerManager {
     ChunkServerLocationFlatSet GetChunkLocationNoLock(
         const std::string& chunk_handle);
 
-    // 分配一定数量的块服务器用于存储块句柄
+    // 分配一定数量的块服务器用于存储块句柄，由放置策略按负载与故障域选择
     ChunkServerLocationFlatSet AssignChunkServer(
         const std::string& chunk_handle, const uint32_t& server_request_nums);
 
@@ -85,10 +89,45 @@ class ChunkServerManager {
     ChunkServerLocationFlatSet AssignChunkServerToCopyReplica(
         const std::string& chunk_handle, const uint32_t& healthy_replica_nums);
 
-    // 更新块服务器信息
+    // 选择 server_nums 个不在 existing_locations 中的块服务器，不记录数据块
+    // 位置，用于放置纠删码文件的校验块与重建的分片。distinct_racks 为 true
+    // 时选中的块服务器与 existing_locations 都位于不同的机架
+    std::vector<protos::ChunkServerLocation> ChooseChunkServers(
+        const uint32_t& server_nums,
+        const std::vector<protos::ChunkServerLocation>& existing_locations,
+        bool distinct_racks = false);
+
+    // 块服务器所在的机架，未配置时为空字符串
+    std::string GetChunkServerRack(const protos::ChunkServerLocation& location);
+
+    // 删除块服务器上多余的副本，块服务器下一次汇报时通知其删除
+    void RemoveChunkReplica(const std::string& chunk_handle,
+                            const protos::ChunkServerLocation& location);
+
+    // 取出需要块服务器删除的副本
+    absl::flat_hash_set<std::string> TakePendingDeletions(
+        const protos::ChunkServerLocation& location);
+
+    // 获取副本数量低于 replica_nums 的数据块，以及其存活的副本数量
+    std::vector<std::pair<std::string, uint32_t>> GetUnderReplicatedChunks(
+        const uint32_t& replica_nums);
+
+    // 副本复制成功后记录新的数据块位置，不必等待块服务器下一次汇报
+    void AddChunkLocation(const std::string& chunk_handle,
+                          const protos::ChunkServerLocation& location);
+
+    // 记录块服务器上正在进行的副本复制，放置策略会避开复制任务较多的块服务器
+    void BeginReplication(const protos::ChunkServerLocation& location);
+
+    void EndReplication(const protos::ChunkServerLocation& location);
+
+    // 所有块服务器最近一次汇报的客户端读写 IOPS 之和
+    uint64_t GetTotalClientIops();
+
+    // 更新块服务器信息，包括块服务器汇报的剩余空间与负载
     void UpdateChunkServer(
         const protos::ChunkServerLocation& location,
-        const uint32_t& available_disk_mb,
+        const uint32_t& available_disk_mb, const protos::ChunkServerLoad& load,
         const absl::flat_hash_set<std::string>& chunks_to_add,
         const absl::flat_hash_set<std::string>& chunks_to_remove);
 
@@ -99,7 +138,7 @@ class ChunkServerManager {
     GetOrCreateChunkServerLeaseServiceClient(const std::string& server_address);
 
    private:
-    ChunkServerManager() = default;
+    ChunkServerManager();
 
     // 更新数据块元数据的主副本服务器位置信息
     void UpdateFileChunkMetadataLocation(
@@ -120,6 +159,17 @@ class ChunkServerManager {
 
     absl::Mutex chunk_location_maps_lock_;
 
+    // 等待块服务器删除的副本
+    absl::flat_hash_map<protos::ChunkServerLocation,
+                        absl::flat_hash_set<std::string>,
+                        ChunkServerLocationHash>
+        pending_deletions_;
+
+    absl::Mutex pending_deletions_lock_;
+
+    // 数据块放置策略
+    ChunkPlacementPolicy placement_policy_;
+
     // 块服务器文件服务的客户端映射表
     absl::flat_hash_map<
         std::string,
@@ -1,6 +1,10 @@
 #include "src/server/master_server/chunk_server_manager_service_impl.h"
 
+#include <absl/time/clock.h>
+
+#include "src/common/config_manager.h"
 #include "src/common/system_logger.h"
+#include "src/server/master_server/chunk_server_heartbeat_task.h"
 #include "src/server/master_server/chunk_server_manager.h"
 #include "src/server/master_server/metadata_manager.h"
 
@@ -13,12 +17,21 @@ grpc::Status ChunkServerManagerServiceImpl::ReportChunkServer(
     protos::grpc::ReportChunkServerRespond* respond) {
     // 从 request 中获取 chunk_server 信息
     auto info = request->chunk_server();
-    LOG(INFO) << "Master handle request from "
-              << info.location().server_hostname() + ":" +
-                     std::to_string(info.location().server_port());
+    DFS_VLOG(1) << "Master handle request from "
+                << info.location().server_hostname() + ":" +
+                       std::to_string(info.location().server_port());
+    // 汇报即心跳，续约块服务器的存活租约，并告知下一次汇报的间隔
+    auto heartbeat_task = ChunkServerHeartBeatTask::GetInstance();
+    respond->set_report_interval_ms(heartbeat_task->GetReportIntervalMs());
+
     auto chunk_server =
         ChunkServerManager::GetInstance()->GetChunkServer(info.location());
     if (!chunk_server) {
+        // 注册需要完整的数据块清单，只有负载的汇报让块服务器下次补上
+        if (!request->full_report()) {
+            respond->set_request_full_report(true);
+            return grpc::Status::OK;
+        }
         chunk_server = std::make_shared<protos::ChunkServer>(info);
         if (!ChunkServerManager::GetInstance()->RegisterChunkServer(
                 chunk_server)) {
@@ -28,6 +41,7 @@ grpc::Status ChunkServerManagerServiceImpl::ReportChunkServer(
         } else {
             LOG(INFO) << "register chunk server";
         }
+        heartbeat_task->RenewChunkServerLease(info.location());
         return grpc::Status::OK;
     }
 
@@ -36,34 +50,69 @@ grpc::Status ChunkServerManagerServiceImpl::ReportChunkServer(
         return grpc::Status(grpc::StatusCode::UNKNOWN, "no chunk server");
     }
 
+    heartbeat_task->RenewChunkServerLease(info.location());
+
     // 需要新加到 master 里的
     absl::flat_hash_set<std::string> chunks_to_add;
     // 从 chunkserver 删掉
     absl::flat_hash_set<std::string> chunks_to_remove;
+    // 只有负载的汇报不携带数据块清单，不对比数据块，待删除的副本留到
+    // 下一次完整汇报
+    if (request->full_report()) {
+        // 主服务器删除的多余副本，例如转换为纠删码后的数据块副本
+        const auto pending_deletions =
+            ChunkServerManager::GetInstance()->TakePendingDeletions(
+                info.location());
 
-    for (const auto& chunk_handle :
-         request->chunk_server().stored_chunk_handles()) {
-        if (dfs::server::MetadataManager::GetInstance()->ExistFileChunkMetadata(
-                chunk_handle)) {
-            chunks_to_add.insert(chunk_handle);
-        } else {
-            // 当前 chunk 被 master 标记为删除，所以 chunkserver 之后可以删除他们
-            *respond->add_delete_chunk_handles() = chunk_handle;
+        for (const auto& chunk_handle :
+             request->chunk_server().stored_chunk_handles()) {
+            if (pending_deletions.contains(chunk_handle)) {
+                *respond->add_delete_chunk_handles() = chunk_handle;
+            } else if (dfs::server::MetadataManager::GetInstance()
+                           ->ExistFileChunkMetadata(chunk_handle)) {
+                chunks_to_add.insert(chunk_handle);
+            } else {
+                // 当前 chunk 被 master 标记为删除，所以 chunkserver
+                // 之后可以删除他们
+                *respond->add_delete_chunk_handles() = chunk_handle;
+            }
         }
-    }
 
-    for (const auto& chunk_handle : chunk_server->stored_chunk_handles()) {
-        if (chunks_to_add.contains(chunk_handle)) {
-            chunks_to_add.erase(chunk_handle);
-        } else {
-            chunks_to_remove.insert(chunk_handle);
+        for (const auto& chunk_handle : chunk_server->stored_chunk_handles()) {
+            if (chunks_to_add.contains(chunk_handle)) {
+                chunks_to_add.erase(chunk_handle);
+            } else {
+                chunks_to_remove.insert(chunk_handle);
+            }
         }
     }
 
     dfs::server::ChunkServerManager::GetInstance()->UpdateChunkServer(
-        info.location(), info.available_disk_mb(), chunks_to_add,
+        info.location(), info.available_disk_mb(), info.load(), chunks_to_add,
         chunks_to_remove);
 
+    // 主副本服务器上仍在写入的数据块，随汇报延长写租约，客户端不需要
+    // 在租约过期后重新申请
+    const uint64_t lease_expire_time = absl::ToUnixSeconds(
+        absl::Now() +
+        absl::Seconds(
+            dfs::common::ConfigManager::GetInstance()->GetLeaseTimeout()));
+    for (const auto& chunk_handle : request->writing_chunk_handles()) {
+        auto metadata_or =
+            MetadataManager::GetInstance()->GetFileChunkMetadata(chunk_handle);
+        if (!metadata_or.ok() ||
+            !(metadata_or.value().primary_location() == info.location())) {
+            continue;
+        }
+        if (MetadataManager::GetInstance()->ExtendLeaseMetadata(
+                chunk_handle, lease_expire_time)) {
+            auto extension = respond->add_lease_extensions();
+            extension->set_chunk_handle(chunk_handle);
+            extension->mutable_lease_expiration_time()->set_seconds(
+                lease_expire_time);
+        }
+    }
+
     return grpc::Status::OK;
 }
 
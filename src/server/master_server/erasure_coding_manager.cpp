@@ -0,0 +1,400 @@
+#include "src/server/master_server/erasure_coding_manager.h"
+
+#include <absl/time/clock.h>
+
+#include <algorithm>
+#include <map>
+
+#include "src/common/config_manager.h"
+#include "src/common/system_logger.h"
+
+namespace dfs {
+namespace server {
+
+using dfs::common::ConfigManager;
+using google::protobuf::util::FailedPreconditionError;
+using google::protobuf::util::InternalError;
+using google::protobuf::util::OkStatus;
+using google::protobuf::util::UnavailableError;
+using protos::ChunkServerLocation;
+using protos::FileChunkMetadata;
+using protos::StripeMetadata;
+using protos::grpc::EncodeStripeRequest;
+using protos::grpc::ReconstructChunkRequest;
+
+ErasureCodingManager::ErasureCodingManager() {
+    auto config_manager = ConfigManager::GetInstance();
+    data_shards_ =
+        std::max<uint32_t>(config_manager->GetErasureCodingDataShards(), 1);
+    parity_shards_ =
+        std::max<uint32_t>(config_manager->GetErasureCodingParityShards(), 1);
+    distinct_racks_ = config_manager->GetErasureCodingDistinctRacks();
+    chunk_server_manager_ = ChunkServerManager::GetInstance();
+    metadata_manager_ = MetadataManager::GetInstance();
+}
+
+ErasureCodingManager* ErasureCodingManager::GetInstance() {
+    static ErasureCodingManager* instance = new ErasureCodingManager();
+    return instance;
+}
+
+google::protobuf::util::Status ErasureCodingManager::ConvertToErasureCoded(
+    const std::string& filename) {
+    {
+        absl::MutexLock lock_guard(&lock_);
+        if (!converting_files_.insert(filename).second) {
+            return UnavailableError(filename + " is being converted");
+        }
+    }
+
+    auto status = ConvertFile(filename);
+
+    absl::MutexLock lock_guard(&lock_);
+    converting_files_.erase(filename);
+    return status;
+}
+
+google::protobuf::util::Status ErasureCodingManager::ConvertFile(
+    const std::string& filename) {
+    auto file_metadata_or = metadata_manager_->GetFileMetadata(filename);
+    if (!file_metadata_or.ok()) {
+        return file_metadata_or.status();
+    }
+
+    auto file_metadata = file_metadata_or.value();
+    if (file_metadata->storage_class() == protos::STORAGE_ERASURE_CODED) {
+        return OkStatus();
+    }
+
+    // 先冻结文件，此后的写入请求都会被拒绝
+    auto status = metadata_manager_->SetFileStorageClass(
+        filename, protos::STORAGE_ERASURE_CODED);
+    if (!status.ok()) {
+        return status;
+    }
+
+    status = EncodeFile(filename, *file_metadata);
+    if (!status.ok()) {
+        LOG(ERROR) << "convert " << filename
+                   << " to erasure coded failed, because "
+                   << status.ToString();
+        // 已经写入的校验块没有元数据，块服务器汇报时会被删除
+        metadata_manager_->SetFileStorageClass(filename,
+                                               protos::STORAGE_REPLICATED);
+    }
+    return status;
+}
+
+google::protobuf::util::Status ErasureCodingManager::EncodeFile(
+    const std::string& filename, const protos::FileMetadata& file_metadata) {
+    // 文件冻结后块索引不再变化
+    const std::map<uint32_t, std::string> chunk_handles(
+        file_metadata.chunk_handles().begin(),
+        file_metadata.chunk_handles().end());
+
+    // 有未过期的写租约说明文件正在被写入
+    for (const auto& chunk_pair : chunk_handles) {
+        auto lease_pair = metadata_manager_->GetLeaseMetadata(chunk_pair.second);
+        if (lease_pair.second &&
+            absl::FromUnixSeconds(lease_pair.first.expire_time) > absl::Now()) {
+            return FailedPreconditionError("chunk " + chunk_pair.second +
+                                           " of file " + filename +
+                                           " is being written");
+        }
+    }
+
+    std::vector<StripeMetadata> stripes;
+    std::vector<std::vector<ChunkServerLocation>> kept_locations;
+    std::vector<FileChunkMetadata> parity_metadatas;
+    const uint64_t chunk_nums =
+        chunk_handles.empty() ? 0 : uint64_t(chunk_handles.rbegin()->first) + 1;
+    for (uint64_t first = 0; first < chunk_nums; first += data_shards_) {
+        std::vector<std::string> data_handles(data_shards_);
+        bool has_data = false;
+        for (uint32_t i = 0; i < data_shards_; i++) {
+            auto iter = chunk_handles.find(first + i);
+            if (iter != chunk_handles.end()) {
+                data_handles[i] = iter->second;
+                has_data = true;
+            }
+        }
+        // 整个条带都没有数据块
+        if (!has_data) {
+            continue;
+        }
+
+        StripeMetadata stripe;
+        std::vector<ChunkServerLocation> stripe_kept_locations;
+        auto status = EncodeStripe(first, data_handles, &stripe,
+                                   &stripe_kept_locations, &parity_metadatas);
+        if (!status.ok()) {
+            return status;
+        }
+        stripes.push_back(stripe);
+        kept_locations.push_back(stripe_kept_locations);
+    }
+
+    // 所有条带编码成功后才记录校验块
+    for (const auto& metadata : parity_metadatas) {
+        metadata_manager_->SetFileChunkMetadata(metadata);
+        chunk_server_manager_->AddChunkLocation(metadata.chunk_handle(),
+                                                metadata.primary_location());
+    }
+    auto status = metadata_manager_->SetFileStripes(filename, stripes);
+    if (!status.ok()) {
+        return status;
+    }
+
+    // 每个数据块只保留一个副本，其余副本在块服务器下一次汇报时删除
+    uint32_t removed_replicas = 0;
+    for (size_t s = 0; s < stripes.size(); s++) {
+        for (uint32_t i = 0; i < data_shards_; i++) {
+            const auto& chunk_handle = stripes[s].chunk_handles(i);
+            if (chunk_handle.empty()) {
+                continue;
+            }
+
+            const auto& kept_location = kept_locations[s][i];
+            for (const auto& location :
+                 chunk_server_manager_->GetChunkLocation(chunk_handle)) {
+                if (!(location == kept_location)) {
+                    chunk_server_manager_->RemoveChunkReplica(chunk_handle,
+                                                              location);
+                    removed_replicas++;
+                }
+            }
+
+            auto metadata_or =
+                metadata_manager_->GetFileChunkMetadata(chunk_handle);
+            if (metadata_or.ok()) {
+                auto metadata = metadata_or.value();
+                *metadata.mutable_primary_location() = kept_location;
+                metadata_manager_->SetFileChunkMetadata(metadata);
+            }
+        }
+    }
+
+    LOG(INFO) << "convert " << filename << " to erasure coded, "
+              << stripes.size() << " stripes, " << parity_metadatas.size()
+              << " parity chunks, remove " << removed_replicas
+              << " data replicas";
+    return OkStatus();
+}
+
+google::protobuf::util::Status ErasureCodingManager::EncodeStripe(
+    uint32_t first_chunk_index, const std::vector<std::string>& data_handles,
+    StripeMetadata* stripe, std::vector<ChunkServerLocation>* kept_locations,
+    std::vector<FileChunkMetadata>* parity_metadatas) {
+    EncodeStripeRequest request;
+    request.set_data_shards(data_shards_);
+    request.set_parity_shards(parity_shards_);
+
+    kept_locations->assign(data_shards_, ChunkServerLocation());
+    // 条带中已经占用的块服务器与机架，每个分片必须位于不同的块服务器
+    ChunkServerLocationFlatSet used_locations;
+    absl::flat_hash_set<std::string> used_racks;
+    uint32_t first_data_shard = data_shards_;
+    for (uint32_t i = 0; i < data_shards_; i++) {
+        auto shard = request.add_data();
+        const auto& chunk_handle = data_handles[i];
+        if (chunk_handle.empty()) {
+            continue;
+        }
+        first_data_shard = std::min(first_data_shard, i);
+
+        auto metadata_or = metadata_manager_->GetFileChunkMetadata(chunk_handle);
+        if (!metadata_or.ok()) {
+            return metadata_or.status();
+        }
+        auto locations = chunk_server_manager_->GetChunkLocation(chunk_handle);
+        if (locations.empty()) {
+            return UnavailableError("chunk " + chunk_handle +
+                                    " has no live replica");
+        }
+
+        shard->set_chunk_handle(chunk_handle);
+        shard->set_version(metadata_or.value().version());
+        // 保留的副本必须与条带中其他分片位于不同的块服务器
+        bool kept = false;
+        for (const auto& location : locations) {
+            *shard->add_locations() = location;
+            if (kept || used_locations.contains(location)) {
+                continue;
+            }
+            const std::string rack =
+                chunk_server_manager_->GetChunkServerRack(location);
+            if (distinct_racks_ && used_racks.contains(rack)) {
+                continue;
+            }
+            (*kept_locations)[i] = location;
+            used_locations.insert(location);
+            used_racks.insert(rack);
+            kept = true;
+        }
+        if (!kept) {
+            return UnavailableError(
+                "no replica of chunk " + chunk_handle +
+                " is on a chunk server (rack) not used by the stripe");
+        }
+    }
+
+    auto parity_locations_or = ChooseParityLocations(
+        ChunkServerLocationFlatSetToVector(used_locations));
+    if (!parity_locations_or.ok()) {
+        return parity_locations_or.status();
+    }
+    const auto& parity_locations = parity_locations_or.value();
+    for (uint32_t i = 0; i < parity_shards_; i++) {
+        auto shard = request.add_parity();
+        shard->set_chunk_handle(metadata_manager_->CreateParityChunkHandle());
+        shard->set_version(1);
+        *shard->add_locations() = parity_locations[i];
+    }
+
+    // 由保存第一个数据块的块服务器计算校验块
+    const auto& coordinator = (*kept_locations)[first_data_shard];
+    const std::string coordinator_address =
+        ChunkServerLocationToString(coordinator);
+    auto client = chunk_server_manager_->GetOrCreateChunkServerFileServiceClient(
+        coordinator_address);
+    if (!client) {
+        return UnavailableError("can not get or create file service client, "
+                                "server_address: " +
+                                coordinator_address);
+    }
+
+    auto respond_or = client->SendRequest(request);
+    if (!respond_or.ok()) {
+        LOG(ERROR) << "encode stripe at chunk index " << first_chunk_index
+                   << " on " << coordinator_address << " failed, because "
+                   << respond_or.status().ToString();
+        return respond_or.status();
+    }
+
+    const auto& respond = respond_or.value();
+    if (respond.data_sizes_size() != static_cast<int>(data_shards_)) {
+        return InternalError("encode stripe respond has " +
+                             std::to_string(respond.data_sizes_size()) +
+                             " data sizes");
+    }
+
+    stripe->set_data_shards(data_shards_);
+    stripe->set_parity_shards(parity_shards_);
+    stripe->set_first_chunk_index(first_chunk_index);
+    for (uint32_t i = 0; i < data_shards_; i++) {
+        stripe->add_chunk_handles(data_handles[i]);
+        stripe->add_shard_sizes(respond.data_sizes(i));
+    }
+    for (uint32_t i = 0; i < parity_shards_; i++) {
+        stripe->add_chunk_handles(request.parity(i).chunk_handle());
+        stripe->add_shard_sizes(respond.parity_size());
+
+        FileChunkMetadata metadata;
+        metadata.set_chunk_handle(request.parity(i).chunk_handle());
+        metadata.set_version(1);
+        *metadata.mutable_primary_location() = parity_locations[i];
+        parity_metadatas->push_back(metadata);
+    }
+
+    return OkStatus();
+}
+
+google::protobuf::util::StatusOr<std::vector<ChunkServerLocation>>
+ErasureCodingManager::ChooseParityLocations(
+    const std::vector<ChunkServerLocation>& data_locations) {
+    auto locations = chunk_server_manager_->ChooseChunkServers(
+        parity_shards_, data_locations, distinct_racks_);
+    // 与数据块位于同一块服务器的校验块无法在该块服务器故障时恢复数据
+    if (locations.size() < parity_shards_) {
+        return UnavailableError(
+            "need " + std::to_string(data_shards_ + parity_shards_) +
+            " distinct chunk servers" + (distinct_racks_ ? " (racks)" : "") +
+            " for a stripe, only " +
+            std::to_string(data_locations.size() + locations.size()) +
+            " available");
+    }
+    return locations;
+}
+
+google::protobuf::util::StatusOr<uint64_t>
+ErasureCodingManager::ReconstructChunk(const std::string& chunk_handle) {
+    auto chunk_stripe_or = metadata_manager_->GetChunkStripe(chunk_handle);
+    if (!chunk_stripe_or.ok()) {
+        return chunk_stripe_or.status();
+    }
+    const auto& chunk_stripe = chunk_stripe_or.value();
+    const auto& stripe = chunk_stripe.stripe;
+
+    auto file_metadata_or =
+        metadata_manager_->GetFileMetadata(chunk_stripe.filename);
+    if (!file_metadata_or.ok()) {
+        return file_metadata_or.status();
+    }
+
+    ReconstructChunkRequest request;
+    request.set_data_shards(stripe.data_shards());
+    request.set_parity_shards(stripe.parity_shards());
+    request.set_shard_index(chunk_stripe.shard_index);
+    request.set_codec(file_metadata_or.value()->codec());
+
+    std::vector<ChunkServerLocation> stripe_locations;
+    for (int i = 0; i < stripe.chunk_handles_size(); i++) {
+        auto shard = request.add_shards();
+        const auto& shard_handle = stripe.chunk_handles(i);
+        if (shard_handle.empty()) {
+            continue;
+        }
+
+        auto metadata_or = metadata_manager_->GetFileChunkMetadata(shard_handle);
+        if (!metadata_or.ok()) {
+            return metadata_or.status();
+        }
+        shard->set_chunk_handle(shard_handle);
+        shard->set_version(metadata_or.value().version());
+        shard->set_size(stripe.shard_sizes(i));
+        for (const auto& location :
+             chunk_server_manager_->GetChunkLocation(shard_handle)) {
+            *shard->add_locations() = location;
+            stripe_locations.push_back(location);
+        }
+    }
+
+    // 重建的分片只能放在条带以外的块服务器上
+    auto destinations = chunk_server_manager_->ChooseChunkServers(
+        1, stripe_locations, distinct_racks_);
+    if (destinations.empty()) {
+        return UnavailableError("no chunk server to reconstruct chunk " +
+                                chunk_handle);
+    }
+
+    const auto& destination = destinations[0];
+    const std::string destination_address =
+        ChunkServerLocationToString(destination);
+    auto client = chunk_server_manager_->GetOrCreateChunkServerFileServiceClient(
+        destination_address);
+    if (!client) {
+        return UnavailableError("can not get or create file service client, "
+                                "server_address: " +
+                                destination_address);
+    }
+
+    LOG(INFO) << "reconstruct chunk " << chunk_handle << " (shard "
+              << chunk_stripe.shard_index << " of file "
+              << chunk_stripe.filename << ") on " << destination_address;
+    auto respond_or = client->SendRequest(request);
+    if (!respond_or.ok()) {
+        return respond_or.status();
+    }
+
+    chunk_server_manager_->AddChunkLocation(chunk_handle, destination);
+    auto metadata_or = metadata_manager_->GetFileChunkMetadata(chunk_handle);
+    if (metadata_or.ok()) {
+        auto metadata = metadata_or.value();
+        *metadata.mutable_primary_location() = destination;
+        metadata_manager_->SetFileChunkMetadata(metadata);
+    }
+    return respond_or.value().chunk_size();
+}
+
+}  // namespace server
+}  // namespace dfs
@@ -0,0 +1,94 @@
+#ifndef DFS_SERVER_MASTER_SERVER_ERASURE_CODING_MANAGER_H
+#define DFS_SERVER_MASTER_SERVER_ERASURE_CODING_MANAGER_H
+
+#include <absl/container/flat_hash_set.h>
+#include <absl/synchronization/mutex.h>
+
+#include <string>
+#include <vector>
+
+#include "google/protobuf/stubs/status.h"
+#include "google/protobuf/stubs/statusor.h"
+#include "metadata.pb.h"
+#include "src/server/master_server/chunk_server_manager.h"
+#include "src/server/master_server/metadata_manager.h"
+
+namespace dfs {
+namespace server {
+
+/**
+ * 纠删码存储
+ * 1. 文件中连续的 data_shards 个数据块组成一个条带，由块服务器计算
+ *    parity_shards 个校验块。条带的每个分片位于不同的块服务器（配置
+ *    distinct_racks 时位于不同的机架），块服务器不足时不转换
+ * 2. 转换完成后每个数据块只保留一个副本，多余的副本在块服务器下一次
+ *    汇报时删除；转换期间文件只读，有未过期的写租约时不转换
+ * 3. 数据块或校验块丢失后，由副本复制调度选择新的块服务器，读取条带中
+ *    其他 data_shards 个分片重建
+ */
+class ErasureCodingManager {
+   public:
+    static ErasureCodingManager* GetInstance();
+
+    // 将多副本文件转换为纠删码文件，已经是纠删码文件时直接返回
+    google::protobuf::util::Status ConvertToErasureCoded(
+        const std::string& filename);
+
+    // 在新的块服务器上重建纠删码文件中丢失的数据块或校验块，返回重建的
+    // 长度。存活的分片不足时返回 DataLoss
+    google::protobuf::util::StatusOr<uint64_t> ReconstructChunk(
+        const std::string& chunk_handle);
+
+    uint32_t data_shards() const { return data_shards_; }
+
+    uint32_t parity_shards() const { return parity_shards_; }
+
+    bool distinct_racks() const { return distinct_racks_; }
+
+   private:
+    ErasureCodingManager();
+
+    // 冻结文件并编码，失败时恢复为多副本文件
+    google::protobuf::util::Status ConvertFile(const std::string& filename);
+
+    // 对文件的每个条带编码，成功后记录条带并删除多余的数据块副本
+    google::protobuf::util::Status EncodeFile(
+        const std::string& filename, const protos::FileMetadata& file_metadata);
+
+    // 对块索引从 first_chunk_index 开始的一个条带编码，data_handles 中不存在
+    // 的数据块为空字符串。kept_locations 为每个数据块保留副本的块服务器，
+    // parity_metadatas 为校验块的元数据
+    google::protobuf::util::Status EncodeStripe(
+        uint32_t first_chunk_index,
+        const std::vector<std::string>& data_handles,
+        protos::StripeMetadata* stripe,
+        std::vector<protos::ChunkServerLocation>* kept_locations,
+        std::vector<protos::FileChunkMetadata>* parity_metadatas);
+
+    // 为校验块选择条带中数据块以外的块服务器，开启 distinct_racks 时也在
+    // 不同的机架上。块服务器不足时返回 Unavailable，分片不会放在同一块服务器
+    google::protobuf::util::StatusOr<std::vector<protos::ChunkServerLocation>>
+    ChooseParityLocations(
+        const std::vector<protos::ChunkServerLocation>& data_locations);
+
+    uint32_t data_shards_;
+
+    uint32_t parity_shards_;
+
+    // 条带的所有分片是否必须位于不同的机架
+    bool distinct_racks_;
+
+    absl::Mutex lock_;
+
+    // 正在转换的文件
+    absl::flat_hash_set<std::string> converting_files_;
+
+    ChunkServerManager* chunk_server_manager_;
+
+    MetadataManager* metadata_manager_;
+};
+
+}  // namespace server
+}  // namespace dfs
+
+#endif  // DFS_SERVER_MASTER_SERVER_ERASURE_CODING_MANAGER_H
@@ -1,11 +1,18 @@
 #include "src/server/master_server/master_metadata_service_impl.h"
 
+#include <absl/container/flat_hash_map.h>
+
+#include "src/common/config_manager.h"
+#include "src/common/metrics.h"
 #include "src/common/system_logger.h"
 #include "src/common/utils.h"
+#include "src/server/master_server/chunk_replica_manager.h"
+#include "src/server/master_server/erasure_coding_manager.h"
 
 namespace dfs {
 namespace server {
 
+using dfs::common::ConfigManager;
 using dfs::common::StatusProtobuf2Grpc;
 using dfs::grpc_client::ChunkServerFileServiceClient;
 using protos::grpc::AdjustFileChunkVersionRequest;
@@ -13,6 +20,7 @@ using protos::grpc::AdjustFileChunkVersionRespond;
 using protos::grpc::GrantLeaseRequest;
 using protos::grpc::GrantLeaseRespond;
 using protos::grpc::InitFileChunkRequest;
+using protos::grpc::RevokeLeaseRequest;
 
 MasterMetadataServiceImpl::MasterMetadataServiceImpl() {
     chunk_server_manager_ = ChunkServerManager::GetInstance();
@@ -34,7 +42,8 @@ grpc::Status MasterMetadataServiceImpl::HandleFileCreation(
     }
 
     //
-    auto status = metadata_manager_->CreateFileMetadata(filename);
+    auto status =
+        metadata_manager_->CreateFileMetadata(filename, request->codec());
     if (!status.ok()) {
         LOG(ERROR) << "can't create file metadata, err msg: "
                    << status.message();
@@ -59,8 +68,8 @@ grpc::Status MasterMetadataServiceImpl::HandleFileChunkRead(
     // get the filename, chunk_index
     const std::string& filename = request->filename();
     const uint32_t chunk_index = request->chunk_index();
-    LOG(INFO) << "Handle file read: " << filename
-              << " chunk idx: " << chunk_index;
+    DFS_VLOG(1) << "Handle file read: " << filename
+                << " chunk idx: " << chunk_index;
 
     //
     if (!metadata_manager_->ExistFileMetadata(filename)) {
@@ -69,6 +78,7 @@ grpc::Status MasterMetadataServiceImpl::HandleFileChunkRead(
         return grpc::Status(grpc::StatusCode::NOT_FOUND,
                             "file does not exists ");
     }
+    metadata_manager_->TouchFile(filename);
 
     // get the chunk handle, uuid
     auto chunk_handle_or =
@@ -99,6 +109,13 @@ grpc::Status MasterMetadataServiceImpl::HandleFileChunkRead(
 
     if (respond->metadata().locations().empty()) {
         LOG(ERROR) << "no chunk server to chunk handle: " << chunk_handle;
+        // 纠删码文件的分片只有一份，丢失后立即安排重建
+        if (metadata_manager_->IsErasureCodedChunk(chunk_handle)) {
+            ChunkReplicaManager::GetInstance()->AddChunkReplicaTask(
+                chunk_handle, 0);
+            return grpc::Status(grpc::StatusCode::UNAVAILABLE,
+                                "chunk is being reconstructed");
+        }
         return grpc::Status(grpc::StatusCode::UNAVAILABLE,
                             "no chunk server is available");
     }
@@ -117,12 +134,17 @@ grpc::Status MasterMetadataServiceImpl::HandleFileChunkWrite(
      * 主副本服务器在客户端写入数据后，会去同步其他副本服务器的数据，调整版本，更新数据等。
      */
 
-    auto start = std::chrono::high_resolution_clock::now();  // 记录开始时间
+    static auto latency =
+        dfs::common::MetricsRegistry::GetInstance()->GetHistogram(
+            "dfs_master_chunk_write_latency_seconds",
+            "Latency of handling write requests for file chunks");
+    dfs::common::ScopedLatency latency_recorder(latency);
+
     // get the filename, chunk_index
     const std::string& filename = request->filename();
     const uint32_t chunk_index = request->chunk_index();
-    LOG(INFO) << "Handle file write: " << filename
-              << " chunk idx: " << chunk_index;
+    DFS_VLOG(1) << "Handle file write: " << filename
+                << " chunk idx: " << chunk_index;
 
     // 确保文件已经被创建
     if (!metadata_manager_->ExistFileMetadata(filename) &&
@@ -133,6 +155,17 @@ grpc::Status MasterMetadataServiceImpl::HandleFileChunkWrite(
                             "file does not exists");
     }
 
+    // 纠删码文件只读，转换期间也不允许写入
+    auto file_metadata_or = metadata_manager_->GetFileMetadata(filename);
+    if (file_metadata_or.ok() && file_metadata_or.value()->storage_class() ==
+                                     protos::STORAGE_ERASURE_CODED) {
+        LOG(ERROR) << "HandleFileChunkWrite: " << filename
+                   << " is erasure coded, can not write";
+        return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION,
+                            "erasure coded file is read only");
+    }
+    metadata_manager_->TouchFile(filename);
+
     auto chunk_handle_or =
         metadata_manager_->GetChunkHandle(filename, chunk_index);
     if (!chunk_handle_or.ok()) {
@@ -166,9 +199,6 @@ grpc::Status MasterMetadataServiceImpl::HandleFileChunkWrite(
 
     const std::string& chunk_handle = chunk_handle_or.value();
 
-    // 当前租约已分配
-    bool lease_granted = false;
-
     auto file_chunk_metadata_or =
         metadata_manager_->GetFileChunkMetadata(chunk_handle);
     if (!file_chunk_metadata_or.ok()) {
@@ -182,87 +212,23 @@ grpc::Status MasterMetadataServiceImpl::HandleFileChunkWrite(
         file_chunk_metadata_or.value();
     const auto chunk_version = file_chunk_metadata.version();
 
-    // try to get lease
-    auto lease_result_pair = metadata_manager_->GetLeaseMetadata(chunk_handle);
-    if (lease_result_pair.second) {
-        // 说明存在 chunk_handle 对应的租约
-        if (absl::FromUnixSeconds(lease_result_pair.first.second) >
-            absl::Now()) {
-            if (context->peer() == lease_result_pair.first.first) {
-                // 当前租约仍有效
-                LOG(INFO) << "lease " << chunk_handle << " is ok";
-                lease_granted = true;
-            } else {
-                // 被其他客户端拿到租约了
-                LOG(INFO) << "other guy get the lease";
-                return grpc::Status(grpc::StatusCode::UNKNOWN,
-                                    "other guy get the lease");
-            }
-        } else {
-            // 租约过期了
-            LOG(INFO) << "lease " << chunk_handle << " is expired";
-            metadata_manager_->RemoveLeaseMetadata(chunk_handle);
-        }
+    // 按客户端会话获取租约，同一客户端的不同连接共享租约
+    const LeaseMetadata lease = MakeClientLease(context, request);
+    auto lease_granted_or =
+        metadata_manager_->AcquireLeaseMetadata(chunk_handle, lease);
+    if (!lease_granted_or.ok()) {
+        LOG(INFO) << "can not get lease " << chunk_handle << " for client "
+                  << lease.client_id << ", because "
+                  << lease_granted_or.status().ToString();
+        return StatusProtobuf2Grpc(lease_granted_or.status());
     }
 
-    if (!lease_granted) {
-        // 需要分配新的租约
-        const std::string primary_server_address =
-            std::move(ChunkServerLocationToString(
-                file_chunk_metadata.primary_location()));
-
-        if (primary_server_address.size() < 3) {
-            LOG(ERROR) << "get chunk metadata primary location error";
-            return grpc::Status(grpc::StatusCode::UNKNOWN,
-                                "get chunk metadata primary location error");
-        }
-
-        auto lease_client =
-            chunk_server_manager_->GetOrCreateChunkServerLeaseServiceClient(
-                primary_server_address);
-        if (!lease_client) {
-            LOG(ERROR) << "can not talk to " << primary_server_address
-                       << " lease service";
-            return grpc::Status(grpc::StatusCode::UNKNOWN,
-                                "can not talk to lease service");
-        }
-
-        LOG(INFO) << "try to talk to primary server: "
-                  << primary_server_address;
-
-        // ok
-        GrantLeaseRequest lease_req;
-        lease_req.set_chunk_handle(chunk_handle);
-        lease_req.set_chunk_version(chunk_version);
-        // TODO: use config
-        uint64_t next_expire_time =
-            absl::ToUnixSeconds(absl::Now() + absl::Seconds(60));
-        lease_req.mutable_lease_expiration_time()->set_seconds(
-            next_expire_time);
-
-        auto lease_respond = lease_client->SendRequest(lease_req);
-        if (lease_respond.ok()) {
-            if (lease_respond.value().status() == GrantLeaseRespond::ACCEPTED) {
-                LOG(INFO) << "get lease ok, status: "
-                          << lease_respond.value().status();
-                metadata_manager_->SetLeaseMetadata(
-                    chunk_handle, context->peer(), next_expire_time);
-                lease_granted = true;
-            } else {
-                LOG(ERROR) << "can not get lease from primary server, because "
-                              "not ok, status: "
-                           << lease_respond.value().status();
-            }
-        } else {
-            LOG(ERROR) << "can not get lease from primary server, because "
-                       << lease_respond.status().ToString();
-        }
-    }
-
-    if (!lease_granted) {
+    if (!lease_granted_or.value() &&
+        !GrantLeaseBatch(lease, filename, chunk_index, file_chunk_metadata)) {
         // 这说明上面租约分配有问题
         // 没有租约，禁止写入数据
         LOG(ERROR) << "can not grant lease for " << chunk_handle;
+        metadata_manager_->ReleaseLeaseMetadata(chunk_handle, lease);
         return grpc::Status(grpc::StatusCode::UNKNOWN,
                             "can not grant lease for " + chunk_handle);
     }
@@ -300,11 +266,11 @@ grpc::Status MasterMetadataServiceImpl::HandleFileChunkWrite(
     }
 
     // get the chunk handle
-    LOG(INFO) << "wirte: try to get chunk handle " << chunk_handle
-              << " metadata";
+    DFS_VLOG(2) << "wirte: try to get chunk handle " << chunk_handle
+                << " metadata";
     auto new_chunk_version = chunk_version + 1;
-    LOG(INFO) << "respond metadata chunk_handle: "
-              << file_chunk_metadata.chunk_handle();
+    DFS_VLOG(2) << "respond metadata chunk_handle: "
+                << file_chunk_metadata.chunk_handle();
 
     respond->mutable_metadata()->set_chunk_handle(
         file_chunk_metadata.chunk_handle());
@@ -316,12 +282,6 @@ grpc::Status MasterMetadataServiceImpl::HandleFileChunkWrite(
         *respond->mutable_metadata()->add_locations() = location;
     }
 
-    auto end = std::chrono::high_resolution_clock::now();  // 记录结束时间
-    double durationMs =
-        std::chrono::duration_cast<std::chrono::milliseconds>(end - start)
-            .count();
-    LOG(INFO) << "HandleFileChunkWrite: " << durationMs << " ms";
-
     return grpc::Status::OK;
 }
 
@@ -356,12 +316,19 @@ grpc::Status MasterMetadataServiceImpl::HandleFileChunkCreation(
                          chunk_index);
     }
 
+    // 数据块使用文件的压缩算法
+    auto file_metadata_or = metadata_manager_->GetFileMetadata(filename);
+    const protos::ChunkCodec codec = file_metadata_or.ok()
+                                         ? file_metadata_or.value()->codec()
+                                         : protos::CODEC_NONE;
+
     // get chunk_handle
     const auto& chunk_handle = chunk_handle_or.value();
 
     // TODO: assign chunk servers to store this chunk
     auto chunk_server_locations = ChunkServerLocationFlatSetToVector(
-        chunk_server_manager_->AssignChunkServer(chunk_handle, 3));
+        chunk_server_manager_->AssignChunkServer(
+            chunk_handle, ConfigManager::GetInstance()->GetChunkReplicaNums()));
 
     LOG(INFO) << "assign " << chunk_server_locations.size()
               << " chunk server to store chunk handle " << chunk_handle;
@@ -389,6 +356,12 @@ grpc::Status MasterMetadataServiceImpl::HandleFileChunkCreation(
     *respond->mutable_metadata()->mutable_primary_location() =
         chunk_server_locations[0];
 
+    // 写入时创建的数据块，由主副本服务器在创建时直接授予写租约
+    const bool grant_lease =
+        request->mode() == protos::grpc::OpenFileRequest::WRITE;
+    LeaseMetadata lease = MakeClientLease(context, request);
+    bool lease_granted = false;
+
     // TODO: talk to chunk server
     for (const auto& location :
          chunk_server_manager_->GetChunkLocation(chunk_handle)) {
@@ -402,6 +375,13 @@ grpc::Status MasterMetadataServiceImpl::HandleFileChunkCreation(
         // set up request, and send request
         InitFileChunkRequest request;
         request.set_chunk_handle(chunk_handle);
+        request.set_codec(codec);
+        const bool is_primary =
+            grant_lease && location == chunk_server_locations[0];
+        if (is_primary) {
+            request.mutable_lease_expiration_time()->set_seconds(
+                lease.expire_time);
+        }
         auto init_chunk_or = client->SendRequest(request);
 
         if (!init_chunk_or.ok()) {
@@ -409,6 +389,7 @@ grpc::Status MasterMetadataServiceImpl::HandleFileChunkCreation(
             return StatusProtobuf2Grpc(init_chunk_or.status());
         } else {
             LOG(INFO) << "InitFileChunkRequest is ok";
+            lease_granted = lease_granted || is_primary;
         }
 
         // ok
@@ -422,6 +403,11 @@ grpc::Status MasterMetadataServiceImpl::HandleFileChunkCreation(
                             "no chunk server is available");
     }
 
+    if (lease_granted) {
+        lease.granted = true;
+        metadata_manager_->SetLeaseMetadata(chunk_handle, lease);
+    }
+
     auto get_chunk_handle_or =
         metadata_manager_->GetChunkHandle(filename, chunk_index);
     if (!get_chunk_handle_or.ok()) {
@@ -437,7 +423,7 @@ grpc::Status MasterMetadataServiceImpl::HandleFileChunkCreation(
 grpc::Status MasterMetadataServiceImpl::OpenFile(
     grpc::ServerContext* context, const protos::grpc::OpenFileRequest* request,
     protos::grpc::OpenFileRespond* respond) {
-    LOG(INFO) << "OpenFile: client url " << context->peer();
+    DFS_VLOG(2) << "OpenFile: client url " << context->peer();
     switch (request->mode()) {
         case protos::grpc::OpenFileRequest::CREATE:
             return HandleFileCreation(context, request, respond);
@@ -458,9 +444,200 @@ grpc::Status MasterMetadataServiceImpl::DeleteFile(
     // get filename from request
     const std::string& filename = request->filename();
     LOG(INFO) << "Delete file: " << filename;
+
+    // 先撤销租约，避免客户端继续写入即将删除的数据块
+    auto file_metadata_or = metadata_manager_->GetFileMetadata(filename);
+    if (file_metadata_or.ok()) {
+        std::vector<std::string> chunk_handles;
+        for (const auto& chunk_pair : file_metadata_or.value()->chunk_handles()) {
+            chunk_handles.push_back(chunk_pair.second);
+        }
+        RevokeLeases(chunk_handles);
+    }
+
     metadata_manager_->DeleteFileAndChunkMetadata(filename);
     return grpc::Status::OK;
 }
 
+grpc::Status MasterMetadataServiceImpl::SetStorageClass(
+    grpc::ServerContext* context,
+    const protos::grpc::SetStorageClassRequest* request,
+    google::protobuf::Empty* respond) {
+    const std::string& filename = request->filename();
+    LOG(INFO) << "Set storage class of " << filename << " to "
+              << protos::StorageClass_Name(request->storage_class());
+
+    auto file_metadata_or = metadata_manager_->GetFileMetadata(filename);
+    if (!file_metadata_or.ok()) {
+        return StatusProtobuf2Grpc(file_metadata_or.status());
+    }
+
+    switch (request->storage_class()) {
+        case protos::STORAGE_ERASURE_CODED:
+            return StatusProtobuf2Grpc(
+                ErasureCodingManager::GetInstance()->ConvertToErasureCoded(
+                    filename));
+        case protos::STORAGE_REPLICATED:
+            // 纠删码文件不支持转换回多副本文件
+            if (file_metadata_or.value()->storage_class() !=
+                protos::STORAGE_REPLICATED) {
+                return grpc::Status(grpc::StatusCode::UNIMPLEMENTED,
+                                    "can not convert erasure coded file back "
+                                    "to replicated");
+            }
+            return grpc::Status::OK;
+        default:
+            return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                                "unknown storage class");
+    }
+}
+
+LeaseMetadata MasterMetadataServiceImpl::MakeClientLease(
+    grpc::ServerContext* context,
+    const protos::grpc::OpenFileRequest* request) {
+    LeaseMetadata lease;
+    lease.client_id = request->client_id().empty() ? context->peer()
+                                                   : request->client_id();
+    lease.session_epoch = request->session_epoch();
+    lease.expire_time = absl::ToUnixSeconds(
+        absl::Now() +
+        absl::Seconds(ConfigManager::GetInstance()->GetLeaseTimeout()));
+    return lease;
+}
+
+bool MasterMetadataServiceImpl::GrantLeaseBatch(
+    const LeaseMetadata& lease, const std::string& filename,
+    uint32_t chunk_index, const protos::FileChunkMetadata& file_chunk_metadata) {
+    const std::string primary_server_address =
+        ChunkServerLocationToString(file_chunk_metadata.primary_location());
+    if (primary_server_address.size() < 3) {
+        LOG(ERROR) << "get chunk metadata primary location error";
+        return false;
+    }
+
+    auto lease_client =
+        chunk_server_manager_->GetOrCreateChunkServerLeaseServiceClient(
+            primary_server_address);
+    if (!lease_client) {
+        LOG(ERROR) << "can not talk to " << primary_server_address
+                   << " lease service";
+        return false;
+    }
+
+    GrantLeaseRequest lease_req;
+    lease_req.set_chunk_handle(file_chunk_metadata.chunk_handle());
+    lease_req.set_chunk_version(file_chunk_metadata.version());
+    lease_req.mutable_lease_expiration_time()->set_seconds(lease.expire_time);
+
+    // 后续的数据块已经存在（例如覆盖写），一起申请租约。只申请该会话
+    // 新记录的租约，其他客户端持有租约的数据块跳过
+    const uint32_t batch_chunks =
+        ConfigManager::GetInstance()->GetLeaseBatchChunks();
+    for (uint32_t i = 1; i < batch_chunks; i++) {
+        auto chunk_handle_or =
+            metadata_manager_->GetChunkHandle(filename, chunk_index + i);
+        if (!chunk_handle_or.ok()) {
+            break;
+        }
+        auto metadata_or =
+            metadata_manager_->GetFileChunkMetadata(chunk_handle_or.value());
+        if (!metadata_or.ok() || !(metadata_or.value().primary_location() ==
+                                   file_chunk_metadata.primary_location())) {
+            continue;
+        }
+        auto granted_or = metadata_manager_->AcquireLeaseMetadata(
+            chunk_handle_or.value(), lease);
+        if (!granted_or.ok() || granted_or.value()) {
+            continue;
+        }
+        auto lease_chunk = lease_req.add_batch();
+        lease_chunk->set_chunk_handle(chunk_handle_or.value());
+        lease_chunk->set_chunk_version(metadata_or.value().version());
+    }
+
+    LOG(INFO) << "try to talk to primary server: " << primary_server_address
+              << ", grant lease for " << lease_req.batch_size() + 1
+              << " chunks";
+    auto lease_respond = lease_client->SendRequest(lease_req);
+    if (!lease_respond.ok()) {
+        LOG(ERROR) << "can not get lease from primary server, because "
+                   << lease_respond.status().ToString();
+        for (const auto& lease_chunk : lease_req.batch()) {
+            metadata_manager_->ReleaseLeaseMetadata(lease_chunk.chunk_handle(),
+                                                    lease);
+        }
+        return false;
+    }
+
+    const auto& respond = lease_respond.value();
+    for (int i = 0; i < lease_req.batch_size(); i++) {
+        const auto& chunk_handle = lease_req.batch(i).chunk_handle();
+        if (i < respond.batch_status_size() &&
+            respond.batch_status(i) == GrantLeaseRespond::ACCEPTED) {
+            metadata_manager_->MarkLeaseGranted(chunk_handle, lease);
+        } else {
+            metadata_manager_->ReleaseLeaseMetadata(chunk_handle, lease);
+        }
+    }
+
+    if (respond.status() != GrantLeaseRespond::ACCEPTED) {
+        LOG(ERROR) << "can not get lease from primary server, because "
+                      "not ok, status: "
+                   << respond.status();
+        return false;
+    }
+
+    LOG(INFO) << "get lease ok, status: " << respond.status();
+    metadata_manager_->MarkLeaseGranted(file_chunk_metadata.chunk_handle(),
+                                        lease);
+    return true;
+}
+
+void MasterMetadataServiceImpl::RevokeLeases(
+    const std::vector<std::string>& chunk_handles) {
+    // <primary server address, request>
+    absl::flat_hash_map<std::string, RevokeLeaseRequest> revoke_requests;
+    const absl::Time now = absl::Now();
+    for (const auto& chunk_handle : chunk_handles) {
+        auto lease_pair = metadata_manager_->GetLeaseMetadata(chunk_handle);
+        if (!lease_pair.second) {
+            continue;
+        }
+        metadata_manager_->RemoveLeaseMetadata(chunk_handle);
+        if (absl::FromUnixSeconds(lease_pair.first.expire_time) <= now) {
+            continue;
+        }
+
+        auto metadata_or = metadata_manager_->GetFileChunkMetadata(chunk_handle);
+        if (!metadata_or.ok()) {
+            continue;
+        }
+        revoke_requests[ChunkServerLocationToString(
+                            metadata_or.value().primary_location())]
+            .add_chunk_handles(chunk_handle);
+    }
+
+    for (const auto& request_pair : revoke_requests) {
+        auto lease_client =
+            chunk_server_manager_->GetOrCreateChunkServerLeaseServiceClient(
+                request_pair.first);
+        if (!lease_client) {
+            continue;
+        }
+        auto respond_or = lease_client->SendRequest(request_pair.second);
+        if (!respond_or.ok()) {
+            // 块服务器上的租约会自然过期
+            LOG(WARNING) << "revoke " << request_pair.second.chunk_handles_size()
+                         << " leases on " << request_pair.first
+                         << " failed, because "
+                         << respond_or.status().ToString();
+        } else {
+            LOG(INFO) << "revoke "
+                      << respond_or.value().revoked_chunk_handles_size()
+                      << " leases on " << request_pair.first;
+        }
+    }
+}
+
 }  // namespace server
 }  // namespace dfs
\ No newline at end of file
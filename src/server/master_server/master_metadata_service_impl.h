@@ -1,6 +1,9 @@
 #ifndef DFS_SERVER_MASTER_METADATA_SERVICE_IMPL_H
 #define DFS_SERVER_MASTER_METADATA_SERVICE_IMPL_H
 
+#include <string>
+#include <vector>
+
 #include "master_metadata_service.grpc.pb.h"
 #include "src/server/master_server/chunk_server_manager.h"
 #include "src/server/master_server/metadata_manager.h"
@@ -13,6 +16,20 @@ class MasterMetadataServiceImpl final
    public:
     MasterMetadataServiceImpl();
 
+    grpc::Status OpenFile(grpc::ServerContext* context,
+                          const protos::grpc::OpenFileRequest* request,
+                          protos::grpc::OpenFileRespond* respond) override;
+
+    grpc::Status DeleteFile(grpc::ServerContext* context,
+                            const protos::grpc::DeleteFileRequest* request,
+                            google::protobuf::Empty* respond) override;
+
+    // 将文件转换为纠删码存储，纠删码文件不能转换回多副本，返回 UNIMPLEMENTED
+    grpc::Status SetStorageClass(
+        grpc::ServerContext* context,
+        const protos::grpc::SetStorageClassRequest* request,
+        google::protobuf::Empty* respond) override;
+
    protected:
     grpc::Status HandleFileCreation(
         grpc::ServerContext* context,
@@ -34,13 +51,19 @@ class MasterMetadataServiceImpl final
         const protos::grpc::OpenFileRequest* request,
         protos::grpc::OpenFileRespond* respond);
 
-    grpc::Status OpenFile(grpc::ServerContext* context,
-                          const protos::grpc::OpenFileRequest* request,
-                          protos::grpc::OpenFileRespond* respond) override;
+    // 请求所属的客户端会话的新租约，到期时间从现在开始计算
+    LeaseMetadata MakeClientLease(grpc::ServerContext* context,
+                                  const protos::grpc::OpenFileRequest* request);
 
-    grpc::Status DeleteFile(grpc::ServerContext* context,
-                            const protos::grpc::DeleteFileRequest* request,
-                            google::protobuf::Empty* respond);
+    // 向主副本服务器申请 lease 已经记录的数据块写租约，同时申请该文件
+    // 后续 batch_chunks 个主副本服务器相同且没有租约的数据块，顺序写入时
+    // 不需要再次申请。返回当前数据块是否获得租约
+    bool GrantLeaseBatch(const LeaseMetadata& lease,
+                         const std::string& filename, uint32_t chunk_index,
+                         const protos::FileChunkMetadata& file_chunk_metadata);
+
+    // 撤销数据块的写租约，按主副本服务器分批发送
+    void RevokeLeases(const std::vector<std::string>& chunk_handles);
 
     ChunkServerManager* chunk_server_manager_;
 
@@ -0,0 +1,75 @@
+#include "src/server/master_server/master_server_async_services.h"
+
+namespace dfs {
+namespace server {
+
+using dfs::common::AsyncServerRuntime;
+using protos::grpc::ChunkServerManagerService;
+using protos::grpc::MasterMetadataService;
+using ExecutorType = AsyncServerRuntime::ExecutorType;
+
+class MasterServerAsyncServices::AsyncChunkServerManagerService final
+    : public ChunkServerManagerService::AsyncService {
+   public:
+    explicit AsyncChunkServerManagerService(
+        ChunkServerManagerServiceImpl* impl)
+        : impl_(impl) {}
+
+    void RegisterMethods(AsyncServerRuntime* runtime) {
+        runtime->RegisterUnaryMethod(
+            "ReportChunkServer", this,
+            &AsyncChunkServerManagerService::RequestReportChunkServer, impl_,
+            &ChunkServerManagerServiceImpl::ReportChunkServer,
+            ExecutorType::INLINE);
+    }
+
+   private:
+    ChunkServerManagerServiceImpl* impl_;
+};
+
+class MasterServerAsyncServices::AsyncMetadataService final
+    : public MasterMetadataService::AsyncService {
+   public:
+    explicit AsyncMetadataService(MasterMetadataServiceImpl* impl)
+        : impl_(impl) {}
+
+    void RegisterMethods(AsyncServerRuntime* runtime) {
+        runtime->RegisterUnaryMethod(
+            "OpenFile", this, &AsyncMetadataService::RequestOpenFile, impl_,
+            &MasterMetadataServiceImpl::OpenFile, ExecutorType::NETWORK);
+        runtime->RegisterUnaryMethod(
+            "DeleteFile", this, &AsyncMetadataService::RequestDeleteFile, impl_,
+            &MasterMetadataServiceImpl::DeleteFile, ExecutorType::NETWORK);
+        // 转换存储方式需要块服务器计算校验块
+        runtime->RegisterUnaryMethod(
+            "SetStorageClass", this,
+            &AsyncMetadataService::RequestSetStorageClass, impl_,
+            &MasterMetadataServiceImpl::SetStorageClass, ExecutorType::NETWORK);
+    }
+
+   private:
+    MasterMetadataServiceImpl* impl_;
+};
+
+MasterServerAsyncServices::MasterServerAsyncServices(
+    ChunkServerManagerServiceImpl* chunk_server_manager_service,
+    MasterMetadataServiceImpl* metadata_service)
+    : chunk_server_manager_service_(
+          std::make_unique<AsyncChunkServerManagerService>(
+              chunk_server_manager_service)),
+      metadata_service_(
+          std::make_unique<AsyncMetadataService>(metadata_service)) {}
+
+MasterServerAsyncServices::~MasterServerAsyncServices() = default;
+
+void MasterServerAsyncServices::Register(grpc::ServerBuilder* builder,
+                                         AsyncServerRuntime* runtime) {
+    builder->RegisterService(chunk_server_manager_service_.get());
+    builder->RegisterService(metadata_service_.get());
+
+    chunk_server_manager_service_->RegisterMethods(runtime);
+    metadata_service_->RegisterMethods(runtime);
+}
+
+}  // namespace server
+}  // namespace dfs
@@ -0,0 +1,48 @@
+#ifndef DFS_SERVER_MASTER_SERVER_ASYNC_SERVICES_H
+#define DFS_SERVER_MASTER_SERVER_ASYNC_SERVICES_H
+
+#include <grpcpp/grpcpp.h>
+
+#include <memory>
+
+#include "src/common/async_server_runtime.h"
+#include "src/server/master_server/chunk_server_manager_service_impl.h"
+#include "src/server/master_server/master_metadata_service_impl.h"
+
+namespace dfs {
+namespace server {
+
+/**
+ * 主服务器对外提供的服务
+ * 一元 RPC 由异步运行时处理，处理逻辑仍然是各个同步服务的实现：
+ * 1. 块服务器的汇报只修改内存中的状态，直接在轮询线程中处理，
+ *    不会被慢的元数据请求阻塞而导致租约过期
+ * 2. 打开文件时可能需要创建数据块、授予租约，需要访问块服务器，
+ *    在网络线程池中处理
+ */
+class MasterServerAsyncServices {
+   public:
+    MasterServerAsyncServices(
+        ChunkServerManagerServiceImpl* chunk_server_manager_service,
+        MasterMetadataServiceImpl* metadata_service);
+
+    ~MasterServerAsyncServices();
+
+    // 将服务注册到 builder，并将一元 RPC 注册到运行时
+    void Register(grpc::ServerBuilder* builder,
+                  dfs::common::AsyncServerRuntime* runtime);
+
+   private:
+    class AsyncChunkServerManagerService;
+    class AsyncMetadataService;
+
+    std::unique_ptr<AsyncChunkServerManagerService>
+        chunk_server_manager_service_;
+
+    std::unique_ptr<AsyncMetadataService> metadata_service_;
+};
+
+}  // namespace server
+}  // namespace dfs
+
+#endif  // DFS_SERVER_MASTER_SERVER_ASYNC_SERVICES_H
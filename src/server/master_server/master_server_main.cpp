@@ -1,31 +1,72 @@
+#include "src/common/async_server_runtime.h"
+#include "src/common/config_manager.h"
+#include "src/common/metrics_server.h"
 #include "src/common/system_logger.h"
+#include "src/common/tracing.h"
 #include "src/server/master_server/chunk_server_heartbeat_task.h"
 #include "src/server/master_server/chunk_server_manager_service_impl.h"
 #include "src/server/master_server/master_metadata_service_impl.h"
+#include "src/server/master_server/master_server_async_services.h"
 #include "src/server/master_server/chunk_replica_manager.h"
 
 using namespace dfs::server;
+using dfs::common::AsyncServerRuntime;
+using dfs::common::ConfigManager;
+using dfs::common::MetricsRegistry;
+using dfs::common::MetricsServer;
+using dfs::common::Tracer;
 
 int main(int argc, char* argv[]) {
     dfs::common::SystemLogger::GetInstance().Initialize(argv[0]);
     LOG(INFO) << "start master server";
 
+    // CMAKE_SOURCE_DIR 是从 cmake 设置的宏
+    const std::string config_path =
+        std::string(CMAKE_SOURCE_DIR) + "/config.json";
+
+    if (!ConfigManager::GetInstance()->InitConfigManager(config_path)) {
+        LOG(ERROR) << "config init error, check config path";
+        return 1;
+    }
+
+    // 按配置切换为异步日志
+    dfs::common::SystemLogger::GetInstance().Configure(
+        dfs::common::SystemLogger::LoadOptions());
+
+    // 导出请求的 span，采样率可以通过指标服务的 /tracing 修改
+    Tracer::GetInstance()->Start("master_server", Tracer::LoadOptions());
+
     grpc::ServerBuilder builder;
-    std::string server_address("0.0.0.0:50050");
+    const uint32_t server_port = 50050;
+    std::string server_address("0.0.0.0:" + std::to_string(server_port));
     builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
 
+    // 一元 RPC 由异步运行时处理，块服务器的汇报不会被慢的元数据请求阻塞
+    AsyncServerRuntime runtime(AsyncServerRuntime::LoadOptions());
+    runtime.Configure(&builder);
+
     // set up service
     ChunkServerManagerServiceImpl chunk_server_manager_service;
-    builder.RegisterService(&chunk_server_manager_service);
-
     MasterMetadataServiceImpl metadata_service;
-    builder.RegisterService(&metadata_service);
+    MasterServerAsyncServices async_services(&chunk_server_manager_service,
+                                             &metadata_service);
+    async_services.Register(&builder, &runtime);
 
     // build server
     std::unique_ptr<grpc::Server> server(builder.BuildAndStart());
+    runtime.Start();
 
     LOG(INFO) << "master server listening on " << server_address;
 
+    // 以 Prometheus 文本格式导出指标
+    MetricsServer metrics_server(MetricsRegistry::GetInstance());
+    const uint32_t metrics_port_offset =
+        ConfigManager::GetInstance()->GetMetricsPortOffset();
+    if (metrics_port_offset > 0) {
+        metrics_server.Start(ConfigManager::GetInstance()->GetMetricsAddress(),
+                             server_port + metrics_port_offset);
+    }
+
     // start heart beat task
     ChunkServerHeartBeatTask::GetInstance()->StartHeartBeatTask();
 
@@ -34,6 +75,10 @@ int main(int argc, char* argv[]) {
 
     server->Wait();
 
+    metrics_server.Stop();
+    runtime.Shutdown();
+    Tracer::GetInstance()->Shutdown();
+    dfs::common::SystemLogger::GetInstance().Shutdown();
     google::ShutdownGoogleLogging();
     return 0;
 }
\ No newline at end of file
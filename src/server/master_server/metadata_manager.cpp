@@ -1,9 +1,14 @@
 #include "metadata_manager.h"
 
+#include <absl/time/clock.h>
+
+#include <algorithm>
+
 namespace dfs {
 namespace server {
 
 using google::protobuf::util::AlreadyExistsError;
+using google::protobuf::util::FailedPreconditionError;
 using google::protobuf::util::IsAlreadyExists;
 using google::protobuf::util::IsNotFound;
 using google::protobuf::util::NotFoundError;
@@ -29,7 +34,7 @@ bool MetadataManager::ExistFileChunkMetadata(const std::string& chunk_handle) {
 }
 
 google::protobuf::util::Status MetadataManager::CreateFileMetadata(
-    const std::string& filename) {
+    const std::string& filename, const protos::ChunkCodec& codec) {
     // step 1: Lock the parent directory first(readerlock)
     ParentLocks plocks(lock_manager_, filename);
     if (!plocks.ok()) {
@@ -52,11 +57,16 @@ google::protobuf::util::Status MetadataManager::CreateFileMetadata(
     // step 3: Instantiate and initialize file metadata
     auto new_file_metadata(std::make_shared<FileMetadata>());
     new_file_metadata->set_filename(filename);
+    new_file_metadata->set_codec(codec);
 
     if (!file_metadatas_.TryInsert(filename, new_file_metadata)) {
         return AlreadyExistsError(filename + " metadata is already exist");
     }
 
+    {
+        absl::MutexLock access_times_lock_guard(&access_times_lock_);
+        file_access_times_[filename] = absl::Now();
+    }
     return OkStatus();
 }
 
@@ -213,26 +223,260 @@ void MetadataManager::DeleteFileAndChunkMetadata(const std::string& filename) {
 
     for (auto& chunk_handle : file_matadata->chunk_handles()) {
         chunk_metadatas_.Erase(chunk_handle.second);
+        chunk_leases_.Erase(chunk_handle.second);
+    }
+
+    // 纠删码文件还需要删除校验块
+    for (const auto& stripe : file_matadata->stripes()) {
+        for (const auto& chunk_handle : stripe.chunk_handles()) {
+            if (chunk_handle.empty()) {
+                continue;
+            }
+            chunk_metadatas_.Erase(chunk_handle);
+            chunk_stripes_.Erase(chunk_handle);
+        }
     }
+
+    absl::MutexLock access_times_lock_guard(&access_times_lock_);
+    file_access_times_.erase(filename);
 }
 
 // lease
 
-void MetadataManager::SetLeaseMetadata(
-    const std::string& chunk_handle,
-    const std::string& clent_url, uint64_t expire_time) {
-    chunk_leases_.Set(chunk_handle, std::make_pair(clent_url, expire_time));
+void MetadataManager::SetLeaseMetadata(const std::string& chunk_handle,
+                                       const LeaseMetadata& lease) {
+    chunk_leases_.Set(chunk_handle, lease);
 }
 
 void MetadataManager::RemoveLeaseMetadata(const std::string& chunk_handle) {
     chunk_leases_.Erase(chunk_handle);
 }
 
-std::pair<std::pair<std::string, uint64_t>, bool>
-MetadataManager::GetLeaseMetadata(const std::string& chunk_handle) {
+google::protobuf::util::StatusOr<bool> MetadataManager::AcquireLeaseMetadata(
+    const std::string& chunk_handle, const LeaseMetadata& lease) {
+    const uint64_t now = absl::ToUnixSeconds(absl::Now());
+    return chunk_leases_.Upsert(
+        chunk_handle,
+        [&](LeaseMetadata& holder) -> google::protobuf::util::StatusOr<bool> {
+            if (holder.client_id.empty() || holder.expire_time <= now) {
+                holder = lease;
+                holder.granted = false;
+                return false;
+            }
+
+            if (holder.client_id != lease.client_id) {
+                return FailedPreconditionError("lease of " + chunk_handle +
+                                               " is held by other client");
+            }
+            if (holder.session_epoch > lease.session_epoch) {
+                return FailedPreconditionError(
+                    "lease of " + chunk_handle +
+                    " is held by a newer session of the client");
+            }
+
+            // 客户端重启后的新会话接管租约
+            holder.session_epoch = lease.session_epoch;
+            return holder.granted;
+        });
+}
+
+bool MetadataManager::MarkLeaseGranted(const std::string& chunk_handle,
+                                       const LeaseMetadata& lease) {
+    return chunk_leases_.TryUpdate(chunk_handle, [&](LeaseMetadata& holder) {
+        if (holder.client_id != lease.client_id ||
+            holder.session_epoch != lease.session_epoch) {
+            return false;
+        }
+        holder.granted = true;
+        return true;
+    });
+}
+
+void MetadataManager::ReleaseLeaseMetadata(const std::string& chunk_handle,
+                                           const LeaseMetadata& lease) {
+    // 在锁内检查并清空，清空的租约与已过期的租约相同，不影响其他会话
+    chunk_leases_.TryUpdate(chunk_handle, [&](LeaseMetadata& holder) {
+        if (holder.granted || holder.client_id != lease.client_id ||
+            holder.session_epoch != lease.session_epoch) {
+            return false;
+        }
+        holder = LeaseMetadata();
+        return true;
+    });
+}
+
+bool MetadataManager::ExtendLeaseMetadata(const std::string& chunk_handle,
+                                          uint64_t expire_time) {
+    const uint64_t now = absl::ToUnixSeconds(absl::Now());
+    return chunk_leases_.TryUpdate(chunk_handle, [&](LeaseMetadata& lease) {
+        if (lease.expire_time <= now) {
+            return false;
+        }
+        lease.expire_time = std::max(lease.expire_time, expire_time);
+        return true;
+    });
+}
+
+std::pair<LeaseMetadata, bool> MetadataManager::GetLeaseMetadata(
+    const std::string& chunk_handle) {
     return chunk_leases_.TryGet(chunk_handle);
 }
 
+google::protobuf::util::Status MetadataManager::SetFileStorageClass(
+    const std::string& filename, const protos::StorageClass& storage_class) {
+    ParentLocks plocks(lock_manager_, filename);
+    if (!plocks.ok()) {
+        return plocks.status();
+    }
+
+    auto file_lock_or = lock_manager_->FetchLock(filename);
+    if (!file_lock_or.ok()) {
+        return file_lock_or.status();
+    }
+    absl::WriterMutexLock file_lock_guard(file_lock_or.value());
+
+    auto file_metadata_or = GetFileMetadata(filename);
+    if (!file_metadata_or.ok()) {
+        return file_metadata_or.status();
+    }
+    file_metadata_or.value()->set_storage_class(storage_class);
+    return OkStatus();
+}
+
+std::string MetadataManager::CreateParityChunkHandle() {
+    return AllocateNewChunkHandle();
+}
+
+google::protobuf::util::Status MetadataManager::SetFileStripes(
+    const std::string& filename,
+    const std::vector<protos::StripeMetadata>& stripes) {
+    ParentLocks plocks(lock_manager_, filename);
+    if (!plocks.ok()) {
+        return plocks.status();
+    }
+
+    auto file_lock_or = lock_manager_->FetchLock(filename);
+    if (!file_lock_or.ok()) {
+        return file_lock_or.status();
+    }
+    absl::WriterMutexLock file_lock_guard(file_lock_or.value());
+
+    auto file_metadata_or = GetFileMetadata(filename);
+    if (!file_metadata_or.ok()) {
+        return file_metadata_or.status();
+    }
+
+    auto file_metadata = file_metadata_or.value();
+    file_metadata->clear_stripes();
+    for (uint32_t i = 0; i < stripes.size(); i++) {
+        *file_metadata->add_stripes() = stripes[i];
+        for (const auto& chunk_handle : stripes[i].chunk_handles()) {
+            if (!chunk_handle.empty()) {
+                chunk_stripes_.Set(chunk_handle, std::make_pair(filename, i));
+            }
+        }
+    }
+    return OkStatus();
+}
+
+google::protobuf::util::StatusOr<ChunkStripe> MetadataManager::GetChunkStripe(
+    const std::string& chunk_handle) {
+    auto stripe_pair = chunk_stripes_.TryGet(chunk_handle);
+    if (!stripe_pair.second) {
+        return NotFoundError("chunk " + chunk_handle +
+                             " does not belong to any stripe");
+    }
+
+    const std::string& filename = stripe_pair.first.first;
+    const uint32_t stripe_index = stripe_pair.first.second;
+    ParentLocks plocks(lock_manager_, filename);
+    if (!plocks.ok()) {
+        return plocks.status();
+    }
+
+    auto file_lock_or = lock_manager_->FetchLock(filename);
+    if (!file_lock_or.ok()) {
+        return file_lock_or.status();
+    }
+    absl::ReaderMutexLock file_lock_guard(file_lock_or.value());
+
+    auto file_metadata_or = GetFileMetadata(filename);
+    if (!file_metadata_or.ok()) {
+        return file_metadata_or.status();
+    }
+
+    const auto& file_metadata = file_metadata_or.value();
+    if (stripe_index >= static_cast<uint32_t>(file_metadata->stripes_size())) {
+        return NotFoundError("stripe of chunk " + chunk_handle +
+                             " is not found in file " + filename);
+    }
+
+    ChunkStripe chunk_stripe;
+    chunk_stripe.filename = filename;
+    chunk_stripe.stripe = file_metadata->stripes(stripe_index);
+    const auto& chunk_handles = chunk_stripe.stripe.chunk_handles();
+    auto iter =
+        std::find(chunk_handles.begin(), chunk_handles.end(), chunk_handle);
+    if (iter == chunk_handles.end()) {
+        return NotFoundError("chunk " + chunk_handle +
+                             " is not found in its stripe");
+    }
+    chunk_stripe.shard_index = iter - chunk_handles.begin();
+    return chunk_stripe;
+}
+
+bool MetadataManager::IsErasureCodedChunk(const std::string& chunk_handle) {
+    return chunk_stripes_.Contains(chunk_handle);
+}
+
+void MetadataManager::TouchFile(const std::string& filename) {
+    const absl::Time now = absl::Now();
+    absl::MutexLock access_times_lock_guard(&access_times_lock_);
+    auto iter = file_access_times_.find(filename);
+    if (iter != file_access_times_.end()) {
+        iter->second = now;
+    }
+}
+
+google::protobuf::util::StatusOr<absl::Time> MetadataManager::GetFileAccessTime(
+    const std::string& filename) {
+    absl::MutexLock access_times_lock_guard(&access_times_lock_);
+    auto iter = file_access_times_.find(filename);
+    if (iter == file_access_times_.end()) {
+        return NotFoundError(filename + " has no access time");
+    }
+    return iter->second;
+}
+
+std::vector<std::string> MetadataManager::GetColdFiles(absl::Time before,
+                                                       uint32_t max_nums) {
+    std::vector<std::pair<absl::Time, std::string>> candidates;
+    {
+        absl::MutexLock access_times_lock_guard(&access_times_lock_);
+        for (const auto& access_pair : file_access_times_) {
+            if (access_pair.second < before) {
+                candidates.emplace_back(access_pair.second, access_pair.first);
+            }
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    std::vector<std::string> filenames;
+    for (const auto& candidate : candidates) {
+        if (filenames.size() >= max_nums) {
+            break;
+        }
+        auto file_metadata_or = GetFileMetadata(candidate.second);
+        if (file_metadata_or.ok() &&
+            file_metadata_or.value()->storage_class() ==
+                protos::STORAGE_REPLICATED &&
+            !file_metadata_or.value()->chunk_handles().empty()) {
+            filenames.push_back(candidate.second);
+        }
+    }
+    return filenames;
+}
+
 std::string MetadataManager::AllocateNewChunkHandle() {
     return std::to_string(global_chunk_id_.fetch_add(1));
 }
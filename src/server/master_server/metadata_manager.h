@@ -2,8 +2,11 @@
 #define DFS_SERVER_MASTER_SERVER_METADATA_MANAGER_H
 
 #include <atomic>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "google/protobuf/stubs/statusor.h"
 #include "metadata.pb.h"
 #include "src/common/utils.h"
@@ -14,6 +17,30 @@ namespace server {
 
 using protos::FileMetadata;
 
+// 纠删码文件中的数据块或校验块所在的条带
+struct ChunkStripe {
+    std::string filename;
+
+    protos::StripeMetadata stripe;
+
+    // 在条带 chunk_handles 中的位置
+    uint32_t shard_index = 0;
+};
+
+// 数据块的写租约，由客户端会话持有。client_id 相同的多个连接与工作线程
+// 共享租约，客户端重启后 session_epoch 变大，由新会话接管旧会话的租约
+struct LeaseMetadata {
+    std::string client_id;
+
+    uint64_t session_epoch = 0;
+
+    // 到期时间，unix 秒
+    uint64_t expire_time = 0;
+
+    // 主副本服务器是否已经接受该租约
+    bool granted = false;
+};
+
 class MetadataManager {
    public:
     static MetadataManager* GetInstance();
@@ -22,8 +49,10 @@ class MetadataManager {
 
     bool ExistFileChunkMetadata(const std::string& chunk_handle);
 
+    // codec 为文件的压缩算法，该文件的所有数据块都按它压缩
     google::protobuf::util::Status CreateFileMetadata(
-        const std::string& filename);
+        const std::string& filename,
+        const protos::ChunkCodec& codec = protos::CODEC_NONE);
 
     google::protobuf::util::StatusOr<std::shared_ptr<FileMetadata>>
     GetFileMetadata(const std::string& filename);
@@ -45,13 +74,66 @@ class MetadataManager {
     void DeleteFileAndChunkMetadata(const std::string& filename);
 
     void SetLeaseMetadata(const std::string& chunk_handle,
-                          const std::string& client_url,
-                          uint64_t expire_time);
+                          const LeaseMetadata& lease);
 
     void RemoveLeaseMetadata(const std::string& chunk_handle);
 
-    std::pair<std::pair<std::string, uint64_t>, bool>
-    GetLeaseMetadata(const std::string& chunk_handle);
+    // 为 lease 的客户端会话获取数据块的写租约，检查与记录是原子的：
+    // 1. 没有租约或者租约已过期时记录 lease，返回 false，调用者需要向
+    //    主副本服务器申请租约
+    // 2. 租约属于同一客户端时沿用原租约，session_epoch 更大时由新会话接管，
+    //    返回主副本服务器是否已经接受该租约
+    // 3. 租约属于其他客户端或者同一客户端更新的会话时返回 FailedPrecondition
+    google::protobuf::util::StatusOr<bool> AcquireLeaseMetadata(
+        const std::string& chunk_handle, const LeaseMetadata& lease);
+
+    // 主副本服务器接受租约后标记，租约已不属于 lease 的会话时返回 false
+    bool MarkLeaseGranted(const std::string& chunk_handle,
+                          const LeaseMetadata& lease);
+
+    // 主副本服务器拒绝租约时删除 lease 的会话记录的、尚未被接受的租约
+    void ReleaseLeaseMetadata(const std::string& chunk_handle,
+                              const LeaseMetadata& lease);
+
+    // 延长未过期的租约，租约不存在或已经过期时返回 false
+    bool ExtendLeaseMetadata(const std::string& chunk_handle,
+                             uint64_t expire_time);
+
+    std::pair<LeaseMetadata, bool> GetLeaseMetadata(
+        const std::string& chunk_handle);
+
+    // 修改文件的存储方式
+    google::protobuf::util::Status SetFileStorageClass(
+        const std::string& filename,
+        const protos::StorageClass& storage_class);
+
+    // 为校验块分配块句柄。校验块不属于文件的块索引，编码成功后由调用者
+    // 设置其元数据
+    std::string CreateParityChunkHandle();
+
+    // 设置纠删码文件的条带，并记录条带中每个分片所属的条带
+    google::protobuf::util::Status SetFileStripes(
+        const std::string& filename,
+        const std::vector<protos::StripeMetadata>& stripes);
+
+    // 获取数据块或校验块所在的条带
+    google::protobuf::util::StatusOr<ChunkStripe> GetChunkStripe(
+        const std::string& chunk_handle);
+
+    // 数据块或校验块是否属于纠删码文件
+    bool IsErasureCodedChunk(const std::string& chunk_handle);
+
+    // 记录客户端对文件的一次读写，不存在的文件忽略
+    void TouchFile(const std::string& filename);
+
+    // 文件最近一次被读写的时间，创建文件时开始计时
+    google::protobuf::util::StatusOr<absl::Time> GetFileAccessTime(
+        const std::string& filename);
+
+    // 获取 before 之前没有被读写过的多副本文件，最久未访问的在前，
+    // 最多返回 max_nums 个
+    std::vector<std::string> GetColdFiles(absl::Time before,
+                                          uint32_t max_nums);
 
    private:
     MetadataManager();
@@ -72,9 +154,17 @@ class MetadataManager {
 
     // <chunk_handle, <client url, expire time>>
     // 确保客户端对数据块写入的独占性
-    dfs::common::parallel_hash_map<std::string,
-                                   std::pair<std::string, uint64_t>>
-        chunk_leases_;
+    dfs::common::parallel_hash_map<std::string, LeaseMetadata> chunk_leases_;
+
+    // <chunk_handle, <filename, stripe index>>
+    // 纠删码文件中的数据块与校验块所在的条带
+    dfs::common::parallel_hash_map<std::string, std::pair<std::string, uint32_t>>
+        chunk_stripes_;
+
+    // <filename, access time>
+    // 文件最近一次被读写的时间，只保存在内存中，用于选择冷文件
+    absl::Mutex access_times_lock_;
+    absl::flat_hash_map<std::string, absl::Time> file_access_times_;
 
     // 用于给每个 chunk 分配 uuid
     std::atomic<uint64_t> global_chunk_id_;
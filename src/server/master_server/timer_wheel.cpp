@@ -0,0 +1,95 @@
+#include "src/server/master_server/timer_wheel.h"
+
+#include <algorithm>
+
+namespace dfs {
+namespace server {
+
+TimerWheel::TimerWheel(absl::Time start, absl::Duration tick,
+                       size_t slot_count)
+    : start_(start),
+      tick_ms_(std::max<int64_t>(absl::ToInt64Milliseconds(tick), 1)),
+      slots_(std::max<size_t>(slot_count, 1)),
+      current_tick_(0) {}
+
+void TimerWheel::Schedule(const std::string& key, absl::Time deadline) {
+    Cancel(key);
+
+    // 向上取整，保证不会早于 deadline 过期
+    int64_t deadline_tick = TickOf(deadline);
+    if (ToMilliseconds(deadline) > deadline_tick * tick_ms_) {
+        deadline_tick++;
+    }
+    deadline_tick = std::max(deadline_tick, current_tick_);
+
+    slots_[SlotOf(deadline_tick)].insert(key);
+    deadline_ticks_[key] = deadline_tick;
+}
+
+void TimerWheel::Cancel(const std::string& key) {
+    auto iter = deadline_ticks_.find(key);
+    if (iter == deadline_ticks_.end()) {
+        return;
+    }
+
+    slots_[SlotOf(iter->second)].erase(key);
+    deadline_ticks_.erase(iter);
+}
+
+std::vector<std::string> TimerWheel::Advance(absl::Time now) {
+    std::vector<std::string> expired_keys;
+    const int64_t now_tick = TickOf(now);
+    if (now_tick < current_tick_) {
+        return expired_keys;
+    }
+
+    // 落后超过一圈时，每个槽只需访问一次
+    const int64_t ticks = std::min<int64_t>(now_tick - current_tick_ + 1,
+                                            static_cast<int64_t>(slots_.size()));
+    for (int64_t i = 0; i < ticks; i++) {
+        auto& slot = slots_[SlotOf(current_tick_ + i)];
+        for (auto iter = slot.begin(); iter != slot.end();) {
+            auto deadline_iter = deadline_ticks_.find(*iter);
+            if (deadline_iter->second <= now_tick) {
+                expired_keys.push_back(*iter);
+                deadline_ticks_.erase(deadline_iter);
+                slot.erase(iter++);
+            } else {
+                // 还要再过若干圈才过期
+                ++iter;
+            }
+        }
+    }
+
+    current_tick_ = now_tick + 1;
+    return expired_keys;
+}
+
+bool TimerWheel::Contains(const std::string& key) const {
+    return deadline_ticks_.contains(key);
+}
+
+size_t TimerWheel::size() const { return deadline_ticks_.size(); }
+
+int64_t TimerWheel::ToMilliseconds(absl::Time time) const {
+    return absl::ToInt64Milliseconds(time - start_);
+}
+
+int64_t TimerWheel::TickOf(absl::Time time) const {
+    const int64_t elapsed_ms = ToMilliseconds(time);
+    if (elapsed_ms >= 0) {
+        return elapsed_ms / tick_ms_;
+    }
+    // 早于 start_ 的时间同样向下取整
+    return -((-elapsed_ms + tick_ms_ - 1) / tick_ms_);
+}
+
+std::vector<absl::flat_hash_set<std::string>>::size_type TimerWheel::SlotOf(
+    int64_t tick) const {
+    // tick 可能为负数（时间早于 start_）
+    const int64_t slot_count = static_cast<int64_t>(slots_.size());
+    return ((tick % slot_count) + slot_count) % slot_count;
+}
+
+}  // namespace server
+}  // namespace dfs
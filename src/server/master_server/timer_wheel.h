@@ -0,0 +1,66 @@
+#ifndef DFS_SERVER_MASTER_SERVER_TIMER_WHEEL_H
+#define DFS_SERVER_MASTER_SERVER_TIMER_WHEEL_H
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+#include <absl/time/time.h>
+
+#include <string>
+#include <vector>
+
+namespace dfs {
+namespace server {
+
+/**
+ * 哈希时间轮
+ * 用于追踪大量会定时过期的对象（如块服务器的存活租约），
+ * 设置、刷新与取消过期时间均为 O(1)，推进时间轮只访问到期的槽。
+ * 过期时间超过一圈的对象会在槽中停留多圈，直到真正到期。
+ * 非线程安全，调用者需自行加锁。
+ */
+class TimerWheel {
+   public:
+    // start 为时间轮的起始时间，tick 为每个槽覆盖的时间，slot_count 为槽的数量
+    TimerWheel(absl::Time start, absl::Duration tick, size_t slot_count);
+
+    // 设置 key 在 deadline 过期，已经存在的 key 会刷新过期时间
+    void Schedule(const std::string& key, absl::Time deadline);
+
+    // 取消 key 的过期时间
+    void Cancel(const std::string& key);
+
+    // 将时间轮推进到 now，返回所有已经过期的 key，过期的 key 会被移除
+    std::vector<std::string> Advance(absl::Time now);
+
+    bool Contains(const std::string& key) const;
+
+    size_t size() const;
+
+   private:
+    // 时间点距离 start_ 的毫秒数
+    int64_t ToMilliseconds(absl::Time time) const;
+
+    // 时间点所在的 tick，向下取整
+    int64_t TickOf(absl::Time time) const;
+
+    std::vector<absl::flat_hash_set<std::string>>::size_type SlotOf(
+        int64_t tick) const;
+
+    absl::Time start_;
+
+    // 每个槽覆盖的毫秒数
+    int64_t tick_ms_;
+
+    std::vector<absl::flat_hash_set<std::string>> slots_;
+
+    // map<key, deadline tick>
+    absl::flat_hash_map<std::string, int64_t> deadline_ticks_;
+
+    // 下一个待处理的 tick
+    int64_t current_tick_;
+};
+
+}  // namespace server
+}  // namespace dfs
+
+#endif  // DFS_SERVER_MASTER_SERVER_TIMER_WHEEL_H
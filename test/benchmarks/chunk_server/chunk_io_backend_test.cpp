@@ -0,0 +1,132 @@
+#include "src/server/chunk_server/chunk_io_backend.h"
+
+#include <absl/synchronization/blocking_counter.h>
+#include <benchmark/benchmark.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+using dfs::server::ChunkIoBackend;
+using dfs::server::ChunkIoRequest;
+
+const char* kFilePath = "benchmark_chunk_io_backend_file";
+// 测试文件大小
+const size_t kFileSize = 256 * 1024 * 1024;
+// 每次随机读取的大小
+const size_t kIoSize = 4096;
+// 最大的队列深度
+const int kMaxQueueDepth = 256;
+
+// 测试文件，尽量使用 O_DIRECT 绕过页缓存
+int file_fd = -1;
+
+// 生成 queue_depth 个随机的按页对齐的偏移
+std::vector<uint64_t> RandomOffsets(std::mt19937_64* random,
+                                    const int& queue_depth) {
+    std::uniform_int_distribution<uint64_t> distribution(
+        0, kFileSize / kIoSize - 1);
+    std::vector<uint64_t> offsets(queue_depth);
+    for (auto& offset : offsets) {
+        offset = distribution(*random) * kIoSize;
+    }
+    return offsets;
+}
+
+// 同步路径：在一个线程中依次调用 pread，range(0) 为每轮的读取次数
+static void BM_SYNC_PREAD(benchmark::State& state) {
+    const int queue_depth = state.range(0);
+    std::mt19937_64 random(0);
+    void* buffer = nullptr;
+    if (posix_memalign(&buffer, kIoSize, kIoSize)) {
+        state.SkipWithError("alloc buffer failed");
+        return;
+    }
+
+    for (auto _ : state) {
+        for (auto offset : RandomOffsets(&random, queue_depth)) {
+            benchmark::DoNotOptimize(pread(file_fd, buffer, kIoSize, offset));
+        }
+    }
+
+    free(buffer);
+    state.SetItemsProcessed(state.iterations() * queue_depth);
+    state.SetBytesProcessed(state.iterations() * queue_depth * kIoSize);
+}
+
+// I/O 后端：每轮一次提交 queue_depth 个读请求，等待全部完成，
+// range(0) 为是否使用线程池，range(1) 为队列深度
+static void BM_CHUNK_IO_BACKEND(benchmark::State& state) {
+    const int queue_depth = state.range(1);
+    ChunkIoBackend::Options options;
+    options.use_thread_pool = state.range(0);
+    options.queue_depth = kMaxQueueDepth;
+    options.thread_nums = 16;
+    // 一个注册缓冲区，每个请求使用其中的一页
+    options.buffer_nums = 1;
+    options.buffer_size = kMaxQueueDepth * kIoSize;
+    auto backend = ChunkIoBackend::Create(options);
+    state.SetLabel(backend->name());
+
+    std::mt19937_64 random(0);
+    for (auto _ : state) {
+        const auto offsets = RandomOffsets(&random, queue_depth);
+        absl::BlockingCounter counter(queue_depth);
+        std::vector<ChunkIoRequest> requests(queue_depth);
+        for (int i = 0; i < queue_depth; i++) {
+            requests[i].type = ChunkIoRequest::READ;
+            requests[i].fd = file_fd;
+            requests[i].offset = offsets[i];
+            requests[i].buffer = backend->GetBuffer(0) + i * kIoSize;
+            requests[i].length = kIoSize;
+            requests[i].buffer_index = 0;
+            requests[i].callback = [&](int64_t result) {
+                counter.DecrementCount();
+            };
+        }
+
+        backend->Submit(std::move(requests));
+        counter.Wait();
+    }
+
+    state.SetItemsProcessed(state.iterations() * queue_depth);
+    state.SetBytesProcessed(state.iterations() * queue_depth * kIoSize);
+}
+
+BENCHMARK(BM_SYNC_PREAD)
+    ->RangeMultiplier(2)
+    ->Range(1, kMaxQueueDepth)
+    ->ArgName("qd")
+    ->UseRealTime();
+BENCHMARK(BM_CHUNK_IO_BACKEND)
+    ->ArgsProduct({{0, 1}, benchmark::CreateRange(1, kMaxQueueDepth, 2)})
+    ->ArgNames({"thread_pool", "qd"})
+    ->UseRealTime();
+
+int main(int argc, char** argv) {
+    // 生成测试文件
+    int fd = open(kFilePath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    const std::string data(1024 * 1024, 'x');
+    for (size_t offset = 0; offset < kFileSize; offset += data.size()) {
+        if (pwrite(fd, data.data(), data.size(), offset) < 0) {
+            return 1;
+        }
+    }
+    fsync(fd);
+    close(fd);
+
+    file_fd = open(kFilePath, O_RDONLY | O_DIRECT);
+    if (file_fd < 0) {
+        file_fd = open(kFilePath, O_RDONLY);
+    }
+
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+
+    close(file_fd);
+    std::filesystem::remove(kFilePath);
+    return 0;
+}
@@ -0,0 +1,213 @@
+#include "src/common/async_server_runtime.h"
+
+#include <benchmark/benchmark.h>
+#include <grpcpp/grpcpp.h>
+
+#include <atomic>
+#include <climits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "chunk_server_control_service.grpc.pb.h"
+#include "hello.grpc.pb.h"
+
+using dfs::common::AsyncServerRuntime;
+using helloworld::Greeter;
+using helloworld::HelloReply;
+using helloworld::HelloRequest;
+using protos::grpc::ChunkServerControlService;
+using protos::grpc::SendHeartBeatRequest;
+using protos::grpc::SendHeartBeatRespond;
+
+// 模拟一次磁盘读写的耗时
+const auto kDiskLatency = std::chrono::milliseconds(1);
+// 并发发送请求的客户端数量
+const int kClientNums = 64;
+// 每个客户端发送的请求数量
+const int kRequestsPerClient = 20;
+
+// 模拟读写 leveldb 的请求
+class DiskServiceImpl final : public Greeter::Service {
+   public:
+    grpc::Status SayHello(grpc::ServerContext* context,
+                          const HelloRequest* request,
+                          HelloReply* reply) override {
+        std::this_thread::sleep_for(kDiskLatency);
+        reply->set_message(request->name());
+        return grpc::Status::OK;
+    }
+};
+
+// 模拟心跳这类只访问内存的请求
+class HeartBeatServiceImpl final : public ChunkServerControlService::Service {
+   public:
+    grpc::Status SendHeartBeat(grpc::ServerContext* context,
+                               const SendHeartBeatRequest* request,
+                               SendHeartBeatRespond* respond) override {
+        return grpc::Status::OK;
+    }
+};
+
+class BenchmarkServer {
+   public:
+    // async 为 true 时使用异步运行时，磁盘请求在 thread_nums 个线程中处理；
+    // 否则使用同步服务，资源配额限制同步线程数量为 thread_nums
+    BenchmarkServer(bool async, uint32_t thread_nums) {
+        grpc::ServerBuilder builder;
+        builder.AddListeningPort("127.0.0.1:0",
+                                 grpc::InsecureServerCredentials(), &port_);
+
+        if (async) {
+            AsyncServerRuntime::Options options;
+            options.disk_thread_nums = thread_nums;
+            options.max_queued_calls = 0;
+            runtime_ = std::make_unique<AsyncServerRuntime>(options);
+            runtime_->Configure(&builder);
+            builder.RegisterService(&async_disk_service_);
+            builder.RegisterService(&async_heart_beat_service_);
+            runtime_->RegisterUnaryMethod(
+                "SayHello", &async_disk_service_,
+                &Greeter::AsyncService::RequestSayHello, &disk_service_,
+                &DiskServiceImpl::SayHello,
+                AsyncServerRuntime::ExecutorType::DISK);
+            runtime_->RegisterUnaryMethod(
+                "SendHeartBeat", &async_heart_beat_service_,
+                &ChunkServerControlService::AsyncService::RequestSendHeartBeat,
+                &heart_beat_service_, &HeartBeatServiceImpl::SendHeartBeat,
+                AsyncServerRuntime::ExecutorType::INLINE);
+        } else {
+            grpc::ResourceQuota resource_quota("benchmark_server");
+            resource_quota.SetMaxThreads(thread_nums);
+            builder.SetResourceQuota(resource_quota);
+            builder.RegisterService(&disk_service_);
+            builder.RegisterService(&heart_beat_service_);
+        }
+
+        server_ = builder.BuildAndStart();
+        if (runtime_) {
+            runtime_->Start();
+        }
+    }
+
+    ~BenchmarkServer() {
+        server_->Shutdown();
+        if (runtime_) {
+            runtime_->Shutdown();
+        }
+    }
+
+    std::shared_ptr<grpc::Channel> CreateChannel() {
+        // 每个客户端使用独立的连接
+        grpc::ChannelArguments args;
+        args.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+        return grpc::CreateCustomChannel(
+            "127.0.0.1:" + std::to_string(port_),
+            grpc::InsecureChannelCredentials(), args);
+    }
+
+   private:
+    int port_ = 0;
+
+    DiskServiceImpl disk_service_;
+
+    HeartBeatServiceImpl heart_beat_service_;
+
+    Greeter::AsyncService async_disk_service_;
+
+    ChunkServerControlService::AsyncService async_heart_beat_service_;
+
+    std::unique_ptr<AsyncServerRuntime> runtime_;
+
+    std::unique_ptr<grpc::Server> server_;
+};
+
+// 持续发送磁盘请求的客户端
+class DiskLoadClients {
+   public:
+    explicit DiskLoadClients(BenchmarkServer* server) {
+        for (int i = 0; i < kClientNums; i++) {
+            stubs_.push_back(Greeter::NewStub(server->CreateChannel()));
+        }
+    }
+
+    // 每个客户端发送 requests 个请求，返回成功的请求数量
+    int64_t Run(int requests) {
+        std::atomic<int64_t> ok_nums{0};
+        std::vector<std::thread> client_threads;
+        for (auto& stub : stubs_) {
+            client_threads.emplace_back([&, stub = stub.get()]() {
+                HelloRequest request;
+                request.set_name("disk");
+                for (int i = 0; i < requests && !stop_.load(); i++) {
+                    grpc::ClientContext context;
+                    HelloReply reply;
+                    if (stub->SayHello(&context, request, &reply).ok()) {
+                        ok_nums++;
+                    }
+                }
+            });
+        }
+
+        for (auto& client_thread : client_threads) {
+            client_thread.join();
+        }
+        return ok_nums.load();
+    }
+
+    void Stop() { stop_.store(true); }
+
+   private:
+    std::vector<std::unique_ptr<Greeter::Stub>> stubs_;
+
+    std::atomic<bool> stop_{false};
+};
+
+// 磁盘请求的吞吐量与线程数量的关系，range(0) 为是否使用异步运行时，
+// range(1) 为处理磁盘请求的线程数量
+static void BM_DISK_QPS(benchmark::State& state) {
+    BenchmarkServer server(state.range(0), state.range(1));
+    DiskLoadClients clients(&server);
+
+    int64_t ok_nums = 0;
+    for (auto _ : state) {
+        ok_nums += clients.Run(kRequestsPerClient);
+    }
+
+    state.SetItemsProcessed(ok_nums);
+    state.counters["qps"] =
+        benchmark::Counter(ok_nums, benchmark::Counter::kIsRate);
+}
+
+// 磁盘请求占满线程时心跳的延迟，range(0) 为是否使用异步运行时
+static void BM_HEART_BEAT_UNDER_DISK_LOAD(benchmark::State& state) {
+    BenchmarkServer server(state.range(0), 8);
+    DiskLoadClients clients(&server);
+    std::thread load_thread([&]() { clients.Run(INT32_MAX); });
+
+    auto stub = ChunkServerControlService::NewStub(server.CreateChannel());
+    for (auto _ : state) {
+        grpc::ClientContext context;
+        SendHeartBeatRequest request;
+        SendHeartBeatRespond respond;
+        benchmark::DoNotOptimize(
+            stub->SendHeartBeat(&context, request, &respond));
+    }
+
+    clients.Stop();
+    load_thread.join();
+}
+
+BENCHMARK(BM_DISK_QPS)
+    ->ArgsProduct({{0, 1}, {1, 2, 4, 8, 16, 32, 64}})
+    ->ArgNames({"async", "threads"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(BM_HEART_BEAT_UNDER_DISK_LOAD)
+    ->Arg(0)
+    ->Arg(1)
+    ->ArgNames({"async"})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,79 @@
+#include "src/common/checksum.h"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include "src/common/utils.h"
+
+using dfs::common::ChecksumType;
+using dfs::common::ComputeChecksum;
+using dfs::common::Crc32c;
+using dfs::common::Crc32cPortable;
+
+namespace {
+
+// 一个数据块的大小
+const size_t kDataSize = 64 * 1024 * 1024;
+
+const std::string& Data() {
+    static const std::string data = [] {
+        std::string data(kDataSize, '\0');
+        for (size_t i = 0; i < data.size(); i++) {
+            data[i] = static_cast<char>(i * 131 + 7);
+        }
+        return data;
+    }();
+    return data;
+}
+
+}  // namespace
+
+static void BM_CRC32C(benchmark::State& state) {
+    const auto& data = Data();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Crc32c(0, data.data(), data.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+static void BM_CRC32C_PORTABLE(benchmark::State& state) {
+    const auto& data = Data();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Crc32cPortable(0, data.data(), data.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+static void BM_XXH3(benchmark::State& state) {
+    const auto& data = Data();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ComputeChecksum(ChecksumType::XXH3, data));
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+static void BM_SHA256(benchmark::State& state) {
+    const auto& data = Data();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ComputeChecksum(ChecksumType::SHA256, data));
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+// 原来写入路径上使用的 ComputeHash
+static void BM_COMPUTE_HASH(benchmark::State& state) {
+    const auto& data = Data();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(dfs::common::ComputeHash(data));
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+BENCHMARK(BM_CRC32C)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CRC32C_PORTABLE)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_XXH3)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SHA256)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_COMPUTE_HASH)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,153 @@
+#include "src/common/compression.h"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+using dfs::common::CompressBlock;
+using dfs::common::CompressionCodec;
+using dfs::common::DecompressBlock;
+
+namespace {
+
+// 一个数据块的大小
+const size_t kDataSize = 64 * 1024 * 1024;
+// 分块大小，与块服务器默认的读缓存分块大小相同
+const size_t kBlockSize = 64 * 1024;
+
+// 数据类型：0 为日志，1 为 CSV，2 为随机数据
+const std::string& Data(int type) {
+    static const std::vector<std::string> datas = [] {
+        std::mt19937 random(42);
+        std::vector<std::string> datas(3);
+        for (int i = 0; datas[0].size() < kDataSize; i++) {
+            datas[0] += "2024-01-01 12:00:" + std::to_string(i % 60) +
+                        " INFO [chunk_server] write chunk " +
+                        std::to_string(random() % 100000) + " version " +
+                        std::to_string(i % 7) + " ok\n";
+        }
+        for (int i = 0; datas[1].size() < kDataSize; i++) {
+            datas[1] += std::to_string(i) + "," +
+                        std::to_string(random() % 1000) + ".5,user" +
+                        std::to_string(random() % 500) + ",true\n";
+        }
+        datas[2].resize(kDataSize);
+        for (auto& c : datas[2]) {
+            c = static_cast<char>(random());
+        }
+        for (auto& data : datas) {
+            data.resize(kDataSize);
+        }
+        return datas;
+    }();
+    return datas[type];
+}
+
+// 按分块压缩整个数据块，返回每个分块压缩后的长度
+std::vector<size_t> CompressChunk(CompressionCodec codec, int level,
+                                  const std::string& data,
+                                  std::string* compressed) {
+    std::vector<size_t> lengths;
+    for (size_t pos = 0; pos < data.size(); pos += kBlockSize) {
+        lengths.push_back(CompressBlock(
+            codec, data.data() + pos,
+            std::min(kBlockSize, data.size() - pos), level, compressed));
+    }
+    return lengths;
+}
+
+}  // namespace
+
+// 参数：压缩算法、zstd 压缩级别、数据类型
+static void BM_COMPRESS(benchmark::State& state) {
+    const auto codec = static_cast<CompressionCodec>(state.range(0));
+    const int level = state.range(1);
+    const auto& data = Data(state.range(2));
+
+    std::string compressed;
+    compressed.reserve(data.size());
+    for (auto _ : state) {
+        compressed.clear();
+        CompressChunk(codec, level, data, &compressed);
+        benchmark::DoNotOptimize(compressed.data());
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+    state.counters["ratio"] =
+        static_cast<double>(data.size()) / compressed.size();
+}
+
+static void BM_DECOMPRESS(benchmark::State& state) {
+    const auto codec = static_cast<CompressionCodec>(state.range(0));
+    const int level = state.range(1);
+    const auto& data = Data(state.range(2));
+
+    std::string compressed;
+    const auto lengths = CompressChunk(codec, level, data, &compressed);
+    std::string output;
+    output.reserve(data.size());
+    for (auto _ : state) {
+        output.clear();
+        size_t pos = 0;
+        for (size_t i = 0; i < lengths.size(); i++) {
+            DecompressBlock(codec, compressed.data() + pos, lengths[i],
+                            std::min(kBlockSize, data.size() - i * kBlockSize),
+                            &output);
+            pos += lengths[i];
+        }
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+    state.counters["ratio"] =
+        static_cast<double>(data.size()) / compressed.size();
+}
+
+// 随机读取一个分块：读取 4KB 只需要解压它所在的分块
+static void BM_RANDOM_BLOCK_READ(benchmark::State& state) {
+    const auto codec = static_cast<CompressionCodec>(state.range(0));
+    const auto& data = Data(0);
+
+    std::string compressed;
+    const auto lengths = CompressChunk(codec, 0, data, &compressed);
+    std::vector<size_t> offsets(lengths.size() + 1, 0);
+    for (size_t i = 0; i < lengths.size(); i++) {
+        offsets[i + 1] = offsets[i] + lengths[i];
+    }
+
+    std::mt19937 random(42);
+    std::string output;
+    for (auto _ : state) {
+        const size_t block = random() % lengths.size();
+        output.clear();
+        DecompressBlock(codec, compressed.data() + offsets[block],
+                        lengths[block], kBlockSize, &output);
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetBytesProcessed(state.iterations() * kBlockSize);
+}
+
+BENCHMARK(BM_COMPRESS)
+    ->ArgsProduct({{static_cast<int>(CompressionCodec::NONE),
+                    static_cast<int>(CompressionCodec::LZ4)},
+                   {0},
+                   {0, 1, 2}})
+    ->ArgsProduct({{static_cast<int>(CompressionCodec::ZSTD)},
+                   {1, 3, 9},
+                   {0, 1, 2}})
+    ->ArgNames({"codec", "level", "data"})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_DECOMPRESS)
+    ->ArgsProduct({{static_cast<int>(CompressionCodec::LZ4)}, {0}, {0, 1, 2}})
+    ->ArgsProduct({{static_cast<int>(CompressionCodec::ZSTD)},
+                   {1, 3, 9},
+                   {0, 1, 2}})
+    ->ArgNames({"codec", "level", "data"})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_RANDOM_BLOCK_READ)
+    ->Arg(static_cast<int>(CompressionCodec::LZ4))
+    ->Arg(static_cast<int>(CompressionCodec::ZSTD))
+    ->ArgNames({"codec"})
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
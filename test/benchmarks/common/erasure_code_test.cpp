@@ -0,0 +1,150 @@
+#include "src/common/erasure_code.h"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+using dfs::common::GfDotProduct;
+using dfs::common::GfDotProductImplName;
+using dfs::common::GfDotProductPortable;
+using dfs::common::GfExpandTables;
+using dfs::common::GfInverse;
+using dfs::common::ReedSolomon;
+
+namespace {
+
+const uint32_t kDataShards = 6;
+const uint32_t kParityShards = 3;
+
+// 每个分片的大小，与块服务器编码时的一段数据相同
+const size_t kCellSize = 1024 * 1024;
+
+struct Stripe {
+    Stripe() : shards(kDataShards + kParityShards) {
+        for (uint32_t i = 0; i < shards.size(); i++) {
+            shards[i].resize(kCellSize);
+            for (size_t j = 0; j < kCellSize; j++) {
+                shards[i][j] = static_cast<char>(j * 131 + i * 7 + 1);
+            }
+        }
+    }
+
+    std::vector<std::string> shards;
+};
+
+// 与 ReedSolomon 相同的 Cauchy 校验矩阵
+std::vector<uint8_t> ParityMatrix() {
+    std::vector<uint8_t> matrix;
+    for (uint32_t j = 0; j < kParityShards; j++) {
+        for (uint32_t i = 0; i < kDataShards; i++) {
+            matrix.push_back(GfInverse((kDataShards + j) ^ i));
+        }
+    }
+    return matrix;
+}
+
+}  // namespace
+
+static void BM_RS_ENCODE(benchmark::State& state) {
+    ReedSolomon codec(kDataShards, kParityShards);
+    Stripe stripe;
+    std::vector<const char*> data;
+    std::vector<char*> parity;
+    for (uint32_t i = 0; i < kDataShards; i++) {
+        data.push_back(stripe.shards[i].data());
+    }
+    for (uint32_t i = kDataShards; i < kDataShards + kParityShards; i++) {
+        parity.push_back(&stripe.shards[i][0]);
+    }
+
+    for (auto _ : state) {
+        codec.Encode(data.data(), parity.data(), kCellSize);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * kDataShards * kCellSize);
+    state.SetLabel(GfDotProductImplName());
+}
+
+static void BM_RS_ENCODE_PORTABLE(benchmark::State& state) {
+    const auto tables = GfExpandTables(ParityMatrix());
+    Stripe stripe;
+    std::vector<const char*> data;
+    std::vector<char*> parity;
+    for (uint32_t i = 0; i < kDataShards; i++) {
+        data.push_back(stripe.shards[i].data());
+    }
+    for (uint32_t i = kDataShards; i < kDataShards + kParityShards; i++) {
+        parity.push_back(&stripe.shards[i][0]);
+    }
+
+    for (auto _ : state) {
+        GfDotProductPortable(tables.data(), kDataShards, kParityShards,
+                             data.data(), parity.data(), kCellSize);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * kDataShards * kCellSize);
+}
+
+// 丢失 state.range(0) 个数据分片，用其余数据分片与校验分片重建
+static void BM_RS_DECODE(benchmark::State& state) {
+    const uint32_t lost = state.range(0);
+    ReedSolomon codec(kDataShards, kParityShards);
+    Stripe stripe;
+    std::vector<const char*> data;
+    std::vector<char*> parity;
+    for (uint32_t i = 0; i < kDataShards; i++) {
+        data.push_back(stripe.shards[i].data());
+    }
+    for (uint32_t i = kDataShards; i < kDataShards + kParityShards; i++) {
+        parity.push_back(&stripe.shards[i][0]);
+    }
+    codec.Encode(data.data(), parity.data(), kCellSize);
+
+    std::vector<uint32_t> survivors;
+    std::vector<const char*> survivor_data;
+    for (uint32_t i = lost; i < kDataShards + lost; i++) {
+        survivors.push_back(i);
+        survivor_data.push_back(stripe.shards[i].data());
+    }
+    std::vector<uint32_t> targets;
+    std::vector<std::string> results(lost, std::string(kCellSize, '\0'));
+    std::vector<char*> outputs;
+    for (uint32_t i = 0; i < lost; i++) {
+        targets.push_back(i);
+        outputs.push_back(&results[i][0]);
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(codec.Decode(survivors, survivor_data.data(),
+                                              targets, outputs.data(),
+                                              kCellSize));
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * kDataShards * kCellSize);
+    state.SetLabel(GfDotProductImplName());
+}
+
+// 单个系数的乘加，衡量 GfDotProduct 本身的吞吐
+static void BM_GF_DOT_PRODUCT(benchmark::State& state) {
+    const auto tables = GfExpandTables({0x8e});
+    std::string input(kCellSize, '\x5a');
+    std::string output(kCellSize, '\0');
+    const char* inputs[] = {input.data()};
+    char* outputs[] = {&output[0]};
+
+    for (auto _ : state) {
+        GfDotProduct(tables.data(), 1, 1, inputs, outputs, kCellSize);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * kCellSize);
+    state.SetLabel(GfDotProductImplName());
+}
+
+BENCHMARK(BM_RS_ENCODE)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_RS_ENCODE_PORTABLE)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_RS_DECODE)->DenseRange(1, kParityShards)->Unit(
+    benchmark::kMicrosecond);
+BENCHMARK(BM_GF_DOT_PRODUCT)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
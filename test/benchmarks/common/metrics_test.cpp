@@ -0,0 +1,49 @@
+#include "src/common/metrics.h"
+
+#include <benchmark/benchmark.h>
+
+using dfs::common::Counter;
+using dfs::common::Histogram;
+using dfs::common::MonotonicMicros;
+using dfs::common::ScopedLatency;
+
+namespace {
+
+Counter counter;
+
+Histogram histogram;
+
+}  // namespace
+
+static void BM_COUNTER_INCREMENT(benchmark::State& state) {
+    for (auto _ : state) {
+        counter.Increment();
+    }
+}
+
+static void BM_HISTOGRAM_RECORD(benchmark::State& state) {
+    uint64_t value = 0;
+    for (auto _ : state) {
+        histogram.Record(value++ & 0xFFFFF);
+    }
+}
+
+// 包括两次读取时钟
+static void BM_SCOPED_LATENCY(benchmark::State& state) {
+    for (auto _ : state) {
+        ScopedLatency latency(&histogram);
+    }
+}
+
+static void BM_MONOTONIC_MICROS(benchmark::State& state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(MonotonicMicros());
+    }
+}
+
+BENCHMARK(BM_COUNTER_INCREMENT)->ThreadRange(1, 8);
+BENCHMARK(BM_HISTOGRAM_RECORD)->ThreadRange(1, 8);
+BENCHMARK(BM_SCOPED_LATENCY)->ThreadRange(1, 8);
+BENCHMARK(BM_MONOTONIC_MICROS);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,120 @@
+#include "src/common/system_logger.h"
+
+#include <benchmark/benchmark.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "src/common/checksum.h"
+
+using dfs::common::Crc32c;
+using dfs::common::SystemLogger;
+
+namespace {
+
+// 模拟一个请求：计算一个 4KB 数据块的校验和，并输出原来热路径上的
+// 三条 INFO 日志
+const size_t kDataSize = 4096;
+
+const std::string& Data() {
+    static const std::string data(kDataSize, 'x');
+    return data;
+}
+
+void ConfigureSync(const benchmark::State&) {
+    SystemLogger::Options options;
+    options.async = false;
+    SystemLogger::GetInstance().Configure(options);
+}
+
+void ConfigureAsync(const benchmark::State&) {
+    SystemLogger::Options options;
+    options.async = true;
+    SystemLogger::GetInstance().Configure(options);
+}
+
+void FlushLogs(const benchmark::State&) { SystemLogger::GetInstance().Flush(); }
+
+uint32_t HandleRequest(uint64_t request_id) {
+    const auto& data = Data();
+    LOG(INFO) << "try to read chunk, chunk_handle: " << request_id
+              << ",version: 1,offset: 0,length: " << data.size();
+    const uint32_t checksum = Crc32c(0, data.data(), data.size());
+    LOG(INFO) << "check data checksum: " << checksum;
+    LOG(INFO) << "data length: " << data.size();
+    return checksum;
+}
+
+uint32_t HandleRequestVlog(uint64_t request_id) {
+    const auto& data = Data();
+    DFS_VLOG(1) << "read chunk " << request_id << ", version: 1, offset: 0"
+                << ", length: " << data.size();
+    const uint32_t checksum = Crc32c(0, data.data(), data.size());
+    DFS_VLOG(2) << "check data checksum: " << checksum;
+    return checksum;
+}
+
+}  // namespace
+
+// 不输出日志，作为对照
+static void BM_REQUEST_NO_LOG(benchmark::State& state) {
+    const auto& data = Data();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Crc32c(0, data.data(), data.size()));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// glog 同步写入标准错误
+static void BM_REQUEST_SYNC_LOG(benchmark::State& state) {
+    uint64_t request_id = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(HandleRequest(request_id++));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// 异步写入，缓冲区满时丢弃
+static void BM_REQUEST_ASYNC_LOG(benchmark::State& state) {
+    uint64_t request_id = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(HandleRequest(request_id++));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// 热路径改为 DFS_VLOG 后，默认级别下不输出
+static void BM_REQUEST_VLOG_OFF(benchmark::State& state) {
+    uint64_t request_id = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(HandleRequestVlog(request_id++));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_REQUEST_NO_LOG)->ThreadRange(1, 8);
+BENCHMARK(BM_REQUEST_SYNC_LOG)
+    ->Setup(ConfigureSync)
+    ->ThreadRange(1, 8);
+BENCHMARK(BM_REQUEST_ASYNC_LOG)
+    ->Setup(ConfigureAsync)
+    ->Teardown(FlushLogs)
+    ->ThreadRange(1, 8);
+BENCHMARK(BM_REQUEST_VLOG_OFF)
+    ->Setup(ConfigureSync)
+    ->ThreadRange(1, 8);
+
+int main(int argc, char** argv) {
+    SystemLogger::GetInstance().Initialize(argv[0]);
+    // 日志写入 /dev/null，测量的是记录日志本身的开销，benchmark 的结果
+    // 输出到标准输出
+    int fd = open("/dev/null", O_WRONLY);
+    dup2(fd, STDERR_FILENO);
+    close(fd);
+
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    SystemLogger::GetInstance().Shutdown();
+    return 0;
+}
@@ -0,0 +1,51 @@
+#include "src/common/tracing.h"
+
+#include <benchmark/benchmark.h>
+
+using dfs::common::Span;
+using dfs::common::Tracer;
+
+namespace {
+
+void StartTracer(double sample_rate) {
+    Tracer::Options options;
+    options.sample_rate = sample_rate;
+    Tracer::GetInstance()->Start("benchmark_tracing", options);
+}
+
+void SampleNone(const benchmark::State&) { StartTracer(0); }
+
+// 几乎不采样，span 都有 context 但不记录
+void SampleRarely(const benchmark::State&) { StartTracer(1e-9); }
+
+void SampleAll(const benchmark::State&) { StartTracer(1); }
+
+}  // namespace
+
+// 采样率为 0，没有上游 context，span 不做任何事
+static void BM_SPAN_DISABLED(benchmark::State& state) {
+    for (auto _ : state) {
+        Span span("disabled");
+    }
+}
+
+// 生成 id 并设置线程的 context，但不读取时钟与写入缓冲区
+static void BM_SPAN_NOT_SAMPLED(benchmark::State& state) {
+    for (auto _ : state) {
+        Span span("not_sampled");
+    }
+}
+
+// 读取两次时钟并写入环形缓冲区，没有读者，旧的 span 被覆盖
+static void BM_SPAN_SAMPLED(benchmark::State& state) {
+    for (auto _ : state) {
+        Span span("sampled");
+        span.SetAttribute("bytes", 4096);
+    }
+}
+
+BENCHMARK(BM_SPAN_DISABLED)->Setup(SampleNone)->ThreadRange(1, 8);
+BENCHMARK(BM_SPAN_NOT_SAMPLED)->Setup(SampleRarely)->ThreadRange(1, 8);
+BENCHMARK(BM_SPAN_SAMPLED)->Setup(SampleAll)->ThreadRange(1, 8);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,187 @@
+#include "src/server/master_server/chunk_placement_policy.h"
+
+#include <absl/container/flat_hash_map.h>
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using dfs::server::ChunkPlacementPolicy;
+using dfs::server::FailureDomain;
+using protos::ChunkServer;
+using protos::ChunkServerLoad;
+using protos::ChunkServerLocation;
+
+// 模拟集群：25 个机架，每个机架 10 台主机，每台主机 4 个块服务器
+const int kRackNums = 25;
+const int kHostsPerRack = 10;
+const int kServersPerHost = 4;
+const int kServerNums = kRackNums * kHostsPerRack * kServersPerHost;
+
+const uint32_t kChunkSizeMB = 64;
+const int kReplicaNums = 3;
+// 每分配多少个数据块，块服务器汇报一次负载
+const int kChunksPerReport = 500;
+
+struct SimulatedServer {
+    ChunkServer chunk_server;
+    FailureDomain domain;
+    uint32_t chunk_nums = 0;
+    // 自上一次汇报以来写入的数据块数量
+    uint32_t recent_writes = 0;
+};
+
+std::vector<SimulatedServer> CreateCluster(uint64_t seed) {
+    std::mt19937_64 random_engine(seed);
+    // 磁盘剩余空间在 512GB 到 2TB 之间
+    std::uniform_int_distribution<uint32_t> disk_distribution(512 * 1024,
+                                                              2048 * 1024);
+
+    std::vector<SimulatedServer> servers;
+    for (int i = 0; i < kServerNums; i++) {
+        const int host = i / kServersPerHost;
+        const int rack = host / kHostsPerRack;
+
+        SimulatedServer server;
+        auto location = server.chunk_server.mutable_location();
+        location->set_server_hostname("10.0." + std::to_string(rack) + "." +
+                                      std::to_string(host % kHostsPerRack));
+        location->set_server_port(50100 + i % kServersPerHost);
+        server.chunk_server.set_available_disk_mb(
+            disk_distribution(random_engine));
+        server.chunk_server.mutable_load();
+        server.domain.rack = "rack" + std::to_string(rack);
+        server.domain.host = location->server_hostname();
+        servers.push_back(server);
+    }
+    return servers;
+}
+
+std::string ToServerAddress(const ChunkServerLocation& location) {
+    return location.server_hostname() + ":" +
+           std::to_string(location.server_port());
+}
+
+// 统计数据块在块服务器间的分布
+void ReportBalance(benchmark::State& state,
+                   const std::vector<SimulatedServer>& servers) {
+    double sum = 0;
+    uint32_t max_chunk_nums = 0;
+    for (const auto& server : servers) {
+        sum += server.chunk_nums;
+        max_chunk_nums = std::max(max_chunk_nums, server.chunk_nums);
+    }
+
+    const double mean = sum / servers.size();
+    double variance = 0;
+    for (const auto& server : servers) {
+        variance += (server.chunk_nums - mean) * (server.chunk_nums - mean);
+    }
+    variance /= servers.size();
+
+    uint32_t idle_server_nums = 0;
+    for (const auto& server : servers) {
+        if (server.chunk_nums == 0) {
+            idle_server_nums++;
+        }
+    }
+
+    state.counters["mean_chunks"] = mean;
+    state.counters["max_chunks"] = max_chunk_nums;
+    state.counters["max_over_mean"] = mean > 0 ? max_chunk_nums / mean : 0;
+    state.counters["stddev_chunks"] = std::sqrt(variance);
+    state.counters["idle_servers"] = idle_server_nums;
+}
+
+// 单次放置决策的耗时
+static void BM_CHOOSE_SERVERS(benchmark::State& state) {
+    ChunkPlacementPolicy policy(kChunkSizeMB, 1);
+    for (const auto& server : CreateCluster(1)) {
+        policy.AddServer(server.chunk_server, server.domain);
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(policy.ChooseServers(kReplicaNums, {}));
+    }
+}
+
+// 使用放置策略放置 state.range(0) 个数据块，统计负载均衡程度
+static void BM_SIMULATE_PLACEMENT(benchmark::State& state) {
+    const int chunk_nums = state.range(0);
+    std::vector<SimulatedServer> servers;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        servers = CreateCluster(1);
+        ChunkPlacementPolicy policy(kChunkSizeMB, 1);
+        absl::flat_hash_map<std::string, size_t> server_indexes;
+        for (size_t i = 0; i < servers.size(); i++) {
+            policy.AddServer(servers[i].chunk_server, servers[i].domain);
+            server_indexes[ToServerAddress(
+                servers[i].chunk_server.location())] = i;
+        }
+        state.ResumeTiming();
+
+        for (int chunk = 0; chunk < chunk_nums; chunk++) {
+            for (const auto& location :
+                 policy.ChooseServers(kReplicaNums, {})) {
+                auto& server = servers[server_indexes[ToServerAddress(location)]];
+                server.chunk_nums++;
+                server.recent_writes++;
+                server.chunk_server.set_available_disk_mb(
+                    server.chunk_server.available_disk_mb() - kChunkSizeMB);
+            }
+
+            // 块服务器定期汇报剩余空间与写负载
+            if ((chunk + 1) % kChunksPerReport == 0) {
+                for (auto& server : servers) {
+                    ChunkServerLoad load;
+                    load.set_write_iops(server.recent_writes);
+                    policy.UpdateServerLoad(
+                        server.chunk_server.location(),
+                        server.chunk_server.available_disk_mb(), load);
+                    server.recent_writes = 0;
+                }
+            }
+        }
+    }
+
+    ReportBalance(state, servers);
+}
+
+// 对照组：与原先的实现相同，按哈希表遍历顺序取前几个块服务器
+static void BM_SIMULATE_FIRST_N(benchmark::State& state) {
+    const int chunk_nums = state.range(0);
+    std::vector<SimulatedServer> servers;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        servers = CreateCluster(1);
+        absl::flat_hash_map<std::string, size_t> server_indexes;
+        for (size_t i = 0; i < servers.size(); i++) {
+            server_indexes[ToServerAddress(
+                servers[i].chunk_server.location())] = i;
+        }
+        state.ResumeTiming();
+
+        for (int chunk = 0; chunk < chunk_nums; chunk++) {
+            int assigned_nums = 0;
+            for (const auto& server_pair : server_indexes) {
+                if (assigned_nums >= kReplicaNums) {
+                    break;
+                }
+                servers[server_pair.second].chunk_nums++;
+                assigned_nums++;
+            }
+        }
+    }
+
+    ReportBalance(state, servers);
+}
+
+BENCHMARK(BM_CHOOSE_SERVERS);
+BENCHMARK(BM_SIMULATE_PLACEMENT)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SIMULATE_FIRST_N)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
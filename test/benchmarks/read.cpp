@@ -15,14 +15,22 @@ static void BM_READ_FILE(benchmark::State& state) {
     auto init_status = dfs::client::init_client();
     dfs::client::open("/benchmark_read", dfs::client::OpenFlag::CREATE);
     dfs::client::set("/benchmark_read", 128 * 1024 * 1024);
+    auto file_or =
+        dfs::client::open("/benchmark_read", dfs::client::OpenFlag::READ);
+    if (!file_or.ok()) {
+        state.SkipWithError(file_or.status().ToString().c_str());
+        return;
+    }
 
     uint64_t ok = 0;
     uint64_t failed = 0;
-    const int fileSizeMB = state.range(0);
+    const size_t read_size = state.range(0) * 1024 * 1024;
+    // 数据直接读入调用者的 buffer，不再为每次读取分配内存
+    std::string buffer(read_size, '\0');
 
     for (auto _ : state) {
-        auto status_or = dfs::client::read("/benchmark_read", 0,
-                                           state.range(0) * 1024 * 1024);
+        auto status_or =
+            dfs::client::pread(file_or.value(), &buffer[0], read_size, 0);
 
         state.PauseTiming();
         if (status_or.ok()) {
@@ -32,13 +40,50 @@ static void BM_READ_FILE(benchmark::State& state) {
         }
         state.ResumeTiming();
     }
+    dfs::client::close(file_or.value());
 
+    state.SetBytesProcessed(state.iterations() * read_size);
     state.counters["ok"] = ok;
     state.counters["failed"] = failed;
 }
 
 BENCHMARK(BM_READ_FILE)->RangeMultiplier(2)->Range(1, 128)->Iterations(100);
 
+// 以 64KB 为单位通过 FileHandle 顺序读取整个文件，开启预读时应接近单次大读取
+// 的吞吐量
+static void BM_SEQUENTIAL_SMALL_READ(benchmark::State& state) {
+    auto init_status = dfs::client::init_client();
+    dfs::client::open("/benchmark_read", dfs::client::OpenFlag::CREATE);
+    dfs::client::set("/benchmark_read", 128 * 1024 * 1024);
+
+    const size_t read_size = state.range(0) * 1024;
+    const size_t file_size = 64 * 1024 * 1024;
+    std::string buffer(read_size, '\0');
+    uint64_t failed = 0;
+
+    for (auto _ : state) {
+        auto file_or = dfs::client::open("/benchmark_read",
+                                         dfs::client::OpenFlag::READ);
+        if (!file_or.ok()) {
+            failed++;
+            continue;
+        }
+        for (size_t offset = 0; offset < file_size; offset += read_size) {
+            if (!dfs::client::pread(file_or.value(), &buffer[0], read_size,
+                                    offset)
+                     .ok()) {
+                failed++;
+            }
+        }
+        dfs::client::close(file_or.value());
+    }
+
+    state.SetBytesProcessed(state.iterations() * file_size);
+    state.counters["failed"] = failed;
+}
+
+BENCHMARK(BM_SEQUENTIAL_SMALL_READ)->Arg(64)->Arg(1024)->Iterations(5);
+
 int main(int argc, char** argv) {
     // 初始化配置
     dfs::common::ConfigManager::GetInstance()->InitConfigManager(
@@ -18,6 +18,10 @@ static void BM_WRITE_FILE(benchmark::State& state) {
         // 写入 fileSizeMB 数据
         auto status_or =
             dfs::client::set("/benchmark_write", fileSizeMB * 1024 * 1024);
+        // 写回缓冲区中的数据也计入写入时间
+        if (status_or.ok()) {
+            status_or = dfs::client::fsync("/benchmark_write");
+        }
 
         state.PauseTiming();
         if (status_or.ok()) {
@@ -34,6 +38,43 @@ static void BM_WRITE_FILE(benchmark::State& state) {
 
 BENCHMARK(BM_WRITE_FILE)->RangeMultiplier(2)->Range(1, 128)->Iterations(100);
 
+// 以 4KB 为单位通过 FileHandle 顺序写入 16MB，写回缓冲区将其合并为少量的
+// 大写入，租约有效期内的写入不再访问 master
+static void BM_SMALL_WRITE(benchmark::State& state) {
+    auto init_status = dfs::client::init_client();
+    auto file_or = dfs::client::open(
+        "/benchmark_small_write",
+        dfs::client::OpenFlag::WRITE | dfs::client::OpenFlag::CREATE);
+    if (!file_or.ok()) {
+        state.SkipWithError(file_or.status().ToString().c_str());
+        return;
+    }
+    auto* file = file_or.value();
+
+    const size_t write_size = state.range(0);
+    const size_t file_size = 16 * 1024 * 1024;
+    std::string data(write_size, 'a');
+    uint64_t failed = 0;
+
+    for (auto _ : state) {
+        for (size_t offset = 0; offset < file_size; offset += write_size) {
+            if (!dfs::client::pwrite(file, data.data(), write_size, offset)
+                     .ok()) {
+                failed++;
+            }
+        }
+        if (!dfs::client::fsync(file).ok()) {
+            failed++;
+        }
+    }
+    dfs::client::close(file);
+
+    state.SetBytesProcessed(state.iterations() * file_size);
+    state.counters["failed"] = failed;
+}
+
+BENCHMARK(BM_SMALL_WRITE)->Arg(4 * 1024)->Iterations(3);
+
 int main(int argc, char** argv) {
     // 初始化配置
     dfs::common::ConfigManager::GetInstance()->InitConfigManager(
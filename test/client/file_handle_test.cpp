@@ -0,0 +1,88 @@
+#include "src/client/file_handle.h"
+
+#include <gtest/gtest.h>
+
+using dfs::client::FileHandle;
+using dfs::client::OpenFlag;
+
+class FileHandleTest : public ::testing::Test {
+   protected:
+    FileHandle::ChunkMetadata Metadata(const std::string& chunk_handle,
+                                       uint32_t version,
+                                       absl::Time expire_time) {
+        FileHandle::ChunkMetadata metadata;
+        metadata.chunk_handle = chunk_handle;
+        metadata.version = version;
+        metadata.expire_time = expire_time;
+        return metadata;
+    }
+
+    const absl::Time now_ = absl::FromUnixSeconds(1000);
+};
+
+TEST_F(FileHandleTest, FlagsTest) {
+    FileHandle read_only("/file", OpenFlag::READ);
+    EXPECT_EQ(read_only.filename(), "/file");
+    EXPECT_TRUE(read_only.readable());
+    EXPECT_FALSE(read_only.writable());
+
+    FileHandle read_write("/file", OpenFlag::READ | OpenFlag::WRITE |
+                                       OpenFlag::CREATE);
+    EXPECT_TRUE(read_write.readable());
+    EXPECT_TRUE(read_write.writable());
+}
+
+TEST_F(FileHandleTest, MetadataExpireTest) {
+    FileHandle file("/file", OpenFlag::READ);
+    FileHandle::ChunkMetadata metadata;
+    EXPECT_FALSE(file.GetChunkMetadata(0, false, now_, &metadata));
+
+    file.SetChunkMetadata(0, false,
+                          Metadata("handle0", 1, now_ + absl::Seconds(10)));
+    ASSERT_TRUE(file.GetChunkMetadata(0, false, now_, &metadata));
+    EXPECT_EQ(metadata.chunk_handle, "handle0");
+    EXPECT_EQ(metadata.version, 1);
+
+    // 过期后需要重新向 master 获取
+    EXPECT_FALSE(file.GetChunkMetadata(0, false, now_ + absl::Seconds(10),
+                                       &metadata));
+    EXPECT_FALSE(file.GetChunkMetadata(1, false, now_, &metadata));
+}
+
+TEST_F(FileHandleTest, ReadWriteMetadataTest) {
+    FileHandle file("/file", OpenFlag::READ | OpenFlag::WRITE);
+    file.SetChunkMetadata(0, false,
+                          Metadata("handle0", 1, now_ + absl::Seconds(600)));
+    file.SetChunkMetadata(0, true,
+                          Metadata("handle0", 2, now_ + absl::Seconds(55)));
+
+    // 读写元数据分开缓存，写元数据带有租约中的版本
+    FileHandle::ChunkMetadata metadata;
+    ASSERT_TRUE(file.GetChunkMetadata(0, false, now_, &metadata));
+    EXPECT_EQ(metadata.version, 1);
+    ASSERT_TRUE(file.GetChunkMetadata(0, true, now_, &metadata));
+    EXPECT_EQ(metadata.version, 2);
+
+    // 写入后只有读元数据失效
+    file.InvalidateChunkMetadata(0, false);
+    EXPECT_FALSE(file.GetChunkMetadata(0, false, now_, &metadata));
+    EXPECT_TRUE(file.GetChunkMetadata(0, true, now_, &metadata));
+
+    file.ClearChunkMetadata();
+    EXPECT_FALSE(file.GetChunkMetadata(0, true, now_, &metadata));
+}
+
+TEST_F(FileHandleTest, LeaseNumsTest) {
+    FileHandle file("/file", OpenFlag::WRITE);
+    file.SetChunkMetadata(0, true,
+                          Metadata("handle0", 2, now_ + absl::Seconds(10)));
+    file.SetChunkMetadata(1, true,
+                          Metadata("handle1", 2, now_ + absl::Seconds(30)));
+    file.SetChunkMetadata(2, false,
+                          Metadata("handle2", 1, now_ + absl::Seconds(30)));
+
+    EXPECT_EQ(file.GetLeaseNums(now_), 2);
+    EXPECT_EQ(file.GetLeaseNums(now_ + absl::Seconds(20)), 1);
+    file.InvalidateChunkMetadata(1, true);
+    EXPECT_EQ(file.GetLeaseNums(now_), 1);
+}
@@ -0,0 +1,109 @@
+#include "src/client/file_read_stream.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstring>
+#include <string>
+
+using dfs::client::FileReadStream;
+using dfs::common::Executor;
+
+class FileReadStreamTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        file_data_.resize(4 * 1024 * 1024);
+        for (size_t i = 0; i < file_data_.size(); i++) {
+            file_data_[i] = 'a' + i % 26;
+        }
+    }
+
+    // 模拟读取文件，越过文件末尾时返回错误
+    FileReadStream::ReadFunction ReadFunction() {
+        return [this](size_t offset, size_t nbytes, char* buffer)
+                   -> google::protobuf::util::StatusOr<size_t> {
+            read_calls_++;
+            if (offset + nbytes > file_data_.size()) {
+                return google::protobuf::util::OutOfRangeError("out of range");
+            }
+            memcpy(buffer, file_data_.data() + offset, nbytes);
+            return nbytes;
+        };
+    }
+
+    FileReadStream::Options StreamOptions() {
+        FileReadStream::Options options;
+        options.initial_window = 128 * 1024;
+        options.max_window = 1024 * 1024;
+        return options;
+    }
+
+    std::string Read(FileReadStream* stream, size_t offset, size_t nbytes) {
+        std::string buffer(nbytes, '\0');
+        auto read_or = stream->Read(offset, nbytes, &buffer[0]);
+        EXPECT_TRUE(read_or.ok()) << read_or.status().ToString();
+        buffer.resize(read_or.ok() ? read_or.value() : 0);
+        return buffer;
+    }
+
+    std::string file_data_;
+
+    std::atomic<int> read_calls_{0};
+
+    Executor executor_{"readahead", 2, 16};
+};
+
+// 顺序的小读取大部分由预读满足，窗口翻倍直到上限
+TEST_F(FileReadStreamTest, SequentialTest) {
+    FileReadStream stream(StreamOptions(), ReadFunction(), &executor_);
+    const size_t read_size = 64 * 1024;
+    for (size_t offset = 0; offset + read_size <= 3 * 1024 * 1024;
+         offset += read_size) {
+        EXPECT_EQ(Read(&stream, offset, read_size),
+                  file_data_.substr(offset, read_size));
+    }
+
+    EXPECT_EQ(stream.window(), 1024 * 1024);
+    EXPECT_GE(stream.GetPrefetchedBytes(), 3 * 1024 * 1024 - 2 * read_size);
+    // 每次读取一个窗口，远少于读取次数
+    EXPECT_LT(read_calls_.load(), 20);
+}
+
+// 随机读取时窗口恢复为初始大小
+TEST_F(FileReadStreamTest, RandomTest) {
+    FileReadStream stream(StreamOptions(), ReadFunction(), &executor_);
+    for (size_t offset = 0; offset < 1024 * 1024; offset += 64 * 1024) {
+        Read(&stream, offset, 64 * 1024);
+    }
+    EXPECT_GT(stream.window(), 128 * 1024);
+
+    EXPECT_EQ(Read(&stream, 3 * 1024 * 1024 + 7, 100),
+              file_data_.substr(3 * 1024 * 1024 + 7, 100));
+    EXPECT_EQ(stream.window(), 128 * 1024);
+    EXPECT_EQ(Read(&stream, 11, 100), file_data_.substr(11, 100));
+}
+
+// 预读越过文件末尾失败时，读取仍然返回正确的数据
+TEST_F(FileReadStreamTest, EndOfFileTest) {
+    FileReadStream stream(StreamOptions(), ReadFunction(), &executor_);
+    const size_t start = file_data_.size() - 256 * 1024;
+    for (size_t offset = start; offset < file_data_.size();
+         offset += 32 * 1024) {
+        EXPECT_EQ(Read(&stream, offset, 32 * 1024),
+                  file_data_.substr(offset, 32 * 1024));
+    }
+
+    std::string buffer(10, '\0');
+    EXPECT_FALSE(stream.Read(file_data_.size(), 10, &buffer[0]).ok());
+}
+
+// 文件被修改后不再使用预读的数据
+TEST_F(FileReadStreamTest, InvalidateTest) {
+    FileReadStream stream(StreamOptions(), ReadFunction(), &executor_);
+    EXPECT_EQ(Read(&stream, 0, 1024), file_data_.substr(0, 1024));
+    EXPECT_EQ(Read(&stream, 1024, 1024), file_data_.substr(1024, 1024));
+
+    stream.Invalidate();
+    file_data_.replace(2048, 1024, std::string(1024, 'x'));
+    EXPECT_EQ(Read(&stream, 2048, 1024), std::string(1024, 'x'));
+}
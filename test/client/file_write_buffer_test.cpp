@@ -0,0 +1,164 @@
+#include "src/client/file_write_buffer.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using dfs::client::FileWriteBuffer;
+
+class FileWriteBufferTest : public ::testing::Test {
+   protected:
+    struct WriteCall {
+        size_t offset;
+        std::string data;
+    };
+
+    // 模拟写入文件，fail_writes_ 为 true 时返回错误，short_writes_ 为 true
+    // 时只写入一半
+    FileWriteBuffer::WriteFunction WriteFunction() {
+        return [this](size_t offset, const char* data, size_t nbytes)
+                   -> google::protobuf::util::StatusOr<size_t> {
+            if (fail_writes_) {
+                return google::protobuf::util::UnavailableError("unavailable");
+            }
+            if (short_writes_) {
+                nbytes /= 2;
+            }
+            writes_.push_back({offset, std::string(data, nbytes)});
+            if (file_data_.size() < offset + nbytes) {
+                file_data_.resize(offset + nbytes, '\0');
+            }
+            file_data_.replace(offset, nbytes, data, nbytes);
+            return nbytes;
+        };
+    }
+
+    FileWriteBuffer::Options BufferOptions() {
+        FileWriteBuffer::Options options;
+        options.max_buffer_bytes = 64 * 1024;
+        options.flush_interval = absl::Hours(1);
+        return options;
+    }
+
+    std::vector<WriteCall> writes_;
+
+    std::string file_data_;
+
+    bool fail_writes_ = false;
+
+    bool short_writes_ = false;
+};
+
+// 相邻的小写入合并为一次写入，达到缓冲区大小时刷新
+TEST_F(FileWriteBufferTest, CoalesceTest) {
+    FileWriteBuffer buffer(BufferOptions(), WriteFunction());
+    std::string expected;
+    for (int i = 0; i < 1024; i++) {
+        const std::string data(100, 'a' + i % 26);
+        EXPECT_TRUE(buffer.Write(i * 100, data.data(), data.size()).ok());
+        expected += data;
+    }
+
+    // 102400 字节只在超过 64KB 时刷新了一次
+    EXPECT_EQ(writes_.size(), 1);
+    EXPECT_EQ(buffer.GetBufferedBytes(), 102400 - 65600);
+    EXPECT_TRUE(buffer.Flush().ok());
+    EXPECT_EQ(writes_.size(), 2);
+    EXPECT_EQ(buffer.GetFlushes(), 2);
+    EXPECT_EQ(file_data_, expected);
+}
+
+// 重叠的写入覆盖缓冲区中的数据，不相邻的写入先刷新缓冲区
+TEST_F(FileWriteBufferTest, OverlapTest) {
+    FileWriteBuffer buffer(BufferOptions(), WriteFunction());
+    EXPECT_TRUE(buffer.Write(0, "aaaaaaaa", 8).ok());
+    EXPECT_TRUE(buffer.Write(4, "bbbbbbbb", 8).ok());
+    EXPECT_TRUE(buffer.Write(2, "cc", 2).ok());
+    EXPECT_TRUE(writes_.empty());
+
+    EXPECT_TRUE(buffer.Write(100, "dd", 2).ok());
+    ASSERT_EQ(writes_.size(), 1);
+    EXPECT_EQ(writes_[0].offset, 0);
+    EXPECT_EQ(writes_[0].data, "aaccbbbbbbbb");
+
+    EXPECT_TRUE(buffer.Flush().ok());
+    ASSERT_EQ(writes_.size(), 2);
+    EXPECT_EQ(writes_[1].offset, 100);
+    EXPECT_EQ(writes_[1].data, "dd");
+}
+
+// 大写入不经过缓冲区
+TEST_F(FileWriteBufferTest, LargeWriteTest) {
+    FileWriteBuffer buffer(BufferOptions(), WriteFunction());
+    EXPECT_TRUE(buffer.Write(0, "head", 4).ok());
+    const std::string data(128 * 1024, 'x');
+    EXPECT_TRUE(buffer.Write(4, data.data(), data.size()).ok());
+    ASSERT_EQ(writes_.size(), 2);
+    EXPECT_EQ(writes_[0].data, "head");
+    EXPECT_EQ(writes_[1].data, data);
+    EXPECT_EQ(buffer.GetBufferedBytes(), 0);
+}
+
+// 超过刷新间隔后，下一次写入刷新缓冲区
+TEST_F(FileWriteBufferTest, FlushIntervalTest) {
+    auto options = BufferOptions();
+    options.flush_interval = absl::ZeroDuration();
+    FileWriteBuffer buffer(options, WriteFunction());
+    EXPECT_TRUE(buffer.Write(0, "abc", 3).ok());
+    EXPECT_EQ(writes_.size(), 1);
+}
+
+// 刷新失败的错误返回给触发刷新的调用，并在 Flush 时再返回一次
+TEST_F(FileWriteBufferTest, ErrorTest) {
+    FileWriteBuffer buffer(BufferOptions(), WriteFunction());
+    EXPECT_TRUE(buffer.Write(0, "abc", 3).ok());
+
+    // 触发刷新的写入失败，本次写入的数据也没有进入缓冲区
+    fail_writes_ = true;
+    EXPECT_FALSE(buffer.Write(10, "def", 3).ok());
+    EXPECT_EQ(buffer.GetBufferedBytes(), 0);
+    fail_writes_ = false;
+    EXPECT_FALSE(buffer.Flush().ok());
+    EXPECT_TRUE(buffer.Flush().ok());
+    EXPECT_TRUE(writes_.empty());
+
+    EXPECT_TRUE(buffer.Write(10, "def", 3).ok());
+    EXPECT_TRUE(buffer.Flush().ok());
+    ASSERT_EQ(writes_.size(), 1);
+    EXPECT_EQ(writes_[0].data, "def");
+}
+
+// 只写入一部分视为失败，错误在 Flush 时再返回一次
+TEST_F(FileWriteBufferTest, ShortWriteTest) {
+    FileWriteBuffer buffer(BufferOptions(), WriteFunction());
+    short_writes_ = true;
+    EXPECT_TRUE(buffer.Write(0, "abcd", 4).ok());
+    auto status = buffer.Flush();
+    EXPECT_TRUE(google::protobuf::util::IsDataLoss(status));
+    EXPECT_TRUE(buffer.Flush().ok());
+
+    const std::string data(128 * 1024, 'x');
+    EXPECT_FALSE(buffer.Write(0, data.data(), data.size()).ok());
+    EXPECT_FALSE(buffer.Flush().ok());
+}
+
+// 没有后续写入时，由 FlushExpired 按刷新间隔刷新，Discard 丢弃缓冲的数据
+TEST_F(FileWriteBufferTest, FlushExpiredTest) {
+    auto options = BufferOptions();
+    options.flush_interval = absl::Milliseconds(100);
+    FileWriteBuffer buffer(options, WriteFunction());
+    EXPECT_TRUE(buffer.Write(0, "abc", 3).ok());
+
+    buffer.FlushExpired(absl::Now());
+    EXPECT_TRUE(writes_.empty());
+    buffer.FlushExpired(absl::Now() + absl::Milliseconds(100));
+    ASSERT_EQ(writes_.size(), 1);
+    EXPECT_EQ(writes_[0].data, "abc");
+
+    EXPECT_TRUE(buffer.Write(3, "def", 3).ok());
+    buffer.Discard();
+    EXPECT_EQ(buffer.GetBufferedBytes(), 0);
+    EXPECT_TRUE(buffer.Flush().ok());
+    EXPECT_EQ(writes_.size(), 1);
+}
@@ -0,0 +1,35 @@
+#include "src/client/hedge_budget.h"
+
+#include <gtest/gtest.h>
+
+using dfs::client::HedgeBudget;
+
+// 积攒的令牌用完后，对冲请求不超过读取次数的 ratio
+TEST(HedgeBudgetTest, RatioTest) {
+    HedgeBudget budget(0.05, 10);
+    uint64_t hedges = 0;
+    for (int i = 0; i < 10000; i++) {
+        budget.RecordRead();
+        if (budget.TryAcquire()) {
+            hedges++;
+        }
+    }
+
+    EXPECT_EQ(budget.GetReads(), 10000);
+    EXPECT_EQ(budget.GetHedgesIssued(), hedges);
+    EXPECT_LE(hedges, 10000 * 0.05 + 10);
+    EXPECT_GE(hedges, 10000 * 0.05);
+}
+
+// 初始令牌允许短时间内连续对冲
+TEST(HedgeBudgetTest, BurstTest) {
+    HedgeBudget budget(0, 3);
+    EXPECT_TRUE(budget.TryAcquire());
+    EXPECT_TRUE(budget.TryAcquire());
+    EXPECT_TRUE(budget.TryAcquire());
+    EXPECT_FALSE(budget.TryAcquire());
+
+    budget.RecordWin();
+    EXPECT_EQ(budget.GetHedgesIssued(), 3);
+    EXPECT_EQ(budget.GetHedgesWon(), 1);
+}
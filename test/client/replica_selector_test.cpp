@@ -0,0 +1,139 @@
+#include "src/client/replica_selector.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+
+using dfs::client::ReplicaSelector;
+
+class ReplicaSelectorTest : public ::testing::Test {
+   protected:
+    // 客户端位于 host0/rack0
+    static ReplicaSelector::Options SelectorOptions() {
+        ReplicaSelector::Options options;
+        options.local_host = "host0";
+        options.local_rack = "rack0";
+        return options;
+    }
+
+    // 四个块服务器，分别位于 host0/rack0、host1/rack0、host2/rack1、host3/rack1
+    static std::vector<ReplicaSelector::Replica> CreateReplicas() {
+        std::vector<ReplicaSelector::Replica> replicas;
+        for (int i = 0; i < 4; i++) {
+            replicas.push_back({"127.0.0.1:" + std::to_string(50100 + i),
+                                "host" + std::to_string(i),
+                                "rack" + std::to_string(i / 2)});
+        }
+        return replicas;
+    }
+};
+
+// 延迟相同时按同一主机、同一机架、其他机架的顺序选择
+TEST_F(ReplicaSelectorTest, ProximityTest) {
+    ReplicaSelector selector(SelectorOptions(), 1);
+    auto replicas = CreateReplicas();
+    for (int i = 0; i < 10; i++) {
+        auto ranked = selector.RankReplicas(replicas);
+        ASSERT_EQ(ranked.size(), 4);
+        EXPECT_EQ(ranked[0], "127.0.0.1:50100");
+        EXPECT_EQ(ranked[1], "127.0.0.1:50101");
+    }
+}
+
+// 代价相同的副本之间均匀分布
+TEST_F(ReplicaSelectorTest, SpreadTest) {
+    ReplicaSelector selector(ReplicaSelector::Options(), 1);
+    auto replicas = CreateReplicas();
+    std::map<std::string, int> first_counts;
+    for (int i = 0; i < 4000; i++) {
+        first_counts[selector.RankReplicas(replicas)[0]]++;
+    }
+    ASSERT_EQ(first_counts.size(), 4);
+    for (const auto& [server_address, count] : first_counts) {
+        EXPECT_GT(count, 800) << server_address;
+    }
+}
+
+// 正在进行的请求较多或延迟较高的块服务器排在后面
+TEST_F(ReplicaSelectorTest, LoadTest) {
+    ReplicaSelector selector(SelectorOptions(), 1);
+    auto replicas = CreateReplicas();
+    replicas.resize(2);
+
+    // 本机的块服务器积压了请求，同机架的块服务器更空闲
+    for (int i = 0; i < 3; i++) {
+        selector.BeginRequest("127.0.0.1:50100");
+    }
+    EXPECT_EQ(selector.GetOutstandingRequests("127.0.0.1:50100"), 3);
+    EXPECT_EQ(selector.RankReplicas(replicas)[0], "127.0.0.1:50101");
+    for (int i = 0; i < 3; i++) {
+        selector.EndRequest("127.0.0.1:50100", absl::Milliseconds(1), true);
+    }
+    EXPECT_EQ(selector.GetOutstandingRequests("127.0.0.1:50100"), 0);
+    EXPECT_EQ(selector.RankReplicas(replicas)[0], "127.0.0.1:50100");
+
+    // 本机的块服务器变慢
+    for (int i = 0; i < 20; i++) {
+        selector.BeginRequest("127.0.0.1:50100");
+        selector.EndRequest("127.0.0.1:50100", absl::Milliseconds(20), true);
+    }
+    EXPECT_GT(selector.GetLatency("127.0.0.1:50100"), absl::Milliseconds(10));
+    EXPECT_EQ(selector.RankReplicas(replicas)[0], "127.0.0.1:50101");
+}
+
+// 读取失败的块服务器在退避时间内排在最后，成功后恢复
+TEST_F(ReplicaSelectorTest, FailoverTest) {
+    auto options = SelectorOptions();
+    options.failure_backoff = absl::Hours(1);
+    ReplicaSelector selector(options, 1);
+    auto replicas = CreateReplicas();
+
+    selector.BeginRequest("127.0.0.1:50100");
+    selector.EndRequest("127.0.0.1:50100", absl::Seconds(2), false);
+    // 失败请求的延迟不计入 EWMA
+    EXPECT_EQ(selector.GetLatency("127.0.0.1:50100"), absl::Milliseconds(1));
+    auto ranked = selector.RankReplicas(replicas);
+    EXPECT_EQ(ranked[0], "127.0.0.1:50101");
+    EXPECT_EQ(ranked[3], "127.0.0.1:50100");
+
+    selector.BeginRequest("127.0.0.1:50100");
+    selector.EndRequest("127.0.0.1:50100", absl::Milliseconds(1), true);
+    EXPECT_EQ(selector.RankReplicas(replicas)[0], "127.0.0.1:50100");
+}
+
+// 延迟分位数只使用最近的样本，样本不足时返回默认值
+TEST_F(ReplicaSelectorTest, LatencyPercentileTest) {
+    auto options = SelectorOptions();
+    options.latency_window = 100;
+    ReplicaSelector selector(options, 1);
+    const std::string server_address = "127.0.0.1:50100";
+    EXPECT_EQ(selector.GetLatencyPercentile(server_address, 0.95,
+                                            absl::Milliseconds(10)),
+              absl::Milliseconds(10));
+
+    for (int i = 1; i <= 100; i++) {
+        selector.BeginRequest(server_address);
+        selector.EndRequest(server_address, absl::Milliseconds(i), true);
+    }
+    EXPECT_EQ(selector.GetLatencyPercentile(server_address, 0.95,
+                                            absl::Milliseconds(10)),
+              absl::Milliseconds(96));
+    EXPECT_EQ(selector.GetLatencyPercentile(server_address, 0.5,
+                                            absl::Milliseconds(10)),
+              absl::Milliseconds(51));
+
+    // 新样本覆盖最早的样本
+    for (int i = 0; i < 100; i++) {
+        selector.BeginRequest(server_address);
+        selector.EndRequest(server_address, absl::Milliseconds(1), true);
+    }
+    EXPECT_EQ(selector.GetLatencyPercentile(server_address, 0.95,
+                                            absl::Milliseconds(10)),
+              absl::Milliseconds(1));
+
+    // 被取消的请求不计入样本
+    selector.BeginRequest(server_address);
+    selector.CancelRequest(server_address);
+    EXPECT_EQ(selector.GetOutstandingRequests(server_address), 0);
+    EXPECT_EQ(selector.GetLatency(server_address), absl::Milliseconds(1));
+}
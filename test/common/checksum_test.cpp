@@ -0,0 +1,102 @@
+#include "src/common/checksum.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+
+using dfs::common::Checksum;
+using dfs::common::ChecksumType;
+using dfs::common::ChecksumTypeFromName;
+using dfs::common::ComputeChecksum;
+using dfs::common::Crc32c;
+using dfs::common::Crc32cPortable;
+using dfs::common::VerifyChecksum;
+
+class ChecksumTest : public ::testing::Test {
+   protected:
+    std::string MakeData(size_t nbytes) {
+        std::string data(nbytes, '\0');
+        for (size_t i = 0; i < nbytes; i++) {
+            data[i] = static_cast<char>(i * 131 + 7);
+        }
+        return data;
+    }
+
+    const ChecksumType types_[3] = {ChecksumType::CRC32C, ChecksumType::XXH3,
+                                    ChecksumType::SHA256};
+};
+
+TEST_F(ChecksumTest, Crc32cKnownValueTest) {
+    const std::string data = "123456789";
+    EXPECT_EQ(Crc32c(0, data.data(), data.size()), 0xE3069283);
+    EXPECT_EQ(Crc32cPortable(0, data.data(), data.size()), 0xE3069283);
+    EXPECT_EQ(Crc32c(0, nullptr, 0), 0);
+}
+
+TEST_F(ChecksumTest, Crc32cHardwareMatchPortableTest) {
+    const auto data = MakeData(100003);
+    // 覆盖未对齐的起点与不足 8 字节的尾部
+    for (size_t offset = 0; offset < 9; offset++) {
+        const size_t nbytes = data.size() - offset * 3;
+        EXPECT_EQ(Crc32c(0, data.data() + offset, nbytes),
+                  Crc32cPortable(0, data.data() + offset, nbytes));
+    }
+
+    // 分段计算与一次性计算结果相同
+    uint32_t crc = Crc32c(0, data.data(), 1000);
+    crc = Crc32c(crc, data.data() + 1000, data.size() - 1000);
+    EXPECT_EQ(crc, Crc32c(0, data.data(), data.size()));
+}
+
+TEST_F(ChecksumTest, StreamingMatchOneShotTest) {
+    const auto data = MakeData(1024 * 1024 + 13);
+    for (auto type : types_) {
+        auto checksum = Checksum::Create(type);
+        ASSERT_NE(checksum, nullptr);
+        EXPECT_EQ(checksum->type(), type);
+        for (size_t offset = 0; offset < data.size(); offset += 4099) {
+            checksum->Update(data.data() + offset,
+                             std::min<size_t>(4099, data.size() - offset));
+        }
+        EXPECT_EQ(checksum->Finish(), ComputeChecksum(type, data));
+    }
+}
+
+TEST_F(ChecksumTest, ChecksumFormatTest) {
+    const std::string data = "hello checksum";
+    EXPECT_EQ(ComputeChecksum(ChecksumType::CRC32C, data).size(), 1 + 4);
+    EXPECT_EQ(ComputeChecksum(ChecksumType::XXH3, data).size(), 1 + 16);
+    EXPECT_EQ(ComputeChecksum(ChecksumType::SHA256, data).size(), 1 + 32);
+
+    for (auto type : types_) {
+        EXPECT_EQ(ComputeChecksum(type, data)[0], static_cast<char>(type));
+    }
+}
+
+TEST_F(ChecksumTest, VerifyChecksumTest) {
+    auto data = MakeData(65536);
+    for (auto type : types_) {
+        const auto checksum = ComputeChecksum(type, data);
+        EXPECT_TRUE(VerifyChecksum(checksum, data));
+
+        auto corrupted = data;
+        corrupted[12345] ^= 0x01;
+        EXPECT_FALSE(VerifyChecksum(checksum, corrupted));
+    }
+
+    // 无法识别的算法编号
+    EXPECT_FALSE(VerifyChecksum("", data));
+    EXPECT_FALSE(VerifyChecksum(std::string(33, '\x7f'), data));
+}
+
+TEST_F(ChecksumTest, ChecksumTypeFromNameTest) {
+    EXPECT_EQ(ChecksumTypeFromName("crc32c", ChecksumType::XXH3),
+              ChecksumType::CRC32C);
+    EXPECT_EQ(ChecksumTypeFromName("xxh3", ChecksumType::SHA256),
+              ChecksumType::XXH3);
+    EXPECT_EQ(ChecksumTypeFromName("sha256", ChecksumType::XXH3),
+              ChecksumType::SHA256);
+    EXPECT_EQ(ChecksumTypeFromName("md5", ChecksumType::XXH3),
+              ChecksumType::XXH3);
+}
@@ -0,0 +1,102 @@
+#include "src/common/compression.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+
+using dfs::common::CompressBlock;
+using dfs::common::CompressionCodec;
+using dfs::common::CompressionCodecFromName;
+using dfs::common::DecompressBlock;
+
+class CompressionTest : public ::testing::Test {
+   protected:
+    // 类似日志的可压缩数据
+    std::string MakeText(size_t nbytes) {
+        std::string data;
+        for (size_t i = 0; data.size() < nbytes; i++) {
+            data += "2024-01-01 00:00:" + std::to_string(i % 60) +
+                    " INFO chunk server heartbeat ok, chunk_nums: " +
+                    std::to_string(i % 1000) + "\n";
+        }
+        data.resize(nbytes);
+        return data;
+    }
+
+    std::string MakeRandom(size_t nbytes) {
+        std::mt19937 random(42);
+        std::string data(nbytes, '\0');
+        for (auto& c : data) {
+            c = static_cast<char>(random());
+        }
+        return data;
+    }
+
+    const CompressionCodec codecs_[2] = {CompressionCodec::LZ4,
+                                         CompressionCodec::ZSTD};
+};
+
+TEST_F(CompressionTest, RoundTripTest) {
+    const auto data = MakeText(64 * 1024);
+    for (auto codec : codecs_) {
+        std::string compressed = "prefix";
+        const size_t length =
+            CompressBlock(codec, data.data(), data.size(), 0, &compressed);
+        EXPECT_EQ(compressed.size(), 6 + length);
+        // 日志至少可以压缩到原来的一半
+        EXPECT_LT(length, data.size() / 2);
+
+        std::string output = "prefix";
+        ASSERT_TRUE(DecompressBlock(codec, compressed.data() + 6, length,
+                                    data.size(), &output));
+        EXPECT_EQ(output, "prefix" + data);
+    }
+}
+
+TEST_F(CompressionTest, IncompressibleTest) {
+    // 压缩后没有变短的数据保存原始数据
+    const auto data = MakeRandom(4096);
+    for (auto codec : codecs_) {
+        std::string compressed;
+        EXPECT_EQ(CompressBlock(codec, data.data(), data.size(), 0, &compressed),
+                  data.size());
+        EXPECT_EQ(compressed, data);
+
+        std::string output;
+        ASSERT_TRUE(DecompressBlock(codec, compressed.data(), compressed.size(),
+                                    data.size(), &output));
+        EXPECT_EQ(output, data);
+    }
+
+    std::string stored;
+    EXPECT_EQ(CompressBlock(CompressionCodec::NONE, data.data(), data.size(), 0,
+                            &stored),
+              data.size());
+    EXPECT_EQ(stored, data);
+}
+
+TEST_F(CompressionTest, CorruptedTest) {
+    const auto data = MakeText(16 * 1024);
+    for (auto codec : codecs_) {
+        std::string compressed;
+        CompressBlock(codec, data.data(), data.size(), 0, &compressed);
+        compressed.resize(compressed.size() / 2);
+
+        std::string output = "prefix";
+        EXPECT_FALSE(DecompressBlock(codec, compressed.data(),
+                                     compressed.size(), data.size(), &output));
+        EXPECT_EQ(output, "prefix");
+    }
+}
+
+TEST_F(CompressionTest, CodecFromNameTest) {
+    EXPECT_EQ(CompressionCodecFromName("lz4", CompressionCodec::NONE),
+              CompressionCodec::LZ4);
+    EXPECT_EQ(CompressionCodecFromName("zstd", CompressionCodec::NONE),
+              CompressionCodec::ZSTD);
+    EXPECT_EQ(CompressionCodecFromName("none", CompressionCodec::LZ4),
+              CompressionCodec::NONE);
+    EXPECT_EQ(CompressionCodecFromName("gzip", CompressionCodec::LZ4),
+              CompressionCodec::LZ4);
+}
@@ -0,0 +1,143 @@
+#include "src/common/erasure_code.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+using dfs::common::GfDotProduct;
+using dfs::common::GfDotProductPortable;
+using dfs::common::GfExpandTables;
+using dfs::common::GfInverse;
+using dfs::common::GfMul;
+using dfs::common::ReedSolomon;
+
+class ErasureCodeTest : public ::testing::Test {
+   protected:
+    std::vector<std::string> MakeShards(uint32_t nums, size_t nbytes) {
+        std::mt19937 random(42);
+        std::vector<std::string> shards(nums, std::string(nbytes, '\0'));
+        for (auto& shard : shards) {
+            for (auto& c : shard) {
+                c = static_cast<char>(random());
+            }
+        }
+        return shards;
+    }
+
+    std::vector<const char*> Pointers(const std::vector<std::string>& shards) {
+        std::vector<const char*> pointers;
+        for (const auto& shard : shards) {
+            pointers.push_back(shard.data());
+        }
+        return pointers;
+    }
+
+    std::vector<char*> Pointers(std::vector<std::string>* shards) {
+        std::vector<char*> pointers;
+        for (auto& shard : *shards) {
+            pointers.push_back(&shard[0]);
+        }
+        return pointers;
+    }
+};
+
+TEST_F(ErasureCodeTest, GaloisFieldTest) {
+    for (uint32_t a = 1; a < 256; a++) {
+        EXPECT_EQ(GfMul(a, GfInverse(a)), 1);
+        EXPECT_EQ(GfMul(a, 1), a);
+        EXPECT_EQ(GfMul(a, 0), 0);
+    }
+    // 0x80 * 2 溢出后模本原多项式 0x11D
+    EXPECT_EQ(GfMul(0x80, 2), 0x1D);
+}
+
+// SIMD 实现与查表实现的结果相同，长度不是 32 的倍数时尾部也正确
+TEST_F(ErasureCodeTest, DotProductTest) {
+    const uint32_t input_nums = 6;
+    const uint32_t output_nums = 5;
+    std::vector<uint8_t> matrix(input_nums * output_nums);
+    std::mt19937 random(7);
+    for (auto& value : matrix) {
+        value = static_cast<uint8_t>(random());
+    }
+    const auto tables = GfExpandTables(matrix);
+
+    for (size_t nbytes : {0, 1, 15, 31, 33, 4096 + 17}) {
+        const auto inputs = MakeShards(input_nums, nbytes);
+        std::vector<std::string> expected(output_nums, std::string(nbytes, 0));
+        std::vector<std::string> outputs(output_nums, std::string(nbytes, 1));
+        GfDotProductPortable(tables.data(), input_nums, output_nums,
+                             Pointers(inputs).data(), Pointers(&expected).data(),
+                             nbytes);
+        GfDotProduct(tables.data(), input_nums, output_nums,
+                     Pointers(inputs).data(), Pointers(&outputs).data(),
+                     nbytes);
+        EXPECT_EQ(outputs, expected) << "nbytes: " << nbytes;
+
+        // 与逐字节计算的结果相同
+        for (size_t pos = 0; pos < nbytes; pos++) {
+            uint8_t value = 0;
+            for (uint32_t i = 0; i < input_nums; i++) {
+                value ^= GfMul(matrix[i], inputs[i][pos]);
+            }
+            ASSERT_EQ(static_cast<uint8_t>(expected[0][pos]), value);
+        }
+    }
+}
+
+// RS(6, 3) 任意丢失 3 个分片都能恢复
+TEST_F(ErasureCodeTest, ReconstructAnyShardsTest) {
+    const uint32_t k = 6;
+    const uint32_t m = 3;
+    const size_t nbytes = 1000;
+    ReedSolomon codec(k, m);
+
+    auto shards = MakeShards(k, nbytes);
+    std::vector<std::string> parity(m, std::string(nbytes, '\0'));
+    codec.Encode(Pointers(shards).data(), Pointers(&parity).data(), nbytes);
+    shards.insert(shards.end(), parity.begin(), parity.end());
+
+    for (uint32_t mask = 0; mask < (1u << (k + m)); mask++) {
+        if (__builtin_popcount(mask) != m) {
+            continue;
+        }
+
+        std::vector<uint32_t> survivors;
+        std::vector<uint32_t> targets;
+        std::vector<const char*> survivor_data;
+        for (uint32_t i = 0; i < k + m; i++) {
+            if (mask & (1u << i)) {
+                targets.push_back(i);
+            } else {
+                survivors.push_back(i);
+                survivor_data.push_back(shards[i].data());
+            }
+        }
+
+        std::vector<std::string> outputs(m, std::string(nbytes, '\0'));
+        ASSERT_TRUE(codec.Decode(survivors, survivor_data.data(), targets,
+                                 Pointers(&outputs).data(), nbytes));
+        for (uint32_t t = 0; t < m; t++) {
+            ASSERT_EQ(outputs[t], shards[targets[t]])
+                << "mask: " << mask << ", target: " << targets[t];
+        }
+    }
+}
+
+TEST_F(ErasureCodeTest, InvalidDecodeTest) {
+    ReedSolomon codec(4, 2);
+    const auto shards = MakeShards(6, 16);
+    const auto data = Pointers(shards);
+    std::string output(16, '\0');
+    char* outputs[] = {&output[0]};
+
+    // 存活分片不足
+    EXPECT_FALSE(codec.Decode({0, 1, 2}, data.data(), {3}, outputs, 16));
+    // 重复的分片
+    EXPECT_FALSE(codec.Decode({0, 1, 1, 2}, data.data(), {3}, outputs, 16));
+    // 编号越界
+    EXPECT_FALSE(codec.Decode({0, 1, 2, 6}, data.data(), {3}, outputs, 16));
+    EXPECT_FALSE(codec.Decode({0, 1, 2, 4}, data.data(), {6}, outputs, 16));
+}
@@ -0,0 +1,55 @@
+#include "src/common/executor.h"
+
+#include <absl/synchronization/notification.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+
+using dfs::common::Executor;
+
+class ExecutorTest : public ::testing::Test {};
+
+// 提交的任务都会被执行
+TEST_F(ExecutorTest, SubmitTest) {
+    Executor executor("test", 4, 0);
+    std::atomic<int> count{0};
+    for (int i = 0; i < 100; i++) {
+        EXPECT_TRUE(executor.Submit([&]() { count++; }));
+    }
+
+    executor.Shutdown();
+    EXPECT_EQ(count.load(), 100);
+}
+
+// 队列已满时拒绝新的任务
+TEST_F(ExecutorTest, QueueFullTest) {
+    Executor executor("test", 1, 1);
+    absl::Notification started;
+    absl::Notification blocker;
+    EXPECT_TRUE(executor.Submit([&]() {
+        started.Notify();
+        blocker.WaitForNotification();
+    }));
+    started.WaitForNotification();
+
+    EXPECT_EQ(executor.GetRunningTasks(), 1);
+    EXPECT_TRUE(executor.Submit([]() {}));
+    EXPECT_FALSE(executor.Submit([]() {}));
+    EXPECT_EQ(executor.GetQueueSize(), 1);
+
+    blocker.Notify();
+}
+
+// 关闭后拒绝新的任务，但会执行完队列中剩余的任务
+TEST_F(ExecutorTest, ShutdownTest) {
+    Executor executor("test", 1, 0);
+    absl::Notification blocker;
+    std::atomic<int> count{0};
+    EXPECT_TRUE(executor.Submit([&]() { blocker.WaitForNotification(); }));
+    EXPECT_TRUE(executor.Submit([&]() { count++; }));
+
+    blocker.Notify();
+    executor.Shutdown();
+    EXPECT_EQ(count.load(), 1);
+    EXPECT_FALSE(executor.Submit([&]() { count++; }));
+}
@@ -0,0 +1,215 @@
+#include "src/common/metrics.h"
+
+#include <arpa/inet.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/common/metrics_server.h"
+
+using dfs::common::Counter;
+using dfs::common::Histogram;
+using dfs::common::MetricsRegistry;
+using dfs::common::MetricsServer;
+using dfs::common::MetricType;
+
+class MetricsTest : public ::testing::Test {};
+
+namespace {
+
+// 向 127.0.0.1:port 发送一个 GET 请求，返回完整的回复
+std::string HttpGet(uint16_t port, const std::string& path) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(fd);
+        return "";
+    }
+
+    const std::string request =
+        "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    send(fd, request.data(), request.size(), 0);
+    std::string respond;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+        respond.append(buffer, n);
+    }
+    close(fd);
+    return respond;
+}
+
+}  // namespace
+
+// 小值每个值一个桶，之后每个桶的相对误差不超过 1/16
+TEST_F(MetricsTest, BucketIndexTest) {
+    for (uint64_t value = 0; value < 16; value++) {
+        EXPECT_EQ(Histogram::BucketIndex(value), value);
+        EXPECT_EQ(Histogram::BucketUpperBound(value), value);
+    }
+
+    size_t last_index = 0;
+    for (uint64_t value = 1; value < (uint64_t(1) << 20); value += 7) {
+        const size_t index = Histogram::BucketIndex(value);
+        EXPECT_GE(index, last_index);
+        last_index = index;
+
+        const uint64_t upper = Histogram::BucketUpperBound(index);
+        EXPECT_GE(upper, value);
+        EXPECT_LE(upper - value, value / 16);
+        if (index > 0) {
+            EXPECT_LT(Histogram::BucketUpperBound(index - 1), value);
+        }
+    }
+
+    // 超出范围的值记录在最后一个桶
+    EXPECT_EQ(Histogram::BucketIndex(uint64_t(1) << 40),
+              Histogram::kBucketNums - 1);
+    EXPECT_EQ(Histogram::BucketIndex(UINT64_MAX), Histogram::kBucketNums - 1);
+}
+
+TEST_F(MetricsTest, HistogramPercentileTest) {
+    Histogram histogram;
+    EXPECT_EQ(histogram.Percentile(0.99), 0);
+
+    for (uint64_t value = 1; value <= 1000; value++) {
+        histogram.Record(value);
+    }
+    EXPECT_EQ(histogram.Count(), 1000);
+    EXPECT_EQ(histogram.Sum(), 500500);
+
+    // 分位数为所在桶的上界，误差不超过 1/16
+    const uint64_t p50 = histogram.Percentile(0.5);
+    EXPECT_GE(p50, 500);
+    EXPECT_LE(p50, 500 + 500 / 16);
+    const uint64_t p99 = histogram.Percentile(0.99);
+    EXPECT_GE(p99, 990);
+    EXPECT_LE(p99, 990 + 990 / 16);
+    EXPECT_EQ(histogram.Percentile(0), 1);
+}
+
+// 多个线程同时记录，不丢失样本
+TEST_F(MetricsTest, RecordInParallelTest) {
+    const int thread_nums = 8;
+    const int record_nums = 100000;
+    Counter counter;
+    Histogram histogram;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thread_nums; i++) {
+        threads.emplace_back([&]() {
+            for (int j = 0; j < record_nums; j++) {
+                counter.Increment();
+                histogram.Record(j % 1000);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(counter.Value(), thread_nums * record_nums);
+    EXPECT_EQ(histogram.Count(), thread_nums * record_nums);
+}
+
+// 同名同标签的指标只创建一次
+TEST_F(MetricsTest, RegistryTest) {
+    auto registry = MetricsRegistry::GetInstance();
+    auto counter = registry->GetCounter("test_registry_total", "help",
+                                        {{"method", "Read"}});
+    EXPECT_EQ(counter, registry->GetCounter("test_registry_total", "help",
+                                            {{"method", "Read"}}));
+    EXPECT_NE(counter, registry->GetCounter("test_registry_total", "help",
+                                            {{"method", "Write"}}));
+}
+
+TEST_F(MetricsTest, ExportTextTest) {
+    auto registry = MetricsRegistry::GetInstance();
+    registry->GetCounter("test_export_total", "Export counter",
+                         {{"method", "Read"}})
+        ->Increment(3);
+    registry->GetGauge("test_export_gauge", "Export gauge")->Set(-2);
+    auto histogram = registry->GetHistogram("test_export_seconds",
+                                            "Export histogram");
+    histogram->Record(3);
+    histogram->Record(1500000);
+
+    const std::string text = registry->ExportText();
+    EXPECT_NE(text.find("# HELP test_export_total Export counter\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("# TYPE test_export_total counter\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("test_export_total{method=\"Read\"} 3\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("# TYPE test_export_gauge gauge\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("test_export_gauge -2\n"), std::string::npos);
+
+    // 直方图的桶是累计的，单位为秒
+    EXPECT_NE(text.find("# TYPE test_export_seconds histogram\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("test_export_seconds_bucket{le=\"2e-06\"} 0\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("test_export_seconds_bucket{le=\"4e-06\"} 1\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("test_export_seconds_bucket{le=\"1.048576\"} 1\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("test_export_seconds_bucket{le=\"2.097152\"} 2\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("test_export_seconds_bucket{le=\"+Inf\"} 2\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("test_export_seconds_sum 1.500003\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("test_export_seconds_count 2\n"), std::string::npos);
+}
+
+// 回调在导出时调用，被之后注册的回调替换后，移除旧回调不影响新回调
+TEST_F(MetricsTest, CallbackTest) {
+    auto registry = MetricsRegistry::GetInstance();
+    double value = 7;
+    auto first_id =
+        registry->AddCallback("test_callback", "Callback", MetricType::GAUGE,
+                              {}, [&value]() { return value; });
+    EXPECT_NE(registry->ExportText().find("test_callback 7\n"),
+              std::string::npos);
+
+    auto second_id = registry->AddCallback(
+        "test_callback", "Callback", MetricType::GAUGE, {},
+        [&value]() { return value * 2; });
+    registry->RemoveCallback(first_id);
+    EXPECT_NE(registry->ExportText().find("test_callback 14\n"),
+              std::string::npos);
+
+    registry->RemoveCallback(second_id);
+    EXPECT_EQ(registry->ExportText().find("test_callback"), std::string::npos);
+}
+
+TEST_F(MetricsTest, MetricsServerTest) {
+    auto registry = MetricsRegistry::GetInstance();
+    registry->GetCounter("test_server_total", "Server counter")->Increment();
+
+    MetricsServer server(registry);
+    ASSERT_TRUE(server.Start("127.0.0.1", 0));
+    ASSERT_NE(server.port(), 0);
+
+    auto respond = HttpGet(server.port(), "/metrics?name=test");
+    EXPECT_EQ(respond.rfind("HTTP/1.1 200 OK\r\n", 0), 0);
+    EXPECT_NE(respond.find("text/plain; version=0.0.4"), std::string::npos);
+    EXPECT_NE(respond.find("test_server_total 1\n"), std::string::npos);
+
+    respond = HttpGet(server.port(), "/");
+    EXPECT_EQ(respond.rfind("HTTP/1.1 404 Not Found\r\n", 0), 0);
+
+    server.Stop();
+    EXPECT_EQ(server.port(), 0);
+}
@@ -0,0 +1,146 @@
+#include "src/common/system_logger.h"
+
+#include <absl/time/clock.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/common/async_log_sink.h"
+
+using dfs::common::AsyncLogSink;
+using dfs::common::LogRateLimiter;
+
+class SystemLoggerTest : public ::testing::Test {};
+
+namespace {
+
+// 读出管道中的全部内容，写端需已经关闭
+std::string ReadAll(int fd) {
+    std::string text;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+        text.append(buffer, n);
+    }
+    return text;
+}
+
+size_t CountLines(const std::string& text, const std::string& pattern) {
+    size_t count = 0;
+    for (size_t pos = text.find(pattern); pos != std::string::npos;
+         pos = text.find(pattern, pos + 1)) {
+        count++;
+    }
+    return count;
+}
+
+void SendMessage(AsyncLogSink* sink, google::LogSeverity severity,
+                 const std::string& message) {
+    sink->send(severity, "test/common/system_logger_test.cpp",
+               "system_logger_test.cpp", 42, nullptr, message.data(),
+               message.size());
+}
+
+}  // namespace
+
+// 日志按 glog 的格式输出，Flush 返回时之前的日志已经写入
+TEST_F(SystemLoggerTest, AsyncLogSinkTest) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    AsyncLogSink sink(1024, fds[1]);
+    SendMessage(&sink, google::GLOG_INFO, "first message");
+    SendMessage(&sink, google::GLOG_ERROR, "second message");
+    sink.Flush();
+    sink.Stop();
+    // 停止后同步写入
+    SendMessage(&sink, google::GLOG_WARNING, "third message");
+    close(fds[1]);
+
+    const std::string text = ReadAll(fds[0]);
+    close(fds[0]);
+
+    const auto first = text.find("system_logger_test.cpp:42] first message\n");
+    const auto second =
+        text.find("system_logger_test.cpp:42] second message\n");
+    const auto third = text.find("system_logger_test.cpp:42] third message\n");
+    ASSERT_NE(first, std::string::npos);
+    ASSERT_NE(second, std::string::npos);
+    ASSERT_NE(third, std::string::npos);
+    EXPECT_LT(first, second);
+    EXPECT_LT(second, third);
+    EXPECT_EQ(text[0], 'I');
+    EXPECT_EQ(text[text.rfind('\n', second) + 1], 'E');
+    EXPECT_EQ(sink.GetDroppedNums(), 0);
+}
+
+// 缓冲区满时丢弃日志，写入的与丢弃的数量之和为记录的数量
+TEST_F(SystemLoggerTest, AsyncLogSinkDropTest) {
+    const int thread_nums = 4;
+    const int message_nums = 10000;
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    std::string text;
+    std::thread reader([&]() { text = ReadAll(fds[0]); });
+    {
+        AsyncLogSink sink(4, fds[1]);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < thread_nums; i++) {
+            threads.emplace_back([&sink]() {
+                for (int j = 0; j < message_nums; j++) {
+                    SendMessage(&sink, google::GLOG_INFO, "message");
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        sink.Stop();
+        close(fds[1]);
+        reader.join();
+        close(fds[0]);
+
+        const size_t lines = CountLines(text, "] message\n");
+        EXPECT_EQ(lines + sink.GetDroppedNums(), thread_nums * message_nums);
+        if (sink.GetDroppedNums() > 0) {
+            EXPECT_NE(text.find("log messages dropped"), std::string::npos);
+        }
+    }
+}
+
+// 一秒内最多放行 max_per_second 条，丢弃的数量随下一条日志输出
+TEST_F(SystemLoggerTest, LogRateLimiterTest) {
+    LogRateLimiter limiter(10);
+    const int64_t start_second = absl::ToUnixSeconds(absl::Now());
+    int allowed = 0;
+    for (int i = 0; i < 100; i++) {
+        if (limiter.Allow()) {
+            allowed++;
+        }
+    }
+    if (absl::ToUnixSeconds(absl::Now()) != start_second) {
+        GTEST_SKIP() << "crossed a second boundary";
+    }
+    EXPECT_EQ(allowed, 10);
+    EXPECT_EQ(limiter.TakeSuppressed(), "(90 similar messages suppressed) ");
+    EXPECT_EQ(limiter.TakeSuppressed(), "");
+}
+
+// 宏只在放行时求值日志内容
+TEST_F(SystemLoggerTest, RateLimitedMacroTest) {
+    int evaluated = 0;
+    auto count = [&evaluated]() { return ++evaluated; };
+    for (int i = 0; i < 100; i++) {
+        DFS_LOG_RATE_LIMITED(INFO, 5) << "rate limited " << count();
+    }
+    EXPECT_LE(evaluated, 10);
+    EXPECT_GE(evaluated, 5);
+
+    evaluated = 0;
+    DFS_VLOG(DFS_MAX_VLOG_LEVEL + 1) << count();
+    EXPECT_EQ(evaluated, 0);
+}
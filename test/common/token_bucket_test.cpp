@@ -0,0 +1,37 @@
+#include "src/common/token_bucket.h"
+
+#include <gtest/gtest.h>
+
+using dfs::common::TokenBucket;
+
+class TokenBucketTest : public ::testing::Test {};
+
+// 令牌充足时不需要等待，不足时等待的时间与欠下的令牌数成正比
+TEST_F(TokenBucketTest, ReserveTest) {
+    TokenBucket bucket(100, 100);
+    const absl::Time now = absl::Now() + absl::Seconds(1);
+
+    EXPECT_EQ(bucket.Reserve(100, now), absl::ZeroDuration());
+    EXPECT_EQ(bucket.Reserve(50, now), absl::Milliseconds(500));
+    // 一秒后补充 100 个令牌，还清欠下的 50 个
+    EXPECT_EQ(bucket.Reserve(50, now + absl::Seconds(1)),
+              absl::ZeroDuration());
+}
+
+// 令牌数不会超过 burst
+TEST_F(TokenBucketTest, BurstTest) {
+    TokenBucket bucket(100, 100);
+    const absl::Time now = absl::Now() + absl::Seconds(100);
+
+    EXPECT_EQ(bucket.Reserve(100, now), absl::ZeroDuration());
+    EXPECT_GT(bucket.Reserve(1, now), absl::ZeroDuration());
+}
+
+// 速度为 0 时不限速
+TEST_F(TokenBucketTest, UnlimitedTest) {
+    TokenBucket bucket(0, 1);
+    EXPECT_EQ(bucket.Reserve(1000000, absl::Now()), absl::ZeroDuration());
+
+    bucket.SetRate(10);
+    EXPECT_GT(bucket.Reserve(1000000, absl::Now()), absl::ZeroDuration());
+}
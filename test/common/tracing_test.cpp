@@ -0,0 +1,321 @@
+#include "src/common/tracing.h"
+
+#include <gtest/gtest.h>
+#include <json/json.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using dfs::common::CurrentTraceContext;
+using dfs::common::FormatTraceParent;
+using dfs::common::ParseTraceParent;
+using dfs::common::ScopedTraceContext;
+using dfs::common::Span;
+using dfs::common::TraceContext;
+using dfs::common::Tracer;
+
+class TracingTest : public ::testing::Test {
+   protected:
+    void SetUp() override { StartTracer(1024, 1, ""); }
+
+    void TearDown() override {
+        Tracer::GetInstance()->Shutdown();
+        Tracer::GetInstance()->SetSampleRate(0);
+    }
+
+    // 重新开始并清空缓冲区中之前的测试留下的 span
+    void StartTracer(uint32_t buffer_spans, double sample_rate,
+                     const std::string& output_dir) {
+        Tracer::Options options;
+        options.buffer_spans = buffer_spans;
+        options.sample_rate = sample_rate;
+        options.output_dir = output_dir;
+        Tracer::GetInstance()->Start("tracing_test", options);
+        std::vector<Tracer::SpanRecord> records;
+        Tracer::GetInstance()->Drain(&records);
+    }
+
+    std::vector<Tracer::SpanRecord> Drain() {
+        std::vector<Tracer::SpanRecord> records;
+        Tracer::GetInstance()->Drain(&records);
+        return records;
+    }
+};
+
+TEST_F(TracingTest, TraceParentTest) {
+    TraceContext context;
+    context.trace_id_high = 0x0123456789abcdef;
+    context.trace_id_low = 0xfedcba9876543210;
+    context.span_id = 0x00f067aa0ba902b7;
+    context.sampled = true;
+
+    const std::string text = FormatTraceParent(context);
+    EXPECT_EQ(text,
+              "00-0123456789abcdeffedcba9876543210-00f067aa0ba902b7-01");
+
+    TraceContext parsed;
+    ASSERT_TRUE(ParseTraceParent(text, &parsed));
+    EXPECT_EQ(parsed.trace_id_high, context.trace_id_high);
+    EXPECT_EQ(parsed.trace_id_low, context.trace_id_low);
+    EXPECT_EQ(parsed.span_id, context.span_id);
+    EXPECT_TRUE(parsed.sampled);
+
+    context.sampled = false;
+    ASSERT_TRUE(ParseTraceParent(FormatTraceParent(context), &parsed));
+    EXPECT_FALSE(parsed.sampled);
+
+    // 长度、分隔符、大写字母与全 0 的 id 都不合法
+    EXPECT_FALSE(ParseTraceParent("", &parsed));
+    EXPECT_FALSE(ParseTraceParent(text.substr(1), &parsed));
+    EXPECT_FALSE(ParseTraceParent(
+        "00-0123456789ABCDEFfedcba9876543210-00f067aa0ba902b7-01", &parsed));
+    EXPECT_FALSE(ParseTraceParent(
+        "00-0123456789abcdeffedcba9876543210_00f067aa0ba902b7-01", &parsed));
+    EXPECT_FALSE(ParseTraceParent(
+        "00-00000000000000000000000000000000-00f067aa0ba902b7-01", &parsed));
+    EXPECT_FALSE(ParseTraceParent(
+        "00-0123456789abcdeffedcba9876543210-0000000000000000-01", &parsed));
+}
+
+// 子 span 与父 span 属于同一个 trace，结束后恢复线程的 context
+TEST_F(TracingTest, SpanTest) {
+    EXPECT_FALSE(CurrentTraceContext().valid());
+    uint64_t root_span_id;
+    {
+        Span root("root");
+        ASSERT_TRUE(root.sampled());
+        root_span_id = root.context().span_id;
+        EXPECT_EQ(CurrentTraceContext().span_id, root_span_id);
+        {
+            Span child("child");
+            child.SetAttribute("bytes", 42);
+            EXPECT_EQ(CurrentTraceContext().span_id, child.context().span_id);
+            EXPECT_EQ(child.context().trace_id_low,
+                      root.context().trace_id_low);
+        }
+        EXPECT_EQ(CurrentTraceContext().span_id, root_span_id);
+    }
+    EXPECT_FALSE(CurrentTraceContext().valid());
+
+    auto records = Drain();
+    ASSERT_EQ(records.size(), 2);
+    // 子 span 先结束
+    EXPECT_STREQ(records[0].name, "child");
+    EXPECT_EQ(records[0].parent_span_id, root_span_id);
+    EXPECT_STREQ(records[0].attribute_key, "bytes");
+    EXPECT_EQ(records[0].attribute_value, 42);
+    EXPECT_STREQ(records[1].name, "root");
+    EXPECT_EQ(records[1].span_id, root_span_id);
+    EXPECT_EQ(records[1].parent_span_id, 0);
+    EXPECT_EQ(records[0].trace_id_high, records[1].trace_id_high);
+    EXPECT_EQ(records[0].trace_id_low, records[1].trace_id_low);
+    EXPECT_GE(records[0].start_micros, records[1].start_micros);
+    EXPECT_LE(records[0].start_micros + records[0].duration_micros,
+              records[1].start_micros + records[1].duration_micros);
+}
+
+// End 之后的 span 不再是当前 span，析构时不会重复记录
+TEST_F(TracingTest, SpanEndTest) {
+    {
+        Span root("root");
+        Span first("first");
+        first.End();
+        EXPECT_EQ(CurrentTraceContext().span_id, root.context().span_id);
+        Span second("second");
+        EXPECT_EQ(CurrentTraceContext().span_id, second.context().span_id);
+    }
+    auto records = Drain();
+    ASSERT_EQ(records.size(), 3);
+    EXPECT_STREQ(records[0].name, "first");
+    EXPECT_EQ(records[0].parent_span_id, records[2].span_id);
+    EXPECT_STREQ(records[1].name, "second");
+    EXPECT_EQ(records[1].parent_span_id, records[2].span_id);
+}
+
+// 采样率为 0 时不生成 context；上游已经开始的 trace 沿用上游的决定
+TEST_F(TracingTest, SampleRateTest) {
+    Tracer::GetInstance()->SetSampleRate(0);
+    EXPECT_EQ(Tracer::GetInstance()->GetSampleRate(), 0);
+    {
+        Span span("off");
+        EXPECT_FALSE(span.context().valid());
+        EXPECT_FALSE(CurrentTraceContext().valid());
+    }
+    EXPECT_TRUE(Drain().empty());
+
+    TraceContext upstream;
+    upstream.trace_id_low = 1;
+    upstream.span_id = 2;
+    upstream.sampled = false;
+    {
+        ScopedTraceContext scope(upstream);
+        Span span("not_sampled");
+        EXPECT_TRUE(span.context().valid());
+        EXPECT_FALSE(span.sampled());
+    }
+    EXPECT_TRUE(Drain().empty());
+
+    upstream.sampled = true;
+    {
+        ScopedTraceContext scope(upstream);
+        Span span("sampled");
+        EXPECT_TRUE(span.sampled());
+    }
+    auto records = Drain();
+    ASSERT_EQ(records.size(), 1);
+    EXPECT_EQ(records[0].trace_id_low, 1);
+    EXPECT_EQ(records[0].parent_span_id, 2);
+
+    // 部分采样
+    Tracer::GetInstance()->SetSampleRate(0.25);
+    EXPECT_NEAR(Tracer::GetInstance()->GetSampleRate(), 0.25, 1e-9);
+    const int trace_nums = 10000;
+    int sampled = 0;
+    for (int i = 0; i < trace_nums; i++) {
+        Span span("partial");
+        EXPECT_TRUE(span.context().valid());
+        sampled += span.sampled();
+    }
+    EXPECT_GT(sampled, trace_nums * 0.2);
+    EXPECT_LT(sampled, trace_nums * 0.3);
+}
+
+// 交给其他线程处理的 span 仍属于同一个 trace
+TEST_F(TracingTest, ScopedTraceContextTest) {
+    uint64_t root_span_id;
+    {
+        Span root("root");
+        root_span_id = root.context().span_id;
+        const auto trace_context = CurrentTraceContext();
+        std::thread thread([trace_context]() {
+            ScopedTraceContext scope(trace_context);
+            Span span("worker");
+        });
+        thread.join();
+    }
+    auto records = Drain();
+    ASSERT_EQ(records.size(), 2);
+    EXPECT_STREQ(records[0].name, "worker");
+    EXPECT_EQ(records[0].parent_span_id, root_span_id);
+    EXPECT_NE(records[0].thread_id, records[1].thread_id);
+}
+
+// 来不及导出的 span 被覆盖，记录丢失的数量
+TEST_F(TracingTest, RingBufferOverflowTest) {
+    StartTracer(16, 1, "");
+    const uint64_t lost_before = Tracer::GetInstance()->GetLostSpans();
+    for (int i = 0; i < 100; i++) {
+        Span span("overflow");
+        span.SetAttribute("index", i);
+    }
+    auto records = Drain();
+    ASSERT_EQ(records.size(), 16);
+    EXPECT_EQ(Tracer::GetInstance()->GetLostSpans() - lost_before, 84);
+    // 留下的是最新的 span
+    EXPECT_EQ(records.front().attribute_value, 84);
+    EXPECT_EQ(records.back().attribute_value, 99);
+}
+
+// 多个线程同时写入，读到的 span 都是完整的，读到的与丢失的数量之和为
+// 写入的数量
+TEST_F(TracingTest, ConcurrentRecordTest) {
+    StartTracer(256, 1, "");
+    const int thread_nums = 4;
+    const int span_nums = 20000;
+    const uint64_t lost_before = Tracer::GetInstance()->GetLostSpans();
+
+    std::atomic<bool> done{false};
+    size_t drained = 0;
+    bool consistent = true;
+    std::thread reader([&]() {
+        std::vector<Tracer::SpanRecord> records;
+        while (true) {
+            const bool finished = done.load();
+            records.clear();
+            drained += Tracer::GetInstance()->Drain(&records);
+            for (const auto& record : records) {
+                // 属性值由 span id 决定，读到混合的字段时不相等
+                if (record.attribute_value !=
+                    static_cast<int64_t>(record.span_id >> 1)) {
+                    consistent = false;
+                }
+            }
+            if (finished) {
+                break;
+            }
+        }
+    });
+
+    std::vector<std::thread> writers;
+    for (int i = 0; i < thread_nums; i++) {
+        writers.emplace_back([]() {
+            for (int j = 0; j < span_nums; j++) {
+                Span span("concurrent");
+                span.SetAttribute("check", span.context().span_id >> 1);
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    done = true;
+    reader.join();
+
+    EXPECT_TRUE(consistent);
+    EXPECT_EQ(drained + Tracer::GetInstance()->GetLostSpans() - lost_before,
+              thread_nums * span_nums);
+}
+
+// 导出文件是 Chrome trace 的 JSON 数组
+TEST_F(TracingTest, ExportTest) {
+    char dir_template[] = "/tmp/tracing_test_XXXXXX";
+    ASSERT_NE(mkdtemp(dir_template), nullptr);
+    const std::string output_dir = dir_template;
+    StartTracer(1024, 1, output_dir);
+    {
+        Span root("export_root");
+        Span child("export_child");
+        child.SetStatus(grpc::Status(grpc::StatusCode::NOT_FOUND, ""));
+    }
+    Tracer::GetInstance()->Shutdown();
+
+    const std::string path = output_dir + "/tracing_test." +
+                             std::to_string(getpid()) + ".trace.json";
+    std::ifstream file(path);
+    ASSERT_TRUE(file.is_open());
+    std::stringstream text;
+    text << file.rdbuf();
+
+    Json::Value root;
+    Json::CharReaderBuilder builder;
+    std::string errors;
+    std::istringstream stream(text.str());
+    ASSERT_TRUE(Json::parseFromStream(builder, stream, &root, &errors))
+        << errors;
+    ASSERT_TRUE(root.isArray());
+    ASSERT_EQ(root.size(), 3);
+    EXPECT_EQ(root[0]["ph"].asString(), "M");
+    EXPECT_EQ(root[0]["args"]["name"].asString(), "tracing_test");
+
+    const auto& child = root[1];
+    const auto& parent = root[2];
+    EXPECT_EQ(child["name"].asString(), "export_child");
+    EXPECT_EQ(child["ph"].asString(), "X");
+    EXPECT_EQ(child["cat"].asString(), "internal");
+    EXPECT_EQ(child["pid"].asInt(), getpid());
+    EXPECT_EQ(child["args"]["status"].asInt(), grpc::StatusCode::NOT_FOUND);
+    EXPECT_EQ(child["args"]["trace_id"].asString(),
+              parent["args"]["trace_id"].asString());
+    EXPECT_EQ(child["args"]["parent_span_id"].asString(),
+              parent["args"]["span_id"].asString());
+    EXPECT_EQ(child["args"]["trace_id"].asString().size(), 32);
+    EXPECT_FALSE(parent["args"].isMember("parent_span_id"));
+
+    unlink(path.c_str());
+    rmdir(output_dir.c_str());
+}
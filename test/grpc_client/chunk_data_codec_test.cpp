@@ -0,0 +1,113 @@
+#include "src/grpc_client/chunk_data_codec.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using dfs::grpc_client::ParseReadFileChunkRespond;
+using dfs::grpc_client::SerializeSendChunkDataRequest;
+using protos::grpc::ReadFileChunkRespond;
+using protos::grpc::SendChunkDataRequest;
+
+class ChunkDataCodecTest : public ::testing::Test {
+   protected:
+    // 按 slice_size 切分成多个 slice，模拟从网络收到的分段数据
+    grpc::ByteBuffer Serialize(const google::protobuf::Message& message,
+                               size_t slice_size = 7) {
+        const std::string bytes = message.SerializeAsString();
+        std::vector<grpc::Slice> slices;
+        for (size_t offset = 0; offset < bytes.size(); offset += slice_size) {
+            slices.emplace_back(bytes.substr(offset, slice_size));
+        }
+        return grpc::ByteBuffer(slices.data(), slices.size());
+    }
+
+    std::string ToString(const grpc::ByteBuffer& byte_buffer) {
+        std::vector<grpc::Slice> slices;
+        EXPECT_TRUE(byte_buffer.Dump(&slices).ok());
+        std::string bytes;
+        for (const auto& slice : slices) {
+            bytes.append(reinterpret_cast<const char*>(slice.begin()),
+                         slice.size());
+        }
+        return bytes;
+    }
+
+    ReadFileChunkRespond MakeRespond(const std::string& data) {
+        ReadFileChunkRespond respond;
+        respond.mutable_request()->set_chunk_handle("handle0");
+        respond.mutable_request()->set_version(3);
+        respond.mutable_request()->set_length(data.size());
+        respond.set_data(data);
+        respond.set_read_length(data.size());
+        respond.set_status(ReadFileChunkRespond::OK);
+        return respond;
+    }
+};
+
+TEST_F(ChunkDataCodecTest, SerializeSendChunkDataTest) {
+    const std::string data(1024 * 1024, 'a');
+    auto byte_buffer = SerializeSendChunkDataRequest("checksum", data.data(),
+                                                     data.size());
+
+    // 与 protobuf 的编码兼容
+    SendChunkDataRequest request;
+    ASSERT_TRUE(request.ParseFromString(ToString(byte_buffer)));
+    EXPECT_EQ(request.checksum(), "checksum");
+    EXPECT_EQ(request.data(), data);
+}
+
+TEST_F(ChunkDataCodecTest, SerializeWithoutCopyTest) {
+    const std::string data(4096, 'b');
+    auto byte_buffer = SerializeSendChunkDataRequest("checksum", data.data(),
+                                                     data.size());
+
+    // data 字段的 slice 直接引用调用者的内存
+    std::vector<grpc::Slice> slices;
+    ASSERT_TRUE(byte_buffer.Dump(&slices).ok());
+    ASSERT_EQ(slices.size(), 2);
+    EXPECT_EQ(static_cast<const void*>(slices[1].begin()),
+              static_cast<const void*>(data.data()));
+    EXPECT_EQ(slices[1].size(), data.size());
+}
+
+TEST_F(ChunkDataCodecTest, ParseReadFileChunkRespondTest) {
+    const std::string data = "hello chunk data";
+    auto byte_buffer = Serialize(MakeRespond(data));
+
+    std::string buffer(data.size(), '\0');
+    ReadFileChunkRespond respond;
+    ASSERT_TRUE(ParseReadFileChunkRespond(&byte_buffer, &buffer[0],
+                                          buffer.size(), &respond)
+                    .ok());
+    EXPECT_EQ(buffer, data);
+    EXPECT_TRUE(respond.data().empty());
+    EXPECT_EQ(respond.read_length(), data.size());
+    EXPECT_EQ(respond.status(), ReadFileChunkRespond::OK);
+    EXPECT_EQ(respond.request().chunk_handle(), "handle0");
+    EXPECT_EQ(respond.request().version(), 3);
+}
+
+TEST_F(ChunkDataCodecTest, ParseErrorRespondTest) {
+    ReadFileChunkRespond error_respond;
+    error_respond.set_status(ReadFileChunkRespond::VERSION_ERROR);
+    auto byte_buffer = Serialize(error_respond);
+
+    char buffer[16];
+    ReadFileChunkRespond respond;
+    ASSERT_TRUE(
+        ParseReadFileChunkRespond(&byte_buffer, buffer, sizeof(buffer), &respond)
+            .ok());
+    EXPECT_EQ(respond.read_length(), 0);
+    EXPECT_EQ(respond.status(), ReadFileChunkRespond::VERSION_ERROR);
+}
+
+TEST_F(ChunkDataCodecTest, ParseBufferTooSmallTest) {
+    auto byte_buffer = Serialize(MakeRespond(std::string(64, 'c')));
+
+    char buffer[16];
+    ReadFileChunkRespond respond;
+    EXPECT_TRUE(google::protobuf::util::IsOutOfRange(ParseReadFileChunkRespond(
+        &byte_buffer, buffer, sizeof(buffer), &respond)));
+}
@@ -0,0 +1,194 @@
+#include "src/server/chunk_server/chunk_block_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using dfs::server::ChunkBlockCache;
+
+class ChunkBlockCacheTest : public ::testing::Test {
+   protected:
+    // 容量为 8 个 kBlockSize 大小的分块，A1in 最多 2 个分块
+    ChunkBlockCache::Options CacheOptions() {
+        ChunkBlockCache::Options options;
+        options.capacity_bytes = 8 * kBlockSize;
+        options.block_size = kBlockSize;
+        options.in_ratio = 0.25;
+        options.out_ratio = 1;
+        return options;
+    }
+
+    // 模拟一次未命中后的磁盘读取
+    void InsertBlock(ChunkBlockCache* cache, const std::string& chunk_handle,
+                     const uint64_t& block_index, const uint32_t& version = 1) {
+        auto lookups =
+            cache->Lookup(chunk_handle, version, block_index, block_index);
+        ASSERT_EQ(lookups.size(), 1);
+        if (lookups[0].load) {
+            cache->FinishLoad(chunk_handle, version, block_index,
+                              lookups[0].pending,
+                              std::make_shared<const std::string>(
+                                  kBlockSize, 'a' + block_index % 26));
+        }
+    }
+
+    // 查找一个分块，未命中时放弃读取
+    std::shared_ptr<const std::string> LookupBlock(
+        ChunkBlockCache* cache, const std::string& chunk_handle,
+        const uint64_t& block_index, const uint32_t& version = 1) {
+        auto lookups =
+            cache->Lookup(chunk_handle, version, block_index, block_index);
+        if (lookups[0].load) {
+            cache->FinishLoad(chunk_handle, version, block_index,
+                              lookups[0].pending, nullptr);
+        }
+        return lookups[0].data;
+    }
+
+    const size_t kBlockSize = 4096;
+};
+
+TEST_F(ChunkBlockCacheTest, HitRateTest) {
+    ChunkBlockCache cache(CacheOptions());
+    EXPECT_EQ(cache.GetHitRate(), 0);
+
+    InsertBlock(&cache, "chunk", 0);
+    auto data = LookupBlock(&cache, "chunk", 0);
+    ASSERT_NE(data, nullptr);
+    EXPECT_EQ(*data, std::string(kBlockSize, 'a'));
+
+    EXPECT_EQ(cache.GetHits(), 1);
+    EXPECT_EQ(cache.GetMisses(), 1);
+    EXPECT_DOUBLE_EQ(cache.GetHitRate(), 0.5);
+    EXPECT_EQ(cache.GetResidentBytes(), kBlockSize);
+}
+
+// 缓存的数据量不超过上限
+TEST_F(ChunkBlockCacheTest, CapacityTest) {
+    ChunkBlockCache cache(CacheOptions());
+    for (uint64_t i = 0; i < 100; i++) {
+        InsertBlock(&cache, "chunk", i);
+        EXPECT_LE(cache.GetResidentBytes(), 8 * kBlockSize);
+    }
+
+    // 按进入的顺序淘汰
+    EXPECT_EQ(cache.GetBlockNums(), 8);
+    EXPECT_NE(LookupBlock(&cache, "chunk", 99), nullptr);
+    EXPECT_EQ(LookupBlock(&cache, "chunk", 0), nullptr);
+}
+
+// 顺序扫描不会挤掉热点数据
+TEST_F(ChunkBlockCacheTest, ScanResistanceTest) {
+    ChunkBlockCache cache(CacheOptions());
+    // 热点分块被淘汰出 A1in 后再次读取，进入 Am
+    for (uint64_t i = 0; i < 4; i++) {
+        InsertBlock(&cache, "hot", i);
+    }
+    for (uint64_t i = 0; i < 8; i++) {
+        InsertBlock(&cache, "fill", i);
+    }
+    EXPECT_EQ(LookupBlock(&cache, "hot", 0), nullptr);
+    for (uint64_t i = 0; i < 4; i++) {
+        InsertBlock(&cache, "hot", i);
+    }
+
+    // 扫描大量只读一次的分块
+    for (uint64_t i = 0; i < 100; i++) {
+        InsertBlock(&cache, "scan", i);
+    }
+
+    for (uint64_t i = 0; i < 4; i++) {
+        EXPECT_NE(LookupBlock(&cache, "hot", i), nullptr);
+    }
+    EXPECT_LE(cache.GetResidentBytes(), 8 * kBlockSize);
+}
+
+TEST_F(ChunkBlockCacheTest, EraseTest) {
+    ChunkBlockCache cache(CacheOptions());
+    InsertBlock(&cache, "chunk0", 0);
+    InsertBlock(&cache, "chunk0", 1);
+    InsertBlock(&cache, "chunk1", 0);
+
+    cache.Erase("chunk0", 1, 1);
+    EXPECT_NE(LookupBlock(&cache, "chunk0", 0), nullptr);
+    EXPECT_EQ(LookupBlock(&cache, "chunk0", 1), nullptr);
+
+    cache.Erase("chunk0");
+    EXPECT_EQ(LookupBlock(&cache, "chunk0", 0), nullptr);
+    EXPECT_NE(LookupBlock(&cache, "chunk1", 0), nullptr);
+    EXPECT_EQ(cache.GetResidentBytes(), kBlockSize);
+
+    // 失效之前开始的读取不写入缓存
+    cache.Erase("chunk1");
+    auto lookups = cache.Lookup("chunk1", 1, 0, 0);
+    ASSERT_TRUE(lookups[0].load);
+    cache.Erase("chunk1", 0, 0);
+    cache.FinishLoad("chunk1", 1, 0, lookups[0].pending,
+                     std::make_shared<const std::string>("stale"));
+    EXPECT_EQ(*ChunkBlockCache::WaitLoad(lookups[0].pending), "stale");
+    EXPECT_EQ(LookupBlock(&cache, "chunk1", 0), nullptr);
+    EXPECT_EQ(cache.GetResidentBytes(), 0);
+}
+
+// 分块按版本号区分，数据块的最后一个分块之后不再查找
+TEST_F(ChunkBlockCacheTest, VersionTest) {
+    ChunkBlockCache cache(CacheOptions());
+    InsertBlock(&cache, "chunk", 0, 1);
+    EXPECT_NE(LookupBlock(&cache, "chunk", 0, 1), nullptr);
+    EXPECT_EQ(LookupBlock(&cache, "chunk", 0, 2), nullptr);
+
+    auto lookups = cache.Lookup("chunk", 2, 0, 0);
+    ASSERT_TRUE(lookups[0].load);
+    cache.FinishLoad("chunk", 2, 0, lookups[0].pending,
+                     std::make_shared<const std::string>("tail"));
+    lookups = cache.Lookup("chunk", 2, 0, 3);
+    ASSERT_EQ(lookups.size(), 1);
+    EXPECT_EQ(*lookups[0].data, "tail");
+}
+
+// 多个线程同时读取同一分块时只有一个线程访问磁盘
+TEST_F(ChunkBlockCacheTest, SingleFlightTest) {
+    ChunkBlockCache cache(CacheOptions());
+    auto first = cache.Lookup("chunk", 1, 0, 0);
+    ASSERT_TRUE(first[0].load);
+
+    const int thread_nums = 8;
+    std::atomic<int> loads(0);
+    std::atomic<int> waits(0);
+    std::vector<std::shared_ptr<const std::string>> results(thread_nums);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thread_nums; i++) {
+        threads.emplace_back([&, i]() {
+            auto lookups = cache.Lookup("chunk", 1, 0, 0);
+            if (lookups[0].load) {
+                loads++;
+                return;
+            }
+            waits++;
+            results[i] = ChunkBlockCache::WaitLoad(lookups[0].pending);
+        });
+    }
+
+    // 等待所有线程都开始等待后再完成读取
+    while (waits.load() + loads.load() < thread_nums) {
+        std::this_thread::yield();
+    }
+    cache.FinishLoad("chunk", 1, 0, first[0].pending,
+                     std::make_shared<const std::string>(kBlockSize, 'x'));
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(loads.load(), 0);
+    EXPECT_EQ(cache.GetMisses(), 1);
+    EXPECT_EQ(cache.GetCoalescedLoads(), thread_nums);
+    for (const auto& result : results) {
+        ASSERT_NE(result, nullptr);
+        EXPECT_EQ(*result, std::string(kBlockSize, 'x'));
+    }
+    EXPECT_NE(LookupBlock(&cache, "chunk", 0), nullptr);
+}
@@ -0,0 +1,113 @@
+#include "src/server/chunk_server/chunk_io_backend.h"
+
+#include <absl/synchronization/blocking_counter.h>
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <filesystem>
+
+using dfs::server::ChunkIoBackend;
+using dfs::server::ChunkIoRequest;
+
+// 同时测试 io_uring 与线程池两种后端
+class ChunkIoBackendTest : public ::testing::TestWithParam<bool> {
+   protected:
+    void SetUp() override {
+        ChunkIoBackend::Options options;
+        options.queue_depth = 8;
+        options.thread_nums = 2;
+        options.buffer_nums = 2;
+        options.buffer_size = 4096;
+        options.use_thread_pool = GetParam();
+        backend_ = ChunkIoBackend::Create(options);
+
+        fd_ = open(kFilePath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        ASSERT_GE(fd_, 0);
+    }
+
+    void TearDown() override {
+        backend_.reset();
+        close(fd_);
+        std::filesystem::remove(kFilePath);
+    }
+
+    const char* kFilePath = "chunk_io_backend_test_file";
+
+    std::unique_ptr<ChunkIoBackend> backend_;
+
+    int fd_ = -1;
+};
+
+// 同步读写，读到文件末尾时返回实际读取的字节数
+TEST_P(ChunkIoBackendTest, ReadWriteTest) {
+    const std::string data = "abcdefghij";
+    EXPECT_TRUE(backend_->Write(fd_, 0, data.data(), data.size()).ok());
+    EXPECT_TRUE(backend_->Fsync(fd_).ok());
+
+    std::string read_data(data.size() + 10, '\0');
+    auto read_or = backend_->Read(fd_, 2, &read_data[0], read_data.size());
+    ASSERT_TRUE(read_or.ok());
+    EXPECT_EQ(read_or.value(), data.size() - 2);
+    EXPECT_EQ(read_data.substr(0, read_or.value()), data.substr(2));
+}
+
+// 使用注册缓冲区读写
+TEST_P(ChunkIoBackendTest, RegisteredBufferTest) {
+    const int write_index = backend_->AcquireBuffer();
+    const int read_index = backend_->AcquireBuffer();
+    ASSERT_GE(write_index, 0);
+    ASSERT_GE(read_index, 0);
+    EXPECT_EQ(backend_->AcquireBuffer(), -1);
+
+    char* write_buffer = backend_->GetBuffer(write_index);
+    memset(write_buffer, 'x', backend_->buffer_size());
+    EXPECT_TRUE(backend_
+                    ->Write(fd_, 0, write_buffer, backend_->buffer_size(),
+                            write_index)
+                    .ok());
+
+    char* read_buffer = backend_->GetBuffer(read_index);
+    auto read_or = backend_->Read(fd_, 0, read_buffer, backend_->buffer_size(),
+                                  read_index);
+    ASSERT_TRUE(read_or.ok());
+    EXPECT_EQ(read_or.value(), backend_->buffer_size());
+    EXPECT_EQ(memcmp(read_buffer, write_buffer, backend_->buffer_size()), 0);
+
+    backend_->ReleaseBuffer(write_index);
+    backend_->ReleaseBuffer(read_index);
+}
+
+// 一次提交超过队列长度的 I/O，所有回调都会被调用
+TEST_P(ChunkIoBackendTest, BatchSubmitTest) {
+    const int io_nums = 64;
+    std::vector<char> data(io_nums);
+    for (int i = 0; i < io_nums; i++) {
+        data[i] = 'a' + i % 26;
+    }
+
+    absl::BlockingCounter counter(io_nums);
+    std::vector<ChunkIoRequest> requests(io_nums);
+    for (int i = 0; i < io_nums; i++) {
+        requests[i].type = ChunkIoRequest::WRITE;
+        requests[i].fd = fd_;
+        requests[i].offset = i;
+        requests[i].buffer = &data[i];
+        requests[i].length = 1;
+        requests[i].callback = [&](int64_t result) {
+            EXPECT_EQ(result, 1);
+            counter.DecrementCount();
+        };
+    }
+    EXPECT_TRUE(backend_->Submit(std::move(requests)).ok());
+    counter.Wait();
+
+    std::vector<char> read_data(io_nums);
+    auto read_or = backend_->Read(fd_, 0, read_data.data(), io_nums);
+    ASSERT_TRUE(read_or.ok());
+    EXPECT_EQ(read_data, data);
+}
+
+INSTANTIATE_TEST_SUITE_P(ChunkIoBackends, ChunkIoBackendTest,
+                         ::testing::Values(false, true));
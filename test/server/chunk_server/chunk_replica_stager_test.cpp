@@ -0,0 +1,147 @@
+#include "src/server/chunk_server/chunk_replica_stager.h"
+
+#include <gtest/gtest.h>
+
+using dfs::server::ChunkIoBackend;
+using dfs::server::ChunkReplicaStager;
+
+class ChunkReplicaStagerTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        io_backend_ = ChunkIoBackend::Create(ChunkIoBackend::Options());
+        stager_ = std::make_unique<ChunkReplicaStager>(
+            "chunk_replica_stager_test", io_backend_.get());
+        ASSERT_TRUE(stager_->Initialize().ok());
+    }
+
+    // 将提交的数据片按顺序拼接
+    google::protobuf::util::Status CommitToString(
+        const std::string& chunk_handle, std::string* data) {
+        return stager_->Commit(
+            chunk_handle, [data](const uint64_t& offset, const char* piece,
+                                 const size_t& length) {
+                EXPECT_EQ(offset, data->size());
+                data->append(piece, length);
+                return google::protobuf::util::OkStatus();
+            });
+    }
+
+    std::unique_ptr<ChunkIoBackend> io_backend_;
+
+    std::unique_ptr<ChunkReplicaStager> stager_;
+};
+
+// 按顺序追加所有帧后提交，得到完整的数据块
+TEST_F(ChunkReplicaStagerTest, AppendAndCommitTest) {
+    auto offset_or = stager_->Begin("0", 1, 10);
+    ASSERT_TRUE(offset_or.ok());
+    EXPECT_EQ(offset_or.value(), 0);
+
+    // 数据块未接收完整时不能提交
+    EXPECT_TRUE(stager_->Append("0", 0, "abcd").ok());
+    std::string data;
+    EXPECT_FALSE(CommitToString("0", &data).ok());
+
+    // 偏移不连续或超过数据块大小
+    EXPECT_FALSE(stager_->Append("0", 8, "ij").ok());
+    EXPECT_FALSE(stager_->Append("0", 4, "efghijk").ok());
+
+    auto append_or = stager_->Append("0", 4, "efghij");
+    ASSERT_TRUE(append_or.ok());
+    EXPECT_EQ(append_or.value(), 10);
+
+    ASSERT_TRUE(CommitToString("0", &data).ok());
+    EXPECT_EQ(data, "abcdefghij");
+    EXPECT_EQ(stager_->GetStagedBytes("0"), 0);
+}
+
+// 传输中断后从已经写入的偏移处续传
+TEST_F(ChunkReplicaStagerTest, ResumeTest) {
+    ASSERT_TRUE(stager_->Begin("0", 1, 10).ok());
+    EXPECT_TRUE(stager_->Append("0", 0, "abcd").ok());
+
+    // 同一个数据块同时只允许一个传输
+    EXPECT_FALSE(stager_->Begin("0", 1, 10).ok());
+
+    stager_->Release("0");
+    EXPECT_FALSE(stager_->Append("0", 4, "efgh").ok());
+
+    auto offset_or = stager_->Begin("0", 1, 10);
+    ASSERT_TRUE(offset_or.ok());
+    EXPECT_EQ(offset_or.value(), 4);
+    EXPECT_TRUE(stager_->Append("0", 4, "efghij").ok());
+
+    std::string data;
+    ASSERT_TRUE(CommitToString("0", &data).ok());
+    EXPECT_EQ(data, "abcdefghij");
+}
+
+// 提交时按缓冲区大小逐片读出，写入失败时保留暂存数据
+TEST_F(ChunkReplicaStagerTest, CommitInPiecesTest) {
+    const size_t chunk_size = io_backend_->buffer_size() * 2 + 10;
+    std::string chunk(chunk_size, '\0');
+    for (size_t i = 0; i < chunk_size; i++) {
+        chunk[i] = static_cast<char>('a' + i % 26);
+    }
+    ASSERT_TRUE(stager_->Begin("0", 1, chunk_size).ok());
+    ASSERT_TRUE(stager_->Append("0", 0, chunk).ok());
+
+    EXPECT_FALSE(stager_
+                     ->Commit("0",
+                              [](const uint64_t& offset, const char* piece,
+                                 const size_t& length) {
+                                  return google::protobuf::util::
+                                      UnknownError("write failed");
+                              })
+                     .ok());
+    EXPECT_EQ(stager_->GetStagedBytes("0"), chunk_size);
+
+    size_t piece_nums = 0;
+    std::string data;
+    ASSERT_TRUE(stager_
+                    ->Commit("0",
+                             [&](const uint64_t& offset, const char* piece,
+                                 const size_t& length) {
+                                 EXPECT_LE(length, io_backend_->buffer_size());
+                                 piece_nums++;
+                                 data.append(piece, length);
+                                 return google::protobuf::util::OkStatus();
+                             })
+                    .ok());
+    EXPECT_EQ(piece_nums, 3);
+    EXPECT_EQ(data, chunk);
+    EXPECT_EQ(stager_->GetStagedBytes("0"), 0);
+}
+
+// 长度未知的数据块以上限开始接收，写入完成后确定长度
+TEST_F(ChunkReplicaStagerTest, SealAndReadTest) {
+    ASSERT_TRUE(stager_->Begin("0", 1, 100).ok());
+    EXPECT_TRUE(stager_->Append("0", 0, "abcdef").ok());
+    std::string data;
+    EXPECT_FALSE(CommitToString("0", &data).ok());
+
+    ASSERT_TRUE(stager_->Seal("0").ok());
+    auto read_or = stager_->Read("0", 2, 10);
+    ASSERT_TRUE(read_or.ok());
+    EXPECT_EQ(read_or.value(), "cdef");
+    EXPECT_FALSE(stager_->Append("0", 6, "g").ok());
+
+    ASSERT_TRUE(CommitToString("0", &data).ok());
+    EXPECT_EQ(data, "abcdef");
+    EXPECT_FALSE(stager_->Read("0", 0, 1).ok());
+}
+
+// 数据块版本变化后重新接收
+TEST_F(ChunkReplicaStagerTest, VersionChangedTest) {
+    ASSERT_TRUE(stager_->Begin("0", 1, 10).ok());
+    EXPECT_TRUE(stager_->Append("0", 0, "abcd").ok());
+    stager_->Release("0");
+
+    auto offset_or = stager_->Begin("0", 2, 10);
+    ASSERT_TRUE(offset_or.ok());
+    EXPECT_EQ(offset_or.value(), 0);
+
+    stager_->Abort("0");
+    EXPECT_EQ(stager_->GetStagedBytes("0"), 0);
+    EXPECT_FALSE(stager_->Append("0", 0, "abcd").ok());
+}
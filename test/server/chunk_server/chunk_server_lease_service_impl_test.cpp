@@ -123,6 +123,45 @@ TEST_F(ChunkServerLeaseServiceTest, GrantLeaseAlreadyExist) {
     EXPECT_EQ(respond_or.value().status(), GrantLeaseRespond::REJECTED_EXPIRED);
 }
 
+// 一次申请多个数据块的租约，每个数据块单独返回状态
+TEST_F(ChunkServerLeaseServiceTest, GrantLeaseBatch) {
+    auto request = MakeGrantLeaseRequest();
+    auto lease_chunk = request.add_batch();
+    lease_chunk->set_chunk_handle(RevokeLeaseChunkHandle);
+    lease_chunk->set_chunk_version(TestVersion);
+    lease_chunk = request.add_batch();
+    lease_chunk->set_chunk_handle("non_exist_chunk_handle");
+    lease_chunk->set_chunk_version(TestVersion);
+    lease_chunk = request.add_batch();
+    lease_chunk->set_chunk_handle(RevokeLeaseChunkHandle);
+    lease_chunk->set_chunk_version(TestVersion + 1);
+
+    auto respond_or = client_->SendRequest(request);
+    ASSERT_TRUE(respond_or.ok());
+    EXPECT_EQ(respond_or.value().status(), GrantLeaseRespond::ACCEPTED);
+    ASSERT_EQ(respond_or.value().batch_status_size(), 3);
+    EXPECT_EQ(respond_or.value().batch_status(0), GrantLeaseRespond::ACCEPTED);
+    EXPECT_EQ(respond_or.value().batch_status(1),
+              GrantLeaseRespond::REJECTED_NOT_FOUND);
+    EXPECT_EQ(respond_or.value().batch_status(2),
+              GrantLeaseRespond::REJECTED_VERSION);
+}
+
+TEST_F(ChunkServerLeaseServiceTest, RevokeLease) {
+    RevokeLeaseRequest request;
+    request.add_chunk_handles(RevokeLeaseChunkHandle);
+    request.add_chunk_handles("non_exist_chunk_handle");
+    auto respond_or = client_->SendRequest(request);
+    ASSERT_TRUE(respond_or.ok());
+    ASSERT_EQ(respond_or.value().revoked_chunk_handles_size(), 1);
+    EXPECT_EQ(respond_or.value().revoked_chunk_handles(0),
+              RevokeLeaseChunkHandle);
+    EXPECT_FALSE(
+        ChunkServerImpl::GetInstance()->HasWriteLease(RevokeLeaseChunkHandle));
+    EXPECT_TRUE(
+        ChunkServerImpl::GetInstance()->HasWriteLease(GrantLeaseChunkHandle));
+}
+
 int main(int argc, char* argv[]) {
     ::testing::InitGoogleTest(&argc, argv);
 
@@ -0,0 +1,143 @@
+#include "src/server/chunk_server/chunk_stripe_coder.h"
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+#include <absl/synchronization/mutex.h>
+#include <gtest/gtest.h>
+
+#include <random>
+
+using dfs::server::ChunkStripeCoder;
+using protos::grpc::StripeShard;
+
+class ChunkStripeCoderTest : public ::testing::Test {
+   protected:
+    static constexpr uint32_t kDataShards = 6;
+    static constexpr uint32_t kParityShards = 3;
+    static constexpr uint64_t kCellSize = 1000;
+
+    void SetUp() override {
+        coder_ = std::make_unique<ChunkStripeCoder>(
+            kDataShards, kParityShards, kCellSize,
+            [this](const StripeShard& shard, uint64_t offset,
+                   uint64_t length)
+                -> google::protobuf::util::StatusOr<std::string> {
+                absl::MutexLock lock_guard(&lock_);
+                read_handles_.insert(shard.chunk_handle());
+                if (lost_handles_.contains(shard.chunk_handle()) ||
+                    !chunks_.contains(shard.chunk_handle())) {
+                    return google::protobuf::util::UnavailableError(
+                        "shard is lost");
+                }
+                const auto& data = chunks_[shard.chunk_handle()];
+                if (offset >= data.size()) {
+                    return std::string();
+                }
+                return data.substr(offset, length);
+            });
+    }
+
+    std::string MakeData(size_t nbytes, uint32_t seed) {
+        std::mt19937 random(seed);
+        std::string data(nbytes, '\0');
+        for (auto& c : data) {
+            c = static_cast<char>(random());
+        }
+        return data;
+    }
+
+    // 创建一个条带，sizes 为每个数据块的长度，长度为 0 的数据块不存在
+    std::vector<StripeShard> MakeStripe(const std::vector<size_t>& sizes) {
+        std::vector<StripeShard> data;
+        for (size_t i = 0; i < sizes.size(); i++) {
+            StripeShard shard;
+            if (sizes[i] > 0) {
+                shard.set_chunk_handle("data" + std::to_string(i));
+                chunks_[shard.chunk_handle()] = MakeData(sizes[i], i);
+            }
+            data.push_back(shard);
+        }
+
+        std::vector<std::string> parity;
+        std::vector<uint64_t> data_sizes;
+        EXPECT_TRUE(coder_->Encode(data, &parity, &data_sizes).ok());
+        EXPECT_EQ(parity.size(), kParityShards);
+
+        auto shards = data;
+        for (size_t i = 0; i < sizes.size(); i++) {
+            EXPECT_EQ(data_sizes[i], sizes[i]);
+            shards[i].set_size(sizes[i]);
+        }
+        const size_t parity_size = *std::max_element(sizes.begin(), sizes.end());
+        for (uint32_t i = 0; i < kParityShards; i++) {
+            EXPECT_EQ(parity[i].size(), parity_size);
+            StripeShard shard;
+            shard.set_chunk_handle("parity" + std::to_string(i));
+            shard.set_size(parity[i].size());
+            chunks_[shard.chunk_handle()] = parity[i];
+            shards.push_back(shard);
+        }
+        return shards;
+    }
+
+    std::unique_ptr<ChunkStripeCoder> coder_;
+
+    absl::Mutex lock_;
+    absl::flat_hash_map<std::string, std::string> chunks_;
+    absl::flat_hash_set<std::string> lost_handles_;
+    absl::flat_hash_set<std::string> read_handles_;
+};
+
+// 丢失的数据块与校验块都可以重建，数据块长度不同，最后一个数据块不存在
+TEST_F(ChunkStripeCoderTest, ReconstructTest) {
+    auto shards = MakeStripe({4500, 4000, 3999, 1, 2500, 0});
+    for (uint32_t i = 0; i < kDataShards + kParityShards; i++) {
+        if (shards[i].chunk_handle().empty()) {
+            continue;
+        }
+        auto data_or = coder_->Reconstruct(shards, i, nullptr);
+        ASSERT_TRUE(data_or.ok()) << data_or.status().ToString();
+        EXPECT_EQ(data_or.value(), chunks_[shards[i].chunk_handle()])
+            << "shard: " << i;
+    }
+}
+
+// 只读取 k 个分片，数据分片优先，不存在的数据块不需要读取
+TEST_F(ChunkStripeCoderTest, ReadDataShardsFirstTest) {
+    auto shards = MakeStripe({3000, 3000, 3000, 3000, 3000, 0});
+    std::vector<uint32_t> read_shards;
+    auto data_or = coder_->Reconstruct(shards, 1, &read_shards);
+    ASSERT_TRUE(data_or.ok());
+    EXPECT_EQ(data_or.value(), chunks_["data1"]);
+    EXPECT_EQ(read_shards, std::vector<uint32_t>({0, 2, 3, 4, 6}));
+    EXPECT_FALSE(read_handles_.contains("parity1"));
+    EXPECT_FALSE(read_handles_.contains("parity2"));
+}
+
+// 读取失败的分片换成其他分片，丢失超过 m 个分片时无法重建
+TEST_F(ChunkStripeCoderTest, LostShardsTest) {
+    auto shards = MakeStripe({2048, 2048, 2048, 2048, 2048, 2048});
+    lost_handles_ = {"data0", "data2"};
+
+    std::vector<uint32_t> read_shards;
+    auto data_or = coder_->Reconstruct(shards, 4, &read_shards);
+    ASSERT_TRUE(data_or.ok()) << data_or.status().ToString();
+    EXPECT_EQ(data_or.value(), chunks_["data4"]);
+    EXPECT_EQ(read_shards, std::vector<uint32_t>({1, 3, 5, 6, 7, 8}));
+
+    lost_handles_.insert("parity0");
+    data_or = coder_->Reconstruct(shards, 4, nullptr);
+    EXPECT_TRUE(google::protobuf::util::IsDataLoss(data_or.status()));
+}
+
+TEST_F(ChunkStripeCoderTest, EncodeFailedTest) {
+    std::vector<StripeShard> data(kDataShards);
+    data[0].set_chunk_handle("missing");
+    std::vector<std::string> parity;
+    std::vector<uint64_t> data_sizes;
+    EXPECT_FALSE(coder_->Encode(data, &parity, &data_sizes).ok());
+
+    data.pop_back();
+    EXPECT_TRUE(google::protobuf::util::IsInvalidArgument(
+        coder_->Encode(data, &parity, &data_sizes)));
+}
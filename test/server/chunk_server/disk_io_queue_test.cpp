@@ -0,0 +1,125 @@
+#include "src/server/chunk_server/disk_io_queue.h"
+
+#include <absl/synchronization/notification.h>
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+using dfs::server::DiskIoQueue;
+using dfs::server::IoPriority;
+
+class DiskIoQueueTest : public ::testing::Test {
+   protected:
+    // 提交一个阻塞 I/O 线程的任务，返回时任务已经开始执行
+    std::thread BlockQueue(DiskIoQueue* queue, const IoPriority& priority,
+                           absl::Notification* blocker) {
+        auto started = std::make_shared<absl::Notification>();
+        std::thread thread([=]() {
+            queue->Execute(priority, [&]() {
+                started->Notify();
+                blocker->WaitForNotification();
+            });
+        });
+        started->WaitForNotification();
+        return thread;
+    }
+
+    // 等待队列中有 nums 个任务
+    void WaitQueuedOps(DiskIoQueue* queue, const size_t& nums) {
+        while (queue->GetQueuedOps() < nums) {
+            std::this_thread::yield();
+        }
+    }
+};
+
+// 优先级高的 I/O 先执行
+TEST_F(DiskIoQueueTest, PriorityTest) {
+    DiskIoQueue::Options options;
+    options.io_depth = 1;
+    DiskIoQueue queue("disk", options);
+
+    absl::Notification blocker;
+    auto blocking_thread =
+        BlockQueue(&queue, IoPriority::FOREGROUND_READ, &blocker);
+
+    std::vector<IoPriority> order;
+    std::vector<std::thread> threads;
+    for (auto priority : {IoPriority::SCRUBBING, IoPriority::REPLICATION,
+                          IoPriority::FOREGROUND_WRITE,
+                          IoPriority::FOREGROUND_READ}) {
+        threads.emplace_back([&, priority]() {
+            EXPECT_TRUE(queue
+                            .Execute(priority,
+                                     [&]() { order.push_back(priority); })
+                            .ok());
+        });
+        WaitQueuedOps(&queue, threads.size());
+    }
+
+    blocker.Notify();
+    blocking_thread.join();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(order, std::vector<IoPriority>(
+                         {IoPriority::FOREGROUND_READ,
+                          IoPriority::FOREGROUND_WRITE, IoPriority::REPLICATION,
+                          IoPriority::SCRUBBING}));
+}
+
+// 后台 I/O 不会占满所有线程
+TEST_F(DiskIoQueueTest, BackgroundDepthTest) {
+    DiskIoQueue::Options options;
+    options.io_depth = 2;
+    options.max_background_depth = 1;
+    DiskIoQueue queue("disk", options);
+
+    absl::Notification blocker;
+    auto blocking_thread = BlockQueue(&queue, IoPriority::REPLICATION, &blocker);
+
+    // 另一个后台 I/O 需要等待
+    std::thread scrubbing_thread([&]() {
+        EXPECT_TRUE(queue.Execute(IoPriority::SCRUBBING, []() {}).ok());
+    });
+    WaitQueuedOps(&queue, 1);
+    EXPECT_EQ(queue.GetQueuedOps(IoPriority::SCRUBBING), 1);
+
+    // 客户端 I/O 仍然可以执行
+    EXPECT_TRUE(queue.Execute(IoPriority::FOREGROUND_READ, []() {}).ok());
+    EXPECT_EQ(queue.GetQueuedOps(IoPriority::SCRUBBING), 1);
+
+    blocker.Notify();
+    blocking_thread.join();
+    scrubbing_thread.join();
+    EXPECT_EQ(queue.GetQueuedOps(), 0);
+}
+
+// 队列已满时拒绝新的 I/O
+TEST_F(DiskIoQueueTest, QueueFullTest) {
+    DiskIoQueue::Options options;
+    options.io_depth = 1;
+    options.max_queued_ops = 1;
+    DiskIoQueue queue("disk", options);
+
+    absl::Notification blocker;
+    auto blocking_thread =
+        BlockQueue(&queue, IoPriority::FOREGROUND_WRITE, &blocker);
+
+    std::thread queued_thread([&]() {
+        EXPECT_TRUE(queue.Execute(IoPriority::FOREGROUND_READ, []() {}).ok());
+    });
+    WaitQueuedOps(&queue, 1);
+
+    auto status = queue.Execute(IoPriority::FOREGROUND_READ, []() {});
+    EXPECT_TRUE(google::protobuf::util::IsResourceExhausted(status));
+
+    blocker.Notify();
+    blocking_thread.join();
+    queued_thread.join();
+
+    queue.Shutdown();
+    status = queue.Execute(IoPriority::FOREGROUND_READ, []() {});
+    EXPECT_TRUE(google::protobuf::util::IsUnavailable(status));
+}
@@ -0,0 +1,222 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <thread>
+
+#include "src/common/utils.h"
+#include "src/grpc_client/chunk_server_file_service_client.h"
+#include "src/server/chunk_server/chunk_server_file_service_impl.h"
+
+using namespace dfs::server;
+using namespace dfs::grpc_client;
+
+using grpc::Server;
+using grpc::ServerBuilder;
+using protos::grpc::EncodeStripeRequest;
+using protos::grpc::ReconstructChunkRequest;
+using protos::grpc::StripeShard;
+
+/**
+ * 进程内的纠删码集群测试
+ * 1. 启动 kServerNums 个块服务器，条带为 RS(3, 2)，每个分片放在不同的
+ *    块服务器上
+ * 2. 同一进程内的块服务器共用一个 FileChunkManager，停止块服务器的同时
+ *    删除该块服务器上的分片，模拟块服务器宕机
+ */
+const uint32_t kDataShards = 3;
+const uint32_t kParityShards = 2;
+const uint32_t kServerNums = kDataShards + kParityShards;
+const uint32_t kBasePort = 55101;
+const uint32_t kChunkVersion = 1;
+
+// 每个数据块的长度，最后一个数据块不存在
+const std::vector<size_t> kDataSizes = {1536 * 1024, 1024 * 1024 + 7, 0};
+
+std::vector<std::unique_ptr<Server>> servers(kServerNums);
+std::vector<std::string> chunk_datas(kDataShards);
+
+std::string ServerAddress(uint32_t index) {
+    return "0.0.0.0:" + std::to_string(kBasePort + index);
+}
+
+std::string ShardHandle(uint32_t index) {
+    return index < kDataShards
+               ? "ec_cluster_data" + std::to_string(index)
+               : "ec_cluster_parity" + std::to_string(index - kDataShards);
+}
+
+void BuildServers() {
+    FileChunkManager::GetInstance()->Initialize(
+        "erasure_coding_cluster_test", 4 * dfs::common::bytesMB);
+
+    std::vector<std::unique_ptr<ChunkServerFileServiceImpl>> services;
+    for (uint32_t i = 0; i < kServerNums; i++) {
+        services.push_back(std::make_unique<ChunkServerFileServiceImpl>());
+
+        ServerBuilder builder;
+        builder.AddListeningPort(ServerAddress(i),
+                                 grpc::InsecureServerCredentials());
+        builder.RegisterService(services.back().get());
+        servers[i] = builder.BuildAndStart();
+        std::cout << "Server listening on " << ServerAddress(i) << std::endl;
+    }
+    for (auto& server : servers) {
+        server->Wait();
+    }
+}
+
+void InitChunks() {
+    std::mt19937 random(44);
+    auto file_chunk_manager = FileChunkManager::GetInstance();
+    for (uint32_t i = 0; i < kDataShards; i++) {
+        if (kDataSizes[i] == 0) {
+            continue;
+        }
+        chunk_datas[i].resize(kDataSizes[i]);
+        for (auto& c : chunk_datas[i]) {
+            c = static_cast<char>(random());
+        }
+        file_chunk_manager->CreateChunk(ShardHandle(i), kChunkVersion);
+        file_chunk_manager->WriteToChunk(ShardHandle(i), kChunkVersion, 0,
+                                         chunk_datas[i].size(),
+                                         chunk_datas[i]);
+    }
+}
+
+// 分片 index 放在第 index 个块服务器上
+StripeShard MakeShard(uint32_t index) {
+    StripeShard shard;
+    if (index >= kDataShards || kDataSizes[index] > 0) {
+        shard.set_chunk_handle(ShardHandle(index));
+        shard.set_version(kChunkVersion);
+        auto location = shard.add_locations();
+        location->set_server_hostname("0.0.0.0");
+        location->set_server_port(kBasePort + index);
+    }
+    return shard;
+}
+
+// 停止块服务器并删除它保存的分片
+void KillServer(uint32_t index) {
+    servers[index]->Shutdown();
+    FileChunkManager::GetInstance()->DeleteChunk(ShardHandle(index));
+}
+
+class ErasureCodingClusterTest : public ::testing::Test {
+   protected:
+    std::shared_ptr<ChunkServerFileServiceClient> Client(uint32_t index) {
+        return std::make_shared<ChunkServerFileServiceClient>(
+            grpc::CreateChannel(ServerAddress(index),
+                                grpc::InsecureChannelCredentials()));
+    }
+
+    ReconstructChunkRequest MakeReconstructRequest(uint32_t shard_index) {
+        ReconstructChunkRequest request;
+        request.set_data_shards(kDataShards);
+        request.set_parity_shards(kParityShards);
+        for (uint32_t i = 0; i < kServerNums; i++) {
+            auto shard = MakeShard(i);
+            shard.set_size(i < kDataShards ? kDataSizes[i] : parity_size_);
+            *request.add_shards() = shard;
+        }
+        request.set_shard_index(shard_index);
+        return request;
+    }
+
+    static uint64_t parity_size_;
+};
+
+uint64_t ErasureCodingClusterTest::parity_size_ = 0;
+
+// 测试按顺序执行，后面的测试依赖前面写入的校验块
+
+// 由第一个数据块所在的块服务器编码，校验块写入其他块服务器
+TEST_F(ErasureCodingClusterTest, EncodeStripeTest) {
+    EncodeStripeRequest request;
+    request.set_data_shards(kDataShards);
+    request.set_parity_shards(kParityShards);
+    for (uint32_t i = 0; i < kServerNums; i++) {
+        *(i < kDataShards ? request.add_data() : request.add_parity()) =
+            MakeShard(i);
+    }
+
+    auto respond_or = Client(0)->SendRequest(request);
+    ASSERT_TRUE(respond_or.ok()) << respond_or.status().ToString();
+    const auto& respond = respond_or.value();
+    ASSERT_EQ(respond.data_sizes_size(), kDataShards);
+    for (uint32_t i = 0; i < kDataShards; i++) {
+        EXPECT_EQ(respond.data_sizes(i), kDataSizes[i]);
+    }
+    EXPECT_EQ(respond.parity_size(), kDataSizes[0]);
+    parity_size_ = respond.parity_size();
+
+    for (uint32_t i = kDataShards; i < kServerNums; i++) {
+        EXPECT_TRUE(
+            FileChunkManager::GetInstance()->GetChunkVersion(ShardHandle(i))
+                .ok());
+    }
+}
+
+// 第一个数据块所在的块服务器宕机，在其他块服务器上重建
+TEST_F(ErasureCodingClusterTest, ReconstructDataChunkTest) {
+    KillServer(0);
+
+    auto respond_or = Client(3)->SendRequest(MakeReconstructRequest(0));
+    ASSERT_TRUE(respond_or.ok()) << respond_or.status().ToString();
+    EXPECT_EQ(respond_or.value().chunk_size(), kDataSizes[0]);
+    // 不存在的数据块不需要读取
+    EXPECT_EQ(std::vector<uint32_t>(respond_or.value().read_shards().begin(),
+                                    respond_or.value().read_shards().end()),
+              std::vector<uint32_t>({1, 3}));
+
+    auto data_or = FileChunkManager::GetInstance()->ReadFromChunk(
+        ShardHandle(0), kChunkVersion, 0, kDataSizes[0]);
+    ASSERT_TRUE(data_or.ok());
+    EXPECT_EQ(data_or.value(), chunk_datas[0]);
+}
+
+// 再宕机一个块服务器，丢失的分片不超过校验块个数，仍然可以重建
+TEST_F(ErasureCodingClusterTest, ReconstructAfterTwoFailuresTest) {
+    KillServer(1);
+
+    auto respond_or = Client(4)->SendRequest(MakeReconstructRequest(1));
+    ASSERT_TRUE(respond_or.ok()) << respond_or.status().ToString();
+    EXPECT_EQ(respond_or.value().chunk_size(), kDataSizes[1]);
+
+    auto data_or = FileChunkManager::GetInstance()->ReadFromChunk(
+        ShardHandle(1), kChunkVersion, 0, kDataSizes[1]);
+    ASSERT_TRUE(data_or.ok());
+    EXPECT_EQ(data_or.value(), chunk_datas[1]);
+}
+
+// 存活的分片不足 data_shards 个时无法重建
+TEST_F(ErasureCodingClusterTest, DataLossTest) {
+    FileChunkManager::GetInstance()->DeleteChunk(ShardHandle(0));
+    FileChunkManager::GetInstance()->DeleteChunk(ShardHandle(1));
+    KillServer(3);
+
+    auto respond_or = Client(4)->SendRequest(MakeReconstructRequest(0));
+    EXPECT_TRUE(google::protobuf::util::IsDataLoss(respond_or.status()))
+        << respond_or.status().ToString();
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+
+    std::thread server_thread = std::thread(BuildServers);
+    std::this_thread::sleep_for(std::chrono::seconds(3));
+    InitChunks();
+
+    // Run tests
+    int exit_code = RUN_ALL_TESTS();
+
+    for (uint32_t i = 0; i < kServerNums; i++) {
+        FileChunkManager::GetInstance()->DeleteChunk(ShardHandle(i));
+    }
+
+    // Clean up background server
+    pthread_cancel(server_thread.native_handle());
+    server_thread.join();
+
+    return exit_code;
+}
@@ -63,4 +63,354 @@ TEST_F(FileChunkManagerTest, RunTest) {
     write_len_or = fileChunkManager_->WriteToChunk(chunk_handle, version, 0,
                                                    data.size(), data);
     EXPECT_FALSE(write_len_or.ok());
-}
\ No newline at end of file
+}
+TEST_F(FileChunkManagerTest, FileChunkReaderTest) {
+    const std::string& chunk_handle = "1";
+    const std::string& data = "abcdefghijk";
+    uint32_t version = 3;
+
+    // unable to open non-exist chunk
+    EXPECT_FALSE(fileChunkManager_->OpenFileChunkReader(chunk_handle).ok());
+
+    EXPECT_TRUE(fileChunkManager_->CreateChunk(chunk_handle, version).ok());
+    EXPECT_TRUE(fileChunkManager_
+                    ->WriteToChunk(chunk_handle, version, 0, data.size(), data)
+                    .ok());
+
+    auto reader_or = fileChunkManager_->OpenFileChunkReader(chunk_handle);
+    ASSERT_TRUE(reader_or.ok());
+    auto reader = reader_or.value();
+    EXPECT_EQ(reader->version(), version);
+    EXPECT_EQ(reader->size(), data.size());
+
+    // read by frames
+    EXPECT_EQ(reader->Read(0, 4).value(), "abcd");
+    EXPECT_EQ(reader->Read(8, 4).value(), "ijk");
+    EXPECT_EQ(reader->Read(data.size(), 4).value(), "");
+
+    EXPECT_TRUE(fileChunkManager_->DeleteChunk(chunk_handle).ok());
+}
+
+TEST_F(FileChunkManagerTest, MultiDiskTest) {
+    const std::vector<std::string> data_dirs = {
+        "file_chunk_manager_test_disk0", "file_chunk_manager_test_disk1"};
+    ASSERT_TRUE(fileChunkManager_->Initialize(data_dirs, 1024,
+                                              DiskIoQueue::Options()));
+    EXPECT_EQ(fileChunkManager_->GetDiskNums(), 2);
+
+    // new chunks are spread across the disks
+    const uint32_t version = 1;
+    EXPECT_TRUE(fileChunkManager_->CreateChunk("disk_chunk_0", version).ok());
+    EXPECT_TRUE(fileChunkManager_->CreateChunk("disk_chunk_1", version).ok());
+    EXPECT_NE(fileChunkManager_->GetChunkDataDir("disk_chunk_0"),
+              fileChunkManager_->GetChunkDataDir("disk_chunk_1"));
+    EXPECT_TRUE(fileChunkManager_
+                    ->WriteToChunk("disk_chunk_1", version, 0, 3, "abc")
+                    .ok());
+
+    // chunks are found on their disk after restart
+    ASSERT_TRUE(fileChunkManager_->Initialize(data_dirs, 1024,
+                                              DiskIoQueue::Options()));
+    EXPECT_EQ(fileChunkManager_->GetAllFileChunkMetadata().size(), 2);
+    auto read_data_or =
+        fileChunkManager_->ReadFromChunk("disk_chunk_1", version, 0, 3);
+    ASSERT_TRUE(read_data_or.ok());
+    EXPECT_EQ(read_data_or.value(), "abc");
+
+    EXPECT_TRUE(fileChunkManager_->DeleteChunk("disk_chunk_0").ok());
+    EXPECT_TRUE(fileChunkManager_->DeleteChunk("disk_chunk_1").ok());
+    EXPECT_EQ(fileChunkManager_->GetChunkDataDir("disk_chunk_0"), "");
+}
+
+TEST_F(FileChunkManagerTest, DirectIoTest) {
+    const std::vector<std::string> data_dirs = {
+        "file_chunk_manager_test_direct_io"};
+    ChunkStoreOptions store_options;
+    store_options.direct_io = true;
+    store_options.cache_block_size = 4096;
+    ASSERT_TRUE(fileChunkManager_->Initialize(
+        data_dirs, 64 * 1024, DiskIoQueue::Options(), ChunkIoBackend::Options(),
+        store_options));
+    EXPECT_TRUE(fileChunkManager_->IsDirectIo());
+
+    const std::string chunk_handle = "direct_io_chunk";
+    const uint32_t version = 1;
+    std::string data(10000, 'a');
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = 'a' + i % 26;
+    }
+
+    EXPECT_TRUE(fileChunkManager_->CreateChunk(chunk_handle, version).ok());
+    auto write_len_or = fileChunkManager_->WriteToChunk(
+        chunk_handle, version, 0, data.size(), data);
+    ASSERT_TRUE(write_len_or.ok());
+    EXPECT_EQ(write_len_or.value(), data.size());
+
+    // the second read is served by the block cache
+    auto cache = fileChunkManager_->GetChunkBlockCache();
+    auto read_data_or =
+        fileChunkManager_->ReadFromChunk(chunk_handle, version, 100, 5000);
+    ASSERT_TRUE(read_data_or.ok());
+    EXPECT_EQ(read_data_or.value(), data.substr(100, 5000));
+    const uint64_t misses = cache->GetMisses();
+    read_data_or =
+        fileChunkManager_->ReadFromChunk(chunk_handle, version, 100, 5000);
+    ASSERT_TRUE(read_data_or.ok());
+    EXPECT_EQ(read_data_or.value(), data.substr(100, 5000));
+    EXPECT_EQ(cache->GetMisses(), misses);
+    EXPECT_GT(cache->GetHitRate(), 0);
+    EXPECT_GT(cache->GetResidentBytes(), 0);
+
+    // unaligned overwrite and append invalidate the cached blocks
+    data.replace(4000, 200, std::string(200, 'x'));
+    EXPECT_TRUE(fileChunkManager_
+                    ->WriteToChunk(chunk_handle, version, 4000, 200,
+                                   std::string(200, 'x'))
+                    .ok());
+    data += "append";
+    EXPECT_TRUE(
+        fileChunkManager_->AppendToChunk(chunk_handle, version, 6, "append")
+            .ok());
+    read_data_or = fileChunkManager_->ReadFromChunk(chunk_handle, version, 0,
+                                                    data.size() + 100);
+    ASSERT_TRUE(read_data_or.ok());
+    EXPECT_EQ(read_data_or.value(), data);
+
+    EXPECT_TRUE(
+        fileChunkManager_->UpdateChunkVersion(chunk_handle, version, version + 1)
+            .ok());
+    auto reader_or = fileChunkManager_->OpenFileChunkReader(chunk_handle);
+    ASSERT_TRUE(reader_or.ok());
+    EXPECT_EQ(reader_or.value()->version(), version + 1);
+    EXPECT_EQ(reader_or.value()->Read(0, data.size()).value(), data);
+    // frames are read from the chunk file on demand, across page boundaries
+    EXPECT_EQ(reader_or.value()->Read(4090, 1000).value(),
+              data.substr(4090, 1000));
+    EXPECT_EQ(reader_or.value()->Read(9000, 4096).value(), data.substr(9000));
+
+    // chunk data survives restart
+    ASSERT_TRUE(fileChunkManager_->Initialize(
+        data_dirs, 64 * 1024, DiskIoQueue::Options(), ChunkIoBackend::Options(),
+        store_options));
+    auto chunk_or = fileChunkManager_->GetFileChunk(chunk_handle, version + 1);
+    ASSERT_TRUE(chunk_or.ok());
+    EXPECT_EQ(chunk_or.value()->data(), data);
+
+    EXPECT_TRUE(fileChunkManager_->DeleteChunk(chunk_handle).ok());
+    EXPECT_FALSE(
+        fileChunkManager_->ReadFromChunk(chunk_handle, version + 1, 0, 1).ok());
+}
+
+TEST_F(FileChunkManagerTest, ReadCacheTest) {
+    const std::vector<std::string> data_dirs = {"file_chunk_manager_test_cache"};
+    ChunkStoreOptions store_options;
+    store_options.cache_block_size = 4096;
+    ASSERT_TRUE(fileChunkManager_->Initialize(
+        data_dirs, 64 * 1024, DiskIoQueue::Options(), ChunkIoBackend::Options(),
+        store_options));
+
+    const std::string chunk_handle = "read_cache_chunk";
+    const uint32_t version = 1;
+    std::string data(10000, 'a');
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = 'a' + i % 26;
+    }
+    EXPECT_TRUE(fileChunkManager_->CreateChunk(chunk_handle, version).ok());
+    EXPECT_TRUE(fileChunkManager_
+                    ->WriteToChunk(chunk_handle, version, 0, data.size(), data)
+                    .ok());
+
+    // the hot range is read from disk only once
+    auto cache = fileChunkManager_->GetChunkBlockCache();
+    for (int i = 0; i < 3; i++) {
+        auto read_data_or =
+            fileChunkManager_->ReadFromChunk(chunk_handle, version, 5000, 3000);
+        ASSERT_TRUE(read_data_or.ok());
+        EXPECT_EQ(read_data_or.value(), data.substr(5000, 3000));
+    }
+    EXPECT_EQ(cache->GetMisses(), 1);
+    EXPECT_EQ(cache->GetHits(), 2);
+
+    // reading past the end of the chunk
+    EXPECT_EQ(fileChunkManager_
+                  ->ReadFromChunk(chunk_handle, version, 9000, 5000)
+                  .value(),
+              data.substr(9000));
+    EXPECT_EQ(
+        fileChunkManager_->ReadFromChunk(chunk_handle, version, 10000, 10)
+            .value(),
+        "");
+    EXPECT_FALSE(
+        fileChunkManager_->ReadFromChunk(chunk_handle, version, 20000, 10)
+            .ok());
+
+    // stale versions are not served from the cache
+    EXPECT_TRUE(
+        fileChunkManager_->UpdateChunkVersion(chunk_handle, version, version + 1)
+            .ok());
+    EXPECT_FALSE(
+        fileChunkManager_->ReadFromChunk(chunk_handle, version, 5000, 3000)
+            .ok());
+    data.replace(6000, 10, std::string(10, 'x'));
+    EXPECT_TRUE(fileChunkManager_
+                    ->WriteToChunk(chunk_handle, version + 1, 6000, 10,
+                                   std::string(10, 'x'))
+                    .ok());
+    EXPECT_EQ(fileChunkManager_
+                  ->ReadFromChunk(chunk_handle, version + 1, 5000, 3000)
+                  .value(),
+              data.substr(5000, 3000));
+}
+
+TEST_F(FileChunkManagerTest, CompressedChunkTest) {
+    for (const bool direct_io : {false, true}) {
+        const std::vector<std::string> data_dirs = {
+            direct_io ? "file_chunk_manager_test_compressed_direct_io"
+                      : "file_chunk_manager_test_compressed"};
+        ChunkStoreOptions store_options;
+        store_options.direct_io = direct_io;
+        store_options.cache_block_size = 4096;
+        ASSERT_TRUE(fileChunkManager_->Initialize(
+            data_dirs, 64 * 1024, DiskIoQueue::Options(),
+            ChunkIoBackend::Options(), store_options));
+
+        for (const auto codec : {protos::CODEC_LZ4, protos::CODEC_ZSTD}) {
+            const std::string chunk_handle =
+                "compressed_chunk_" + std::to_string(codec);
+            const uint32_t version = 1;
+            std::string data;
+            for (int i = 0; data.size() < 20000; i++) {
+                data += "line " + std::to_string(i % 100) + " of the log\n";
+            }
+
+            EXPECT_TRUE(fileChunkManager_
+                            ->CreateChunk(chunk_handle, version,
+                                          IoPriority::FOREGROUND_WRITE, codec)
+                            .ok());
+            EXPECT_TRUE(
+                fileChunkManager_
+                    ->WriteToChunk(chunk_handle, version, 0, data.size(), data)
+                    .ok());
+
+            // random reads only decompress the blocks they touch
+            EXPECT_EQ(fileChunkManager_
+                          ->ReadFromChunk(chunk_handle, version, 5000, 3000)
+                          .value(),
+                      data.substr(5000, 3000));
+
+            // overwrite in the middle, then append across a block boundary
+            data.replace(4090, 20, std::string(20, 'x'));
+            EXPECT_TRUE(fileChunkManager_
+                            ->WriteToChunk(chunk_handle, version, 4090, 20,
+                                           std::string(20, 'x'))
+                            .ok());
+            const std::string tail(5000, 'y');
+            data += tail;
+            EXPECT_TRUE(fileChunkManager_
+                            ->AppendToChunk(chunk_handle, version, tail.size(),
+                                            tail)
+                            .ok());
+            EXPECT_EQ(fileChunkManager_
+                          ->ReadFromChunk(chunk_handle, version, 0,
+                                          data.size() + 100)
+                          .value(),
+                      data);
+
+            // the stored data is smaller than the raw data
+            auto reader_or =
+                fileChunkManager_->OpenFileChunkReader(chunk_handle);
+            ASSERT_TRUE(reader_or.ok());
+            auto reader = reader_or.value();
+            EXPECT_EQ(reader->metadata().codec(), codec);
+            EXPECT_EQ(reader->metadata().raw_size(), data.size());
+            EXPECT_LT(reader->size(), data.size() / 2);
+
+            // a replica copied with the compressed data reads the same
+            protos::FileChunk replica = reader->metadata();
+            replica.clear_size();
+            replica.set_data(reader->Read(0, reader->size()).value());
+            const std::string replica_handle = chunk_handle + "_replica";
+            EXPECT_TRUE(
+                fileChunkManager_->WriteFileChunk(replica_handle, replica).ok());
+            EXPECT_EQ(fileChunkManager_
+                          ->ReadFromChunk(replica_handle, version, 0,
+                                          data.size())
+                          .value(),
+                      data);
+
+            // GetFileChunk returns the raw data after restart
+            ASSERT_TRUE(fileChunkManager_->Initialize(
+                data_dirs, 64 * 1024, DiskIoQueue::Options(),
+                ChunkIoBackend::Options(), store_options));
+            auto chunk_or = fileChunkManager_->GetFileChunk(chunk_handle);
+            ASSERT_TRUE(chunk_or.ok());
+            EXPECT_EQ(chunk_or.value()->data(), data);
+
+            EXPECT_TRUE(fileChunkManager_->DeleteChunk(chunk_handle).ok());
+            EXPECT_TRUE(fileChunkManager_->DeleteChunk(replica_handle).ok());
+        }
+    }
+}
+
+TEST_F(FileChunkManagerTest, CompressedChunkOverwriteTest) {
+    for (const bool direct_io : {false, true}) {
+        const std::vector<std::string> data_dirs = {
+            direct_io ? "file_chunk_manager_test_overwrite_direct_io"
+                      : "file_chunk_manager_test_overwrite"};
+        ChunkStoreOptions store_options;
+        store_options.direct_io = direct_io;
+        store_options.cache_block_size = 4096;
+        ASSERT_TRUE(fileChunkManager_->Initialize(
+            data_dirs, 64 * 1024, DiskIoQueue::Options(),
+            ChunkIoBackend::Options(), store_options));
+
+        const std::string chunk_handle = "overwrite_chunk";
+        const uint32_t version = 1;
+        std::string data;
+        for (int i = 0; data.size() < 40000; i++) {
+            data += "record " + std::to_string(i) + "\n";
+        }
+        EXPECT_TRUE(fileChunkManager_
+                        ->CreateChunk(chunk_handle, version,
+                                      IoPriority::FOREGROUND_WRITE,
+                                      protos::CODEC_LZ4)
+                        .ok());
+        EXPECT_TRUE(
+            fileChunkManager_
+                ->WriteToChunk(chunk_handle, version, 0, data.size(), data)
+                .ok());
+
+        // overwrites of a middle block move only that block to the end, the
+        // holes are compacted before they outgrow the live blocks
+        for (int round = 0; round < 50; round++) {
+            const std::string update(100, 'a' + round % 26);
+            const uint32_t offset = 5000 + round * 37;
+            data.replace(offset, update.size(), update);
+            EXPECT_TRUE(fileChunkManager_
+                            ->WriteToChunk(chunk_handle, version, offset,
+                                           update.size(), update)
+                            .ok());
+
+            auto reader_or =
+                fileChunkManager_->OpenFileChunkReader(chunk_handle);
+            ASSERT_TRUE(reader_or.ok());
+            const auto& metadata = reader_or.value()->metadata();
+            uint64_t live_size = 0;
+            for (const auto& length : metadata.block_lengths()) {
+                live_size += length;
+            }
+            EXPECT_LE(reader_or.value()->size(), 2 * live_size);
+        }
+
+        EXPECT_EQ(fileChunkManager_
+                      ->ReadFromChunk(chunk_handle, version, 0, data.size())
+                      .value(),
+                  data);
+        ASSERT_TRUE(fileChunkManager_->Initialize(
+            data_dirs, 64 * 1024, DiskIoQueue::Options(),
+            ChunkIoBackend::Options(), store_options));
+        EXPECT_EQ(fileChunkManager_->GetFileChunk(chunk_handle).value()->data(),
+                  data);
+        EXPECT_TRUE(fileChunkManager_->DeleteChunk(chunk_handle).ok());
+    }
+}
@@ -0,0 +1,208 @@
+#include "src/server/master_server/chunk_placement_policy.h"
+
+#include <gtest/gtest.h>
+
+#include <set>
+
+using dfs::server::ChunkPlacementPolicy;
+using dfs::server::FailureDomain;
+using protos::ChunkServer;
+using protos::ChunkServerLoad;
+using protos::ChunkServerLocation;
+
+class ChunkPlacementPolicyTest : public ::testing::Test {
+   protected:
+    static ChunkServer CreateChunkServer(const std::string& hostname,
+                                         uint32_t port,
+                                         uint32_t available_disk_mb) {
+        ChunkServer chunk_server;
+        chunk_server.mutable_location()->set_server_hostname(hostname);
+        chunk_server.mutable_location()->set_server_port(port);
+        chunk_server.set_available_disk_mb(available_disk_mb);
+        chunk_server.mutable_load();
+        return chunk_server;
+    }
+
+    static std::string ToString(const ChunkServerLocation& location) {
+        return location.server_hostname() + ":" +
+               std::to_string(location.server_port());
+    }
+};
+
+// 选出的块服务器互不相同，数量不足时返回所有可用的块服务器
+TEST_F(ChunkPlacementPolicyTest, ChooseDistinctServersTest) {
+    ChunkPlacementPolicy policy(64, 1);
+    for (uint32_t i = 0; i < 4; i++) {
+        policy.AddServer(CreateChunkServer("127.0.0.1", 50100 + i, 1024),
+                         FailureDomain{"", "127.0.0.1"});
+    }
+    EXPECT_EQ(policy.size(), 4);
+
+    auto locations = policy.ChooseServers(3, {});
+    ASSERT_EQ(locations.size(), 3);
+    std::set<std::string> addresses;
+    for (const auto& location : locations) {
+        addresses.insert(ToString(location));
+    }
+    EXPECT_EQ(addresses.size(), 3);
+
+    EXPECT_EQ(policy.ChooseServers(10, {}).size(), 4);
+}
+
+// 要求不同机架时不放宽约束，机架不足时返回的块服务器少于请求的数量
+TEST_F(ChunkPlacementPolicyTest, DistinctRacksTest) {
+    ChunkPlacementPolicy policy(64, 1);
+    // 三个机架，每个机架两个块服务器
+    for (uint32_t i = 0; i < 6; i++) {
+        const std::string host = "host" + std::to_string(i);
+        policy.AddServer(CreateChunkServer(host, 50100 + i, 1024),
+                         FailureDomain{"rack" + std::to_string(i / 2), host});
+    }
+
+    auto locations = policy.ChooseServers(5, {}, true);
+    ASSERT_EQ(locations.size(), 3);
+    std::set<int> racks;
+    for (const auto& location : locations) {
+        racks.insert(std::stoi(location.server_hostname().substr(4)) / 2);
+    }
+    EXPECT_EQ(racks.size(), 3);
+
+    // 已有副本所在的机架不会再被选中
+    const auto existing = CreateChunkServer("host0", 50100, 1024).location();
+    locations = policy.ChooseServers(5, {existing}, true);
+    ASSERT_EQ(locations.size(), 2);
+    for (const auto& location : locations) {
+        EXPECT_NE(std::stoi(location.server_hostname().substr(4)) / 2, 0);
+    }
+
+    // 不要求不同机架时放宽约束
+    EXPECT_EQ(policy.ChooseServers(5, {}).size(), 5);
+}
+
+// 副本优先分布在不同机架与不同主机
+TEST_F(ChunkPlacementPolicyTest, FailureDomainTest) {
+    ChunkPlacementPolicy policy(64, 1);
+    // 三个机架，每个机架两台主机，每台主机两个块服务器
+    for (uint32_t i = 0; i < 12; i++) {
+        const std::string rack = "rack" + std::to_string(i / 4);
+        const std::string host = "host" + std::to_string(i / 2);
+        policy.AddServer(CreateChunkServer(host, 50100 + i, 1024),
+                         FailureDomain{rack, host});
+    }
+
+    for (int round = 0; round < 100; round++) {
+        auto locations = policy.ChooseServers(3, {});
+        ASSERT_EQ(locations.size(), 3);
+
+        std::set<std::string> hosts;
+        for (const auto& location : locations) {
+            hosts.insert(location.server_hostname());
+        }
+        // 主机 2k 与 2k+1 位于同一机架的前后两台，机架编号为 k/2
+        std::set<std::string> racks;
+        for (const auto& host : hosts) {
+            racks.insert(std::to_string(std::stoi(host.substr(4)) / 2));
+        }
+        EXPECT_EQ(hosts.size(), 3);
+        EXPECT_EQ(racks.size(), 3);
+    }
+}
+
+// 已有副本所在的块服务器不会被选中
+TEST_F(ChunkPlacementPolicyTest, ExistingLocationsTest) {
+    ChunkPlacementPolicy policy(64, 1);
+    for (uint32_t i = 0; i < 3; i++) {
+        policy.AddServer(CreateChunkServer("127.0.0.1", 50100 + i, 1024),
+                         FailureDomain{"", "127.0.0.1"});
+    }
+
+    auto existing = policy.ChooseServers(2, {});
+    auto locations = policy.ChooseServers(3, existing);
+    ASSERT_EQ(locations.size(), 1);
+    for (const auto& location : existing) {
+        EXPECT_NE(ToString(location), ToString(locations[0]));
+    }
+}
+
+// 剩余空间不足的块服务器不会被选中，移除的块服务器也不会被选中
+TEST_F(ChunkPlacementPolicyTest, CapacityAndRemoveTest) {
+    ChunkPlacementPolicy policy(64, 1);
+    policy.AddServer(CreateChunkServer("127.0.0.1", 50100, 32),
+                     FailureDomain{"", "127.0.0.1"});
+    policy.AddServer(CreateChunkServer("127.0.0.1", 50101, 1024),
+                     FailureDomain{"", "127.0.0.1"});
+    policy.AddServer(CreateChunkServer("127.0.0.1", 50102, 1024),
+                     FailureDomain{"", "127.0.0.1"});
+
+    auto locations = policy.ChooseServers(3, {});
+    ASSERT_EQ(locations.size(), 2);
+    for (const auto& location : locations) {
+        EXPECT_NE(location.server_port(), 50100);
+    }
+
+    policy.RemoveServer(locations[0]);
+    EXPECT_EQ(policy.size(), 2);
+    auto remain = policy.ChooseServers(3, {});
+    ASSERT_EQ(remain.size(), 1);
+    EXPECT_EQ(ToString(remain[0]), ToString(locations[1]));
+}
+
+// 负载高、复制任务多的块服务器更少被选中
+TEST_F(ChunkPlacementPolicyTest, LoadAwareTest) {
+    ChunkPlacementPolicy policy(64, 1);
+    auto busy = CreateChunkServer("127.0.0.1", 50100, 1024);
+    auto idle = CreateChunkServer("127.0.0.1", 50101, 1024);
+    policy.AddServer(busy, FailureDomain{"", "127.0.0.1"});
+    policy.AddServer(idle, FailureDomain{"", "127.0.0.1"});
+
+    ChunkServerLoad load;
+    load.set_write_iops(1000);
+    load.set_queue_depth(32);
+    policy.UpdateServerLoad(busy.location(), 1024, load);
+    policy.BeginReplication(busy.location());
+
+    for (int i = 0; i < 20; i++) {
+        auto locations = policy.ChooseServers(1, {});
+        ASSERT_EQ(locations.size(), 1);
+        EXPECT_EQ(locations[0].server_port(), 50101);
+    }
+}
+
+// 机架用完之后仍然分布在不同主机，块服务器移除后机架计数随之更新
+TEST_F(ChunkPlacementPolicyTest, ExhaustedDomainTest) {
+    ChunkPlacementPolicy policy(64, 1);
+    // 两个机架，每个机架三台主机
+    for (uint32_t i = 0; i < 6; i++) {
+        const std::string rack = "rack" + std::to_string(i / 3);
+        const std::string host = "host" + std::to_string(i);
+        policy.AddServer(CreateChunkServer(host, 50100, 1024),
+                         FailureDomain{rack, host});
+    }
+
+    for (int round = 0; round < 100; round++) {
+        auto locations = policy.ChooseServers(4, {});
+        ASSERT_EQ(locations.size(), 4);
+        std::set<std::string> hosts;
+        std::set<int> racks;
+        for (const auto& location : locations) {
+            hosts.insert(location.server_hostname());
+            racks.insert(std::stoi(location.server_hostname().substr(4)) / 3);
+        }
+        EXPECT_EQ(hosts.size(), 4);
+        EXPECT_EQ(racks.size(), 2);
+    }
+
+    // 只剩一个机架
+    for (uint32_t i = 3; i < 6; i++) {
+        policy.RemoveServer(
+            CreateChunkServer("host" + std::to_string(i), 50100, 1024)
+                .location());
+    }
+    auto locations = policy.ChooseServers(3, {});
+    ASSERT_EQ(locations.size(), 3);
+    std::set<std::string> hosts;
+    for (const auto& location : locations) {
+        hosts.insert(location.server_hostname());
+    }
+    EXPECT_EQ(hosts.size(), 3);
+}
@@ -0,0 +1,55 @@
+#include "src/server/master_server/chunk_replica_queue.h"
+
+#include <gtest/gtest.h>
+
+using dfs::server::ChunkReplicaQueue;
+
+class ChunkReplicaQueueTest : public ::testing::Test {};
+
+// 存活副本越少越先出队，相同优先级先进先出
+TEST_F(ChunkReplicaQueueTest, PriorityTest) {
+    ChunkReplicaQueue queue;
+    queue.Push("a", 2);
+    queue.Push("b", 1);
+    queue.Push("c", 2);
+    queue.Push("d", 1);
+
+    std::string chunk_handle;
+    uint32_t live_replica_nums;
+    const std::vector<std::pair<std::string, uint32_t>> expected = {
+        {"b", 1}, {"d", 1}, {"a", 2}, {"c", 2}};
+    for (const auto& expected_pair : expected) {
+        ASSERT_TRUE(queue.Pop(&chunk_handle, &live_replica_nums));
+        EXPECT_EQ(chunk_handle, expected_pair.first);
+        EXPECT_EQ(live_replica_nums, expected_pair.second);
+    }
+
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.Pop(&chunk_handle, &live_replica_nums));
+}
+
+// 重复添加只保留一个任务，副本减少时提高优先级
+TEST_F(ChunkReplicaQueueTest, DeduplicateTest) {
+    ChunkReplicaQueue queue;
+    EXPECT_TRUE(queue.Push("a", 2));
+    EXPECT_TRUE(queue.Push("b", 2));
+    EXPECT_FALSE(queue.Push("a", 2));
+    EXPECT_FALSE(queue.Push("b", 1));
+    // 副本数量变多不会降低优先级
+    EXPECT_FALSE(queue.Push("b", 2));
+    EXPECT_EQ(queue.size(), 2);
+    EXPECT_TRUE(queue.Contains("a"));
+
+    std::string chunk_handle;
+    uint32_t live_replica_nums;
+    ASSERT_TRUE(queue.Pop(&chunk_handle, &live_replica_nums));
+    EXPECT_EQ(chunk_handle, "b");
+    EXPECT_EQ(live_replica_nums, 1);
+
+    ASSERT_TRUE(queue.Pop(&chunk_handle, &live_replica_nums));
+    EXPECT_EQ(chunk_handle, "a");
+    EXPECT_FALSE(queue.Contains("a"));
+
+    // 出队后可以再次添加
+    EXPECT_TRUE(queue.Push("a", 1));
+}
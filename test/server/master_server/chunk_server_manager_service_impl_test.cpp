@@ -19,6 +19,7 @@ TEST_F(ChunkServerManagerServiceImplTest, TalkToMaster) {
     ReportChunkServerRequest request;
     request.mutable_chunk_server()->mutable_location()->set_server_hostname("127.0.0.1");
     request.mutable_chunk_server()->mutable_location()->set_server_port(50100);
+    request.set_full_report(true);
     auto respond_or = client->SendRequest(request);
     std::cout << respond_or.status().ToString() << std::endl;
     EXPECT_TRUE(respond_or.ok());
@@ -1,8 +1,10 @@
 #include "src/server/master_server/metadata_manager.h"
 
+#include <absl/time/clock.h>
 #include <google/protobuf/stubs/statusor.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <atomic>
 #include <set>
 #include <thread>
@@ -254,4 +256,203 @@ TEST_F(MetadataManagerTest, CreateDirFileMetadataInParallel) {
         auto metadata_or = metadataManager_->GetFileMetadata(GetLevelName(i));
         EXPECT_TRUE(metadata_or.ok());
     }
-}
\ No newline at end of file
+}
+// 纠删码文件的条带，删除文件时同时删除校验块
+TEST_F(MetadataManagerTest, FileStripeTest) {
+    const std::string filename = "/stripe_file";
+    EXPECT_TRUE(metadataManager_->CreateFileMetadata(filename).ok());
+    auto data_handle = metadataManager_->CreateChunkHandle(filename, 0).value();
+    auto parity_handle = metadataManager_->CreateParityChunkHandle();
+    EXPECT_NE(data_handle, parity_handle);
+    EXPECT_FALSE(metadataManager_->IsErasureCodedChunk(data_handle));
+
+    protos::FileChunkMetadata parity_metadata;
+    parity_metadata.set_chunk_handle(parity_handle);
+    parity_metadata.set_version(1);
+    metadataManager_->SetFileChunkMetadata(parity_metadata);
+
+    // RS(2, 1)，第二个数据块不存在
+    protos::StripeMetadata stripe;
+    stripe.set_data_shards(2);
+    stripe.set_parity_shards(1);
+    stripe.add_chunk_handles(data_handle);
+    stripe.add_chunk_handles("");
+    stripe.add_chunk_handles(parity_handle);
+    for (uint32_t size : {100, 0, 100}) {
+        stripe.add_shard_sizes(size);
+    }
+    EXPECT_TRUE(metadataManager_
+                    ->SetFileStorageClass(filename,
+                                          protos::STORAGE_ERASURE_CODED)
+                    .ok());
+    EXPECT_TRUE(metadataManager_->SetFileStripes(filename, {stripe}).ok());
+    EXPECT_TRUE(metadataManager_->IsErasureCodedChunk(data_handle));
+    EXPECT_TRUE(metadataManager_->IsErasureCodedChunk(parity_handle));
+    EXPECT_EQ(metadataManager_->GetFileMetadata(filename).value()->storage_class(),
+              protos::STORAGE_ERASURE_CODED);
+
+    auto chunk_stripe_or = metadataManager_->GetChunkStripe(parity_handle);
+    ASSERT_TRUE(chunk_stripe_or.ok());
+    EXPECT_EQ(chunk_stripe_or.value().filename, filename);
+    EXPECT_EQ(chunk_stripe_or.value().shard_index, 2);
+    EXPECT_EQ(chunk_stripe_or.value().stripe.chunk_handles(0), data_handle);
+    EXPECT_TRUE(IsNotFound(metadataManager_->GetChunkStripe("").status()));
+
+    metadataManager_->DeleteFileAndChunkMetadata(filename);
+    EXPECT_FALSE(metadataManager_->ExistFileChunkMetadata(data_handle));
+    EXPECT_FALSE(metadataManager_->ExistFileChunkMetadata(parity_handle));
+    EXPECT_FALSE(metadataManager_->IsErasureCodedChunk(parity_handle));
+}
+
+// 一段时间内没有被读写的多副本文件为冷文件，空文件与纠删码文件不转换
+TEST_F(MetadataManagerTest, ColdFilesTest) {
+    for (const auto& filename : {"/cold_a", "/cold_b", "/cold_c"}) {
+        EXPECT_TRUE(metadataManager_->CreateFileMetadata(filename).ok());
+        EXPECT_TRUE(metadataManager_->CreateChunkHandle(filename, 0).ok());
+    }
+    EXPECT_TRUE(metadataManager_->CreateFileMetadata("/cold_empty").ok());
+
+    absl::SleepFor(absl::Milliseconds(5));
+    const absl::Time before = absl::Now();
+    metadataManager_->TouchFile("/cold_a");
+    EXPECT_GE(metadataManager_->GetFileAccessTime("/cold_a").value(), before);
+    EXPECT_TRUE(metadataManager_
+                    ->SetFileStorageClass("/cold_c",
+                                          protos::STORAGE_ERASURE_CODED)
+                    .ok());
+
+    auto cold_files = metadataManager_->GetColdFiles(before, 1000);
+    auto contains = [&](const std::string& filename) {
+        return std::find(cold_files.begin(), cold_files.end(), filename) !=
+               cold_files.end();
+    };
+    EXPECT_TRUE(contains("/cold_b"));
+    EXPECT_FALSE(contains("/cold_a"));
+    EXPECT_FALSE(contains("/cold_c"));
+    EXPECT_FALSE(contains("/cold_empty"));
+    EXPECT_EQ(metadataManager_->GetColdFiles(before, 1).size(), 1);
+
+    // 删除的文件不再记录访问时间
+    metadataManager_->DeleteFileAndChunkMetadata("/cold_b");
+    metadataManager_->TouchFile("/cold_b");
+    EXPECT_TRUE(IsNotFound(metadataManager_->GetFileAccessTime("/cold_b")
+                               .status()));
+}
+
+LeaseMetadata MakeLease(const std::string& client_id, uint64_t session_epoch,
+                        uint64_t expire_time) {
+    LeaseMetadata lease;
+    lease.client_id = client_id;
+    lease.session_epoch = session_epoch;
+    lease.expire_time = expire_time;
+    return lease;
+}
+
+// 只延长未过期的租约，删除文件时一起删除租约
+TEST_F(MetadataManagerTest, ExtendLeaseTest) {
+    const std::string filename = "/lease_file";
+    EXPECT_TRUE(metadataManager_->CreateFileMetadata(filename).ok());
+    auto chunk_handle_or = metadataManager_->CreateChunkHandle(filename, 0);
+    ASSERT_TRUE(chunk_handle_or.ok());
+    const std::string chunk_handle = chunk_handle_or.value();
+
+    const uint64_t now = absl::ToUnixSeconds(absl::Now());
+    EXPECT_FALSE(metadataManager_->ExtendLeaseMetadata(chunk_handle, now + 60));
+
+    metadataManager_->SetLeaseMetadata(chunk_handle,
+                                       MakeLease("client", 1, now - 1));
+    EXPECT_FALSE(metadataManager_->ExtendLeaseMetadata(chunk_handle, now + 60));
+
+    metadataManager_->SetLeaseMetadata(chunk_handle,
+                                       MakeLease("client", 1, now + 30));
+    EXPECT_TRUE(metadataManager_->ExtendLeaseMetadata(chunk_handle, now + 60));
+    EXPECT_EQ(metadataManager_->GetLeaseMetadata(chunk_handle).first.expire_time,
+              now + 60);
+    // 不会缩短租约
+    EXPECT_TRUE(metadataManager_->ExtendLeaseMetadata(chunk_handle, now + 10));
+    EXPECT_EQ(metadataManager_->GetLeaseMetadata(chunk_handle).first.expire_time,
+              now + 60);
+    EXPECT_EQ(metadataManager_->GetLeaseMetadata(chunk_handle).first.client_id,
+              "client");
+
+    metadataManager_->DeleteFileAndChunkMetadata(filename);
+    EXPECT_FALSE(metadataManager_->GetLeaseMetadata(chunk_handle).second);
+}
+
+// 同一客户端共享租约，新会话接管旧会话的租约，其他客户端与旧会话被拒绝
+TEST_F(MetadataManagerTest, AcquireLeaseTest) {
+    const std::string chunk_handle = "acquire_lease_chunk";
+    const uint64_t expire_time = absl::ToUnixSeconds(absl::Now()) + 60;
+    const auto lease = MakeLease("client_a", 2, expire_time);
+
+    auto granted_or =
+        metadataManager_->AcquireLeaseMetadata(chunk_handle, lease);
+    ASSERT_TRUE(granted_or.ok());
+    EXPECT_FALSE(granted_or.value());
+    // 主副本服务器接受之前，同一会话的其他工作线程也需要申请
+    granted_or = metadataManager_->AcquireLeaseMetadata(chunk_handle, lease);
+    ASSERT_TRUE(granted_or.ok());
+    EXPECT_FALSE(granted_or.value());
+
+    EXPECT_TRUE(metadataManager_->MarkLeaseGranted(chunk_handle, lease));
+    granted_or = metadataManager_->AcquireLeaseMetadata(chunk_handle, lease);
+    ASSERT_TRUE(granted_or.ok());
+    EXPECT_TRUE(granted_or.value());
+
+    granted_or = metadataManager_->AcquireLeaseMetadata(
+        chunk_handle, MakeLease("client_b", 9, expire_time));
+    EXPECT_TRUE(granted_or.status().code() ==
+                google::protobuf::util::StatusCode::kFailedPrecondition);
+
+    // 客户端重启后的新会话
+    granted_or = metadataManager_->AcquireLeaseMetadata(
+        chunk_handle, MakeLease("client_a", 3, expire_time));
+    ASSERT_TRUE(granted_or.ok());
+    EXPECT_TRUE(granted_or.value());
+    EXPECT_EQ(metadataManager_->GetLeaseMetadata(chunk_handle)
+                  .first.session_epoch,
+              3);
+    granted_or = metadataManager_->AcquireLeaseMetadata(chunk_handle, lease);
+    EXPECT_TRUE(granted_or.status().code() ==
+                google::protobuf::util::StatusCode::kFailedPrecondition);
+
+    // 已经被接受的租约不会被释放
+    metadataManager_->ReleaseLeaseMetadata(
+        chunk_handle, MakeLease("client_a", 3, expire_time));
+    EXPECT_EQ(metadataManager_->GetLeaseMetadata(chunk_handle).first.client_id,
+              "client_a");
+    metadataManager_->RemoveLeaseMetadata(chunk_handle);
+}
+
+// 多个客户端同时申请同一个数据块，只有一个客户端记录租约，被拒绝后
+// 释放的租约可以被其他客户端获取
+TEST_F(MetadataManagerTest, AcquireLeaseInParallelTest) {
+    const std::string chunk_handle = "parallel_lease_chunk";
+    const uint64_t expire_time = absl::ToUnixSeconds(absl::Now()) + 60;
+    const int kClientNums = 16;
+
+    std::atomic<int> acquired(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kClientNums; i++) {
+        threads.emplace_back([&, i]() {
+            auto granted_or = metadataManager_->AcquireLeaseMetadata(
+                chunk_handle,
+                MakeLease("client" + std::to_string(i), 1, expire_time));
+            if (granted_or.ok()) {
+                acquired++;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(acquired.load(), 1);
+
+    const auto holder = metadataManager_->GetLeaseMetadata(chunk_handle).first;
+    metadataManager_->ReleaseLeaseMetadata(chunk_handle, holder);
+    auto granted_or = metadataManager_->AcquireLeaseMetadata(
+        chunk_handle, MakeLease("other_client", 1, expire_time));
+    ASSERT_TRUE(granted_or.ok());
+    EXPECT_FALSE(granted_or.value());
+    metadataManager_->RemoveLeaseMetadata(chunk_handle);
+}
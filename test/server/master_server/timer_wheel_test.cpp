@@ -0,0 +1,97 @@
+#include "src/server/master_server/timer_wheel.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+using dfs::server::TimerWheel;
+
+class TimerWheelTest : public ::testing::Test {
+   protected:
+    const absl::Time start_ = absl::FromUnixSeconds(1000);
+};
+
+// 到期之前不会过期，到期后过期且只返回一次
+TEST_F(TimerWheelTest, ExpireTest) {
+    TimerWheel wheel(start_, absl::Milliseconds(100), 10);
+    wheel.Schedule("server_a", start_ + absl::Milliseconds(300));
+    EXPECT_TRUE(wheel.Contains("server_a"));
+
+    EXPECT_TRUE(wheel.Advance(start_ + absl::Milliseconds(250)).empty());
+
+    auto expired = wheel.Advance(start_ + absl::Milliseconds(300));
+    ASSERT_EQ(expired.size(), 1);
+    EXPECT_EQ(expired[0], "server_a");
+    EXPECT_FALSE(wheel.Contains("server_a"));
+    EXPECT_EQ(wheel.size(), 0);
+
+    EXPECT_TRUE(wheel.Advance(start_ + absl::Milliseconds(400)).empty());
+}
+
+// 过期时间不在 tick 边界时向上取整，不会提前过期
+TEST_F(TimerWheelTest, RoundUpTest) {
+    TimerWheel wheel(start_, absl::Milliseconds(100), 10);
+    wheel.Schedule("server_a", start_ + absl::Milliseconds(250));
+
+    EXPECT_TRUE(wheel.Advance(start_ + absl::Milliseconds(299)).empty());
+    EXPECT_EQ(wheel.Advance(start_ + absl::Milliseconds(300)).size(), 1);
+}
+
+// 续约会推迟过期时间
+TEST_F(TimerWheelTest, RenewTest) {
+    TimerWheel wheel(start_, absl::Milliseconds(100), 10);
+    wheel.Schedule("server_a", start_ + absl::Milliseconds(300));
+    wheel.Schedule("server_a", start_ + absl::Milliseconds(600));
+    EXPECT_EQ(wheel.size(), 1);
+
+    EXPECT_TRUE(wheel.Advance(start_ + absl::Milliseconds(500)).empty());
+    EXPECT_EQ(wheel.Advance(start_ + absl::Milliseconds(600)).size(), 1);
+}
+
+// 取消后不会过期
+TEST_F(TimerWheelTest, CancelTest) {
+    TimerWheel wheel(start_, absl::Milliseconds(100), 10);
+    wheel.Schedule("server_a", start_ + absl::Milliseconds(300));
+    wheel.Cancel("server_a");
+    wheel.Cancel("server_b");
+
+    EXPECT_FALSE(wheel.Contains("server_a"));
+    EXPECT_TRUE(wheel.Advance(start_ + absl::Seconds(10)).empty());
+}
+
+// 过期时间超过一圈时，需要转过多圈才会过期
+TEST_F(TimerWheelTest, MultipleRoundsTest) {
+    TimerWheel wheel(start_, absl::Milliseconds(100), 4);
+    wheel.Schedule("server_a", start_ + absl::Milliseconds(1000));
+
+    for (int ms = 0; ms < 1000; ms += 100) {
+        EXPECT_TRUE(wheel.Advance(start_ + absl::Milliseconds(ms)).empty());
+    }
+    EXPECT_EQ(wheel.Advance(start_ + absl::Milliseconds(1000)).size(), 1);
+}
+
+// 长时间未推进时间轮，一次推进返回所有过期的 key
+TEST_F(TimerWheelTest, AdvanceManyTicksTest) {
+    TimerWheel wheel(start_, absl::Milliseconds(100), 4);
+    for (int i = 0; i < 100; i++) {
+        wheel.Schedule("server_" + std::to_string(i),
+                       start_ + absl::Milliseconds(100 * i));
+    }
+
+    auto expired = wheel.Advance(start_ + absl::Milliseconds(4950));
+    EXPECT_EQ(expired.size(), 50);
+    EXPECT_EQ(wheel.size(), 50);
+    EXPECT_NE(std::find(expired.begin(), expired.end(), "server_49"),
+              expired.end());
+    EXPECT_EQ(std::find(expired.begin(), expired.end(), "server_50"),
+              expired.end());
+}
+
+// 过期时间早于当前时间的 key 在下一次推进时过期
+TEST_F(TimerWheelTest, ScheduleInPastTest) {
+    TimerWheel wheel(start_, absl::Milliseconds(100), 10);
+    EXPECT_TRUE(wheel.Advance(start_ + absl::Milliseconds(500)).empty());
+
+    wheel.Schedule("server_a", start_ + absl::Milliseconds(100));
+    EXPECT_EQ(wheel.Advance(start_ + absl::Milliseconds(600)).size(), 1);
+}
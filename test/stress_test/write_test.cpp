@@ -20,6 +20,10 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    // 按配置切换为异步日志
+    dfs::common::SystemLogger::GetInstance().Configure(
+        dfs::common::SystemLogger::LoadOptions());
+
     std::vector<std::thread> threads;
 
     auto start = std::chrono::high_resolution_clock::now();  // 记录开始时间